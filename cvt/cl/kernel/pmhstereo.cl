@@ -112,7 +112,7 @@ float4 nd_state_refine( RNG* rng, const float4 _state, const float2 coord, const
 	float4 ret = ( float4 ) ( - n.x / n.z, - n.y / n.z, ( n.x * coord.x + n.y * coord.y ) / n.z + z, 0.0f );
 	ret = ( float4 ) ( 1.0f, 0.0f, 0.0f, 0.0f ) - ret;
 	if( !lr )
-		return nd_state_viewprop( state );
+		return nd_state_viewprop( ret );
 	return ret;
 }
 
@@ -22,242 +22,440 @@
    THE SOFTWARE.
 */
 
+
 #ifndef CVT_KDTREE_H
 #define CVT_KDTREE_H
 
 #include <vector>
+#include <algorithm>
+
+#include <float.h>
+#include <sys/types.h>
 
 #include <cvt/math/Vector.h>
+#include <cvt/math/Math.h>
+#include <cvt/util/ParallelFor.h>
 
 namespace cvt
 {
-
-#define PT( n ) _pts[ _ptidx[ n ] ][ idx ]
-#define SWAP( a, b ) do { ssize_t t = _ptidx[ a ]; _ptidx[ a ] = _ptidx[ b ]; _ptidx[ b ] = t; } while( 0 )
-
-    template<class _T=Point2f>
+	/**
+	  @brief Balanced KD-tree over points with operator[], dimension() and lengthSqr() ( Vector2 to Vector6 ).
+
+	  The points are copied and reordered so that every node covers a contiguous range of them. Nodes are split at
+	  the median of the range along the dimension with the largest extent, ranges with at most KDTREE_BUCKET points
+	  are leaves. The tree is balanced, so the nodes are stored implicitly in heap order ( children of node i are
+	  2i+1 and 2i+2 ) with only their split dimension and value, the ranges follow from the recursion.
+	  The tree is built in parallel, the batch queries run in parallel over the queries.
+	  All indices returned refer to the points passed to the constructor, distances are squared.
+	 */
+	template<class _T=Point2f>
 	class KDTree {
 		public:
 			KDTree( const std::vector<_T> & pts );
 			~KDTree();
 
-			// return index of nearest neighbor
-			ssize_t locate( const _T & pt, float dist );
-            void rangeSearch( std::vector<_T> &output, const _T &pt, float dist );
+			size_t size() const					{ return _points.size(); }
+			const _T& point( size_t i ) const	{ return _points[ _rank[ i ] ]; }
+
+			/* index of the nearest neighbor closer than dist, -1 if there is none */
+			ssize_t locate( const _T & pt, float dist ) const;
+
+			/* index of the nearest neighbor, -1 for an empty tree */
+			ssize_t nearest( const _T & pt, float* distSqr = 0 ) const;
+
+			/* the k nearest neighbors within maxDist sorted by distance */
+			void knn( std::vector<size_t> & indices, std::vector<float> & distSqr, const _T & pt, size_t k, float maxDist = FLT_MAX ) const;
+
+			/* indices of all points within dist, unordered */
+			void radiusSearch( std::vector<size_t> & indices, const _T & pt, float dist ) const;
+
+			/* all points within dist */
+			void rangeSearch( std::vector<_T> & output, const _T & pt, float dist ) const;
+
+			/* batch queries in parallel: nearest neighbor ( -1 if none within maxDist ) and k nearest neighbors,
+			   the k results of query i start at k * i, missing neighbors are -1 with distance FLT_MAX */
+			void nearest( std::vector<ssize_t> & indices, std::vector<float> & distSqr, const std::vector<_T> & queries, float maxDist = FLT_MAX ) const;
+			void knn( std::vector<ssize_t> & indices, std::vector<float> & distSqr, const std::vector<_T> & queries, size_t k, float maxDist = FLT_MAX ) const;
 
 		private:
-            void build( ssize_t l, ssize_t h, ssize_t idx );
-            ssize_t partition( ssize_t l, ssize_t h, ssize_t x, ssize_t idx );
-			/* select the x-th element according to dimension idx */
-            void select(  ssize_t l, ssize_t h, ssize_t x, ssize_t idx );
+			enum { KDTREE_BUCKET = 8 };
+
+			class BuildBody;
+			class QueryBody;
+
+			struct Neighbor {
+				float	distSqr;
+				size_t	pos;
+				bool operator<( const Neighbor & other ) const { return distSqr < other.distSqr; }
+			};
+
+			struct Task {
+				size_t node, l, h;
+			};
+
+			KDTree( const KDTree & );
+			KDTree& operator=( const KDTree & );
+
+			struct CompareDim {
+				CompareDim( const std::vector<_T> & pts, size_t dim ) : _pts( pts ), _dim( dim ) {}
+				bool operator()( size_t a, size_t b ) const { return _pts[ a ][ _dim ] < _pts[ b ][ _dim ]; }
+				const std::vector<_T> &	_pts;
+				size_t					_dim;
+			};
+
+			void build( std::vector<size_t> & perm, const std::vector<_T> & pts, size_t node, size_t l, size_t h );
+			void split( std::vector<size_t> & perm, const std::vector<_T> & pts, size_t node, size_t l, size_t h );
+
+			void searchNearest( const _T & pt, size_t node, size_t l, size_t h, float & bestDist, ssize_t & best ) const;
+			void searchKnn( const _T & pt, size_t node, size_t l, size_t h, Neighbor* heap, size_t & num, size_t k, float & bound ) const;
+			void searchRadius( std::vector<size_t> & indices, const _T & pt, size_t node, size_t l, size_t h, float distSqr ) const;
+
+			/* points in tree order, their original indices and the tree position of every original index */
+			std::vector<_T>			_points;
+			std::vector<size_t>		_index;
+			std::vector<size_t>		_rank;
+			/* split dimension and value of the inner nodes in heap order */
+			std::vector<uint8_t>	_dims;
+			std::vector<float>		_splits;
+			size_t					_dim;
+	};
 
-            ssize_t visit( ssize_t low, ssize_t high, const _T & pt, float distance, ssize_t idx );
-            void visit( std::vector<_T> &output, const _T &pt, double *min, double *max, double distance, ssize_t low, ssize_t high, ssize_t idx );
+	template<class _T>
+	class KDTree<_T>::BuildBody
+	{
+		public:
+			BuildBody( KDTree<_T> & tree, std::vector<size_t> & perm, const std::vector<_T> & pts, const std::vector<Task> & tasks ) :
+				_tree( tree ), _perm( perm ), _pts( pts ), _tasks( tasks )
+			{
+			}
 
-			void print();
-            void check( ssize_t l, ssize_t h, ssize_t idx );
+			void operator()( size_t begin, size_t end ) const
+			{
+				for( size_t i = begin; i < end; i++ )
+					_tree.build( _perm, _pts, _tasks[ i ].node, _tasks[ i ].l, _tasks[ i ].h );
+			}
 
-			const std::vector<_T>&	_pts;
-			ssize_t*				_ptidx;
-            size_t					_dim;
+		private:
+			KDTree<_T> &				_tree;
+			std::vector<size_t> &		_perm;
+			const std::vector<_T> &		_pts;
+			const std::vector<Task> &	_tasks;
+	};
+
+	template<class _T>
+	class KDTree<_T>::QueryBody
+	{
+		public:
+			QueryBody( const KDTree<_T> & tree, const std::vector<_T> & queries, ssize_t* indices, float* distSqr, size_t k, float maxDist ) :
+				_tree( tree ), _queries( queries ), _indices( indices ), _distSqr( distSqr ), _k( k ), _maxDist( maxDist )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				const size_t n = _tree.size();
+				if( !n )
+					return;
+
+				if( _k == 1 ) {
+					for( size_t q = begin; q < end; q++ ) {
+						ssize_t best = -1;
+						float bestDist = _maxDist < FLT_MAX ? _maxDist * _maxDist : FLT_MAX;
+						_tree.searchNearest( _queries[ q ], 0, 0, n, bestDist, best );
+						_indices[ q ] = best < 0 ? -1 : ( ssize_t ) _tree._index[ best ];
+						_distSqr[ q ] = best < 0 ? FLT_MAX : bestDist;
+					}
+					return;
+				}
+
+				std::vector<Neighbor> heap( _k );
+				for( size_t q = begin; q < end; q++ ) {
+					ssize_t* idx = _indices + q * _k;
+					float* dist = _distSqr + q * _k;
+
+					size_t num = 0;
+					float bound = _maxDist < FLT_MAX ? _maxDist * _maxDist : FLT_MAX;
+					_tree.searchKnn( _queries[ q ], 0, 0, n, &heap[ 0 ], num, _k, bound );
+					std::sort_heap( heap.begin(), heap.begin() + num );
+					for( size_t i = 0; i < _k; i++ ) {
+						idx[ i ] = i < num ? ( ssize_t ) _tree._index[ heap[ i ].pos ] : -1;
+						dist[ i ] = i < num ? heap[ i ].distSqr : FLT_MAX;
+					}
+				}
+			}
+
+		private:
+			const KDTree<_T> &		_tree;
+			const std::vector<_T> &	_queries;
+			ssize_t*				_indices;
+			float*					_distSqr;
+			size_t					_k;
+			float					_maxDist;
 	};
 
-    template <class _T>
-    inline KDTree<_T>::KDTree( const std::vector<_T> & pts ) : _pts( pts )
-    {
-        size_t npts = _pts.size();
-        if( npts == 0 )
-            return;
-        _ptidx = new ssize_t[ npts ];
-        _dim = pts[0].dimension();
-
-        for( size_t i = 0; i < npts; i++ )
-            _ptidx[ i ] = i;
-
-        build( 0, npts - 1, 0 );
-    }
-
-    template<class _T>
-    inline KDTree<_T>::~KDTree()
-    {
-        delete[] _ptidx;
-    }
-
-    template <class _T>
-    inline ssize_t KDTree<_T>::locate( const _T & pt, float dist )
-    {
-        ssize_t nearestIndex = visit( 0, _pts.size() - 1, pt, dist, 0 );
-
-        return _ptidx[ nearestIndex ];
-    }
-
-    template <class _T>
-    inline void KDTree<_T>::build( ssize_t l, ssize_t h, ssize_t idx )
-    {
-        if (l<h)
-        {
-            ssize_t med = (l+h)>>1;
-            select( l, h, med, idx );
-
-            build( l, med-1, (idx+1)%_dim );
-            build( med+1, h, (idx+1)%_dim );
-        }
-    }
-
-    template <class _T>
-    inline ssize_t KDTree<_T>::partition( ssize_t l, ssize_t h, ssize_t x, ssize_t idx )
-    {
-        ssize_t pivot = l;
-
-        SWAP( x, h );
-
-        for ( ssize_t i = l; i < h; ++i )
-        {
-            if ( PT(i) < PT(h) )
-            {
-                SWAP( pivot, i );
-                pivot++;
-            }
-        }
-
-        SWAP( pivot, h );
-        return pivot;
-    }
-
-    template <class _T>
-    void KDTree<_T>::select( ssize_t l, ssize_t h, ssize_t x, ssize_t idx )
-    {
-        if (h>l)
-        {
-            ssize_t pivot = partition( l, h, x, idx );
-
-            if ( pivot > x )
-                select( l, pivot-1, x, idx );
-            if ( pivot < x )
-                select( pivot+1, h, x, idx );
-        }
-    }
-
-    template <class _T>
-    inline ssize_t KDTree<_T>::visit( ssize_t low, ssize_t high,
-                                       const _T & pt, float dist, ssize_t idx )
-    {
-        if( high - low < 2 ){
-            // check low and high
-            float nearest = ( _pts[ _ptidx[ low ] ] - pt ).length();
-            if( nearest <  ( _pts[ _ptidx[ high ] ] - pt ).length() )
-                return low;
-            else
-                return high;
-        }
-
-        ssize_t medianIdx = ( high + low ) >> 1;
-
-        float min = pt[ idx ] - dist;
-        float max = pt[ idx ] + dist;
-
-        if( PT( medianIdx ) > max ){
-            // search left half
-            return visit( low, medianIdx - 1, pt, dist, (idx+1)%_dim );
-        }
-
-        if( PT( medianIdx ) < min ){
-            // search right half
-            return visit( medianIdx + 1, high, pt, dist, (idx+1)%_dim );
-        }
-
-        // search both halfes and compare the results and also the median!:
-        ssize_t bestLow = visit( low, medianIdx - 1, pt, dist, (idx+1)%_dim );
-        ssize_t bestHigh = visit( medianIdx + 1, high, pt, dist, (idx+1)%_dim );
-
-        const _T & other = _pts[ _ptidx[ medianIdx ] ];
-        ssize_t bestIdx = medianIdx;
-        float nearestDistance = ( other - pt ).length();
-
-        float tmp = ( _pts[ _ptidx[ bestLow ] ] - pt ).length();
-        if( tmp < nearestDistance ){
-            nearestDistance = tmp;
-            bestIdx = bestLow;
-        }
-
-        tmp = ( _pts[ _ptidx[ bestHigh ] ] - pt ).length();
-        if( tmp < nearestDistance ){
-            nearestDistance = tmp;
-            bestIdx = bestHigh;
-        }
-
-        return bestIdx;
-    }
-
-    template<class _T>
-    void KDTree<_T>::rangeSearch( std::vector<_T> &output, const _T &pt, float distance )
-    {
-        double min[ _dim ];
-        double max[ _dim ];
-
-        for( size_t i = 0; i < _dim; ++i ){
-            min[i] = pt[i] - distance;
-            max[i] = pt[i] + distance;
-        }
-
-        visit( output, pt, min, max, distance, 0, _pts.size()-1, 0 );
-    }
-
-    template<class _T>
-    void KDTree<_T>::visit( std::vector<_T> &output, const _T &pt, double *min, double *max, double distance, ssize_t l, ssize_t h, ssize_t idx )
-    {
-        ssize_t med = (l+h) >> 1;
-        const _T &root = _pts[ _ptidx[ med ] ];
-
-        if (h >= l)
-        {
-            float dist = (root-pt).length();
-
-            if ( dist <= distance )
-            {
-                output.push_back(root);
-            }
-        }
-
-        if (h > l)
-        {
-            if (max[idx] >= root[idx])
-                visit( output, pt, min, max, distance, med+1, h, (idx+1)%_dim );
-
-            if (min[idx] <= root[idx])
-                visit( output, pt, min, max, distance, l, med-1, (idx+1)%_dim );
-        }
-    }
-
-    template<class _T>
-    inline void KDTree<_T>::check( ssize_t l, ssize_t h, ssize_t idx )
-    {
-        ssize_t med = ( l + h ) >> 1;
-
-        if( l >= h )
-            return;
-
-        for( ssize_t x = l; x < h; x++ ) {
-            if( x < med && PT( x ) > PT( med ) )
-                std::cout << "lower than median has bigger value" << std::endl;
-            if( x > med && PT( x ) < PT( med ) )
-                std::cout << "bigger than median has lower value" << std::endl;
-        }
-        check( l, med - 1, (idx+1)%_dim );
-        check( med + 1, h, (idx+1)%_dim );
-    }
-
-    template<class _T>
-    inline void KDTree<_T>::print()
-    {
-        for( size_t idx = 0; idx < _dim; ++idx ) {
-            printf( "dim %lu : ", idx );
-            for( ssize_t i = 0; i < _pts.size(); i++ ){
-                std::cout << PT( i ) << " ";
-            }
-            printf( "\n\n" );
-        }
-    }
+	template <class _T>
+	inline KDTree<_T>::KDTree( const std::vector<_T> & pts ) : _dim( 0 )
+	{
+		const size_t npts = pts.size();
+		if( npts == 0 )
+			return;
+		_dim = pts[ 0 ].dimension();
+
+		/* depth of the balanced tree with leaves of at most KDTREE_BUCKET points */
+		size_t depth = 0;
+		for( size_t m = npts; m > KDTREE_BUCKET; m = ( m + 1 ) >> 1 )
+			depth++;
+		_dims.resize( ( ( size_t ) 1 << depth ) - 1 );
+		_splits.resize( _dims.size() );
+
+		std::vector<size_t> perm( npts );
+		for( size_t i = 0; i < npts; i++ )
+			perm[ i ] = i;
+
+		/* split the upper levels serially until there are enough subtrees to build in parallel */
+		std::vector<Task> tasks( 1 );
+		tasks[ 0 ].node = 0;
+		tasks[ 0 ].l = 0;
+		tasks[ 0 ].h = npts;
+		const size_t minTasks = 4 * ParallelFor::numThreads();
+		while( tasks.size() < minTasks && tasks[ 0 ].h - tasks[ 0 ].l > 8192 ) {
+			std::vector<Task> next;
+			next.reserve( 2 * tasks.size() );
+			for( size_t i = 0; i < tasks.size(); i++ ) {
+				const Task & t = tasks[ i ];
+				Task lo = t, hi = t;
+				/* split only this node, the children become the next tasks */
+				size_t mid = ( t.l + t.h ) >> 1;
+				split( perm, pts, t.node, t.l, t.h );
+				lo.node = 2 * t.node + 1; lo.h = mid;
+				hi.node = 2 * t.node + 2; hi.l = mid;
+				next.push_back( lo );
+				next.push_back( hi );
+			}
+			tasks.swap( next );
+		}
+
+		BuildBody body( *this, perm, pts, tasks );
+		ParallelFor::run( body, 0, tasks.size() );
+
+		_points.resize( npts );
+		_index.swap( perm );
+		_rank.resize( npts );
+		for( size_t i = 0; i < npts; i++ ) {
+			_points[ i ] = pts[ _index[ i ] ];
+			_rank[ _index[ i ] ] = i;
+		}
+	}
+
+	template<class _T>
+	inline KDTree<_T>::~KDTree()
+	{
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::build( std::vector<size_t> & perm, const std::vector<_T> & pts, size_t node, size_t l, size_t h )
+	{
+		if( h - l <= KDTREE_BUCKET )
+			return;
+
+		split( perm, pts, node, l, h );
+		size_t mid = ( l + h ) >> 1;
+		build( perm, pts, 2 * node + 1, l, mid );
+		build( perm, pts, 2 * node + 2, mid, h );
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::split( std::vector<size_t> & perm, const std::vector<_T> & pts, size_t node, size_t l, size_t h )
+	{
+		/* split along the dimension with the largest extent */
+		size_t dim = 0;
+		float extent = -1.0f;
+		for( size_t d = 0; d < _dim; d++ ) {
+			float min = pts[ perm[ l ] ][ d ];
+			float max = min;
+			for( size_t i = l + 1; i < h; i++ ) {
+				float v = pts[ perm[ i ] ][ d ];
+				min = Math::min( min, v );
+				max = Math::max( max, v );
+			}
+			if( max - min > extent ) {
+				extent = max - min;
+				dim = d;
+			}
+		}
+
+		/* median split: the points left of mid are <= split <= the points right of it */
+		size_t mid = ( l + h ) >> 1;
+		std::nth_element( perm.begin() + l, perm.begin() + mid, perm.begin() + h, CompareDim( pts, dim ) );
+		_dims[ node ] = dim;
+		_splits[ node ] = pts[ perm[ mid ] ][ dim ];
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::searchNearest( const _T & pt, size_t node, size_t l, size_t h, float & bestDist, ssize_t & best ) const
+	{
+		if( h - l <= KDTREE_BUCKET ) {
+			for( size_t i = l; i < h; i++ ) {
+				float d = ( _points[ i ] - pt ).lengthSqr();
+				if( d < bestDist ) {
+					bestDist = d;
+					best = i;
+				}
+			}
+			return;
+		}
+
+		size_t mid = ( l + h ) >> 1;
+		float diff = pt[ _dims[ node ] ] - _splits[ node ];
+		/* descend into the side of the query first */
+		if( diff < 0.0f ) {
+			searchNearest( pt, 2 * node + 1, l, mid, bestDist, best );
+			if( diff * diff < bestDist )
+				searchNearest( pt, 2 * node + 2, mid, h, bestDist, best );
+		} else {
+			searchNearest( pt, 2 * node + 2, mid, h, bestDist, best );
+			if( diff * diff < bestDist )
+				searchNearest( pt, 2 * node + 1, l, mid, bestDist, best );
+		}
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::searchKnn( const _T & pt, size_t node, size_t l, size_t h, Neighbor* heap, size_t & num, size_t k, float & bound ) const
+	{
+		if( h - l <= KDTREE_BUCKET ) {
+			for( size_t i = l; i < h; i++ ) {
+				float d = ( _points[ i ] - pt ).lengthSqr();
+				if( num == k ? d >= bound : d > bound )
+					continue;
+
+				/* bounded max-heap of the k best */
+				Neighbor n;
+				n.distSqr = d;
+				n.pos = i;
+				if( num < k ) {
+					heap[ num++ ] = n;
+					std::push_heap( heap, heap + num );
+				} else {
+					std::pop_heap( heap, heap + num );
+					heap[ num - 1 ] = n;
+					std::push_heap( heap, heap + num );
+				}
+				if( num == k )
+					bound = heap[ 0 ].distSqr;
+			}
+			return;
+		}
+
+		size_t mid = ( l + h ) >> 1;
+		float diff = pt[ _dims[ node ] ] - _splits[ node ];
+		if( diff < 0.0f ) {
+			searchKnn( pt, 2 * node + 1, l, mid, heap, num, k, bound );
+			if( diff * diff <= bound )
+				searchKnn( pt, 2 * node + 2, mid, h, heap, num, k, bound );
+		} else {
+			searchKnn( pt, 2 * node + 2, mid, h, heap, num, k, bound );
+			if( diff * diff <= bound )
+				searchKnn( pt, 2 * node + 1, l, mid, heap, num, k, bound );
+		}
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::searchRadius( std::vector<size_t> & indices, const _T & pt, size_t node, size_t l, size_t h, float distSqr ) const
+	{
+		if( h - l <= KDTREE_BUCKET ) {
+			for( size_t i = l; i < h; i++ ) {
+				if( ( _points[ i ] - pt ).lengthSqr() <= distSqr )
+					indices.push_back( _index[ i ] );
+			}
+			return;
+		}
+
+		size_t mid = ( l + h ) >> 1;
+		float diff = pt[ _dims[ node ] ] - _splits[ node ];
+		if( diff <= 0.0f || diff * diff <= distSqr )
+			searchRadius( indices, pt, 2 * node + 1, l, mid, distSqr );
+		if( diff >= 0.0f || diff * diff <= distSqr )
+			searchRadius( indices, pt, 2 * node + 2, mid, h, distSqr );
+	}
+
+	template <class _T>
+	inline ssize_t KDTree<_T>::nearest( const _T & pt, float* distSqr ) const
+	{
+		ssize_t best = -1;
+		float bestDist = FLT_MAX;
+		if( size() )
+			searchNearest( pt, 0, 0, size(), bestDist, best );
+		if( distSqr )
+			*distSqr = bestDist;
+		return best < 0 ? -1 : ( ssize_t ) _index[ best ];
+	}
+
+	template <class _T>
+	inline ssize_t KDTree<_T>::locate( const _T & pt, float dist ) const
+	{
+		ssize_t best = -1;
+		float bestDist = dist * dist;
+		if( size() )
+			searchNearest( pt, 0, 0, size(), bestDist, best );
+		return best < 0 ? -1 : ( ssize_t ) _index[ best ];
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::knn( std::vector<size_t> & indices, std::vector<float> & distSqr, const _T & pt, size_t k, float maxDist ) const
+	{
+		indices.clear();
+		distSqr.clear();
+		if( !size() || !k )
+			return;
+
+		std::vector<Neighbor> heap( k );
+		size_t num = 0;
+		float bound = maxDist < FLT_MAX ? maxDist * maxDist : FLT_MAX;
+		searchKnn( pt, 0, 0, size(), &heap[ 0 ], num, k, bound );
+		std::sort_heap( heap.begin(), heap.begin() + num );
+
+		indices.resize( num );
+		distSqr.resize( num );
+		for( size_t i = 0; i < num; i++ ) {
+			indices[ i ] = _index[ heap[ i ].pos ];
+			distSqr[ i ] = heap[ i ].distSqr;
+		}
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::radiusSearch( std::vector<size_t> & indices, const _T & pt, float dist ) const
+	{
+		indices.clear();
+		if( size() )
+			searchRadius( indices, pt, 0, 0, size(), dist * dist );
+	}
+
+	template<class _T>
+	inline void KDTree<_T>::rangeSearch( std::vector<_T> & output, const _T & pt, float dist ) const
+	{
+		std::vector<size_t> indices;
+		radiusSearch( indices, pt, dist );
+		for( size_t i = 0; i < indices.size(); i++ )
+			output.push_back( point( indices[ i ] ) );
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::nearest( std::vector<ssize_t> & indices, std::vector<float> & distSqr, const std::vector<_T> & queries, float maxDist ) const
+	{
+		knn( indices, distSqr, queries, 1, maxDist );
+	}
+
+	template <class _T>
+	inline void KDTree<_T>::knn( std::vector<ssize_t> & indices, std::vector<float> & distSqr, const std::vector<_T> & queries, size_t k, float maxDist ) const
+	{
+		indices.assign( queries.size() * k, -1 );
+		distSqr.assign( queries.size() * k, FLT_MAX );
+		if( queries.empty() || !k )
+			return;
+
+		QueryBody body( *this, queries, &indices[ 0 ], &distSqr[ 0 ], k, maxDist );
+		ParallelFor::run( body, 0, queries.size(), 64 );
+	}
 }
 
 #endif
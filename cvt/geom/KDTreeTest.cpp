@@ -27,6 +27,10 @@
 #include <cvt/util/Time.h>
 #include <cvt/math/Vector.h>
 #include <cvt/geom/KDTree.h>
+#include <cvt/util/CVTTestUtil.h>
+
+#include <algorithm>
+#include <utility>
 
 namespace cvt {
 
@@ -89,7 +93,7 @@ namespace cvt {
         std::vector<VecType> kresult;
         VecType  pt;
         for( size_t i = 0; i < dim; i++ )
-            pt[ dim ] = Math::rand( -50.0f, 50.0f );
+            pt[ i ] = Math::rand( -50.0f, 50.0f );
 
         float range = Math::rand( 0.0f, 50.0f );
         kdtree.rangeSearch( kresult, pt, range );
@@ -98,6 +102,101 @@ namespace cvt {
         return b;
     }
 
+    /* k nearest neighbors, radius search and batch queries against brute force */
+    template <size_t dim>
+    static bool knnTest( size_t n, float scale )
+    {
+        typedef typename Vector<dim, float >::TYPE VecType;
+        std::vector<VecType> data, queries;
+        generateVectors<dim>( data, n );
+        generateVectors<dim>( queries, 50 );
+        for( size_t i = 0; i < data.size(); i++ )
+            data[ i ] *= scale;
+        for( size_t i = 0; i < queries.size(); i++ )
+            queries[ i ] *= scale;
+
+        KDTree<VecType> kdtree( data );
+        const size_t k = 7;
+        const float radius = 1000.0f * scale;
+
+        std::vector<ssize_t> batchIdx;
+        std::vector<float> batchDist;
+        kdtree.knn( batchIdx, batchDist, queries, k );
+
+        std::vector<size_t> idx;
+        std::vector<float> dist;
+        std::vector<std::pair<float, size_t> > all( data.size() );
+        for( size_t q = 0; q < queries.size(); q++ ){
+            for( size_t i = 0; i < data.size(); i++ )
+                all[ i ] = std::make_pair( ( data[ i ] - queries[ q ] ).lengthSqr(), i );
+            std::sort( all.begin(), all.end() );
+
+            kdtree.knn( idx, dist, queries[ q ], k );
+            if( idx.size() != std::min( k, data.size() ) )
+                return false;
+            for( size_t i = 0; i < k; i++ ){
+                if( i >= idx.size() ){
+                    if( batchIdx[ q * k + i ] != -1 )
+                        return false;
+                    continue;
+                }
+                if( dist[ i ] != all[ i ].first || ( size_t ) batchIdx[ q * k + i ] != idx[ i ] || batchDist[ q * k + i ] != dist[ i ] )
+                    return false;
+            }
+
+            float d;
+            ssize_t nn = kdtree.nearest( queries[ q ], &d );
+            if( nn < 0 || d != all[ 0 ].first )
+                return false;
+
+            kdtree.radiusSearch( idx, queries[ q ], radius );
+            size_t num = 0;
+            while( num < all.size() && all[ num ].first <= radius * radius )
+                num++;
+            if( idx.size() != num )
+                return false;
+            std::sort( idx.begin(), idx.end() );
+            for( size_t i = 0; i < num; i++ ){
+                if( !std::binary_search( idx.begin(), idx.end(), all[ i ].second ) )
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    typedef std::pair<std::vector<ssize_t>, std::vector<float> > NearestResult;
+
+    /* nearest neighbours of queries in a tree built from data */
+    struct BuildNearest {
+        BuildNearest( const std::vector<Vector3f>& d, const std::vector<Vector3f>& q ) : data( d ), queries( q ) {}
+        void operator()( NearestResult& res ) const
+        {
+            KDTree<Vector3f> tree( data );
+            tree.nearest( res.first, res.second, queries );
+        }
+        const std::vector<Vector3f>& data;
+        const std::vector<Vector3f>& queries;
+    };
+
+    /* the tree does not depend on the number of threads used for the construction */
+    static bool buildTest()
+    {
+        std::vector<Vector3f> data, queries;
+        generateVectors<3>( data, 200000 );
+        generateVectors<3>( queries, 1000 );
+
+        KDTree<Vector3f> tree( data );
+        bool b = testThreadInvariance<NearestResult>( BuildNearest( data, queries ), testEqual<NearestResult> );
+        b &= tree.size() == data.size();
+        for( size_t i = 0; i < data.size() && b; i += 997 )
+            b &= tree.point( i ) == data[ i ];
+
+        /* nothing within 1 */
+        b &= tree.locate( Vector3f( 1e6f, 1e6f, 1e6f ), 1.0f ) == -1;
+        b &= tree.locate( data[ 17 ] + Vector3f( 0.1f, 0.0f, 0.0f ), 1.0f ) == 17;
+        return b;
+    }
+
 }
 
 BEGIN_CVTTEST( KDTree )
@@ -116,5 +215,22 @@ BEGIN_CVTTEST( KDTree )
     ret &= cvt::rangeTest<4>();
     CVTTEST_PRINT( "range test Vector 4", ret );
 
+    bool b = cvt::knnTest<2>( 20000, 1.0f );
+    CVTTEST_PRINT( "knn / radius test Vector 2", b );
+    ret &= b;
+    b = cvt::knnTest<3>( 20000, 1.0f );
+    CVTTEST_PRINT( "knn / radius test Vector 3", b );
+    ret &= b;
+    b = cvt::knnTest<6>( 20000, 2.0f );
+    CVTTEST_PRINT( "knn / radius test Vector 6", b );
+    ret &= b;
+    b = cvt::knnTest<3>( 5, 1.0f );
+    CVTTEST_PRINT( "knn / radius test single leaf", b );
+    ret &= b;
+
+    b = cvt::buildTest();
+    CVTTEST_PRINT( "parallel construction", b );
+    ret &= b;
+
     return ret;
 END_CVTTEST
@@ -0,0 +1,369 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ICanny.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/Exception.h>
+
+namespace cvt {
+
+	/* rows per gradient block and per hysteresis strip, fixed so that the result does not depend on the number of threads */
+#define ICANNY_BLOCK 32
+#define ICANNY_STRIP 64
+
+	static inline uint32_t _icannyFind( uint32_t* parent, uint32_t l )
+	{
+		while( parent[ l ] != l ) {
+			parent[ l ] = parent[ parent[ l ] ];
+			l = parent[ l ];
+		}
+		return l;
+	}
+
+	/* the smaller label becomes the root, so parents always have smaller labels than their children */
+	static inline void _icannyUnion( uint32_t* parent, uint32_t a, uint32_t b )
+	{
+		a = _icannyFind( parent, a );
+		b = _icannyFind( parent, b );
+		if( a < b )
+			parent[ b ] = a;
+		else if( b < a )
+			parent[ a ] = b;
+	}
+
+	/* gradient magnitude and direction of a range of row blocks */
+	class ICanny::GradientBody
+	{
+		public:
+			GradientBody( const ICanny& canny, float* mag, uint8_t* dir, const uint8_t* base, size_t stride, bool u8 ) :
+				_canny( canny ), _mag( mag ), _dir( dir ), _base( base ), _stride( stride ), _basey( NULL ), _stridey( 0 ), _u8( u8 ) {}
+			GradientBody( const ICanny& canny, float* mag, uint8_t* dir, const uint8_t* basex, size_t stridex, const uint8_t* basey, size_t stridey ) :
+				_canny( canny ), _mag( mag ), _dir( dir ), _base( basex ), _stride( stridex ), _basey( basey ), _stridey( stridey ), _u8( false ) {}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				for( size_t i = start; i < end; i++ ) {
+					size_t y0 = i * ICANNY_BLOCK;
+					size_t y1 = Math::min( _canny._height, y0 + ICANNY_BLOCK );
+					if( _basey )
+						gradientRows( y0, y1, _base, _stride, _basey, _stridey );
+					else
+						gradientRows( y0, y1, _base, _stride, _u8 );
+				}
+			}
+
+		private:
+			void gradientRows( size_t y0, size_t y1, const uint8_t* base, size_t stride, bool u8 ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t w = _canny._width;
+
+				if( !u8 ) {
+					for( size_t y = y0; y < y1; y++ ) {
+						const float* prev = ( const float* ) ( base + ( y > 0 ? y - 1 : 0 ) * stride );
+						const float* cur = ( const float* ) ( base + y * stride );
+						const float* next = ( const float* ) ( base + ( y + 1 < _canny._height ? y + 1 : y ) * stride );
+						simd->cannyGradient1_f( &_mag[ y * w ], &_dir[ y * w ], prev, cur, next, w );
+					}
+					return;
+				}
+
+				/* ring of three converted rows, row r lives in rows[ r % 3 ] */
+				ScopedBuffer<float, true> buf( 3 * w );
+				float* rows[ 3 ] = { buf.ptr(), buf.ptr() + w, buf.ptr() + 2 * w };
+				size_t first = y0 > 0 ? y0 - 1 : 0;
+				size_t last = Math::min( y1 + 1, _canny._height );
+				for( size_t r = first; r < Math::min( y0 + 1, last ); r++ )
+					simd->Conv_u8_to_f( rows[ r % 3 ], base + r * stride, w );
+
+				for( size_t y = y0; y < y1; y++ ) {
+					if( y + 1 < last )
+						simd->Conv_u8_to_f( rows[ ( y + 1 ) % 3 ], base + ( y + 1 ) * stride, w );
+					const float* prev = rows[ ( y > 0 ? y - 1 : 0 ) % 3 ];
+					const float* cur = rows[ y % 3 ];
+					const float* next = rows[ ( y + 1 < _canny._height ? y + 1 : y ) % 3 ];
+					simd->cannyGradient1_f( &_mag[ y * w ], &_dir[ y * w ], prev, cur, next, w );
+				}
+			}
+
+			void gradientRows( size_t y0, size_t y1, const uint8_t* basex, size_t stridex, const uint8_t* basey, size_t stridey ) const
+			{
+				SIMD* simd = SIMD::instance();
+				for( size_t y = y0; y < y1; y++ )
+					simd->cannyGradient1_f( &_mag[ y * _canny._width ], &_dir[ y * _canny._width ], ( const float* ) ( basex + y * stridex ), ( const float* ) ( basey + y * stridey ), _canny._width );
+			}
+
+			const ICanny&	_canny;
+			float*			_mag;
+			uint8_t*		_dir;
+			const uint8_t*	_base;
+			size_t			_stride;
+			const uint8_t*	_basey;
+			size_t			_stridey;
+			bool			_u8;
+	};
+
+	/* non-maximum suppression and provisional labels of a range of strips, every strip only writes its own rows */
+	class ICanny::StripBody
+	{
+		public:
+			StripBody( const ICanny& canny, uint32_t* labels, ICanny::Strip* strips ) : _canny( canny ), _labels( labels ), _strips( strips ) {}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				for( size_t i = start; i < end; i++ )
+					labelStrip( _strips[ i ] );
+			}
+
+		private:
+			void labelStrip( ICanny::Strip& strip ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t w = _canny._width;
+				std::vector<uint32_t>& parent = strip.parent;
+				std::vector<uint8_t>& strong = strip.strong;
+				parent.clear();
+				strong.clear();
+				strip.state.resize( w );
+				uint8_t* state = &strip.state[ 0 ];
+
+				for( size_t y = strip.y0; y < strip.y1; y++ ) {
+					uint32_t* lab = _labels + y * w;
+
+					/* the first and the last row are never edges */
+					if( y == 0 || y + 1 >= _canny._height ) {
+						for( size_t x = 0; x < w; x++ )
+							lab[ x ] = 0;
+						continue;
+					}
+
+					const float* mag = &_canny._mag[ y * w ];
+					simd->cannyNonMaxima1_f( state, mag - w, mag, mag + w, &_canny._dir[ y * w ], w, _canny._low, _canny._high );
+
+					const uint32_t* prev = y > strip.y0 ? lab - w : NULL;
+					for( size_t x = 0; x < w; x++ ) {
+						if( !state[ x ] ) {
+							lab[ x ] = 0;
+							continue;
+						}
+
+						/* 8-connected candidates, provisional labels are local label + 1 */
+						uint32_t l = x > 0 ? lab[ x - 1 ] : 0;
+						if( prev ) {
+							uint32_t n[ 3 ];
+							n[ 0 ] = prev[ x ];
+							n[ 1 ] = x > 0 ? prev[ x - 1 ] : 0;
+							n[ 2 ] = x + 1 < w ? prev[ x + 1 ] : 0;
+							for( int k = 0; k < 3; k++ ) {
+								if( !n[ k ] )
+									continue;
+								if( !l )
+									l = n[ k ];
+								else if( l != n[ k ] )
+									_icannyUnion( &parent[ 0 ], l - 1, n[ k ] - 1 );
+							}
+						}
+
+						if( !l ) {
+							parent.push_back( parent.size() );
+							strong.push_back( 0 );
+							l = parent.size();
+						}
+						lab[ x ] = l;
+						if( state[ x ] == 2 )
+							strong[ l - 1 ] = 1;
+					}
+				}
+			}
+
+			const ICanny&	_canny;
+			uint32_t*		_labels;
+			ICanny::Strip*	_strips;
+	};
+
+	/* edge image of a range of strips */
+	class ICanny::OutputBody
+	{
+		public:
+			OutputBody( const ICanny& canny, const ICanny::Strip* strips, uint8_t* base, size_t stride ) :
+				_canny( canny ), _strips( strips ), _base( base ), _stride( stride ) {}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				for( size_t i = start; i < end; i++ )
+					outputStrip( _strips[ i ] );
+			}
+
+		private:
+			void outputStrip( const ICanny::Strip& strip ) const
+			{
+				const uint8_t* edge = &_canny._edge[ strip.base ];
+				const size_t w = _canny._width;
+				for( size_t y = strip.y0; y < strip.y1; y++ ) {
+					const uint32_t* lab = &_canny._labels[ y * w ];
+					float* dst = ( float* ) ( _base + y * _stride );
+					for( size_t x = 0; x < w; x++ )
+						dst[ x ] = ( lab[ x ] && edge[ lab[ x ] - 1 ] ) ? 1.0f : 0.0f;
+				}
+			}
+
+			const ICanny&			_canny;
+			const ICanny::Strip*	_strips;
+			uint8_t*				_base;
+			size_t					_stride;
+	};
+
+
+	ICanny::ICanny( float low, float high ) :
+		_low( low ),
+		_high( high ),
+		_width( 0 ),
+		_height( 0 )
+	{
+	}
+
+	ICanny::~ICanny()
+	{
+	}
+
+	void ICanny::setThresholds( float low, float high )
+	{
+		_low = low;
+		_high = high;
+	}
+
+	void ICanny::resize( size_t width, size_t height )
+	{
+		_width = width;
+		_height = height;
+		/* at least one element, the parallel loops get pointers to the buffers */
+		size_t n = Math::max<size_t>( width * height, 1 );
+		_mag.resize( n );
+		_dir.resize( n );
+		_labels.resize( n );
+	}
+
+	void ICanny::apply( Image& out, const Image& in )
+	{
+		bool u8 = in.format() == IFormat::GRAY_UINT8;
+		if( !u8 && in.format() != IFormat::GRAY_FLOAT )
+			throw CVTException( "ICanny::apply needs a GRAY_UINT8 or GRAY_FLOAT image!" );
+
+		resize( in.width(), in.height() );
+		{
+			IMapScoped<const uint8_t> map( in );
+			GradientBody grad( *this, &_mag[ 0 ], &_dir[ 0 ], map.ptr(), map.stride(), u8 );
+			ParallelFor::run( grad, 0, ( _height + ICANNY_BLOCK - 1 ) / ICANNY_BLOCK );
+		}
+		hysteresis( out );
+	}
+
+	void ICanny::apply( Image& out, const Image& gradx, const Image& grady )
+	{
+		if( gradx.format() != IFormat::GRAY_FLOAT || grady.format() != IFormat::GRAY_FLOAT ||
+			gradx.width() != grady.width() || gradx.height() != grady.height() )
+			throw CVTException( "ICanny::apply needs single channel floating point gradient images with the same size!" );
+
+		resize( gradx.width(), gradx.height() );
+		{
+			IMapScoped<const uint8_t> mapx( gradx );
+			IMapScoped<const uint8_t> mapy( grady );
+			GradientBody grad( *this, &_mag[ 0 ], &_dir[ 0 ], mapx.ptr(), mapx.stride(), mapy.ptr(), mapy.stride() );
+			ParallelFor::run( grad, 0, ( _height + ICANNY_BLOCK - 1 ) / ICANNY_BLOCK );
+		}
+		hysteresis( out );
+	}
+
+	void ICanny::hysteresis( Image& out )
+	{
+		out.reallocate( _width, _height, IFormat::GRAY_FLOAT );
+		if( !_width || !_height )
+			return;
+
+		/* non-maximum suppression and provisional labels of the candidates for every strip */
+		_strips.resize( ( _height + ICANNY_STRIP - 1 ) / ICANNY_STRIP );
+		for( size_t i = 0; i < _strips.size(); i++ ) {
+			_strips[ i ].y0 = i * ICANNY_STRIP;
+			_strips[ i ].y1 = Math::min( _height, ( i + 1 ) * ICANNY_STRIP );
+		}
+		StripBody labels( *this, &_labels[ 0 ], &_strips[ 0 ] );
+		ParallelFor::run( labels, 0, _strips.size() );
+
+		/* global union-find over all provisional labels */
+		uint32_t count = 0;
+		for( size_t i = 0; i < _strips.size(); i++ ) {
+			_strips[ i ].base = count;
+			count += _strips[ i ].parent.size();
+		}
+		_parent.resize( count + 1 );
+		_edge.resize( count + 1 );
+		for( size_t i = 0; i < _strips.size(); i++ ) {
+			const Strip& s = _strips[ i ];
+			for( size_t k = 0; k < s.parent.size(); k++ ) {
+				_parent[ s.base + k ] = s.base + s.parent[ k ];
+				_edge[ s.base + k ] = 0;
+			}
+		}
+
+		/* merge along the strip borders */
+		for( size_t i = 1; i < _strips.size(); i++ ) {
+			const uint32_t* lab = &_labels[ _strips[ i ].y0 * _width ];
+			const uint32_t* prev = lab - _width;
+			const uint32_t b = _strips[ i ].base - 1;
+			const uint32_t pb = _strips[ i - 1 ].base - 1;
+			for( size_t x = 0; x < _width; x++ ) {
+				if( !lab[ x ] )
+					continue;
+				if( prev[ x ] )
+					_icannyUnion( &_parent[ 0 ], b + lab[ x ], pb + prev[ x ] );
+				if( x > 0 && prev[ x - 1 ] )
+					_icannyUnion( &_parent[ 0 ], b + lab[ x ], pb + prev[ x - 1 ] );
+				if( x + 1 < _width && prev[ x + 1 ] )
+					_icannyUnion( &_parent[ 0 ], b + lab[ x ], pb + prev[ x + 1 ] );
+			}
+		}
+
+		/* resolve the roots in label order and keep the components with a strong pixel */
+		for( uint32_t l = 0; l < count; l++ )
+			_parent[ l ] = _parent[ _parent[ l ] ];
+		for( size_t i = 0; i < _strips.size(); i++ ) {
+			const Strip& s = _strips[ i ];
+			for( size_t k = 0; k < s.strong.size(); k++ ) {
+				if( s.strong[ k ] )
+					_edge[ _parent[ s.base + k ] ] = 1;
+			}
+		}
+		for( uint32_t l = 0; l < count; l++ )
+			_edge[ l ] = _edge[ _parent[ l ] ];
+
+		IMapScoped<uint8_t> map( out );
+		OutputBody output( *this, &_strips[ 0 ], map.ptr(), map.stride() );
+		ParallelFor::run( output, 0, _strips.size() );
+	}
+
+}
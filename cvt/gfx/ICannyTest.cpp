@@ -0,0 +1,261 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ICanny.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/math/Math.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace cvt {
+
+	/* canny with the scalar kernels and a flood fill hysteresis */
+	static void _icannyReference( std::vector<uint8_t>& edges, const std::vector<float>& img, size_t w, size_t h, float low, float high )
+	{
+		SIMD* simd = SIMD::get( SIMD_BASE );
+		std::vector<float> mag( w * h );
+		std::vector<uint8_t> dir( w * h ), state( w * h, 0 );
+		for( size_t y = 0; y < h; y++ ) {
+			const float* prev = &img[ ( y > 0 ? y - 1 : 0 ) * w ];
+			const float* next = &img[ ( y + 1 < h ? y + 1 : y ) * w ];
+			simd->cannyGradient1_f( &mag[ y * w ], &dir[ y * w ], prev, &img[ y * w ], next, w );
+		}
+		for( size_t y = 1; y + 1 < h; y++ )
+			simd->cannyNonMaxima1_f( &state[ y * w ], &mag[ ( y - 1 ) * w ], &mag[ y * w ], &mag[ ( y + 1 ) * w ], &dir[ y * w ], w, low, high );
+		delete simd;
+
+		edges.assign( w * h, 0 );
+		std::vector<size_t> stack;
+		for( size_t i = 0; i < w * h; i++ ) {
+			if( state[ i ] != 2 || edges[ i ] )
+				continue;
+			edges[ i ] = 1;
+			stack.push_back( i );
+			while( !stack.empty() ) {
+				size_t p = stack.back();
+				stack.pop_back();
+				int px = p % w, py = p / w;
+				for( int dy = -1; dy <= 1; dy++ ) {
+					for( int dx = -1; dx <= 1; dx++ ) {
+						int x = px + dx, y = py + dy;
+						if( x < 0 || x >= ( int ) w || y < 0 || y >= ( int ) h )
+							continue;
+						size_t q = y * w + x;
+						if( !state[ q ] || edges[ q ] )
+							continue;
+						edges[ q ] = 1;
+						stack.push_back( q );
+					}
+				}
+			}
+		}
+	}
+
+	/* random blobs, so that there are long connected edges crossing the strips */
+	static void _icannyImage( Image& img, std::vector<float>& data, size_t w, size_t h )
+	{
+		SIMD* simd = SIMD::get( SIMD_BASE );
+		img.reallocate( w, h, IFormat::GRAY_UINT8 );
+		data.resize( w * h );
+		float cx[ 6 ], cy[ 6 ], r[ 6 ];
+		for( int k = 0; k < 6; k++ ) {
+			cx[ k ] = Math::rand( 0.0f, ( float ) w );
+			cy[ k ] = Math::rand( 0.0f, ( float ) h );
+			r[ k ] = Math::rand( 3.0f, ( float ) Math::max( w, h ) * 0.4f );
+		}
+		IMapScoped<uint8_t> map( img );
+		for( size_t y = 0; y < h; y++ ) {
+			uint8_t* ptr = map.ptr();
+			for( size_t x = 0; x < w; x++ ) {
+				float v = Math::rand( 0.0f, 40.0f );
+				for( int k = 0; k < 6; k++ ) {
+					if( Math::sqr( x - cx[ k ] ) + Math::sqr( y - cy[ k ] ) < Math::sqr( r[ k ] ) )
+						v += 60.0f;
+				}
+				ptr[ x ] = ( uint8_t ) Math::min( v, 255.0f );
+			}
+			simd->Conv_u8_to_f( &data[ y * w ], ptr, w );
+			map++;
+		}
+		delete simd;
+	}
+
+	static bool _icannyCompare( const Image& out, const std::vector<uint8_t>& edges )
+	{
+		if( out.format() != IFormat::GRAY_FLOAT || out.width() * out.height() != edges.size() )
+			return false;
+		IMapScoped<const float> map( out );
+		for( size_t y = 0; y < out.height(); y++ ) {
+			for( size_t x = 0; x < out.width(); x++ ) {
+				if( map.ptr()[ x ] != ( edges[ y * out.width() + x ] ? 1.0f : 0.0f ) )
+					return false;
+			}
+			map++;
+		}
+		return true;
+	}
+
+	static bool _icannyKernels()
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+		bool ret = true;
+
+		for( size_t w = 1; w < 40; w++ ) {
+			std::vector<float> rows( 3 * w ), mag1( 3 * w ), mag2( 3 * w );
+			std::vector<uint8_t> dir1( 3 * w ), dir2( 3 * w ), nms1( w ), nms2( w );
+			for( size_t i = 0; i < 3 * w; i++ )
+				rows[ i ] = Math::rand( -1.0f, 1.0f );
+
+			for( size_t r = 0; r < 3; r++ ) {
+				base->cannyGradient1_f( &mag1[ r * w ], &dir1[ r * w ], &rows[ 0 ], &rows[ r * w ], &rows[ 2 * w ], w );
+				best->cannyGradient1_f( &mag2[ r * w ], &dir2[ r * w ], &rows[ 0 ], &rows[ r * w ], &rows[ 2 * w ], w );
+			}
+			ret &= mag1 == mag2 && dir1 == dir2;
+
+			base->cannyGradient1_f( &mag1[ 0 ], &dir1[ 0 ], &rows[ 0 ], &rows[ w ], w );
+			best->cannyGradient1_f( &mag2[ 0 ], &dir2[ 0 ], &rows[ 0 ], &rows[ w ], w );
+			ret &= mag1 == mag2 && dir1 == dir2;
+
+			for( size_t i = 0; i < 3 * w; i++ )
+				mag1[ i ] = Math::rand( 0.0f, 1.0f );
+			base->cannyNonMaxima1_f( &nms1[ 0 ], &mag1[ 0 ], &mag1[ w ], &mag1[ 2 * w ], &dir1[ 0 ], w, 0.3f, 0.6f );
+			best->cannyNonMaxima1_f( &nms2[ 0 ], &mag1[ 0 ], &mag1[ w ], &mag1[ 2 * w ], &dir1[ 0 ], w, 0.3f, 0.6f );
+			ret &= nms1 == nms2;
+		}
+
+		delete base;
+		delete best;
+		return ret;
+	}
+
+
+	struct ICannyApply {
+		ICannyApply( ICanny& c, const Image& i ) : canny( c ), in( i ) {}
+		void operator()( Image& out ) const { canny.apply( out, in ); }
+		ICanny&			canny;
+		const Image&	in;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( ICanny )
+	bool result = true;
+	bool b;
+
+	b = _icannyKernels();
+	CVTTEST_PRINT( "SIMD gradient and non-maximum suppression", b );
+	result &= b;
+
+	static const size_t sizes[][ 2 ] = { { 1, 1 }, { 2, 7 }, { 5, 3 }, { 31, 64 }, { 97, 203 }, { 320, 240 } };
+	ICanny canny( 0.05f, 0.15f );
+	Image in, out, fin, out1;
+	std::vector<float> data;
+	std::vector<uint8_t> ref;
+
+	b = true;
+	bool bf = true, bs = true;
+	for( size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[ 0 ] ); i++ ) {
+		size_t w = sizes[ i ][ 0 ], h = sizes[ i ][ 1 ];
+		_icannyImage( in, data, w, h );
+		_icannyReference( ref, data, w, h, 0.05f, 0.15f );
+
+		canny.apply( out, in );
+		b &= _icannyCompare( out, ref );
+		if( w * h > 1000 )
+			b &= std::count( ref.begin(), ref.end(), 1 ) > 0;
+
+		fin.reallocate( w, h, IFormat::GRAY_FLOAT );
+		{
+			IMapScoped<float> map( fin );
+			for( size_t y = 0; y < h; y++ ) {
+				for( size_t x = 0; x < w; x++ )
+					map.ptr()[ x ] = data[ y * w + x ];
+				map++;
+			}
+		}
+		canny.apply( out, fin );
+		bf &= _icannyCompare( out, ref );
+
+		ICanny::detectEdges( out, fin, 0.05f, 0.15f );
+		bs &= _icannyCompare( out, ref );
+	}
+	CVTTEST_PRINT( "GRAY_UINT8 against flood fill hysteresis", b );
+	result &= b;
+	CVTTEST_PRINT( "GRAY_FLOAT against flood fill hysteresis", bf );
+	result &= bf;
+	CVTTEST_PRINT( "detectEdges", bs );
+	result &= bs;
+
+	/* the gradient image interface gives the same result for sobel gradients */
+	{
+		size_t w = 150, h = 140;
+		_icannyImage( in, data, w, h );
+		_icannyReference( ref, data, w, h, 0.05f, 0.15f );
+		Image gx( w, h, IFormat::GRAY_FLOAT ), gy( w, h, IFormat::GRAY_FLOAT );
+		{
+			IMapScoped<float> mx( gx );
+			IMapScoped<float> my( gy );
+			for( size_t y = 0; y < h; y++ ) {
+				const float* p = &data[ ( y > 0 ? y - 1 : 0 ) * w ];
+				const float* c = &data[ y * w ];
+				const float* n = &data[ ( y + 1 < h ? y + 1 : y ) * w ];
+				for( size_t x = 0; x < w; x++ ) {
+					size_t xl = x > 0 ? x - 1 : 0;
+					size_t xr = x + 1 < w ? x + 1 : w - 1;
+					mx.ptr()[ x ] = ( ( ( p[ xl ] + n[ xl ] ) + ( c[ xl ] + c[ xl ] ) ) - ( ( p[ xr ] + n[ xr ] ) + ( c[ xr ] + c[ xr ] ) ) ) * 0.25f;
+					my.ptr()[ x ] = ( ( ( p[ xl ] + p[ xr ] ) + ( p[ x ] + p[ x ] ) ) - ( ( n[ xl ] + n[ xr ] ) + ( n[ x ] + n[ x ] ) ) ) * 0.25f;
+				}
+				mx++;
+				my++;
+			}
+		}
+		canny.apply( out, gx, gy );
+		b = _icannyCompare( out, ref );
+		CVTTEST_PRINT( "gradient images", b );
+		result &= b;
+	}
+
+	/* in-place and independent of the number of threads */
+	{
+		_icannyImage( in, data, 211, 300 );
+		fin.reallocate( 211, 300, IFormat::GRAY_UINT8 );
+		in.convert( fin, IFormat::GRAY_UINT8 );
+		canny.apply( out1, in );
+		b = testThreadInvariance<Image>( ICannyApply( canny, in ), testImagesEqual );
+		canny.apply( fin, fin );
+		b &= testImagesEqual( fin, out1 );
+		CVTTEST_PRINT( "thread count and in-place", b );
+		result &= b;
+	}
+
+	return result;
+END_CVTTEST
@@ -24,11 +24,13 @@
 
 #include <cvt/gfx/IConvert.h>
 #include <cvt/gfx/Image.h>
+#include <cvt/gfx/IDebayer.h>
 #include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
 
 namespace cvt {
 
-#define LAST_FORMAT	( IFORMAT_UYVY_UINT8 )
+#define LAST_FORMAT	( IFORMAT_BAYER_BGGR_UINT8 )
 
 #define TABLE( table, source, dst ) table[ ( ( source ) - 1 ) * LAST_FORMAT + ( dst ) - 1 ]
 
@@ -512,402 +514,245 @@ namespace cvt {
         CONV( Conv_YUYVu8_to_GRAYf, dstImage, float*, sourceImage, uint8_t*, sourceImage.width() )
     }
 
-#undef CONV
+    /* conversion via a temporary float row: func1 converts n1 source elements, func2 n2 float elements */
+    #define CONV_VIA_FLOAT( func1, n1, func2, n2, tmpsize, dI, dsttype, sI, srctype )	\
+    {																	\
+        ScopedBuffer<float, true> tmp( tmpsize );						\
+        sbase = src = sI.map( &sstride );								\
+        dbase = dst = dI.map( &dstride );								\
+        h = sI.height();												\
+        while( h-- ) {													\
+            simd->func1( tmp.ptr(), ( const srctype ) src, n1 );		\
+            simd->func2( ( dsttype ) dst, tmp.ptr(), n2 );				\
+            src += sstride;												\
+            dst += dstride;												\
+        }																\
+        sI.unmap( sbase );												\
+        dI.unmap( dbase );												\
+        return;															\
+    }
+
+    #define CONV_FUNC( name, func, dsttype, srctype, width )			\
+    static void name( Image & dstImage, const Image & sourceImage, IConvertFlags ) \
+    {																	\
+        SIMD* simd = SIMD::instance();									\
+        const uint8_t* src;												\
+        const uint8_t* sbase;											\
+        size_t sstride;													\
+        size_t dstride;													\
+        uint8_t* dst;													\
+        uint8_t* dbase;													\
+        size_t h;														\
+        CONV( func, dstImage, dsttype, sourceImage, srctype, width )	\
+    }
 
-    void Conv_BAYER_RGGB_to_RGBAu8( Image & dstImage, const Image & sourceImage, IConvertFlags flags )
+    CONV_FUNC( Conv_f_to_f16, Conv_f_to_f16, uint16_t*, float*, sourceImage.width() * sourceImage.channels() )
+    CONV_FUNC( Conv_f16_to_f, Conv_f16_to_f, float*, uint16_t*, sourceImage.width() * sourceImage.channels() )
+    CONV_FUNC( Conv_XXXu8_to_XXXAu8, Conv_XXXu8_to_XXXAu8, uint8_t*, uint8_t*, sourceImage.width() )
+    CONV_FUNC( Conv_XXXAu8_to_XXXu8, Conv_XXXAu8_to_XXXu8, uint8_t*, uint8_t*, sourceImage.width() )
+    CONV_FUNC( Conv_XYZu8_to_ZYXAu8, Conv_XYZu8_to_ZYXAu8, uint8_t*, uint8_t*, sourceImage.width() )
+    CONV_FUNC( Conv_XYZAu8_to_ZYXu8, Conv_XYZAu8_to_ZYXu8, uint8_t*, uint8_t*, sourceImage.width() )
+    CONV_FUNC( Conv_RGBu8_to_GRAYu8, Conv_RGBu8_to_GRAYu8, uint8_t*, uint8_t*, sourceImage.width() )
+    CONV_FUNC( Conv_BGRu8_to_GRAYu8, Conv_BGRu8_to_GRAYu8, uint8_t*, uint8_t*, sourceImage.width() )
+    CONV_FUNC( Conv_RGBu8_to_GRAYf, Conv_RGBu8_to_GRAYf, float*, uint8_t*, sourceImage.width() )
+    CONV_FUNC( Conv_BGRu8_to_GRAYf, Conv_BGRu8_to_GRAYf, float*, uint8_t*, sourceImage.width() )
+
+    #undef CONV_FUNC
+
+    static void Conv_GRAYf16_to_GRAYu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
     {
-        const uint32_t* src1;
-        const uint32_t* src2;
-        const uint32_t* src3;
-        const uint32_t* src4;
-        const uint32_t* src5;
-        const uint8_t* osrc;
-        uint32_t* dst;
-        uint8_t* odst;
+        SIMD* simd = SIMD::instance();
+        const uint8_t* src;
+        const uint8_t* sbase;
         size_t sstride;
         size_t dstride;
+        uint8_t* dst;
+        uint8_t* dbase;
         size_t h;
-        size_t w;
-        size_t i;
+        size_t w = sourceImage.width();
+        CONV_VIA_FLOAT( Conv_f16_to_f, w, Conv_GRAYf_to_GRAYu8, w, w, dstImage, uint8_t*, sourceImage, uint16_t* )
+    }
 
+    static void Conv_RGBAf16_to_RGBAu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    {
         SIMD* simd = SIMD::instance();
-
-        osrc = sourceImage.map( &sstride );
-        src1 = ( uint32_t* ) osrc;
-        sstride = sstride >> 2;
-        src2 = src1 + sstride;
-        src3 = src2 + sstride;
-        src4 = src3 + sstride;
-        src5 = src4 + sstride;
-        w = sourceImage.width();
-        h = sourceImage.height();
-        odst = dstImage.map( &dstride );
-        dst = ( uint32_t* ) odst;
-        dstride = dstride >> 2;
-
-		if( flags & ICONVERT_DEBAYER_HQLINEAR ) {
-			simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src2, src1, src2, w >> 2 );
-			dst += dstride;
-			simd->debayer_ODD_RGGBu8_RGBAu8( dst, src1, src2, src3, w >> 2 );
-			dst += dstride;
-			for( i = 2; i < h - 2; i += 2 ) {
-				simd->debayerhq_EVEN_RGGBu8_RGBAu8( dst, src1, src2, src3, src4, src5, w );
-				dst += dstride;
-				src1 += sstride;
-				src2 += sstride;
-				src3 += sstride;
-				src4 += sstride;
-				src5 += sstride;
-				simd->debayerhq_ODD_RGGBu8_RGBAu8( dst, src1, src2, src3, src4, src5, w );
-				dst += dstride;
-				src1 += sstride;
-				src2 += sstride;
-				src3 += sstride;
-				src4 += sstride;
-				src5 += sstride;
-			}
-			if( h - 2 == i ) {
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src2, src3, src4, w >> 2 );
-				dst += dstride;
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src3, src4, src3, w >> 2 );
-			} else {
-				simd->debayerhq_EVEN_RGGBu8_RGBAu8( dst, src1, src2, src3, src4, src5, w );
-				dst += dstride;
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src3, src4, src5, w >> 2 );
-				dst += dstride;
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src3, src4, src3, w >> 2 );
-			}
-
-		} else {
-			simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src2, src1, src2, w >> 2 );
-			dst += dstride;
-			for( i = 1; i < h - 1; i += 2 ) {
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src1, src2, src3, w >> 2 );
-				dst += dstride;
-				src1 += sstride;
-				src2 += sstride;
-				src3 += sstride;
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src1, src2, src3, w >> 2 );
-				dst += dstride;
-				src1 += sstride;
-				src2 += sstride;
-				src3 += sstride;
-			}
-			if( h - 1 == i )
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src1, src2, src1, w >> 2 );
-			else {
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src1, src2, src3, w >> 2 );
-				dst += dstride;
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src2, src3, src2, w >> 2 );
-			}
-		}
-
-        dstImage.unmap( odst );
-        sourceImage.unmap( osrc );
+        const uint8_t* src;
+        const uint8_t* sbase;
+        size_t sstride;
+        size_t dstride;
+        uint8_t* dst;
+        uint8_t* dbase;
+        size_t h;
+        size_t w = sourceImage.width();
+        CONV_VIA_FLOAT( Conv_f16_to_f, w * 4, Conv_XXXAf_to_XXXAu8, w, w * 4, dstImage, uint8_t*, sourceImage, uint16_t* )
     }
 
-    void Conv_BAYER_RGGB_to_BGRAu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    static void Conv_RGBAf16_to_BGRAu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
     {
-        const uint32_t* src1;
-        const uint32_t* src2;
-        const uint32_t* src3;
-        const uint8_t* osrc;
-        uint32_t* dst;
-        uint8_t* odst;
+        SIMD* simd = SIMD::instance();
+        const uint8_t* src;
+        const uint8_t* sbase;
         size_t sstride;
         size_t dstride;
+        uint8_t* dst;
+        uint8_t* dbase;
         size_t h;
-        size_t w;
-        size_t i;
+        size_t w = sourceImage.width();
+        CONV_VIA_FLOAT( Conv_f16_to_f, w * 4, Conv_XYZAf_to_ZYXAu8, w, w * 4, dstImage, uint8_t*, sourceImage, uint16_t* )
+    }
+
+    #undef CONV_VIA_FLOAT
 
+    /* packed RGB/BGR to float goes through a RGBA/BGRA u8 row */
+    static void Conv_XXXu8_to_XXXAf( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    {
         SIMD* simd = SIMD::instance();
+        size_t sstride, dstride;
+        const uint8_t* sbase = sourceImage.map( &sstride );
+        uint8_t* dbase = dstImage.map( &dstride );
+        const uint8_t* src = sbase;
+        uint8_t* dst = dbase;
+        size_t w = sourceImage.width();
+        size_t h = sourceImage.height();
+        ScopedBuffer<uint8_t, true> tmp( w * 4 );
 
-        osrc = sourceImage.map( &sstride );
-        src1 = ( uint32_t* ) osrc;
-        sstride = sstride >> 2;
-        src2 = src1 + sstride;
-        src3 = src2 + sstride;
-        w = sourceImage.width();
-        h = sourceImage.height();
-        odst = dstImage.map( &dstride );
-        dst = ( uint32_t* ) odst;
-        dstride = dstride >> 2;
-
-        simd->debayer_EVEN_RGGBu8_BGRAu8( dst, src2, src1, src2, w >> 2 );
-        dst += dstride;
-        for( i = 1; i < h - 1; i += 2 ) {
-            simd->debayer_ODD_RGGBu8_BGRAu8( dst, src1, src2, src3, w >> 2 );
-            dst += dstride;
-            src1 += sstride;
-            src2 += sstride;
-            src3 += sstride;
-            simd->debayer_EVEN_RGGBu8_BGRAu8( dst, src1, src2, src3, w >> 2 );
+        while( h-- ) {
+            simd->Conv_XXXu8_to_XXXAu8( tmp.ptr(), src, w );
+            simd->Conv_XXXAu8_to_XXXAf( ( float* ) dst, tmp.ptr(), w );
+            src += sstride;
             dst += dstride;
-            src1 += sstride;
-            src2 += sstride;
-            src3 += sstride;
         }
-        if( i < h ) {
-            if( i & 1 ) {
-                simd->debayer_ODD_RGGBu8_BGRAu8( dst, src1, src2, src1, w >> 2 );
-            } else {
-                simd->debayer_EVEN_RGGBu8_BGRAu8( dst, src1, src2, src1, w >> 2 );
-            }
-        }
-        dstImage.unmap( odst );
-        sourceImage.unmap( osrc );
+        sourceImage.unmap( sbase );
+        dstImage.unmap( dbase );
     }
 
-    void Conv_BAYER_RGGB_to_GRAYu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    static void Conv_XYZu8_to_ZYXAf( Image & dstImage, const Image & sourceImage, IConvertFlags )
     {
-        const uint32_t* src1;
-        const uint32_t* src2;
-        const uint32_t* src3;
-        const uint8_t* osrc;
-        uint32_t* dst;
-        uint8_t* odst;
-        size_t sstride;
-        size_t dstride;
-        size_t h;
-        size_t w;
-        size_t i;
-
         SIMD* simd = SIMD::instance();
+        size_t sstride, dstride;
+        const uint8_t* sbase = sourceImage.map( &sstride );
+        uint8_t* dbase = dstImage.map( &dstride );
+        const uint8_t* src = sbase;
+        uint8_t* dst = dbase;
+        size_t w = sourceImage.width();
+        size_t h = sourceImage.height();
+        ScopedBuffer<uint8_t, true> tmp( w * 4 );
 
-        osrc = sourceImage.map( &sstride );
-        src1 = ( uint32_t* ) osrc;
-        sstride = sstride >> 2;
-        src2 = src1 + sstride;
-        src3 = src2 + sstride;
-        w = sourceImage.width();
-        h = sourceImage.height();
-        odst = dstImage.map( &dstride );
-        dst = ( uint32_t* ) odst;
-        dstride = dstride >> 2;
-
-        simd->debayer_EVEN_RGGBu8_GRAYu8( dst, src2, src1, src2, w >> 2 );
-        dst += dstride;
-        for( i = 1; i < h - 1; i += 2 ) {
-            simd->debayer_ODD_RGGBu8_GRAYu8( dst, src1, src2, src3, w >> 2 );
-            dst += dstride;
-            src1 += sstride;
-            src2 += sstride;
-            src3 += sstride;
-            simd->debayer_EVEN_RGGBu8_GRAYu8( dst, src1, src2, src3, w >> 2 );
+        while( h-- ) {
+            simd->Conv_XYZu8_to_ZYXAu8( tmp.ptr(), src, w );
+            simd->Conv_XXXAu8_to_XXXAf( ( float* ) dst, tmp.ptr(), w );
+            src += sstride;
             dst += dstride;
-            src1 += sstride;
-            src2 += sstride;
-            src3 += sstride;
         }
-        if( i < h ) {
-            if( ++i & 1 ) {
-                simd->debayer_ODD_RGGBu8_GRAYu8( dst, src1, src2, src1, w >> 2 );
-            } else {
-                simd->debayer_EVEN_RGGBu8_GRAYu8( dst, src1, src2, src1, w >> 2 );
-            }
+        sourceImage.unmap( sbase );
+        dstImage.unmap( dbase );
+    }
+
+    /*
+       Planar YUV 4:2:0: the luma plane is followed by the chroma data in the same buffer.
+       NV12 stores interleaved UV rows with the luma stride, I420 stores the U plane followed
+       by the V plane, both with half the luma stride.
+     */
+    static void Conv_YUV420_to_GRAYu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    {
+        size_t sstride, dstride;
+        const uint8_t* sbase = sourceImage.map( &sstride );
+        uint8_t* dbase = dstImage.map( &dstride );
+        const uint8_t* src = sbase;
+        uint8_t* dst = dbase;
+        size_t w = sourceImage.width();
+        size_t h = sourceImage.height();
+
+        while( h-- ) {
+            SIMD::instance()->Memcpy( dst, src, w );
+            src += sstride;
+            dst += dstride;
         }
-        simd->debayer_EVEN_RGGBu8_GRAYu8( dst, src2, src1, src2, w >> 2 );
-        dstImage.unmap( odst );
-        sourceImage.unmap( osrc );
+        sourceImage.unmap( sbase );
+        dstImage.unmap( dbase );
     }
 
-    void Conv_BAYER_GBRG_to_RGBAu8( Image & dstImage, const Image & sourceImage, IConvertFlags flags )
+    static void Conv_YUV420_to_GRAYf( Image & dstImage, const Image & sourceImage, IConvertFlags )
     {
-        const uint32_t* src1;
-        const uint32_t* src2;
-        const uint32_t* src3;
-        const uint32_t* src4;
-        const uint32_t* src5;
-        const uint8_t* osrc;
-        uint32_t* dst;
-        uint8_t* odst;
+        SIMD* simd = SIMD::instance();
+        const uint8_t* src;
+        const uint8_t* sbase;
         size_t sstride;
         size_t dstride;
+        uint8_t* dst;
+        uint8_t* dbase;
         size_t h;
-        size_t w;
-        size_t i;
+        CONV( Conv_u8_to_f, dstImage, float*, sourceImage, uint8_t*, sourceImage.width() )
+    }
 
+    static void Conv_NV12_to_XXXAu8( Image & dstImage, const Image & sourceImage, bool bgra )
+    {
         SIMD* simd = SIMD::instance();
+        size_t sstride, dstride;
+        const uint8_t* sbase = sourceImage.map( &sstride );
+        uint8_t* dbase = dstImage.map( &dstride );
+        uint8_t* dst = dbase;
+        size_t w = sourceImage.width();
+        size_t h = sourceImage.height();
+        const uint8_t* srcuv = sbase + h * sstride;
 
-        osrc = sourceImage.map( &sstride );
-        src1 = ( uint32_t* ) osrc;
-        sstride = sstride >> 2;
-        src2 = src1 + sstride;
-        src3 = src2 + sstride;
-        src4 = src3 + sstride;
-        src5 = src4 + sstride;
-        w = sourceImage.width();
-        h = sourceImage.height();
-        odst = dstImage.map( &dstride );
-        dst = ( uint32_t* ) odst;
-        dstride = dstride >> 2;
-
-		if( flags & ICONVERT_DEBAYER_HQLINEAR ) {
-			simd->debayer_ODD_RGGBu8_RGBAu8( dst, src2, src1, src2, w >> 2 );
-			dst += dstride;
-			simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src1, src2, src3, w >> 2 );
-			dst += dstride;
-			for( i = 2; i < h - 2; i += 2 ) {
-				simd->debayerhq_ODD_RGGBu8_RGBAu8( dst, src1, src2, src3, src4, src5, w );
-				dst += dstride;
-				src1 += sstride;
-				src2 += sstride;
-				src3 += sstride;
-				src4 += sstride;
-				src5 += sstride;
-				simd->debayerhq_EVEN_RGGBu8_RGBAu8( dst, src1, src2, src3, src4, src5, w );
-				dst += dstride;
-				src1 += sstride;
-				src2 += sstride;
-				src3 += sstride;
-				src4 += sstride;
-				src5 += sstride;
-			}
-			if( h - 2 == i ) {
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src2, src3, src4, w >> 2 );
-				dst += dstride;
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src3, src4, src3, w >> 2 );
-			} else {
-				simd->debayerhq_ODD_RGGBu8_RGBAu8( dst, src1, src2, src3, src4, src5, w );
-				dst += dstride;
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src3, src4, src5, w >> 2 );
-				dst += dstride;
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src3, src4, src3, w >> 2 );
-			}
-
-		} else {
-			simd->debayer_ODD_RGGBu8_RGBAu8( dst, src2, src1, src2, w >> 2 );
-			dst += dstride;
-			for( i = 1; i < h - 1; i += 2 ) {
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src1, src2, src3, w >> 2 );
-				dst += dstride;
-				src1 += sstride;
-				src2 += sstride;
-				src3 += sstride;
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src1, src2, src3, w >> 2 );
-				dst += dstride;
-				src1 += sstride;
-				src2 += sstride;
-				src3 += sstride;
-			}
-			if( h - 1 == i )
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src1, src2, src1, w >> 2 );
-			else {
-				simd->debayer_EVEN_RGGBu8_RGBAu8( dst, src1, src2, src3, w >> 2 );
-				dst += dstride;
-				simd->debayer_ODD_RGGBu8_RGBAu8( dst, src2, src3, src2, w >> 2 );
-			}
-		}
-
-            dstImage.unmap( odst );
-            sourceImage.unmap( osrc );
+        for( size_t y = 0; y < h; y++ ) {
+            if( bgra )
+                simd->Conv_NV12u8_to_BGRAu8( dst, sbase + y * sstride, srcuv + ( y >> 1 ) * sstride, w );
+            else
+                simd->Conv_NV12u8_to_RGBAu8( dst, sbase + y * sstride, srcuv + ( y >> 1 ) * sstride, w );
+            dst += dstride;
+        }
+        sourceImage.unmap( sbase );
+        dstImage.unmap( dbase );
     }
 
-    void Conv_BAYER_GBRG_to_GRAYu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    static void Conv_I420_to_XXXAu8( Image & dstImage, const Image & sourceImage, bool bgra )
     {
-        const uint32_t* src1;
-        const uint32_t* src2;
-        const uint32_t* src3;
-        const uint8_t* osrc;
-        uint32_t* dst;
-        uint8_t* odst;
-        size_t sstride;
-        size_t dstride;
-        size_t h;
-        size_t w;
-        size_t i;
-
         SIMD* simd = SIMD::instance();
+        size_t sstride, dstride;
+        const uint8_t* sbase = sourceImage.map( &sstride );
+        uint8_t* dbase = dstImage.map( &dstride );
+        uint8_t* dst = dbase;
+        size_t w = sourceImage.width();
+        size_t h = sourceImage.height();
+        size_t cstride = sstride >> 1;
+        const uint8_t* srcu = sbase + h * sstride;
+        const uint8_t* srcv = srcu + ( ( h + 1 ) >> 1 ) * cstride;
 
-        osrc = sourceImage.map( &sstride );
-        src1 = ( uint32_t* ) osrc;
-        sstride = sstride >> 2;
-        src2 = src1 + sstride;
-        src3 = src2 + sstride;
-        w = sourceImage.width();
-        h = sourceImage.height();
-        odst = dstImage.map( &dstride );
-        dst = ( uint32_t* ) odst;
-        dstride = dstride >> 2;
-
-        simd->debayer_ODD_RGGBu8_GRAYu8( dst, src2, src1, src2, w >> 2 );
-        dst += dstride;
-        for( i = 1; i < h - 1; i += 2 ) {
-            simd->debayer_EVEN_RGGBu8_GRAYu8( dst, src1, src2, src3, w >> 2 );
-            dst += dstride;
-            src1 += sstride;
-            src2 += sstride;
-            src3 += sstride;
-            simd->debayer_ODD_RGGBu8_GRAYu8( dst, src1, src2, src3, w >> 2 );
+        for( size_t y = 0; y < h; y++ ) {
+            if( bgra )
+                simd->Conv_YUV420u8_to_BGRAu8( dst, sbase + y * sstride, srcu + ( y >> 1 ) * cstride, srcv + ( y >> 1 ) * cstride, w );
+            else
+                simd->Conv_YUV420u8_to_RGBAu8( dst, sbase + y * sstride, srcu + ( y >> 1 ) * cstride, srcv + ( y >> 1 ) * cstride, w );
             dst += dstride;
-            src1 += sstride;
-            src2 += sstride;
-            src3 += sstride;
         }
-        if( i < h ) {
-            if( ++i & 1 ) {
-                simd->debayer_EVEN_RGGBu8_GRAYu8( dst, src1, src2, src1, w >> 2 );
-            } else {
-                simd->debayer_ODD_RGGBu8_GRAYu8( dst, src1, src2, src1, w >> 2 );
-            }
-        }
-        simd->debayer_ODD_RGGBu8_GRAYu8( dst, src2, src1, src2, w >> 2 );
-        dstImage.unmap( odst );
-        sourceImage.unmap( osrc );
+        sourceImage.unmap( sbase );
+        dstImage.unmap( dbase );
     }
 
-    void Conv_BAYER_GBRG_to_BGRAu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    static void Conv_NV12_to_RGBAu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
     {
-        const uint32_t* src1;
-        const uint32_t* src2;
-        const uint32_t* src3;
-        const uint8_t* osrc;
-        uint32_t* dst;
-        uint8_t* odst;
-        size_t sstride;
-        size_t dstride;
-        size_t h;
-        size_t w;
-        size_t i;
+        Conv_NV12_to_XXXAu8( dstImage, sourceImage, false );
+    }
 
-        SIMD* simd = SIMD::instance();
+    static void Conv_NV12_to_BGRAu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    {
+        Conv_NV12_to_XXXAu8( dstImage, sourceImage, true );
+    }
 
-        osrc = sourceImage.map( &sstride );
-        src1 = ( uint32_t* ) osrc;
-        sstride = sstride >> 2;
-        src2 = src1 + sstride;
-        src3 = src2 + sstride;
-        w = sourceImage.width();
-        h = sourceImage.height();
-        odst = dstImage.map( &dstride );
-        dst = ( uint32_t* ) odst;
-        dstride = dstride >> 2;
-
-        simd->debayer_ODD_RGGBu8_BGRAu8( dst, src2, src1, src2, w >> 2 );
-        dst += dstride;
-        for( i = 1; i < h - 1; i += 2 ) {
-            simd->debayer_EVEN_RGGBu8_BGRAu8( dst, src1, src2, src3, w >> 2 );
-            dst += dstride;
-            src1 += sstride;
-            src2 += sstride;
-            src3 += sstride;
-            simd->debayer_ODD_RGGBu8_BGRAu8( dst, src1, src2, src3, w >> 2 );
-            dst += dstride;
-            src1 += sstride;
-            src2 += sstride;
-            src3 += sstride;
-        }
-        if( i < h ) {
-            if( i & 1 ) {
-                simd->debayer_EVEN_RGGBu8_BGRAu8( dst, src1, src2, src1, w >> 2 );
-            } else {
-                simd->debayer_ODD_RGGBu8_BGRAu8( dst, src1, src2, src1, w >> 2 );
-            }
-        }
-        dstImage.unmap( odst );
-        sourceImage.unmap( osrc );
+    static void Conv_I420_to_RGBAu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    {
+        Conv_I420_to_XXXAu8( dstImage, sourceImage, false );
+    }
+
+    static void Conv_I420_to_BGRAu8( Image & dstImage, const Image & sourceImage, IConvertFlags )
+    {
+        Conv_I420_to_XXXAu8( dstImage, sourceImage, true );
     }
 
+#undef CONV
+
     IConvert::IConvert():
         _convertFuncs( 0 )
     {
@@ -985,15 +830,37 @@ namespace cvt {
         TABLE( _convertFuncs, IFORMAT_BGRA_FLOAT, IFORMAT_RGBA_FLOAT )  = &Conv_XYZAf_to_ZYXAf;
         TABLE( _convertFuncs, IFORMAT_BGRA_FLOAT, IFORMAT_GRAY_FLOAT )  = &Conv_BGRAf_to_GRAYf;
 
-        /* RGGB_UINT8 to X */
-        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_GRAY_UINT8 ) = &Conv_BAYER_RGGB_to_GRAYu8;
-        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_RGBA_UINT8 ) = &Conv_BAYER_RGGB_to_RGBAu8;
-        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_BGRA_UINT8 ) = &Conv_BAYER_RGGB_to_BGRAu8;
-
-        /* GBRG_UINT8 to X */
-        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_GRAY_UINT8 ) = &Conv_BAYER_RGGB_to_GRAYu8;
-        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_RGBA_UINT8 ) = &Conv_BAYER_GBRG_to_RGBAu8;
-        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_BGRA_UINT8 ) = &Conv_BAYER_GBRG_to_BGRAu8;
+        /* BAYER_RGGB_UINT8 to X */
+        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_GRAY_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_GRAY_FLOAT ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_RGBA_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_BGRA_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_RGBA_FLOAT ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_RGGB_UINT8, IFORMAT_BGRA_FLOAT ) = &IDebayer::debayer;
+
+        /* BAYER_GRBG_UINT8 to X */
+        TABLE( _convertFuncs, IFORMAT_BAYER_GRBG_UINT8, IFORMAT_GRAY_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GRBG_UINT8, IFORMAT_GRAY_FLOAT ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GRBG_UINT8, IFORMAT_RGBA_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GRBG_UINT8, IFORMAT_BGRA_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GRBG_UINT8, IFORMAT_RGBA_FLOAT ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GRBG_UINT8, IFORMAT_BGRA_FLOAT ) = &IDebayer::debayer;
+
+        /* BAYER_GBRG_UINT8 to X */
+        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_GRAY_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_GRAY_FLOAT ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_RGBA_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_BGRA_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_RGBA_FLOAT ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_GBRG_UINT8, IFORMAT_BGRA_FLOAT ) = &IDebayer::debayer;
+
+        /* BAYER_BGGR_UINT8 to X */
+        TABLE( _convertFuncs, IFORMAT_BAYER_BGGR_UINT8, IFORMAT_GRAY_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_BGGR_UINT8, IFORMAT_GRAY_FLOAT ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_BGGR_UINT8, IFORMAT_RGBA_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_BGGR_UINT8, IFORMAT_BGRA_UINT8 ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_BGGR_UINT8, IFORMAT_RGBA_FLOAT ) = &IDebayer::debayer;
+        TABLE( _convertFuncs, IFORMAT_BAYER_BGGR_UINT8, IFORMAT_BGRA_FLOAT ) = &IDebayer::debayer;
 
         /* YUYV_UINT8 to X */
         TABLE( _convertFuncs, IFORMAT_YUYV_UINT8, IFORMAT_GRAY_UINT8 ) = &Conv_YUYVu8_to_GRAYu8;
@@ -1008,6 +875,49 @@ namespace cvt {
         TABLE( _convertFuncs, IFORMAT_UYVY_UINT8, IFORMAT_RGBA_UINT8 ) = &Conv_UYVYu8_to_RGBAu8;
         TABLE( _convertFuncs, IFORMAT_UYVY_UINT8, IFORMAT_BGRA_UINT8 ) = &Conv_UYVYu8_to_BGRAu8;
         TABLE( _convertFuncs, IFORMAT_UYVY_UINT8, IFORMAT_GRAY_FLOAT ) = &Conv_UYVYu8_to_GRAYf;
+
+        /* GRAY_FLOAT16 TO X */
+        TABLE( _convertFuncs, IFORMAT_GRAY_FLOAT16, IFORMAT_GRAY_FLOAT ) = &Conv_f16_to_f;
+        TABLE( _convertFuncs, IFORMAT_GRAY_FLOAT16, IFORMAT_GRAY_UINT8 ) = &Conv_GRAYf16_to_GRAYu8;
+        TABLE( _convertFuncs, IFORMAT_GRAY_FLOAT, IFORMAT_GRAY_FLOAT16 ) = &Conv_f_to_f16;
+
+        /* RGBA_FLOAT16 TO X */
+        TABLE( _convertFuncs, IFORMAT_RGBA_FLOAT16, IFORMAT_RGBA_FLOAT ) = &Conv_f16_to_f;
+        TABLE( _convertFuncs, IFORMAT_RGBA_FLOAT16, IFORMAT_RGBA_UINT8 ) = &Conv_RGBAf16_to_RGBAu8;
+        TABLE( _convertFuncs, IFORMAT_RGBA_FLOAT16, IFORMAT_BGRA_UINT8 ) = &Conv_RGBAf16_to_BGRAu8;
+        TABLE( _convertFuncs, IFORMAT_RGBA_FLOAT, IFORMAT_RGBA_FLOAT16 ) = &Conv_f_to_f16;
+
+        /* RGB_UINT8 TO X */
+        TABLE( _convertFuncs, IFORMAT_RGB_UINT8, IFORMAT_RGBA_UINT8 ) = &Conv_XXXu8_to_XXXAu8;
+        TABLE( _convertFuncs, IFORMAT_RGB_UINT8, IFORMAT_BGRA_UINT8 ) = &Conv_XYZu8_to_ZYXAu8;
+        TABLE( _convertFuncs, IFORMAT_RGB_UINT8, IFORMAT_RGBA_FLOAT ) = &Conv_XXXu8_to_XXXAf;
+        TABLE( _convertFuncs, IFORMAT_RGB_UINT8, IFORMAT_BGRA_FLOAT ) = &Conv_XYZu8_to_ZYXAf;
+        TABLE( _convertFuncs, IFORMAT_RGB_UINT8, IFORMAT_GRAY_UINT8 ) = &Conv_RGBu8_to_GRAYu8;
+        TABLE( _convertFuncs, IFORMAT_RGB_UINT8, IFORMAT_GRAY_FLOAT ) = &Conv_RGBu8_to_GRAYf;
+        TABLE( _convertFuncs, IFORMAT_RGBA_UINT8, IFORMAT_RGB_UINT8 ) = &Conv_XXXAu8_to_XXXu8;
+        TABLE( _convertFuncs, IFORMAT_BGRA_UINT8, IFORMAT_RGB_UINT8 ) = &Conv_XYZAu8_to_ZYXu8;
+
+        /* BGR_UINT8 TO X */
+        TABLE( _convertFuncs, IFORMAT_BGR_UINT8, IFORMAT_BGRA_UINT8 ) = &Conv_XXXu8_to_XXXAu8;
+        TABLE( _convertFuncs, IFORMAT_BGR_UINT8, IFORMAT_RGBA_UINT8 ) = &Conv_XYZu8_to_ZYXAu8;
+        TABLE( _convertFuncs, IFORMAT_BGR_UINT8, IFORMAT_BGRA_FLOAT ) = &Conv_XXXu8_to_XXXAf;
+        TABLE( _convertFuncs, IFORMAT_BGR_UINT8, IFORMAT_RGBA_FLOAT ) = &Conv_XYZu8_to_ZYXAf;
+        TABLE( _convertFuncs, IFORMAT_BGR_UINT8, IFORMAT_GRAY_UINT8 ) = &Conv_BGRu8_to_GRAYu8;
+        TABLE( _convertFuncs, IFORMAT_BGR_UINT8, IFORMAT_GRAY_FLOAT ) = &Conv_BGRu8_to_GRAYf;
+        TABLE( _convertFuncs, IFORMAT_BGRA_UINT8, IFORMAT_BGR_UINT8 ) = &Conv_XXXAu8_to_XXXu8;
+        TABLE( _convertFuncs, IFORMAT_RGBA_UINT8, IFORMAT_BGR_UINT8 ) = &Conv_XYZAu8_to_ZYXu8;
+
+        /* NV12_UINT8 TO X */
+        TABLE( _convertFuncs, IFORMAT_NV12_UINT8, IFORMAT_GRAY_UINT8 ) = &Conv_YUV420_to_GRAYu8;
+        TABLE( _convertFuncs, IFORMAT_NV12_UINT8, IFORMAT_GRAY_FLOAT ) = &Conv_YUV420_to_GRAYf;
+        TABLE( _convertFuncs, IFORMAT_NV12_UINT8, IFORMAT_RGBA_UINT8 ) = &Conv_NV12_to_RGBAu8;
+        TABLE( _convertFuncs, IFORMAT_NV12_UINT8, IFORMAT_BGRA_UINT8 ) = &Conv_NV12_to_BGRAu8;
+
+        /* I420_UINT8 TO X */
+        TABLE( _convertFuncs, IFORMAT_I420_UINT8, IFORMAT_GRAY_UINT8 ) = &Conv_YUV420_to_GRAYu8;
+        TABLE( _convertFuncs, IFORMAT_I420_UINT8, IFORMAT_GRAY_FLOAT ) = &Conv_YUV420_to_GRAYf;
+        TABLE( _convertFuncs, IFORMAT_I420_UINT8, IFORMAT_RGBA_UINT8 ) = &Conv_I420_to_RGBAu8;
+        TABLE( _convertFuncs, IFORMAT_I420_UINT8, IFORMAT_BGRA_UINT8 ) = &Conv_I420_to_BGRAu8;
     }
 
     const IConvert& IConvert::instance()
@@ -0,0 +1,200 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/IDebayer.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+
+namespace cvt {
+
+	/* mirror index at the borders without repeating the border pixel, keeps the CFA parity */
+	static inline size_t _debayerReflect( long i, size_t n )
+	{
+		if( i < 0 )
+			i = -i;
+		if( i >= ( long ) n )
+			i = 2 * ( long ) n - 2 - i;
+		if( i < 0 || i >= ( long ) n )
+			i &= 1;
+		return ( size_t ) i;
+	}
+
+	class DebayerBand {
+		public:
+			DebayerBand( uint8_t* dst, size_t dstride, const IFormat& dstformat,
+						 const uint8_t* src, size_t sstride, const IFormat& srcformat,
+						 size_t width, size_t height, bool hq );
+
+			void operator()( size_t ystart, size_t yend ) const;
+
+		private:
+			void loadRow( uint8_t* buf, long y ) const;
+
+			uint8_t*		_dst;
+			size_t			_dstride;
+			IFormatID		_dstformat;
+			const uint8_t*	_src;
+			size_t			_sstride;
+			size_t			_width;
+			size_t			_height;
+			size_t			_rx, _ry;
+			bool			_hq;
+	};
+
+	inline DebayerBand::DebayerBand( uint8_t* dst, size_t dstride, const IFormat& dstformat,
+									 const uint8_t* src, size_t sstride, const IFormat& srcformat,
+									 size_t width, size_t height, bool hq ) :
+		_dst( dst ),
+		_dstride( dstride ),
+		_dstformat( dstformat.formatID ),
+		_src( src ),
+		_sstride( sstride ),
+		_width( width ),
+		_height( height ),
+		_hq( hq )
+	{
+		/* position of the red pixel in the 2x2 cell */
+		switch( srcformat.formatID ) {
+			case IFORMAT_BAYER_RGGB_UINT8: _rx = 0; _ry = 0; break;
+			case IFORMAT_BAYER_GRBG_UINT8: _rx = 1; _ry = 0; break;
+			case IFORMAT_BAYER_GBRG_UINT8: _rx = 0; _ry = 1; break;
+			case IFORMAT_BAYER_BGGR_UINT8: _rx = 1; _ry = 1; break;
+			default:
+				throw CVTException( "Debayer: source is not a Bayer image" );
+		}
+	}
+
+	inline void DebayerBand::loadRow( uint8_t* buf, long y ) const
+	{
+		const uint8_t* src = _src + _sstride * _debayerReflect( y, _height );
+
+		SIMD::instance()->Memcpy( buf, src, _width );
+		buf[ -2 ] = src[ _debayerReflect( -2, _width ) ];
+		buf[ -1 ] = src[ _debayerReflect( -1, _width ) ];
+		buf[ _width ] = src[ _debayerReflect( _width, _width ) ];
+		buf[ _width + 1 ] = src[ _debayerReflect( _width + 1, _width ) ];
+	}
+
+	void DebayerBand::operator()( size_t ystart, size_t yend ) const
+	{
+		SIMD* simd = SIMD::instance();
+		const long radius = _hq ? 2 : 1;
+		const size_t nrows = 2 * radius + 1;
+		/* two pixels of border on each side, keep the row start 16 byte aligned */
+		const size_t rowsize = Math::pad16( _width + 4 ) + 16;
+		const bool direct = _dstformat == IFORMAT_RGBA_UINT8 || _dstformat == IFORMAT_BGRA_UINT8;
+		const bool bgra = _dstformat == IFORMAT_BGRA_UINT8 || _dstformat == IFORMAT_BGRA_FLOAT;
+		ScopedBuffer<uint8_t, true> rowbuf( rowsize * nrows );
+		ScopedBuffer<uint32_t, true> tmp( direct ? 1 : _width );
+		const uint8_t* rows[ 5 ];
+		uint8_t* ring[ 5 ];
+
+		for( size_t i = 0; i < nrows; i++ )
+			ring[ i ] = rowbuf.ptr() + i * rowsize + 16;
+
+		/* ring slot of row y is ( y - ystart + radius ) % nrows */
+		for( long r = -radius; r < radius; r++ )
+			loadRow( ring[ r + radius ], ( long ) ystart + r );
+
+		for( size_t y = ystart; y < yend; y++ ) {
+			loadRow( ring[ ( y - ystart + 2 * radius ) % nrows ], ( long ) y + radius );
+			for( size_t k = 0; k < nrows; k++ )
+				rows[ k ] = ring[ ( y - ystart + k ) % nrows ];
+
+			bool redrow = ( y & 1 ) == _ry;
+			size_t phase = redrow ? _rx : 1 - _rx;
+			uint32_t* out = direct ? ( uint32_t* ) ( _dst + y * _dstride ) : tmp.ptr();
+
+			if( _hq )
+				simd->debayer_MHCu8_RGBAu8( out, rows, _width, phase, redrow != bgra );
+			else
+				simd->debayer_LINEARu8_RGBAu8( out, rows, _width, phase, redrow != bgra );
+
+			switch( _dstformat ) {
+				case IFORMAT_GRAY_UINT8:
+					simd->Conv_RGBAu8_to_GRAYu8( _dst + y * _dstride, ( const uint8_t* ) out, _width );
+					break;
+				case IFORMAT_GRAY_FLOAT:
+					simd->Conv_RGBAu8_to_GRAYf( ( float* ) ( _dst + y * _dstride ), ( const uint8_t* ) out, _width );
+					break;
+				case IFORMAT_RGBA_FLOAT:
+				case IFORMAT_BGRA_FLOAT:
+					simd->Conv_XXXAu8_to_XXXAf( ( float* ) ( _dst + y * _dstride ), ( const uint8_t* ) out, _width );
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	static void _debayerCheckFormat( const IFormat& dstformat )
+	{
+		switch( dstformat.formatID ) {
+			case IFORMAT_GRAY_UINT8:
+			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_RGBA_UINT8:
+			case IFORMAT_BGRA_UINT8:
+			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_BGRA_FLOAT:
+				break;
+			default:
+				throw CVTException( "Debayer: unsupported destination format" );
+		}
+	}
+
+	void IDebayer::debayer( Image& dst, const Image& src, IConvertFlags flags )
+	{
+		if( dst.width() != src.width() || dst.height() != src.height() )
+			throw CVTException( "Debayer: source and destination size differ" );
+		if( src.width() < 2 || src.height() < 2 )
+			throw CVTException( "Debayer: image too small" );
+		_debayerCheckFormat( dst.format() );
+
+		IMapScoped<uint8_t> mapdst( dst );
+		IMapScoped<const uint8_t> mapsrc( src );
+
+		DebayerBand band( mapdst.base(), mapdst.stride(), dst.format(),
+						  mapsrc.base(), mapsrc.stride(), src.format(),
+						  src.width(), src.height(), flags & ICONVERT_DEBAYER_HQLINEAR );
+		ParallelFor::run( band, 0, src.height(), 32 );
+	}
+
+	void IDebayer::debayerRows( uint8_t* dst, size_t dstride, const IFormat& dstformat,
+								const uint8_t* src, size_t sstride, const IFormat& srcformat,
+								size_t width, size_t height, size_t ystart, size_t yend,
+								IConvertFlags flags )
+	{
+		if( width < 2 || height < 2 )
+			throw CVTException( "Debayer: image too small" );
+		_debayerCheckFormat( dstformat );
+
+		DebayerBand band( dst, dstride, dstformat, src, sstride, srcformat,
+						  width, height, flags & ICONVERT_DEBAYER_HQLINEAR );
+		band( ystart, Math::min( yend, height ) );
+	}
+}
@@ -0,0 +1,65 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_IDEBAYER_H
+#define CVT_IDEBAYER_H
+
+#include <cvt/gfx/IConvert.h>
+
+namespace cvt {
+	class Image;
+
+	class IDebayer {
+		public:
+			/**
+			  @brief Demosaic a Bayer image with RGGB, GRBG, GBRG or BGGR pattern.
+
+			  dst has to be allocated with the size of src, supported destination formats are
+			  GRAY_UINT8, GRAY_FLOAT, RGBA_UINT8, BGRA_UINT8, RGBA_FLOAT and BGRA_FLOAT.
+			  ICONVERT_DEBAYER_HQLINEAR selects the gradient-corrected interpolation of
+			  Malvar, He and Cutler, otherwise bilinear interpolation is used.
+			  The image borders are mirrored, the rows are processed in parallel bands.
+			 */
+			static void debayer( Image& dst, const Image& src, IConvertFlags flags = ICONVERT_DEBAYER_LINEAR );
+
+			/**
+			  @brief Demosaic the rows [ ystart, yend ) of mapped Bayer image data.
+
+			  Rows outside the range are only read as context, the destination rows
+			  are addressed as dst + y * dstride. The range is processed by the calling thread,
+			  this allows to fuse the demosaicing with further row-wise processing.
+			 */
+			static void debayerRows( uint8_t* dst, size_t dstride, const IFormat& dstformat,
+									 const uint8_t* src, size_t sstride, const IFormat& srcformat,
+									 size_t width, size_t height, size_t ystart, size_t yend,
+									 IConvertFlags flags = ICONVERT_DEBAYER_LINEAR );
+
+		private:
+			IDebayer();
+			IDebayer( const IDebayer& );
+	};
+}
+
+#endif
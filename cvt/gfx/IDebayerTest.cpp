@@ -0,0 +1,164 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/IDebayer.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+namespace cvt {
+
+	/* mosaic a constant color, ( rx, ry ) is the position of red in the 2x2 cell */
+	static void _mosaic( Image& bayer, size_t rx, size_t ry, uint8_t r, uint8_t g, uint8_t b )
+	{
+		IMapScoped<uint8_t> map( bayer );
+		for( size_t y = 0; y < bayer.height(); y++ ) {
+			uint8_t* ptr = map.ptr();
+			for( size_t x = 0; x < bayer.width(); x++ ) {
+				bool redrow = ( y & 1 ) == ry;
+				bool redcol = ( x & 1 ) == rx;
+				if( redrow == redcol )
+					ptr[ x ] = redrow ? r : b;
+				else
+					ptr[ x ] = g;
+			}
+			map++;
+		}
+	}
+
+	static bool _constantColorTest( const IFormat& pattern, size_t rx, size_t ry, IConvertFlags flags )
+	{
+		Image bayer( 37, 23, pattern );
+		Image rgba, bgra, gray;
+		bool ret = true;
+
+		_mosaic( bayer, rx, ry, 200, 100, 50 );
+		rgba.reallocate( bayer.width(), bayer.height(), IFormat::RGBA_UINT8 );
+		bgra.reallocate( bayer.width(), bayer.height(), IFormat::BGRA_UINT8 );
+		IDebayer::debayer( rgba, bayer, flags );
+		IDebayer::debayer( bgra, bayer, flags );
+
+		IMapScoped<const uint8_t> mrgba( rgba );
+		IMapScoped<const uint8_t> mbgra( bgra );
+		for( size_t y = 0; y < bayer.height(); y++ ) {
+			const uint32_t* p1 = ( const uint32_t* ) mrgba.ptr();
+			const uint32_t* p2 = ( const uint32_t* ) mbgra.ptr();
+			for( size_t x = 0; x < bayer.width(); x++ ) {
+				ret &= p1[ x ] == 0xff3264c8;
+				ret &= p2[ x ] == 0xffc86432;
+			}
+			mrgba++;
+			mbgra++;
+		}
+		return ret;
+	}
+
+	static bool _simdTest()
+	{
+		const size_t n = 53;
+		uint8_t rowdata[ 5 ][ n + 4 ];
+		const uint8_t* rows[ 5 ];
+		uint32_t out[ n ], ref[ n ];
+		bool ret = true;
+
+		for( size_t k = 0; k < 5; k++ ) {
+			for( size_t x = 0; x < n + 4; x++ )
+				rowdata[ k ][ x ] = ( uint8_t ) Math::rand( 0.0f, 255.0f );
+			rows[ k ] = rowdata[ k ] + 2;
+		}
+
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMDType bestType = SIMD::bestSupportedType();
+		for( int st = SIMD_BASE; st <= bestType; st++ ) {
+			SIMD* simd = SIMD::get( ( SIMDType ) st );
+			for( size_t phase = 0; phase < 2; phase++ ) {
+				for( int redrow = 0; redrow < 2; redrow++ ) {
+					base->debayer_LINEARu8_RGBAu8( ref, rows + 1, n, phase, redrow );
+					simd->debayer_LINEARu8_RGBAu8( out, rows + 1, n, phase, redrow );
+					for( size_t x = 0; x < n; x++ )
+						ret &= out[ x ] == ref[ x ];
+
+					base->debayer_MHCu8_RGBAu8( ref, rows, n, phase, redrow );
+					simd->debayer_MHCu8_RGBAu8( out, rows, n, phase, redrow );
+					for( size_t x = 0; x < n; x++ )
+						ret &= out[ x ] == ref[ x ];
+				}
+			}
+			delete simd;
+		}
+		delete base;
+		return ret;
+	}
+
+	struct DebayerHQ {
+		DebayerHQ( const Image& b ) : bayer( b ) {}
+		void operator()( Image& out ) const { IDebayer::debayer( out, bayer, ICONVERT_DEBAYER_HQLINEAR ); }
+		const Image& bayer;
+	};
+
+	static bool _threadTest()
+	{
+		Image bayer( 128, 97, IFormat::BAYER_GRBG_UINT8 );
+		{
+			IMapScoped<uint8_t> map( bayer );
+			for( size_t y = 0; y < bayer.height(); y++ ) {
+				for( size_t x = 0; x < bayer.width(); x++ )
+					map.ptr()[ x ] = ( uint8_t ) Math::rand( 0.0f, 255.0f );
+				map++;
+			}
+		}
+		return testThreadInvariance( DebayerHQ( bayer ), testImagesEqual, Image( 128, 97, IFormat::GRAY_FLOAT ) );
+	}
+
+BEGIN_CVTTEST( debayer )
+	bool result = true;
+	bool b;
+
+	const IFormat* patterns[ 4 ] = { &IFormat::BAYER_RGGB_UINT8, &IFormat::BAYER_GRBG_UINT8,
+									 &IFormat::BAYER_GBRG_UINT8, &IFormat::BAYER_BGGR_UINT8 };
+	for( size_t i = 0; i < 4; i++ ) {
+		b = _constantColorTest( *patterns[ i ], i & 1, i >> 1, ICONVERT_DEBAYER_LINEAR );
+		CVTTEST_PRINT( *patterns[ i ] << " linear constant color", b );
+		result &= b;
+		b = _constantColorTest( *patterns[ i ], i & 1, i >> 1, ICONVERT_DEBAYER_HQLINEAR );
+		CVTTEST_PRINT( *patterns[ i ] << " MHC constant color", b );
+		result &= b;
+	}
+
+	b = _simdTest();
+	CVTTEST_PRINT( "SIMD kernels", b );
+	result &= b;
+
+	b = _threadTest();
+	CVTTEST_PRINT( "Row band threading", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
+
+}
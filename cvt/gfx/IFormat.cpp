@@ -50,6 +50,13 @@ namespace cvt {
     const IFormat IFormat::BAYER_GBRG_UINT8		= FORMATDESC( 1, uint8_t	, IFORMAT_BAYER_GBRG_UINT8  , IFORMAT_TYPE_UINT8 );
 	const IFormat IFormat::YUYV_UINT8			= FORMATDESC( 2, uint8_t	, IFORMAT_YUYV_UINT8		, IFORMAT_TYPE_UINT8 );
 	const IFormat IFormat::UYVY_UINT8			= FORMATDESC( 2, uint8_t	, IFORMAT_UYVY_UINT8		, IFORMAT_TYPE_UINT8 );
+	const IFormat IFormat::GRAY_FLOAT16			= FORMATDESC( 1, uint16_t	, IFORMAT_GRAY_FLOAT16		, IFORMAT_TYPE_FLOAT16 );
+	const IFormat IFormat::RGBA_FLOAT16			= FORMATDESC( 4, uint16_t	, IFORMAT_RGBA_FLOAT16		, IFORMAT_TYPE_FLOAT16 );
+	const IFormat IFormat::RGB_UINT8			= FORMATDESC( 3, uint8_t	, IFORMAT_RGB_UINT8			, IFORMAT_TYPE_UINT8 );
+	const IFormat IFormat::BGR_UINT8			= FORMATDESC( 3, uint8_t	, IFORMAT_BGR_UINT8			, IFORMAT_TYPE_UINT8 );
+	const IFormat IFormat::NV12_UINT8			= FORMATDESC( 1, uint8_t	, IFORMAT_NV12_UINT8		, IFORMAT_TYPE_UINT8 );
+	const IFormat IFormat::I420_UINT8			= FORMATDESC( 1, uint8_t	, IFORMAT_I420_UINT8		, IFORMAT_TYPE_UINT8 );
+	const IFormat IFormat::BAYER_BGGR_UINT8		= FORMATDESC( 1, uint8_t	, IFORMAT_BAYER_BGGR_UINT8	, IFORMAT_TYPE_UINT8 );
 
 #undef FORMATDESC
 
@@ -86,7 +93,14 @@ namespace cvt {
             "BAYER_GRBG_UINT8",
             "BAYER_GBRG_UINT8",
 			"YUYV_UINT8",
-			"UYVY_UINT8"
+			"UYVY_UINT8",
+			"GRAY_FLOAT16",
+			"RGBA_FLOAT16",
+			"RGB_UINT8",
+			"BGR_UINT8",
+			"NV12_UINT8",
+			"I420_UINT8",
+			"BAYER_BGGR_UINT8"
 		};
 
 		out << "Format: " << _iformatstring[ f.formatID - 1 ];
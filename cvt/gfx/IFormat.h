@@ -59,7 +59,17 @@ namespace cvt
         IFORMAT_BAYER_GRBG_UINT8,
         IFORMAT_BAYER_GBRG_UINT8,
 		IFORMAT_YUYV_UINT8,
-		IFORMAT_UYVY_UINT8
+		IFORMAT_UYVY_UINT8,
+
+		IFORMAT_GRAY_FLOAT16,
+		IFORMAT_RGBA_FLOAT16,
+
+		IFORMAT_RGB_UINT8,
+		IFORMAT_BGR_UINT8,
+
+		IFORMAT_NV12_UINT8,
+		IFORMAT_I420_UINT8,
+		IFORMAT_BAYER_BGGR_UINT8
 	};
 
 	enum IFormatType
@@ -68,7 +78,8 @@ namespace cvt
 		IFORMAT_TYPE_UINT8,
 		IFORMAT_TYPE_UINT16,
 		IFORMAT_TYPE_INT16,
-		IFORMAT_TYPE_FLOAT
+		IFORMAT_TYPE_FLOAT,
+		IFORMAT_TYPE_FLOAT16
 	};
 
 	struct IFormat
@@ -104,11 +115,31 @@ namespace cvt
         static const IFormat BAYER_GBRG_UINT8;
 		static const IFormat YUYV_UINT8;
 		static const IFormat UYVY_UINT8;
+		static const IFormat GRAY_FLOAT16;
+		static const IFormat RGBA_FLOAT16;
+		static const IFormat RGB_UINT8;
+		static const IFormat BGR_UINT8;
+		static const IFormat NV12_UINT8;
+		static const IFormat I420_UINT8;
+		static const IFormat BAYER_BGGR_UINT8;
+
+		/**
+		 * Planar YUV 4:2:0 formats (NV12, I420) describe the luma plane only,
+		 * the chroma planes are stored below the luma plane using the same stride.
+		 * @return true if the format stores additional chroma planes
+		 */
+		bool isPlanar() const;
+
+		/**
+		 * @return number of rows of size stride needed to store an image with the given height
+		 */
+		size_t allocRows( size_t height ) const;
 
 		static const IFormat& uint8Equivalent( const IFormat& format );
 		static const IFormat& uint16Equivalent( const IFormat& format );
 		static const IFormat& int16Equivalent( const IFormat& format );
 		static const IFormat& floatEquivalent( const IFormat& format );
+		static const IFormat& float16Equivalent( const IFormat& format );
         static const IFormat& formatForId( IFormatID formatID );
 		static const IFormat& glEquivalent( GLenum format, GLenum type );
 
@@ -129,6 +160,18 @@ namespace cvt
 		return ( other.formatID != formatID );
 	}
 
+	inline bool IFormat::isPlanar() const
+	{
+		return formatID == IFORMAT_NV12_UINT8 || formatID == IFORMAT_I420_UINT8;
+	}
+
+	inline size_t IFormat::allocRows( size_t height ) const
+	{
+		if( isPlanar() )
+			return height + ( ( height + 1 ) >> 1 );
+		return height;
+	}
+
 	inline const IFormat & IFormat::uint8Equivalent( const IFormat & format )
 	{
 		switch ( format.formatID ) {
@@ -136,6 +179,7 @@ namespace cvt
 			case IFORMAT_GRAY_UINT16:
 			case IFORMAT_GRAY_INT16:
 			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_GRAY_FLOAT16:
 				return IFormat::GRAY_UINT8;
 			case IFORMAT_GRAYALPHA_UINT8:
 			case IFORMAT_GRAYALPHA_UINT16:
@@ -146,6 +190,7 @@ namespace cvt
 			case IFORMAT_RGBA_UINT16:
 			case IFORMAT_RGBA_INT16:
 			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_RGBA_FLOAT16:
 				return IFormat::RGBA_UINT8;
 			case IFORMAT_BGRA_UINT8:
 			case IFORMAT_BGRA_UINT16:
@@ -162,6 +207,16 @@ namespace cvt
 				return IFormat::YUYV_UINT8;
 			case IFORMAT_UYVY_UINT8:
 				return IFormat::UYVY_UINT8;
+			case IFORMAT_RGB_UINT8:
+				return IFormat::RGB_UINT8;
+			case IFORMAT_BGR_UINT8:
+				return IFormat::BGR_UINT8;
+			case IFORMAT_NV12_UINT8:
+				return IFormat::NV12_UINT8;
+			case IFORMAT_I420_UINT8:
+				return IFormat::I420_UINT8;
+			case IFORMAT_BAYER_BGGR_UINT8:
+				return IFormat::BAYER_BGGR_UINT8;
 			default:
 				throw CVTException( "NO UINT8 equivalent for requested FORMAT" );
 		}
@@ -174,6 +229,7 @@ namespace cvt
 			case IFORMAT_GRAY_UINT16:
 			case IFORMAT_GRAY_INT16:
 			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_GRAY_FLOAT16:
 				return IFormat::GRAY_UINT16;
 			case IFORMAT_GRAYALPHA_UINT8:
 			case IFORMAT_GRAYALPHA_UINT16:
@@ -184,6 +240,7 @@ namespace cvt
 			case IFORMAT_RGBA_UINT16:
 			case IFORMAT_RGBA_INT16:
 			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_RGBA_FLOAT16:
 				return IFormat::RGBA_UINT16;
 			case IFORMAT_BGRA_UINT8:
 			case IFORMAT_BGRA_UINT16:
@@ -203,6 +260,7 @@ namespace cvt
 			case IFORMAT_GRAY_UINT16:
 			case IFORMAT_GRAY_INT16:
 			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_GRAY_FLOAT16:
 				return IFormat::GRAY_INT16;
 			case IFORMAT_GRAYALPHA_UINT8:
 			case IFORMAT_GRAYALPHA_UINT16:
@@ -213,6 +271,7 @@ namespace cvt
 			case IFORMAT_RGBA_UINT16:
 			case IFORMAT_RGBA_INT16:
 			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_RGBA_FLOAT16:
 				return IFormat::RGBA_INT16;
 			case IFORMAT_BGRA_UINT8:
 			case IFORMAT_BGRA_UINT16:
@@ -232,6 +291,7 @@ namespace cvt
 			case IFORMAT_GRAY_UINT16:
 			case IFORMAT_GRAY_INT16:
 			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_GRAY_FLOAT16:
 				return IFormat::GRAY_FLOAT;
 			case IFORMAT_GRAYALPHA_UINT8:
 			case IFORMAT_GRAYALPHA_UINT16:
@@ -242,11 +302,14 @@ namespace cvt
 			case IFORMAT_RGBA_UINT16:
 			case IFORMAT_RGBA_INT16:
 			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_RGBA_FLOAT16:
+			case IFORMAT_RGB_UINT8:
 				return IFormat::RGBA_FLOAT;
 			case IFORMAT_BGRA_UINT8:
 			case IFORMAT_BGRA_UINT16:
 			case IFORMAT_BGRA_INT16:
 			case IFORMAT_BGRA_FLOAT:
+			case IFORMAT_BGR_UINT8:
 				return IFormat::BGRA_FLOAT;
 			default:
 				throw CVTException( "NO UINT8 equivalent for requested FORMAT" );
@@ -254,6 +317,27 @@ namespace cvt
 		}
 	}
 
+	inline const IFormat & IFormat::float16Equivalent( const IFormat & format )
+	{
+		switch ( format.formatID ) {
+			case IFORMAT_GRAY_UINT8:
+			case IFORMAT_GRAY_UINT16:
+			case IFORMAT_GRAY_INT16:
+			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_GRAY_FLOAT16:
+				return IFormat::GRAY_FLOAT16;
+			case IFORMAT_RGBA_UINT8:
+			case IFORMAT_RGBA_UINT16:
+			case IFORMAT_RGBA_INT16:
+			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_RGBA_FLOAT16:
+				return IFormat::RGBA_FLOAT16;
+			default:
+				throw CVTException( "NO FLOAT16 equivalent for requested FORMAT" );
+				break;
+		}
+	}
+
 
 	inline void IFormat::toGLFormatType( GLenum& glformat, GLenum& gltype ) const
 	{
@@ -281,9 +365,13 @@ namespace cvt
 			case IFORMAT_BAYER_RGGB_UINT8:	glformat = GL_RED; gltype = GL_UNSIGNED_BYTE; break;
             case IFORMAT_BAYER_GRBG_UINT8:	glformat = GL_RED; gltype = GL_UNSIGNED_BYTE; break;
             case IFORMAT_BAYER_GBRG_UINT8:	glformat = GL_RED; gltype = GL_UNSIGNED_BYTE; break;
+			case IFORMAT_BAYER_BGGR_UINT8:	glformat = GL_RED; gltype = GL_UNSIGNED_BYTE; break;
 
 			case IFORMAT_YUYV_UINT8:		glformat = GL_RG; gltype = GL_UNSIGNED_BYTE; break;
 			case IFORMAT_UYVY_UINT8:		glformat = GL_RG; gltype = GL_UNSIGNED_BYTE; break;
+
+			case IFORMAT_GRAY_FLOAT16:		glformat = GL_RED; gltype = GL_HALF_FLOAT; break;
+			case IFORMAT_RGBA_FLOAT16:		glformat = GL_RGBA; gltype = GL_HALF_FLOAT; break;
 			default:
 											throw CVTException( "No equivalent GL format found" );
 											break;
@@ -319,9 +407,13 @@ namespace cvt
 			case IFORMAT_BAYER_RGGB_UINT8:	clorder = CL_INTENSITY; cltype = CL_UNORM_INT8; break;
             case IFORMAT_BAYER_GRBG_UINT8:	clorder = CL_INTENSITY; cltype = CL_UNORM_INT8; break;
             case IFORMAT_BAYER_GBRG_UINT8:	clorder = CL_INTENSITY; cltype = CL_UNORM_INT8; break;
+			case IFORMAT_BAYER_BGGR_UINT8:	clorder = CL_INTENSITY; cltype = CL_UNORM_INT8; break;
 
 			case IFORMAT_YUYV_UINT8:		clorder = CL_RA; cltype = CL_UNORM_INT8; break;
 			case IFORMAT_UYVY_UINT8:		clorder = CL_RA; cltype = CL_UNORM_INT8; break;
+
+			case IFORMAT_GRAY_FLOAT16:		clorder = CL_INTENSITY; cltype = CL_HALF_FLOAT; break;
+			case IFORMAT_RGBA_FLOAT16:		clorder = CL_RGBA; cltype = CL_HALF_FLOAT; break;
 			default:
 				throw CVTException( "No equivalent CL format found" );
 				break;
@@ -339,6 +431,7 @@ namespace cvt
 					case GL_UNSIGNED_SHORT: return IFormat::GRAY_UINT16;
 					case GL_SHORT: return IFormat::GRAY_INT16;
 					case GL_FLOAT: return IFormat::GRAY_FLOAT;
+					case GL_HALF_FLOAT: return IFormat::GRAY_FLOAT16;
 					default:
 						throw CVTException("GL type unsupported");
 						break;
@@ -361,6 +454,7 @@ namespace cvt
 					case GL_UNSIGNED_SHORT: return IFormat::RGBA_UINT16;
 					case GL_SHORT: return IFormat::RGBA_INT16;
 					case GL_FLOAT: return IFormat::RGBA_FLOAT;
+					case GL_HALF_FLOAT: return IFormat::RGBA_FLOAT16;
 					default:
 						throw CVTException("GL type unsupported");
 						break;
@@ -428,6 +522,20 @@ namespace cvt
                 return IFormat::BAYER_GRBG_UINT8;
             case IFORMAT_BAYER_GBRG_UINT8:
                 return IFormat::BAYER_GBRG_UINT8;
+			case IFORMAT_GRAY_FLOAT16:
+				return IFormat::GRAY_FLOAT16;
+			case IFORMAT_RGBA_FLOAT16:
+				return IFormat::RGBA_FLOAT16;
+			case IFORMAT_RGB_UINT8:
+				return IFormat::RGB_UINT8;
+			case IFORMAT_BGR_UINT8:
+				return IFormat::BGR_UINT8;
+			case IFORMAT_NV12_UINT8:
+				return IFormat::NV12_UINT8;
+			case IFORMAT_I420_UINT8:
+				return IFormat::I420_UINT8;
+			case IFORMAT_BAYER_BGGR_UINT8:
+				return IFormat::BAYER_BGGR_UINT8;
 			default:
 				String msg;
 				msg.sprintf( "UNKNOWN INPUT FORMAT: %d", (int)formatID );
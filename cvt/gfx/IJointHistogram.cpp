@@ -0,0 +1,433 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/IJointHistogram.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/Exception.h>
+#include <string.h>
+
+namespace cvt {
+
+	/* fixed number of row bands with private histograms, independent of the number of threads */
+#define IJOINTHISTOGRAM_BANDS 16
+	/* pixels accumulated in the float histogram of a band before it is added to the double one */
+#define IJOINTHISTOGRAM_FLUSH 4096
+
+	/* histograms of a range of bands, every band fills its own histogram */
+	class IJointHistogram::HistogramBody
+	{
+		public:
+			HistogramBody( const IJointHistogram& jh, const Pass& pass, double* bandhist ) :
+				_jh( jh ), _pass( pass ), _bandhist( bandhist )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				for( size_t band = begin; band < end; band++ )
+					histogramBand( band );
+			}
+
+		private:
+			void histogramBand( size_t band ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t bins = _jh._bins;
+				const size_t w = _pass.roi.width;
+				const size_t bsize = bins * bins;
+				const size_t y0 = _pass.bandStart( band ), y1 = _pass.bandStart( band + 1 );
+				const size_t aoff = _pass.roi.x * ( _pass.au8 ? 1 : sizeof( float ) );
+				const size_t boff = _pass.roi.x * ( _pass.bu8 ? 1 : sizeof( float ) );
+				double* out = _bandhist + band * bsize;
+
+				ScopedBuffer<float, true> hist( bsize );
+				ScopedBuffer<int32_t, true> ia( w );
+				ScopedBuffer<int32_t, true> ib( w );
+				ScopedBuffer<float, true> wa( 4 * w );
+				ScopedBuffer<float, true> wb( 4 * w );
+				float* h = hist.ptr();
+				memset( h, 0, sizeof( float ) * bsize );
+
+				size_t pending = 0;
+				for( size_t y = y0; y < y1; y++ ) {
+					const uint8_t* arow = _pass.a + y * _pass.astride + aoff;
+					const uint8_t* brow = _pass.b + y * _pass.bstride + boff;
+
+					if( _jh._type == IHISTOGRAM_BSPLINE ) {
+						_jh.rowWeights( ia.ptr(), wa.ptr(), NULL, arow, _pass.au8, w );
+						_jh.rowWeights( ib.ptr(), wb.ptr(), NULL, brow, _pass.bu8, w );
+						simd->jointHistogramBSpline_f( h, bins, ia.ptr(), wa.ptr(), ib.ptr(), wb.ptr(), w );
+					} else {
+						_jh.rowBins( ia.ptr(), arow, _pass.au8, w );
+						_jh.rowBins( ib.ptr(), brow, _pass.bu8, w );
+						const int32_t* pa = ia.ptr();
+						const int32_t* pb = ib.ptr();
+						for( size_t x = 0; x < w; x++ )
+							h[ pa[ x ] * bins + pb[ x ] ] += 1.0f;
+					}
+
+					pending += w;
+					if( pending >= IJOINTHISTOGRAM_FLUSH || y + 1 == y1 ) {
+						for( size_t i = 0; i < bsize; i++ ) {
+							out[ i ] += h[ i ];
+							h[ i ] = 0.0f;
+						}
+						pending = 0;
+					}
+				}
+			}
+
+			const IJointHistogram&	_jh;
+			const Pass&				_pass;
+			double*					_bandhist;
+	};
+
+	/* unscaled mutual information gradient of a range of bands */
+	class IJointHistogram::GradientBody
+	{
+		public:
+			GradientBody( const IJointHistogram& jh, const Pass& pass, const double* logratio, double* bandgrad ) :
+				_jh( jh ), _pass( pass ), _logratio( logratio ), _bandgrad( bandgrad )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				for( size_t band = begin; band < end; band++ )
+					gradientBand( band );
+			}
+
+		private:
+			void gradientBand( size_t band ) const
+			{
+				const size_t bins = _jh._bins;
+				const size_t w = _pass.roi.width;
+				const size_t n = _pass.n;
+				const size_t y0 = _pass.bandStart( band ), y1 = _pass.bandStart( band + 1 );
+				const size_t aoff = _pass.roi.x * ( _pass.au8 ? 1 : sizeof( float ) );
+				const size_t boff = _pass.roi.x * ( _pass.bu8 ? 1 : sizeof( float ) );
+				double* g = _bandgrad + band * n;
+
+				ScopedBuffer<int32_t, true> ia( w );
+				ScopedBuffer<int32_t, true> ib( w );
+				ScopedBuffer<float, true> wa( 4 * w );
+				ScopedBuffer<float, true> wb( 4 * w );
+				ScopedBuffer<float, true> dwb( 4 * w );
+
+				const float* sd = _pass.sd + ( y0 - _pass.roi.y ) * w * n;
+				for( size_t y = y0; y < y1; y++ ) {
+					_jh.rowWeights( ia.ptr(), wa.ptr(), NULL, _pass.a + y * _pass.astride + aoff, _pass.au8, w );
+					_jh.rowWeights( ib.ptr(), wb.ptr(), dwb.ptr(), _pass.b + y * _pass.bstride + boff, _pass.bu8, w );
+
+					const float* pwa = wa.ptr();
+					const float* pdw = dwb.ptr();
+					for( size_t x = 0; x < w; x++ ) {
+						const double* l = _logratio + ia.ptr()[ x ] * bins + ib.ptr()[ x ];
+						double s = 0.0;
+						for( size_t k = 0; k < 4; k++ ) {
+							s += pwa[ k ] * ( pdw[ 0 ] * l[ 0 ] + pdw[ 1 ] * l[ 1 ] + pdw[ 2 ] * l[ 2 ] + pdw[ 3 ] * l[ 3 ] );
+							l += bins;
+						}
+						if( s != 0.0 ) {
+							for( size_t k = 0; k < n; k++ )
+								g[ k ] += s * sd[ k ];
+						}
+						sd += n;
+						pwa += 4;
+						pdw += 4;
+					}
+				}
+			}
+
+			const IJointHistogram&	_jh;
+			const Pass&				_pass;
+			const double*			_logratio;
+			double*					_bandgrad;
+	};
+
+	IJointHistogram::IJointHistogram( size_t bins, IHistogramType type ) :
+		_bins( bins ),
+		_type( type ),
+		_hist( bins * bins, 0.0 ),
+		_count( 0.0 ),
+		_u8idx( 256 )
+	{
+		if( _type == IHISTOGRAM_BSPLINE && _bins < 4 )
+			throw CVTException( "IJointHistogram: the B-spline histogram needs at least 4 bins!" );
+		if( _bins < 1 )
+			throw CVTException( "IJointHistogram: invalid number of bins!" );
+
+		SIMD* simd = SIMD::instance();
+		float values[ 256 ];
+		uint8_t u8[ 256 ];
+		for( size_t i = 0; i < 256; i++ )
+			u8[ i ] = ( uint8_t ) i;
+		simd->Conv_u8_to_f( values, u8, 256 );
+
+		if( _type == IHISTOGRAM_BSPLINE ) {
+			_u8weights.resize( 4 * 256 );
+			_u8dweights.resize( 4 * 256 );
+			simd->histogramBSplineWeights_f( &_u8idx[ 0 ], &_u8weights[ 0 ], &_u8dweights[ 0 ], values, 256, _bins );
+		} else {
+			rowBins( &_u8idx[ 0 ], ( const uint8_t* ) values, false, 256 );
+		}
+	}
+
+	IJointHistogram::~IJointHistogram()
+	{
+	}
+
+	void IJointHistogram::clear()
+	{
+		_hist.assign( _bins * _bins, 0.0 );
+		_count = 0.0;
+	}
+
+	void IJointHistogram::check( const Image& a, const Image& b ) const
+	{
+		if( ( a.format() != IFormat::GRAY_UINT8 && a.format() != IFormat::GRAY_FLOAT ) ||
+		    ( b.format() != IFormat::GRAY_UINT8 && b.format() != IFormat::GRAY_FLOAT ) )
+			throw CVTException( "IJointHistogram: only GRAY_UINT8 and GRAY_FLOAT images are supported!" );
+		if( a.width() != b.width() || a.height() != b.height() )
+			throw CVTException( "IJointHistogram: the images need to have the same size!" );
+	}
+
+	void IJointHistogram::update( const Image& a, const Image& b, const Recti* roi )
+	{
+		clear();
+		add( a, b, roi ? *roi : Recti( 0, 0, a.width(), a.height() ) );
+	}
+
+	void IJointHistogram::add( const Image& a, const Image& b, const Recti& roi )
+	{
+		accumulate( a, b, roi, 1.0 );
+	}
+
+	void IJointHistogram::remove( const Image& a, const Image& b, const Recti& roi )
+	{
+		accumulate( a, b, roi, -1.0 );
+	}
+
+	void IJointHistogram::rowWeights( int32_t* idx, float* w, float* dw, const uint8_t* row, bool u8, size_t n ) const
+	{
+		if( !u8 ) {
+			SIMD::instance()->histogramBSplineWeights_f( idx, w, dw, ( const float* ) row, n, _bins );
+			return;
+		}
+
+		for( size_t x = 0; x < n; x++ ) {
+			size_t v = row[ x ];
+			idx[ x ] = _u8idx[ v ];
+			memcpy( w + 4 * x, &_u8weights[ 4 * v ], sizeof( float ) * 4 );
+			if( dw )
+				memcpy( dw + 4 * x, &_u8dweights[ 4 * v ], sizeof( float ) * 4 );
+		}
+	}
+
+	void IJointHistogram::rowBins( int32_t* idx, const uint8_t* row, bool u8, size_t n ) const
+	{
+		if( u8 ) {
+			for( size_t x = 0; x < n; x++ )
+				idx[ x ] = _u8idx[ row[ x ] ];
+			return;
+		}
+
+		const float* src = ( const float* ) row;
+		const float scale = ( float ) ( _bins - 1 );
+		for( size_t x = 0; x < n; x++ ) {
+			float v = src[ x ];
+			v = v > 0.0f ? v : 0.0f;
+			v = v < 1.0f ? v : 1.0f;
+			idx[ x ] = ( int32_t ) ( v * scale + 0.5f );
+		}
+	}
+
+	void IJointHistogram::accumulate( const Image& a, const Image& b, const Recti& roi, double sign )
+	{
+		check( a, b );
+
+		Recti r( roi );
+		r.intersect( 0, 0, a.width(), a.height() );
+		if( r.width <= 0 || r.height <= 0 )
+			return;
+
+		const size_t bsize = _bins * _bins;
+		IMapScoped<const uint8_t> mapa( a );
+		IMapScoped<const uint8_t> mapb( b );
+		Pass pass;
+		pass.a = mapa.ptr();
+		pass.b = mapb.ptr();
+		pass.astride = mapa.stride();
+		pass.bstride = mapb.stride();
+		pass.au8 = a.format() == IFormat::GRAY_UINT8;
+		pass.bu8 = b.format() == IFormat::GRAY_UINT8;
+		pass.roi = r;
+		pass.bands = Math::min<size_t>( IJOINTHISTOGRAM_BANDS, r.height );
+		pass.sd = NULL;
+		pass.n = 0;
+		std::vector<double> bandhist( pass.bands * bsize, 0.0 );
+
+		ParallelFor::run( HistogramBody( *this, pass, &bandhist[ 0 ] ), 0, pass.bands );
+
+		/* merge the bands in order */
+		for( size_t i = 0; i < bsize; i++ ) {
+			double sum = 0.0;
+			for( size_t band = 0; band < pass.bands; band++ )
+				sum += bandhist[ band * bsize + i ];
+			_hist[ i ] += sign * sum;
+		}
+		_count += sign * ( double ) ( r.width * r.height );
+	}
+
+	double IJointHistogram::probability( size_t ia, size_t ib ) const
+	{
+		if( _count <= 0.0 )
+			return 0.0;
+		return Math::max( _hist[ ia * _bins + ib ], 0.0 ) / _count;
+	}
+
+	void IJointHistogram::marginals( std::vector<double>& pa, std::vector<double>& pb ) const
+	{
+		pa.assign( _bins, 0.0 );
+		pb.assign( _bins, 0.0 );
+		if( _count <= 0.0 )
+			return;
+
+		const double inv = 1.0 / _count;
+		for( size_t i = 0; i < _bins; i++ ) {
+			for( size_t j = 0; j < _bins; j++ ) {
+				double p = Math::max( _hist[ i * _bins + j ], 0.0 ) * inv;
+				pa[ i ] += p;
+				pb[ j ] += p;
+			}
+		}
+	}
+
+	static inline double entropy( const double* p, size_t n )
+	{
+		double h = 0.0;
+		for( size_t i = 0; i < n; i++ ) {
+			if( p[ i ] > 0.0 )
+				h -= p[ i ] * Math::log( p[ i ] );
+		}
+		return h;
+	}
+
+	void IJointHistogram::entropies( double& ha, double& hb, double& hab ) const
+	{
+		std::vector<double> pa, pb;
+		marginals( pa, pb );
+		ha = entropy( &pa[ 0 ], _bins );
+		hb = entropy( &pb[ 0 ], _bins );
+
+		hab = 0.0;
+		if( _count <= 0.0 )
+			return;
+		const double inv = 1.0 / _count;
+		for( size_t i = 0; i < _bins * _bins; i++ ) {
+			double p = _hist[ i ] * inv;
+			if( p > 0.0 )
+				hab -= p * Math::log( p );
+		}
+	}
+
+	double IJointHistogram::mutualInformation() const
+	{
+		double ha, hb, hab;
+		entropies( ha, hb, hab );
+		return ha + hb - hab;
+	}
+
+	double IJointHistogram::normalizedMutualInformation() const
+	{
+		double ha, hb, hab;
+		entropies( ha, hb, hab );
+		if( hab <= 0.0 )
+			return 2.0;
+		return ( ha + hb ) / hab;
+	}
+
+	void IJointHistogram::mutualInformationGradient( double* grad, size_t n, const Image& a, const Image& b, const float* sd, const Recti* roi ) const
+	{
+		if( _type != IHISTOGRAM_BSPLINE )
+			throw CVTException( "IJointHistogram: the mutual information gradient needs the B-spline histogram!" );
+		check( a, b );
+
+		Recti r( 0, 0, a.width(), a.height() );
+		if( roi ) {
+			if( !r.contains( *roi ) )
+				throw CVTException( "IJointHistogram: the region needs to be inside the images!" );
+			r = *roi;
+		}
+
+		for( size_t k = 0; k < n; k++ )
+			grad[ k ] = 0.0;
+		if( _count <= 0.0 || r.width <= 0 || r.height <= 0 )
+			return;
+
+		/* dMI / dp = sum_ij dp(i, j) / dp * log( p(i, j) / p_b(j) ), p_a is constant */
+		std::vector<double> pb( _bins, 0.0 );
+		for( size_t i = 0; i < _bins; i++ )
+			for( size_t j = 0; j < _bins; j++ )
+				pb[ j ] += Math::max( _hist[ i * _bins + j ], 0.0 );
+
+		std::vector<double> logratio( _bins * _bins );
+		for( size_t i = 0; i < _bins; i++ ) {
+			for( size_t j = 0; j < _bins; j++ ) {
+				double h = _hist[ i * _bins + j ];
+				logratio[ i * _bins + j ] = h > 0.0 ? Math::log( h / pb[ j ] ) : 0.0;
+			}
+		}
+
+		IMapScoped<const uint8_t> mapa( a );
+		IMapScoped<const uint8_t> mapb( b );
+		Pass pass;
+		pass.a = mapa.ptr();
+		pass.b = mapb.ptr();
+		pass.astride = mapa.stride();
+		pass.bstride = mapb.stride();
+		pass.au8 = a.format() == IFormat::GRAY_UINT8;
+		pass.bu8 = b.format() == IFormat::GRAY_UINT8;
+		pass.roi = r;
+		pass.bands = Math::min<size_t>( IJOINTHISTOGRAM_BANDS, r.height );
+		pass.sd = sd;
+		pass.n = n;
+		std::vector<double> bandgrad( pass.bands * n + 1, 0.0 );
+
+		ParallelFor::run( GradientBody( *this, pass, &logratio[ 0 ], &bandgrad[ 0 ] ), 0, pass.bands );
+
+		/* chain rule for the bin coordinate v * ( bins - 3 ) + 1 and the normalization of the histogram */
+		const double scale = ( double ) ( _bins - 3 ) / _count;
+		for( size_t band = 0; band < pass.bands; band++ )
+			for( size_t k = 0; k < n; k++ )
+				grad[ k ] += bandgrad[ band * n + k ];
+		for( size_t k = 0; k < n; k++ )
+			grad[ k ] *= scale;
+	}
+
+}
@@ -0,0 +1,122 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_IJOINTHISTOGRAM_H
+#define CVT_IJOINTHISTOGRAM_H
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IHistogram.h>
+#include <cvt/geom/Rect.h>
+#include <vector>
+
+namespace cvt {
+
+	/**
+	  @brief Joint histogram of two gray images and the mutual information derived from it.
+
+	  Values of GRAY_UINT8 ( normalized to [0, 1] ) or GRAY_FLOAT images in [0, 1] are binned with cubic B-spline
+	  Parzen windows or to the nearest bin. The rows are split into a fixed number of bands, every band fills its
+	  own histogram with SIMD row kernels and the bands are merged in order, so the result does not depend on the
+	  number of threads. The counts are kept unnormalized, add() and remove() update a moving region incrementally.
+
+	  For registration b is the warped moving image and a the fixed template: mutualInformationGradient() gives the
+	  analytic derivative of the MI with respect to the warp parameters from the steepest descent images
+	  db / dp ( image gradient times warp Jacobian, as used by ESM or the Homography tracker ).
+	 */
+	class IJointHistogram {
+		public:
+			IJointHistogram( size_t bins = 32, IHistogramType type = IHISTOGRAM_BSPLINE );
+			~IJointHistogram();
+
+			size_t			bins() const { return _bins; }
+			IHistogramType	type() const { return _type; }
+			void			clear();
+
+			/* replaces the histogram by the one of the pixels of a and b inside roi, the whole image if NULL */
+			void			update( const Image& a, const Image& b, const Recti* roi = NULL );
+			/* adds or removes the pixels inside roi ( clipped to the images ) */
+			void			add( const Image& a, const Image& b, const Recti& roi );
+			void			remove( const Image& a, const Image& b, const Recti& roi );
+
+			/* number of pixels in the histogram */
+			double			count() const { return _count; }
+			/* unnormalized joint count of bin ia of a and bin ib of b */
+			double			operator()( size_t ia, size_t ib ) const { return _hist[ ia * _bins + ib ]; }
+			double			probability( size_t ia, size_t ib ) const;
+			void			marginals( std::vector<double>& pa, std::vector<double>& pb ) const;
+
+			void			entropies( double& ha, double& hb, double& hab ) const;
+			double			mutualInformation() const;
+			/* ( H(a) + H(b) ) / H(a, b) in [1, 2] */
+			double			normalizedMutualInformation() const;
+
+			/**
+			  Derivative of the mutual information with respect to n warp parameters, only for IHISTOGRAM_BSPLINE.
+			  The histogram has to be the one of a, b and roi ( update( a, b, roi ) ), the fixed template a keeps its
+			  marginal. Only reads the histogram, so several threads may call it at once.
+			  @param sd		n derivatives d b( x ) / d p per pixel of roi in row-major order, in the normalized
+							units of the histogram ( values in [0, 1] )
+			  @param roi	region inside the images, the whole image if NULL
+			 */
+			void			mutualInformationGradient( double* grad, size_t n, const Image& a, const Image& b, const float* sd, const Recti* roi = NULL ) const;
+
+		private:
+			IJointHistogram( const IJointHistogram& );
+			IJointHistogram& operator=( const IJointHistogram& );
+
+			/* images and region of one histogram or gradient computation */
+			struct Pass {
+				const uint8_t*	a;
+				const uint8_t*	b;
+				size_t			astride, bstride;
+				bool			au8, bu8;
+				Recti			roi;
+				size_t			bands;
+				const float*	sd;
+				size_t			n;
+
+				size_t			bandStart( size_t band ) const { return roi.y + ( band * roi.height ) / bands; }
+			};
+			class HistogramBody;
+			class GradientBody;
+
+			void			check( const Image& a, const Image& b ) const;
+			void			accumulate( const Image& a, const Image& b, const Recti& roi, double sign );
+			void			rowWeights( int32_t* idx, float* w, float* dw, const uint8_t* row, bool u8, size_t n ) const;
+			void			rowBins( int32_t* idx, const uint8_t* row, bool u8, size_t n ) const;
+
+			size_t							_bins;
+			IHistogramType					_type;
+			std::vector<double>				_hist;
+			double							_count;
+
+			/* B-spline bins, weights and derivatives of the 256 UINT8 values */
+			std::vector<int32_t>			_u8idx;
+			std::vector<float>				_u8weights, _u8dweights;
+	};
+
+}
+
+#endif
@@ -0,0 +1,294 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/IJointHistogram.h>
+#include <cvt/gfx/IMI.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/math/Math.h>
+
+#include <vector>
+
+namespace cvt {
+
+	static bool _jhKernels()
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+		bool ret = true;
+
+		for( size_t n = 1; n < 37; n++ ) {
+			std::vector<float> src( n );
+			for( size_t i = 0; i < n; i++ )
+				src[ i ] = i % 7 ? Math::rand( -0.1f, 1.1f ) : ( float ) ( i % 2 );
+			std::vector<int32_t> idx1( n ), idx2( n );
+			std::vector<float> w1( 4 * n ), w2( 4 * n ), dw1( 4 * n ), dw2( 4 * n );
+			base->histogramBSplineWeights_f( &idx1[ 0 ], &w1[ 0 ], &dw1[ 0 ], &src[ 0 ], n, 16 );
+			best->histogramBSplineWeights_f( &idx2[ 0 ], &w2[ 0 ], &dw2[ 0 ], &src[ 0 ], n, 16 );
+			ret &= idx1 == idx2 && w1 == w2 && dw1 == dw2;
+
+			for( size_t i = 0; i < n; i++ ) {
+				ret &= idx1[ i ] >= 0 && idx1[ i ] <= 12;
+				ret &= Math::abs( w1[ 4 * i ] + w1[ 4 * i + 1 ] + w1[ 4 * i + 2 ] + w1[ 4 * i + 3 ] - 1.0f ) < 1e-5f;
+				ret &= Math::abs( dw1[ 4 * i ] + dw1[ 4 * i + 1 ] + dw1[ 4 * i + 2 ] + dw1[ 4 * i + 3 ] ) < 1e-5f;
+			}
+
+			std::vector<float> h1( 16 * 16, 0.0f ), h2;
+			std::vector<int32_t> ib( idx1.rbegin(), idx1.rend() );
+			std::vector<float> wb( w1.rbegin(), w1.rend() );
+			for( size_t i = 0; i < n; i++ )
+				std::swap( wb[ 4 * i ], wb[ 4 * i + 3 ] ), std::swap( wb[ 4 * i + 1 ], wb[ 4 * i + 2 ] );
+			h2 = h1;
+			base->jointHistogramBSpline_f( &h1[ 0 ], 16, &idx1[ 0 ], &w1[ 0 ], &ib[ 0 ], &wb[ 0 ], n );
+			best->jointHistogramBSpline_f( &h2[ 0 ], 16, &idx1[ 0 ], &w1[ 0 ], &ib[ 0 ], &wb[ 0 ], n );
+			ret &= h1 == h2;
+		}
+
+		delete base;
+		delete best;
+		return ret;
+	}
+
+	/* smooth test pattern in [0.1, 0.9] shifted by ( tx, ty ), optionally with the x and y derivatives */
+	static void _jhPattern( Image& img, size_t w, size_t h, float tx, float ty, std::vector<float>* sd = NULL )
+	{
+		img.reallocate( w, h, IFormat::GRAY_FLOAT );
+		if( sd )
+			sd->resize( 2 * w * h );
+		IMapScoped<float> map( img );
+		for( size_t y = 0; y < h; y++ ) {
+			float* p = map.ptr();
+			for( size_t x = 0; x < w; x++ ) {
+				float u = ( ( float ) x + tx ) * 0.09f, v = ( ( float ) y + ty ) * 0.07f;
+				p[ x ] = 0.5f + 0.25f * Math::sin( u ) + 0.15f * Math::cos( v + 0.5f * u );
+				if( sd ) {
+					( *sd )[ 2 * ( y * w + x ) ] = 0.09f * ( 0.25f * Math::cos( u ) - 0.075f * Math::sin( v + 0.5f * u ) );
+					( *sd )[ 2 * ( y * w + x ) + 1 ] = -0.07f * 0.15f * Math::sin( v + 0.5f * u );
+				}
+			}
+			map++;
+		}
+	}
+
+	static bool _jhEqual( const IJointHistogram& h1, const IJointHistogram& h2, double eps )
+	{
+		bool ret = h1.count() == h2.count();
+		for( size_t i = 0; i < h1.bins(); i++ )
+			for( size_t j = 0; j < h1.bins(); j++ )
+				ret &= Math::abs( h1( i, j ) - h2( i, j ) ) <= eps;
+		return ret;
+	}
+
+	/* count and bins of the histogram of a region */
+	struct JHUpdate {
+		JHUpdate( const Image& ia, const Image& ib, const Recti& r ) : a( ia ), b( ib ), roi( r ) {}
+		void operator()( std::vector<double>& counts ) const
+		{
+			IJointHistogram h( 32 );
+			h.update( a, b, &roi );
+			counts.push_back( h.count() );
+			for( size_t i = 0; i < h.bins(); i++ )
+				for( size_t j = 0; j < h.bins(); j++ )
+					counts.push_back( h( i, j ) );
+		}
+		const Image& a;
+		const Image& b;
+		Recti roi;
+	};
+
+	/* concurrent gradient calls on one histogram, call i writes the gradient to out[ 2 * i ] */
+	struct JHGradient {
+		JHGradient( const IJointHistogram& jh, const Image& ia, const Image& ib, const float* s, const Recti& r, double* o ) :
+			h( jh ), a( ia ), b( ib ), sd( s ), roi( r ), out( o ) {}
+		void operator()( size_t i ) const { h.mutualInformationGradient( out + 2 * i, 2, a, b, sd, &roi ); }
+		const IJointHistogram& h;
+		const Image& a;
+		const Image& b;
+		const float* sd;
+		Recti roi;
+		double* out;
+	};
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( IJointHistogram )
+	bool result = true;
+	bool b;
+
+	b = _jhKernels();
+	CVTTEST_PRINT( "SIMD B-spline binning", b );
+	result &= b;
+
+	Image u8a( 97, 61, IFormat::GRAY_UINT8 ), u8b( 97, 61, IFormat::GRAY_UINT8 );
+	{
+		IMapScoped<uint8_t> ma( u8a );
+		IMapScoped<uint8_t> mb( u8b );
+		for( size_t y = 0; y < u8a.height(); y++ ) {
+			for( size_t x = 0; x < u8a.width(); x++ ) {
+				ma.ptr()[ x ] = ( uint8_t ) ( ( x * 3 + y * 5 ) & 0xff );
+				mb.ptr()[ x ] = ( uint8_t ) Math::rand( 0, 256 );
+			}
+			ma++;
+			mb++;
+		}
+	}
+	Image fa( u8a.width(), u8a.height(), IFormat::GRAY_FLOAT ), fb( u8a.width(), u8a.height(), IFormat::GRAY_FLOAT );
+	{
+		SIMD* simd = SIMD::instance();
+		IMapScoped<const uint8_t> ma( u8a );
+		IMapScoped<const uint8_t> mb( u8b );
+		IMapScoped<float> mfa( fa );
+		IMapScoped<float> mfb( fb );
+		for( size_t y = 0; y < u8a.height(); y++ ) {
+			simd->Conv_u8_to_f( mfa.ptr(), ma.ptr(), u8a.width() );
+			simd->Conv_u8_to_f( mfb.ptr(), mb.ptr(), u8a.width() );
+			ma++; mb++; mfa++; mfb++;
+		}
+	}
+
+	/* UINT8 and FLOAT inputs give the same histogram, the B-spline weights sum to one */
+	for( int t = 0; t < 2; t++ ) {
+		IHistogramType type = t ? IHISTOGRAM_NOINTERP : IHISTOGRAM_BSPLINE;
+		IJointHistogram h1( 24, type ), h2( 24, type );
+		h1.update( u8a, u8b );
+		h2.update( fa, u8b );
+		b = _jhEqual( h1, h2, 0.0 ) && h1.count() == 97 * 61;
+		h2.update( fa, fb );
+		b &= _jhEqual( h1, h2, 0.0 );
+		double sum = 0.0;
+		for( size_t i = 0; i < 24; i++ )
+			for( size_t j = 0; j < 24; j++ )
+				sum += h1( i, j );
+		b &= Math::abs( sum - h1.count() ) < 1e-3;
+		if( t )
+			CVTTEST_PRINT( "UINT8 and FLOAT nearest bins", b );
+		else
+			CVTTEST_PRINT( "UINT8 and FLOAT B-spline", b );
+		result &= b;
+	}
+
+	/* the bands do not depend on the number of threads */
+	{
+		Recti roi( 5, 3, 80, 50 );
+		IJointHistogram h( 32 );
+		h.update( fa, u8b, &roi );
+		b = h.count() == 80 * 50;
+		b &= testThreadInvariance<std::vector<double> >( JHUpdate( fa, u8b, roi ), testEqual<std::vector<double> > );
+		CVTTEST_PRINT( "thread count", b );
+		result &= b;
+	}
+
+	/* moving the region by adding and removing strips */
+	{
+		IJointHistogram h1( 32 ), h2( 32 );
+		Recti roi( 10, 10, 40, 30 ), moved( 13, 12, 40, 30 );
+		h1.update( u8a, fb, &roi );
+		h1.add( u8a, fb, Recti( 50, 12, 3, 30 ) );
+		h1.add( u8a, fb, Recti( 13, 40, 37, 2 ) );
+		h1.remove( u8a, fb, Recti( 10, 10, 3, 30 ) );
+		h1.remove( u8a, fb, Recti( 13, 10, 37, 2 ) );
+		h2.update( u8a, fb, &moved );
+		b = _jhEqual( h1, h2, 1e-6 );
+		/* regions are clipped to the image */
+		h2.add( u8a, fb, Recti( 90, -5, 20, 10 ) );
+		b &= h2.count() == 40 * 30 + 7 * 5;
+		CVTTEST_PRINT( "incremental region updates", b );
+		result &= b;
+	}
+
+	/* mutual information of dependent and independent images */
+	{
+		IJointHistogram h( 32 );
+		h.update( fa, fa );
+		double ha, hb, hab;
+		h.entropies( ha, hb, hab );
+		double miself = h.mutualInformation();
+		b = Math::abs( ha - hb ) < 1e-9 && Math::abs( miself - ha ) < 0.5 * ha && h.normalizedMutualInformation() > 1.4;
+		h.update( fa, fb );
+		b &= h.mutualInformation() < 0.25 * miself && h.normalizedMutualInformation() < 1.1;
+
+		IMIf mi( 32 );
+		mi.update( fa, fa );
+		b &= Math::abs( mi() - ( float ) miself ) < 1e-5f && mi.size() == 32;
+		CVTTEST_PRINT( "mutual information", b );
+		result &= b;
+	}
+
+	/* analytic gradient for a translation against central differences */
+	{
+		Image a, bimg;
+		std::vector<float> sd;
+		_jhPattern( a, 120, 90, 0.0f, 0.0f );
+		const float tx = 1.3f, ty = -0.8f, delta = 0.05f;
+		Recti roi( 4, 4, 110, 80 );
+
+		/* steepest descent images of the region */
+		_jhPattern( bimg, 120, 90, tx, ty, &sd );
+		std::vector<float> sdroi;
+		for( int y = roi.y; y < roi.y + roi.height; y++ )
+			sdroi.insert( sdroi.end(), &sd[ 2 * ( y * 120 + roi.x ) ], &sd[ 2 * ( y * 120 + roi.x + roi.width ) ] );
+
+		IJointHistogram h( 24 );
+		h.update( a, bimg, &roi );
+		double grad[ 2 ];
+		h.mutualInformationGradient( grad, 2, a, bimg, &sdroi[ 0 ], &roi );
+
+		/* the gradient only reads the histogram, concurrent calls give the same result */
+		std::vector<double> grads( 16 );
+		size_t threads = ParallelFor::numThreads();
+		ParallelFor::setNumThreads( 4 );
+		ParallelFor::run( ParallelFor::each( JHGradient( h, a, bimg, &sdroi[ 0 ], roi, &grads[ 0 ] ) ), 0, 8 );
+		ParallelFor::setNumThreads( threads );
+		bool concurrent = true;
+		for( size_t i = 0; i < 8; i++ )
+			concurrent &= grads[ 2 * i ] == grad[ 0 ] && grads[ 2 * i + 1 ] == grad[ 1 ];
+		CVTTEST_PRINT( "concurrent mutual information gradient", concurrent );
+		result &= concurrent;
+
+		double num[ 2 ];
+		for( int k = 0; k < 2; k++ ) {
+			_jhPattern( bimg, 120, 90, tx + ( k ? 0 : delta ), ty + ( k ? delta : 0 ) );
+			h.update( a, bimg, &roi );
+			double mip = h.mutualInformation();
+			_jhPattern( bimg, 120, 90, tx - ( k ? 0 : delta ), ty - ( k ? delta : 0 ) );
+			h.update( a, bimg, &roi );
+			double mim = h.mutualInformation();
+			num[ k ] = ( mip - mim ) / ( 2.0 * delta );
+		}
+		b = Math::abs( grad[ 0 ] - num[ 0 ] ) < 0.05 * Math::abs( num[ 0 ] ) + 1e-4 &&
+			Math::abs( grad[ 1 ] - num[ 1 ] ) < 0.05 * Math::abs( num[ 1 ] ) + 1e-4 &&
+			Math::abs( num[ 0 ] ) > 1e-3;
+		CVTTEST_PRINT( "mutual information gradient", b );
+		result &= b;
+	}
+
+	return result;
+END_CVTTEST
@@ -0,0 +1,434 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ILabeling.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/Exception.h>
+
+namespace cvt {
+
+	/* rows of one strip, fixed so that the provisional labels do not depend on the number of threads */
+#define ILABELING_STRIP 64
+
+	struct ILabelAccum {
+		ILabelAccum() : area( 0 ), x0( 0 ), y0( 0 ), x1( 0 ), y1( 0 ), sx( 0 ), sy( 0 ), sxx( 0 ), sxy( 0 ), syy( 0 ) {}
+
+		void add( int x, int y )
+		{
+			if( !area ) {
+				x0 = x1 = x;
+				y0 = y1 = y;
+			} else {
+				x0 = Math::min( x0, x );
+				x1 = Math::max( x1, x );
+				y1 = y;
+			}
+			area++;
+			sx += x;
+			sy += y;
+			sxx += ( double ) x * x;
+			sxy += ( double ) x * y;
+			syy += ( double ) y * y;
+		}
+
+		void add( const ILabelAccum& other )
+		{
+			if( !other.area )
+				return;
+			if( !area ) {
+				*this = other;
+				return;
+			}
+			area += other.area;
+			x0 = Math::min( x0, other.x0 );
+			y0 = Math::min( y0, other.y0 );
+			x1 = Math::max( x1, other.x1 );
+			y1 = Math::max( y1, other.y1 );
+			sx += other.sx;
+			sy += other.sy;
+			sxx += other.sxx;
+			sxy += other.sxy;
+			syy += other.syy;
+		}
+
+		size_t	area;
+		int		x0, y0, x1, y1;
+		double	sx, sy, sxx, sxy, syy;
+	};
+
+	struct ILabelStrip {
+		size_t						y0, y1;
+		uint32_t					base;	/* global index of the first provisional label */
+		std::vector<uint32_t>		parent;
+		std::vector<ILabelAccum>	stats;
+	};
+
+	static inline uint32_t _ilabelFind( uint32_t* parent, uint32_t l )
+	{
+		while( parent[ l ] != l ) {
+			parent[ l ] = parent[ parent[ l ] ];
+			l = parent[ l ];
+		}
+		return l;
+	}
+
+	/* the smaller label becomes the root, so roots are the first labels in raster order */
+	static inline void _ilabelUnion( uint32_t* parent, uint32_t a, uint32_t b )
+	{
+		a = _ilabelFind( parent, a );
+		b = _ilabelFind( parent, b );
+		if( a < b )
+			parent[ b ] = a;
+		else if( b < a )
+			parent[ a ] = b;
+	}
+
+	/* provisional labels and statistics of a range of strips, every strip only writes its own rows */
+	class ILabeling::StripBody
+	{
+		public:
+			StripBody( const ILabeling& labeling, uint32_t* labels, ILabelStrip* strips,
+					   const uint8_t* base, size_t stride, bool u8, bool nonzero, float threshold ) :
+				_labeling( labeling ), _labels( labels ), _strips( strips ), _base( base ),
+				_stride( stride ), _u8( u8 ), _nonzero( nonzero ), _threshold( threshold )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				for( size_t i = begin; i < end; i++ )
+					labelStrip( _strips[ i ] );
+			}
+
+		private:
+			void labelStrip( ILabelStrip& strip ) const
+			{
+				const int w = _labeling._width;
+				const bool eight = _labeling._connectivity == ILABEL_8;
+				const uint8_t ut = _nonzero ? 0 : ( uint8_t ) Math::clamp( _threshold * 255.0f, 0.0f, 255.0f );
+				std::vector<uint32_t>& parent = strip.parent;
+				parent.clear();
+				strip.stats.clear();
+
+				for( size_t y = strip.y0; y < strip.y1; y++ ) {
+					const uint8_t* src = _base + y * _stride;
+					uint32_t* lab = _labels + y * w;
+					const uint32_t* prev = y > strip.y0 ? lab - w : NULL;
+
+					for( int x = 0; x < w; x++ ) {
+						bool fg;
+						if( _u8 )
+							fg = src[ x ] > ut;
+						else if( _nonzero )
+							fg = ( ( const float* ) src )[ x ] != 0.0f;
+						else
+							fg = ( ( const float* ) src )[ x ] > _threshold;
+						if( !fg ) {
+							lab[ x ] = 0;
+							continue;
+						}
+
+						/* provisional labels are local label + 1 */
+						uint32_t l = x > 0 ? lab[ x - 1 ] : 0;
+						if( prev ) {
+							uint32_t n[ 3 ];
+							n[ 0 ] = prev[ x ];
+							n[ 1 ] = ( eight && x > 0 ) ? prev[ x - 1 ] : 0;
+							n[ 2 ] = ( eight && x + 1 < w ) ? prev[ x + 1 ] : 0;
+							for( int k = 0; k < 3; k++ ) {
+								if( !n[ k ] )
+									continue;
+								if( !l )
+									l = n[ k ];
+								else if( l != n[ k ] )
+									_ilabelUnion( &parent[ 0 ], l - 1, n[ k ] - 1 );
+							}
+						}
+
+						if( !l ) {
+							parent.push_back( parent.size() );
+							strip.stats.push_back( ILabelAccum() );
+							l = parent.size();
+						}
+						lab[ x ] = l;
+						strip.stats[ l - 1 ].add( x, y );
+					}
+				}
+			}
+
+			const ILabeling&	_labeling;
+			uint32_t*			_labels;
+			ILabelStrip*		_strips;
+			const uint8_t*		_base;
+			size_t				_stride;
+			bool				_u8;
+			bool				_nonzero;
+			float				_threshold;
+	};
+
+	/* replaces the provisional labels of a range of strips by the final ones */
+	class ILabeling::RelabelBody
+	{
+		public:
+			RelabelBody( const ILabeling& labeling, uint32_t* labels, const ILabelStrip* strips ) :
+				_labeling( labeling ), _labels( labels ), _strips( strips )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				const size_t w = _labeling._width;
+				for( size_t i = begin; i < end; i++ ) {
+					const ILabelStrip& strip = _strips[ i ];
+					const uint32_t* ids = &_labeling._ids[ strip.base ];
+					for( uint32_t* lab = _labels + strip.y0 * w, *lend = _labels + strip.y1 * w; lab != lend; lab++ ) {
+						if( *lab )
+							*lab = ids[ *lab - 1 ] + 1;
+					}
+				}
+			}
+
+		private:
+			const ILabeling&	_labeling;
+			uint32_t*			_labels;
+			const ILabelStrip*	_strips;
+	};
+
+	/* traces the outer boundary of a range of components */
+	class ILabeling::ContourBody
+	{
+		public:
+			ContourBody( const ILabeling& labeling, ILabelComponent* components ) :
+				_labeling( labeling ), _components( components )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				for( size_t i = begin; i < end; i++ )
+					traceContour( i );
+			}
+
+		private:
+			void traceContour( size_t i ) const
+			{
+				/* clockwise neighbours ( y pointing down ), starting east */
+				static const int dirs[ 8 ][ 2 ] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+				static const int index[ 3 ][ 3 ] = { { 5, 6, 7 }, { 4, -1, 0 }, { 3, 2, 1 } };
+				const bool eight = _labeling._connectivity == ILABEL_8;
+				const uint32_t id = i + 1;
+				const int w = _labeling._width, h = _labeling._height;
+				const uint32_t* labels = &_labeling._labels[ 0 ];
+
+				ILabelComponent& c = _components[ i ];
+				std::vector<Vector2i>& contour = c.contour;
+
+				/* the first pixel in raster order is on the boundary, its west neighbour is outside */
+				int y = c.bounds.y;
+				int x = c.bounds.x;
+				while( labels[ y * w + x ] != id )
+					x++;
+
+				Vector2i p0( x, y ), p( x, y ), p1( x, y );
+				int back = 4;
+				contour.push_back( p0 );
+
+				/* Moore neighbour tracing, 4-connected components only step along the axes */
+				size_t maxsteps = 4 * c.area + 4;
+				while( maxsteps-- ) {
+					int found = -1;
+					for( int k = 1; k <= 8; k++ ) {
+						int d = ( back + k ) & 7;
+						if( !eight && ( d & 1 ) )
+							continue;
+						int nx = p.x + dirs[ d ][ 0 ];
+						int ny = p.y + dirs[ d ][ 1 ];
+						if( nx >= 0 && nx < w && ny >= 0 && ny < h && labels[ ny * w + nx ] == id ) {
+							found = d;
+							break;
+						}
+					}
+					if( found < 0 )
+						break;
+
+					Vector2i q( p.x + dirs[ found ][ 0 ], p.y + dirs[ found ][ 1 ] );
+					if( p.x == p0.x && p.y == p0.y && contour.size() > 1 && q.x == p1.x && q.y == p1.y ) {
+						contour.pop_back();
+						break;
+					}
+					if( contour.size() == 1 )
+						p1 = q;
+
+					/* the neighbour examined before q is the new backtrack position */
+					int pd = eight ? ( ( found + 7 ) & 7 ) : ( ( found + 6 ) & 7 );
+					int bx = p.x + dirs[ pd ][ 0 ] - q.x;
+					int by = p.y + dirs[ pd ][ 1 ] - q.y;
+					back = index[ by + 1 ][ bx + 1 ];
+					if( back < 0 )
+						back = ( found + 4 ) & 7;
+					p = q;
+					contour.push_back( p );
+				}
+			}
+
+			const ILabeling&	_labeling;
+			ILabelComponent*	_components;
+	};
+
+
+	ILabeling::ILabeling( ILabelConnectivity connectivity ) :
+		_connectivity( connectivity ),
+		_width( 0 ),
+		_height( 0 )
+	{
+	}
+
+	ILabeling::~ILabeling()
+	{
+	}
+
+	void ILabeling::label( const Image& img, float threshold, bool contours )
+	{
+		labelPixels( img, false, threshold, contours );
+	}
+
+	void ILabeling::labelNonZero( const Image& img, bool contours )
+	{
+		labelPixels( img, true, 0.0f, contours );
+	}
+
+	void ILabeling::labelPixels( const Image& img, bool nonzero, float threshold, bool contours )
+	{
+		bool u8 = img.format() == IFormat::GRAY_UINT8;
+		if( !u8 && img.format() != IFormat::GRAY_FLOAT )
+			throw CVTException( "Unsupported image format!" );
+
+		_width = img.width();
+		_height = img.height();
+		_labels.resize( _width * _height );
+		_components.clear();
+		if( !_width || !_height )
+			return;
+
+		/* provisional labels for every strip */
+		std::vector<ILabelStrip> strips( ( _height + ILABELING_STRIP - 1 ) / ILABELING_STRIP );
+		for( size_t i = 0; i < strips.size(); i++ ) {
+			strips[ i ].y0 = i * ILABELING_STRIP;
+			strips[ i ].y1 = Math::min( _height, ( i + 1 ) * ILABELING_STRIP );
+		}
+		{
+			IMapScoped<const uint8_t> map( img );
+			StripBody body( *this, &_labels[ 0 ], &strips[ 0 ], map.ptr(), map.stride(), u8, nonzero, threshold );
+			ParallelFor::run( body, 0, strips.size() );
+		}
+
+		/* global union-find over all provisional labels */
+		uint32_t count = 0;
+		for( size_t i = 0; i < strips.size(); i++ ) {
+			strips[ i ].base = count;
+			count += strips[ i ].parent.size();
+		}
+		std::vector<uint32_t> parent( count + 1 );
+		for( size_t i = 0; i < strips.size(); i++ ) {
+			for( size_t k = 0; k < strips[ i ].parent.size(); k++ )
+				parent[ strips[ i ].base + k ] = strips[ i ].base + strips[ i ].parent[ k ];
+		}
+
+		/* merge along the strip borders */
+		for( size_t i = 1; i < strips.size(); i++ ) {
+			const uint32_t* lab = &_labels[ strips[ i ].y0 * _width ];
+			const uint32_t* prev = lab - _width;
+			const uint32_t b = strips[ i ].base - 1;
+			const uint32_t pb = strips[ i - 1 ].base - 1;
+			for( size_t x = 0; x < _width; x++ ) {
+				if( !lab[ x ] )
+					continue;
+				if( prev[ x ] )
+					_ilabelUnion( &parent[ 0 ], b + lab[ x ], pb + prev[ x ] );
+				if( _connectivity == ILABEL_8 ) {
+					if( x > 0 && prev[ x - 1 ] )
+						_ilabelUnion( &parent[ 0 ], b + lab[ x ], pb + prev[ x - 1 ] );
+					if( x + 1 < _width && prev[ x + 1 ] )
+						_ilabelUnion( &parent[ 0 ], b + lab[ x ], pb + prev[ x + 1 ] );
+				}
+			}
+		}
+
+		/* consecutive ids, parents always have smaller labels than their children */
+		_ids.resize( count + 1 );
+		size_t n = 0;
+		for( uint32_t l = 0; l < count; l++ ) {
+			if( parent[ l ] == l )
+				_ids[ l ] = n++;
+			else
+				_ids[ l ] = _ids[ parent[ l ] ];
+		}
+
+		std::vector<ILabelAccum> stats( n );
+		for( size_t i = 0; i < strips.size(); i++ ) {
+			for( size_t k = 0; k < strips[ i ].stats.size(); k++ )
+				stats[ _ids[ strips[ i ].base + k ] ].add( strips[ i ].stats[ k ] );
+		}
+
+		RelabelBody relabel( *this, &_labels[ 0 ], &strips[ 0 ] );
+		ParallelFor::run( relabel, 0, strips.size() );
+
+		_components.resize( n );
+		for( size_t i = 0; i < n; i++ ) {
+			const ILabelAccum& s = stats[ i ];
+			ILabelComponent& c = _components[ i ];
+			double inva = 1.0 / ( double ) s.area;
+			double cx = s.sx * inva;
+			double cy = s.sy * inva;
+			c.area = s.area;
+			c.bounds.set( s.x0, s.y0, s.x1 - s.x0 + 1, s.y1 - s.y0 + 1 );
+			c.centroid.x = cx;
+			c.centroid.y = cy;
+			c.mu20 = s.sxx * inva - cx * cx;
+			c.mu11 = s.sxy * inva - cx * cy;
+			c.mu02 = s.syy * inva - cy * cy;
+			c.contour.clear();
+		}
+
+		if( contours && n ) {
+			ContourBody trace( *this, &_components[ 0 ] );
+			ParallelFor::run( trace, 0, n, 16 );
+		}
+	}
+
+	void ILabeling::labelImage( Image& dst ) const
+	{
+		dst.reallocate( _width, _height, IFormat::GRAY_FLOAT );
+		IMapScoped<float> map( dst );
+		for( size_t y = 0; y < _height; y++ ) {
+			float* ptr = map.ptr();
+			for( size_t x = 0; x < _width; x++ )
+				ptr[ x ] = ( float ) _labels[ y * _width + x ];
+			map++;
+		}
+	}
+}
@@ -0,0 +1,108 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_ILABELING_H
+#define CVT_ILABELING_H
+
+#include <cvt/geom/Rect.h>
+#include <cvt/math/Vector.h>
+#include <vector>
+
+namespace cvt {
+	class Image;
+
+	enum ILabelConnectivity {
+		ILABEL_4 = 4,
+		ILABEL_8 = 8
+	};
+
+	struct ILabelComponent {
+		size_t					area;
+		Recti					bounds;
+		Vector2f				centroid;
+		/* central second order moments divided by the area ( the covariance of the pixel positions ) */
+		float					mu20, mu11, mu02;
+		/* outer boundary in clockwise order, only filled if requested */
+		std::vector<Vector2i>	contour;
+	};
+
+	/**
+	  @brief Connected component labeling with per component statistics.
+
+	  Two pass union-find labeling on strips of rows in parallel, the equivalences across the strips
+	  are merged afterwards. Components are numbered from 1 in raster order of their first pixel,
+	  background pixels get the label 0.
+	 */
+	class ILabeling {
+		public:
+			ILabeling( ILabelConnectivity connectivity = ILABEL_8 );
+			~ILabeling();
+
+			/**
+			  Labels the pixels of a GRAY_UINT8 or GRAY_FLOAT image with a value greater than threshold
+			  ( uint8 values are compared to threshold * 255 ), so masks work with the default threshold.
+			  @param contours	trace the outer boundary of every component
+			 */
+			void						label( const Image& img, float threshold = 0.0f, bool contours = false );
+
+			/**
+			  Labels the pixels of a GRAY_UINT8 or GRAY_FLOAT image with a value different from zero,
+			  negative float values are foreground as well.
+			 */
+			void						labelNonZero( const Image& img, bool contours = false );
+
+			size_t						width() const { return _width; }
+			size_t						height() const { return _height; }
+
+			size_t						size() const { return _components.size(); }
+			const ILabelComponent&		operator[]( size_t i ) const { return _components[ i ]; }
+			const std::vector<ILabelComponent>& components() const { return _components; }
+
+			/* label of a pixel, 0 for background, i + 1 for component i */
+			uint32_t					labelAt( size_t x, size_t y ) const { return _labels[ y * _width + x ]; }
+			const uint32_t*				labels() const { return _labels.empty() ? NULL : &_labels[ 0 ]; }
+
+			/* label image as GRAY_FLOAT */
+			void						labelImage( Image& dst ) const;
+
+		private:
+			class StripBody;
+			class RelabelBody;
+			class ContourBody;
+
+			ILabeling( const ILabeling& );
+			ILabeling& operator=( const ILabeling& );
+
+			void							labelPixels( const Image& img, bool nonzero, float threshold, bool contours );
+
+			ILabelConnectivity				_connectivity;
+			size_t							_width, _height;
+			std::vector<uint32_t>			_labels;
+			std::vector<uint32_t>			_ids;
+			std::vector<ILabelComponent>	_components;
+	};
+}
+
+#endif
@@ -0,0 +1,229 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ILabeling.h>
+#include <cvt/gfx/IComponents.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+#include <vector>
+
+namespace cvt {
+
+	/* flood fill labeling in raster order of the first pixel */
+	static size_t _ilReference( std::vector<uint32_t>& lab, const std::vector<bool>& mask, int w, int h, bool eight )
+	{
+		lab.assign( w * h, 0 );
+		std::vector<int> stack;
+		uint32_t n = 0;
+		for( int i = 0; i < w * h; i++ ) {
+			if( !mask[ i ] || lab[ i ] )
+				continue;
+			lab[ i ] = ++n;
+			stack.push_back( i );
+			while( !stack.empty() ) {
+				int p = stack.back();
+				stack.pop_back();
+				int px = p % w, py = p / w;
+				for( int dy = -1; dy <= 1; dy++ ) {
+					for( int dx = -1; dx <= 1; dx++ ) {
+						if( ( !dx && !dy ) || ( !eight && dx && dy ) )
+							continue;
+						int x = px + dx, y = py + dy;
+						if( x < 0 || x >= w || y < 0 || y >= h || !mask[ y * w + x ] || lab[ y * w + x ] )
+							continue;
+						lab[ y * w + x ] = n;
+						stack.push_back( y * w + x );
+					}
+				}
+			}
+		}
+		return n;
+	}
+
+	static void _ilRandomMask( Image& img, std::vector<bool>& mask, int w, int h, float density )
+	{
+		img.reallocate( w, h, IFormat::GRAY_UINT8 );
+		mask.resize( w * h );
+		IMapScoped<uint8_t> map( img );
+		for( int y = 0; y < h; y++ ) {
+			for( int x = 0; x < w; x++ ) {
+				mask[ y * w + x ] = Math::rand( 0.0f, 1.0f ) < density;
+				map.ptr()[ x ] = mask[ y * w + x ] ? 255 : 0;
+			}
+			map++;
+		}
+	}
+
+	static bool _ilCompare( const ILabeling& l, const std::vector<bool>& mask, int w, int h, bool eight )
+	{
+		std::vector<uint32_t> ref;
+		size_t n = _ilReference( ref, mask, w, h, eight );
+		if( n != l.size() )
+			return false;
+
+		std::vector<double> sx( n, 0.0 ), sy( n, 0.0 ), sxx( n, 0.0 );
+		std::vector<size_t> area( n, 0 );
+		for( int i = 0; i < w * h; i++ ) {
+			if( l.labels()[ i ] != ref[ i ] )
+				return false;
+			if( ref[ i ] ) {
+				area[ ref[ i ] - 1 ]++;
+				sx[ ref[ i ] - 1 ] += i % w;
+				sy[ ref[ i ] - 1 ] += i / w;
+				sxx[ ref[ i ] - 1 ] += ( double ) ( i % w ) * ( i % w );
+			}
+		}
+		for( size_t i = 0; i < n; i++ ) {
+			double cx = sx[ i ] / area[ i ];
+			if( l[ i ].area != area[ i ] || Math::abs( l[ i ].centroid.x - cx ) > 1e-3 || Math::abs( l[ i ].centroid.y - sy[ i ] / area[ i ] ) > 1e-3 ||
+				Math::abs( l[ i ].mu20 - ( sxx[ i ] / area[ i ] - cx * cx ) ) > 1e-2 )
+				return false;
+		}
+		return true;
+	}
+
+	/* component count followed by the label image */
+	struct ILabelImage {
+		ILabelImage( const Image& i ) : img( i ) {}
+		void operator()( std::vector<uint32_t>& out ) const
+		{
+			ILabeling l;
+			l.label( img );
+			out.assign( 1, l.size() );
+			out.insert( out.end(), l.labels(), l.labels() + img.width() * img.height() );
+		}
+		const Image& img;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( ILabeling )
+	bool result = true;
+	bool b;
+	Image img;
+	std::vector<bool> mask;
+
+	srand( 3 );
+
+	/* several strips, components crossing the strip borders */
+	_ilRandomMask( img, mask, 97, 211, 0.45f );
+	{
+		ILabeling l8( ILABEL_8 );
+		l8.label( img );
+		b = _ilCompare( l8, mask, 97, 211, true );
+	}
+	CVTTEST_PRINT( "8-connectivity", b );
+	result &= b;
+
+	{
+		ILabeling l4( ILABEL_4 );
+		l4.label( img );
+		b = _ilCompare( l4, mask, 97, 211, false );
+	}
+	CVTTEST_PRINT( "4-connectivity", b );
+	result &= b;
+
+	b = testThreadInvariance<std::vector<uint32_t> >( ILabelImage( img ), testEqual<std::vector<uint32_t> > );
+	CVTTEST_PRINT( "independent of the number of threads", b );
+	result &= b;
+
+	/* thresholded float image with a ring and a filled rectangle */
+	{
+		Image f( 60, 150, IFormat::GRAY_FLOAT );
+		{
+			IMapScoped<float> map( f );
+			for( int y = 0; y < 150; y++ ) {
+				for( int x = 0; x < 60; x++ ) {
+					float r2 = ( x - 20 ) * ( x - 20 ) + ( y - 100 ) * ( y - 100 );
+					bool ring = r2 <= 15 * 15 && r2 >= 10 * 10;
+					bool rect = x >= 5 && x < 45 && y >= 10 && y < 70;
+					map.ptr()[ x ] = ring || rect ? 0.8f : 0.3f;
+				}
+				map++;
+			}
+		}
+		ILabeling l;
+		l.label( f, 0.5f, true );
+		b = l.size() == 2;
+		if( b ) {
+			const ILabelComponent& r = l[ 0 ];
+			b = r.area == 40 * 60 && r.bounds == Recti( 5, 10, 40, 60 ) && Math::abs( r.centroid.x - 24.5f ) < 1e-4f && Math::abs( r.centroid.y - 39.5f ) < 1e-4f;
+			/* var of 0..n-1 is ( n^2 - 1 ) / 12 */
+			b &= Math::abs( r.mu20 - ( 40.0f * 40.0f - 1.0f ) / 12.0f ) < 1e-2f && Math::abs( r.mu02 - ( 60.0f * 60.0f - 1.0f ) / 12.0f ) < 1e-2f && Math::abs( r.mu11 ) < 1e-2f;
+			b &= r.contour.size() == 2 * ( 40 + 60 ) - 4 && r.contour[ 0 ].x == 5 && r.contour[ 0 ].y == 10 && r.contour[ 1 ].x == 6 && r.contour[ 1 ].y == 10;
+
+			/* the outer contour of the ring only has pixels at the outer radius */
+			const ILabelComponent& c = l[ 1 ];
+			b &= Math::abs( c.centroid.x - 20.0f ) < 1e-3f && Math::abs( c.centroid.y - 100.0f ) < 1e-3f && c.contour.size() > 40;
+			for( size_t i = 0; i < c.contour.size(); i++ ) {
+				float d = Math::sqrt( ( float ) ( Math::sqr( c.contour[ i ].x - 20 ) + Math::sqr( c.contour[ i ].y - 100 ) ) );
+				b &= d > 13.0f && l.labelAt( c.contour[ i ].x, c.contour[ i ].y ) == 2;
+			}
+		}
+	}
+	CVTTEST_PRINT( "statistics and contours", b );
+	result &= b;
+
+	{
+		IComponents<float> comps( img );
+		ILabeling l;
+		l.label( img );
+		b = comps.size() == l.size();
+		for( size_t i = 0; b && i < comps.size(); i++ )
+			b = comps[ i ].size() == l[ i ].area;
+	}
+	CVTTEST_PRINT( "IComponents", b );
+	result &= b;
+
+	/* negative float pixels are components as well, empty labelings have no label array */
+	{
+		Image f( 20, 10, IFormat::GRAY_FLOAT );
+		f.fill( Color( 0.0f ) );
+		{
+			IMapScoped<float> map( f );
+			map.line( 2 )[ 3 ] = -1.0f;
+			map.line( 2 )[ 4 ] = 0.5f;
+			map.line( 7 )[ 15 ] = -0.25f;
+		}
+		IComponents<float> comps( f );
+		b = comps.size() == 2 && comps[ 0 ].size() == 2 && comps[ 1 ].size() == 1;
+
+		ILabeling l;
+		b &= l.labels() == NULL;
+		l.label( f );
+		b &= l.size() == 1 && l.labels() != NULL;
+		l.labelNonZero( f );
+		b &= l.size() == 2;
+	}
+	CVTTEST_PRINT( "non-zero pixels", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
@@ -26,119 +26,464 @@
 #include <cvt/gfx/IMapScoped.h>
 #include <cvt/util/SIMD.h>
 #include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/Exception.h>
 #include <cvt/gfx/IMorphological.h>
 
+#include <limits>
+#include <cstring>
+
 namespace cvt
 {
 
-	template<typename TYPE>
-	static void morphTemplate( Image& dst, const Image& src, size_t radius,
-								void ( SIMD::*hfunc )( TYPE*, const TYPE*, size_t, size_t ) const,
-								void ( SIMD::*hfuncborder )( TYPE*, const TYPE*, const TYPE*, size_t ) const,
-								void ( SIMD::*vfunc )( TYPE*, const TYPE**, size_t, size_t ) const
-							 )
-	{
-		SIMD* simd = SIMD::instance();
-		const size_t boxsize = radius * 2 + 1;
-		size_t curbuf;
-		size_t w = src.width();
-		size_t h = src.height();
-		size_t bstride = Math::pad16( sizeof( TYPE ) * w ) / sizeof( TYPE ); //FIXME: does this always work - it should
-		TYPE** buf;
-		size_t i;
-
-		IMapScoped<TYPE> mapdst( dst );
-		IMapScoped<const TYPE> mapsrc( src );
-
-		/* allocate and fill buffer */
-		ScopedBuffer<TYPE,true> bufmem( bstride * boxsize );
-		ScopedBuffer<TYPE*,true> bufptr( boxsize );
-
-		buf = bufptr.ptr();
-		buf[ 0 ] = bufmem.ptr();
-		for( i = 0; i < boxsize; i++ ) {
-			if( i != 0 )
-				buf[ i ] = buf[ i - 1 ] + bstride;
-			( simd->*hfunc )( buf[ i ], mapsrc.ptr(), w, radius );
-			mapsrc++;
+	IMorphElement::IMorphElement( size_t radius ) : _shape( IMORPH_RECT )
+	{
+		add( -( int ) radius, -( int ) radius, 2 * radius + 1, 2 * radius + 1 );
+	}
+
+	IMorphElement::IMorphElement( IMorphShape shape ) : _shape( shape )
+	{
+	}
+
+	IMorphElement IMorphElement::rect( size_t radiusx, size_t radiusy )
+	{
+		IMorphElement e( IMORPH_RECT );
+		e.add( -( int ) radiusx, -( int ) radiusy, 2 * radiusx + 1, 2 * radiusy + 1 );
+		return e;
+	}
+
+	IMorphElement IMorphElement::cross( size_t radiusx, size_t radiusy )
+	{
+		IMorphElement e( IMORPH_CROSS );
+		e.add( -( int ) radiusx, 0, 2 * radiusx + 1, 1 );
+		if( radiusy )
+			e.add( 0, -( int ) radiusy, 1, 2 * radiusy + 1 );
+		return e;
+	}
+
+	IMorphElement IMorphElement::disk( size_t radius )
+	{
+		IMorphElement e( IMORPH_DISK );
+		const int r = radius;
+
+		/* one rectangle per distinct half width, as high as the rows reaching this width */
+		int dy = 0;
+		while( dy <= r ) {
+			int hw = ( int ) Math::sqrt( ( float ) ( r * r - dy * dy ) + 1e-3f );
+			while( dy < r && ( int ) Math::sqrt( ( float ) ( r * r - ( dy + 1 ) * ( dy + 1 ) ) + 1e-3f ) == hw )
+				dy++;
+			e.add( -hw, -dy, 2 * hw + 1, 2 * dy + 1 );
+			dy++;
+		}
+		return e;
+	}
+
+	IMorphElement IMorphElement::line( size_t radius, float angle )
+	{
+		IMorphElement e( IMORPH_LINE );
+		const int r = radius;
+		float c = Math::cos( angle );
+		float s = Math::sin( angle );
+		bool steep = Math::abs( s ) > Math::abs( c );
+		float slope = steep ? c / s : s / c;
+
+		/* runs of pixels along the dominant axis with the same offset in the other direction */
+		int t = -r;
+		while( t <= r ) {
+			int o = ( int ) Math::round( t * slope );
+			int t1 = t;
+			while( t1 < r && ( int ) Math::round( ( t1 + 1 ) * slope ) == o )
+				t1++;
+			if( steep )
+				e.add( o, t, 1, t1 - t + 1 );
+			else
+				e.add( t, o, t1 - t + 1, 1 );
+			t = t1 + 1;
+		}
+		return e;
+	}
+
+	void IMorphElement::add( int x, int y, int width, int height )
+	{
+		if( _rects.empty() ) {
+			_bounds.set( x, y, width, height );
+		} else {
+			int x1 = Math::max( _bounds.x + _bounds.width, x + width );
+			int y1 = Math::max( _bounds.y + _bounds.height, y + height );
+			_bounds.x = Math::min( _bounds.x, x );
+			_bounds.y = Math::min( _bounds.y, y );
+			_bounds.width = x1 - _bounds.x;
+			_bounds.height = y1 - _bounds.y;
 		}
+		_rects.push_back( Recti( x, y, width, height ) );
+	}
 
-		/* upper border */
-		( simd->*vfunc )( mapdst.ptr(), ( const TYPE** ) buf, radius + 1, w );
-		for( i = 1; i < radius; i++ ) {
-			TYPE* prev = mapdst.ptr();
-			mapdst++;
-			( simd->*hfuncborder )( mapdst.ptr(), ( const TYPE* ) prev, ( const TYPE* ) buf[ radius + 1 + i ], w );
+	bool IMorphElement::contains( int dx, int dy ) const
+	{
+		for( size_t i = 0; i < _rects.size(); i++ ) {
+			const Recti& r = _rects[ i ];
+			if( dx >= r.x && dx < r.x + r.width && dy >= r.y && dy < r.y + r.height )
+				return true;
 		}
-		mapdst++;
-
-		/* center */
-		curbuf = 0;
-		i = h - 2 * radius - 1;
-		( simd->*vfunc )( mapdst.ptr(), ( const TYPE** ) buf, boxsize, w );
-		mapdst++;
-		while( i-- ) {
-			( simd->*hfunc )( buf[ curbuf ], mapsrc.ptr(), w, radius );
-			curbuf = ( curbuf + 1 ) % boxsize;
-			( simd->*vfunc )( mapdst.ptr(), ( const TYPE** ) buf, boxsize, w );
-			mapdst++;
-			mapsrc++;
+		return false;
+	}
+
+
+	template<typename T>
+	struct IMorphType {
+		static T lowest() { return std::numeric_limits<T>::min(); }
+		static T highest() { return std::numeric_limits<T>::max(); }
+	};
+
+	template<>
+	struct IMorphType<float> {
+		static float lowest() { return -std::numeric_limits<float>::infinity(); }
+		static float highest() { return std::numeric_limits<float>::infinity(); }
+	};
+
+	template<typename T>
+	struct IMorphErode {
+		static T	neutral() { return IMorphType<T>::highest(); }
+		static T	op( T a, T b ) { return a < b ? a : b; }
+		static void row( const SIMD* simd, T* dst, const T* src1, const T* src2, size_t n );
+	};
+
+	template<typename T>
+	struct IMorphDilate {
+		static T	neutral() { return IMorphType<T>::lowest(); }
+		static T	op( T a, T b ) { return a > b ? a : b; }
+		static void row( const SIMD* simd, T* dst, const T* src1, const T* src2, size_t n );
+	};
+
+	template<> void IMorphErode<uint8_t>::row( const SIMD* simd, uint8_t* dst, const uint8_t* src1, const uint8_t* src2, size_t n ) { simd->MinValueU8( dst, src1, src2, n ); }
+	template<> void IMorphErode<uint16_t>::row( const SIMD* simd, uint16_t* dst, const uint16_t* src1, const uint16_t* src2, size_t n ) { simd->MinValueU16( dst, src1, src2, n ); }
+	template<> void IMorphErode<float>::row( const SIMD* simd, float* dst, const float* src1, const float* src2, size_t n ) { simd->MinValue1f( dst, src1, src2, n ); }
+	template<> void IMorphDilate<uint8_t>::row( const SIMD* simd, uint8_t* dst, const uint8_t* src1, const uint8_t* src2, size_t n ) { simd->MaxValueU8( dst, src1, src2, n ); }
+	template<> void IMorphDilate<uint16_t>::row( const SIMD* simd, uint16_t* dst, const uint16_t* src1, const uint16_t* src2, size_t n ) { simd->MaxValueU16( dst, src1, src2, n ); }
+	template<> void IMorphDilate<float>::row( const SIMD* simd, float* dst, const float* src1, const float* src2, size_t n ) { simd->MaxValue1f( dst, src1, src2, n ); }
+
+	/* rows [ begin, end ) of an image or of a band buffer, other rows are outside of the image */
+	template<typename T>
+	struct IMorphRows {
+		IMorphRows( uint8_t* b, size_t s, int y0, int y1 ) : base( b ), stride( s ), begin( y0 ), end( y1 ) {}
+
+		T*		row( int y ) const { return ( T* ) ( base + ( y - begin ) * stride ); }
+		bool	inside( int y ) const { return y >= begin && y < end; }
+
+		uint8_t*	base;
+		size_t		stride;
+		int			begin, end;
+	};
+
+	/* buffers of one thread, sized for the element and the largest band */
+	template<typename T>
+	class IMorphWork {
+		public:
+			IMorphWork( const IMorphElement& e, size_t width, size_t rows ) :
+				_width( width ),
+				_maxw( 1 ),
+				_maxh( 1 )
+			{
+				for( size_t i = 0; i < e.rectCount(); i++ ) {
+					_maxw = Math::max<size_t>( _maxw, e.rect( i ).width );
+					_maxh = Math::max<size_t>( _maxh, e.rect( i ).height );
+				}
+				size_t vrows = rows + _maxh - 1;
+				_line.resize( 3 * ( width + _maxw ) );
+				_rows.resize( ( 2 * vrows + 3 ) * width );
+				_ptrs.resize( vrows );
+			}
+
+			/* padded source, suffix maxima of the segments */
+			T*		linePadded() { return &_line[ 0 ]; }
+			T*		lineSuffix() { return &_line[ _width + _maxw ]; }
+			T*		hrows( size_t i ) { return &_rows[ i * _width ]; }
+			T*		vsuffix( size_t i ) { return &_rows[ ( _ptrs.size() + i ) * _width ]; }
+			T*		neutralRow() { return &_rows[ 2 * _ptrs.size() * _width ]; }
+			T*		runRow() { return neutralRow() + _width; }
+			T*		tmpRow() { return runRow() + _width; }
+			const T** ptrs() { return &_ptrs[ 0 ]; }
+
+		private:
+			size_t			_width, _maxw, _maxh;
+			std::vector<T>	_line;
+			std::vector<T>	_rows;
+			std::vector<const T*> _ptrs;
+	};
+
+	/* dst[ x ] = OP( src[ x + x0 ], ..., src[ x + x0 + len - 1 ] ), outside values ignored */
+	template<typename T, typename OP>
+	static void morphLine( T* dst, const T* src, int width, int x0, int len, IMorphWork<T>& work )
+	{
+		if( len == 1 && x0 == 0 ) {
+			memcpy( dst, src, sizeof( T ) * width );
+			return;
 		}
 
-		/* lower border */
-		/* reorder buffer */
-		ScopedBuffer<TYPE*,true> bufptr2( boxsize );
-		TYPE** buf2 = bufptr2.ptr();
-		for( i = 0; i < boxsize; i++ )
-			buf2[ i ] = buf[ ( curbuf + i ) % boxsize ];
+		const int n = width + len - 1;
+		T* p = work.linePadded();
+		T* g = work.lineSuffix();
+
+		/* p[ j ] = src[ j + x0 ] */
+		int j0 = Math::max( 0, -x0 );
+		int j1 = Math::min( n, width - x0 );
+		for( int j = 0; j < j0; j++ )
+			p[ j ] = OP::neutral();
+		if( j1 > j0 )
+			memcpy( p + j0, src + j0 + x0, sizeof( T ) * ( j1 - j0 ) );
+		for( int j = Math::max( j0, j1 ); j < n; j++ )
+			p[ j ] = OP::neutral();
 
-		for( i = 1; i <= radius; i++ ) {
-			( simd->*vfunc )( mapdst.ptr(), ( const TYPE** ) ( buf2 + i ), boxsize - i, w );
-			mapdst++;
+		/* van Herk/Gil-Werman: suffix and prefix of segments with len values */
+		for( int a = 0; a < width; a += len ) {
+			int b = Math::min( a + len, n ) - 1;
+			g[ b ] = p[ b ];
+			for( int j = b - 1; j >= a; j-- )
+				g[ j ] = OP::op( p[ j ], g[ j + 1 ] );
+		}
+
+		T prefix = g[ 0 ];
+		dst[ 0 ] = prefix;
+		for( int j = len; j < n; j++ ) {
+			prefix = ( j % len ) ? OP::op( prefix, p[ j ] ) : p[ j ];
+			dst[ j - len + 1 ] = OP::op( g[ j - len + 1 ], prefix );
 		}
 	}
 
-	void IMorphological::dilate( Image& dst, const Image& src, size_t radius )
+	/* rows [ y0, y1 ) of dst = OP over the element of src */
+	template<typename T, typename OP>
+	static void morphRows( const IMorphRows<T>& dst, int y0, int y1, const IMorphRows<T>& src, const IMorphElement& e, int width, IMorphWork<T>& work )
 	{
-		if( src.channels() != 1 )
-			throw CVTException( "Not implemented IMorphological::dilate" );
+		const SIMD* simd = SIMD::instance();
+		const int nout = y1 - y0;
+		T* neutral = work.neutralRow();
+		for( int x = 0; x < width; x++ )
+			neutral[ x ] = OP::neutral();
 
-		dst.reallocate( src.width(), src.height(), src.format() );
+		for( size_t k = 0; k < e.rectCount(); k++ ) {
+			const Recti& r = e.rect( k );
+			const int m = nout + r.height - 1;
+			const T** p = work.ptrs();
 
-		switch( src.format().formatID ) {
-			case IFORMAT_GRAY_UINT8:
-				morphTemplate<uint8_t>( dst, src, radius, &SIMD::dilateSpanU8, &SIMD::MaxValueU8, &SIMD::MaxValueVertU8 );
-				return;
-			case IFORMAT_GRAY_UINT16:
-				morphTemplate<uint16_t>( dst, src, radius, &SIMD::dilateSpanU16, &SIMD::MaxValueU16, &SIMD::MaxValueVertU16 );
-				break;
-			case IFORMAT_GRAY_FLOAT:
-				morphTemplate<float>( dst, src, radius, &SIMD::dilateSpan1f, &SIMD::MaxValue1f, &SIMD::MaxValueVert1f );
-				break;
-			default:
-				throw CVTException( "Not implemented" );
+			/* horizontal pass for all source rows of the rectangle */
+			for( int j = 0; j < m; j++ ) {
+				int y = y0 + r.y + j;
+				if( src.inside( y ) ) {
+					morphLine<T, OP>( work.hrows( j ), src.row( y ), width, r.x, r.width, work );
+					p[ j ] = work.hrows( j );
+				} else
+					p[ j ] = neutral;
+			}
+
+			if( r.height == 1 ) {
+				for( int i = 0; i < nout; i++ ) {
+					if( k == 0 )
+						memcpy( dst.row( y0 + i ), p[ i ], sizeof( T ) * width );
+					else
+						OP::row( simd, dst.row( y0 + i ), dst.row( y0 + i ), p[ i ], width );
+				}
+				continue;
+			}
+
+			/* vertical van Herk/Gil-Werman on whole rows */
+			const int len = r.height;
+			for( int a = 0; a < nout; a += len ) {
+				int b = Math::min( a + len, m ) - 1;
+				memcpy( work.vsuffix( b ), p[ b ], sizeof( T ) * width );
+				for( int j = b - 1; j >= a; j-- )
+					OP::row( simd, work.vsuffix( j ), p[ j ], work.vsuffix( j + 1 ), width );
+			}
+
+			T* prefix = work.runRow();
+			memcpy( prefix, work.vsuffix( 0 ), sizeof( T ) * width );
+			for( int j = len - 1; j < m; j++ ) {
+				if( j >= len ) {
+					if( j % len )
+						OP::row( simd, prefix, prefix, p[ j ], width );
+					else
+						memcpy( prefix, p[ j ], sizeof( T ) * width );
+				}
+				int i = j - len + 1;
+				if( k == 0 ) {
+					OP::row( simd, dst.row( y0 + i ), work.vsuffix( i ), prefix, width );
+				} else {
+					T* tmp = work.tmpRow();
+					OP::row( simd, tmp, work.vsuffix( i ), prefix, width );
+					OP::row( simd, dst.row( y0 + i ), dst.row( y0 + i ), tmp, width );
+				}
+			}
 		}
 	}
 
-	void IMorphological::erode( Image& dst, const Image& src, size_t radius )
+	template<typename T>
+	static void morphSub( T* dst, const T* src1, const T* src2, size_t n )
+	{
+		while( n-- )
+			*dst++ = *src1++ - *src2++;
+	}
+
+	template<typename T>
+	class IMorphBody
+	{
+		public:
+			IMorphBody( const IMorphRows<T>& dst, const IMorphRows<T>& src, int width, int height, IMorphOperation op, const IMorphElement& e ) :
+				_dst( dst ), _src( src ), _width( width ), _height( height ), _op( op ), _e( e )
+			{
+			}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				int y0 = start, y1 = end;
+				const Recti& b = _e.bounds();
+
+				/* rows of the intermediate result needed by the second operation */
+				int ty0 = y0, ty1 = y1;
+				if( _op == IMORPH_OPEN || _op == IMORPH_CLOSE || _op == IMORPH_TOPHAT || _op == IMORPH_BLACKHAT ) {
+					ty0 = Math::max( 0, y0 + b.y );
+					ty1 = Math::min( _height, y1 + b.y + b.height - 1 );
+				} else if( _op != IMORPH_GRADIENT ) {
+					ty1 = ty0;
+				}
+
+				IMorphWork<T> work( _e, _width, Math::max( y1 - y0, ty1 - ty0 ) );
+				size_t tstride = sizeof( T ) * _width;
+				ScopedBuffer<T, true> tbuf( Math::max( ty1 - ty0, 1 ) * _width );
+				IMorphRows<T> tmp( ( uint8_t* ) tbuf.ptr(), tstride, ty0, ty1 );
+
+				switch( _op ) {
+					case IMORPH_ERODE:
+						morphRows<T, IMorphErode<T> >( _dst, y0, y1, _src, _e, _width, work );
+						break;
+					case IMORPH_DILATE:
+						morphRows<T, IMorphDilate<T> >( _dst, y0, y1, _src, _e, _width, work );
+						break;
+					case IMORPH_OPEN:
+					case IMORPH_TOPHAT:
+						morphRows<T, IMorphErode<T> >( tmp, ty0, ty1, _src, _e, _width, work );
+						morphRows<T, IMorphDilate<T> >( _dst, y0, y1, tmp, _e, _width, work );
+						break;
+					case IMORPH_CLOSE:
+					case IMORPH_BLACKHAT:
+						morphRows<T, IMorphDilate<T> >( tmp, ty0, ty1, _src, _e, _width, work );
+						morphRows<T, IMorphErode<T> >( _dst, y0, y1, tmp, _e, _width, work );
+						break;
+					case IMORPH_GRADIENT:
+						morphRows<T, IMorphDilate<T> >( _dst, y0, y1, _src, _e, _width, work );
+						morphRows<T, IMorphErode<T> >( tmp, y0, y1, _src, _e, _width, work );
+						for( int y = y0; y < y1; y++ )
+							morphSub( _dst.row( y ), _dst.row( y ), tmp.row( y ), _width );
+						break;
+				}
+
+				if( _op == IMORPH_TOPHAT ) {
+					for( int y = y0; y < y1; y++ )
+						morphSub( _dst.row( y ), _src.row( y ), _dst.row( y ), _width );
+				} else if( _op == IMORPH_BLACKHAT ) {
+					for( int y = y0; y < y1; y++ )
+						morphSub( _dst.row( y ), _dst.row( y ), _src.row( y ), _width );
+				}
+			}
+
+		private:
+			const IMorphRows<T>&	_dst;
+			const IMorphRows<T>&	_src;
+			int						_width, _height;
+			IMorphOperation			_op;
+			const IMorphElement&	_e;
+	};
+
+	template<typename T>
+	static void morphTemplate( Image& dst, const Image& src, IMorphOperation op, const IMorphElement& e )
+	{
+		IMapScoped<T> mapdst( dst );
+		IMapScoped<const T> mapsrc( src );
+		const int h = src.height();
+		IMorphRows<T> rdst( ( uint8_t* ) mapdst.ptr(), mapdst.stride(), 0, h );
+		IMorphRows<T> rsrc( ( uint8_t* ) mapsrc.ptr(), mapsrc.stride(), 0, h );
+		IMorphBody<T> body( rdst, rsrc, src.width(), h, op, e );
+		ParallelFor::run( body, 0, h, 16 );
+	}
+
+	void IMorphological::apply( Image& dst, const Image& src, IMorphOperation op, const IMorphElement& element )
 	{
 		if( src.channels() != 1 )
-			throw CVTException( "Not implemented IMorphological::erode" );
+			throw CVTException( "Not implemented IMorphological::apply" );
+
+		if( &dst == &src ) {
+			Image copy( src );
+			apply( dst, copy, op, element );
+			return;
+		}
 
 		dst.reallocate( src.width(), src.height(), src.format() );
 
 		switch( src.format().formatID ) {
 			case IFORMAT_GRAY_UINT8:
-				morphTemplate<uint8_t>( dst, src, radius, &SIMD::erodeSpanU8, &SIMD::MinValueU8, &SIMD::MinValueVertU8 );
-				return;
+				morphTemplate<uint8_t>( dst, src, op, element );
+				break;
 			case IFORMAT_GRAY_UINT16:
-				morphTemplate<uint16_t>( dst, src, radius, &SIMD::erodeSpanU16, &SIMD::MinValueU16, &SIMD::MinValueVertU16 );
+				morphTemplate<uint16_t>( dst, src, op, element );
 				break;
 			case IFORMAT_GRAY_FLOAT:
-				morphTemplate<float>( dst, src, radius, &SIMD::erodeSpan1f, &SIMD::MinValue1f, &SIMD::MinValueVert1f );
+				morphTemplate<float>( dst, src, op, element );
 				break;
 			default:
 				throw CVTException( "Not implemented" );
 		}
 	}
+
+	void IMorphological::dilate( Image& dst, const Image& src, size_t radius )
+	{
+		apply( dst, src, IMORPH_DILATE, IMorphElement( radius ) );
+	}
+
+	void IMorphological::erode( Image& dst, const Image& src, size_t radius )
+	{
+		apply( dst, src, IMORPH_ERODE, IMorphElement( radius ) );
+	}
+
+	void IMorphological::open( Image& dst, const Image& src, size_t radius )
+	{
+		apply( dst, src, IMORPH_OPEN, IMorphElement( radius ) );
+	}
+
+	void IMorphological::close( Image& dst, const Image& src, size_t radius )
+	{
+		apply( dst, src, IMORPH_CLOSE, IMorphElement( radius ) );
+	}
+
+	void IMorphological::dilate( Image& dst, const Image& src, const IMorphElement& element )
+	{
+		apply( dst, src, IMORPH_DILATE, element );
+	}
+
+	void IMorphological::erode( Image& dst, const Image& src, const IMorphElement& element )
+	{
+		apply( dst, src, IMORPH_ERODE, element );
+	}
+
+	void IMorphological::open( Image& dst, const Image& src, const IMorphElement& element )
+	{
+		apply( dst, src, IMORPH_OPEN, element );
+	}
+
+	void IMorphological::close( Image& dst, const Image& src, const IMorphElement& element )
+	{
+		apply( dst, src, IMORPH_CLOSE, element );
+	}
+
+	void IMorphological::gradient( Image& dst, const Image& src, const IMorphElement& element )
+	{
+		apply( dst, src, IMORPH_GRADIENT, element );
+	}
+
+	void IMorphological::topHat( Image& dst, const Image& src, const IMorphElement& element )
+	{
+		apply( dst, src, IMORPH_TOPHAT, element );
+	}
+
+	void IMorphological::blackHat( Image& dst, const Image& src, const IMorphElement& element )
+	{
+		apply( dst, src, IMORPH_BLACKHAT, element );
+	}
 }
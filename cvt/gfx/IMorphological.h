@@ -25,17 +25,89 @@
 #ifndef CVT_IMORPHOLOGICAL_H
 #define CVT_IMORPHOLOGICAL_H
 
+#include <cvt/geom/Rect.h>
+#include <vector>
+
 namespace cvt
 {
 	class Image;
 
+	enum IMorphShape {
+		IMORPH_RECT,
+		IMORPH_CROSS,
+		IMORPH_DISK,
+		IMORPH_LINE
+	};
+
+	enum IMorphOperation {
+		IMORPH_ERODE,
+		IMORPH_DILATE,
+		IMORPH_OPEN,
+		IMORPH_CLOSE,
+		IMORPH_GRADIENT,	/* dilation - erosion */
+		IMORPH_TOPHAT,		/* src - opening */
+		IMORPH_BLACKHAT		/* closing - src */
+	};
+
+	/**
+	  @brief Symmetric structuring element centred at the origin.
+
+	  The element is stored as a union of rectangles ( offsets to the centre ), each rectangle is
+	  handled with the van Herk/Gil-Werman algorithm in both directions, so the cost per pixel
+	  depends on the number of rectangles but not on their size: one for rectangles, two for crosses,
+	  one per distinct row width for disks and one per run of pixels for lines.
+	 */
+	class IMorphElement
+	{
+		public:
+			/* square with side 2 * radius + 1 */
+			explicit IMorphElement( size_t radius = 1 );
+
+			static IMorphElement rect( size_t radiusx, size_t radiusy );
+			static IMorphElement cross( size_t radiusx, size_t radiusy );
+			/* all offsets with dx^2 + dy^2 <= radius^2 */
+			static IMorphElement disk( size_t radius );
+			/* digital line with 2 * radius + 1 pixels, angle in radians */
+			static IMorphElement line( size_t radius, float angle );
+
+			IMorphShape		shape() const { return _shape; }
+			size_t			rectCount() const { return _rects.size(); }
+			const Recti&	rect( size_t i ) const { return _rects[ i ]; }
+			/* bounding box of the offsets */
+			const Recti&	bounds() const { return _bounds; }
+			bool			contains( int dx, int dy ) const;
+
+		private:
+			IMorphElement( IMorphShape shape );
+			void			add( int x, int y, int width, int height );
+
+			IMorphShape			_shape;
+			std::vector<Recti>	_rects;
+			Recti				_bounds;
+	};
+
+	/**
+	  Morphology for GRAY_UINT8, GRAY_UINT16 and GRAY_FLOAT images, the windows are clipped at the image borders.
+	  The compound operations work on bands of rows and need no intermediate images, the bands are processed in parallel.
+	 */
 	class IMorphological
 	{
 		public:
+			static void apply( Image& dst, const Image& src, IMorphOperation op, const IMorphElement& element );
+
 			static void dilate( Image& dst, const Image& src, size_t radius );
 			static void erode( Image& dst, const Image& src, size_t radius );
-//			static void open( Image& dst, const Image& src, size_t radius );
-//			static void close( Image& dst, const Image& src, size_t radius );
+			static void open( Image& dst, const Image& src, size_t radius );
+			static void close( Image& dst, const Image& src, size_t radius );
+
+			static void dilate( Image& dst, const Image& src, const IMorphElement& element );
+			static void erode( Image& dst, const Image& src, const IMorphElement& element );
+			static void open( Image& dst, const Image& src, const IMorphElement& element );
+			static void close( Image& dst, const Image& src, const IMorphElement& element );
+			static void gradient( Image& dst, const Image& src, const IMorphElement& element );
+			static void topHat( Image& dst, const Image& src, const IMorphElement& element );
+			static void blackHat( Image& dst, const Image& src, const IMorphElement& element );
+
 		private:
 			IMorphological() {}
 			IMorphological( const IMorphological& ) {}
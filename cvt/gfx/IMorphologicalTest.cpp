@@ -0,0 +1,209 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/IMorphological.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+#include <vector>
+
+namespace cvt {
+
+	template<typename T>
+	static void _morphRandom( Image& img, size_t w, size_t h, const IFormat& format, float scale )
+	{
+		img.reallocate( w, h, format );
+		IMapScoped<T> map( img );
+		for( size_t y = 0; y < h; y++ ) {
+			for( size_t x = 0; x < w; x++ )
+				map.ptr()[ x ] = ( T ) Math::rand( 0.0f, scale );
+			map++;
+		}
+	}
+
+	/* brute force erosion/dilation over the offsets of the element with clipped windows */
+	template<typename T>
+	static void _morphReference( std::vector<T>& out, const std::vector<T>& in, int w, int h, const IMorphElement& e, bool dilate )
+	{
+		const Recti& b = e.bounds();
+		out.resize( w * h );
+		for( int y = 0; y < h; y++ ) {
+			for( int x = 0; x < w; x++ ) {
+				T v = in[ y * w + x ];
+				for( int dy = b.y; dy < b.y + b.height; dy++ ) {
+					for( int dx = b.x; dx < b.x + b.width; dx++ ) {
+						int xx = x + dx, yy = y + dy;
+						if( xx < 0 || xx >= w || yy < 0 || yy >= h || !e.contains( dx, dy ) )
+							continue;
+						T s = in[ yy * w + xx ];
+						v = dilate ? Math::max( v, s ) : Math::min( v, s );
+					}
+				}
+				out[ y * w + x ] = v;
+			}
+		}
+	}
+
+	template<typename T>
+	static void _morphReferenceOp( std::vector<T>& out, const std::vector<T>& in, int w, int h, const IMorphElement& e, IMorphOperation op )
+	{
+		std::vector<T> a, b;
+		switch( op ) {
+			case IMORPH_ERODE: _morphReference( out, in, w, h, e, false ); break;
+			case IMORPH_DILATE: _morphReference( out, in, w, h, e, true ); break;
+			case IMORPH_OPEN:
+			case IMORPH_TOPHAT:
+				_morphReference( a, in, w, h, e, false );
+				_morphReference( out, a, w, h, e, true );
+				break;
+			case IMORPH_CLOSE:
+			case IMORPH_BLACKHAT:
+				_morphReference( a, in, w, h, e, true );
+				_morphReference( out, a, w, h, e, false );
+				break;
+			case IMORPH_GRADIENT:
+				_morphReference( a, in, w, h, e, true );
+				_morphReference( b, in, w, h, e, false );
+				out.resize( in.size() );
+				for( size_t i = 0; i < out.size(); i++ )
+					out[ i ] = a[ i ] - b[ i ];
+				break;
+		}
+		for( size_t i = 0; i < out.size(); i++ ) {
+			if( op == IMORPH_TOPHAT )
+				out[ i ] = in[ i ] - out[ i ];
+			else if( op == IMORPH_BLACKHAT )
+				out[ i ] = out[ i ] - in[ i ];
+		}
+	}
+
+	template<typename T>
+	static bool _morphCheck( const Image& src, IMorphOperation op, const IMorphElement& e )
+	{
+		const int w = src.width(), h = src.height();
+		std::vector<T> in( w * h ), ref;
+		{
+			IMapScoped<const T> map( src );
+			for( int y = 0; y < h; y++ ) {
+				for( int x = 0; x < w; x++ )
+					in[ y * w + x ] = map.ptr()[ x ];
+				map++;
+			}
+		}
+		_morphReferenceOp( ref, in, w, h, e, op );
+
+		Image out;
+		IMorphological::apply( out, src, op, e );
+		if( out.format() != src.format() )
+			return false;
+		IMapScoped<const T> map( out );
+		for( int y = 0; y < h; y++ ) {
+			for( int x = 0; x < w; x++ )
+				if( map.ptr()[ x ] != ref[ y * w + x ] )
+					return false;
+			map++;
+		}
+		return true;
+	}
+
+	static bool _morphElementCheck( const IMorphElement& e, size_t size )
+	{
+		const Recti& b = e.bounds();
+		size_t n = 0;
+		for( int dy = b.y; dy < b.y + b.height; dy++ ) {
+			for( int dx = b.x; dx < b.x + b.width; dx++ ) {
+				if( e.contains( dx, dy ) ) {
+					n++;
+					if( !e.contains( -dx, -dy ) )
+						return false;
+				}
+			}
+		}
+		return e.contains( 0, 0 ) && n == size;
+	}
+
+	struct MorphClose {
+		MorphClose( const Image& s ) : src( s ) {}
+		void operator()( Image& out ) const { IMorphological::close( out, src, IMorphElement::disk( 9 ) ); }
+		const Image& src;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( IMorphological )
+	bool result = true;
+	bool b;
+	Image u8, u16, f;
+
+	srand( 5 );
+
+	b = _morphElementCheck( IMorphElement::rect( 3, 2 ), 35 );
+	b &= _morphElementCheck( IMorphElement::cross( 2, 4 ), 13 );
+	b &= _morphElementCheck( IMorphElement::disk( 5 ), 81 );
+	b &= _morphElementCheck( IMorphElement::line( 6, 0.4f ), 13 );
+	b &= _morphElementCheck( IMorphElement::line( 6, 1.3f ), 13 );
+	b &= IMorphElement::rect( 9, 9 ).rectCount() == 1;
+	CVTTEST_PRINT( "structuring elements", b );
+	result &= b;
+
+	_morphRandom<uint8_t>( u8, 67, 91, IFormat::GRAY_UINT8, 255.0f );
+	_morphRandom<uint16_t>( u16, 67, 91, IFormat::GRAY_UINT16, 60000.0f );
+	_morphRandom<float>( f, 67, 91, IFormat::GRAY_FLOAT, 1.0f );
+
+	IMorphElement elements[] = { IMorphElement( 4 ), IMorphElement::rect( 1, 7 ), IMorphElement::cross( 3, 5 ),
+								 IMorphElement::disk( 6 ), IMorphElement::line( 7, 0.6f ), IMorphElement::line( 5, -2.0f ) };
+	const char* names[] = { "square", "rect", "cross", "disk", "line", "steep line" };
+	for( size_t i = 0; i < 6; i++ ) {
+		b = _morphCheck<uint8_t>( u8, IMORPH_ERODE, elements[ i ] );
+		b &= _morphCheck<uint8_t>( u8, IMORPH_DILATE, elements[ i ] );
+		b &= _morphCheck<uint16_t>( u16, IMORPH_CLOSE, elements[ i ] );
+		b &= _morphCheck<float>( f, IMORPH_OPEN, elements[ i ] );
+		String msg;
+		msg.sprintf( "erode/dilate/open/close %s", names[ i ] );
+		CVTTEST_PRINT( msg.c_str(), b );
+		result &= b;
+	}
+
+	b = _morphCheck<uint8_t>( u8, IMORPH_GRADIENT, IMorphElement::disk( 3 ) );
+	b &= _morphCheck<uint8_t>( u8, IMORPH_TOPHAT, IMorphElement::cross( 4, 4 ) );
+	b &= _morphCheck<float>( f, IMORPH_BLACKHAT, IMorphElement( 2 ) );
+	CVTTEST_PRINT( "gradient/top-hat/black-hat", b );
+	result &= b;
+
+	/* radius larger than the image */
+	b = _morphCheck<uint8_t>( u8, IMORPH_CLOSE, IMorphElement( 60 ) );
+	CVTTEST_PRINT( "radius larger than the image", b );
+	result &= b;
+
+	b = testThreadInvariance<Image>( MorphClose( u8 ), testImagesEqual );
+	CVTTEST_PRINT( "independent of the number of threads", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
@@ -0,0 +1,204 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/IRemap.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/Exception.h>
+
+namespace cvt {
+
+	class RemapBand {
+		public:
+			RemapBand( const IRemap& map, uint8_t* dst, size_t dstride, const uint8_t* src, size_t sstride,
+					   size_t swidth, size_t sheight, const IFormat& format ) :
+				_map( map ), _dst( dst ), _dstride( dstride ), _src( src ), _sstride( sstride ),
+				_swidth( swidth ), _sheight( sheight ), _format( format )
+			{
+			}
+
+			void operator()( size_t ystart, size_t yend ) const
+			{
+				_map.applyRows( _dst, _dstride, _src, _sstride, _swidth, _sheight, _format, ystart, yend );
+			}
+
+		private:
+			const IRemap&	_map;
+			uint8_t*		_dst;
+			size_t			_dstride;
+			const uint8_t*	_src;
+			size_t			_sstride;
+			size_t			_swidth;
+			size_t			_sheight;
+			const IFormat&	_format;
+	};
+
+	/* the rows [ 0, h0 ) belong to the first, [ h0, h0 + h1 ) to the second remap */
+	class RemapBandPair {
+		public:
+			RemapBandPair( const RemapBand& band0, size_t h0, const RemapBand& band1 ) :
+				_band0( band0 ), _h0( h0 ), _band1( band1 )
+			{
+			}
+
+			void operator()( size_t ystart, size_t yend ) const
+			{
+				if( ystart < _h0 )
+					_band0( ystart, Math::min( yend, _h0 ) );
+				if( yend > _h0 )
+					_band1( Math::max( ystart, _h0 ) - _h0, yend - _h0 );
+			}
+
+		private:
+			const RemapBand&	_band0;
+			size_t				_h0;
+			const RemapBand&	_band1;
+	};
+
+	IRemap::IRemap() :
+		_width( 0 ),
+		_height( 0 )
+	{
+	}
+
+	IRemap::IRemap( const Image& warp ) :
+		_width( 0 ),
+		_height( 0 )
+	{
+		update( warp );
+	}
+
+	void IRemap::update( const Image& warp )
+	{
+		if( warp.format() != IFormat::GRAYALPHA_FLOAT )
+			throw CVTException( "Unsupported warp image type" );
+
+		_width = warp.width();
+		_height = warp.height();
+		_xy.resize( 2 * _width * _height );
+		_frac.resize( _width * _height );
+		if( !_width || !_height )
+			return;
+
+		IMapScoped<const float> map( warp );
+		int16_t* xy = &_xy[ 0 ];
+		uint16_t* frac = &_frac[ 0 ];
+		for( size_t y = 0; y < _height; y++ ) {
+			const float* coords = map.ptr();
+			for( size_t x = 0; x < _width; x++ ) {
+				/* positions far outside are clamped, they are outside of every valid source image */
+				float fx = Math::clamp( coords[ 2 * x ] * 32.0f, -64.0f, 1048544.0f );
+				float fy = Math::clamp( coords[ 2 * x + 1 ] * 32.0f, -64.0f, 1048544.0f );
+				int ix = ( int ) Math::floor( fx + 0.5f );
+				int iy = ( int ) Math::floor( fy + 0.5f );
+				*xy++ = ( int16_t ) ( ix >> 5 );
+				*xy++ = ( int16_t ) ( iy >> 5 );
+				*frac++ = ( uint16_t ) ( ( ix & 0x1f ) | ( ( iy & 0x1f ) << 5 ) );
+			}
+			map++;
+		}
+	}
+
+	void IRemap::check( const Image& src, const IRemap& map )
+	{
+		if( !map._width || !map._height )
+			throw CVTException( "IRemap: map not initialized" );
+		if( src.width() >= 0x8000 || src.height() >= 0x8000 )
+			throw CVTException( "IRemap: source image too large" );
+
+		switch( src.format().formatID ) {
+			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_GRAY_UINT8:
+			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_BGRA_FLOAT:
+			case IFORMAT_RGBA_UINT8:
+			case IFORMAT_BGRA_UINT8:
+				break;
+			default:
+				throw CVTException( "Unsupported image format" );
+		}
+	}
+
+	void IRemap::applyRows( uint8_t* dst, size_t dstride, const uint8_t* src, size_t sstride,
+							size_t srcWidth, size_t srcHeight, const IFormat& format,
+							size_t ystart, size_t yend ) const
+	{
+		SIMD* simd = SIMD::instance();
+		const float black[ ] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		for( size_t y = ystart; y < yend; y++ ) {
+			uint8_t* d = dst + y * dstride;
+			switch( format.formatID ) {
+				case IFORMAT_GRAY_FLOAT:
+					simd->remapBilinear1f( ( float* ) d, positions( y ), fractions( y ), ( const float* ) src, sstride, srcWidth, srcHeight, 0.0f, _width );
+					break;
+				case IFORMAT_GRAY_UINT8:
+					simd->remapBilinear1u8( d, positions( y ), fractions( y ), src, sstride, srcWidth, srcHeight, 0, _width );
+					break;
+				case IFORMAT_RGBA_FLOAT:
+				case IFORMAT_BGRA_FLOAT:
+					simd->remapBilinear4f( ( float* ) d, positions( y ), fractions( y ), ( const float* ) src, sstride, srcWidth, srcHeight, black, _width );
+					break;
+				case IFORMAT_RGBA_UINT8:
+				case IFORMAT_BGRA_UINT8:
+					simd->remapBilinear4u8( d, positions( y ), fractions( y ), src, sstride, srcWidth, srcHeight, 0xff000000, _width );
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	void IRemap::apply( Image& dst, const Image& src ) const
+	{
+		check( src, *this );
+		dst.reallocate( _width, _height, src.format() );
+
+		IMapScoped<uint8_t> mapdst( dst );
+		IMapScoped<const uint8_t> mapsrc( src );
+		RemapBand band( *this, mapdst.base(), mapdst.stride(), mapsrc.base(), mapsrc.stride(), src.width(), src.height(), src.format() );
+		ParallelFor::run( band, 0, _height, 16 );
+	}
+
+	void IRemap::apply( Image& dst0, const Image& src0, const IRemap& map0,
+						Image& dst1, const Image& src1, const IRemap& map1 )
+	{
+		check( src0, map0 );
+		check( src1, map1 );
+		dst0.reallocate( map0._width, map0._height, src0.format() );
+		dst1.reallocate( map1._width, map1._height, src1.format() );
+
+		IMapScoped<uint8_t> mapdst0( dst0 );
+		IMapScoped<const uint8_t> mapsrc0( src0 );
+		IMapScoped<uint8_t> mapdst1( dst1 );
+		IMapScoped<const uint8_t> mapsrc1( src1 );
+		RemapBand band0( map0, mapdst0.base(), mapdst0.stride(), mapsrc0.base(), mapsrc0.stride(), src0.width(), src0.height(), src0.format() );
+		RemapBand band1( map1, mapdst1.base(), mapdst1.stride(), mapsrc1.base(), mapsrc1.stride(), src1.width(), src1.height(), src1.format() );
+		RemapBandPair pair( band0, map0._height, band1 );
+		ParallelFor::run( pair, 0, map0._height + map1._height, 16 );
+	}
+
+}
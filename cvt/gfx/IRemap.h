@@ -0,0 +1,87 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_IREMAP_H
+#define CVT_IREMAP_H
+
+#include <cvt/gfx/Image.h>
+#include <vector>
+
+namespace cvt {
+
+	/**
+	  @brief Precomputed fixed-point remap.
+
+	  Converts a GRAYALPHA_FLOAT warp image ( as created by IWarp::warpUndistort or
+	  StereoCameraCalibration::undistortRectify ) once into a compact map with int16 source
+	  positions and 5-bit fractional weights. The map is applied with bilinear interpolation to
+	  GRAY_UINT8, GRAY_FLOAT, RGBA/BGRA_UINT8 and RGBA/BGRA_FLOAT images, samples outside of the
+	  source are black. The interpolation positions are quantized to 1/32 pixel, the source images
+	  have to be smaller than 32768 pixels in each dimension.
+	 */
+	class IRemap {
+		public:
+			IRemap();
+			IRemap( const Image& warp );
+
+			void			update( const Image& warp );
+
+			size_t			width() const  { return _width; }
+			size_t			height() const { return _height; }
+
+			/* the interleaved ( x, y ) source positions and the fractions of row y */
+			const int16_t*	positions( size_t y ) const { return &_xy[ 2 * y * _width ]; }
+			const uint16_t*	fractions( size_t y ) const { return &_frac[ y * _width ]; }
+
+			/**
+			  @brief Remap src to dst, dst is reallocated to the size of the map with the format of src.
+			 */
+			void			apply( Image& dst, const Image& src ) const;
+
+			/**
+			  @brief Remap two images in one parallel pass, e.g. the left and right image of a stereo pair.
+			 */
+			static void		apply( Image& dst0, const Image& src0, const IRemap& map0,
+								   Image& dst1, const Image& src1, const IRemap& map1 );
+
+			/**
+			  @brief Remap the rows [ ystart, yend ) of the mapped src to dst + y * dstride.
+			 */
+			void			applyRows( uint8_t* dst, size_t dstride, const uint8_t* src, size_t sstride,
+									   size_t srcWidth, size_t srcHeight, const IFormat& format,
+									   size_t ystart, size_t yend ) const;
+
+		private:
+			static void		check( const Image& src, const IRemap& map );
+
+			size_t					_width;
+			size_t					_height;
+			std::vector<int16_t>	_xy;
+			std::vector<uint16_t>	_frac;
+	};
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/IRemap.h>
+#include <cvt/gfx/ifilter/IWarp.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+#include <cstring>
+
+namespace cvt {
+
+	static void _randomFill( Image& img )
+	{
+		IMapScoped<uint8_t> map( img );
+		for( size_t y = 0; y < img.height(); y++ ) {
+			uint8_t* ptr = map.ptr();
+			if( img.format().type == IFORMAT_TYPE_FLOAT ) {
+				for( size_t x = 0; x < img.width() * img.channels(); x++ )
+					( ( float* ) ptr )[ x ] = Math::rand( 0.0f, 1.0f );
+			} else {
+				for( size_t x = 0; x < img.width() * img.format().bpp; x++ )
+					ptr[ x ] = ( uint8_t ) Math::rand( 0.0f, 255.0f );
+			}
+			map++;
+		}
+	}
+
+	/* rotation around the center with positions on the 1/32 pixel grid, partially outside of the source */
+	struct _RemapRotation {
+		Vector2f operator()( const Vector2f& pt ) const
+		{
+			Vector2f p( pt.x - 40.0f, pt.y - 30.0f );
+			Vector2f r( 0.9f * p.x - 0.4f * p.y + 40.0f, 0.4f * p.x + 0.9f * p.y + 30.0f );
+			return Vector2f( Math::round( r.x * 32.0f ) / 32.0f, Math::round( r.y * 32.0f ) / 32.0f );
+		}
+	};
+
+	static bool _simdTest()
+	{
+		const size_t n = 67;
+		const size_t sw = 13, sh = 11;
+		int16_t xy[ 2 * n ];
+		uint16_t frac[ n ];
+		uint8_t src[ sw * sh * 4 ];
+		float fsrc[ sw * sh * 4 ];
+		uint8_t out[ 4 * n ], ref[ 4 * n ];
+		float fout[ 4 * n ], fref[ 4 * n ];
+		const float fill[ ] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		bool ret = true;
+
+		for( size_t i = 0; i < sw * sh * 4; i++ ) {
+			src[ i ] = ( uint8_t ) Math::rand( 0.0f, 255.0f );
+			fsrc[ i ] = Math::rand( 0.0f, 1.0f );
+		}
+		/* mostly inside, some positions at or beyond the border */
+		for( size_t i = 0; i < n; i++ ) {
+			bool border = i % 11 == 3;
+			xy[ 2 * i ] = ( int16_t ) ( border ? Math::rand( -3.0f, sw + 2.0f ) : Math::rand( 0.0f, sw - 1.5f ) );
+			xy[ 2 * i + 1 ] = ( int16_t ) ( border ? Math::rand( -3.0f, sh + 2.0f ) : Math::rand( 0.0f, sh - 1.5f ) );
+			frac[ i ] = ( uint16_t ) Math::rand( 0.0f, 1023.0f );
+		}
+
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMDType bestType = SIMD::bestSupportedType();
+		for( int st = SIMD_BASE; st <= bestType; st++ ) {
+			SIMD* simd = SIMD::get( ( SIMDType ) st );
+
+			base->remapBilinear1u8( ref, xy, frac, src, sw, sw, sh, 7, n );
+			simd->remapBilinear1u8( out, xy, frac, src, sw, sw, sh, 7, n );
+			ret &= memcmp( out, ref, n ) == 0;
+
+			base->remapBilinear4u8( ref, xy, frac, src, sw * 4, sw, sh, 0xff000000, n );
+			simd->remapBilinear4u8( out, xy, frac, src, sw * 4, sw, sh, 0xff000000, n );
+			ret &= memcmp( out, ref, 4 * n ) == 0;
+
+			base->remapBilinear1f( fref, xy, frac, fsrc, sw * sizeof( float ), sw, sh, 0.5f, n );
+			simd->remapBilinear1f( fout, xy, frac, fsrc, sw * sizeof( float ), sw, sh, 0.5f, n );
+			for( size_t i = 0; i < n; i++ )
+				ret &= Math::abs( fout[ i ] - fref[ i ] ) < 1e-6f;
+
+			base->remapBilinear4f( fref, xy, frac, fsrc, sw * 4 * sizeof( float ), sw, sh, fill, n );
+			simd->remapBilinear4f( fout, xy, frac, fsrc, sw * 4 * sizeof( float ), sw, sh, fill, n );
+			for( size_t i = 0; i < 4 * n; i++ )
+				ret &= Math::abs( fout[ i ] - fref[ i ] ) < 1e-6f;
+
+			delete simd;
+		}
+		delete base;
+		return ret;
+	}
+
+	static bool _warpTest( const IFormat& format, float eps )
+	{
+		Image src( 80, 60, format );
+		Image warp( 80, 60, IFormat::GRAYALPHA_FLOAT );
+		Image ref( 80, 60, format );
+		Image out;
+		bool ret = true;
+
+		_randomFill( src );
+		IWarp::warpGeneric( warp, _RemapRotation() );
+		IWarp::apply( ref, src, warp );
+
+		IRemap remap( warp );
+		remap.apply( out, src );
+		ret &= out.width() == ref.width() && out.height() == ref.height() && out.format() == format;
+
+		IMapScoped<const uint8_t> mout( out );
+		IMapScoped<const uint8_t> mref( ref );
+		for( size_t y = 0; y < ref.height(); y++ ) {
+			for( size_t x = 0; x < ref.width() * ref.channels(); x++ ) {
+				if( format.type == IFORMAT_TYPE_FLOAT )
+					ret &= Math::abs( ( ( const float* ) mout.ptr() )[ x ] - ( ( const float* ) mref.ptr() )[ x ] ) <= eps;
+				else
+					ret &= Math::abs( ( int ) mout.ptr()[ x ] - ( int ) mref.ptr()[ x ] ) <= eps;
+			}
+			mout++;
+			mref++;
+		}
+		return ret;
+	}
+
+	/* one image of the pair remapped in a single pass */
+	struct RemapStereo {
+		RemapStereo( const IRemap& m, const Image& l, const Image& r, bool s ) : remap( m ), left( l ), right( r ), second( s ) {}
+		void operator()( Image& out ) const
+		{
+			Image other;
+			if( second )
+				IRemap::apply( other, left, remap, out, right, remap );
+			else
+				IRemap::apply( out, left, remap, other, right, remap );
+		}
+		const IRemap&	remap;
+		const Image&	left;
+		const Image&	right;
+		bool			second;
+	};
+
+	static bool _stereoTest()
+	{
+		Image left( 80, 60, IFormat::GRAY_UINT8 );
+		Image right( 80, 60, IFormat::GRAY_UINT8 );
+		Image warp( 80, 60, IFormat::GRAYALPHA_FLOAT );
+		Image outl, outr, refl, refr;
+		bool ret;
+
+		_randomFill( left );
+		_randomFill( right );
+		IWarp::warpGeneric( warp, _RemapRotation() );
+		IRemap remap( warp );
+
+		remap.apply( refl, left );
+		remap.apply( refr, right );
+		IRemap::apply( outl, left, remap, outr, right, remap );
+
+		ret = testImagesEqual( outl, refl ) && testImagesEqual( outr, refr );
+		ret &= testThreadInvariance<Image>( RemapStereo( remap, left, right, false ), testImagesEqual );
+		ret &= testThreadInvariance<Image>( RemapStereo( remap, left, right, true ), testImagesEqual );
+		return ret;
+	}
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( remap )
+	bool result = true;
+	bool b;
+
+	b = _simdTest();
+	CVTTEST_PRINT( "SIMD kernels", b );
+	result &= b;
+
+	b = _warpTest( IFormat::GRAY_FLOAT, 1e-5f );
+	CVTTEST_PRINT( "GRAY_FLOAT compared to IWarp", b );
+	result &= b;
+
+	/* IWarp truncates after both interpolation steps, the remap rounds */
+	b = _warpTest( IFormat::GRAY_UINT8, 2 );
+	CVTTEST_PRINT( "GRAY_UINT8 compared to IWarp", b );
+	result &= b;
+
+	b = _warpTest( IFormat::RGBA_UINT8, 2 );
+	CVTTEST_PRINT( "RGBA_UINT8 compared to IWarp", b );
+	result &= b;
+
+	b = _warpTest( IFormat::RGBA_FLOAT, 1e-5f );
+	CVTTEST_PRINT( "RGBA_FLOAT compared to IWarp", b );
+	result &= b;
+
+	b = _stereoTest();
+	CVTTEST_PRINT( "Stereo pair in one pass", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
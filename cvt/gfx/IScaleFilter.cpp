@@ -463,6 +463,11 @@ namespace cvt {
 		return _filter_sinc( x ) * _filter_window_blackmanharris( x / _support );
 	}
 
+	float IScaleFilterBox::eval( float x ) const
+	{
+		return Math::abs( x ) <= 0.5f ? 1.0f : 0.0f;
+	}
+
 	float IScaleFilterGauss::eval( float x ) const
 	{
 		return _filter_gauss( x, _support * 0.5f );
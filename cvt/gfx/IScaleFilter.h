@@ -115,6 +115,14 @@ namespace cvt {
 			virtual const std::string name() const { return "BlackmanHarris"; }
 	};
 
+	class IScaleFilterBox : public IScaleFilter
+	{
+		public:
+			IScaleFilterBox( float sharpsmooth = 0.0f ) : IScaleFilter( 0.5f, sharpsmooth ) {}
+			virtual float eval( float x ) const;
+			virtual const std::string name() const { return "Box"; }
+	};
+
 	class IScaleFilterGauss : public IScaleFilter
 	{
 		public:
@@ -0,0 +1,252 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/IWarpEngine.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/Exception.h>
+#include <string.h>
+
+namespace cvt {
+
+#define IWARPENGINE_TILE_WIDTH	64
+#define IWARPENGINE_TILE_HEIGHT	16
+
+	class IWarpEngineTiles {
+		public:
+			IWarpEngineTiles( uint8_t* dst, size_t dstride, size_t width, size_t height,
+							  const uint8_t* src, size_t sstride, size_t swidth, size_t sheight,
+							  const IFormat& format, IWarpInterpolation interpolation, const Color& fill,
+							  const Matrix3f* H, const IWarpCoordinates* coords ) :
+				_dst( dst ), _dstride( dstride ), _width( width ), _height( height ),
+				_src( src ), _sstride( sstride ), _swidth( swidth ), _sheight( sheight ),
+				_format( format ), _interpolation( interpolation ), _H( H ), _coords( coords )
+			{
+				_tilesx = ( width + IWARPENGINE_TILE_WIDTH - 1 ) / IWARPENGINE_TILE_WIDTH;
+
+				bool bgra = format.formatID == IFORMAT_BGRA_FLOAT || format.formatID == IFORMAT_BGRA_UINT8;
+				_fill4f[ 0 ] = bgra ? fill.blue() : fill.red();
+				_fill4f[ 1 ] = fill.green();
+				_fill4f[ 2 ] = bgra ? fill.red() : fill.blue();
+				_fill4f[ 3 ] = fill.alpha();
+				_fill1f = fill.gray();
+				_fill1u8 = ( uint8_t ) Math::clamp( _fill1f * 255.0f + 0.5f, 0.0f, 255.0f );
+				_fill4u8 = 0;
+				for( size_t c = 0; c < 4; c++ )
+					_fill4u8 |= ( uint32_t ) Math::clamp( _fill4f[ c ] * 255.0f + 0.5f, 0.0f, 255.0f ) << ( 8 * c );
+			}
+
+			size_t tiles() const
+			{
+				return _tilesx * ( ( _height + IWARPENGINE_TILE_HEIGHT - 1 ) / IWARPENGINE_TILE_HEIGHT );
+			}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				ScopedBuffer<float, true> buf( 2 * IWARPENGINE_TILE_WIDTH );
+				for( size_t t = start; t < end; t++ )
+					tile( t, buf.ptr() );
+			}
+
+		private:
+			void tile( size_t index, float* coords ) const
+			{
+				size_t x0 = ( index % _tilesx ) * IWARPENGINE_TILE_WIDTH;
+				size_t y0 = ( index / _tilesx ) * IWARPENGINE_TILE_HEIGHT;
+				size_t x1 = Math::min<size_t>( x0 + IWARPENGINE_TILE_WIDTH, _width );
+				size_t y1 = Math::min<size_t>( y0 + IWARPENGINE_TILE_HEIGHT, _height );
+				size_t n = x1 - x0;
+				size_t bpp = _format.bpp;
+
+				if( _H && outside( x0, y0, x1 - 1, y1 - 1 ) ) {
+					for( size_t y = y0; y < y1; y++ )
+						fill( _dst + y * _dstride + x0 * bpp, n );
+					return;
+				}
+
+				SIMD* simd = SIMD::instance();
+				Vector3f delta;
+				if( _H )
+					delta.set( ( *_H )[ 0 ][ 0 ], ( *_H )[ 1 ][ 0 ], ( *_H )[ 2 ][ 0 ] );
+				for( size_t y = y0; y < y1; y++ ) {
+					if( _H ) {
+						Vector3f p = *_H * Vector3f( ( float ) x0, ( float ) y, 1.0f );
+						simd->warpProjectiveCoords_f( coords, p.ptr(), delta.ptr(), n );
+					} else {
+						_coords->coordinates( coords, x0, y, n );
+					}
+					sample( _dst + y * _dstride + x0 * bpp, coords, n );
+				}
+			}
+
+			/* true if the tile maps completely outside of the source, only decided for tiles in front of the camera */
+			bool outside( size_t x0, size_t y0, size_t x1, size_t y1 ) const
+			{
+				Vector3f c[ 4 ];
+				c[ 0 ] = *_H * Vector3f( ( float ) x0, ( float ) y0, 1.0f );
+				c[ 1 ] = *_H * Vector3f( ( float ) x1, ( float ) y0, 1.0f );
+				c[ 2 ] = *_H * Vector3f( ( float ) x0, ( float ) y1, 1.0f );
+				c[ 3 ] = *_H * Vector3f( ( float ) x1, ( float ) y1, 1.0f );
+
+				bool positive = c[ 0 ].z > 0.0f;
+				float minx = 1e30f, maxx = -1e30f, miny = 1e30f, maxy = -1e30f;
+				for( size_t i = 0; i < 4; i++ ) {
+					if( Math::abs( c[ i ].z ) < Math::EPSILONF || ( c[ i ].z > 0.0f ) != positive )
+						return false;
+					float x = c[ i ].x / c[ i ].z;
+					float y = c[ i ].y / c[ i ].z;
+					minx = Math::min( minx, x );
+					maxx = Math::max( maxx, x );
+					miny = Math::min( miny, y );
+					maxy = Math::max( maxy, y );
+				}
+				/* samples with a position in [ -1, size ) touch the source, keep a margin for rounding */
+				return maxx < -2.0f || minx > ( float ) _swidth + 1.0f || maxy < -2.0f || miny > ( float ) _sheight + 1.0f;
+			}
+
+			void fill( uint8_t* dst, size_t n ) const
+			{
+				switch( _format.formatID ) {
+					case IFORMAT_GRAY_FLOAT:
+						for( size_t x = 0; x < n; x++ )
+							( ( float* ) dst )[ x ] = _fill1f;
+						break;
+					case IFORMAT_GRAY_UINT8:
+						memset( dst, _fill1u8, n );
+						break;
+					case IFORMAT_RGBA_FLOAT:
+					case IFORMAT_BGRA_FLOAT:
+						for( size_t x = 0; x < n; x++ )
+							memcpy( dst + x * 4 * sizeof( float ), _fill4f, 4 * sizeof( float ) );
+						break;
+					default:
+						for( size_t x = 0; x < n; x++ )
+							( ( uint32_t* ) dst )[ x ] = _fill4u8;
+						break;
+				}
+			}
+
+			void sample( uint8_t* dst, const float* coords, size_t n ) const
+			{
+				SIMD* simd = SIMD::instance();
+				bool cubic = _interpolation == IWARP_BICUBIC;
+
+				switch( _format.formatID ) {
+					case IFORMAT_GRAY_FLOAT:
+						if( cubic )
+							simd->warpBicubic1f( ( float* ) dst, coords, ( const float* ) _src, _sstride, _swidth, _sheight, _fill1f, n );
+						else
+							simd->warpBilinear1f( ( float* ) dst, coords, ( const float* ) _src, _sstride, _swidth, _sheight, _fill1f, n );
+						break;
+					case IFORMAT_GRAY_UINT8:
+						if( cubic )
+							simd->warpBicubic1u8( dst, coords, _src, _sstride, _swidth, _sheight, _fill1u8, n );
+						else
+							simd->warpBilinear1u8( dst, coords, _src, _sstride, _swidth, _sheight, _fill1u8, n );
+						break;
+					case IFORMAT_RGBA_FLOAT:
+					case IFORMAT_BGRA_FLOAT:
+						if( cubic )
+							simd->warpBicubic4f( ( float* ) dst, coords, ( const float* ) _src, _sstride, _swidth, _sheight, _fill4f, n );
+						else
+							simd->warpBilinear4f( ( float* ) dst, coords, ( const float* ) _src, _sstride, _swidth, _sheight, _fill4f, n );
+						break;
+					default:
+						if( cubic )
+							simd->warpBicubic4u8( dst, coords, _src, _sstride, _swidth, _sheight, _fill4u8, n );
+						else
+							simd->warpBilinear4u8( dst, coords, _src, _sstride, _swidth, _sheight, _fill4u8, n );
+						break;
+				}
+			}
+
+			uint8_t*					_dst;
+			size_t						_dstride;
+			size_t						_width, _height;
+			const uint8_t*				_src;
+			size_t						_sstride;
+			size_t						_swidth, _sheight;
+			const IFormat&				_format;
+			IWarpInterpolation			_interpolation;
+			const Matrix3f*				_H;
+			const IWarpCoordinates*		_coords;
+			size_t						_tilesx;
+			float						_fill1f;
+			float						_fill4f[ 4 ];
+			uint8_t						_fill1u8;
+			uint32_t					_fill4u8;
+	};
+
+	IWarpEngine::IWarpEngine( IWarpInterpolation interpolation, const Color& fill ) :
+		_interpolation( interpolation ),
+		_fill( fill )
+	{
+	}
+
+	IWarpEngine::~IWarpEngine()
+	{
+	}
+
+	void IWarpEngine::warp( Image& dst, const Image& src, const Matrix3f& H ) const
+	{
+		warp( dst, src, &H, NULL );
+	}
+
+	void IWarpEngine::warp( Image& dst, const Image& src, const IWarpCoordinates& coords ) const
+	{
+		warp( dst, src, NULL, &coords );
+	}
+
+	void IWarpEngine::warp( Image& dst, const Image& src, const Matrix3f* H, const IWarpCoordinates* coords ) const
+	{
+		switch( src.format().formatID ) {
+			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_GRAY_UINT8:
+			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_BGRA_FLOAT:
+			case IFORMAT_RGBA_UINT8:
+			case IFORMAT_BGRA_UINT8:
+				break;
+			default:
+				throw CVTException( "IWarpEngine: unsupported image format!" );
+		}
+		if( dst.format() != src.format() )
+			throw CVTException( "IWarpEngine: the destination needs the format of the source!" );
+		if( &dst == &src )
+			throw CVTException( "IWarpEngine: in-place warps are not supported!" );
+		if( !dst.width() || !dst.height() )
+			return;
+
+		IMapScoped<uint8_t> mapdst( dst );
+		IMapScoped<const uint8_t> mapsrc( src );
+		IWarpEngineTiles tiles( mapdst.base(), mapdst.stride(), dst.width(), dst.height(),
+								mapsrc.base(), mapsrc.stride(), src.width(), src.height(),
+								src.format(), _interpolation, _fill, H, coords );
+		ParallelFor::run( tiles, 0, tiles.tiles() );
+	}
+
+}
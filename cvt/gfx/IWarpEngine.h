@@ -0,0 +1,88 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_IWARPENGINE_H
+#define CVT_IWARPENGINE_H
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/Color.h>
+#include <cvt/math/Matrix.h>
+
+namespace cvt {
+
+	enum IWarpInterpolation {
+		IWARP_BILINEAR,
+		IWARP_BICUBIC		/* Catmull-Rom */
+	};
+
+	/**
+	  @brief Batched source positions of a generic warp.
+	 */
+	class IWarpCoordinates {
+		public:
+			virtual ~IWarpCoordinates() {}
+			/**
+			  Writes the interleaved ( x, y ) source positions of the destination pixels ( x + i, y ), 0 <= i < n.
+			  Called concurrently for different tiles.
+			 */
+			virtual void coordinates( float* coords, size_t x, size_t y, size_t n ) const = 0;
+	};
+
+	/**
+	  @brief Geometric image warps.
+
+	  dst( x ) = src( w( x ) ), where w maps destination to source pixel positions. Projective and affine
+	  transforms are evaluated along the rows without a matrix product per pixel, generic warps fill a row of
+	  source positions per call. The destination is processed in parallel tiles, tiles of a projective warp that
+	  map completely outside of the source are only filled. Samples outside of the source get the fill color.
+	  Supported are GRAY_FLOAT, GRAY_UINT8, RGBA/BGRA_FLOAT and RGBA/BGRA_UINT8 images.
+	 */
+	class IWarpEngine {
+		public:
+			IWarpEngine( IWarpInterpolation interpolation = IWARP_BILINEAR, const Color& fill = Color::BLACK );
+			~IWarpEngine();
+
+			void				setInterpolation( IWarpInterpolation interpolation ) { _interpolation = interpolation; }
+			IWarpInterpolation	interpolation() const { return _interpolation; }
+			void				setFillColor( const Color& fill ) { _fill = fill; }
+			const Color&		fillColor() const { return _fill; }
+
+			/**
+			  Warps src into the allocated dst with the format of src.
+			  @param H	transformation from destination to source pixel positions
+			 */
+			void				warp( Image& dst, const Image& src, const Matrix3f& H ) const;
+			void				warp( Image& dst, const Image& src, const IWarpCoordinates& coords ) const;
+
+		private:
+			void				warp( Image& dst, const Image& src, const Matrix3f* H, const IWarpCoordinates* coords ) const;
+
+			IWarpInterpolation	_interpolation;
+			Color				_fill;
+	};
+
+}
+
+#endif
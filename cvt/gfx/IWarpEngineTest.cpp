@@ -0,0 +1,279 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/IWarpEngine.h>
+#include <cvt/gfx/ifilter/ITransform.h>
+#include <cvt/gfx/ifilter/IWarp.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/math/Math.h>
+
+#include <vector>
+
+namespace cvt {
+
+	static bool _warpKernels()
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+		bool ret = true;
+		const size_t sw = 23, sh = 17;
+
+		std::vector<float> src1f( sw * sh ), src4f( 4 * sw * sh );
+		std::vector<uint8_t> src1u8( sw * sh ), src4u8( 4 * sw * sh );
+		for( size_t i = 0; i < sw * sh; i++ ) {
+			src1f[ i ] = Math::rand( 0.0f, 1.0f );
+			src1u8[ i ] = ( uint8_t ) Math::rand( 0, 256 );
+		}
+		for( size_t i = 0; i < 4 * sw * sh; i++ ) {
+			src4f[ i ] = Math::rand( 0.0f, 1.0f );
+			src4u8[ i ] = ( uint8_t ) Math::rand( 0, 256 );
+		}
+		const float fill4f[ 4 ] = { 0.1f, 0.2f, 0.3f, 1.0f };
+
+		for( size_t n = 1; n < 41; n++ ) {
+			std::vector<float> coords( 2 * n ), c1( 2 * n ), c2( 2 * n );
+			for( size_t i = 0; i < n; i++ ) {
+				coords[ 2 * i ] = Math::rand( -3.0f, ( float ) sw + 2.0f );
+				coords[ 2 * i + 1 ] = Math::rand( -3.0f, ( float ) sh + 2.0f );
+			}
+
+			float point[ 3 ] = { Math::rand( -5.0f, 5.0f ), Math::rand( -5.0f, 5.0f ), Math::rand( 0.5f, 2.0f ) };
+			float delta[ 3 ] = { Math::rand( -1.0f, 1.0f ), Math::rand( -1.0f, 1.0f ), Math::rand( -0.01f, 0.01f ) };
+			base->warpProjectiveCoords_f( &c1[ 0 ], point, delta, n );
+			best->warpProjectiveCoords_f( &c2[ 0 ], point, delta, n );
+			ret &= c1 == c2;
+
+			std::vector<float> d1( 4 * n ), d2( 4 * n );
+			base->warpBicubic1f( &d1[ 0 ], &coords[ 0 ], &src1f[ 0 ], sw * sizeof( float ), sw, sh, 0.5f, n );
+			best->warpBicubic1f( &d2[ 0 ], &coords[ 0 ], &src1f[ 0 ], sw * sizeof( float ), sw, sh, 0.5f, n );
+			ret &= d1 == d2;
+			base->warpBicubic4f( &d1[ 0 ], &coords[ 0 ], &src4f[ 0 ], 4 * sw * sizeof( float ), sw, sh, fill4f, n );
+			best->warpBicubic4f( &d2[ 0 ], &coords[ 0 ], &src4f[ 0 ], 4 * sw * sizeof( float ), sw, sh, fill4f, n );
+			ret &= d1 == d2;
+			base->warpBilinear4f( &d1[ 0 ], &coords[ 0 ], &src4f[ 0 ], 4 * sw * sizeof( float ), sw, sh, fill4f, n );
+			best->warpBilinear4f( &d2[ 0 ], &coords[ 0 ], &src4f[ 0 ], 4 * sw * sizeof( float ), sw, sh, fill4f, n );
+			ret &= d1 == d2;
+
+			std::vector<uint8_t> u1( 4 * n ), u2( 4 * n );
+			base->warpBicubic1u8( &u1[ 0 ], &coords[ 0 ], &src1u8[ 0 ], sw, sw, sh, 7, n );
+			best->warpBicubic1u8( &u2[ 0 ], &coords[ 0 ], &src1u8[ 0 ], sw, sw, sh, 7, n );
+			ret &= u1 == u2;
+			base->warpBicubic4u8( &u1[ 0 ], &coords[ 0 ], &src4u8[ 0 ], 4 * sw, sw, sh, 0xff102030, n );
+			best->warpBicubic4u8( &u2[ 0 ], &coords[ 0 ], &src4u8[ 0 ], 4 * sw, sw, sh, 0xff102030, n );
+			ret &= u1 == u2;
+		}
+
+		delete base;
+		delete best;
+		return ret;
+	}
+
+	static void _warpRamp( Image& img, size_t w, size_t h, IFormat format )
+	{
+		img.reallocate( w, h, format );
+		IMapScoped<uint8_t> map( img );
+		for( size_t y = 0; y < h; y++ ) {
+			for( size_t x = 0; x < w; x++ ) {
+				float v = 0.002f * x + 0.003f * y + 0.1f;
+				if( format == IFormat::GRAY_FLOAT ) {
+					( ( float* ) map.ptr() )[ x ] = v;
+				} else if( format == IFormat::RGBA_FLOAT ) {
+					for( size_t c = 0; c < 4; c++ )
+						( ( float* ) map.ptr() )[ 4 * x + c ] = v + 0.1f * c;
+				} else if( format == IFormat::GRAY_UINT8 ) {
+					map.ptr()[ x ] = ( uint8_t ) ( ( x + 2 * y ) & 0xff );
+				} else {
+					for( size_t c = 0; c < 4; c++ )
+						map.ptr()[ 4 * x + c ] = ( uint8_t ) ( ( x + 2 * y + 10 * c ) & 0xff );
+				}
+			}
+			map++;
+		}
+	}
+
+	static bool _warpEqual( const Image& a, const Image& b, float eps, size_t border = 0 )
+	{
+		if( a.width() != b.width() || a.height() != b.height() || a.format() != b.format() )
+			return false;
+		IMapScoped<const uint8_t> ma( a );
+		IMapScoped<const uint8_t> mb( b );
+		size_t n = a.width() * a.channels();
+		size_t c = a.channels();
+		bool ret = true;
+		for( size_t y = 0; y < a.height(); y++ ) {
+			if( y >= border && y + border < a.height() ) {
+				for( size_t x = border * c; x < n - border * c; x++ ) {
+					float va = a.format().type == IFORMAT_TYPE_FLOAT ? ( ( const float* ) ma.ptr() )[ x ] : ( float ) ma.ptr()[ x ];
+					float vb = b.format().type == IFORMAT_TYPE_FLOAT ? ( ( const float* ) mb.ptr() )[ x ] : ( float ) mb.ptr()[ x ];
+					ret &= Math::abs( va - vb ) <= eps;
+				}
+			}
+			ma++;
+			mb++;
+		}
+		return ret;
+	}
+
+	/* generic warp with the positions of a projective transform */
+	class WarpTestCoordinates : public IWarpCoordinates {
+		public:
+			WarpTestCoordinates( const Matrix3f& H ) : _H( H ) {}
+
+			void coordinates( float* coords, size_t x, size_t y, size_t n ) const
+			{
+				for( size_t i = 0; i < n; i++ ) {
+					Vector3f p = _H * Vector3f( ( float ) ( x + i ), ( float ) y, 1.0f );
+					*coords++ = p.x / p.z;
+					*coords++ = p.y / p.z;
+				}
+			}
+
+		private:
+			Matrix3f _H;
+	};
+
+	struct WarpHomography {
+		WarpHomography( const IWarpEngine& e, const Image& s, const Matrix3f& h ) : engine( e ), src( s ), H( h ) {}
+		void operator()( Image& dst ) const { engine.warp( dst, src, H ); }
+		const IWarpEngine&	engine;
+		const Image&		src;
+		Matrix3f			H;
+	};
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( IWarpEngine )
+	bool result = true;
+	bool b;
+
+	b = _warpKernels();
+	CVTTEST_PRINT( "SIMD warp kernels", b );
+	result &= b;
+
+	const IFormat* formats[ 4 ] = { &IFormat::GRAY_FLOAT, &IFormat::RGBA_FLOAT, &IFormat::GRAY_UINT8, &IFormat::RGBA_UINT8 };
+
+	/* the identity reproduces the image, a pure translation samples a linear ramp exactly */
+	b = true;
+	for( size_t f = 0; f < 4; f++ ) {
+		Image src, dst;
+		_warpRamp( src, 150, 70, *formats[ f ] );
+		for( int interp = 0; interp < 2; interp++ ) {
+			IWarpEngine engine( interp ? IWARP_BICUBIC : IWARP_BILINEAR );
+			dst.reallocate( src.width(), src.height(), src.format() );
+			Matrix3f H;
+			H.setIdentity();
+			engine.warp( dst, src, H );
+			b &= _warpEqual( dst, src, 0.0f );
+
+			if( src.format().type == IFORMAT_TYPE_FLOAT ) {
+				Image ref;
+				_warpRamp( ref, 150, 70, *formats[ f ] );
+				H[ 0 ][ 2 ] = 0.5f;
+				H[ 1 ][ 2 ] = 0.25f;
+				engine.warp( dst, src, H );
+				/* ramp shifted by 0.5 * 0.002 + 0.25 * 0.003 */
+				IMapScoped<float> map( ref );
+				for( size_t y = 0; y < ref.height(); y++ ) {
+					for( size_t x = 0; x < ref.width() * ref.channels(); x++ )
+						map.ptr()[ x ] += 0.00175f;
+					map++;
+				}
+				b &= _warpEqual( dst, ref, 1e-5f, 2 );
+			}
+		}
+	}
+	CVTTEST_PRINT( "identity and translation", b );
+	result &= b;
+
+	/* projective warp against the generic path, the tile skipping and the thread count */
+	b = true;
+	for( size_t f = 0; f < 4; f++ ) {
+		Image src, dst1, dst2;
+		_warpRamp( src, 120, 90, *formats[ f ] );
+		Matrix3f H( 0.9f, 0.1f, -30.0f,
+				   -0.05f, 1.1f, 10.0f,
+				    0.0005f, -0.0003f, 1.0f );
+		for( int interp = 0; interp < 2; interp++ ) {
+			IWarpEngine engine( interp ? IWARP_BICUBIC : IWARP_BILINEAR, Color( 0.2f, 0.4f, 0.6f, 1.0f ) );
+			dst1.reallocate( 300, 200, src.format() );
+			dst2.reallocate( 300, 200, src.format() );
+			engine.warp( dst1, src, H );
+			engine.warp( dst2, src, WarpTestCoordinates( H ) );
+			b &= testThreadInvariance( WarpHomography( engine, src, H ), testImagesEqual, Image( 300, 200, src.format() ) );
+			b &= _warpEqual( dst1, dst2, src.format().type == IFORMAT_TYPE_FLOAT ? 1e-3f : 2.0f );
+		}
+
+		/* far outside: only the fill color */
+		Matrix3f T;
+		T.setIdentity();
+		T[ 0 ][ 2 ] = 1000.0f;
+		IWarpEngine engine( IWARP_BILINEAR, Color::WHITE );
+		engine.warp( dst1, src, T );
+		IMapScoped<const uint8_t> map( dst1 );
+		for( size_t y = 0; y < dst1.height(); y++ ) {
+			for( size_t x = 0; x < dst1.width() * dst1.channels(); x++ )
+				b &= src.format().type == IFORMAT_TYPE_FLOAT ? ( ( const float* ) map.ptr() )[ x ] == 1.0f : map.ptr()[ x ] == 255;
+			map++;
+		}
+	}
+	CVTTEST_PRINT( "projective, generic and outside tiles", b );
+	result &= b;
+
+	/* ITransform and IWarp run on the engine */
+	{
+		Image src, dst, warp, dst2;
+		_warpRamp( src, 64, 48, IFormat::GRAY_FLOAT );
+		Matrix3f T;
+		T.setIdentity();
+		T[ 0 ][ 2 ] = 3.0f;
+		ITransform::apply( dst, src, T );
+		warp.reallocate( 64, 48, IFormat::GRAYALPHA_FLOAT );
+		{
+			IMapScoped<float> map( warp );
+			for( size_t y = 0; y < 48; y++ ) {
+				for( size_t x = 0; x < 64; x++ ) {
+					map.ptr()[ 2 * x ] = ( float ) x - 3.0f;
+					map.ptr()[ 2 * x + 1 ] = ( float ) y;
+				}
+				map++;
+			}
+		}
+		IWarp::apply( dst2, src, warp );
+		b = _warpEqual( dst, dst2, 1e-6f ) && dst.width() == 64 && dst.height() == 48;
+		IMapScoped<const float> m( dst );
+		IMapScoped<const float> ms( src );
+		b &= m.ptr()[ 0 ] == 0.0f && m.ptr()[ 1 ] == 0.0f && Math::abs( m.ptr()[ 10 ] - ms.ptr()[ 7 ] ) < 1e-6f;
+		CVTTEST_PRINT( "ITransform and IWarp", b );
+		result &= b;
+	}
+
+	return result;
+END_CVTTEST
@@ -187,6 +187,7 @@ namespace cvt {
             case IFORMAT_BAYER_RGGB_UINT8:  glformat = GL_RED; gltype = GL_UNSIGNED_BYTE; break;
             case IFORMAT_BAYER_GBRG_UINT8:  glformat = GL_RED; gltype = GL_UNSIGNED_BYTE; break;
             case IFORMAT_BAYER_GRBG_UINT8:  glformat = GL_RED; gltype = GL_UNSIGNED_BYTE; break;
+            case IFORMAT_BAYER_BGGR_UINT8:  glformat = GL_RED; gltype = GL_UNSIGNED_BYTE; break;
 
 			case IFORMAT_YUYV_UINT8:		glformat = GL_RG; gltype = GL_UNSIGNED_BYTE; break;
 			case IFORMAT_UYVY_UINT8:		glformat = GL_RG; gltype = GL_UNSIGNED_BYTE; break;
@@ -67,7 +67,7 @@ namespace cvt {
 		_height = height;
 		_format = format;
 		_stride = Math::pad16( _width * _format.bpp );
-		_mem = new uint8_t[ _stride * _height + 16 ];
+		_mem = new uint8_t[ _stride * _format.allocRows( _height ) + 16 ];
 		_data = Util::alignPtr( _mem, 16 );
 		_refcnt = new size_t;
 		*_refcnt = 0;
@@ -87,6 +87,9 @@ namespace cvt {
 		if( r )
 			rect.intersect( *r );
 
+		if( x->_format.isPlanar() && ( rect.x || rect.y || rect.width != ( int ) x->_width || rect.height != ( int ) x->_height ) )
+			throw CVTException( "Copy of sub-rectangles is not supported for planar formats" );
+
 		alloc( rect.width, rect.height, x->_format );
 
 		osrc = src = x->map( &sstride );
@@ -100,9 +103,40 @@ namespace cvt {
 			dst += _stride;
 			src += sstride;
 		}
+
+		if( _format.isPlanar() )
+			copyChroma( dst, src, sstride );
+
 		x->unmap( osrc );
 	}
 
+	void ImageAllocatorMem::copyChroma( uint8_t* dst, const uint8_t* src, size_t sstride )
+	{
+		SIMD* simd = SIMD::instance();
+		size_t h = ( _height + 1 ) >> 1;
+
+		if( _format.formatID == IFORMAT_NV12_UINT8 ) {
+			/* interleaved UV plane with full stride */
+			size_t n = ( _width + 1 ) & ~( ( size_t ) 1 );
+			while( h-- ) {
+				simd->Memcpy( dst, src, n );
+				dst += _stride;
+				src += sstride;
+			}
+		} else {
+			/* separate U and V planes with half stride */
+			size_t n = ( _width + 1 ) >> 1;
+			size_t dstride2 = _stride >> 1;
+			size_t sstride2 = sstride >> 1;
+			h <<= 1;
+			while( h-- ) {
+				simd->Memcpy( dst, src, n );
+				dst += dstride2;
+				src += sstride2;
+			}
+		}
+	}
+
 	void ImageAllocatorMem::release()
 	{
 		if( _refcnt ) {
@@ -43,6 +43,7 @@ namespace cvt {
 			ImageAllocatorMem( const ImageAllocatorMem& );
 			void retain();
 			void release();
+			void copyChroma( uint8_t* dst, const uint8_t* src, size_t sstride );
 
 		private:
 			uint8_t* _data;
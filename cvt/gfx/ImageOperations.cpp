@@ -28,6 +28,7 @@
 #include <cvt/util/Exception.h>
 #include <cvt/util/ScopedBuffer.h>
 #include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/ifilter/IntegralFilterCPU.h>
 
 #include <iomanip>
 
@@ -787,81 +788,17 @@ namespace cvt {
     {
         dst.reallocate( this->width(), this->height(), IFormat::floatEquivalent( this->format() ), _mem->type() );
 
-        size_t inStride;
-        size_t dstStride;
-
-        float* out = dst.map<float>( &dstStride );
-        SIMD* simd = SIMD::instance();
-
-        IFormatID fId = this->format().formatID;
-
-        switch ( fId ) {
-            case IFORMAT_GRAY_UINT8:
-            {
-                const uint8_t* in = this->map<uint8_t>( &inStride );
-                simd->prefixSum1_u8_to_f( out, dstStride, in, inStride, width(), height() );
-                this->unmap( in );
-            }
-            break;
-            case IFORMAT_GRAY_FLOAT:
-            {
-                const float* in = this->map<float>( &inStride );
-                simd->prefixSum1_f_to_f( out, dstStride, in, inStride, width(), height() );
-                this->unmap( in );
-            }
-            break;
-            case IFORMAT_BGRA_UINT8:
-            case IFORMAT_RGBA_UINT8:
-            {
-                const uint8_t* in = this->map<uint8_t > ( &inStride );
-                simd->prefixSum1_xxxxu8_to_f( out, dstStride, in, inStride, width( ), height( ) );
-                this->unmap( in );
-            }
-                break;
-            default:
-                this->unmap( out );
-                String msg;
-                msg.sprintf( "IntegralImage not implemented for type: %s", fId );
-                throw CVTException( msg.c_str() );
-        }
-        dst.unmap( out );
+        // uint8 values are summed as they are, not scaled to [ 0, 1 ]
+        IntegralFilterCPU::ImageSource src( *this, NULL, false );
+        IntegralFilterCPU::apply( dst, src );
     }
 
     void Image::squaredIntegralImage( Image & dst ) const
     {
         dst.reallocate( this->width(), this->height(), IFormat::floatEquivalent( this->format() ), _mem->type() );
 
-        size_t inStride;
-        size_t dstStride;
-
-        float * out = dst.map<float>( &dstStride );
-        SIMD * simd = SIMD::instance();
-
-        IFormatID fId = this->format().formatID;
-
-        switch ( fId ) {
-            case IFORMAT_GRAY_UINT8:
-            {
-                const uint8_t * in = this->map<uint8_t>( &inStride );
-                simd->prefixSumSqr1_u8_to_f( out, dstStride, in, inStride, width(), height() );
-                this->unmap( in );
-            }
-            break;
-            case IFORMAT_GRAY_FLOAT:
-            {
-                const float * in = this->map<float>( &inStride );
-                simd->prefixSumSqr1_f_to_f( out, dstStride, in, inStride, width(), height() );
-                this->unmap( in );
-            }
-            break;
-
-            default:
-                this->unmap( out );
-                String msg;
-                msg.sprintf( "Squared integralImage not implemented for type: %s", fId );
-                throw CVTException( msg.c_str() );
-        }
-        dst.unmap( out );
+        IntegralFilterCPU::ImageSource src( *this, this, false );
+        IntegralFilterCPU::apply( dst, src );
     }
 
 
@@ -148,6 +148,80 @@ namespace cvt {
 		b &= *( base + 3 ) == 1.0f;
 		CVTTEST_PRINT("BGRA FLOAT", b );
 		y.unmap( ( uint8_t* ) base );
+
+		std::cerr << "RGB UBYTE TO:" << std::endl;
+		x.reallocate( 3, 1, IFormat::RGB_UINT8 );
+		valPtr = x.map( &stride );
+		for( int i = 0; i < 3; i++ ) {
+			valPtr[ i * 3 + 0 ] = 255;
+			valPtr[ i * 3 + 1 ] = 0;
+			valPtr[ i * 3 + 2 ] = 0;
+		}
+		x.unmap( valPtr );
+
+		x.convert( y, IFormat::BGRA_UINT8 );
+		valPtr = y.map( &stride );
+		val = *( ( uint32_t* ) valPtr + 2 );
+		CVTTEST_PRINT("BGRA UBYTE", val == 0xFFFF0000 );
+		y.unmap( valPtr );
+
+		x.convert( y, IFormat::RGBA_FLOAT );
+		base = ( float* ) y.map( &stride );
+		b  = *( base + 8 ) == 1.0f;
+		b &= *( base + 9 ) == 0.0f;
+		b &= *( base + 10 ) == 0.0f;
+		b &= *( base + 11 ) == 1.0f;
+		CVTTEST_PRINT("RGBA FLOAT", b );
+		y.unmap( ( uint8_t* ) base );
+
+		x.reallocate( 3, 1, IFormat::RGBA_FLOAT );
+		x.fill( Color( 0.25f, 0.5f, 1.0f, 1.0f ) );
+		std::cerr << "RGBA FLOAT16 TO:" << std::endl;
+		x.convert( y, IFormat::RGBA_FLOAT16 );
+		y.convert( x, IFormat::RGBA_FLOAT );
+		base = ( float* ) x.map( &stride );
+		b  = *( base + 8 ) == 0.25f;
+		b &= *( base + 9 ) == 0.5f;
+		b &= *( base + 10 ) == 1.0f;
+		b &= *( base + 11 ) == 1.0f;
+		CVTTEST_PRINT("RGBA FLOAT", b );
+		x.unmap( ( uint8_t* ) base );
+
+		std::cerr << "NV12/I420 UBYTE TO:" << std::endl;
+		x.reallocate( 4, 3, IFormat::NV12_UINT8 );
+		y.reallocate( 4, 3, IFormat::I420_UINT8 );
+		{
+			size_t ystride;
+			uint8_t* nv12 = x.map( &stride );
+			uint8_t* i420 = y.map( &ystride );
+			for( size_t r = 0; r < 3; r++ ) {
+				memset( nv12 + r * stride, 255, 4 );
+				memset( i420 + r * ystride, 255, 4 );
+			}
+			/* neutral chroma */
+			memset( nv12 + 3 * stride, 128, 2 * stride );
+			memset( i420 + 3 * ystride, 128, 2 * ystride );
+			x.unmap( nv12 );
+			y.unmap( i420 );
+		}
+
+		Image z;
+		x.convert( z, IFormat::RGBA_UINT8 );
+		valPtr = z.map( &stride );
+		val = *( ( uint32_t* ) ( valPtr + 2 * stride ) + 3 );
+		CVTTEST_PRINT("NV12 -> RGBA UBYTE", val == 0xFFFFFFFF );
+		z.unmap( valPtr );
+
+		y.convert( z, IFormat::BGRA_UINT8 );
+		valPtr = z.map( &stride );
+		val = *( ( uint32_t* ) ( valPtr + 2 * stride ) + 3 );
+		CVTTEST_PRINT("I420 -> BGRA UBYTE", val == 0xFFFFFFFF );
+		z.unmap( valPtr );
+
+		y.convert( z, IFormat::GRAY_UINT8 );
+		valPtr = z.map( &stride );
+		CVTTEST_PRINT("I420 -> GRAY UBYTE", valPtr[ 2 * stride + 3 ] == 255 );
+		z.unmap( valPtr );
 		return true;
 	END_CVTTEST
 
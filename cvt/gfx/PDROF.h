@@ -27,6 +27,8 @@
 
 #include <cvt/cl/kernel/PDHuberWeighted.h>
 #include <cvt/cl/kernel/fill.h>
+#include <cvt/gfx/IFilter.h>
+#include <cvt/gfx/ifilter/TVDenoise.h>
 
 namespace cvt {
 
@@ -35,20 +37,36 @@ namespace cvt {
 		public:
 			PDROF();
 
-			void apply( Image& output, const Image& input, const Image& weight, float lambda, int iter );
+			/* the CPU version bounds the number of iterations by iter and stops once converged */
+			void apply( Image& output, const Image& input, const Image& weight, float lambda, int iter, IFilterType type = IFILTER_OPENCL );
 		private:
 			CLKernel _clfill;
 			CLKernel _clrof;
+			TVDenoise _tv;
 	};
 
-	inline PDROF::PDROF() :
-		_clfill( _fill_source, "fill" ),
-		_clrof(_PDHuberWeighted_source, "PDHuberWeighted" )
+	inline PDROF::PDROF()
 	{
 	}
 
-	inline void PDROF::apply( Image& output, const Image& input, const Image& weight, float lambda, int iter )
+	inline void PDROF::apply( Image& output, const Image& input, const Image& weight, float lambda, int iter, IFilterType type )
 	{
+		if( type == IFILTER_CPU ) {
+			/* weighted Huber-ROF with the same Huber parameter as the kernel */
+			_tv.setModel( TVMODEL_ROF );
+			_tv.setLambda( lambda );
+			_tv.setEpsilon( 0.001f );
+			_tv.setMaxIterations( iter );
+			_tv.apply( output, input, &weight );
+			return;
+		}
+
+		/* the kernels are built on first use */
+		if( ( cl_kernel ) _clrof == NULL ) {
+			_clfill = CLKernel( _fill_source, "fill" );
+			_clrof = CLKernel( _PDHuberWeighted_source, "PDHuberWeighted" );
+		}
+
 		//TODO: check image for CL and size
 		Image cltmp( input, IALLOCATOR_CL );
 		Image clp1( input.width()*2, input.height(), input.format(), IALLOCATOR_CL );
@@ -23,7 +23,7 @@
 */
 
 #include <cvt/gfx/ifilter/BoxFilter.h>
-#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/ifilter/IntegralFilterCPU.h>
 
 #include <cvt/cl/kernel/boxfilter/boxfilter_prefixsum.h>
 #include <cvt/cl/kernel/boxfilter/boxfilter.h>
@@ -40,15 +40,22 @@ namespace cvt {
 	};
 
 	BoxFilter::BoxFilter() :
-		IFilter( "BoxFilter", _params, 3, IFILTER_CPU | IFILTER_OPENCL ),
-		_clboxfilter_prefixsum( _boxfilter_prefixsum_source, "boxfilter_prefixsum" ),
-		_clboxfilter( _boxfilter_source, "boxfilter" )
+		IFilter( "BoxFilter", _params, 3, IFILTER_CPU | IFILTER_OPENCL )
 	{
 	}
 
+	void BoxFilter::initCL() const
+	{
+		if( ( cl_kernel ) _clboxfilter_prefixsum != NULL )
+			return;
+		_clboxfilter_prefixsum = CLKernel( _boxfilter_prefixsum_source, "boxfilter_prefixsum" );
+		_clboxfilter = CLKernel( _boxfilter_source, "boxfilter" );
+	}
+
 	void BoxFilter::apply( Image& dst, const Image& src, const int radius, IFilterType type ) const
 	{
 		if( type == IFILTER_OPENCL ) {
+			initCL();
 			// FIXME: integrate IntegralFilter
 			dst.reallocate( src.width(), src.height(), dst.format(), IALLOCATOR_CL );
 			CLNDRange global( Math::pad16( src.width() ), Math::pad16( src.height() ) );
@@ -65,17 +72,7 @@ namespace cvt {
 				_clboxfilter.runWait( global, CLNDRange( 16, 16 ) );
 			}*/
 		} else {
-			dst.reallocate( src.width(), src.height(), dst.format() );
-			if( src.format().formatID == IFORMAT_GRAY_FLOAT && dst.format().formatID == IFORMAT_GRAY_FLOAT ) {
-				cvt::IMapScoped<float> mapdst( dst );
-				cvt::IMapScoped<const float> mapsrc( src );
-				SIMD::instance()->boxFilterPrefixSum1_f_to_f( mapdst.ptr(), mapdst.stride(), mapsrc.ptr(), mapsrc.stride(), dst.width(), dst.height(), 2*radius+1, 2*radius+1 );
-			} else if( src.format().formatID == IFORMAT_GRAY_FLOAT && dst.format().formatID == IFORMAT_GRAY_UINT8 ) {
-				cvt::IMapScoped<uint8_t> mapdst( dst );
-				cvt::IMapScoped<const float> mapsrc( src );
-				SIMD::instance()->boxFilterPrefixSum1_f_to_u8( mapdst.ptr(), mapdst.stride(), mapsrc.ptr(), mapsrc.stride(), dst.width(), dst.height(), 2*radius+1, 2*radius+1 );
-			} else
-				throw CVTException( "Unsupported image format!" );
+			IntegralFilterCPU::boxFilter( dst, src, radius );
 		}
 	}
 
@@ -88,7 +85,8 @@ namespace cvt {
 
 		switch ( t ) {
 			case IFILTER_OPENCL:
-				this->apply( *out, *in, radius );
+			case IFILTER_CPU:
+				this->apply( *out, *in, radius, t );
 				break;
 			default:
 				throw CVTException( "Not implemented" );
@@ -32,12 +32,18 @@ namespace cvt {
 	class BoxFilter : public IFilter {
 		public:
 			BoxFilter();
+			/**
+			  Mean of the ( 2 * r + 1 )^2 window, src is the summed area table of the image
+			  ( e.g. from IntegralFilter or Image::integralImage ).
+			 */
 			void apply( Image& dst, const Image& src, const int r, IFilterType = IFILTER_CPU ) const;
 			void apply( const ParamSet* set, IFilterType t = IFILTER_CPU ) const;
 
 		private:
-			CLKernel _clboxfilter_prefixsum;
-			CLKernel _clboxfilter;
+			void initCL() const;
+
+			mutable CLKernel _clboxfilter_prefixsum;
+			mutable CLKernel _clboxfilter;
 	};
 }
 
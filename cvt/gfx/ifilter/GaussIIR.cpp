@@ -29,6 +29,10 @@
 #include <cvt/cl/kernel/gaussiir.h>
 #include <cvt/cl/kernel/gaussiir2.h>
 #include <cvt/math/Fixed.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
 
 
 namespace cvt {
@@ -249,290 +253,228 @@ namespace cvt {
 		_kernelIIR2->run( CLNDRange( Math::pad16( w ) ), _kernelIIR->bestLocalRange1d( CLNDRange( Math::pad16( w ) ) ) );
 	}
 
-	void GaussIIR::applyCPUf( Image& dst, const Image& src, const Vector4f & n, const Vector4f & m, const Vector4f & d ) const
+	/* horizontal pass: causal and anti-causal filtering of each row into the float buffer,
+	   single channel images filter 4 rows at once as interleaved lanes */
+	class GaussIIRHorizontal
 	{
-		float b1 = ( n[ 0 ] + n[ 1 ] + n[ 2 ] + n[ 3 ] ) / ( d[ 0 ] + d[ 1 ] + d[ 2 ] + d[ 3 ] + 1.0f );
-		float b2 = ( m[ 0 ] + m[ 1 ] + m[ 2 ] + m[ 3 ] ) / ( d[ 0 ] + d[ 1 ] + d[ 2 ] + d[ 3 ] + 1.0f );
-
-		size_t sstride, dstride;
-		const float * inTmp = src.map<float>( &sstride );
-		float * outTmp = dst.map<float>( &dstride );
-		const float * in = inTmp;
-		float * out = outTmp;
-
-		uint32_t h = dst.height();
-		uint32_t w = dst.width();
-		uint32_t channels = dst.channels();
-
-		/* last four values */
-		const float* x;
-		float* y;
-
-		float tmpLine[ channels * w ];
-		float * tmpBuf = tmpLine + channels * ( w - 1 );
-
-		// horizontal pass
-		for( uint32_t k = 0; k < h; k++ ){
-			x = in;
-			y = out;
-
-			for( uint32_t c = 0; c < channels; c++ ){
-				y[ c ] = n[ 0 ] * x[ c ] + n[ 1 ] * x[ c ] + n[ 2 ] * x[ c ] + n[ 3 ] * x[ c ]
-				- b1 * ( d[ 0 ] * x[ c ] + d[ 1 ] * x[ c ] + d[ 2 ] * x[ c ] + d[ 3 ] * x[ c ] );
-
-				y[ c + channels  ] = n[ 0 ] * x[ c + channels ] + n[ 1 ] * x[ c ] + n[ 2 ] * x[ c ] + n[ 3 ] * x[ c ]
-				- d[ 0 ] * y[ c ] - b1 * ( d[ 1 ] * x[ c ] + d[ 2 ] * x[ c ] + d[ 3 ] * x[ c ] );
-
-				y[ c + 2 * channels ] = n[ 0 ] * x[ c + 2 * channels ] + n[ 1 ] * x[ c + channels ] + n[ 2 ] * x[ c ] + n[ 3 ] * x[ c ]
-				- d[ 0 ] * y[ c + channels ] - d[ 1 ] * y[ c ] - b1 * (  d[ 2 ] * x[ c ] + d[ 3 ] * x[ c ] );
-
-				y[ c + 3 * channels ] = n[ 0 ] * x[ c + 3 * channels ] + n[ 1 ] * x[ c + 2 * channels ] + n[ 2 ] * x[ c + channels ] + n[ 3 ] * x[ c ]
-				- d[ 0 ] * y[ c + 2 * channels ] - d[ 1 ] * y[ c + channels ] - d[ 2 ] * y[ c ] - b1 * d[ 3 ] * x[ c ];
+		public:
+			GaussIIRHorizontal( float* buf, const uint8_t* src, size_t sstride, const IFormat& format, size_t width, size_t height,
+								const float* n, const float* m, const float* d, float b1, float b2 ) :
+				_buf( buf ), _src( src ), _sstride( sstride ), _format( format ), _width( width ), _height( height ),
+				_n( n ), _m( m ), _d( d ), _b1( b1 ), _b2( b2 )
+			{
 			}
 
-			// forward pass
-			for( uint32_t i = 4; i < w; i++ ){
-				x+=channels; /* last 4 pixels, x[ 3*channels ] is current pixel */
-
-				for( uint32_t c = 0; c < channels; c++ ){
-					y[ 4 * channels + c ] = n[ 0 ] * x[ 3 * channels + c ] + n[ 1 ] * x[ 2 * channels + c ] + n[ 2 ] * x[ channels + c ] + n[ 3 ] * x[ c ]
-					- d[ 0 ] * y[ 3 * channels + c ] - d[ 1 ] * y[ 2 * channels + c ] - d[ 2 ] * y[ channels + c ] - d[ 3 ] * y[ c ];
+			void operator()( size_t start, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t channels = _format.channels;
+				const size_t rowsize = channels * _width;
+				ScopedBuffer<float, true> scratch( 8 * _width + ( _format.type == IFORMAT_TYPE_UINT8 ? 4 * rowsize : 0 ) );
+				float* lanes = scratch.ptr();
+				float* result = lanes + 4 * _width;
+				float* conv = result + 4 * _width;
+
+				for( size_t i = start; i < end; i++ ) {
+					if( channels == 4 ) {
+						simd->IIR4Horizontal4f( _buf + i * rowsize, row( i, conv ), _width, _n, _m, _d, _b1, _b2 );
+						continue;
+					}
+
+					/* gather 4 rows, the last group repeats the final row */
+					const float* rows[ 4 ];
+					for( size_t k = 0; k < 4; k++ )
+						rows[ k ] = row( Math::min( 4 * i + k, _height - 1 ), conv + k * rowsize );
+
+					float* l = lanes;
+					for( size_t x = 0; x < _width; x++ ) {
+						l[ 0 ] = rows[ 0 ][ x ];
+						l[ 1 ] = rows[ 1 ][ x ];
+						l[ 2 ] = rows[ 2 ][ x ];
+						l[ 3 ] = rows[ 3 ][ x ];
+						l += 4;
+					}
+
+					simd->IIR4Horizontal4f( result, lanes, _width, _n, _m, _d, _b1, _b2 );
+
+					size_t num = Math::min<size_t>( 4, _height - 4 * i );
+					for( size_t k = 0; k < num; k++ ) {
+						float* dst = _buf + ( 4 * i + k ) * rowsize;
+						const float* r = result + k;
+						for( size_t x = 0; x < _width; x++ ) {
+							dst[ x ] = *r;
+							r += 4;
+						}
+					}
 				}
-				y+=channels;
 			}
 
-			// backward border init:
-			x = ( in + channels * ( w - 1 ) );
-			y = ( out + channels * ( w - 1 ) );
-			for( uint32_t c = 0; c < channels; c++ ){
-				tmpBuf[ c ] = m[ 0 ] * x[ c ] + m[ 1 ] * x[ c ] + m[ 2 ] * x[ c ] + m[ 3 ] * x[ c ]
-				- b2 * ( d[ 0 ] * x[ c ] + d[ 1 ] * x[ c ] + d[ 2 ] * x[ c ] + d[ 3 ] * x[ c ] );
+			size_t size() const
+			{
+				return _format.channels == 4 ? _height : ( _height + 3 ) >> 2;
+			}
 
-				*( tmpBuf - channels + c ) = m[ 0 ] * *( x - channels + c ) + m[ 1 ] * x[ c ] + m[ 2 ] * x[ c ] + m[ 3 ] * x[ c ]
-				- d[ 0 ] * tmpBuf[ c ] - b2 * ( d[ 1 ] * x[ c ] + d[ 2 ] * x[ c ] + d[ 3 ] * x[ c ] );
+		private:
+			const float* row( size_t y, float* conv ) const
+			{
+				const uint8_t* line = _src + y * _sstride;
+				if( _format.type == IFORMAT_TYPE_FLOAT )
+					return ( const float* ) line;
+				SIMD::instance()->Conv_u8_to_f( conv, line, _format.channels * _width );
+				return conv;
+			}
 
-				*( tmpBuf - 2 * channels + c ) = m[ 0 ] * *( x - 2 * channels + c ) + m[ 1 ] * *( x - channels + c ) + m[ 2 ] * x[ c ] + m[ 3 ] * x[ c ]
-				- d[ 0 ] * *( tmpBuf - channels + c ) - d[ 1 ] * tmpBuf[ c ] - b2 * (  d[ 2 ] * x[ c ] + d[ 3 ] * x[ c ] );
+			float*			_buf;
+			const uint8_t*	_src;
+			size_t			_sstride;
+			const IFormat&	_format;
+			size_t			_width, _height;
+			const float*	_n;
+			const float*	_m;
+			const float*	_d;
+			float			_b1, _b2;
+	};
 
-				*( tmpBuf - 3 * channels + c ) = m[ 0 ] * *( x - 3 * channels + c ) + m[ 1 ] * *( x - 2 * channels + c ) + m[ 2 ] * *( x - channels + c ) + m[ 3 ] * x[ c ]
-				- d[ 0 ] * *( tmpBuf - 2 * channels + c ) - d[ 1 ] * *( tmpBuf - channels + c ) - d[ 2 ] * tmpBuf[ c ] - b2 * d[ 3 ] * x[ c ];
+	/* vertical pass over strips of columns of the horizontal result */
+	static const size_t STRIP = 256;
 
-				y[ c ] += tmpBuf[ c ];
-				*( y - channels + c ) += *( tmpBuf - channels + c );
-				*( y - 2 * channels + c ) += *( tmpBuf - 2 * channels + c );
-				*( y - 3 * channels + c ) += *( tmpBuf - 3 * channels + c );
+	class GaussIIRVertical
+	{
+		public:
+			GaussIIRVertical( uint8_t* dst, size_t dstride, const float* buf, const IFormat& format, size_t width, size_t height,
+							  const float* n, const float* m, const float* d, float b1, float b2 ) :
+				_dst( dst ), _dstride( dstride ), _buf( buf ), _format( format ), _rowsize( format.channels * width ), _height( height ),
+				_n( n ), _m( m ), _d( d ), _b1( b1 ), _b2( b2 )
+			{
 			}
 
-			// backward pass
-			y -= ( 4 * channels );
-			for (int i = w-4; i > 0; i--) {
-				x-=channels;
-				for( uint32_t c = 0; c < channels; c++ ){
-					*( tmpBuf - 4 * channels + c ) = ( m[ 0 ] * *( x - 3 * channels + c ) + m[ 1 ] * *( x - 2 * channels + c ) + m[ 2 ] * *( x - channels + c ) + m[ 3 ] * x[ c ]
-					- d[ 0 ] * *( tmpBuf - 3 * channels + c ) - d[ 1 ] * *( tmpBuf - 2 * channels + c ) - d[ 2 ] * *( tmpBuf - channels + c ) - d[ 3 ] * tmpBuf[ c ] );
-					y[ c ] += *( tmpBuf - 4 * channels + c );
+			void operator()( size_t start, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t h = _height;
+				ScopedBuffer<float, true> scratch( STRIP * ( h + 7 ) );
+				float* causal = scratch.ptr();
+				float* ring = causal + STRIP * h;
+				float* init1 = ring + 5 * STRIP;
+				float* init2 = init1 + STRIP;
+				const float* x[ 4 ];
+				const float* y[ 4 ];
+
+				for( size_t strip = start; strip < end; strip++ ) {
+					const size_t c0 = strip * STRIP;
+					const size_t len = Math::min( STRIP, _rowsize - c0 );
+
+					/* causal, the rows above the image are the steady state of the first row */
+					simd->MulValue1f( init1, col( 0, c0 ), _b1, len );
+					for( size_t r = 0; r < h; r++ ) {
+						for( size_t k = 0; k < 4; k++ ) {
+							x[ k ] = col( r >= k ? r - k : 0, c0 );
+							y[ k ] = r >= k + 1 ? causal + ( r - k - 1 ) * STRIP : init1;
+						}
+						simd->IIR4Vertical_f( causal + r * STRIP, x, y, _n, _d, len );
+					}
+
+					/* anti-causal, sum up both directions and store */
+					simd->MulValue1f( init2, col( h - 1, c0 ), _b2, len );
+					for( size_t r = h; r-- > 0; ) {
+						for( size_t k = 0; k < 4; k++ ) {
+							x[ k ] = col( Math::min( r + k + 1, h - 1 ), c0 );
+							y[ k ] = r + k + 1 < h ? ring + ( ( r + k + 1 ) % 5 ) * STRIP : init2;
+						}
+						float* cur = ring + ( r % 5 ) * STRIP;
+						simd->IIR4Vertical_f( cur, x, y, _m, _d, len );
+
+						uint8_t* line = _dst + r * _dstride;
+						if( _format.type == IFORMAT_TYPE_FLOAT ) {
+							simd->Add( ( float* ) line + c0, causal + r * STRIP, cur, len );
+						} else {
+							simd->Add( causal + r * STRIP, causal + r * STRIP, cur, len );
+							simd->Conv_f_to_u8( line + c0, causal + r * STRIP, len );
+						}
+					}
 				}
-				tmpBuf-=channels;
 			}
 
-			in += sstride;
-			out += dstride;
-		}
-
-		// vertical pass
-		const float * x0 = inTmp;
-		const float * x1 = x0 + sstride;
-		const float * x2 = x1 + sstride;
-		const float * x3 = x2 + sstride;
-		float * y0 = outTmp;
-		float * y1 = y0 + dstride;
-		float * y2 = y1 + dstride;
-		float * y3 = y2 + dstride;
-		for( size_t i = 0; i < w; i++ ){
-			for( uint32_t c = 0; c < channels; c++ ){
-				y0[ c ] = n[ 0 ] * x0[ c ] + n[ 1 ] * x0[ c ] + n[ 2 ] * x0[ c ] + n[ 3 ] * x0[ c ]
-				- b1 * ( d[ 0 ] * x0[ c ] + d[ 1 ] * x0[ c ] + d[ 2 ] * x0[ c ] + d[ 3 ] * x0[ c ] );
-
-				y1[ c ] = n[ 0 ] * x1[ c ] + n[ 1 ] * x0[ c ] + n[ 2 ] * x0[ c ] + n[ 3 ] * x0[ c ]
-				- d[ 0 ] * y0[ c ] - b1 * ( d[ 1 ] * x0[ c ] + d[ 2 ] * x0[ c ] + d[ 3 ] * x0[ c ] );
-
-				y2[ c ] = n[ 0 ] * x2[ c ] + n[ 1 ] * x1[ c ] + n[ 2 ] * x0[ c ] + n[ 3 ] * x0[ c ]
-				- d[ 0 ] * y1[ c ] - d[ 1 ] * y0[ c ] - b1 * (  d[ 2 ] * x0[ c ] + d[ 3 ] * x0[ c ] );
-
-				y3[ c ] = n[ 0 ] * x3[ c ] + n[ 1 ] * x2[ c ] + n[ 2 ] * x1[ c ] + n[ 3 ] * x0[ c ]
-				- d[ 0 ] * y2[ c ] - d[ 1 ] * y1[ c ] - d[ 2 ] * y0[ c ] - b1 * d[ 3 ] * x0[ c ];
+			size_t size() const
+			{
+				return ( _rowsize + STRIP - 1 ) / STRIP;
 			}
-			x0+=channels; x1+=channels; x2+=channels; x3+=channels;
-			y0+=channels; y1+=channels; y2+=channels; y3+=channels;
-		}
 
-		float * currOut;
-		// from fourth line to end:
-		for( uint32_t i = 4; i < h; i++ ){
-			x0 = inTmp + i * sstride;
-			x1 = x0 + sstride;
-			x2 = x1 + sstride;
-			x3 = x2 + sstride;
-
-			y0 = outTmp + ( i - 4 ) * dstride;
-			y1 = y0 + dstride;
-			y2 = y1 + dstride;
-			y3 = y2 + dstride;
-			currOut = y3 + dstride;
-
-			for( uint32_t j = 0; j < w; j++ ){
-				for( uint32_t c = 0; c < channels; c++ ){
-					currOut[ c ] = n[ 0 ] * x3[ c ] + n[ 1 ] * x2[ c ] + n[ 2 ] * x1[ c ] + n[ 3 ] * x0[ c ]
-					- d[ 0 ] * y3[ c ] - d[ 1 ] * y2[ c ] - d[ 2 ] * y1[ c ] - d[ 3 ] * y0[ c ];
-				}
-				x0+=channels; x1+=channels; x2+=channels; x3+=channels;
-				y0+=channels; y1+=channels; y2+=channels; y3+=channels;
-				currOut+=channels;
+		private:
+			const float* col( size_t y, size_t c0 ) const
+			{
+				return _buf + y * _rowsize + c0;
 			}
-		}
 
-		x0 = inTmp + ( h - 1 ) * sstride;
-		x1 = x0 - sstride;
-		x2 = x1 - sstride;
-		x3 = x2 - sstride;
-
-		float tmpBuffer[ 4 * w * channels ];
-		y0 = outTmp + ( h - 1 ) * dstride;
-		y1 = y0 - dstride;
-		y2 = y1 - dstride;
-		y3 = y2 - dstride;
-
-		float * t0 = ( tmpBuffer + 3 * w * channels );
-		float * t1 = ( tmpBuffer + 2 * w * channels );
-		float * t2 = ( tmpBuffer + 1 * w * channels );
-		float * t3 = ( tmpBuffer );
-
-		for( size_t i = 0; i < w; i++ ){
-			for( uint32_t c = 0; c < channels; c++ ){
-				t0[ c ] = m[ 0 ] * x0[ c ] + m[ 1 ] * x0[ c ] + m[ 2 ] * x0[ c ] + m[ 3 ] * x0[ c ]
-				- b1 * ( d[ 0 ] * x0[ c ] + d[ 1 ] * x0[ c ] + d[ 2 ] * x0[ c ] + d[ 3 ] * x0[ c ] );
-				y0[ c ] += t0[ c ];
-
-				t1[ c ] = m[ 0 ] * x1[ c ] + m[ 1 ] * x0[ c ] + m[ 2 ] * x0[ c ] + m[ 3 ] * x0[ c ]
-				- d[ 0 ] * t0[ c ] - b1 * ( d[ 1 ] * x0[ c ] + d[ 2 ] * x0[ c ] + d[ 3 ] * x0[ c ] );
-				y1[ c ] += t1[ c ];
-
-				t2[ c ] = m[ 0 ] * x2[ c ] + m[ 1 ] * x1[ c ] + m[ 2 ] * x0[ c ] + m[ 3 ] * x0[ c ]
-				- d[ 0 ] * t1[ c ] - d[ 1 ] * t0[ c ] - b1 * (  d[ 2 ] * x0[ c ] + d[ 3 ] * x0[ c ] );
-				y2[ c ] += t2[ c ];
-
-				t3[ c ] = m[ 0 ] * x3[ c ] + m[ 1 ] * x2[ c ] + m[ 2 ] * x1[ c ] + m[ 3 ] * x0[ c ]
-				- d[ 0 ] * t2[ c ] - d[ 1 ] * t1[ c ] - d[ 2 ] * t0[ c ] - b1 * d[ 3 ] * x0[ c ];
-				y3[ c ] += t3[ c ];
-			}
-			x0+=channels; x1+=channels; x2+=channels; x3+=channels;
-			y0+=channels; y1+=channels; y2+=channels; y3+=channels;
-			t0+=channels; t1+=channels; t2+=channels; t3+=channels;
-		}
+			uint8_t*		_dst;
+			size_t			_dstride;
+			const float*	_buf;
+			const IFormat&	_format;
+			size_t			_rowsize, _height;
+			const float*	_n;
+			const float*	_m;
+			const float*	_d;
+			float			_b1, _b2;
+	};
 
-		float* tmp;
-		t0 = ( tmpBuffer + 3 * w * channels );
-		t1 = ( tmpBuffer + 2 * w * channels );
-		t2 = ( tmpBuffer + 1 * w * channels );
-		t3 = ( tmpBuffer );
-		for( uint32_t i = h - 4; i > 0; i-- ){
-			x0 = inTmp + ( i + 2 ) * sstride;
-			x1 = x0 - sstride;
-			x2 = x1 - sstride;
-			x3 = x2 - sstride;
-
-			currOut = outTmp + ( i - 1 ) * dstride;
-
-			for( uint32_t j = 0; j < w; j++ ){
-				for( uint32_t c = 0; c < channels; c++ ){
-					t0[ j * channels + c ] = n[ 0 ] * x3[ c ] + n[ 1 ] * x2[ c ] + n[ 2 ] * x1[ c ] + n[ 3 ] * x0[ c ]
-					- d[ 0 ] * t3[ j * channels + c ] - d[ 1 ] * t2[ j * channels + c ] - d[ 2 ] * t1[ j * channels + c ] - d[ 3 ] * t0[ j * channels + c ];
-					currOut[ c ] += t0[ j * channels + c ];
-				}
+	static void _GaussIIRCPU( Image& dst, const Image& src, const Vector4f & _n, const Vector4f & _m, const Vector4f & _d )
+	{
+		const IFormat& format = src.format();
+		if( ( format.channels != 1 && format.channels != 4 ) ||
+			( format.type != IFORMAT_TYPE_FLOAT && format.type != IFORMAT_TYPE_UINT8 ) )
+			throw CVTException( "GaussIIR CPU not implemented for given Image format" );
+
+		const size_t w = src.width();
+		const size_t h = src.height();
+		if( !w || !h )
+			return;
+
+		float n[ 4 ], m[ 4 ], d[ 4 ];
+		for( size_t i = 0; i < 4; i++ ) {
+			n[ i ] = _n[ i ];
+			m[ i ] = _m[ i ];
+			d[ i ] = _d[ i ];
+		}
+		float b1 = ( n[ 0 ] + n[ 1 ] + n[ 2 ] + n[ 3 ] ) / ( d[ 0 ] + d[ 1 ] + d[ 2 ] + d[ 3 ] + 1.0f );
+		float b2 = ( m[ 0 ] + m[ 1 ] + m[ 2 ] + m[ 3 ] ) / ( d[ 0 ] + d[ 1 ] + d[ 2 ] + d[ 3 ] + 1.0f );
 
-				// next pixel of row
-				x0+=channels; x1+=channels; x2+=channels; x3+=channels;
-				currOut+=channels;
-			}
-			tmp = t0;
-			t0 = t1; t1 = t2; t2 = t3; t3 = tmp;
+		/* the horizontal result is complete before dst is touched, so dst may be src */
+		ScopedBuffer<float, true> buf( w * h * format.channels );
+		{
+			IMapScoped<const uint8_t> map( src );
+			GaussIIRHorizontal horizontal( buf.ptr(), map.base(), map.stride(), format, w, h, n, m, d, b1, b2 );
+			ParallelFor::run( horizontal, 0, horizontal.size(), 4 );
 		}
 
-		src.unmap( inTmp );
-		dst.unmap( outTmp );
+		dst.reallocate( w, h, format );
+		IMapScoped<uint8_t> map( dst );
+		GaussIIRVertical vertical( map.base(), map.stride(), buf.ptr(), format, w, h, n, m, d, b1, b2 );
+		ParallelFor::run( vertical, 0, vertical.size() );
 	}
 
-	void GaussIIR::applyCPUu8( Image& dst, const Image& src, const Vector4f & _n, const Vector4f & _m, const Vector4f & _d ) const
+	void GaussIIR::applyCPUf( Image& dst, const Image& src, const Vector4f & n, const Vector4f & m, const Vector4f & d ) const
 	{
-		uint32_t h = dst.height();
-		uint32_t w = dst.width();
-		uint32_t channels = dst.channels();
-		
-		void (SIMD::*fwdHoriz)( Fixed* dst, const uint8_t * src, size_t width, const Fixed * n, const Fixed * d, const Fixed & b1 ) const;
-		void (SIMD::*bwdHoriz)( uint8_t * dst, const Fixed* fwdRes, const uint8_t * src, size_t w, const Fixed * n, const Fixed * d, const Fixed & b  ) const;
-		void (SIMD::*fwdVert)( Fixed* buffer, const uint8_t * src, size_t sstride, size_t h, const Fixed * n, const Fixed * d, const Fixed & b ) const;
-		void (SIMD::*bwdVert)( uint8_t * dst, size_t dstride, Fixed* fwdRes, size_t h, const Fixed * n, const Fixed * d, const Fixed & b ) const;
-		
-		SIMD * simd = SIMD::instance();		
-		switch ( channels ) {
-			case 4:
-				fwdHoriz = &SIMD::IIR4FwdHorizontal4Fx;
-				bwdHoriz = &SIMD::IIR4BwdHorizontal4Fx;
-				fwdVert = &SIMD::IIR4FwdVertical4Fx;
-				bwdVert = &SIMD::IIR4BwdVertical4Fx;
-				break;
-			default:
-				String msg;
-				msg.sprintf( "Not implement for number of channles: %d", channels );
-				throw CVTException( msg.c_str() );
-				break;
-		}
-		
-		
-		Fixed n[ 4 ], m[ 4 ], d[ 4 ];
-		n[ 0 ] = _n[ 0 ]; n[ 1 ] = _n[ 1 ]; n[ 2 ] = _n[ 2 ]; n[ 3 ] = _n[ 3 ];
-		m[ 0 ] = _m[ 0 ]; m[ 1 ] = _m[ 1 ]; m[ 2 ] = _m[ 2 ]; m[ 3 ] = _m[ 3 ];
-		d[ 0 ] = _d[ 0 ]; d[ 1 ] = _d[ 1 ]; d[ 2 ] = _d[ 2 ]; d[ 3 ] = _d[ 3 ];
-
-		Fixed one( 1.0f );
-		Fixed b1 = ( n[ 0 ] + n[ 1 ] + n[ 2 ] + n[ 3 ] ) / ( d[ 0 ] + d[ 1 ] + d[ 2 ] + d[ 3 ] + one );
-		Fixed b2 = ( m[ 0 ] + m[ 1 ] + m[ 2 ] + m[ 3 ] ) / ( d[ 0 ] + d[ 1 ] + d[ 2 ] + d[ 3 ] + one );
-
-		size_t sstride, dstride;
-		const uint8_t * in = src.map<uint8_t>( &sstride );
-		uint8_t * out = dst.map<uint8_t>( &dstride );
-
-		/* last four values */
-		const uint8_t* x = in;
-		uint8_t* y = out;
-
-		Fixed* tmpLine = new Fixed[ channels * w ];		
-
-		// horizontal pass
-		for( uint32_t k = 0; k < h; k++ ){
-			( simd->*fwdHoriz )( tmpLine, x, w, n, d, b1 );
-			( simd->*bwdHoriz )( y, tmpLine, x, w, m, d, b2 );
-
-			x += sstride;
-			y += dstride;
-		}
-        delete[] tmpLine;
-
-		// vertical pass:
-		// buffer for 4 lines:
-		Fixed* column = new Fixed[ channels * h ];
-		x = in;
-		y = out;
-		for( uint32_t k = 0; k < w; k++ ){
-			( simd->*fwdVert )( column, y, dstride, h, n, d, b1 );
-			( simd->*bwdVert )( y, dstride, column, h, m, d, b2 );
-			x += channels;
-			y += channels;
-		}
-        delete[] column;
+		if( src.format().type != IFORMAT_TYPE_FLOAT )
+			throw CVTException( "GaussIIR: float image expected" );
+		_GaussIIRCPU( dst, src, n, m, d );
+	}
 
+	void GaussIIR::applyCPUu8( Image& dst, const Image& src, const Vector4f & n, const Vector4f & m, const Vector4f & d ) const
+	{
+		if( src.format().type != IFORMAT_TYPE_UINT8 )
+			throw CVTException( "GaussIIR: uint8 image expected" );
+		_GaussIIRCPU( dst, src, n, m, d );
+	}
 
-		src.unmap( in );
-		dst.unmap( out );
+	void GaussIIR::apply( Image& dst, const Image& src, float sigma, int order, IFilterType t ) const
+	{
+		Vector4f n, m, d;
+		_GaussIIRCoeff( sigma, order, n, m, d );
+
+		if( t == IFILTER_OPENCL ) {
+			applyOpenCL( dst, src, n, m, d );
+			return;
+		}
+		_GaussIIRCPU( dst, src, n, m, d );
 	}
 }
@@ -40,6 +40,10 @@ namespace cvt
 			void	applyCPUu8( Image& dst, const Image& src, const Vector4f & n, const Vector4f & m, const Vector4f & d ) const;
 			void	apply( const ParamSet* set, IFilterType t = IFILTER_CPU ) const;
 
+			/* filter 1 or 4 channel float and uint8 images, the CPU path runs in parallel,
+			   dst is reallocated and may be src */
+			void	apply( Image& dst, const Image& src, float sigma, int order = 0, IFilterType t = IFILTER_CPU ) const;
+
 		private:
 			mutable CLKernel*	_kernelIIR;
 			mutable CLKernel*	_kernelIIR2;
@@ -0,0 +1,256 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/ifilter/GaussIIR.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+#include <cstring>
+
+namespace cvt {
+
+	static void _fill( Image& img, bool random, float value = 0.0f )
+	{
+		IMapScoped<uint8_t> map( img );
+		for( size_t y = 0; y < img.height(); y++ ) {
+			for( size_t x = 0; x < img.width() * img.channels(); x++ ) {
+				float v = random ? Math::rand( 0.0f, 1.0f ) : value;
+				if( img.format().type == IFORMAT_TYPE_FLOAT )
+					( ( float* ) map.ptr() )[ x ] = v;
+				else
+					map.ptr()[ x ] = ( uint8_t ) ( v * 255.0f + 0.5f );
+			}
+			map++;
+		}
+	}
+
+	static float _value( const IMapScoped<const uint8_t>& map, const IFormat& format, size_t x )
+	{
+		if( format.type == IFORMAT_TYPE_FLOAT )
+			return ( ( const float* ) map.ptr() )[ x ];
+		return map.ptr()[ x ] / 255.0f;
+	}
+
+	/* maximal absolute difference over all channels, channel c of a is compared to channel c % channels of b */
+	static float _maxDiff( const Image& a, const Image& b )
+	{
+		IMapScoped<const uint8_t> ma( a );
+		IMapScoped<const uint8_t> mb( b );
+		float diff = 0.0f;
+		for( size_t y = 0; y < a.height(); y++ ) {
+			for( size_t x = 0; x < a.width(); x++ ) {
+				for( size_t c = 0; c < a.channels(); c++ ) {
+					float va = _value( ma, a.format(), x * a.channels() + c );
+					float vb = _value( mb, b.format(), x * b.channels() + c % b.channels() );
+					diff = Math::max( diff, Math::abs( va - vb ) );
+				}
+			}
+			ma++;
+			mb++;
+		}
+		return diff;
+	}
+
+	/* copy the gray value to all channels of dst, without any color space conversion */
+	static void _expand( Image& dst, const Image& src, const IFormat& format )
+	{
+		dst.reallocate( src.width(), src.height(), format );
+		IMapScoped<uint8_t> mdst( dst );
+		IMapScoped<const uint8_t> msrc( src );
+		for( size_t y = 0; y < src.height(); y++ ) {
+			for( size_t x = 0; x < src.width(); x++ ) {
+				for( size_t c = 0; c < format.channels; c++ ) {
+					if( format.type == IFORMAT_TYPE_FLOAT )
+						( ( float* ) mdst.ptr() )[ format.channels * x + c ] = msrc.ptr()[ x ] / 255.0f;
+					else
+						mdst.ptr()[ format.channels * x + c ] = msrc.ptr()[ x ];
+				}
+			}
+			mdst++;
+			msrc++;
+		}
+	}
+
+	static bool _simdTest()
+	{
+		const size_t w = 37;
+		const float n[ ] = { 0.3f, 0.2f, -0.1f, 0.05f };
+		const float m[ ] = { 0.25f, 0.1f, -0.05f, 0.02f };
+		const float d[ ] = { -0.8f, 0.3f, -0.05f, 0.01f };
+		float src[ 4 * w ], out[ 4 * w ], ref[ 4 * w ];
+		const float* x[ 4 ];
+		const float* y[ 4 ];
+		bool ret = true;
+
+		for( size_t i = 0; i < 4 * w; i++ )
+			src[ i ] = Math::rand( -1.0f, 1.0f );
+		for( size_t k = 0; k < 4; k++ ) {
+			x[ k ] = src + k * 7;
+			y[ k ] = src + 64 + k * 5;
+		}
+
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMDType bestType = SIMD::bestSupportedType();
+		for( int st = SIMD_BASE; st <= bestType; st++ ) {
+			SIMD* simd = SIMD::get( ( SIMDType ) st );
+
+			base->IIR4Horizontal4f( ref, src, w, n, m, d, 0.4f, 0.3f );
+			simd->IIR4Horizontal4f( out, src, w, n, m, d, 0.4f, 0.3f );
+			for( size_t i = 0; i < 4 * w; i++ )
+				ret &= Math::abs( out[ i ] - ref[ i ] ) < 1e-5f;
+
+			base->IIR4Vertical_f( ref, x, y, n, d, w );
+			simd->IIR4Vertical_f( out, x, y, n, d, w );
+			for( size_t i = 0; i < w; i++ )
+				ret &= Math::abs( out[ i ] - ref[ i ] ) < 1e-5f;
+
+			delete simd;
+		}
+		delete base;
+		return ret;
+	}
+
+	static bool _constantTest( const IFormat& format )
+	{
+		Image src( 45, 31, format );
+		Image dst;
+		GaussIIR iir;
+
+		_fill( src, false, 0.6f );
+		iir.apply( dst, src, 2.5f );
+		return _maxDiff( dst, src ) < ( format.type == IFORMAT_TYPE_FLOAT ? 1e-4f : 1.5f / 255.0f );
+	}
+
+	/* the response to a centered impulse sums to one and is close to a gaussian */
+	static bool _impulseTest()
+	{
+		const size_t size = 65, c = 32;
+		const float sigma = 3.0f;
+		Image src( size, size, IFormat::GRAY_FLOAT );
+		Image dst;
+		GaussIIR iir;
+
+		_fill( src, false, 0.0f );
+		{
+			IMapScoped<float> map( src );
+			map.setLine( c );
+			map.ptr()[ c ] = 1.0f;
+		}
+		iir.apply( dst, src, sigma );
+
+		IMapScoped<const float> map( dst );
+		float sum = 0.0f, err = 0.0f;
+		const float g0 = 1.0f / ( 2.0f * Math::PI * sigma * sigma );
+		for( size_t y = 0; y < size; y++ ) {
+			for( size_t x = 0; x < size; x++ ) {
+				float r2 = Math::sqr( ( float ) x - ( float ) c ) + Math::sqr( ( float ) y - ( float ) c );
+				sum += map.ptr()[ x ];
+				err = Math::max( err, Math::abs( map.ptr()[ x ] - g0 * Math::exp( -r2 / ( 2.0f * sigma * sigma ) ) ) );
+			}
+			map++;
+		}
+		return Math::abs( sum - 1.0f ) < 1e-3f && err < 0.05f * g0;
+	}
+
+	struct GaussIIRApply {
+		GaussIIRApply( const GaussIIR& i, const Image& s ) : iir( i ), src( s ) {}
+		void operator()( Image& dst ) const { iir.apply( dst, src, 1.7f ); }
+		const GaussIIR&	iir;
+		const Image&	src;
+	};
+
+	/* gray and rgba paths, float and uint8 as well as different thread counts give the same result */
+	static bool _consistencyTest()
+	{
+		Image grayu8( 53, 41, IFormat::GRAY_UINT8 );
+		Image gray, rgba, rgbau8;
+		Image out1, outrgba, outu8, outrgbau8;
+		GaussIIR iir;
+		bool ret = true;
+
+		_fill( grayu8, true );
+		_expand( gray, grayu8, IFormat::GRAY_FLOAT );
+		_expand( rgba, grayu8, IFormat::RGBA_FLOAT );
+		_expand( rgbau8, grayu8, IFormat::RGBA_UINT8 );
+
+		iir.apply( out1, gray, 1.7f );
+		iir.apply( outrgba, rgba, 1.7f );
+		iir.apply( outu8, grayu8, 1.7f );
+		iir.apply( outrgbau8, rgbau8, 1.7f );
+
+		ret &= testThreadInvariance<Image>( GaussIIRApply( iir, gray ), testImagesEqual );
+		ret &= testThreadInvariance<Image>( GaussIIRApply( iir, rgbau8 ), testImagesEqual );
+		ret &= _maxDiff( outrgba, out1 ) < 1e-5f;
+		ret &= _maxDiff( outu8, out1 ) < 1.5f / 255.0f;
+		ret &= _maxDiff( outrgbau8, outu8 ) == 0.0f;
+		return ret;
+	}
+
+	static bool _inplaceTest()
+	{
+		Image src( 40, 30, IFormat::RGBA_UINT8 );
+		Image ref;
+		GaussIIR iir;
+
+		_fill( src, true );
+		iir.apply( ref, src, 4.0f );
+		iir.apply( src, src, 4.0f );
+		return testImagesEqual( src, ref );
+	}
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( GaussIIR )
+	bool result = true;
+	bool b;
+
+	b = _simdTest();
+	CVTTEST_PRINT( "SIMD kernels", b );
+	result &= b;
+
+	b = _constantTest( IFormat::GRAY_FLOAT ) && _constantTest( IFormat::RGBA_FLOAT ) &&
+		_constantTest( IFormat::GRAY_UINT8 ) && _constantTest( IFormat::RGBA_UINT8 );
+	CVTTEST_PRINT( "constant image", b );
+	result &= b;
+
+	b = _impulseTest();
+	CVTTEST_PRINT( "impulse response", b );
+	result &= b;
+
+	b = _consistencyTest();
+	CVTTEST_PRINT( "formats and threads", b );
+	result &= b;
+
+	b = _inplaceTest();
+	CVTTEST_PRINT( "in-place", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
@@ -23,6 +23,7 @@
 */
 
 #include <cvt/gfx/ifilter/GuidedFilter.h>
+#include <cvt/gfx/ifilter/GuidedFilterCPU.h>
 
 #include <cvt/cl/kernel/guidedfilter/guidedfilter_calcab.h>
 #include <cvt/cl/kernel/guidedfilter/guidedfilter_calcab_outerrgb.h>
@@ -46,19 +47,34 @@ namespace cvt {
 	};
 
 	GuidedFilter::GuidedFilter() :
-		IFilter( "GuidedFilter", _params, 5, IFILTER_CPU | IFILTER_OPENCL ),
-		_clguidedfilter_calcab( _guidedfilter_calcab_source, "guidedfilter_calcab" ),
-		_clguidedfilter_calcab_outerrgb( _guidedfilter_calcab_outerrgb_source, "guidedfilter_calcab_outerrgb" ),
-		_clguidedfilter_applyab_gc( _guidedfilter_applyab_gc_source, "guidedfilter_applyab_gc" ),
-		_clguidedfilter_applyab_gc_outer( _guidedfilter_applyab_gc_outer_source, "guidedfilter_applyab_gc_outer" ),
-		_clguidedfilter_applyab_cc( _guidedfilter_applyab_cc_source, "guidedfilter_applyab_cc" )
+		IFilter( "GuidedFilter", _params, 5, IFILTER_CPU | IFILTER_OPENCL )
 	{
 	}
 
-	void GuidedFilter::apply( Image& dst, const Image& src, const Image& guide, const int radius, const float epsilon, bool rgbcovariance ) const
+	void GuidedFilter::initCL() const
+	{
+		if( ( cl_kernel ) _clguidedfilter_calcab != NULL )
+			return;
+
+		_clguidedfilter_calcab = CLKernel( _guidedfilter_calcab_source, "guidedfilter_calcab" );
+		_clguidedfilter_calcab_outerrgb = CLKernel( _guidedfilter_calcab_outerrgb_source, "guidedfilter_calcab_outerrgb" );
+		_clguidedfilter_applyab_gc = CLKernel( _guidedfilter_applyab_gc_source, "guidedfilter_applyab_gc" );
+		_clguidedfilter_applyab_gc_outer = CLKernel( _guidedfilter_applyab_gc_outer_source, "guidedfilter_applyab_gc_outer" );
+		_clguidedfilter_applyab_cc = CLKernel( _guidedfilter_applyab_cc_source, "guidedfilter_applyab_cc" );
+	}
+
+	void GuidedFilter::apply( Image& dst, const Image& src, const Image& guide, const int radius, const float epsilon, bool rgbcovariance, IFilterType type ) const
 	{
 		// G guidance image, S source image
 
+		if( type == IFILTER_CPU ) {
+			GuidedFilterCPU gf( guide, radius, epsilon, rgbcovariance );
+			gf.apply( dst, src );
+			return;
+		} else if( type != IFILTER_OPENCL )
+			throw CVTException( "Not implemented" );
+
+		initCL();
 		if( rgbcovariance ) {
 			applyGC_COV( dst, src, guide, radius, epsilon );
 		} else if( src.format().channels <= 2 ) {
@@ -219,7 +235,8 @@ namespace cvt {
 
 		switch ( t ) {
 			case IFILTER_OPENCL:
-				this->apply( *out, *in, guide?*guide:*in, radius, epsilon );
+			case IFILTER_CPU:
+				this->apply( *out, *in, guide?*guide:*in, radius, epsilon, false, t );
 				break;
 			default:
 				throw CVTException( "Not implemented" );
@@ -34,27 +34,31 @@
 #include <cvt/gfx/ifilter/BoxFilter.h>
 
 namespace cvt {
+	/**
+	  Guided image filter, with IFILTER_CPU the filter runs on GuidedFilterCPU.
+	 */
 	class GuidedFilter : public IFilter {
 		public:
 			GuidedFilter();
 			~GuidedFilter() {};
 
-			void apply( Image& dst, const Image& src, const Image& guide, const int radius, const float epsilon, bool rgbcovariance = false ) const;
+			void apply( Image& dst, const Image& src, const Image& guide, const int radius, const float epsilon, bool rgbcovariance = false, IFilterType type = IFILTER_OPENCL ) const;
 
 			void apply( const ParamSet* attribs, IFilterType iftype ) const;
 
 		private:
+			void initCL() const;
 			void applyGC( Image& dst, const Image& src, const Image& guide, const int radius, const float epsilon ) const;
 			void applyGC_COV( Image& dst, const Image& src, const Image& guide, const int radius, const float epsilon ) const;
 			void applyCC( Image& dst, const Image& src, const Image& guide, const int radius, const float epsilon ) const;
 
 			GuidedFilter( const GuidedFilter& t );
 
-			CLKernel	   _clguidedfilter_calcab;
-			CLKernel	   _clguidedfilter_calcab_outerrgb;
-			CLKernel	   _clguidedfilter_applyab_gc;
-			CLKernel	   _clguidedfilter_applyab_gc_outer;
-			CLKernel	   _clguidedfilter_applyab_cc;
+			mutable CLKernel _clguidedfilter_calcab;
+			mutable CLKernel _clguidedfilter_calcab_outerrgb;
+			mutable CLKernel _clguidedfilter_applyab_gc;
+			mutable CLKernel _clguidedfilter_applyab_gc_outer;
+			mutable CLKernel _clguidedfilter_applyab_cc;
 			IntegralFilter _intfilter;
 			BoxFilter	   _boxfilter;
 	};
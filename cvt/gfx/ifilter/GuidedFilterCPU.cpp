@@ -0,0 +1,494 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ifilter/GuidedFilterCPU.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/Exception.h>
+
+#include <vector>
+#include <cstring>
+
+namespace cvt {
+
+	/* rows after which the running sums start again, also the grain of the parallel loops */
+#define GUIDEDFILTER_BLOCK 64
+
+	/* reads the first channels of an interleaved float image into planar rows */
+	class GuidedFilterImageSource : public GuidedFilterCPU::RowSource
+	{
+		public:
+			GuidedFilterImageSource( const uint8_t* base, size_t stride, size_t width, size_t ichannels, size_t channels ) :
+				_base( base ), _stride( stride ), _width( width ), _ichannels( ichannels ), _channels( channels )
+			{
+			}
+
+			void row( float* dst, size_t y ) const
+			{
+				const float* src = ( const float* ) ( _base + y * _stride );
+				for( size_t c = 0; c < _channels; c++ ) {
+					const float* s = src + c;
+					for( size_t x = 0; x < _width; x++, s += _ichannels )
+						*dst++ = *s;
+				}
+			}
+
+		private:
+			const uint8_t*	_base;
+			size_t			_stride;
+			size_t			_width;
+			size_t			_ichannels;
+			size_t			_channels;
+	};
+
+	/* writes planar rows into an interleaved float image, a fourth channel is copied from the source */
+	class GuidedFilterImageSink : public GuidedFilterCPU::RowSink
+	{
+		public:
+			GuidedFilterImageSink( uint8_t* base, size_t stride, const uint8_t* srcbase, size_t srcstride, size_t width, size_t ichannels, size_t channels ) :
+				_base( base ), _stride( stride ), _srcbase( srcbase ), _srcstride( srcstride ), _width( width ), _ichannels( ichannels ), _channels( channels )
+			{
+			}
+
+			void row( const float* src, size_t y ) const
+			{
+				float* dst = ( float* ) ( _base + y * _stride );
+				for( size_t c = 0; c < _channels; c++ ) {
+					float* d = dst + c;
+					for( size_t x = 0; x < _width; x++, d += _ichannels )
+						*d = *src++;
+				}
+				if( _ichannels == 4 ) {
+					const float* alpha = ( const float* ) ( _srcbase + y * _srcstride ) + 3;
+					for( size_t x = 0; x < _width; x++ )
+						dst[ 4 * x + 3 ] = alpha[ 4 * x ];
+				}
+			}
+
+		private:
+			uint8_t*		_base;
+			size_t			_stride;
+			const uint8_t*	_srcbase;
+			size_t			_srcstride;
+			size_t			_width;
+			size_t			_ichannels;
+			size_t			_channels;
+	};
+
+	/* one stage of a filter call over a range of rows */
+	class GuidedFilterCPU::RowsBody
+	{
+		public:
+			RowsBody( const GuidedFilterCPU& filter, RowsFunc rows, const Pass& pass ) :
+				_filter( filter ), _rows( rows ), _pass( pass )
+			{
+			}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				( _filter.*_rows )( _pass, start, end );
+			}
+
+		private:
+			const GuidedFilterCPU&	_filter;
+			RowsFunc				_rows;
+			Pass					_pass;
+	};
+
+	GuidedFilterCPU::GuidedFilterCPU( const Image& guide, int radius, float epsilon, bool rgbcovariance ) :
+		_width( guide.width() ),
+		_height( guide.height() ),
+		_radius( Math::max( radius, 0 ) ),
+		_epsilon( epsilon ),
+		_gchannels( guide.channels() >= 3 ? 3 : 1 ),
+		_guide( NULL ),
+		_gstats( NULL )
+	{
+		_covariance = rgbcovariance && _gchannels == 3;
+
+		Image tmp;
+		guide.convert( tmp, _gchannels == 3 ? IFormat::RGBA_FLOAT : IFormat::GRAY_FLOAT );
+
+		_guide = new float[ _gchannels * _width * _height ];
+		IMapScoped<const float> map( tmp );
+		GuidedFilterImageSource src( ( const uint8_t* ) map.ptr(), map.stride(), _width, tmp.channels(), _gchannels );
+		for( size_t y = 0; y < _height; y++ )
+			src.row( _guide + y * _gchannels * _width, y );
+	}
+
+	GuidedFilterCPU::~GuidedFilterCPU()
+	{
+		delete[] _guide;
+		delete[] _gstats;
+	}
+
+	size_t GuidedFilterCPU::guidePlanes() const
+	{
+		return _gchannels + ( _covariance ? 6 : _gchannels );
+	}
+
+	size_t GuidedFilterCPU::guideStatPlanes() const
+	{
+		return guidePlanes();
+	}
+
+	/* the guide channels used for the input channel */
+	size_t GuidedFilterCPU::guideChannels( size_t channel, size_t channels, size_t* gidx ) const
+	{
+		if( _covariance || channels == 1 ) {
+			for( size_t i = 0; i < _gchannels; i++ )
+				gidx[ i ] = i;
+			return _gchannels;
+		}
+		gidx[ 0 ] = _gchannels == 1 ? 0 : channel;
+		return 1;
+	}
+
+	size_t GuidedFilterCPU::coefficientSize( size_t channels ) const
+	{
+		size_t gidx[ 3 ];
+		size_t n = 0;
+		for( size_t c = 0; c < channels; c++ )
+			n += guideChannels( c, channels, gidx ) + 1;
+		return n * _width * _height;
+	}
+
+	void GuidedFilterCPU::precompute()
+	{
+		if( _gstats )
+			return;
+		_gstats = new float[ guideStatPlanes() * _width * _height ];
+
+		Pass pass = { NULL, NULL, 0, NULL };
+		ParallelFor::run( RowsBody( *this, &GuidedFilterCPU::guideRows, pass ), 0, _height, GUIDEDFILTER_BLOCK );
+	}
+
+	void GuidedFilterCPU::apply( Image& dst, const Image& src ) const
+	{
+		if( src.width() != _width || src.height() != _height )
+			throw CVTException( "Input and guide size differ" );
+
+		const size_t channels = src.channels() >= 3 ? 3 : 1;
+		Image input, output;
+		src.convert( input, channels == 3 ? IFormat::RGBA_FLOAT : IFormat::GRAY_FLOAT );
+		output.reallocate( _width, _height, input.format() );
+
+		{
+			IMapScoped<const float> mapsrc( input );
+			IMapScoped<float> mapdst( output );
+			GuidedFilterImageSource rsrc( ( const uint8_t* ) mapsrc.ptr(), mapsrc.stride(), _width, input.channels(), channels );
+			GuidedFilterImageSink rdst( ( uint8_t* ) mapdst.ptr(), mapdst.stride(), ( const uint8_t* ) mapsrc.ptr(), mapsrc.stride(), _width, output.channels(), channels );
+
+			std::vector<float> coeff( coefficientSize( channels ) );
+			Pass pass = { &rsrc, &rdst, channels, &coeff[ 0 ] };
+			ParallelFor::run( RowsBody( *this, &GuidedFilterCPU::coefficientRows, pass ), 0, _height, GUIDEDFILTER_BLOCK );
+			ParallelFor::run( RowsBody( *this, &GuidedFilterCPU::outputRows, pass ), 0, _height, GUIDEDFILTER_BLOCK );
+		}
+
+		if( src.format() == output.format() )
+			dst = output;
+		else
+			output.convert( dst, src.format() );
+	}
+
+	void GuidedFilterCPU::apply( const RowSink& dst, const RowSource& src, size_t channels, float* coeff ) const
+	{
+		Pass pass = { &src, &dst, channels, coeff };
+		coefficientRows( pass, 0, _height );
+		outputRows( pass, 0, _height );
+	}
+
+	void GuidedFilterCPU::guideRows( const Pass& pass, size_t start, size_t end ) const
+	{
+		boxRows( start, end, guidePlanes(), &GuidedFilterCPU::loadGuide, &GuidedFilterCPU::storeGuide, pass );
+	}
+
+	void GuidedFilterCPU::coefficientRows( const Pass& pass, size_t start, size_t end ) const
+	{
+		size_t gidx[ 3 ];
+		size_t planes = pass.channels;
+		for( size_t c = 0; c < pass.channels; c++ )
+			planes += guideChannels( c, pass.channels, gidx );
+		if( !_gstats )
+			planes += guidePlanes();
+		boxRows( start, end, planes, &GuidedFilterCPU::loadInput, &GuidedFilterCPU::storeCoefficients, pass );
+	}
+
+	void GuidedFilterCPU::outputRows( const Pass& pass, size_t start, size_t end ) const
+	{
+		boxRows( start, end, coefficientSize( pass.channels ) / ( _width * _height ), &GuidedFilterCPU::loadCoefficients, &GuidedFilterCPU::storeOutput, pass );
+	}
+
+	/*
+	   Box means of the rows [ start, end ) for the planes delivered by load. The column sums over the
+	   window rows are updated by adding the entering and subtracting the leaving row, the horizontal
+	   sum slides along the column sums. The means are divided by the number of pixels of the window
+	   inside of the image. The column sums are initialised again every GUIDEDFILTER_BLOCK rows.
+	 */
+	void GuidedFilterCPU::boxRows( size_t start, size_t end, size_t planes, LoadFunc load, StoreFunc store, const Pass& pass ) const
+	{
+		if( start >= end )
+			return;
+
+		SIMD* simd = SIMD::instance();
+		const int w = ( int ) _width;
+		const int h = ( int ) _height;
+		const int r = _radius;
+		const size_t n = planes * _width;
+
+		ScopedBuffer<float, true> colsum( n );
+		ScopedBuffer<float, true> rowbuf( n );
+		ScopedBuffer<float, true> means( n );
+		ScopedBuffer<float, true> scratch( n );
+		ScopedBuffer<float, true> invcount( _width );
+
+		for( int x = 0; x < w; x++ )
+			invcount.ptr()[ x ] = 1.0f / ( float ) ( Math::min( w - 1, x + r ) - Math::max( 0, x - r ) + 1 );
+
+		for( int y = ( int ) start; y < ( int ) end; y++ ) {
+			/* restart the column sums at fixed rows, the result does not depend on the split into threads */
+			if( y == ( int ) start || y % GUIDEDFILTER_BLOCK == 0 ) {
+				simd->SetValue1f( colsum.ptr(), 0.0f, n );
+				const int ystart = Math::max( 0, y - r );
+				const int yend = Math::min( h - 1, y + r );
+				for( int yy = ystart; yy <= yend; yy++ )
+					simd->Add( colsum.ptr(), colsum.ptr(), ( this->*load )( rowbuf.ptr(), yy, pass ), n );
+			}
+
+			const float invy = 1.0f / ( float ) ( Math::min( h - 1, y + r ) - Math::max( 0, y - r ) + 1 );
+
+			for( size_t k = 0; k < planes; k++ ) {
+				const float* col = colsum.ptr() + k * _width;
+				float* mean = means.ptr() + k * _width;
+				float acc = 0.0f;
+				for( int x = 0; x <= Math::min( r, w - 1 ); x++ )
+					acc += col[ x ];
+				for( int x = 0; x < w; x++ ) {
+					mean[ x ] = acc * invcount.ptr()[ x ] * invy;
+					if( x + r + 1 < w )
+						acc += col[ x + r + 1 ];
+					if( x >= r )
+						acc -= col[ x - r ];
+				}
+			}
+
+			( this->*store )( means.ptr(), scratch.ptr(), y, pass );
+
+			if( y + 1 < ( int ) end && ( y + 1 ) % GUIDEDFILTER_BLOCK != 0 ) {
+				if( y + r + 1 < h )
+					simd->Add( colsum.ptr(), colsum.ptr(), ( this->*load )( rowbuf.ptr(), y + r + 1, pass ), n );
+				if( y - r >= 0 )
+					simd->Sub( colsum.ptr(), colsum.ptr(), ( this->*load )( rowbuf.ptr(), y - r, pass ), n );
+			}
+		}
+	}
+
+	/* guide channels followed by the products RR, RG, RB, GG, GB, BB or the squares of the channels */
+	const float* GuidedFilterCPU::loadGuide( float* buf, size_t y, const Pass& ) const
+	{
+		SIMD* simd = SIMD::instance();
+		const size_t w = _width;
+		const float* guide = _guide + y * _gchannels * w;
+
+		memcpy( buf, guide, sizeof( float ) * _gchannels * w );
+		float* dst = buf + _gchannels * w;
+		if( _covariance ) {
+			for( size_t i = 0; i < 3; i++ ) {
+				for( size_t j = i; j < 3; j++ ) {
+					simd->Mul( dst, guide + i * w, guide + j * w, w );
+					dst += w;
+				}
+			}
+		} else {
+			for( size_t i = 0; i < _gchannels; i++ ) {
+				simd->Mul( dst, guide + i * w, guide + i * w, w );
+				dst += w;
+			}
+		}
+		return buf;
+	}
+
+	/* mean of the guide and the inverse of its ( co-)variance plus epsilon from the means of loadGuide */
+	void GuidedFilterCPU::guideStatistics( float* dst, const float* means, size_t w ) const
+	{
+		const size_t C = _gchannels;
+		memcpy( dst, means, sizeof( float ) * C * w );
+
+		if( _covariance ) {
+			const float* m = means;
+			const float* mm = means + 3 * w;
+			float* inv = dst + 3 * w;
+			for( size_t x = 0; x < w; x++ ) {
+				double r = m[ x ], g = m[ w + x ], b = m[ 2 * w + x ];
+				double a00 = mm[ x ] - r * r + _epsilon;
+				double a01 = mm[ w + x ] - r * g;
+				double a02 = mm[ 2 * w + x ] - r * b;
+				double a11 = mm[ 3 * w + x ] - g * g + _epsilon;
+				double a12 = mm[ 4 * w + x ] - g * b;
+				double a22 = mm[ 5 * w + x ] - b * b + _epsilon;
+
+				double c00 = a11 * a22 - a12 * a12;
+				double c01 = a02 * a12 - a01 * a22;
+				double c02 = a01 * a12 - a02 * a11;
+				double det = a00 * c00 + a01 * c01 + a02 * c02;
+				double idet = Math::abs( det ) < 1e-20 ? 0.0 : 1.0 / det;
+
+				inv[ x ]		 = ( float ) ( c00 * idet );
+				inv[ w + x ]	 = ( float ) ( c01 * idet );
+				inv[ 2 * w + x ] = ( float ) ( c02 * idet );
+				inv[ 3 * w + x ] = ( float ) ( ( a00 * a22 - a02 * a02 ) * idet );
+				inv[ 4 * w + x ] = ( float ) ( ( a01 * a02 - a00 * a12 ) * idet );
+				inv[ 5 * w + x ] = ( float ) ( ( a00 * a11 - a01 * a01 ) * idet );
+			}
+		} else {
+			for( size_t c = 0; c < C; c++ ) {
+				const float* m = means + c * w;
+				const float* mm = means + ( C + c ) * w;
+				float* inv = dst + ( C + c ) * w;
+				for( size_t x = 0; x < w; x++ )
+					inv[ x ] = 1.0f / ( mm[ x ] - m[ x ] * m[ x ] + _epsilon );
+			}
+		}
+	}
+
+	void GuidedFilterCPU::storeGuide( const float* means, float*, size_t y, const Pass& ) const
+	{
+		guideStatistics( _gstats + y * guideStatPlanes() * _width, means, _width );
+	}
+
+	/* the input channels, the products of guide and input channels and the planes of loadGuide if not precomputed */
+	const float* GuidedFilterCPU::loadInput( float* buf, size_t y, const Pass& pass ) const
+	{
+		SIMD* simd = SIMD::instance();
+		const size_t w = _width;
+		const float* guide = _guide + y * _gchannels * w;
+		size_t gidx[ 3 ];
+
+		pass.src->row( buf, y );
+		float* dst = buf + pass.channels * w;
+		for( size_t c = 0; c < pass.channels; c++ ) {
+			size_t ng = guideChannels( c, pass.channels, gidx );
+			for( size_t i = 0; i < ng; i++ ) {
+				simd->Mul( dst, guide + gidx[ i ] * w, buf + c * w, w );
+				dst += w;
+			}
+		}
+		if( !_gstats )
+			loadGuide( dst, y, pass );
+		return buf;
+	}
+
+	/*
+	   a = ( Sigma + epsilon U )^-1 cov( I, p ) and b = mean( p ) - a * mean( I ). Without covariance each
+	   guide channel has its own a, gray inputs average the results of all guide channels.
+	 */
+	void GuidedFilterCPU::storeCoefficients( const float* means, float* buf, size_t y, const Pass& pass ) const
+	{
+		const size_t w = _width;
+		const size_t S = pass.channels;
+		size_t gidx[ 3 ];
+
+		size_t nprod = 0;
+		for( size_t c = 0; c < S; c++ )
+			nprod += guideChannels( c, S, gidx );
+
+		const float* stats;
+		if( _gstats )
+			stats = _gstats + y * guideStatPlanes() * w;
+		else {
+			guideStatistics( buf, means + ( S + nprod ) * w, w );
+			stats = buf;
+		}
+		const float* gmean = stats;
+		const float* ginv = stats + _gchannels * w;
+
+		const size_t ncoeff = coefficientSize( S ) / ( w * _height );
+		float* coeff = pass.coeff + y * ncoeff * w;
+		const float* prod = means + S * w;
+
+		for( size_t c = 0; c < S; c++ ) {
+			const float* mp = means + c * w;
+			size_t ng = guideChannels( c, S, gidx );
+			float* a = coeff;
+			float* b = coeff + ng * w;
+
+			for( size_t x = 0; x < w; x++ ) {
+				float cov[ 3 ];
+				for( size_t i = 0; i < ng; i++ )
+					cov[ i ] = prod[ i * w + x ] - gmean[ gidx[ i ] * w + x ] * mp[ x ];
+
+				float ai[ 3 ];
+				if( _covariance ) {
+					ai[ 0 ] = ginv[ x ] * cov[ 0 ] + ginv[ w + x ] * cov[ 1 ] + ginv[ 2 * w + x ] * cov[ 2 ];
+					ai[ 1 ] = ginv[ w + x ] * cov[ 0 ] + ginv[ 3 * w + x ] * cov[ 1 ] + ginv[ 4 * w + x ] * cov[ 2 ];
+					ai[ 2 ] = ginv[ 2 * w + x ] * cov[ 0 ] + ginv[ 4 * w + x ] * cov[ 1 ] + ginv[ 5 * w + x ] * cov[ 2 ];
+				} else {
+					const float norm = 1.0f / ( float ) ng;
+					for( size_t i = 0; i < ng; i++ )
+						ai[ i ] = cov[ i ] * ginv[ gidx[ i ] * w + x ] * norm;
+				}
+
+				float bi = mp[ x ];
+				for( size_t i = 0; i < ng; i++ ) {
+					a[ i * w + x ] = ai[ i ];
+					bi -= ai[ i ] * gmean[ gidx[ i ] * w + x ];
+				}
+				b[ x ] = bi;
+			}
+
+			prod += ng * w;
+			coeff += ( ng + 1 ) * w;
+		}
+	}
+
+	const float* GuidedFilterCPU::loadCoefficients( float*, size_t y, const Pass& pass ) const
+	{
+		return pass.coeff + y * ( coefficientSize( pass.channels ) / _height );
+	}
+
+	/* q = mean( a ) * I + mean( b ) */
+	void GuidedFilterCPU::storeOutput( const float* means, float* buf, size_t y, const Pass& pass ) const
+	{
+		const size_t w = _width;
+		const float* guide = _guide + y * _gchannels * w;
+		size_t gidx[ 3 ];
+
+		for( size_t c = 0; c < pass.channels; c++ ) {
+			size_t ng = guideChannels( c, pass.channels, gidx );
+			float* out = buf + c * w;
+			memcpy( out, means + ng * w, sizeof( float ) * w );
+			for( size_t i = 0; i < ng; i++ ) {
+				const float* a = means + i * w;
+				const float* g = guide + gidx[ i ] * w;
+				for( size_t x = 0; x < w; x++ )
+					out[ x ] += a[ x ] * g[ x ];
+			}
+			means += ( ng + 1 ) * w;
+		}
+		pass.dst->row( buf, y );
+	}
+}
@@ -0,0 +1,133 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_GUIDEDFILTERCPU_H
+#define CVT_GUIDEDFILTERCPU_H
+
+#include <cvt/gfx/Image.h>
+
+namespace cvt {
+	/**
+	  @brief CPU guided filter with constant cost per pixel.
+
+	  All box means are computed over the part of the ( 2 * radius + 1 )^2 window inside the image
+	  with running column sums, the products of guide and input are formed row by row while summing.
+	  Only the coefficients a and b are stored for the whole image. The statistics of the guide can be
+	  precomputed once if one guide is used for many inputs ( e.g. the slices of a cost volume ).
+
+	  Gray inputs use all colour channels of the guide, either each channel on its own and averaged
+	  or with the full colour covariance. Colour inputs are filtered channel by channel with the
+	  corresponding guide channel ( or with the colour covariance ).
+	 */
+	class GuidedFilterCPU {
+		public:
+			/**
+			  Provides the input of the filter row by row, the channels one after another ( planar ).
+			 */
+			class RowSource {
+				public:
+					virtual ~RowSource() {}
+					virtual void row( float* dst, size_t y ) const = 0;
+			};
+
+			/**
+			  Receives the filtered rows, the channels one after another ( planar ).
+			 */
+			class RowSink {
+				public:
+					virtual ~RowSink() {}
+					virtual void row( const float* src, size_t y ) const = 0;
+			};
+
+			GuidedFilterCPU( const Image& guide, int radius, float epsilon, bool rgbcovariance = false );
+			~GuidedFilterCPU();
+
+			/**
+			  Computes the mean and the inverse ( co-)variance of the guide, worthwhile if the filter is applied more than once.
+			 */
+			void	precompute();
+
+			/**
+			  Filters src ( any format ) into dst with the format of src, parallel over rows.
+			 */
+			void	apply( Image& dst, const Image& src ) const;
+
+			/**
+			  Filters an input with the given number of channels ( 1 or 3 ) without any threading,
+			  meant to be called from within parallel loops over independent inputs.
+			  @param coeff	buffer with coefficientSize( channels ) floats
+			 */
+			void	apply( const RowSink& dst, const RowSource& src, size_t channels, float* coeff ) const;
+
+			size_t	coefficientSize( size_t channels ) const;
+
+			size_t	width() const { return _width; }
+			size_t	height() const { return _height; }
+
+		private:
+			/* input, output and coefficients of one filter call */
+			struct Pass {
+				const RowSource*	src;
+				const RowSink*		dst;
+				size_t				channels;
+				float*				coeff;
+			};
+			class RowsBody;
+
+			GuidedFilterCPU( const GuidedFilterCPU& );
+			GuidedFilterCPU& operator=( const GuidedFilterCPU& );
+
+			typedef void ( GuidedFilterCPU::*RowsFunc )( const Pass& pass, size_t start, size_t end ) const;
+			typedef const float* ( GuidedFilterCPU::*LoadFunc )( float* buf, size_t y, const Pass& pass ) const;
+			typedef void ( GuidedFilterCPU::*StoreFunc )( const float* means, float* buf, size_t y, const Pass& pass ) const;
+
+			void			guideRows( const Pass& pass, size_t start, size_t end ) const;
+			void			coefficientRows( const Pass& pass, size_t start, size_t end ) const;
+			void			outputRows( const Pass& pass, size_t start, size_t end ) const;
+			void			boxRows( size_t start, size_t end, size_t planes, LoadFunc load, StoreFunc store, const Pass& pass ) const;
+
+			const float*	loadGuide( float* buf, size_t y, const Pass& pass ) const;
+			void			storeGuide( const float* means, float* buf, size_t y, const Pass& pass ) const;
+			const float*	loadInput( float* buf, size_t y, const Pass& pass ) const;
+			void			storeCoefficients( const float* means, float* buf, size_t y, const Pass& pass ) const;
+			const float*	loadCoefficients( float* buf, size_t y, const Pass& pass ) const;
+			void			storeOutput( const float* means, float* buf, size_t y, const Pass& pass ) const;
+
+			void			guideStatistics( float* dst, const float* means, size_t stride ) const;
+			size_t			guidePlanes() const;
+			size_t			guideStatPlanes() const;
+			size_t			guideChannels( size_t channel, size_t channels, size_t* gidx ) const;
+
+			size_t	_width, _height;
+			int		_radius;
+			float	_epsilon;
+			bool	_covariance;
+			size_t	_gchannels;
+			float*	_guide;		/* planar guide rows */
+			float*	_gstats;	/* planar mean and inverse ( co-)variance rows of the guide, NULL if not precomputed */
+	};
+}
+
+#endif
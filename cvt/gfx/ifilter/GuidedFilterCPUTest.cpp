@@ -0,0 +1,232 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ifilter/GuidedFilterCPU.h>
+#include <cvt/gfx/ifilter/GuidedFilter.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+#include <cvt/math/Matrix.h>
+
+#include <vector>
+
+namespace cvt {
+
+	static void _gfRandomImage( Image& img, size_t w, size_t h, const IFormat& format, bool smooth )
+	{
+		img.reallocate( w, h, format );
+		IMapScoped<float> map( img );
+		const size_t c = format.channels;
+		for( size_t y = 0; y < h; y++ ) {
+			float* ptr = map.ptr();
+			for( size_t x = 0; x < w * c; x++ ) {
+				if( smooth )
+					ptr[ x ] = 0.5f + 0.2f * Math::sin( 0.3f * ( float ) ( x / c ) + ( float ) ( x % c ) ) * Math::cos( 0.2f * ( float ) y ) + Math::rand( -0.05f, 0.05f );
+				else
+					ptr[ x ] = Math::rand( 0.0f, 1.0f );
+			}
+			map++;
+		}
+	}
+
+	/* plain implementation of the guided filter with box means over the clipped window */
+	static void _gfReference( std::vector<float>& out, const Image& src, const Image& guide, int r, float eps, bool cov )
+	{
+		const int w = src.width(), h = src.height();
+		const size_t sc = src.channels(), gc = guide.channels();
+		const size_t S = sc >= 3 ? 3 : 1;
+		const size_t C = gc >= 3 ? 3 : 1;
+		std::vector<float> I( w * h * C ), p( w * h * S );
+		{
+			IMapScoped<const float> ms( src );
+			IMapScoped<const float> mg( guide );
+			for( int y = 0; y < h; y++ ) {
+				for( int x = 0; x < w; x++ ) {
+					for( size_t c = 0; c < S; c++ ) p[ ( y * w + x ) * S + c ] = ms.ptr()[ x * sc + c ];
+					for( size_t c = 0; c < C; c++ ) I[ ( y * w + x ) * C + c ] = mg.ptr()[ x * gc + c ];
+				}
+				ms++;
+				mg++;
+			}
+		}
+		cov = cov && C == 3;
+
+		/* a ( up to 3 per channel ) and b for every pixel and channel */
+		std::vector<double> a( w * h * S * 3, 0.0 ), b( w * h * S, 0.0 );
+		for( int y = 0; y < h; y++ ) {
+			for( int x = 0; x < w; x++ ) {
+				double mI[ 3 ] = { 0, 0, 0 }, mII[ 3 ][ 3 ] = { { 0 } }, mp[ 3 ] = { 0, 0, 0 }, mIp[ 3 ][ 3 ] = { { 0 } };
+				int n = 0;
+				for( int yy = Math::max( 0, y - r ); yy <= Math::min( h - 1, y + r ); yy++ ) {
+					for( int xx = Math::max( 0, x - r ); xx <= Math::min( w - 1, x + r ); xx++ ) {
+						const float* i = &I[ ( yy * w + xx ) * C ];
+						const float* q = &p[ ( yy * w + xx ) * S ];
+						for( size_t c = 0; c < C; c++ ) {
+							mI[ c ] += i[ c ];
+							for( size_t d = 0; d < C; d++ ) mII[ c ][ d ] += i[ c ] * i[ d ];
+							for( size_t s = 0; s < S; s++ ) mIp[ s ][ c ] += i[ c ] * q[ s ];
+						}
+						for( size_t s = 0; s < S; s++ ) mp[ s ] += q[ s ];
+						n++;
+					}
+				}
+				for( size_t c = 0; c < 3; c++ ) {
+					mI[ c ] /= n; mp[ c ] /= n;
+					for( size_t d = 0; d < 3; d++ ) { mII[ c ][ d ] /= n; mIp[ c ][ d ] /= n; }
+				}
+
+				for( size_t s = 0; s < S; s++ ) {
+					double* as = &a[ ( ( y * w + x ) * S + s ) * 3 ];
+					double bs = mp[ s ];
+					if( cov ) {
+						Matrix3d sigma;
+						Vector3d cv;
+						for( size_t c = 0; c < 3; c++ ) {
+							for( size_t d = 0; d < 3; d++ )
+								sigma[ c ][ d ] = mII[ c ][ d ] - mI[ c ] * mI[ d ] + ( c == d ? eps : 0.0 );
+							cv[ c ] = mIp[ s ][ c ] - mI[ c ] * mp[ s ];
+						}
+						sigma.inverseSelf();
+						Vector3d av = sigma * cv;
+						for( size_t c = 0; c < 3; c++ ) {
+							as[ c ] = av[ c ];
+							bs -= av[ c ] * mI[ c ];
+						}
+					} else if( S == 1 ) {
+						for( size_t c = 0; c < C; c++ ) {
+							as[ c ] = ( mIp[ 0 ][ c ] - mI[ c ] * mp[ 0 ] ) / ( mII[ c ][ c ] - mI[ c ] * mI[ c ] + eps ) / ( double ) C;
+							bs -= as[ c ] * mI[ c ];
+						}
+					} else {
+						size_t g = C == 1 ? 0 : s;
+						as[ g ] = ( mIp[ s ][ g ] - mI[ g ] * mp[ s ] ) / ( mII[ g ][ g ] - mI[ g ] * mI[ g ] + eps );
+						bs -= as[ g ] * mI[ g ];
+					}
+					b[ ( y * w + x ) * S + s ] = bs;
+				}
+			}
+		}
+
+		out.assign( w * h * S, 0.0f );
+		for( int y = 0; y < h; y++ ) {
+			for( int x = 0; x < w; x++ ) {
+				for( size_t s = 0; s < S; s++ ) {
+					double ma[ 3 ] = { 0, 0, 0 }, mb = 0;
+					int n = 0;
+					for( int yy = Math::max( 0, y - r ); yy <= Math::min( h - 1, y + r ); yy++ ) {
+						for( int xx = Math::max( 0, x - r ); xx <= Math::min( w - 1, x + r ); xx++ ) {
+							for( size_t c = 0; c < 3; c++ ) ma[ c ] += a[ ( ( yy * w + xx ) * S + s ) * 3 + c ];
+							mb += b[ ( yy * w + xx ) * S + s ];
+							n++;
+						}
+					}
+					double q = mb / n;
+					for( size_t c = 0; c < C; c++ )
+						q += ma[ c ] / n * I[ ( y * w + x ) * C + c ];
+					out[ ( y * w + x ) * S + s ] = ( float ) q;
+				}
+			}
+		}
+	}
+
+	static float _gfMaxError( const std::vector<float>& ref, const Image& img )
+	{
+		const size_t S = img.channels() >= 3 ? 3 : 1;
+		IMapScoped<const float> map( img );
+		float err = 0.0f;
+		for( size_t y = 0; y < img.height(); y++ ) {
+			for( size_t x = 0; x < img.width(); x++ )
+				for( size_t s = 0; s < S; s++ )
+					err = Math::max( err, Math::abs( map.ptr()[ x * img.channels() + s ] - ref[ ( y * img.width() + x ) * S + s ] ) );
+			map++;
+		}
+		return err;
+	}
+
+	struct GFApplyCov {
+		GFApplyCov( const GuidedFilter& f, const Image& s, const Image& g ) : gf( f ), src( s ), guide( g ) {}
+		void operator()( Image& out ) const { gf.apply( out, src, guide, 4, 1e-2f, true, IFILTER_CPU ); }
+		const GuidedFilter&	gf;
+		const Image&		src;
+		const Image&		guide;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( GuidedFilterCPU )
+	bool result = true;
+	bool b;
+	Image gray, rgba, guide, out;
+	std::vector<float> ref;
+
+	srand( 23 );
+	_gfRandomImage( gray, 37, 29, IFormat::GRAY_FLOAT, false );
+	_gfRandomImage( rgba, 37, 29, IFormat::RGBA_FLOAT, false );
+	_gfRandomImage( guide, 37, 29, IFormat::RGBA_FLOAT, true );
+
+	GuidedFilter gf;
+	gf.apply( out, gray, guide, 4, 1e-2f, false, IFILTER_CPU );
+	_gfReference( ref, gray, guide, 4, 1e-2f, false );
+	b = out.format() == IFormat::GRAY_FLOAT && _gfMaxError( ref, out ) < 1e-4f;
+	CVTTEST_PRINT( "gray input, colour guide", b );
+	result &= b;
+
+	gf.apply( out, gray, guide, 3, 1e-2f, true, IFILTER_CPU );
+	_gfReference( ref, gray, guide, 3, 1e-2f, true );
+	b = _gfMaxError( ref, out ) < 1e-3f;
+	CVTTEST_PRINT( "gray input, colour covariance", b );
+	result &= b;
+
+	gf.apply( out, rgba, guide, 5, 1e-3f, false, IFILTER_CPU );
+	_gfReference( ref, rgba, guide, 5, 1e-3f, false );
+	b = out.format() == IFormat::RGBA_FLOAT && _gfMaxError( ref, out ) < 1e-3f;
+	CVTTEST_PRINT( "colour input, colour guide", b );
+	result &= b;
+
+	/* radius larger than the image and a precomputed guide */
+	{
+		GuidedFilterCPU gfcpu( gray, 40, 1e-2f );
+		gfcpu.precompute();
+		gfcpu.apply( out, rgba );
+		_gfReference( ref, rgba, gray, 40, 1e-2f, false );
+		b = _gfMaxError( ref, out ) < 1e-3f;
+	}
+	CVTTEST_PRINT( "gray guide, large radius", b );
+	result &= b;
+
+	/* more rows than one block of the running sums */
+	_gfRandomImage( rgba, 40, 150, IFormat::RGBA_FLOAT, false );
+	_gfRandomImage( guide, 40, 150, IFormat::RGBA_FLOAT, true );
+	gf.apply( out, rgba, guide, 4, 1e-2f, true, IFILTER_CPU );
+	_gfReference( ref, rgba, guide, 4, 1e-2f, true );
+	b = testThreadInvariance<Image>( GFApplyCov( gf, rgba, guide ), testImagesEqual ) && _gfMaxError( ref, out ) < 1e-3f;
+	CVTTEST_PRINT( "independent of the number of threads", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
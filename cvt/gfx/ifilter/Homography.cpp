@@ -23,6 +23,7 @@
 */
 
 #include <cvt/gfx/ifilter/Homography.h>
+#include <cvt/gfx/IWarpEngine.h>
 #include <cvt/util/Exception.h>
 #include <cvt/math/Math.h>
 
@@ -144,7 +145,19 @@ namespace cvt {
 			dst.format().type != IFORMAT_TYPE_FLOAT )
 			throw CVTException( "Invalid image formats/types");
 
-		applyFloat( dst, src, H, c );
+		switch( src.format().formatID ) {
+			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_BGRA_FLOAT:
+				{
+					IWarpEngine engine( IWARP_BILINEAR, c );
+					engine.warp( dst, src, H );
+				}
+				break;
+			default:
+				applyFloat( dst, src, H, c );
+				break;
+		}
 	}
 
 	void Homography::apply( const ParamSet* set, IFilterType t ) const
@@ -35,6 +35,7 @@ namespace cvt {
 	{
 		public:
 			Homography();
+			/* dst( x ) = src( H x ) for the allocated float image dst with the format of src, pixels without source get the color c */
 			void apply( Image& dst, const Image& src, const Matrix3f& H, const Color& c ) const;
 			void apply( const ParamSet* set, IFilterType t = IFILTER_CPU ) const;
 		private:
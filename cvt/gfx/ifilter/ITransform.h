@@ -41,6 +41,8 @@ namespace cvt {
 			 *	@param	dst			the destination image
 			 *	@param	src			the source image
 			 *	@param	transform	transformation from src to dst!
+			 *
+			 *	The warps run in IWarpEngine, pixels without source are black.
 			 */
 			static void apply( Image& dst, const Image& src, const Matrix3f& transform, size_t width = 0, size_t height = 0 );
 			static void apply( Image& dst, const Image& src, const Matrix3f& transform, const Matrix3f& itransform, size_t width = 0, size_t height = 0 );
@@ -48,17 +50,6 @@ namespace cvt {
 			static void apply( Image& dst, const Image& src, const Function<Vector2f, Vector2f>& warpFunc, size_t width = 0, size_t height = 0 );
 
 		private:
-			static void applyFC1( Image& dst, const Image& src, const Matrix3f& T, const Matrix3f& Tinv );
-			static void applyFC4( Image& dst, const Image& src, const Matrix3f& T, const Matrix3f& Tinv );
-			static void applyU8C1( Image& dst, const Image& src, const Matrix3f& T, const Matrix3f& Tinv );
-			static void applyU8C4( Image& dst, const Image& src, const Matrix3f& T, const Matrix3f& Tinv );
-
-			/* function versions */
-			static void applyFC1( Image& dst, const Image& src, const Function<Vector2f, Vector2f>& warp );
-			static void applyFC4( Image& dst, const Image& src, const Function<Vector2f, Vector2f>& warp );
-			static void applyU8C1( Image& dst, const Image& src, const Function<Vector2f, Vector2f>& warp );
-			static void applyU8C4( Image& dst, const Image& src, const Function<Vector2f, Vector2f>& warp );
-
 			ITransform( const ITransform& t );
 	};
 }
@@ -23,7 +23,9 @@
 */
 
 #include <cvt/gfx/ifilter/IWarp.h>
+#include <cvt/gfx/IWarpEngine.h>
 #include <cvt/math/Vector.h>
+#include <string.h>
 
 namespace cvt {
 
@@ -38,6 +40,23 @@ namespace cvt {
 		&_poutput
 	};
 
+	/* source positions from the rows of a GRAYALPHA_FLOAT warp image */
+	class IWarpImageCoordinates : public IWarpCoordinates {
+		public:
+			IWarpImageCoordinates( const uint8_t* warp, size_t stride ) : _warp( warp ), _stride( stride )
+			{
+			}
+
+			void coordinates( float* coords, size_t x, size_t y, size_t n ) const
+			{
+				memcpy( coords, ( const float* ) ( _warp + y * _stride ) + 2 * x, sizeof( float ) * 2 * n );
+			}
+
+		private:
+			const uint8_t*	_warp;
+			size_t			_stride;
+	};
+
 	IWarp::IWarp() : IFilter( "ImageWarp", _itransform_params, 3, IFILTER_CPU )
 	{
 	}
@@ -53,15 +72,9 @@ namespace cvt {
 
 		dst.reallocate( warp.width(), warp.height(), src.format() );
 
-		switch( src.format().formatID ) {
-			case IFORMAT_GRAY_FLOAT: return applyFC1( dst, src, warp );
-			case IFORMAT_GRAY_UINT8: return applyU8C1( dst, src, warp );
-			case IFORMAT_RGBA_FLOAT:
-			case IFORMAT_BGRA_FLOAT: return applyFC4( dst, src, warp );
-			case IFORMAT_RGBA_UINT8:
-			case IFORMAT_BGRA_UINT8: return applyU8C4( dst, src, warp );
-			default: throw CVTException( "Unsupported image format!" );
-		}
+		IMapScoped<const uint8_t> map( warp );
+		IWarpEngine engine;
+		engine.warp( dst, src, IWarpImageCoordinates( map.base(), map.stride() ) );
 	}
 
 
@@ -251,126 +264,4 @@ namespace cvt {
 		idst.unmap( dst );
 	}
 
-	void IWarp::applyFC1( Image& idst, const Image& isrc, const Image& iwarp )
-	{
-		const uint8_t* src;
-		uint8_t* dst;
-		const uint8_t* wrp;
-		uint8_t* pdst;
-		const uint8_t* pwrp;
-		size_t sstride, dstride, wstride, w, h, sw, sh;
-
-		pdst = dst = idst.map( &dstride );
-		pwrp = wrp = iwarp.map( &wstride );
-		src = isrc.map( &sstride );
-
-		SIMD* simd = SIMD::instance();
-
-		sw = isrc.width();
-		sh = isrc.height();
-		w = iwarp.width();
-		h = iwarp.height();
-		while( h-- ) {
-			simd->warpBilinear1f( ( float* ) pdst, ( const float* ) pwrp, ( const float* ) src, sstride, sw, sh, 0.0f, w );
-			pdst += dstride;
-			pwrp += wstride;
-		}
-
-		idst.unmap( dst );
-		isrc.unmap( src );
-		iwarp.unmap( wrp );
-	}
-
-	void IWarp::applyFC4( Image& idst, const Image& isrc, const Image& iwarp )
-	{
-		const uint8_t* src;
-		uint8_t* dst;
-		const uint8_t* wrp;
-		uint8_t* pdst;
-		const uint8_t* pwrp;
-		size_t sstride, dstride, wstride, w, h, sw, sh;
-		float black[ ] = { 0.0f, 0.0f, 0.0f, 1.0f };
-
-		pdst = dst = idst.map( &dstride );
-		pwrp = wrp = iwarp.map( &wstride );
-		src = isrc.map( &sstride );
-
-		SIMD* simd = SIMD::instance();
-
-		sw = isrc.width();
-		sh = isrc.height();
-		w = iwarp.width();
-		h = iwarp.height();
-		while( h-- ) {
-			simd->warpBilinear4f( ( float* ) pdst, ( const float* ) pwrp, ( const float* ) src, sstride, sw, sh, black, w );
-			pdst += dstride;
-			pwrp += wstride;
-		}
-
-		idst.unmap( dst );
-		isrc.unmap( src );
-		iwarp.unmap( wrp );
-	}
-
-	void IWarp::applyU8C1( Image& idst, const Image& isrc, const Image& iwarp )
-	{
-		const uint8_t* src;
-		uint8_t* dst;
-		const uint8_t* wrp;
-		uint8_t* pdst;
-		const uint8_t* pwrp;
-		size_t sstride, dstride, wstride, w, h, sw, sh;
-
-		pdst = dst = idst.map( &dstride );
-		pwrp = wrp = iwarp.map( &wstride );
-		src = isrc.map( &sstride );
-
-		SIMD* simd = SIMD::instance();
-
-		sw = isrc.width();
-		sh = isrc.height();
-		w = iwarp.width();
-		h = iwarp.height();
-		while( h-- ) {
-			simd->warpBilinear1u8( pdst, ( const float* ) pwrp, src, sstride, sw, sh, 0, w );
-			pdst += dstride;
-			pwrp += wstride;
-		}
-
-		idst.unmap( dst );
-		isrc.unmap( src );
-		iwarp.unmap( wrp );
-	}
-
-	void IWarp::applyU8C4( Image& idst, const Image& isrc, const Image& iwarp )
-	{
-		const uint8_t* src;
-		uint8_t* dst;
-		const uint8_t* wrp;
-		uint8_t* pdst;
-		const uint8_t* pwrp;
-		size_t sstride, dstride, wstride, w, h, sw, sh;
-		uint32_t black = 0xff000000;
-
-		pdst = dst = idst.map( &dstride );
-		pwrp = wrp = iwarp.map( &wstride );
-		src = isrc.map( &sstride );
-
-		SIMD* simd = SIMD::instance();
-
-		sw = isrc.width();
-		sh = isrc.height();
-		w = iwarp.width();
-		h = iwarp.height();
-		while( h-- ) {
-			simd->warpBilinear4u8( pdst, ( const float* ) pwrp, src, sstride, sw, sh, black, w );
-			pdst += dstride;
-			pwrp += wstride;
-		}
-
-		idst.unmap( dst );
-		isrc.unmap( src );
-		iwarp.unmap( wrp );
-	}
-
 }
@@ -64,11 +64,6 @@ namespace cvt {
 			static void warpGeneric( Image& idst, TFUNC op );
 
 		private:
-			static void applyFC1( Image& dst, const Image& src, const Image& warp );
-			static void applyFC4( Image& dst, const Image& src, const Image& warp );
-			static void applyU8C1( Image& dst, const Image& src, const Image& warp );
-			static void applyU8C4( Image& dst, const Image& src, const Image& warp );
-
 			IWarp( const IWarp& t );
 	};
 
@@ -23,6 +23,7 @@
 */
 
 #include <cvt/gfx/ifilter/IntegralFilter.h>
+#include <cvt/gfx/ifilter/IntegralFilterCPU.h>
 
 #include <cvt/cl/kernel/prefixsum/prefixsum_pblock.h>
 #include <cvt/cl/kernel/prefixsum/prefixsum_pblock_mul2.h>
@@ -46,24 +47,38 @@ namespace cvt {
 
 	IntegralFilter::IntegralFilter() :
 		IFilter( "IntegralFilter", _params, 3, IFILTER_CPU | IFILTER_OPENCL ),
-		_clprefixsum_blockp( _prefixsum_pblock_source, "prefixsum_pblock" ),
-		_clprefixsum_blockp_sqr( _prefixsum_pblock_sqr_source, "prefixsum_pblock_sqr" ),
-		_clprefixsum_blockp_mul2( _prefixsum_pblock_mul2_source, "prefixsum_pblock_mul2" ),
-		_clprefixsum_blockp_mul2_shifted( _prefixsum_pblock_mul2_shifted_source, "prefixsum_pblock_mul2_shifted" ),
-		_clprefixsum_blockp_outerrgb( _prefixsum_pblock_outerrgb_source, "prefixsum_pblock_outerrgb" ),
-		_clprefixsum_horiz( _prefixsum_horiz_source, "prefixsum_horiz" ),
-		_clprefixsum_vert( _prefixsum_vert_source, "prefixsum_vert" ),
-		_clprefixsum_block2( _prefixsum_block2_source, "prefixsum_block2" ),
 		_blocksize( 16 )
 	{
+	}
+
+	void IntegralFilter::initCL() const
+	{
+		if( ( cl_kernel ) _clprefixsum_blockp != NULL )
+			return;
+
+		_clprefixsum_blockp = CLKernel( _prefixsum_pblock_source, "prefixsum_pblock" );
+		_clprefixsum_blockp_sqr = CLKernel( _prefixsum_pblock_sqr_source, "prefixsum_pblock_sqr" );
+		_clprefixsum_blockp_mul2 = CLKernel( _prefixsum_pblock_mul2_source, "prefixsum_pblock_mul2" );
+		_clprefixsum_blockp_mul2_shifted = CLKernel( _prefixsum_pblock_mul2_shifted_source, "prefixsum_pblock_mul2_shifted" );
+		_clprefixsum_blockp_outerrgb = CLKernel( _prefixsum_pblock_outerrgb_source, "prefixsum_pblock_outerrgb" );
+		_clprefixsum_horiz = CLKernel( _prefixsum_horiz_source, "prefixsum_horiz" );
+		_clprefixsum_vert = CLKernel( _prefixsum_vert_source, "prefixsum_vert" );
+		_clprefixsum_block2 = CLKernel( _prefixsum_block2_source, "prefixsum_block2" );
+
 		size_t maxwg = Math::max( _clprefixsum_blockp.maxWorkGroupSize(), _clprefixsum_block2.maxWorkGroupSize() );
 		while( _blocksize * _blocksize > maxwg  ) {
 			_blocksize >>= 1;
 		}
 	}
 
-	void IntegralFilter::apply( Image& dst, const Image& src, const Image* src2 ) const
+	void IntegralFilter::apply( Image& dst, const Image& src, const Image* src2, IFilterType type ) const
 	{
+		if( type == IFILTER_CPU ) {
+			IntegralFilterCPU::apply( dst, src, src2 );
+			return;
+		}
+
+		initCL();
 		dst.reallocate( src.width(), src.height(), IFormat::floatEquivalent( src.format() ), IALLOCATOR_CL );
 		// FIXME: hardcoded work-group size
 
@@ -106,8 +121,14 @@ namespace cvt {
 	}
 
 
-	void IntegralFilter::applyOuterRGB( Image& dst_RR_RG_RB, Image& dst_GG_GB_BB, const Image& src ) const
+	void IntegralFilter::applyOuterRGB( Image& dst_RR_RG_RB, Image& dst_GG_GB_BB, const Image& src, IFilterType type ) const
 	{
+		if( type == IFILTER_CPU ) {
+			IntegralFilterCPU::applyOuterRGB( dst_RR_RG_RB, dst_GG_GB_BB, src );
+			return;
+		}
+
+		initCL();
 		_clprefixsum_blockp_outerrgb.setArg( 0, dst_RR_RG_RB );
 		_clprefixsum_blockp_outerrgb.setArg( 1, dst_GG_GB_BB );
 		_clprefixsum_blockp_outerrgb.setArg( 2, src );
@@ -148,8 +169,14 @@ namespace cvt {
 	}
 
 
-	void IntegralFilter::applyShifted( Image& dst, const Image& src, const Image& src2, float dx, float dy ) const
+	void IntegralFilter::applyShifted( Image& dst, const Image& src, const Image& src2, float dx, float dy, IFilterType type ) const
 	{
+		if( type == IFILTER_CPU ) {
+			IntegralFilterCPU::applyShifted( dst, src, src2, dx, dy );
+			return;
+		}
+
+		initCL();
 		Vector2f shift( dx, dy );
 
 		_clprefixsum_blockp_mul2_shifted.setArg( 0, dst );
@@ -185,7 +212,8 @@ namespace cvt {
 
 		switch ( t ) {
 			case IFILTER_OPENCL:
-				this->apply( *out, *in, in2 );
+			case IFILTER_CPU:
+				this->apply( *out, *in, in2, t );
 				break;
 			default:
 				throw CVTException( "Not implemented" );
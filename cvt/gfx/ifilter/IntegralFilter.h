@@ -36,22 +36,24 @@ namespace cvt {
 		friend class StereoGCVFilter;
 		public:
 			IntegralFilter();
-			void apply( Image& dst, const Image& src, const Image* src2 = NULL ) const;
+			void apply( Image& dst, const Image& src, const Image* src2 = NULL, IFilterType type = IFILTER_OPENCL ) const;
 			void apply( const ParamSet* set, IFilterType t = IFILTER_CPU ) const;
 
 		private:
-			void applyOuterRGB( Image& dst_RR_RG_RB, Image& dst_GG_GB_BB, const Image& src ) const;
-			void applyShifted( Image& dst, const Image& src1, const Image& src2, float dx = 0, float dy = 0 ) const;
-
-			CLKernel _clprefixsum_blockp;
-			CLKernel _clprefixsum_blockp_sqr;
-			CLKernel _clprefixsum_blockp_mul2;
-			CLKernel _clprefixsum_blockp_mul2_shifted;
-			CLKernel _clprefixsum_blockp_outerrgb;
-			CLKernel _clprefixsum_horiz;
-			CLKernel _clprefixsum_vert;
-			CLKernel _clprefixsum_block2;
-			size_t _blocksize;
+			void applyOuterRGB( Image& dst_RR_RG_RB, Image& dst_GG_GB_BB, const Image& src, IFilterType type = IFILTER_OPENCL ) const;
+			void applyShifted( Image& dst, const Image& src1, const Image& src2, float dx = 0, float dy = 0, IFilterType type = IFILTER_OPENCL ) const;
+
+			void initCL() const;
+
+			mutable CLKernel _clprefixsum_blockp;
+			mutable CLKernel _clprefixsum_blockp_sqr;
+			mutable CLKernel _clprefixsum_blockp_mul2;
+			mutable CLKernel _clprefixsum_blockp_mul2_shifted;
+			mutable CLKernel _clprefixsum_blockp_outerrgb;
+			mutable CLKernel _clprefixsum_horiz;
+			mutable CLKernel _clprefixsum_vert;
+			mutable CLKernel _clprefixsum_block2;
+			mutable size_t _blocksize;
 	};
 }
 
@@ -0,0 +1,476 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ifilter/IntegralFilterCPU.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/Exception.h>
+
+#include <cstring>
+
+namespace cvt {
+
+	/* rows summed vertically in one block, also the grain of the parallel loops */
+#define INTEGRALFILTER_BLOCK 64
+
+	template<typename T>
+	struct IntegralFilterRow {
+		static inline T value( float v ) { return ( T ) v; }
+
+		static void scan( T* dst, const float* src, const T* prev, size_t width, size_t channels, const SIMD* )
+		{
+			for( size_t c = 0; c < channels; c++ ) {
+				T sum = 0;
+				for( size_t i = c, end = width * channels; i < end; i += channels ) {
+					sum += value( src[ i ] );
+					dst[ i ] = prev ? sum + prev[ i ] : sum;
+				}
+			}
+		}
+
+		static void add( T* dst, const T* src, size_t n, const SIMD* )
+		{
+			while( n-- )
+				*dst++ += *src++;
+		}
+	};
+
+	template<>
+	inline int64_t IntegralFilterRow<int64_t>::value( float v )
+	{
+		return ( int64_t ) Math::round( v );
+	}
+
+	template<>
+	void IntegralFilterRow<float>::scan( float* dst, const float* src, const float* prev, size_t width, size_t channels, const SIMD* simd )
+	{
+		simd->prefixSumRow_f_to_f( dst, src, prev, width, channels );
+	}
+
+	template<>
+	void IntegralFilterRow<float>::add( float* dst, const float* src, size_t n, const SIMD* simd )
+	{
+		simd->Add( dst, dst, src, n );
+	}
+
+	template<typename T>
+	class IntegralFilterTable
+	{
+		public:
+			IntegralFilterTable( uint8_t* base, size_t stride, const IntegralFilterCPU::RowSource& src ) :
+				_base( base ),
+				_stride( stride ),
+				_src( src ),
+				_width( src.width() ),
+				_height( src.height() ),
+				_n( src.width() * src.channels() ),
+				_simd( SIMD::instance() )
+			{
+			}
+
+			void run() const;
+
+			/* generate, scan horizontally and sum vertically inside the blocks */
+			void blockRows( size_t start, size_t end ) const
+			{
+				ScopedBuffer<float, true> buf( _n );
+				ScopedBuffer<float, true> scratch( Math::max<size_t>( _src.scratchSize(), 1 ) );
+				for( size_t y = start; y < end; y++ ) {
+					_src.row( buf.ptr(), scratch.ptr(), y );
+					IntegralFilterRow<T>::scan( row( y ), buf.ptr(), ( y % INTEGRALFILTER_BLOCK ) ? row( y - 1 ) : NULL, _width, _src.channels(), _simd );
+				}
+			}
+
+			/* add the final last row of the previous block to all but the last row of a block */
+			void carryRows( size_t start, size_t end ) const
+			{
+				for( size_t y = Math::max<size_t>( start, INTEGRALFILTER_BLOCK ); y < end; y++ ) {
+					size_t block = y / INTEGRALFILTER_BLOCK;
+					if( y == lastRow( block ) )
+						continue;
+					IntegralFilterRow<T>::add( row( y ), row( block * INTEGRALFILTER_BLOCK - 1 ), _n, _simd );
+				}
+			}
+
+		private:
+			T* row( size_t y ) const { return ( T* ) ( _base + y * _stride ); }
+			size_t lastRow( size_t block ) const { return Math::min( ( block + 1 ) * INTEGRALFILTER_BLOCK, _height ) - 1; }
+
+			uint8_t*								_base;
+			size_t									_stride;
+			const IntegralFilterCPU::RowSource&		_src;
+			size_t									_width, _height, _n;
+			const SIMD*								_simd;
+	};
+
+	template<typename T>
+	void IntegralFilterTable<T>::run() const
+	{
+		if( !_width || !_height )
+			return;
+
+		ParallelFor::run( ParallelFor::bind( *this, &IntegralFilterTable<T>::blockRows ), 0, _height, INTEGRALFILTER_BLOCK );
+
+		size_t blocks = ( _height + INTEGRALFILTER_BLOCK - 1 ) / INTEGRALFILTER_BLOCK;
+		if( blocks < 2 )
+			return;
+
+		for( size_t b = 1; b < blocks; b++ )
+			IntegralFilterRow<T>::add( row( lastRow( b ) ), row( lastRow( b - 1 ) ), _n, _simd );
+
+		ParallelFor::run( ParallelFor::bind( *this, &IntegralFilterTable<T>::carryRows ), INTEGRALFILTER_BLOCK, _height, INTEGRALFILTER_BLOCK );
+	}
+
+
+	IntegralFilterCPU::ImageSource::ImageSource( const Image& src1, const Image* src2, bool normalize ) :
+		_width( src1.width() ),
+		_height( src1.height() ),
+		_channels( src1.channels() ),
+		_normalize( normalize ),
+		_square( src2 == &src1 ),
+		_count( ( src2 && src2 != &src1 ) ? 2 : 1 )
+	{
+		if( _count == 2 && ( src2->width() != _width || src2->height() != _height || src2->channels() != _channels ) )
+			throw CVTException( "Images differ in size or channels" );
+
+		_img[ 0 ] = _img[ 1 ] = NULL;
+		map( 0, src1 );
+		if( _count == 2 )
+			map( 1, *src2 );
+	}
+
+	IntegralFilterCPU::ImageSource::~ImageSource()
+	{
+		for( size_t i = 0; i < _count; i++ ) {
+			if( _img[ i ] )
+				_img[ i ]->unmap( _base[ i ] );
+		}
+	}
+
+	void IntegralFilterCPU::ImageSource::map( size_t idx, const Image& img )
+	{
+		const IFormat& format = img.format();
+		if( format.type == IFORMAT_TYPE_OTHER || format.isPlanar() )
+			throw CVTException( "Unsupported image format!" );
+
+		const Image* pimg = &img;
+		if( format.type != IFORMAT_TYPE_UINT8 && format.type != IFORMAT_TYPE_FLOAT ) {
+			img.convert( _conv[ idx ], IFormat::floatEquivalent( format ) );
+			pimg = &_conv[ idx ];
+		}
+		_type[ idx ] = pimg->format().type;
+		_base[ idx ] = pimg->map<uint8_t>( &_stride[ idx ] );
+		_img[ idx ] = pimg;
+	}
+
+	void IntegralFilterCPU::ImageSource::load( float* dst, size_t idx, size_t y ) const
+	{
+		const uint8_t* src = _base[ idx ] + y * _stride[ idx ];
+		size_t n = _width * _channels;
+		if( _type[ idx ] == IFORMAT_TYPE_UINT8 )
+			SIMD::instance()->MulU8Value1f( dst, src, _normalize ? 1.0f / 255.0f : 1.0f, n );
+		else
+			memcpy( dst, src, sizeof( float ) * n );
+	}
+
+	void IntegralFilterCPU::ImageSource::row( float* dst, float* scratch, size_t y ) const
+	{
+		load( dst, 0, y );
+		if( _square ) {
+			SIMD::instance()->Mul( dst, dst, dst, _width * _channels );
+		} else if( _count == 2 ) {
+			load( scratch, 1, y );
+			SIMD::instance()->Mul( dst, dst, scratch, _width * _channels );
+		}
+	}
+
+
+	/* ( RR, RG, RB, 0 ) or ( GG, GB, BB, 0 ) of a colour image */
+	class IntegralFilterOuterRGBSource : public IntegralFilterCPU::RowSource
+	{
+		public:
+			IntegralFilterOuterRGBSource( const IntegralFilterCPU::ImageSource& src, bool bgr, bool second ) :
+				_src( src ), _r( bgr ? 2 : 0 ), _b( bgr ? 0 : 2 ), _second( second )
+			{
+			}
+
+			size_t width() const { return _src.width(); }
+			size_t height() const { return _src.height(); }
+			size_t channels() const { return 4; }
+
+			void row( float* dst, float* scratch, size_t y ) const
+			{
+				const size_t c = _src.channels();
+				_src.load( scratch, 0, y );
+				const float* rgb = scratch;
+				for( size_t x = 0, w = width(); x < w; x++, rgb += c, dst += 4 ) {
+					float r = rgb[ _r ], g = rgb[ 1 ], b = rgb[ _b ];
+					if( _second ) {
+						dst[ 0 ] = g * g;
+						dst[ 1 ] = g * b;
+						dst[ 2 ] = b * b;
+					} else {
+						dst[ 0 ] = r * r;
+						dst[ 1 ] = r * g;
+						dst[ 2 ] = r * b;
+					}
+					dst[ 3 ] = 0.0f;
+				}
+			}
+
+		private:
+			const IntegralFilterCPU::ImageSource&	_src;
+			size_t									_r, _b;
+			bool									_second;
+	};
+
+	/* src1( x, y ) * src2( x + dx, y + dy ) with bilinear interpolation and zero border */
+	class IntegralFilterShiftedSource : public IntegralFilterCPU::RowSource
+	{
+		public:
+			IntegralFilterShiftedSource( const IntegralFilterCPU::ImageSource& src1, const IntegralFilterCPU::ImageSource& src2, float dx, float dy ) :
+				_src1( src1 ), _src2( src2 )
+			{
+				float fx = Math::floor( dx );
+				float fy = Math::floor( dy );
+				_ix = ( ssize_t ) fx;
+				_iy = ( ssize_t ) fy;
+				_ax = dx - fx;
+				_ay = dy - fy;
+			}
+
+			size_t width() const { return _src1.width(); }
+			size_t height() const { return _src1.height(); }
+			size_t channels() const { return _src1.channels(); }
+
+			void row( float* dst, float* scratch, size_t y ) const
+			{
+				const ssize_t w = width();
+				const ssize_t c = channels();
+				const size_t n = w * c;
+				float* r0 = scratch;
+				float* r1 = scratch + n;
+
+				/* vertical interpolation of the two rows of src2 into r0 */
+				ssize_t y0 = ( ssize_t ) y + _iy;
+				loadRow( r0, y0 );
+				loadRow( r1, y0 + 1 );
+				for( size_t i = 0; i < n; i++ )
+					r0[ i ] = Math::mix( r0[ i ], r1[ i ], _ay );
+
+				_src1.load( dst, 0, y );
+				for( ssize_t x = 0; x < w; x++ ) {
+					ssize_t x0 = x + _ix;
+					for( ssize_t k = 0; k < c; k++ ) {
+						float v0 = ( x0 >= 0 && x0 < w ) ? r0[ x0 * c + k ] : 0.0f;
+						float v1 = ( x0 + 1 >= 0 && x0 + 1 < w ) ? r0[ ( x0 + 1 ) * c + k ] : 0.0f;
+						dst[ x * c + k ] *= Math::mix( v0, v1, _ax );
+					}
+				}
+			}
+
+		private:
+			void loadRow( float* dst, ssize_t y ) const
+			{
+				if( y >= 0 && y < ( ssize_t ) height() )
+					_src2.load( dst, 0, y );
+				else
+					memset( dst, 0, sizeof( float ) * width() * channels() );
+			}
+
+			const IntegralFilterCPU::ImageSource&	_src1;
+			const IntegralFilterCPU::ImageSource&	_src2;
+			ssize_t									_ix, _iy;
+			float									_ax, _ay;
+	};
+
+
+	void IntegralFilterCPU::table( float* dst, size_t stride, const RowSource& src )
+	{
+		IntegralFilterTable<float>( ( uint8_t* ) dst, stride, src ).run();
+	}
+
+	void IntegralFilterCPU::table( double* dst, size_t stride, const RowSource& src )
+	{
+		IntegralFilterTable<double>( ( uint8_t* ) dst, stride, src ).run();
+	}
+
+	void IntegralFilterCPU::table( int64_t* dst, size_t stride, const RowSource& src )
+	{
+		IntegralFilterTable<int64_t>( ( uint8_t* ) dst, stride, src ).run();
+	}
+
+	void IntegralFilterCPU::apply( Image& dst, const RowSource& src, Accumulator acc )
+	{
+		const IFormat* format;
+		switch( src.channels() ) {
+			case 1: format = &IFormat::GRAY_FLOAT; break;
+			case 2: format = &IFormat::GRAYALPHA_FLOAT; break;
+			case 4: format = &IFormat::RGBA_FLOAT; break;
+			default:
+				throw CVTException( "Unsupported number of channels" );
+		}
+
+		/* keep BGRA_FLOAT and the allocator of dst */
+		if( dst.format().channels != src.channels() || dst.format().type != IFORMAT_TYPE_FLOAT )
+			dst.reallocate( src.width(), src.height(), *format, dst.memType() );
+		else
+			dst.reallocate( src.width(), src.height(), dst.format(), dst.memType() );
+
+		IMapScoped<float> map( dst );
+		if( acc == ACCUMULATE_FLOAT ) {
+			table( map.ptr(), map.stride(), src );
+			return;
+		}
+
+		size_t n = src.width() * src.channels();
+		ScopedBuffer<double, true> buf( n * src.height() );
+		table( buf.ptr(), n * sizeof( double ), src );
+		const double* d = buf.ptr();
+		for( size_t y = 0; y < src.height(); y++ ) {
+			float* f = map.ptr();
+			for( size_t i = 0; i < n; i++ )
+				f[ i ] = ( float ) *d++;
+			map++;
+		}
+	}
+
+	void IntegralFilterCPU::apply( Image& dst, const Image& src, const Image* src2, Accumulator acc )
+	{
+		ImageSource isrc( src, src2 );
+		apply( dst, isrc, acc );
+	}
+
+	void IntegralFilterCPU::applyOuterRGB( Image& dst_RR_RG_RB, Image& dst_GG_GB_BB, const Image& src, Accumulator acc )
+	{
+		if( src.channels() < 3 )
+			throw CVTException( "Colour image required" );
+
+		ImageSource isrc( src );
+		bool bgr = src.format().formatID == IFORMAT_BGRA_UINT8 || src.format().formatID == IFORMAT_BGRA_FLOAT || src.format().formatID == IFORMAT_BGR_UINT8;
+		apply( dst_RR_RG_RB, IntegralFilterOuterRGBSource( isrc, bgr, false ), acc );
+		apply( dst_GG_GB_BB, IntegralFilterOuterRGBSource( isrc, bgr, true ), acc );
+	}
+
+	void IntegralFilterCPU::applyShifted( Image& dst, const Image& src1, const Image& src2, float dx, float dy, Accumulator acc )
+	{
+		if( src1.width() != src2.width() || src1.height() != src2.height() || src1.channels() != src2.channels() )
+			throw CVTException( "Images differ in size or channels" );
+
+		ImageSource isrc1( src1 );
+		ImageSource isrc2( src2 );
+		apply( dst, IntegralFilterShiftedSource( isrc1, isrc2, dx, dy ), acc );
+	}
+
+
+	class IntegralFilterBox
+	{
+		public:
+			IntegralFilterBox( const IMapScoped<const float>& table, uint8_t* dst, size_t dststride, bool u8, size_t width, size_t height, size_t channels, size_t radius ) :
+				_table( table ), _dst( dst ), _dststride( dststride ), _u8( u8 ), _width( width ), _height( height ), _channels( channels ), _radius( radius )
+			{
+			}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				const SIMD* simd = SIMD::instance();
+				const size_t c = _channels;
+				const size_t r = _radius;
+				const size_t n = _width * c;
+				ScopedBuffer<float, true> diff( n );
+				ScopedBuffer<float, true> out( n );
+
+				for( size_t y = start; y < end; y++ ) {
+					/* rows y0 < j <= y1 of the window */
+					size_t y1 = Math::min( y + r, _height - 1 );
+					const float* t1 = ( const float* ) ( ( const uint8_t* ) _table.ptr() + y1 * _table.stride() );
+					float h;
+					if( y > r ) {
+						const float* t0 = ( const float* ) ( ( const uint8_t* ) _table.ptr() + ( y - r - 1 ) * _table.stride() );
+						simd->Sub( diff.ptr(), t1, t0, n );
+						h = ( float ) ( y1 - ( y - r - 1 ) );
+					} else {
+						memcpy( diff.ptr(), t1, sizeof( float ) * n );
+						h = ( float ) ( y1 + 1 );
+					}
+
+					const float* d = diff.ptr();
+					float* o = out.ptr();
+					for( size_t x = 0; x < _width; x++ ) {
+						/* the interior is handled with SIMD below */
+						if( x == r + 1 && x + r < _width ) {
+							size_t xend = _width - r;
+							simd->Sub( o + x * c, d + ( x + r ) * c, d + ( x - r - 1 ) * c, ( xend - x ) * c );
+							simd->MulValue1f( o + x * c, o + x * c, 1.0f / ( h * ( float ) ( 2 * r + 1 ) ), ( xend - x ) * c );
+							x = xend - 1;
+							continue;
+						}
+						size_t x1 = Math::min( x + r, _width - 1 );
+						float w = ( float ) ( x1 + 1 );
+						for( size_t k = 0; k < c; k++ )
+							o[ x * c + k ] = d[ x1 * c + k ];
+						if( x > r ) {
+							w -= ( float ) ( x - r );
+							for( size_t k = 0; k < c; k++ )
+								o[ x * c + k ] -= d[ ( x - r - 1 ) * c + k ];
+						}
+						for( size_t k = 0; k < c; k++ )
+							o[ x * c + k ] /= w * h;
+					}
+
+					uint8_t* dst = _dst + y * _dststride;
+					if( _u8 ) {
+						for( size_t i = 0; i < n; i++ )
+							dst[ i ] = ( uint8_t ) Math::clamp( o[ i ] + 0.5f, 0.0f, 255.0f );
+					} else
+						memcpy( dst, o, sizeof( float ) * n );
+				}
+			}
+
+		private:
+			const IMapScoped<const float>&	_table;
+			uint8_t*						_dst;
+			size_t							_dststride;
+			bool							_u8;
+			size_t							_width, _height, _channels, _radius;
+	};
+
+	void IntegralFilterCPU::boxFilter( Image& dst, const Image& table, int radius )
+	{
+		const IFormat& tformat = table.format();
+		bool u8 = dst.format() == IFormat::GRAY_UINT8 && tformat == IFormat::GRAY_FLOAT;
+		if( tformat.type != IFORMAT_TYPE_FLOAT )
+			throw CVTException( "Unsupported image format!" );
+
+		dst.reallocate( table.width(), table.height(), u8 ? IFormat::GRAY_UINT8 : tformat, dst.memType() );
+		IMapScoped<const float> maptable( table );
+		IMapScoped<uint8_t> mapdst( dst );
+		IntegralFilterBox box( maptable, mapdst.ptr(), mapdst.stride(), u8, table.width(), table.height(), table.channels(), Math::max( radius, 0 ) );
+		ParallelFor::run( box, 0, table.height(), 16 );
+	}
+
+}
@@ -0,0 +1,140 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_INTEGRALFILTERCPU_H
+#define CVT_INTEGRALFILTERCPU_H
+
+#include <cvt/gfx/Image.h>
+
+namespace cvt {
+	/**
+	  @brief Multithreaded CPU summed area tables.
+
+	  The rows are generated and prefix summed horizontally ( SIMD ), then the columns are summed
+	  in blocks of INTEGRALFILTER_BLOCK rows in parallel. The last rows of the blocks are summed
+	  sequentially and finally added to the rows of the following block in parallel.
+	  The block layout does not depend on the number of threads, so the results do not either.
+
+	  All tables are inclusive and of the size of the input: T( x, y ) = sum_{ i <= x, j <= y } I( i, j ).
+	  Tables can be accumulated in float, double or ( for integer valued rows ) int64_t, the latter two
+	  avoid the precision loss of float sums on large images.
+	 */
+	class IntegralFilterCPU {
+		public:
+			enum Accumulator {
+				ACCUMULATE_FLOAT,
+				ACCUMULATE_DOUBLE
+			};
+
+			/**
+			  Generates the values to sum row by row with interleaved channels.
+			 */
+			class RowSource {
+				public:
+					virtual ~RowSource() {}
+					virtual size_t width() const = 0;
+					virtual size_t height() const = 0;
+					virtual size_t channels() const = 0;
+					/* number of floats of the scratch buffer passed to row() */
+					virtual size_t scratchSize() const { return 2 * width() * channels(); }
+					virtual void   row( float* dst, float* scratch, size_t y ) const = 0;
+			};
+
+			/**
+			  Values, squares ( src2 == &src1 ) or products ( src2 != NULL ) of uint8 or float images.
+			  uint8 values are scaled to [ 0, 1 ] if normalize is set, otherwise they stay integers.
+			 */
+			class ImageSource : public RowSource {
+				public:
+					ImageSource( const Image& src1, const Image* src2 = NULL, bool normalize = true );
+					~ImageSource();
+
+					size_t width() const { return _width; }
+					size_t height() const { return _height; }
+					size_t channels() const { return _channels; }
+					void   row( float* dst, float* scratch, size_t y ) const;
+
+					/* loads row y of the first ( idx = 0 ) or second image without multiplication */
+					void   load( float* dst, size_t idx, size_t y ) const;
+
+				private:
+					ImageSource( const ImageSource& );
+					ImageSource& operator=( const ImageSource& );
+
+					void   map( size_t idx, const Image& img );
+
+					size_t			_width, _height, _channels;
+					bool			_normalize;
+					bool			_square;
+					size_t			_count;
+					Image			_conv[ 2 ];
+					const Image*	_img[ 2 ];
+					const uint8_t*	_base[ 2 ];
+					size_t			_stride[ 2 ];
+					IFormatType		_type[ 2 ];
+			};
+
+			/**
+			  Same as IntegralFilter::apply: the table of src, of src^2 if src2 == &src or of src * src2.
+			  dst gets the float equivalent of the format of src.
+			 */
+			static void apply( Image& dst, const Image& src, const Image* src2 = NULL, Accumulator acc = ACCUMULATE_FLOAT );
+
+			/**
+			  Tables of the upper triangle of the outer product of the colours ( RR, RG, RB, 0 ) and ( GG, GB, BB, 0 ).
+			 */
+			static void applyOuterRGB( Image& dst_RR_RG_RB, Image& dst_GG_GB_BB, const Image& src, Accumulator acc = ACCUMULATE_FLOAT );
+
+			/**
+			  Table of src1( x, y ) * src2( x + dx, y + dy ), src2 is sampled bilinearly and is zero outside.
+			 */
+			static void applyShifted( Image& dst, const Image& src1, const Image& src2, float dx, float dy, Accumulator acc = ACCUMULATE_FLOAT );
+
+			/**
+			  Table of an arbitrary source into a float image with 1, 2 or 4 channels.
+			 */
+			static void apply( Image& dst, const RowSource& src, Accumulator acc = ACCUMULATE_FLOAT );
+
+			/**
+			  Tables into plain buffers of height rows with width * channels values, stride in bytes.
+			  The int64_t version rounds the generated values to integers.
+			 */
+			static void table( float* dst, size_t stride, const RowSource& src );
+			static void table( double* dst, size_t stride, const RowSource& src );
+			static void table( int64_t* dst, size_t stride, const RowSource& src );
+
+			/**
+			  Mean of the ( 2 * radius + 1 )^2 window inside the image computed from a float table.
+			  dst gets the format of the table, except for GRAY_UINT8 dst images and single channel tables.
+			 */
+			static void boxFilter( Image& dst, const Image& table, int radius );
+
+		private:
+			IntegralFilterCPU();
+			IntegralFilterCPU( const IntegralFilterCPU& );
+	};
+}
+
+#endif
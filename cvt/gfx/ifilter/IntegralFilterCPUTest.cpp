@@ -0,0 +1,275 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ifilter/IntegralFilterCPU.h>
+#include <cvt/gfx/ifilter/IntegralFilter.h>
+#include <cvt/gfx/ifilter/BoxFilter.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/math/Math.h>
+
+#include <vector>
+
+namespace cvt {
+
+	static void _ifRandomImage( Image& img, size_t w, size_t h, const IFormat& format )
+	{
+		img.reallocate( w, h, format );
+		IMapScoped<uint8_t> map( img );
+		const size_t n = w * format.channels;
+		for( size_t y = 0; y < h; y++ ) {
+			for( size_t x = 0; x < n; x++ ) {
+				if( format.type == IFORMAT_TYPE_UINT8 )
+					map.ptr()[ x ] = ( uint8_t ) Math::rand( 0, 256 );
+				else
+					( ( float* ) map.ptr() )[ x ] = Math::rand( 0.0f, 1.0f );
+			}
+			map++;
+		}
+	}
+
+	/* values of an uint8 or float image as double, uint8 scaled to [ 0, 1 ] */
+	static void _ifValues( std::vector<double>& v, const Image& img, bool normalize = true )
+	{
+		const size_t n = img.width() * img.channels();
+		v.resize( n * img.height() );
+		IMapScoped<const uint8_t> map( img );
+		for( size_t y = 0; y < img.height(); y++ ) {
+			for( size_t x = 0; x < n; x++ ) {
+				if( img.format().type == IFORMAT_TYPE_UINT8 )
+					v[ y * n + x ] = map.ptr()[ x ] / ( normalize ? 255.0 : 1.0 );
+				else
+					v[ y * n + x ] = ( ( const float* ) map.ptr() )[ x ];
+			}
+			map++;
+		}
+	}
+
+	static void _ifReference( std::vector<double>& sat, const std::vector<double>& v, size_t w, size_t h, size_t c )
+	{
+		sat.assign( w * h * c, 0.0 );
+		for( size_t y = 0; y < h; y++ )
+			for( size_t x = 0; x < w; x++ )
+				for( size_t k = 0; k < c; k++ ) {
+					double s = v[ ( y * w + x ) * c + k ];
+					if( x ) s += sat[ ( y * w + x - 1 ) * c + k ];
+					if( y ) s += sat[ ( ( y - 1 ) * w + x ) * c + k ];
+					if( x && y ) s -= sat[ ( ( y - 1 ) * w + x - 1 ) * c + k ];
+					sat[ ( y * w + x ) * c + k ] = s;
+				}
+	}
+
+	/* maximal error relative to the largest value of the reference */
+	static double _ifRelError( const std::vector<double>& ref, const Image& img )
+	{
+		const size_t n = img.width() * img.channels();
+		IMapScoped<const float> map( img );
+		double err = 0.0, maxval = 1e-12;
+		for( size_t y = 0; y < img.height(); y++ ) {
+			for( size_t x = 0; x < n; x++ ) {
+				err = Math::max( err, Math::abs( map.ptr()[ x ] - ref[ y * n + x ] ) );
+				maxval = Math::max( maxval, Math::abs( ref[ y * n + x ] ) );
+			}
+			map++;
+		}
+		return err / maxval;
+	}
+
+	struct IFApply {
+		IFApply( const Image& s ) : src( s ) {}
+		void operator()( Image& out ) const { IntegralFilterCPU::apply( out, src ); }
+		const Image& src;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( IntegralFilterCPU )
+	bool result = true;
+	bool b;
+	Image rgba, rgba2, gray, out, out2;
+	std::vector<double> v, v2, ref;
+
+	srand( 11 );
+
+	/* the SIMD row scan against the scalar version */
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		std::vector<float> src( 4 * 37 ), prev( 4 * 37 ), r0( 4 * 37 ), r1( 4 * 37 );
+		for( size_t i = 0; i < src.size(); i++ ) {
+			src[ i ] = Math::rand( -1.0f, 1.0f );
+			prev[ i ] = Math::rand( -1.0f, 1.0f );
+		}
+		b = true;
+		for( int t = SIMD_BASE; t <= SIMD::bestSupportedType(); t++ ) {
+			SIMD* simd = SIMD::get( ( SIMDType ) t );
+			for( size_t c = 1; c <= 4; c++ ) {
+				base->prefixSumRow_f_to_f( &r0[ 0 ], &src[ 0 ], &prev[ 0 ], 37, c );
+				simd->prefixSumRow_f_to_f( &r1[ 0 ], &src[ 0 ], c & 1 ? &prev[ 0 ] : NULL, 37, c );
+				for( size_t i = 0; i < 37 * c; i++ )
+					b &= Math::abs( r0[ i ] - r1[ i ] - ( c & 1 ? 0.0f : prev[ i ] ) ) < 1e-4f;
+			}
+			delete simd;
+		}
+		delete base;
+	}
+	CVTTEST_PRINT( "prefixSumRow_f_to_f", b );
+	result &= b;
+
+	/* several blocks of rows */
+	_ifRandomImage( rgba, 53, 150, IFormat::RGBA_UINT8 );
+	_ifRandomImage( rgba2, 53, 150, IFormat::RGBA_FLOAT );
+	_ifValues( v, rgba );
+	_ifValues( v2, rgba2 );
+
+	IntegralFilterCPU::apply( out, rgba );
+	_ifReference( ref, v, 53, 150, 4 );
+	b = out.format() == IFormat::RGBA_FLOAT && _ifRelError( ref, out ) < 1e-6;
+	CVTTEST_PRINT( "sum", b );
+	result &= b;
+
+	IntegralFilterCPU::apply( out, rgba, &rgba );
+	IntegralFilterCPU::apply( out2, rgba, &rgba, IntegralFilterCPU::ACCUMULATE_DOUBLE );
+	for( size_t i = 0; i < v.size(); i++ )
+		v[ i ] *= v[ i ];
+	_ifReference( ref, v, 53, 150, 4 );
+	b = _ifRelError( ref, out2 ) < 1e-6 && _ifRelError( ref, out2 ) <= _ifRelError( ref, out );
+	CVTTEST_PRINT( "squared sum, double accumulation", b );
+	result &= b;
+
+	_ifValues( v, rgba );
+	IntegralFilter intfilter;
+	intfilter.apply( out, rgba, &rgba2, IFILTER_CPU );
+	for( size_t i = 0; i < v.size(); i++ )
+		v2[ i ] *= v[ i ];
+	_ifReference( ref, v2, 53, 150, 4 );
+	b = _ifRelError( ref, out ) < 1e-6;
+	CVTTEST_PRINT( "product", b );
+	result &= b;
+
+	/* outer product of the colours */
+	{
+		Image outgb;
+		IntegralFilterCPU::applyOuterRGB( out, outgb, rgba );
+		std::vector<double> o1( v.size() ), o2( v.size() ), ref2;
+		for( size_t i = 0; i < v.size(); i += 4 ) {
+			o1[ i ] = v[ i ] * v[ i ];
+			o1[ i + 1 ] = v[ i ] * v[ i + 1 ];
+			o1[ i + 2 ] = v[ i ] * v[ i + 2 ];
+			o2[ i ] = v[ i + 1 ] * v[ i + 1 ];
+			o2[ i + 1 ] = v[ i + 1 ] * v[ i + 2 ];
+			o2[ i + 2 ] = v[ i + 2 ] * v[ i + 2 ];
+			o1[ i + 3 ] = o2[ i + 3 ] = 0.0;
+		}
+		_ifReference( ref, o1, 53, 150, 4 );
+		_ifReference( ref2, o2, 53, 150, 4 );
+		b = _ifRelError( ref, out ) < 1e-6 && _ifRelError( ref2, outgb ) < 1e-6;
+	}
+	CVTTEST_PRINT( "outer product RGB", b );
+	result &= b;
+
+	/* product with a bilinearly shifted image, zero outside */
+	{
+		const float dx = -2.25f, dy = 3.5f;
+		std::vector<double> s( v.size() );
+		_ifValues( v2, rgba2 );
+		for( int y = 0; y < 150; y++ )
+			for( int x = 0; x < 53; x++ )
+				for( int k = 0; k < 4; k++ ) {
+					double sx = x + dx, sy = y + dy;
+					int x0 = Math::floor( sx ), y0 = Math::floor( sy );
+					double ax = sx - x0, ay = sy - y0, val = 0.0;
+					for( int j = 0; j < 2; j++ )
+						for( int i = 0; i < 2; i++ ) {
+							int xx = x0 + i, yy = y0 + j;
+							if( xx >= 0 && xx < 53 && yy >= 0 && yy < 150 )
+								val += ( i ? ax : 1.0 - ax ) * ( j ? ay : 1.0 - ay ) * v2[ ( yy * 53 + xx ) * 4 + k ];
+						}
+					s[ ( y * 53 + x ) * 4 + k ] = v[ ( y * 53 + x ) * 4 + k ] * val;
+				}
+		IntegralFilterCPU::applyShifted( out, rgba, rgba2, dx, dy );
+		_ifReference( ref, s, 53, 150, 4 );
+		b = _ifRelError( ref, out ) < 1e-6;
+	}
+	CVTTEST_PRINT( "shifted product", b );
+	result &= b;
+
+	/* exact integer tables and Image::integralImage */
+	_ifRandomImage( gray, 301, 257, IFormat::GRAY_UINT8 );
+	_ifValues( v, gray, false );
+	_ifReference( ref, v, 301, 257, 1 );
+	{
+		std::vector<int64_t> t( 301 * 257 );
+		IntegralFilterCPU::ImageSource src( gray, NULL, false );
+		IntegralFilterCPU::table( &t[ 0 ], 301 * sizeof( int64_t ), src );
+		b = true;
+		for( size_t i = 0; i < t.size(); i++ )
+			b &= ( double ) t[ i ] == ref[ i ];
+	}
+	CVTTEST_PRINT( "int64 table", b );
+	result &= b;
+
+	gray.integralImage( out );
+	b = out.format() == IFormat::GRAY_FLOAT && _ifRelError( ref, out ) < 1e-6;
+	CVTTEST_PRINT( "Image::integralImage", b );
+	result &= b;
+
+	IntegralFilterCPU::apply( out, rgba2 );
+	b = testThreadInvariance<Image>( IFApply( rgba2 ), testImagesEqual );
+	CVTTEST_PRINT( "independent of the number of threads", b );
+	result &= b;
+
+	/* box filter with clipped windows from the table */
+	{
+		const int r = 3;
+		BoxFilter box;
+		Image mean;
+		box.apply( mean, out, r, IFILTER_CPU );
+		_ifValues( v, rgba2 );
+		IMapScoped<const float> map( mean );
+		b = mean.format() == IFormat::RGBA_FLOAT;
+		for( int y = 0; y < 150; y++ ) {
+			for( int x = 0; x < 53; x++ ) {
+				for( int k = 0; k < 4; k++ ) {
+					double s = 0.0, n = 0.0;
+					for( int j = Math::max( y - r, 0 ); j <= Math::min( y + r, 149 ); j++ )
+						for( int i = Math::max( x - r, 0 ); i <= Math::min( x + r, 52 ); i++ ) {
+							s += v[ ( j * 53 + i ) * 4 + k ];
+							n += 1.0;
+						}
+					b &= Math::abs( map.ptr()[ x * 4 + k ] - s / n ) < 1e-3;
+				}
+			}
+			map++;
+		}
+	}
+	CVTTEST_PRINT( "box filter", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
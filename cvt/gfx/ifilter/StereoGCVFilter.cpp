@@ -35,6 +35,13 @@
 #include <cvt/cl/kernel/gradx.h>
 
 #include <gfx/ifilter/GuidedFilter.h>
+#include <cvt/gfx/ifilter/GuidedFilterCPU.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/Mutex.h>
+#include <cvt/util/SIMD.h>
+
+#include <vector>
 
 namespace cvt {
 	static ParamInfoTyped<Image*> pin0( "Input 0", true );
@@ -54,22 +61,48 @@ namespace cvt {
 	};
 
 	StereoGCVFilter::StereoGCVFilter() :
-		IFilter( "StereoGCVFilter", _params, 6, IFILTER_CPU | IFILTER_OPENCL ),
-		_cldepthcost( _costdepth_source, "stereogcv_costdepth" ),
-		_cldepthcostgrad( _costdepthgrad_source, "stereogcv_costdepthgrad" ),
-		_cldepthcostncc( _costdepthncc_source, "stereogcv_costdepthncc" ),
-		_cldepthmin( _costmin_source, "stereogcv_costmin" ),
-		_clfill( _fill_source, "fill" ),
-		_clcdconv( _costdepthconv_source, "stereogcv_costdepthconv" ),
-		_clgrad( _gradx_source, "gradx" ),
-		_clguidedfilter_calcab_outerrgb( _guidedfilter_calcab_outerrgb_source, "guidedfilter_calcab_outerrgb" ),
-		_clguidedfilter_applyab_gc_outer( _guidedfilter_applyab_gc_outer_source, "guidedfilter_applyab_gc_outer" ),
-		_clocclusioncheck( _occlusioncheck_source, "stereogcv_occlusioncheck" )
+		IFilter( "StereoGCVFilter", _params, 6, IFILTER_CPU | IFILTER_OPENCL )
+	{
+	}
+
+	void StereoGCVFilter::initCL() const
+	{
+		if( ( cl_kernel ) _cldepthcost != NULL )
+			return;
+
+		_cldepthcost = CLKernel( _costdepth_source, "stereogcv_costdepth" );
+		_cldepthcostgrad = CLKernel( _costdepthgrad_source, "stereogcv_costdepthgrad" );
+		_cldepthcostncc = CLKernel( _costdepthncc_source, "stereogcv_costdepthncc" );
+		_cldepthmin = CLKernel( _costmin_source, "stereogcv_costmin" );
+		_clfill = CLKernel( _fill_source, "fill" );
+		_clcdconv = CLKernel( _costdepthconv_source, "stereogcv_costdepthconv" );
+		_clgrad = CLKernel( _gradx_source, "gradx" );
+		_clguidedfilter_calcab_outerrgb = CLKernel( _guidedfilter_calcab_outerrgb_source, "guidedfilter_calcab_outerrgb" );
+		_clguidedfilter_applyab_gc_outer = CLKernel( _guidedfilter_applyab_gc_outer_source, "guidedfilter_applyab_gc_outer" );
+		_clocclusioncheck = CLKernel( _occlusioncheck_source, "stereogcv_occlusioncheck" );
+	}
+
+	void StereoGCVFilter::apply( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt, IFilterType type ) const
 	{
+		if( cam0.width() != cam1.width() || cam0.height() != cam1.height() )
+			throw CVTException( "Stereo images inconsistent" );
+
+		switch( type ) {
+			case IFILTER_OPENCL:
+				applyCL( dst, cam0, cam1, dmin, dmax, dt );
+				break;
+			case IFILTER_CPU:
+				applyCPU( dst, cam0, cam1, dmin, dmax, dt );
+				break;
+			default:
+				throw CVTException( "Not implemented" );
+		}
 	}
 
-	void StereoGCVFilter::apply( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt ) const
+	void StereoGCVFilter::applyCL( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt ) const
 	{
+		initCL();
+
 		Image d0( cam0.width(), cam0.height(), IFormat::GRAY_FLOAT, IALLOCATOR_CL );
 		Image d1( cam0.width(), cam0.height(), IFormat::GRAY_FLOAT, IALLOCATOR_CL );
 
@@ -243,6 +276,235 @@ namespace cvt {
 		_clcdconv.run( global, CLNDRange( 16, 16 ) );
 	}
 
-}
 
+	/* the values of stereogcv_costdepthgrad and stereogcv_occlusioncheck */
+#define GCV_COSTTHRESHOLD 0.028f
+#define GCV_COSTTHRESHOLDGRAD 0.008f
+#define GCV_ALPHA 0.10f
+#define GCV_MAXDIFF 2.0f
 
+	/* RGBA float copy of the image and its horizontal central differences ( gradx ) */
+	static void _gcvPrepare( std::vector<float>& img, std::vector<float>& grad, const Image& src )
+	{
+		const size_t w = src.width(), h = src.height();
+		Image tmp;
+		src.convert( tmp, IFormat::RGBA_FLOAT );
+
+		img.resize( 4 * w * h );
+		grad.resize( 4 * w * h );
+		IMapScoped<const float> map( tmp );
+		for( size_t y = 0; y < h; y++ ) {
+			memcpy( &img[ 4 * w * y ], map.ptr(), sizeof( float ) * 4 * w );
+			map++;
+		}
+
+		for( size_t y = 0; y < h; y++ ) {
+			const float* row = &img[ 4 * w * y ];
+			float* g = &grad[ 4 * w * y ];
+			for( size_t x = 0; x < w; x++ ) {
+				const float* l = row + 4 * ( x > 0 ? x - 1 : 0 );
+				const float* r = row + 4 * Math::min( x + 1, w - 1 );
+				for( size_t c = 0; c < 4; c++ )
+					*g++ = r[ c ] - l[ c ];
+			}
+		}
+	}
+
+	/* one slice of the cost volume: truncated colour and gradient difference of the reference to the other image shifted by the disparity */
+	class StereoGCVCostSource : public GuidedFilterCPU::RowSource
+	{
+		public:
+			StereoGCVCostSource( const std::vector<float>& ref, const std::vector<float>& refgrad,
+								 const std::vector<float>& other, const std::vector<float>& othergrad, size_t width ) :
+				_ref( &ref[ 0 ] ), _refgrad( &refgrad[ 0 ] ), _other( &other[ 0 ] ), _othergrad( &othergrad[ 0 ] ), _width( width ), _disparity( 0.0f )
+			{
+			}
+
+			void setDisparity( float d ) { _disparity = d; }
+
+			void row( float* dst, size_t y ) const
+			{
+				const size_t w = _width;
+				const float* i0 = _ref + 4 * w * y;
+				const float* g0 = _refgrad + 4 * w * y;
+				const float* i1 = _other + 4 * w * y;
+				const float* g1 = _othergrad + 4 * w * y;
+
+				for( size_t x = 0; x < w; x++, i0 += 4, g0 += 4 ) {
+					float pos = ( float ) x - _disparity;
+					if( pos < -0.5f || pos >= ( float ) w - 0.5f ) {
+						dst[ x ] = GCV_COSTTHRESHOLDGRAD + GCV_COSTTHRESHOLD;
+						continue;
+					}
+
+					/* linear interpolation with clamping like the image sampler */
+					float fx = Math::floor( pos );
+					float alpha = pos - fx;
+					int ix = ( int ) fx;
+					size_t xa = ( size_t ) Math::clamp<int>( ix, 0, w - 1 );
+					size_t xb = ( size_t ) Math::clamp<int>( ix + 1, 0, w - 1 );
+
+					float ci = 0.0f, cg = 0.0f;
+					for( size_t c = 0; c < 3; c++ ) {
+						ci += Math::abs( Math::mix( i1[ 4 * xa + c ], i1[ 4 * xb + c ], alpha ) - i0[ c ] );
+						cg += Math::abs( Math::mix( g1[ 4 * xa + c ], g1[ 4 * xb + c ], alpha ) - g0[ c ] );
+					}
+					ci = Math::min( ci * 0.3333f, GCV_COSTTHRESHOLD );
+					cg = Math::min( cg * 0.3333f, GCV_COSTTHRESHOLDGRAD );
+					dst[ x ] = Math::mix( ci, cg, GCV_ALPHA );
+				}
+			}
+
+		private:
+			const float*	_ref;
+			const float*	_refgrad;
+			const float*	_other;
+			const float*	_othergrad;
+			size_t			_width;
+			float			_disparity;
+	};
+
+	/* winner-takes-all over the filtered slices, the first slice wins on equal cost */
+	class StereoGCVWTASink : public GuidedFilterCPU::RowSink
+	{
+		public:
+			StereoGCVWTASink( float* cost, float* value, size_t width ) : _cost( cost ), _value( value ), _width( width ), _current( 0.0f )
+			{
+			}
+
+			void setValue( float v ) { _current = v; }
+
+			void row( const float* src, size_t y ) const
+			{
+				float* cost = _cost + y * _width;
+				float* value = _value + y * _width;
+				for( size_t x = 0; x < _width; x++ ) {
+					if( src[ x ] < cost[ x ] ) {
+						cost[ x ] = src[ x ];
+						value[ x ] = _current;
+					}
+				}
+			}
+
+		private:
+			float*	_cost;
+			float*	_value;
+			size_t	_width;
+			float	_current;
+	};
+
+	/* every chunk of slices keeps its own minimum, merged in the end with the same tie breaking as the sequential order */
+	class StereoGCVSlices
+	{
+		public:
+			StereoGCVSlices( const GuidedFilterCPU& gf, const StereoGCVCostSource& cost, float dmin, float dmax, float dt,
+							 float* bestcost, float* bestvalue, Mutex& mutex ) :
+				_gf( gf ), _cost( cost ), _dmin( dmin ), _dmax( dmax ), _dt( dt ), _bestcost( bestcost ), _bestvalue( bestvalue ), _mutex( mutex )
+			{
+			}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				const size_t n = _gf.width() * _gf.height();
+				std::vector<float> coeff( _gf.coefficientSize( 1 ) );
+				std::vector<float> cost( n, 1e9f );
+				std::vector<float> value( n, 0.0f );
+				StereoGCVCostSource src( _cost );
+				StereoGCVWTASink sink( &cost[ 0 ], &value[ 0 ], _gf.width() );
+
+				for( size_t i = start; i < end; i++ ) {
+					float d = _dmin + ( float ) i * _dt;
+					src.setDisparity( d );
+					sink.setValue( Math::abs( d - _dmin ) / Math::abs( _dmax - _dmin ) );
+					_gf.apply( sink, src, 1, &coeff[ 0 ] );
+				}
+
+				_mutex.lock();
+				for( size_t i = 0; i < n; i++ ) {
+					if( cost[ i ] < _bestcost[ i ] || ( cost[ i ] == _bestcost[ i ] && value[ i ] < _bestvalue[ i ] ) ) {
+						_bestcost[ i ] = cost[ i ];
+						_bestvalue[ i ] = value[ i ];
+					}
+				}
+				_mutex.unlock();
+			}
+
+		private:
+			const GuidedFilterCPU&		_gf;
+			const StereoGCVCostSource&	_cost;
+			float						_dmin, _dmax, _dt;
+			float*						_bestcost;
+			float*						_bestvalue;
+			Mutex&						_mutex;
+	};
+
+	void StereoGCVFilter::applyCPU( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt ) const
+	{
+		const size_t w = cam0.width(), h = cam0.height();
+		Image d0, d1;
+
+		depthmapCPU( d0, cam0, cam1, dmin, dmax, dt );
+		depthmapCPU( d1, cam1, cam0, -dmin, -dmax, -dt );
+
+		/* stereogcv_occlusioncheck, the result is stored linear like the unorm image of the kernel */
+		const float dscale = Math::abs( dmax );
+		dst.reallocate( w, h, IFormat::GRAY_UINT8 );
+		std::vector<float> row( w );
+		SIMD* simd = SIMD::instance();
+
+		IMapScoped<uint8_t> mapout( dst );
+		IMapScoped<const float> map0( d0 );
+		IMapScoped<const float> map1( d1 );
+		for( size_t y = 0; y < h; y++ ) {
+			const float* p0 = map0.ptr();
+			const float* p1 = map1.ptr();
+			for( size_t x = 0; x < w; x++ ) {
+				float din0 = p0[ x ];
+				float pos = Math::clamp( ( float ) x - din0 * dscale, 0.0f, ( float ) ( w - 1 ) );
+				size_t xa = ( size_t ) pos;
+				size_t xb = Math::min( xa + 1, w - 1 );
+				float din1 = Math::mix( p1[ xa ], p1[ xb ], pos - ( float ) xa );
+				float diff = Math::abs( din1 * dscale - din0 * dscale );
+				row[ x ] = diff <= GCV_MAXDIFF ? ( din0 + din1 ) * 0.5f : 0.0f;
+			}
+			simd->Conv_f_to_u8( mapout.ptr(), &row[ 0 ], w );
+			mapout++;
+			map0++;
+			map1++;
+		}
+	}
+
+	void StereoGCVFilter::depthmapCPU( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt ) const
+	{
+		const size_t w = cam0.width(), h = cam0.height();
+		std::vector<float> img0, grad0, img1, grad1;
+
+		/* cam1 is the reference and the guide like in depthmap */
+		_gcvPrepare( img0, grad0, cam0 );
+		_gcvPrepare( img1, grad1, cam1 );
+
+		GuidedFilterCPU gf( cam1, RADIUS, EPSILON, true );
+		gf.precompute();
+
+		if( dmax < dmin && dt > 0 ) dt = -dt;
+		size_t n = Math::abs( dmax - dmin ) / Math::abs( dt );
+
+		std::vector<float> cost( w * h, 1e9f );
+		std::vector<float> value( w * h, 0.0f );
+		Mutex mutex;
+		StereoGCVCostSource src( img1, grad1, img0, grad0, w );
+		ParallelFor::run( StereoGCVSlices( gf, src, dmin, dmax, dt, &cost[ 0 ], &value[ 0 ], mutex ), 0, n );
+
+		/* stereogcv_costdepthconv */
+		dst.reallocate( w, h, IFormat::GRAY_FLOAT );
+		IMapScoped<float> map( dst );
+		for( size_t y = 0; y < h; y++ ) {
+			float* ptr = map.ptr();
+			for( size_t x = 0; x < w; x++ ) {
+				float v = value[ y * w + x ];
+				ptr[ x ] = v >= 1.0f ? 0.0f : v;
+			}
+			map++;
+		}
+	}
+}
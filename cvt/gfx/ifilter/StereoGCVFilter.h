@@ -31,28 +31,37 @@
 #include <cvt/cl/CLKernel.h>
 
 namespace cvt {
+	/**
+	  Stereo from a cost volume filtered with the guided filter. With IFILTER_CPU the slices of the
+	  volume are filtered in parallel and reduced by a streaming winner-takes-all, the volume itself
+	  is never stored.
+	 */
 	class StereoGCVFilter : public IFilter {
 		public:
 					StereoGCVFilter();
 					~StereoGCVFilter();
 
-			void	apply( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt = 1.0f ) const;
+			void	apply( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt = 1.0f, IFilterType type = IFILTER_OPENCL ) const;
 			void	apply( const ParamSet* attribs, IFilterType iftype ) const {}
 
 		private:
+			void	initCL() const;
+			void	applyCL( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt ) const;
+			void	applyCPU( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt ) const;
 			void	depthmap( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt = 1.0f ) const;
+			void	depthmapCPU( Image& dst, const Image& cam0, const Image& cam1, float dmin, float dmax, float dt ) const;
 
-			CLKernel		_cldepthcost;
-			CLKernel		_cldepthcostgrad;
-			CLKernel		_cldepthcostncc;
-			CLKernel		_cldepthmin;
-			CLKernel		_clfill;
-			CLKernel		_clcdconv;
-			CLKernel		_clgrad;
+			mutable CLKernel		_cldepthcost;
+			mutable CLKernel		_cldepthcostgrad;
+			mutable CLKernel		_cldepthcostncc;
+			mutable CLKernel		_cldepthmin;
+			mutable CLKernel		_clfill;
+			mutable CLKernel		_clcdconv;
+			mutable CLKernel		_clgrad;
 //			CLKernel		_cldepthrefine;
-			CLKernel	   _clguidedfilter_calcab_outerrgb;
-			CLKernel	   _clguidedfilter_applyab_gc_outer;
-			CLKernel	   _clocclusioncheck;
+			mutable CLKernel	   _clguidedfilter_calcab_outerrgb;
+			mutable CLKernel	   _clguidedfilter_applyab_gc_outer;
+			mutable CLKernel	   _clocclusioncheck;
 			IntegralFilter _intfilter;
 			BoxFilter	   _boxfilter;
 
@@ -0,0 +1,99 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ifilter/StereoGCVFilter.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace cvt {
+
+	/* coloured texture, shifted horizontally by dx */
+	static void _gcvTexture( Image& img, float dx )
+	{
+		img.reallocate( 64, 48, IFormat::RGBA_FLOAT );
+		IMapScoped<float> map( img );
+		for( size_t y = 0; y < img.height(); y++ ) {
+			float* ptr = map.ptr();
+			for( size_t x = 0; x < img.width(); x++ ) {
+				float fx = ( float ) x - dx;
+				float fy = ( float ) y;
+				*ptr++ = 0.5f + 0.25f * Math::sin( 0.61f * fx + 0.23f * fy ) + 0.2f * Math::sin( 0.17f * fx - 0.47f * fy + 1.0f );
+				*ptr++ = 0.5f + 0.3f * Math::sin( -0.39f * fx + 0.53f * fy + 0.5f ) + 0.15f * Math::cos( 0.83f * fx );
+				*ptr++ = 0.5f + 0.35f * Math::cos( 0.29f * fx + 0.71f * fy + 2.0f );
+				*ptr++ = 1.0f;
+			}
+			map++;
+		}
+	}
+
+	struct GCVApply {
+		GCVApply( const StereoGCVFilter& g, const Image& c0, const Image& c1 ) : gcv( g ), cam0( c0 ), cam1( c1 ) {}
+		void operator()( Image& disp ) const { gcv.apply( disp, cam0, cam1, 0.0f, 16.0f, 1.0f, IFILTER_CPU ); }
+		const StereoGCVFilter&	gcv;
+		const Image&			cam0;
+		const Image&			cam1;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( StereoGCVFilter )
+	bool result = true;
+	bool b;
+	Image cam0, cam1, disp;
+
+	/* disparity of 5 pixels with a range of 16: the normalised result is 5 / 16 */
+	_gcvTexture( cam0, -5.0f );
+	_gcvTexture( cam1, 0.0f );
+
+	StereoGCVFilter gcv;
+	gcv.apply( disp, cam0, cam1, 0.0f, 16.0f, 1.0f, IFILTER_CPU );
+
+	std::vector<int> values;
+	{
+		IMapScoped<const uint8_t> map( disp );
+		for( size_t y = 0; y < disp.height(); y++ ) {
+			for( size_t x = 16; x + 8 < disp.width(); x++ )
+				values.push_back( map.ptr()[ x ] );
+			map++;
+		}
+	}
+	std::nth_element( values.begin(), values.begin() + values.size() / 2, values.end() );
+	b = disp.format() == IFormat::GRAY_UINT8 && Math::abs( values[ values.size() / 2 ] - 80 ) <= 1;
+	CVTTEST_PRINT( "CPU disparity of a shifted image", b );
+	result &= b;
+
+	b = testThreadInvariance<Image>( GCVApply( gcv, cam0, cam1 ), testImagesEqual );
+	CVTTEST_PRINT( "CPU disparity independent of the number of threads", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
@@ -0,0 +1,348 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ifilter/TVDenoise.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/Exception.h>
+
+namespace cvt {
+
+	/* rows per parallel block, the energies are summed per block so the gap does not depend on the number of threads */
+#define TVDENOISE_ROWS 16
+
+	/* dual ascent of a range of rows, the rows of all channels are stacked */
+	class TVDenoise::DualBody
+	{
+		public:
+			DualBody( const TVDenoise& tv, float* px, float* py ) : _tv( tv ), _px( px ), _py( py )
+			{
+			}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t w = _tv._width;
+				const std::vector<float>& ubar = _tv._ubar;
+				for( size_t r = start; r < end; r++ ) {
+					size_t y = r % _tv._height;
+					const float* unext = y + 1 < _tv._height ? &ubar[ ( r + 1 ) * w ] : NULL;
+					const float* g = _tv._g.empty() ? NULL : &_tv._g[ y * w ];
+					simd->pdtvDual1_f( _px + r * w, _py + r * w, &ubar[ r * w ], unext, g, w, _tv._sigma, _tv._epsilon );
+				}
+			}
+
+		private:
+			const TVDenoise&	_tv;
+			float*				_px;
+			float*				_py;
+	};
+
+	/* primal descent and extrapolation of a range of rows */
+	class TVDenoise::PrimalBody
+	{
+		public:
+			PrimalBody( const TVDenoise& tv, float* u, float* ubar ) : _tv( tv ), _u( u ), _ubar( ubar )
+			{
+			}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t w = _tv._width;
+				const std::vector<float>& px = _tv._px;
+				const std::vector<float>& py = _tv._py;
+				for( size_t r = start; r < end; r++ ) {
+					size_t y = r % _tv._height;
+					const float* pyprev = y > 0 ? &py[ ( r - 1 ) * w ] : NULL;
+					const float* lambda = _tv._m.empty() ? NULL : &_tv._m[ y * w ];
+					simd->pdtvPrimal1_f( _u + r * w, _ubar + r * w, &px[ r * w ], &py[ r * w ], pyprev, &_tv._f[ r * w ], lambda, _tv._lambda, w,
+										 _tv._tau, _tv._theta, _tv._model == TVMODEL_L1 );
+				}
+			}
+
+		private:
+			const TVDenoise&	_tv;
+			float*				_u;
+			float*				_ubar;
+	};
+
+	/* data term minus the linear term v * u, minimized over u in [ fmin, fmax ] */
+	static inline double _tvDataConjugate( TVModel model, double lambda, double f, double v, double fmin, double fmax )
+	{
+		if( model == TVMODEL_ROF ) {
+			double u = lambda > 0.0 ? Math::clamp( f + v / lambda, fmin, fmax ) : ( v > 0.0 ? fmax : fmin );
+			return 0.5 * lambda * Math::sqr( u - f ) - v * u;
+		}
+
+		double e = Math::min( lambda * Math::abs( fmin - f ) - v * fmin, lambda * Math::abs( fmax - f ) - v * fmax );
+		if( lambda > 0.0 )
+			e = Math::min( e, -v * f );
+		return e;
+	}
+
+	/* primal and dual energy of a range of row blocks */
+	class TVDenoise::EnergyBody
+	{
+		public:
+			EnergyBody( const TVDenoise& tv, double* eprimal, double* edual ) : _tv( tv ), _eprimal( eprimal ), _edual( edual )
+			{
+			}
+
+			void operator()( size_t start, size_t end ) const
+			{
+				const size_t w = _tv._width, h = _tv._height;
+				const size_t rows = _tv._channels * h;
+				const double eps = _tv._epsilon;
+				const TVModel model = _tv._model;
+				const std::vector<float>& gw = _tv._g;
+				const std::vector<float>& mw = _tv._m;
+
+				for( size_t b = start; b < end; b++ ) {
+					double ep = 0.0, ed = 0.0;
+					for( size_t r = b * TVDENOISE_ROWS; r < Math::min( rows, ( b + 1 ) * TVDENOISE_ROWS ); r++ ) {
+						size_t y = r % h;
+						const float* u = &_tv._u[ r * w ];
+						const float* f = &_tv._f[ r * w ];
+						const float* px = &_tv._px[ r * w ];
+						const float* py = &_tv._py[ r * w ];
+						for( size_t x = 0; x < w; x++ ) {
+							double g = gw.empty() ? 1.0 : gw[ y * w + x ];
+							double lambda = mw.empty() ? _tv._lambda : mw[ y * w + x ];
+
+							/* primal: weighted huber of the gradient and the data term */
+							double dx = x + 1 < w ? u[ x + 1 ] - u[ x ] : 0.0;
+							double dy = y + 1 < h ? u[ x + w ] - u[ x ] : 0.0;
+							double n = Math::sqrt( dx * dx + dy * dy );
+							if( eps > 0.0 )
+								n = n <= eps ? n * n / ( 2.0 * eps ) : n - 0.5 * eps;
+							double d = u[ x ] - f[ x ];
+							ep += g * n + ( model == TVMODEL_ROF ? 0.5 * lambda * d * d : lambda * Math::abs( d ) );
+
+							/* dual: conjugate of the huber and of the data term at div p */
+							if( eps > 0.0 && g > 0.0 )
+								ed -= eps / ( 2.0 * g ) * ( ( double ) px[ x ] * px[ x ] + ( double ) py[ x ] * py[ x ] );
+							double v = ( double ) px[ x ] - ( x > 0 ? px[ x - 1 ] : 0.0 ) + py[ x ] - ( y > 0 ? py[ x - w ] : 0.0 );
+							ed += _tvDataConjugate( model, lambda, f[ x ], v, _tv._fmin, _tv._fmax );
+						}
+					}
+					_eprimal[ b ] = ep;
+					_edual[ b ] = ed;
+				}
+			}
+
+		private:
+			const TVDenoise&	_tv;
+			double*				_eprimal;
+			double*				_edual;
+	};
+
+	TVDenoise::TVDenoise( TVModel model, float lambda, float epsilon ) :
+		_model( model ),
+		_lambda( lambda ),
+		_epsilon( epsilon ),
+		_maxiter( 1000 ),
+		_tolerance( 1e-4f ),
+		_checkinterval( 10 ),
+		_width( 0 ),
+		_height( 0 ),
+		_channels( 0 ),
+		_fmin( 0.0f ),
+		_fmax( 0.0f ),
+		_tau( 0.0f ),
+		_sigma( 0.0f ),
+		_theta( 1.0f ),
+		_iterations( 0 ),
+		_primal( 0.0 ),
+		_dual( 0.0 )
+	{
+	}
+
+	TVDenoise::~TVDenoise()
+	{
+	}
+
+	void TVDenoise::load( const Image& src, const Image* weight, const Image* mask )
+	{
+		if( src.format().type != IFORMAT_TYPE_FLOAT && src.format().type != IFORMAT_TYPE_UINT8 )
+			throw CVTException( "TVDenoise: unsupported image format!" );
+		if( weight && ( weight->format().type != IFORMAT_TYPE_FLOAT || weight->width() != src.width() || weight->height() != src.height() ) )
+			throw CVTException( "TVDenoise: the weights need to be a float image with the size of the input!" );
+		if( mask && ( ( mask->format().type != IFORMAT_TYPE_FLOAT && mask->format() != IFormat::GRAY_UINT8 ) || mask->width() != src.width() || mask->height() != src.height() ) )
+			throw CVTException( "TVDenoise: the mask needs to be a float or GRAY_UINT8 image with the size of the input!" );
+
+		SIMD* simd = SIMD::instance();
+		_width = src.width();
+		_height = src.height();
+		_channels = src.channels();
+		const size_t w = _width, h = _height, n = _width * _height;
+
+		/* planar copy of the input, one plane per channel */
+		_f.resize( n * _channels );
+		{
+			ScopedBuffer<float, true> row( w * _channels );
+			IMapScoped<const uint8_t> map( src );
+			for( size_t y = 0; y < h; y++ ) {
+				const float* s = ( const float* ) map.ptr();
+				if( src.format().type == IFORMAT_TYPE_UINT8 ) {
+					simd->Conv_u8_to_f( row.ptr(), map.ptr(), w * _channels );
+					s = row.ptr();
+				}
+				for( size_t c = 0; c < _channels; c++ ) {
+					float* d = &_f[ ( c * h + y ) * w ];
+					for( size_t x = 0; x < w; x++ )
+						d[ x ] = s[ x * _channels + c ];
+				}
+				map++;
+			}
+		}
+
+		_g.clear();
+		if( weight ) {
+			_g.resize( n );
+			IMapScoped<const float> map( *weight );
+			size_t wc = weight->channels();
+			for( size_t y = 0; y < h; y++ ) {
+				for( size_t x = 0; x < w; x++ )
+					_g[ y * w + x ] = Math::max( map.ptr()[ x * wc ], 0.0f );
+				map++;
+			}
+		}
+
+		_m.clear();
+		if( mask ) {
+			_m.resize( n );
+			IMapScoped<const uint8_t> map( *mask );
+			size_t mc = mask->channels();
+			for( size_t y = 0; y < h; y++ ) {
+				for( size_t x = 0; x < w; x++ ) {
+					float v = mask->format() == IFormat::GRAY_UINT8 ? map.ptr()[ x ] / 255.0f : ( ( const float* ) map.ptr() )[ x * mc ];
+					_m[ y * w + x ] = _lambda * Math::clamp( v, 0.0f, 1.0f );
+				}
+				map++;
+			}
+		}
+
+		/* range of the observed values */
+		_fmin = _fmax = 0.0f;
+		bool first = true;
+		for( size_t pass = 0; pass < 2 && first; pass++ ) {
+			for( size_t i = 0; i < _f.size(); i++ ) {
+				if( !pass && !_m.empty() && _m[ i % n ] <= 0.0f )
+					continue;
+				if( first ) {
+					_fmin = _fmax = _f[ i ];
+					first = false;
+				} else {
+					_fmin = Math::min( _fmin, _f[ i ] );
+					_fmax = Math::max( _fmax, _f[ i ] );
+				}
+			}
+		}
+
+		_u = _f;
+		_ubar = _f;
+		_px.assign( _f.size(), 0.0f );
+		_py.assign( _f.size(), 0.0f );
+	}
+
+	void TVDenoise::store( Image& dst, const Image& src ) const
+	{
+		SIMD* simd = SIMD::instance();
+		const size_t w = _width, h = _height;
+		IFormat format = src.format();
+
+		dst.reallocate( w, h, format );
+		ScopedBuffer<float, true> row( w * _channels );
+		IMapScoped<uint8_t> map( dst );
+		for( size_t y = 0; y < h; y++ ) {
+			float* d = format.type == IFORMAT_TYPE_UINT8 ? row.ptr() : ( float* ) map.ptr();
+			for( size_t c = 0; c < _channels; c++ ) {
+				const float* s = &_u[ ( c * h + y ) * w ];
+				for( size_t x = 0; x < w; x++ )
+					d[ x * _channels + c ] = s[ x ];
+			}
+			if( format.type == IFORMAT_TYPE_UINT8 )
+				simd->Conv_f_to_u8( map.ptr(), row.ptr(), w * _channels );
+			map++;
+		}
+	}
+
+	void TVDenoise::apply( Image& dst, const Image& src, const Image* weight, const Image* mask )
+	{
+		load( src, weight, mask );
+		const size_t rows = _channels * _height;
+
+		/* the accelerated variant needs a uniformly convex data term */
+		float gamma = 0.0f;
+		if( _model == TVMODEL_ROF ) {
+			gamma = _lambda;
+			for( size_t i = 0; i < _m.size(); i++ )
+				gamma = Math::min( gamma, _m[ i ] );
+			gamma *= 0.7f;
+		}
+
+		_tau = _sigma = 1.0f / Math::sqrt( 8.0f );
+		_theta = 1.0f;
+		_primal = _dual = 0.0;
+		_eprimal.resize( ( rows + TVDENOISE_ROWS - 1 ) / TVDENOISE_ROWS );
+		_edual.resize( _eprimal.size() );
+
+		size_t iter = 0;
+		while( iter < _maxiter && rows && _width ) {
+			ParallelFor::run( DualBody( *this, &_px[ 0 ], &_py[ 0 ] ), 0, rows, TVDENOISE_ROWS );
+			if( gamma > 0.0f )
+				_theta = 1.0f / Math::sqrt( 1.0f + 2.0f * gamma * _tau );
+			ParallelFor::run( PrimalBody( *this, &_u[ 0 ], &_ubar[ 0 ] ), 0, rows, TVDENOISE_ROWS );
+			if( gamma > 0.0f ) {
+				_tau *= _theta;
+				_sigma /= _theta;
+			}
+			iter++;
+
+			if( _tolerance > 0.0f && ( iter % _checkinterval == 0 || iter == _maxiter ) ) {
+				energies();
+				if( _primal - _dual <= _tolerance * Math::max( Math::abs( _primal ), 1e-10 ) )
+					break;
+			}
+		}
+		_iterations = iter;
+
+		store( dst, src );
+	}
+
+	void TVDenoise::energies()
+	{
+		ParallelFor::run( EnergyBody( *this, &_eprimal[ 0 ], &_edual[ 0 ] ), 0, _eprimal.size() );
+		_primal = _dual = 0.0;
+		for( size_t b = 0; b < _eprimal.size(); b++ ) {
+			_primal += _eprimal[ b ];
+			_dual += _edual[ b ];
+		}
+	}
+
+}
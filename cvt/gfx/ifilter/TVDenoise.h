@@ -0,0 +1,119 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_TVDENOISE_H
+#define CVT_TVDENOISE_H
+
+#include <cvt/gfx/Image.h>
+#include <vector>
+
+namespace cvt {
+
+	enum TVModel {
+		TVMODEL_ROF,	/* quadratic data term, lambda / 2 * ( u - f )^2 */
+		TVMODEL_L1		/* absolute data term, lambda * | u - f | */
+	};
+
+	/**
+	  @brief Total variation regularization with the primal-dual algorithm of Chambolle and Pock.
+
+	  Minimizes sum g * huber_epsilon( |grad u| ) + m * data( u, f ) with forward differences, where g are optional
+	  TV weights ( e.g. from the image edges ) and m optional data weights in [0, 1]. A mask with zeros gives
+	  inpainting, epsilon > 0 the Huber-ROF/Huber-L1 models. The channels are regularized independently.
+
+	  The dual and the primal steps are SIMD row kernels run in parallel over blocks of rows. Every checkInterval
+	  iterations the primal-dual gap is evaluated, the iterations stop as soon as gap <= tolerance * primal energy.
+	  The dual energy is taken with u restricted to the range of the observed values, which keeps the gap finite
+	  for all models without changing the minimizer. The ROF model with positive data weights uses the accelerated
+	  variant with adaptive step sizes. The buffers are kept, so a sequence of images does not reallocate.
+	 */
+	class TVDenoise {
+		public:
+			TVDenoise( TVModel model = TVMODEL_ROF, float lambda = 10.0f, float epsilon = 0.0f );
+			~TVDenoise();
+
+			void		setModel( TVModel model ) { _model = model; }
+			TVModel		model() const { return _model; }
+			void		setLambda( float lambda ) { _lambda = lambda; }
+			float		lambda() const { return _lambda; }
+			/* Huber parameter, 0 for the plain TV */
+			void		setEpsilon( float epsilon ) { _epsilon = epsilon; }
+			float		epsilon() const { return _epsilon; }
+			void		setMaxIterations( size_t iter ) { _maxiter = iter; }
+			size_t		maxIterations() const { return _maxiter; }
+			/* relative primal-dual gap to stop at, 0 runs maxIterations */
+			void		setTolerance( float tolerance ) { _tolerance = tolerance; }
+			float		tolerance() const { return _tolerance; }
+			void		setCheckInterval( size_t interval ) { _checkinterval = Math::max<size_t>( interval, 1 ); }
+			size_t		checkInterval() const { return _checkinterval; }
+
+			/**
+			  Regularizes src ( UINT8 normalized to [0, 1] or FLOAT with any number of channels ) into dst with the format of src.
+			  @param weight	TV weights, FLOAT image of the same size, the first channel is used
+			  @param mask	data term weights in [0, 1], FLOAT ( first channel ) or GRAY_UINT8 image of the same size
+			 */
+			void		apply( Image& dst, const Image& src, const Image* weight = NULL, const Image* mask = NULL );
+
+			/* iterations, gap and energies of the last apply, the gap is only known if tolerance > 0 */
+			size_t		iterations() const { return _iterations; }
+			double		gap() const { return _primal - _dual; }
+			double		primalEnergy() const { return _primal; }
+			double		dualEnergy() const { return _dual; }
+
+		private:
+			class DualBody;
+			class PrimalBody;
+			class EnergyBody;
+
+			TVDenoise( const TVDenoise& );
+			TVDenoise& operator=( const TVDenoise& );
+
+			void		load( const Image& src, const Image* weight, const Image* mask );
+			void		store( Image& dst, const Image& src ) const;
+			void		energies();
+
+			TVModel							_model;
+			float							_lambda;
+			float							_epsilon;
+			size_t							_maxiter;
+			float							_tolerance;
+			size_t							_checkinterval;
+
+			size_t							_width, _height, _channels;
+			float							_fmin, _fmax;
+			float							_tau, _sigma, _theta;
+			std::vector<float>				_u, _ubar, _px, _py;
+			std::vector<float>				_f;
+			std::vector<float>				_g;			/* TV weights per pixel or empty */
+			std::vector<float>				_m;			/* lambda * data weight per pixel or empty */
+			std::vector<double>				_eprimal, _edual;	/* energies per block of rows */
+
+			size_t							_iterations;
+			double							_primal, _dual;
+	};
+
+}
+
+#endif
@@ -0,0 +1,253 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/ifilter/TVDenoise.h>
+#include <cvt/gfx/ifilter/ROFDenoise.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/math/Math.h>
+
+#include <vector>
+
+namespace cvt {
+
+	static bool _tvKernels()
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+		bool ret = true;
+
+		for( size_t w = 1; w < 37; w++ ) {
+			std::vector<float> u( 2 * w ), g( w ), lambda( w ), f( w );
+			for( size_t i = 0; i < 2 * w; i++ )
+				u[ i ] = Math::rand( -1.0f, 1.0f );
+			for( size_t i = 0; i < w; i++ ) {
+				g[ i ] = i % 5 ? Math::rand( 0.0f, 1.0f ) : 0.0f;
+				lambda[ i ] = i % 3 ? Math::rand( 0.0f, 2.0f ) : 0.0f;
+				f[ i ] = Math::rand( -1.0f, 1.0f );
+			}
+
+			for( int k = 0; k < 8; k++ ) {
+				std::vector<float> px1( 2 * w ), py1( 2 * w ), px2, py2, u1, u2, ub1( w ), ub2( w );
+				for( size_t i = 0; i < 2 * w; i++ ) {
+					px1[ i ] = Math::rand( -1.0f, 1.0f );
+					py1[ i ] = Math::rand( -1.0f, 1.0f );
+				}
+				px2 = px1;
+				py2 = py1;
+
+				const float* unext = ( k & 1 ) ? &u[ w ] : NULL;
+				const float* weight = ( k & 2 ) ? &g[ 0 ] : NULL;
+				float eps = ( k & 4 ) ? 0.05f : 0.0f;
+				base->pdtvDual1_f( &px1[ w ], &py1[ w ], &u[ 0 ], unext, weight, w, 0.35f, eps );
+				best->pdtvDual1_f( &px2[ w ], &py2[ w ], &u[ 0 ], unext, weight, w, 0.35f, eps );
+				ret &= px1 == px2 && py1 == py2;
+
+				u1.assign( u.begin(), u.begin() + w );
+				u2 = u1;
+				const float* pyprev = ( k & 1 ) ? &py1[ 0 ] : NULL;
+				const float* lam = ( k & 2 ) ? &lambda[ 0 ] : NULL;
+				base->pdtvPrimal1_f( &u1[ 0 ], &ub1[ 0 ], &px1[ w ], &py1[ w ], pyprev, &f[ 0 ], lam, 0.7f, w, 0.3f, 0.9f, k & 4 );
+				best->pdtvPrimal1_f( &u2[ 0 ], &ub2[ 0 ], &px1[ w ], &py1[ w ], pyprev, &f[ 0 ], lam, 0.7f, w, 0.3f, 0.9f, k & 4 );
+				ret &= u1 == u2 && ub1 == ub2;
+			}
+		}
+
+		delete base;
+		delete best;
+		return ret;
+	}
+
+	/* two constant halves, optionally with gaussian-like noise or impulse noise */
+	static void _tvImage( Image& clean, Image& noisy, size_t w, size_t h, float noise, float impulses )
+	{
+		clean.reallocate( w, h, IFormat::GRAY_FLOAT );
+		noisy.reallocate( w, h, IFormat::GRAY_FLOAT );
+		IMapScoped<float> mc( clean );
+		IMapScoped<float> mn( noisy );
+		for( size_t y = 0; y < h; y++ ) {
+			for( size_t x = 0; x < w; x++ ) {
+				float v = x < w / 2 ? 0.2f : 0.8f;
+				mc.ptr()[ x ] = v;
+				v += noise * ( Math::rand( -1.0f, 1.0f ) + Math::rand( -1.0f, 1.0f ) + Math::rand( -1.0f, 1.0f ) );
+				if( Math::rand( 0.0f, 1.0f ) < impulses )
+					v = Math::rand( 0.0f, 1.0f );
+				mn.ptr()[ x ] = v;
+			}
+			mc++;
+			mn++;
+		}
+	}
+
+	static float _tvError( const Image& a, const Image& b, float threshold, float* maxerr = NULL )
+	{
+		IMapScoped<const float> ma( a );
+		IMapScoped<const float> mb( b );
+		size_t bad = 0;
+		float m = 0.0f, sum = 0.0f;
+		for( size_t y = 0; y < a.height(); y++ ) {
+			for( size_t x = 0; x < a.width(); x++ ) {
+				float d = Math::abs( ma.ptr()[ x ] - mb.ptr()[ x ] );
+				m = Math::max( m, d );
+				sum += d * d;
+				if( d > threshold )
+					bad++;
+			}
+			ma++;
+			mb++;
+		}
+		if( maxerr )
+			*maxerr = m;
+		return threshold > 0.0f ? ( float ) bad / ( float ) ( a.width() * a.height() ) : Math::sqrt( sum / ( a.width() * a.height() ) );
+	}
+
+
+	struct TVApply {
+		TVApply( TVDenoise& t, const Image& s ) : tv( t ), src( s ) {}
+		void operator()( Image& out ) const { tv.apply( out, src ); }
+		TVDenoise&		tv;
+		const Image&	src;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( TVDenoise )
+	bool result = true;
+	bool b;
+
+	b = _tvKernels();
+	CVTTEST_PRINT( "SIMD dual and primal steps", b );
+	result &= b;
+
+	Image clean, noisy, out, out2;
+
+	/* ROF stops on the gap long before the iteration limit and removes most of the noise */
+	{
+		_tvImage( clean, noisy, 97, 75, 0.05f, 0.0f );
+		TVDenoise tv( TVMODEL_ROF, 8.0f );
+		tv.setMaxIterations( 5000 );
+		tv.apply( out, noisy );
+		b = tv.iterations() < 5000 && tv.gap() >= 0.0 && tv.gap() <= 1e-4 * tv.primalEnergy();
+		b &= _tvError( out, clean, 0.0f ) < 0.5f * _tvError( noisy, clean, 0.0f );
+
+		/* the solution does not change much with a tighter tolerance */
+		tv.setTolerance( 1e-6f );
+		tv.apply( out2, noisy );
+		float maxerr;
+		_tvError( out, out2, 1.0f, &maxerr );
+		b &= maxerr < 1e-2f;
+		CVTTEST_PRINT( "ROF converged by the primal-dual gap", b );
+		result &= b;
+	}
+
+	/* TV-L1 removes impulse noise while keeping the edge */
+	{
+		_tvImage( clean, noisy, 80, 64, 0.0f, 0.03f );
+		TVDenoise tv( TVMODEL_L1, 1.0f );
+		tv.setMaxIterations( 3000 );
+		tv.apply( out, noisy );
+		b = _tvError( out, clean, 0.05f ) < 0.01f && tv.gap() >= 0.0;
+		CVTTEST_PRINT( "TV-L1 impulse noise", b );
+		result &= b;
+	}
+
+	/* Huber-ROF and inpainting: the masked hole is filled from its surrounding */
+	{
+		size_t w = 64, h = 48;
+		Image img( w, h, IFormat::GRAY_FLOAT ), mask( w, h, IFormat::GRAY_UINT8 );
+		{
+			IMapScoped<float> mi( img );
+			IMapScoped<uint8_t> mm( mask );
+			for( size_t y = 0; y < h; y++ ) {
+				for( size_t x = 0; x < w; x++ ) {
+					bool hole = x >= 20 && x < 40 && y >= 15 && y < 30;
+					mi.ptr()[ x ] = hole ? 1.0f : 0.5f;
+					mm.ptr()[ x ] = hole ? 0 : 255;
+				}
+				mi++;
+				mm++;
+			}
+		}
+		TVDenoise tv( TVMODEL_ROF, 10.0f, 0.01f );
+		tv.setMaxIterations( 3000 );
+		tv.apply( out, img, NULL, &mask );
+		float maxerr = 1.0f;
+		Image flat( w, h, IFormat::GRAY_FLOAT );
+		flat.fill( Color( 0.5f ) );
+		_tvError( out, flat, 1.0f, &maxerr );
+		b = maxerr < 1e-2f && tv.iterations() < 3000;
+		CVTTEST_PRINT( "Huber-ROF inpainting", b );
+		result &= b;
+	}
+
+	/* constant input is a fixed point, uint8 input keeps its format */
+	{
+		Image img( 33, 17, IFormat::GRAY_UINT8 );
+		img.fill( Color( 0.4f ) );
+		TVDenoise tv( TVMODEL_ROF, 5.0f );
+		tv.apply( out, img );
+		b = tv.iterations() == tv.checkInterval() && testImagesEqual( img, out );
+		CVTTEST_PRINT( "constant GRAY_UINT8", b );
+		result &= b;
+	}
+
+	/* independent of the number of threads, planar channels */
+	{
+		_tvImage( clean, noisy, 70, 90, 0.05f, 0.0f );
+		Image rgba;
+		noisy.convert( rgba, IFormat::RGBA_FLOAT );
+		TVDenoise tv( TVMODEL_ROF, 4.0f, 0.02f );
+		tv.setTolerance( 0.0f );
+		tv.setMaxIterations( 50 );
+		tv.apply( out, rgba );
+		b = out.format() == IFormat::RGBA_FLOAT && tv.iterations() == 50;
+		b &= testThreadInvariance<Image>( TVApply( tv, rgba ), testImagesEqual );
+		IMapScoped<const float> m1( out );
+		for( size_t y = 0; y < out.height(); y++ ) {
+			/* all colour channels see the same data */
+			for( size_t x = 0; x < out.width(); x++ )
+				b &= m1.ptr()[ 4 * x ] == m1.ptr()[ 4 * x + 1 ] && m1.ptr()[ 4 * x ] == m1.ptr()[ 4 * x + 2 ];
+			m1++;
+		}
+		CVTTEST_PRINT( "thread count and channels", b );
+		result &= b;
+	}
+
+	/* ROFDenoise uses the engine, lambda weights the regularization */
+	{
+		_tvImage( clean, noisy, 64, 64, 0.05f, 0.0f );
+		ROFDenoise rof;
+		rof.apply( out, noisy, 0.1f, 500 );
+		b = _tvError( out, clean, 0.0f ) < 0.5f * _tvError( noisy, clean, 0.0f );
+		CVTTEST_PRINT( "ROFDenoise", b );
+		result &= b;
+	}
+
+	return result;
+END_CVTTEST
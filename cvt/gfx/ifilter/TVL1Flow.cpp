@@ -35,6 +35,15 @@
 #include <cvt/cl/kernel/tvl1flow/tvl1_dataadd.h>
 
 #include <cvt/vision/Flow.h>
+#include <cvt/vision/CapturePreprocessor.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/ifilter/internal/TVL1Solver.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+
+#include <vector>
+#include <algorithm>
 
 namespace cvt {
 		static ParamInfoTyped<Image*> pin( "Input", true );
@@ -45,19 +54,15 @@ namespace cvt {
 			&pout,
 		};
 
-		TVL1Flow::TVL1Flow( float scalefactor, size_t levels ) : IFilter( "TVL1Flow", _params, 2, IFILTER_OPENCL ),
+		TVL1Flow::TVL1Flow( float scalefactor, size_t levels ) : IFilter( "TVL1Flow", _params, 2, IFILTER_OPENCL | IFILTER_CPU ),
 			_toggle( false ),
 			_scalefactor( scalefactor ),
 			_levels( levels ),
-			_pyrup( _pyrupmul_source, "pyrup_mul" ),
-//			_pyrdown( _pyrdown_source, "pyrdown" ),
-			_pyrdown( _pyrdown_source, "pyrdown" ),
-			_tvl1( _tvl1_source, "tvl1" ),
-			_tvl1_warp( _tvl1_warp_source, "tvl1_warp" ),
-//			_tvl1_dataadd( _tvl1_dataadd_source, "tvl1_dataadd" ),
-			_clear( _clear_source, "clear" ),
-			_median3( _median3_source, "median3" ),
-			_lambda( 70.0f )
+			_lambda( 70.0f ),
+			_warps( 5 ),
+			_iterations( 10 ),
+			_median( true ),
+			_epsilon( 0.0f )
 		{
 			_pyr[ 0 ] = new Image[ levels ];
 			_pyr[ 1 ] = new Image[ levels ];
@@ -69,12 +74,44 @@ namespace cvt {
 			delete[ ] _pyr[ 1 ];
 		}
 
-		void TVL1Flow::apply( Image& output, const Image& src1, const Image& src2 )
+		/* the kernels are only built on first use, the CPU path works without an OpenCL device */
+		void TVL1Flow::initCL()
+		{
+			if( ( cl_kernel ) _tvl1 != NULL )
+				return;
+
+			_pyrup = CLKernel( _pyrupmul_source, "pyrup_mul" );
+//			_pyrdown = CLKernel( _pyrdown_source, "pyrdown" );
+			_pyrdown = CLKernel( _pyrdown_source, "pyrdown" );
+			_tvl1_warp = CLKernel( _tvl1_warp_source, "tvl1_warp" );
+//			_tvl1_dataadd = CLKernel( _tvl1_dataadd_source, "tvl1_dataadd" );
+			_clear = CLKernel( _clear_source, "clear" );
+			_median3 = CLKernel( _median3_source, "median3" );
+			_tvl1 = CLKernel( _tvl1_source, "tvl1" );
+		}
+
+		void TVL1Flow::apply( Image& output, const Image& src1, const Image& src2, IFilterType t )
 		{
 			if( src1.width() != src2.width() ||
 			    src1.height() != src2.height() )
 				throw CVTException( "Image do not match in size!" );
 
+			switch( t ) {
+				case IFILTER_OPENCL:
+					applyCL( output, src1, src2 );
+					break;
+				case IFILTER_CPU:
+					applyCPU( output, src1, src2 );
+					break;
+				default:
+					throw CVTException( "Not implemented" );
+			}
+		}
+
+		void TVL1Flow::applyCL( Image& output, const Image& src1, const Image& src2 )
+		{
+			initCL();
+
 			fillPyramidCL( src1, 0 );
 			fillPyramidCL( src2, 1 );
 
@@ -106,7 +143,7 @@ namespace cvt {
 
 				//float tmp = _lambda;
 				//_lambda = _lambda * Math::pow( _scalefactor, l );
-				solveTVL1( *flow, _pyr[ 0 ][ l ], _pyr[ 1 ][ l ], true );
+				solveTVL1( *flow, _pyr[ 0 ][ l ], _pyr[ 1 ][ l ], _median );
 				//_lambda = tmp;
 			}
 
@@ -140,7 +177,7 @@ namespace cvt {
 
 				Image* ps[ 3 ] = { &p0, &p1/*, &p2*/ };
 			// WARPS
-			for( int i = 0; i < 5; i++ ) {
+			for( size_t i = 0; i < _warps; i++ ) {
 				if( median ) {
 					_median3.setArg( 0, flow0 );
 					_median3.setArg( 1, *us[ 1 ] );
@@ -164,8 +201,8 @@ namespace cvt {
 
 				Image* tmp;
 				// NUMBER of ROF/THRESHOLD iterations
-#define ROFITER 10
-				for( int k = 0; k < ROFITER; k++ ) {
+				const float rofiter = ( float ) _iterations;
+				for( size_t k = 0; k < _iterations; k++ ) {
 					_tvl1.setArg( 0, *ps[ 0 ] );
 					_tvl1.setArg( 1, *us[ 0 ] );
 					_tvl1.setArg( 2, *us[ 1 ] );
@@ -174,10 +211,10 @@ namespace cvt {
 					_tvl1.setArg( 5, *ps[ 1 ] );
 				//	_tvl1.setArg( 6, *ps[ 2 ] );
 //					_tvl1.setArg( 6, _lambda );
-					_tvl1.setArg( 6, _lambda * ( Math::exp( -( float ) ( k / ( float ) ROFITER ) * ( k / ( float ) ROFITER ) * 6.0f ) ) );
-//					_tvl1.setArg( 6, _lambda * ( ( Math::tanh( ( ( float ) ( -k ) + 0.5f * ( float ) ROFITER ) * 0.75f ) * 0.5f + 0.5f ) ) );
+					_tvl1.setArg( 6, _lambda * ( Math::exp( -( float ) ( k / rofiter ) * ( k / rofiter ) * 6.0f ) ) );
+//					_tvl1.setArg( 6, _lambda * ( ( Math::tanh( ( ( float ) ( -k ) + 0.5f * rofiter ) * 0.75f ) * 0.5f + 0.5f ) ) );
 					_tvl1.setArg( 7, THETA );
-//					_tvl1.setArg( 7, THETA * ( Math::exp( -( float ) ( k / ( float ) ROFITER ) * ( k / ( float ) ROFITER ) * 6.0f ) ) );
+//					_tvl1.setArg( 7, THETA * ( Math::exp( -( float ) ( k / rofiter ) * ( k / rofiter ) * 6.0f ) ) );
 					_tvl1.setArg( 8, CLLocalSpace( sizeof( cl_float4 ) * ( TVL1WGSIZE + 2 ) * ( TVL1WGSIZE + 2 ) ) );
 					_tvl1.setArg( 9, CLLocalSpace( sizeof( cl_float4 ) * ( TVL1WGSIZE + 1 ) * ( TVL1WGSIZE + 1 ) ) );
 					_tvl1.run( CLNDRange(Math::pad( flow.width(), TVL1WGSIZE ), Math::pad( flow.height(), TVL1WGSIZE ) ), CLNDRange( TVL1WGSIZE, TVL1WGSIZE ) );
@@ -192,10 +229,16 @@ namespace cvt {
 //					us[ 1 ] = tmp;
 //					} else {
 
-					_median3.setArg( 0, *us[ 1 ] );
-					_median3.setArg( 1, *us[ 0 ] );
-					_median3.setArg( 2,  CLLocalSpace( sizeof( cl_float4 ) * ( MEDWGSIZE + 2 ) * ( MEDWGSIZE + 2 ) ) );
-					_median3.run( CLNDRange( Math::pad( flow.width(), MEDWGSIZE ), Math::pad( flow.height(), MEDWGSIZE ) ), CLNDRange( MEDWGSIZE, MEDWGSIZE ) );
+					if( median ) {
+						_median3.setArg( 0, *us[ 1 ] );
+						_median3.setArg( 1, *us[ 0 ] );
+						_median3.setArg( 2,  CLLocalSpace( sizeof( cl_float4 ) * ( MEDWGSIZE + 2 ) * ( MEDWGSIZE + 2 ) ) );
+						_median3.run( CLNDRange( Math::pad( flow.width(), MEDWGSIZE ), Math::pad( flow.height(), MEDWGSIZE ) ), CLNDRange( MEDWGSIZE, MEDWGSIZE ) );
+					} else {
+						tmp = us[ 0 ];
+						us[ 0 ] = us[ 1 ];
+						us[ 1 ] = tmp;
+					}
 //					}
 
 
@@ -231,4 +274,180 @@ namespace cvt {
 				_pyrdown.run( CLNDRange( Math::pad( pyr[ l ].width(), PYRWGSIZE ), Math::pad( pyr[ l ].height(), PYRWGSIZE ) ), CLNDRange( PYRWGSIZE, PYRWGSIZE ) );
 			}
 		}
+
+		/* CPU implementation, the primal-dual iterations are shared with TVL1Stereo */
+		static const float  TVL1_THETA = 0.08f;
+		static const float  TVL1_BETA  = 15.0f;
+		static const float  TVL1_HUBER = 0.04f;
+
+		class TVL1FlowSolver : public TVL1Solver<TVL1FlowSolver, 2>
+		{
+			public:
+				TVL1FlowSolver( size_t width, size_t height );
+
+				void upsample( const TVL1FlowSolver& coarse, float mul );
+				void prepare();
+				void primalRow( float* const* v, size_t y ) const;
+				void result( Image& flow ) const;
+
+				/* parallel parts, they work on rows [ start, end ) */
+				void gradientRows( size_t start, size_t end ) const;
+				void warpRows( size_t start, size_t end ) const;
+
+			private:
+				/* warped temporal derivative and gradient, gradient of the second image */
+				enum Planes { IT = NUMPLANES, IX, IY, GX, GY, NUMFLOWPLANES };
+		};
+
+		TVL1FlowSolver::TVL1FlowSolver( size_t width, size_t height ) :
+			TVL1Solver<TVL1FlowSolver, 2>( width, height, NUMFLOWPLANES, TVL1_HUBER )
+		{
+		}
+
+		void TVL1FlowSolver::upsample( const TVL1FlowSolver& coarse, float mul )
+		{
+			/* bilinear with clamp to edge, same sampling positions as pyrup_mul */
+			const float incx = ( float ) coarse._width / ( float ) _width;
+			const float incy = ( float ) coarse._height / ( float ) _height;
+			const int cw = ( int ) coarse._width, ch = ( int ) coarse._height;
+
+			for( size_t y = 0; y < _height; y++ ) {
+				float fy = Math::clamp( incy * ( y + 0.5f ) - 0.5f, 0.0f, ( float ) ( ch - 1 ) );
+				int y0 = ( int ) fy;
+				int y1 = Math::min( y0 + 1, ch - 1 );
+				float ay = fy - ( float ) y0;
+				for( size_t x = 0; x < _width; x++ ) {
+					float fx = Math::clamp( incx * ( x + 0.5f ) - 0.5f, 0.0f, ( float ) ( cw - 1 ) );
+					int x0 = ( int ) fx;
+					int x1 = Math::min( x0 + 1, cw - 1 );
+					float ax = fx - ( float ) x0;
+					for( size_t c = 0; c < 2; c++ ) {
+						const float* u = coarse._plane[ U + c ];
+						float v0 = Math::mix( u[ y0 * cw + x0 ], u[ y0 * cw + x1 ], ax );
+						float v1 = Math::mix( u[ y1 * cw + x0 ], u[ y1 * cw + x1 ], ax );
+						_plane[ U + c ][ y * _width + x ] = mul * Math::mix( v0, v1, ay );
+					}
+				}
+			}
+		}
+
+		void TVL1FlowSolver::prepare()
+		{
+			ParallelFor::run( ParallelFor::bind( *this, &TVL1FlowSolver::gradientRows ), 0, _height, 16 );
+			ParallelFor::run( ParallelFor::bind( *this, &TVL1FlowSolver::warpRows ), 0, _height, 16 );
+
+			/* the dual variables restart with every warp */
+			resetDual();
+		}
+
+		/* thresholding of the linearised data term */
+		void TVL1FlowSolver::primalRow( float* const* v, size_t y ) const
+		{
+			const size_t off = y * _width;
+			const float lt = _lambdatheta;
+			const float* u1 = _plane[ U ] + off;
+			const float* u2 = _plane[ U + 1 ] + off;
+			const float* u01 = _plane[ U0 ] + off;
+			const float* u02 = _plane[ U0 + 1 ] + off;
+			const float* it = _plane[ IT ] + off;
+			const float* ix = _plane[ IX ] + off;
+			const float* iy = _plane[ IY ] + off;
+			float* n1 = v[ 0 ];
+			float* n2 = v[ 1 ];
+
+			for( size_t x = 0; x < _width; x++ ) {
+				float gx = ix[ x ], gy = iy[ x ];
+				float grad2 = gx * gx + gy * gy;
+				float dt = it[ x ] + gx * ( u1[ x ] - u01[ x ] ) + gy * ( u2[ x ] - u02[ x ] );
+				float ltg2 = lt * grad2;
+				float s;
+				if( dt < -ltg2 )
+					s = lt;
+				else if( dt > ltg2 )
+					s = -lt;
+				else
+					s = -dt / Math::max( grad2, 1e-4f );
+
+				n1[ x ] = u1[ x ] + s * gx;
+				n2[ x ] = u2[ x ] + s * gy;
+			}
+		}
+
+		void TVL1FlowSolver::result( Image& flow ) const
+		{
+			flow.reallocate( _width, _height, IFormat::GRAYALPHA_FLOAT );
+			IMapScoped<float> map( flow );
+			const float* u1 = _plane[ U ];
+			const float* u2 = _plane[ U + 1 ];
+			for( size_t y = 0; y < _height; y++ ) {
+				float* dst = map.ptr();
+				for( size_t x = 0; x < _width; x++ ) {
+					*dst++ = *u1++;
+					*dst++ = *u2++;
+				}
+				map++;
+			}
+		}
+
+		/* central differences of the second image, zero outside like the CLK_ADDRESS_CLAMP sampler */
+		void TVL1FlowSolver::gradientRows( size_t start, size_t end ) const
+		{
+			const size_t w = _width;
+			for( size_t y = start; y < end; y++ ) {
+				const float* row = row2( y );
+				const float* prev = y > 0 ? row2( y - 1 ) : NULL;
+				const float* next = y + 1 < _height ? row2( y + 1 ) : NULL;
+				float* gx = _plane[ GX ] + y * w;
+				float* gy = _plane[ GY ] + y * w;
+
+				for( size_t x = 0; x < w; x++ ) {
+					gx[ x ] = ( x + 1 < w ? row[ x + 1 ] : 0.0f ) - ( x > 0 ? row[ x - 1 ] : 0.0f );
+					gy[ x ] = ( next ? next[ x ] : 0.0f ) - ( prev ? prev[ x ] : 0.0f );
+				}
+			}
+		}
+
+		void TVL1FlowSolver::warpRows( size_t start, size_t end ) const
+		{
+			SIMD* simd = SIMD::instance();
+			const size_t w = _width;
+			ScopedBuffer<float, true> coords( 2 * w );
+
+			for( size_t y = start; y < end; y++ ) {
+				const size_t off = y * w;
+				const float* u1 = _plane[ U0 ] + off;
+				const float* u2 = _plane[ U0 + 1 ] + off;
+				const float* img1 = row1( y );
+				float* it = _plane[ IT ] + off;
+				float* ix = _plane[ IX ] + off;
+				float* iy = _plane[ IY ] + off;
+				float* g = _plane[ G ] + off;
+				float* c = coords.ptr();
+
+				for( size_t x = 0; x < w; x++ ) {
+					*c++ = ( float ) x + u1[ x ];
+					*c++ = ( float ) y + u2[ x ];
+				}
+
+				simd->warpBilinear1f( it, coords.ptr(), _img2, _img2stride, w, _height, 0.0f, w );
+				simd->warpBilinear1f( ix, coords.ptr(), _plane[ GX ], w * sizeof( float ), w, _height, 0.0f, w );
+				simd->warpBilinear1f( iy, coords.ptr(), _plane[ GY ], w * sizeof( float ), w, _height, 0.0f, w );
+				simd->Sub( it, it, img1, w );
+
+				for( size_t x = 0; x < w; x++ )
+					g[ x ] = Math::max( 1e-4f, Math::exp( -TVL1_BETA * ( Math::abs( ix[ x ] ) + Math::abs( iy[ x ] ) ) ) );
+			}
+		}
+
+		void TVL1Flow::applyCPU( Image& output, const Image& src1, const Image& src2 )
+		{
+			CapturePreprocessor prep( IFormat::GRAY_FLOAT );
+			ImagePyramid pyr1( _levels, _scalefactor );
+			ImagePyramid pyr2( _levels, _scalefactor );
+			prep.process( pyr1, src1 );
+			prep.process( pyr2, src2 );
+
+			TVL1Schedule schedule = { _lambda, 6.0f, TVL1_THETA, _epsilon, _warps, _iterations, _median };
+			TVL1Solve<TVL1FlowSolver>( output, pyr1, pyr2, _levels, _scalefactor, schedule );
+		}
 }
@@ -31,14 +31,26 @@
 #include <cvt/cl/CLKernel.h>
 
 namespace cvt {
+	/* coarse to fine TV-L1 optical flow, the result is a GRAYALPHA_FLOAT image with the flow in x and y */
 	class TVL1Flow : public IFilter {
 		public:
 			TVL1Flow( float scalefactor, size_t levels );
 			~TVL1Flow();
-			void apply( Image& flow, const Image& src1, const Image& src2 );
+			void apply( Image& flow, const Image& src1, const Image& src2, IFilterType t = IFILTER_OPENCL );
 			void apply( const ParamSet* set, IFilterType t = IFILTER_CPU ) const {};
 
+			void setLambda( float lambda )		{ _lambda = lambda; }
+			void setWarps( size_t warps )		{ _warps = warps; }
+			void setIterations( size_t iter )	{ _iterations = iter; }
+			/* 3x3 median filtering of the flow before each warp and after each iteration */
+			void setMedian( bool median )		{ _median = median; }
+			/* CPU only: leave the iterations of a warp once the rms of the flow update drops below epsilon, 0 disables */
+			void setEpsilon( float epsilon )	{ _epsilon = epsilon; }
+
 		private:
+			void initCL();
+			void applyCL( Image& flow, const Image& src1, const Image& src2 );
+			void applyCPU( Image& flow, const Image& src1, const Image& src2 );
 			void fillPyramidCL( const Image& img, size_t index );
 			void solveTVL1( Image& flow, const Image& src1, const Image& src2, bool median );
 
@@ -53,6 +65,10 @@ namespace cvt {
 			CLKernel	 _clear;
 			CLKernel	 _median3;
 			float		 _lambda;
+			size_t		 _warps;
+			size_t		 _iterations;
+			bool		 _median;
+			float		 _epsilon;
 //			ROFFGPFilter _rof;
 //			GuidedFilter _gf;
 			Image*		 _pyr[ 2 ];
@@ -0,0 +1,164 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/ifilter/TVL1Flow.h>
+#include <cvt/vision/Flow.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+namespace cvt {
+
+	/* smooth texture, shifted by ( dx, dy ) */
+	static void _texture( Image& img, float dx, float dy )
+	{
+		static const float freq[ 4 ][ 3 ] = {
+			{ 0.31f, 0.12f, 0.0f },
+			{ -0.17f, 0.27f, 1.3f },
+			{ 0.45f, -0.38f, 2.1f },
+			{ 0.08f, 0.51f, 0.7f }
+		};
+
+		img.reallocate( 96, 80, IFormat::GRAY_FLOAT );
+		IMapScoped<float> map( img );
+		for( size_t y = 0; y < img.height(); y++ ) {
+			float* ptr = map.ptr();
+			for( size_t x = 0; x < img.width(); x++ ) {
+				float v = 0.5f;
+				for( size_t i = 0; i < 4; i++ )
+					v += 0.1f * Math::sin( freq[ i ][ 0 ] * ( ( float ) x - dx ) + freq[ i ][ 1 ] * ( ( float ) y - dy ) + freq[ i ][ 2 ] );
+				ptr[ x ] = v;
+			}
+			map++;
+		}
+	}
+
+	static bool _simdTest()
+	{
+		const size_t n = 67;
+		const size_t sw = 13, sh = 11;
+		float src[ sw * sh ], coords[ 2 * n ], out[ n ], ref[ n ];
+		bool ret = true;
+
+		for( size_t i = 0; i < sw * sh; i++ )
+			src[ i ] = Math::rand( 0.0f, 1.0f );
+		/* mostly inside, some positions at or beyond the border */
+		for( size_t i = 0; i < n; i++ ) {
+			bool border = i % 7 == 3;
+			coords[ 2 * i ] = border ? Math::rand( -3.0f, sw + 2.0f ) : Math::rand( 0.0f, sw - 1.01f );
+			coords[ 2 * i + 1 ] = border ? Math::rand( -3.0f, sh + 2.0f ) : Math::rand( 0.0f, sh - 1.01f );
+		}
+
+		SIMD* base = SIMD::get( SIMD_BASE );
+		base->warpBilinear1f( ref, coords, src, sw * sizeof( float ), sw, sh, 0.25f, n );
+		SIMDType bestType = SIMD::bestSupportedType();
+		for( int st = SIMD_BASE; st <= bestType; st++ ) {
+			SIMD* simd = SIMD::get( ( SIMDType ) st );
+			simd->warpBilinear1f( out, coords, src, sw * sizeof( float ), sw, sh, 0.25f, n );
+			for( size_t i = 0; i < n; i++ )
+				ret &= Math::abs( out[ i ] - ref[ i ] ) < 1e-6f;
+			delete simd;
+		}
+		delete base;
+		return ret;
+	}
+
+	/* mean endpoint error inside of the image */
+	static float _flowError( const Image& flow, float dx, float dy )
+	{
+		IMapScoped<const float> map( flow );
+		float err = 0.0f;
+		size_t n = 0;
+		for( size_t y = 0; y < flow.height(); y++ ) {
+			const float* ptr = map.ptr();
+			if( y >= 8 && y + 8 < flow.height() ) {
+				for( size_t x = 8; x + 8 < flow.width(); x++ ) {
+					err += Math::sqrt( Math::sqr( ptr[ 2 * x ] - dx ) + Math::sqr( ptr[ 2 * x + 1 ] - dy ) );
+					n++;
+				}
+			}
+			map++;
+		}
+		return err / ( float ) n;
+	}
+
+	struct TVL1FlowCPU {
+		TVL1FlowCPU( TVL1Flow& t, const Image& s1, const Image& s2 ) : tvl1( t ), src1( s1 ), src2( s2 ) {}
+		void operator()( Image& flow ) const { tvl1.apply( flow, src1, src2, IFILTER_CPU ); }
+		TVL1Flow&		tvl1;
+		const Image&	src1;
+		const Image&	src2;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( TVL1Flow )
+	bool result = true;
+	bool b;
+	Image src1, src2, flow, flow4, color;
+
+	b = _simdTest();
+	CVTTEST_PRINT( "SIMD warpBilinear1f", b );
+	result &= b;
+
+	_texture( src1, 0.0f, 0.0f );
+	_texture( src2, 1.6f, -0.7f );
+
+	TVL1Flow tvl1( 0.5f, 3 );
+	tvl1.apply( flow, src1, src2, IFILTER_CPU );
+	b = flow.width() == src1.width() && flow.height() == src1.height() && flow.format() == IFormat::GRAYALPHA_FLOAT;
+	b &= _flowError( flow, 1.6f, -0.7f ) < 0.1f;
+	CVTTEST_PRINT( "CPU flow of a shifted image", b );
+	result &= b;
+
+	b = testThreadInvariance<Image>( TVL1FlowCPU( tvl1, src1, src2 ), testImagesEqual );
+	CVTTEST_PRINT( "CPU flow independent of the number of threads", b );
+	result &= b;
+
+	/* leaving the iterations early changes the result, but the flow stays close */
+	tvl1.setEpsilon( 0.02f );
+	tvl1.apply( flow4, src1, src2, IFILTER_CPU );
+	b = !testImagesEqual( flow, flow4 ) && _flowError( flow4, 1.6f, -0.7f ) < 0.1f;
+	CVTTEST_PRINT( "CPU flow with early exit", b );
+	result &= b;
+
+	tvl1.setEpsilon( 0.0f );
+	tvl1.setMedian( false );
+	tvl1.apply( flow, src1, src2, IFILTER_CPU );
+	b = _flowError( flow, 1.6f, -0.7f ) < 0.25f;
+	CVTTEST_PRINT( "CPU flow without median", b );
+	result &= b;
+
+	Flow::colorCode( color, flow );
+	b = color.width() == flow.width() && color.height() == flow.height();
+	CVTTEST_PRINT( "color code", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
@@ -34,6 +34,15 @@
 #include <cvt/cl/kernel/tvl1stereo/tvl1_warp.h>
 
 #include <cvt/vision/Flow.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/ifilter/internal/TVL1Solver.h>
+#include <cvt/gfx/IScaleFilter.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+
+#include <vector>
+#include <algorithm>
 
 namespace cvt {
 		static ParamInfoTyped<Image*> pin( "Input", true );
@@ -44,16 +53,9 @@ namespace cvt {
 			&pout,
 		};
 
-		TVL1Stereo::TVL1Stereo( float scalefactor, size_t levels ) : IFilter( "TVL1Stereo", _params, 2, IFILTER_OPENCL ),
+		TVL1Stereo::TVL1Stereo( float scalefactor, size_t levels ) : IFilter( "TVL1Stereo", _params, 2, IFILTER_OPENCL | IFILTER_CPU ),
 			_scalefactor( scalefactor ),
 			_levels( levels ),
-			_pyrup( _pyrupmul_source, "pyrup_mul" ),
-			_pyrdown( _pyrdown_source, "pyrdown" ),
-			_pyrdownbinom( _pyrdown_binom3_source, "pyrdown_binom3" ),
-			_tvl1( _tvl1_source, "tvl1" ),
-			_tvl1_warp( _tvl1_warp_source, "tvl1_warp" ),
-			_clear( _clear_source, "clear" ),
-			_median3( _median3_source, "median3" ),
 			_lambda( 70.0f )
 		{
 			_pyr[ 0 ] = new Image[ levels ];
@@ -66,12 +68,43 @@ namespace cvt {
 			delete[ ] _pyr[ 1 ];
 		}
 
-		void TVL1Stereo::apply( Image& output, const Image& src1, const Image& src2 )
+		/* the kernels are only built on first use, the CPU path works without an OpenCL device */
+		void TVL1Stereo::initCL()
+		{
+			if( ( cl_kernel ) _tvl1 != NULL )
+				return;
+
+			_pyrup = CLKernel( _pyrupmul_source, "pyrup_mul" );
+			_pyrdown = CLKernel( _pyrdown_source, "pyrdown" );
+			_pyrdownbinom = CLKernel( _pyrdown_binom3_source, "pyrdown_binom3" );
+			_tvl1_warp = CLKernel( _tvl1_warp_source, "tvl1_warp" );
+			_clear = CLKernel( _clear_source, "clear" );
+			_median3 = CLKernel( _median3_source, "median3" );
+			_tvl1 = CLKernel( _tvl1_source, "tvl1" );
+		}
+
+		void TVL1Stereo::apply( Image& output, const Image& src1, const Image& src2, IFilterType t )
 		{
 			if( src1.width() != src2.width() ||
 			    src1.height() != src2.height() )
 				throw CVTException( "Image do not match in size!" );
 
+			switch( t ) {
+				case IFILTER_OPENCL:
+					applyCL( output, src1, src2 );
+					break;
+				case IFILTER_CPU:
+					applyCPU( output, src1, src2 );
+					break;
+				default:
+					throw CVTException( "Not implemented" );
+			}
+		}
+
+		void TVL1Stereo::applyCL( Image& output, const Image& src1, const Image& src2 )
+		{
+			initCL();
+
 			fillPyramidCL( src1, 0 );
 			fillPyramidCL( src2, 1 );
 
@@ -240,4 +273,169 @@ namespace cvt {
 				_pyrdown.run( CLNDRange( Math::pad( pyr[ l ].width(), PYRWGSIZE ), Math::pad( pyr[ l ].height(), PYRWGSIZE ) ), CLNDRange( PYRWGSIZE, PYRWGSIZE ) );
 			}
 		}
+
+		/* CPU implementation, the primal-dual iterations are shared with TVL1Flow */
+		static const float  TVL1STEREO_THETA = 0.08f;
+		static const float  TVL1STEREO_BETA  = 10.0f;
+		static const float  TVL1STEREO_HUBER = 0.01f;
+		static const size_t TVL1STEREO_WARPS = 10;
+		static const size_t TVL1STEREO_ITER  = 50;
+
+		class TVL1StereoSolver : public TVL1Solver<TVL1StereoSolver, 1>
+		{
+			public:
+				TVL1StereoSolver( size_t width, size_t height );
+
+				void upsample( const TVL1StereoSolver& coarse, float mul );
+				void prepare();
+				void primalRow( float* const* v, size_t y ) const;
+				void result( Image& disparity ) const;
+
+				/* parallel parts, they work on rows [ start, end ) */
+				void gradientRows( size_t start, size_t end ) const;
+				void warpRows( size_t start, size_t end ) const;
+
+			private:
+				/* warped temporal derivative and gradient, horizontal gradients of both images */
+				enum Planes { IT = NUMPLANES, IX, DX1, DX2, NUMSTEREOPLANES };
+		};
+
+		TVL1StereoSolver::TVL1StereoSolver( size_t width, size_t height ) :
+			TVL1Solver<TVL1StereoSolver, 1>( width, height, NUMSTEREOPLANES, TVL1STEREO_HUBER )
+		{
+		}
+
+		void TVL1StereoSolver::upsample( const TVL1StereoSolver& coarse, float mul )
+		{
+			/* linear with clamp to edge, same sampling positions as pyrup_mul - the height does not change */
+			const float incx = ( float ) coarse._width / ( float ) _width;
+			const int cw = ( int ) coarse._width;
+
+			for( size_t x = 0; x < _width; x++ ) {
+				float fx = Math::clamp( incx * ( x + 0.5f ) - 0.5f, 0.0f, ( float ) ( cw - 1 ) );
+				int x0 = ( int ) fx;
+				int x1 = Math::min( x0 + 1, cw - 1 );
+				float ax = fx - ( float ) x0;
+				const float* u = coarse._plane[ U ];
+				float* dst = _plane[ U ] + x;
+				for( size_t y = 0; y < _height; y++ ) {
+					*dst = mul * Math::mix( u[ x0 ], u[ x1 ], ax );
+					dst += _width;
+					u += cw;
+				}
+			}
+		}
+
+		void TVL1StereoSolver::prepare()
+		{
+			ParallelFor::run( ParallelFor::bind( *this, &TVL1StereoSolver::gradientRows ), 0, _height, 16 );
+			ParallelFor::run( ParallelFor::bind( *this, &TVL1StereoSolver::warpRows ), 0, _height, 16 );
+		}
+
+		/* thresholding of the linearised data term, only along the scanline */
+		void TVL1StereoSolver::primalRow( float* const* v, size_t y ) const
+		{
+			const size_t off = y * _width;
+			const float lt = _lambdatheta;
+			const float* u = _plane[ U ] + off;
+			const float* u0 = _plane[ U0 ] + off;
+			const float* it = _plane[ IT ] + off;
+			const float* ix = _plane[ IX ] + off;
+			float* dst = v[ 0 ];
+
+			for( size_t x = 0; x < _width; x++ ) {
+				float gx = ix[ x ];
+				float val = u[ x ];
+				float dt = it[ x ] + gx * ( val - u0[ x ] );
+				float ltg2 = lt * gx * gx;
+				if( dt < -ltg2 )
+					val += lt * gx;
+				else if( dt > ltg2 )
+					val -= lt * gx;
+				else if( Math::abs( gx ) >= 1e-8f )
+					val -= dt / gx;
+				dst[ x ] = val;
+			}
+		}
+
+		void TVL1StereoSolver::result( Image& disparity ) const
+		{
+			disparity.reallocate( _width, _height, IFormat::GRAY_FLOAT );
+			IMapScoped<float> map( disparity );
+			const float* u = _plane[ U ];
+			for( size_t y = 0; y < _height; y++ ) {
+				std::copy( u, u + _width, map.ptr() );
+				u += _width;
+				map++;
+			}
+		}
+
+		/* horizontal central differences of both images, zero outside like the CLK_ADDRESS_CLAMP sampler */
+		void TVL1StereoSolver::gradientRows( size_t start, size_t end ) const
+		{
+			const size_t w = _width;
+			for( size_t y = start; y < end; y++ ) {
+				const float* r1 = row1( y );
+				const float* r2 = row2( y );
+				float* dx1 = _plane[ DX1 ] + y * w;
+				float* dx2 = _plane[ DX2 ] + y * w;
+
+				for( size_t x = 0; x < w; x++ ) {
+					dx1[ x ] = ( x + 1 < w ? r1[ x + 1 ] : 0.0f ) - ( x > 0 ? r1[ x - 1 ] : 0.0f );
+					dx2[ x ] = ( x + 1 < w ? r2[ x + 1 ] : 0.0f ) - ( x > 0 ? r2[ x - 1 ] : 0.0f );
+				}
+			}
+		}
+
+		void TVL1StereoSolver::warpRows( size_t start, size_t end ) const
+		{
+			SIMD* simd = SIMD::instance();
+			const size_t w = _width;
+			ScopedBuffer<float, true> coords( 2 * w );
+			ScopedBuffer<float, true> warped( w );
+
+			for( size_t y = start; y < end; y++ ) {
+				const size_t off = y * w;
+				const float* u0 = _plane[ U0 ] + off;
+				const float* img1 = row1( y );
+				const float* dx1 = _plane[ DX1 ] + off;
+				float* it = _plane[ IT ] + off;
+				float* ix = _plane[ IX ] + off;
+				float* g = _plane[ G ] + off;
+				float* dx2 = warped.ptr();
+				float* c = coords.ptr();
+
+				for( size_t x = 0; x < w; x++ ) {
+					*c++ = ( float ) x + u0[ x ];
+					*c++ = ( float ) y;
+				}
+
+				simd->warpBilinear1f( it, coords.ptr(), _img2, _img2stride, w, _height, 0.0f, w );
+				simd->warpBilinear1f( dx2, coords.ptr(), _plane[ DX2 ], w * sizeof( float ), w, _height, 0.0f, w );
+				simd->Sub( it, it, img1, w );
+
+				/* the gradient is a blend of the warped and the reference gradient */
+				for( size_t x = 0; x < w; x++ ) {
+					ix[ x ] = Math::mix( dx2[ x ], dx1[ x ], 0.4f );
+					g[ x ] = Math::max( 1e-4f, Math::exp( -TVL1STEREO_BETA * Math::abs( Math::mix( dx2[ x ], dx1[ x ], 0.5f ) ) ) );
+				}
+			}
+		}
+
+		void TVL1Stereo::applyCPU( Image& output, const Image& src1, const Image& src2 )
+		{
+			/* gray pyramids, only the width is reduced like in fillPyramidCL */
+			std::vector<Image> pyr1( _levels ), pyr2( _levels );
+			src1.convert( pyr1[ 0 ], IFormat::GRAY_FLOAT );
+			src2.convert( pyr2[ 0 ], IFormat::GRAY_FLOAT );
+			for( size_t l = 1; l < _levels; l++ ) {
+				size_t w = Math::max<size_t>( pyr1[ l - 1 ].width() * _scalefactor, 1 );
+				pyr1[ l - 1 ].scale( pyr1[ l ], w, pyr1[ l - 1 ].height(), IScaleFilterGauss() );
+				pyr2[ l - 1 ].scale( pyr2[ l ], w, pyr2[ l - 1 ].height(), IScaleFilterGauss() );
+			}
+
+			/* constant lambda, every warp and iteration is median filtered */
+			TVL1Schedule schedule = { _lambda, 0.0f, TVL1STEREO_THETA, 0.0f, TVL1STEREO_WARPS, TVL1STEREO_ITER, true };
+			TVL1Solve<TVL1StereoSolver>( output, pyr1, pyr2, _levels, _scalefactor, schedule );
+		}
 }
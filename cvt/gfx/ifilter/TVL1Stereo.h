@@ -29,14 +29,19 @@
 #include <cvt/cl/CLKernel.h>
 
 namespace cvt {
+	/* coarse to fine TV-L1 disparity estimation, the pyramid is only scaled horizontally.
+	   The result is a GRAY_FLOAT image with the horizontal offset of the matching pixel in src2 */
 	class TVL1Stereo : public IFilter {
 		public:
 			TVL1Stereo( float scalefactor, size_t levels );
 			~TVL1Stereo();
-			void apply( Image& flow, const Image& src1, const Image& src2 );
+			void apply( Image& flow, const Image& src1, const Image& src2, IFilterType t = IFILTER_OPENCL );
 			void apply( const ParamSet* set, IFilterType t = IFILTER_CPU ) const {};
 
 		private:
+			void initCL();
+			void applyCL( Image& flow, const Image& src1, const Image& src2 );
+			void applyCPU( Image& flow, const Image& src1, const Image& src2 );
 			void fillPyramidCL( const Image& img, size_t index );
 			void solveTVL1( Image& flow, const Image& src1, const Image& src2, bool median );
 
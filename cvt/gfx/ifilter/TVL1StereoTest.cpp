@@ -0,0 +1,110 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/ifilter/TVL1Stereo.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+namespace cvt {
+
+	/* smooth texture, shifted horizontally by dx */
+	static void _stereoTexture( Image& img, float dx )
+	{
+		static const float freq[ 4 ][ 3 ] = {
+			{ 0.35f, 0.12f, 0.0f },
+			{ -0.21f, 0.27f, 1.3f },
+			{ 0.52f, -0.38f, 2.1f },
+			{ 0.13f, 0.51f, 0.7f }
+		};
+
+		img.reallocate( 96, 64, IFormat::GRAY_FLOAT );
+		IMapScoped<float> map( img );
+		for( size_t y = 0; y < img.height(); y++ ) {
+			float* ptr = map.ptr();
+			for( size_t x = 0; x < img.width(); x++ ) {
+				float v = 0.5f;
+				for( size_t i = 0; i < 4; i++ )
+					v += 0.1f * Math::sin( freq[ i ][ 0 ] * ( ( float ) x - dx ) + freq[ i ][ 1 ] * ( float ) y + freq[ i ][ 2 ] );
+				ptr[ x ] = v;
+			}
+			map++;
+		}
+	}
+
+	/* mean absolute disparity error, a border of 8 pixels is ignored */
+	static float _disparityError( const Image& disp, float d )
+	{
+		IMapScoped<const float> map( disp );
+		float err = 0.0f;
+		size_t n = 0;
+		for( size_t y = 0; y < disp.height(); y++ ) {
+			const float* ptr = map.ptr();
+			if( y >= 8 && y + 8 < disp.height() ) {
+				for( size_t x = 8; x + 8 < disp.width(); x++ ) {
+					err += Math::abs( ptr[ x ] - d );
+					n++;
+				}
+			}
+			map++;
+		}
+		return err / ( float ) n;
+	}
+
+	struct TVL1StereoCPU {
+		TVL1StereoCPU( TVL1Stereo& t, const Image& l, const Image& r ) : tvl1( t ), left( l ), right( r ) {}
+		void operator()( Image& disp ) const { tvl1.apply( disp, left, right, IFILTER_CPU ); }
+		TVL1Stereo&		tvl1;
+		const Image&	left;
+		const Image&	right;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( TVL1Stereo )
+	bool result = true;
+	bool b;
+	Image left, right, disp;
+
+	/* the right image sees the texture 2.5 pixels further left */
+	_stereoTexture( left, 0.0f );
+	_stereoTexture( right, -2.5f );
+
+	TVL1Stereo tvl1( 0.5f, 3 );
+	tvl1.apply( disp, left, right, IFILTER_CPU );
+	b = disp.width() == left.width() && disp.height() == left.height() && disp.format() == IFormat::GRAY_FLOAT;
+	b &= _disparityError( disp, -2.5f ) < 0.1f;
+	CVTTEST_PRINT( "CPU disparity of a shifted image", b );
+	result &= b;
+
+	b = testThreadInvariance<Image>( TVL1StereoCPU( tvl1, left, right ), testImagesEqual );
+	CVTTEST_PRINT( "CPU disparity independent of the number of threads", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
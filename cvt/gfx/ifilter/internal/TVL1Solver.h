@@ -0,0 +1,356 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_TVL1SOLVER_H
+#define CVT_TVL1SOLVER_H
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/math/Math.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace cvt {
+
+	/* rows per parallel band of the primal-dual iterations */
+	static const size_t TVL1SOLVER_BAND = 32;
+
+	/**
+	  @brief Primal-dual TV-L1 iterations shared by the CPU versions of TVL1Flow and TVL1Stereo.
+
+	  All quantities of one pyramid level are stored as planes. An iteration for the C channels of u is
+	  a primal step, the thresholding of the linearised data term done by Derived followed by a step along
+	  the divergence of the dual variables p, and a Huber regularised projected ascent in p weighted by
+	  the edge term G. The iterations run on parallel bands of TVL1SOLVER_BAND rows, every band recomputes
+	  the primal update of the first row of the following band as halo.
+
+	  Derived provides the data term:
+		void prepare();									// warp the second image, the images are mapped
+		void primalRow( float* const* v, size_t y ) const;	// thresholded u of row y for every channel
+		void upsample( const Derived& coarse, float mul );
+		void result( Image& output ) const;
+	 */
+	template<class Derived, size_t C>
+	class TVL1Solver
+	{
+		public:
+			/* u, the result of the last iteration, u at the warp, the edge term and two dual planes per channel */
+			enum BasePlanes { U = 0, T = C, U0 = 2 * C, G = 3 * C, P = 3 * C + 1, Q = 5 * C + 1, NUMPLANES = 7 * C + 1 };
+
+			size_t	width() const  { return _width; }
+			size_t	height() const { return _height; }
+
+			/* maps the images, sets u0 to the ( median filtered ) u and lets Derived warp the second image */
+			void	warp( const Image& src1, const Image& src2, bool median );
+			/* returns the rms change of u */
+			float	iterate( float lambda, float theta, bool median );
+
+			/* parallel parts, they work on bands or rows [ start, end ) */
+			void	updateBands( size_t start, size_t end ) const;
+			void	medianRows( size_t start, size_t end ) const;
+
+		protected:
+			TVL1Solver( size_t width, size_t height, size_t planes, float huber );
+
+			void	median( float* const* dst, const float* const* src );
+			void	resetDual();
+
+			const float* row1( size_t y ) const { return ( const float* ) ( ( const uint8_t* ) _img1 + y * _img1stride ); }
+			const float* row2( size_t y ) const { return ( const float* ) ( ( const uint8_t* ) _img2 + y * _img2stride ); }
+
+			size_t				_width, _height;
+			std::vector<float>	_mem;
+			std::vector<float*>	_plane;
+
+			/* arguments of the parallel parts */
+			const float*		_img1;
+			size_t				_img1stride;
+			const float*		_img2;
+			size_t				_img2stride;
+			float				_lambdatheta;
+			float				_theta;
+
+		private:
+			TVL1Solver( const TVL1Solver& );
+			TVL1Solver& operator=( const TVL1Solver& );
+
+			float				_huber;
+			mutable std::vector<float> _residual;
+			const float*		_src[ C ];
+			float*				_dst[ C ];
+	};
+
+	/**
+	  Parameters of the coarse to fine iterations, lambda decays with exp( -decay * ( k / iterations )^2 )
+	  within the iterations of a warp, the iterations stop once the rms change of u is below epsilon.
+	 */
+	struct TVL1Schedule {
+		float	lambda;
+		float	decay;
+		float	theta;
+		float	epsilon;
+		size_t	warps;
+		size_t	iterations;
+		bool	median;
+	};
+
+	template<class Solver, class Pyramid>
+	inline void TVL1Solve( Image& output, const Pyramid& pyr1, const Pyramid& pyr2, size_t levels, float scalefactor, const TVL1Schedule& schedule )
+	{
+		Solver* solver = NULL;
+		for( int l = ( int ) levels - 1; l >= 0; l-- ) {
+			Solver* next = new Solver( pyr1[ l ].width(), pyr1[ l ].height() );
+			if( solver ) {
+				next->upsample( *solver, 1.0f / scalefactor );
+				delete solver;
+			}
+			solver = next;
+
+			for( size_t i = 0; i < schedule.warps; i++ ) {
+				solver->warp( pyr1[ l ], pyr2[ l ], schedule.median );
+				for( size_t k = 0; k < schedule.iterations; k++ ) {
+					float t = ( float ) k / ( float ) schedule.iterations;
+					float residual = solver->iterate( schedule.lambda * Math::exp( -t * t * schedule.decay ), schedule.theta, schedule.median );
+					if( residual < schedule.epsilon )
+						break;
+				}
+			}
+		}
+
+		solver->result( output );
+		delete solver;
+	}
+
+	template<class Derived, size_t C>
+	inline TVL1Solver<Derived, C>::TVL1Solver( size_t width, size_t height, size_t planes, float huber ) :
+		_width( width ),
+		_height( height ),
+		_mem( planes * width * height, 0.0f ),
+		_plane( planes ),
+		_huber( huber ),
+		_residual( ( height + TVL1SOLVER_BAND - 1 ) / TVL1SOLVER_BAND, 0.0f )
+	{
+		for( size_t i = 0; i < planes; i++ )
+			_plane[ i ] = &_mem[ 0 ] + i * width * height;
+	}
+
+	template<class Derived, size_t C>
+	inline void TVL1Solver<Derived, C>::warp( const Image& src1, const Image& src2, bool median )
+	{
+		IMapScoped<const float> map1( src1 );
+		IMapScoped<const float> map2( src2 );
+		_img1 = map1.base();
+		_img1stride = map1.stride();
+		_img2 = map2.base();
+		_img2stride = map2.stride();
+
+		if( median ) {
+			this->median( &_plane[ U0 ], &_plane[ U ] );
+		} else {
+			for( size_t c = 0; c < C; c++ )
+				std::copy( _plane[ U + c ], _plane[ U + c ] + _width * _height, _plane[ U0 + c ] );
+		}
+
+		static_cast<Derived*>( this )->prepare();
+	}
+
+	template<class Derived, size_t C>
+	inline float TVL1Solver<Derived, C>::iterate( float lambda, float theta, bool median )
+	{
+		_lambdatheta = lambda * theta;
+		_theta = theta;
+		ParallelFor::run( ParallelFor::bind( *this, &TVL1Solver::updateBands ), 0, _residual.size() );
+
+		for( size_t i = 0; i < 2 * C; i++ )
+			std::swap( _plane[ P + i ], _plane[ Q + i ] );
+
+		if( median ) {
+			this->median( &_plane[ U ], &_plane[ T ] );
+		} else {
+			for( size_t c = 0; c < C; c++ )
+				std::swap( _plane[ U + c ], _plane[ T + c ] );
+		}
+
+		float sum = 0.0f;
+		for( size_t i = 0; i < _residual.size(); i++ )
+			sum += _residual[ i ];
+		return Math::sqrt( sum / ( float ) ( _width * _height ) );
+	}
+
+	template<class Derived, size_t C>
+	inline void TVL1Solver<Derived, C>::median( float* const* dst, const float* const* src )
+	{
+		for( size_t c = 0; c < C; c++ ) {
+			_src[ c ] = src[ c ];
+			_dst[ c ] = dst[ c ];
+		}
+		ParallelFor::run( ParallelFor::bind( *this, &TVL1Solver::medianRows ), 0, _height, 16 );
+	}
+
+	template<class Derived, size_t C>
+	inline void TVL1Solver<Derived, C>::resetDual()
+	{
+		for( size_t i = 0; i < 2 * C; i++ )
+			std::fill( _plane[ P + i ], _plane[ P + i ] + _width * _height, 0.0f );
+	}
+
+	template<class Derived, size_t C>
+	inline void TVL1Solver<Derived, C>::updateBands( size_t start, size_t end ) const
+	{
+		const Derived& derived = static_cast<const Derived&>( *this );
+		const size_t w = _width;
+		const size_t h = _height;
+		const size_t bandsize = w * ( TVL1SOLVER_BAND + 1 );
+		const float theta = _theta;
+		const float tau = 1.0f / ( 4.0f * C * theta );
+		ScopedBuffer<float, true> buf( C * bandsize );
+
+		for( size_t band = start; band < end; band++ ) {
+			const size_t y0 = band * TVL1SOLVER_BAND;
+			const size_t y1 = Math::min( y0 + TVL1SOLVER_BAND, h );
+			const size_t yh = Math::min( y1 + 1, h );
+			float* v[ C ];
+
+			/* primal: thresholding of the linearised data term and step along the divergence of p */
+			for( size_t y = y0; y < yh; y++ ) {
+				const size_t off = y * w;
+				for( size_t c = 0; c < C; c++ )
+					v[ c ] = buf.ptr() + c * bandsize + ( y - y0 ) * w;
+				derived.primalRow( v, y );
+
+				for( size_t c = 0; c < C; c++ ) {
+					const float* px = _plane[ P + 2 * c ] + off;
+					const float* py = _plane[ P + 2 * c + 1 ] + off;
+					float* vc = v[ c ];
+					for( size_t x = 0; x < w; x++ ) {
+						float div = px[ x ] + py[ x ];
+						if( x > 0 )
+							div -= px[ x - 1 ];
+						if( y > 0 )
+							div -= py[ x - w ];
+						vc[ x ] += theta * div;
+					}
+				}
+			}
+
+			/* dual: huber regularised projected ascent weighted by the edge term */
+			float residual = 0.0f;
+			for( size_t y = y0; y < y1; y++ ) {
+				const size_t off = y * w;
+				const float* g = _plane[ G ] + off;
+				const bool last = y + 1 == h;
+				const float* u[ C ];
+				const float* p[ 2 * C ];
+				float* q[ 2 * C ];
+				float* t[ C ];
+				for( size_t c = 0; c < C; c++ ) {
+					v[ c ] = buf.ptr() + c * bandsize + ( y - y0 ) * w;
+					u[ c ] = _plane[ U + c ] + off;
+					t[ c ] = _plane[ T + c ] + off;
+				}
+				for( size_t i = 0; i < 2 * C; i++ ) {
+					p[ i ] = _plane[ P + i ] + off;
+					q[ i ] = _plane[ Q + i ] + off;
+				}
+
+				for( size_t x = 0; x < w; x++ ) {
+					float a[ 2 * C ];
+					float norm = 0.0f;
+					for( size_t c = 0; c < C; c++ ) {
+						float dx = x + 1 < w ? v[ c ][ x + 1 ] - v[ c ][ x ] : 0.0f;
+						float dy = !last ? v[ c ][ x + w ] - v[ c ][ x ] : 0.0f;
+						a[ 2 * c ] = p[ 2 * c ][ x ] + tau * ( dx - _huber * p[ 2 * c ][ x ] );
+						a[ 2 * c + 1 ] = p[ 2 * c + 1 ][ x ] + tau * ( dy - _huber * p[ 2 * c + 1 ][ x ] );
+					}
+					for( size_t i = 0; i < 2 * C; i++ )
+						norm += a[ i ] * a[ i ];
+					float n = 1.0f / Math::max( 1.0f, Math::sqrt( norm ) / g[ x ] );
+					for( size_t i = 0; i < 2 * C; i++ )
+						q[ i ][ x ] = a[ i ] * n;
+
+					float change = 0.0f;
+					for( size_t c = 0; c < C; c++ ) {
+						change += Math::sqr( v[ c ][ x ] - u[ c ][ x ] );
+						t[ c ][ x ] = v[ c ][ x ];
+					}
+					residual += change;
+				}
+			}
+			_residual[ band ] = residual;
+		}
+	}
+
+	static inline float _tvl1Median3( float a, float b, float c )
+	{
+		return Math::max( Math::min( a, b ), Math::min( Math::max( a, b ), c ) );
+	}
+
+	/* 3x3 median with clamp to edge: the columns are sorted once, the median is the median
+	   of the largest minimum, the median of the middle values and the smallest maximum */
+	template<class Derived, size_t C>
+	inline void TVL1Solver<Derived, C>::medianRows( size_t start, size_t end ) const
+	{
+		const size_t w = _width;
+		const size_t h = _height;
+		ScopedBuffer<float, true> buf( 3 * ( w + 2 ) );
+		float* lo = buf.ptr() + 1;
+		float* mid = lo + w + 2;
+		float* hi = mid + w + 2;
+
+		for( size_t y = start; y < end; y++ ) {
+			const size_t r0 = ( y > 0 ? y - 1 : 0 ) * w;
+			const size_t r2 = ( y + 1 < h ? y + 1 : y ) * w;
+			for( size_t c = 0; c < C; c++ ) {
+				const float* s0 = _src[ c ] + r0;
+				const float* s1 = _src[ c ] + y * w;
+				const float* s2 = _src[ c ] + r2;
+				float* dst = _dst[ c ] + y * w;
+
+				for( size_t x = 0; x < w; x++ ) {
+					float a = Math::min( s0[ x ], s1[ x ] );
+					float b = Math::max( s0[ x ], s1[ x ] );
+					lo[ x ] = Math::min( a, s2[ x ] );
+					hi[ x ] = Math::max( b, s2[ x ] );
+					mid[ x ] = Math::max( a, Math::min( b, s2[ x ] ) );
+				}
+				lo[ -1 ] = lo[ 0 ]; lo[ w ] = lo[ w - 1 ];
+				mid[ -1 ] = mid[ 0 ]; mid[ w ] = mid[ w - 1 ];
+				hi[ -1 ] = hi[ 0 ]; hi[ w ] = hi[ w - 1 ];
+
+				for( size_t x = 0; x < w; x++ ) {
+					float l = Math::max( lo[ x - 1 ], Math::max( lo[ x ], lo[ x + 1 ] ) );
+					float m = _tvl1Median3( mid[ x - 1 ], mid[ x ], mid[ x + 1 ] );
+					float u = Math::min( hi[ x - 1 ], Math::min( hi[ x ], hi[ x + 1 ] ) );
+					dst[ x ] = _tvl1Median3( l, m, u );
+				}
+			}
+		}
+	}
+}
+
+#endif
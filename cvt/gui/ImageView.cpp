@@ -69,6 +69,7 @@ namespace cvt {
 			if( img.format() == IFormat::BAYER_RGGB_UINT8 ||
 				img.format() == IFormat::BAYER_GBRG_UINT8 ||
 				img.format() == IFormat::BAYER_GRBG_UINT8 ||
+				img.format() == IFormat::BAYER_BGGR_UINT8 ||
 				img.format() == IFormat::YUYV_UINT8 ||
 				img.format() == IFormat::UYVY_UINT8 ) {
 				_img.reallocate( img.width(), img.height(), IFormat::RGBA_UINT8, IALLOCATOR_GL );
@@ -53,7 +53,8 @@ namespace cvt
 						return IFormat::BAYER_GRBG_UINT8;
 					case DC1394_COLOR_FILTER_GBRG:
                         return IFormat::BAYER_GBRG_UINT8;
-					case DC1394_COLOR_FILTER_BGGR:                    
+					case DC1394_COLOR_FILTER_BGGR:
+						return IFormat::BAYER_BGGR_UINT8;
 					default:
                         std::cout << "filter" << ( int )filter << std::endl;
 						throw CVTException( "unsupported bayer format" );
@@ -0,0 +1,334 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_AFFINE2D_H
+#define CVT_AFFINE2D_H
+
+#include <Eigen/Core>
+#include <cvt/math/Math.h>
+#include <cvt/math/Matrix.h>
+
+namespace cvt {
+	/**
+	 *	\class Affine2D	Affine motion in 2D
+	 *	parameters (elements of the generating matrix):
+	 *	p0:	tx
+	 *	p1:	ty
+	 *	p2:	a00
+	 *	p3:	a01
+	 *	p4:	a10
+	 *	p5:	a11
+	 */
+	template <typename T>
+	class Affine2D
+	{
+		public:
+			static const size_t NPARAMS	= 6;
+			typedef Eigen::Matrix<T, 3, 3> MatrixType;
+			typedef Eigen::Matrix<T, 3, NPARAMS> JacMatType;
+			typedef Eigen::Matrix<T, 3*NPARAMS, NPARAMS> HessMatType;
+			typedef Eigen::Matrix<T, 2, NPARAMS> ScreenJacType;
+			typedef Eigen::Matrix<T, NPARAMS, NPARAMS> ScreenHessType;
+			typedef Eigen::Matrix<T, NPARAMS, 1> ParameterVectorType;
+			typedef Eigen::Matrix<T, 3, 1> PointType;
+			typedef Eigen::Matrix<T, 2, 1> SPType;
+
+			Affine2D();
+			~Affine2D(){};
+
+			void set( T a00, T a01, T a10, T a11, T tx, T ty );
+			void set( const Matrix3<T> & mat );
+
+			/**
+			 *	\brief apply delta parameters
+			 *	\param	delta	the delta to apply
+			 *	\desc	forward update of pose: T( delta ) * T( current )
+			 */
+			void apply( const ParameterVectorType & delta );
+
+			/**
+			 *	\brief	apply delta parameters in inverse compositional way
+			 *	\param	delta	the delta to apply
+			 *	\desc	update of the pose: T(current) = T(current) * T(delta)
+			 */
+			void applyInverse( const ParameterVectorType & delta );
+
+			/* transform the point */
+			void transform( PointType & warped, const PointType & p ) const;
+			void transform( SPType & warped, const SPType & p ) const;
+
+			/* transform the point: warped = current^-1 * p */
+			void transformInverse( SPType & warped, const SPType & p ) const;
+
+			/* get the jacobian at a certain point */
+			void jacobian( JacMatType & J, const PointType & p ) const;
+
+			/* hessian of the pose */
+			void hessian( HessMatType & H, const PointType & p ) const;
+
+			/* sp = proj( transform( p ) ) */
+			void project( SPType & sp, const PointType & p ) const;
+
+			/* sp = proj( transform( p ) ), J = d proj( transform( p ) ) / d params */
+			void project( SPType & sp, ScreenJacType & J, const PointType & p ) const;
+
+			/* p is already transformed with the current T in this case, but not yet projected! */
+			void jacobianAroundT( JacMatType & J, const PointType & p ) const;
+
+			/* sp is a screen point (transformed with current) */
+			void screenJacobian( ScreenJacType & J, const SPType & sp ) const;
+
+			void screenHessian( ScreenHessType & wx,
+								ScreenHessType & wy,
+								const SPType & sp ) const;
+
+			/* get back the currently stored transformation matrix */
+			const MatrixType & transformation() const { return _current; }
+			MatrixType & transformation() { return _current; }
+
+			/* scale the current transformation: useful for scale space algorithms */
+			void scale( T s );
+
+		private:
+			void generator( MatrixType & m, const ParameterVectorType & delta ) const;
+
+			MatrixType		_current;
+	};
+
+	template < typename T >
+	inline Affine2D<T>::Affine2D() : _current( MatrixType::Identity() )
+	{
+	}
+
+	template < typename T>
+	inline void Affine2D<T>::set( T a00, T a01, T a10, T a11, T tx, T ty )
+	{
+		_current( 0, 0 ) = a00;
+		_current( 0, 1 ) = a01;
+		_current( 0, 2 ) = tx;
+		_current( 1, 0 ) = a10;
+		_current( 1, 1 ) = a11;
+		_current( 1, 2 ) = ty;
+		_current( 2, 0 ) = 0;
+		_current( 2, 1 ) = 0;
+		_current( 2, 2 ) = 1;
+	}
+
+	template <typename T>
+	inline void Affine2D<T>::set( const Matrix3<T> & mat )
+	{
+		_current( 0, 0 ) = mat[ 0 ][ 0 ];
+		_current( 0, 1 ) = mat[ 0 ][ 1 ];
+		_current( 0, 2 ) = mat[ 0 ][ 2 ];
+		_current( 1, 0 ) = mat[ 1 ][ 0 ];
+		_current( 1, 1 ) = mat[ 1 ][ 1 ];
+		_current( 1, 2 ) = mat[ 1 ][ 2 ];
+		_current( 2, 0 ) = mat[ 2 ][ 0 ];
+		_current( 2, 1 ) = mat[ 2 ][ 1 ];
+		_current( 2, 2 ) = mat[ 2 ][ 2 ];
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::generator( MatrixType & m, const ParameterVectorType & delta ) const
+	{
+		m( 0, 0 ) =  delta[ 2 ];
+		m( 0, 1 ) =  delta[ 3 ];
+		m( 0, 2 ) =  delta[ 0 ];
+
+		m( 1, 0 ) =  delta[ 4 ];
+		m( 1, 1 ) =  delta[ 5 ];
+		m( 1, 2 ) =  delta[ 1 ];
+
+		m( 2, 0 ) = 0;
+		m( 2, 1 ) = 0;
+		m( 2, 2 ) = 0;
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::apply( const ParameterVectorType & delta )
+	{
+		MatrixType m;
+		generator( m, delta );
+
+		/* m = exp( m ) */
+		cvt::Math::exponential( m, m );
+
+		/* update the current transformation */
+		_current = m * _current;
+	}
+
+	template <typename T>
+	inline void Affine2D<T>::applyInverse( const ParameterVectorType & delta )
+	{
+		MatrixType m;
+		generator( m, delta );
+
+		/* m = exp( m ) */
+		cvt::Math::exponential( m, m );
+
+		/* update current in the inverse fashion */
+		_current *= m;
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::transform( PointType & warped, const PointType & p ) const
+	{
+		warped = _current * p;
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::transform( SPType & warped, const SPType & p ) const
+	{
+		warped = _current.template block<2, 2>( 0, 0 ) * p;
+		warped[ 0 ] += _current( 0, 2 );
+		warped[ 1 ] += _current( 1, 2 );
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::transformInverse( SPType & warped, const SPType & p ) const
+	{
+		warped[ 0 ] = p[ 0 ] - _current( 0, 2 );
+		warped[ 1 ] = p[ 1 ] - _current( 1, 2 );
+		warped = ( _current.template block<2, 2>( 0, 0 ) ).inverse() * warped;
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::jacobianAroundT( JacMatType & J, const PointType & p ) const
+	{
+		J.setZero();
+		J( 0, 0 ) = p[ 2 ];
+		J( 1, 1 ) = p[ 2 ];
+		J( 0, 2 ) = p[ 0 ];
+		J( 0, 3 ) = p[ 1 ];
+		J( 1, 4 ) = p[ 0 ];
+		J( 1, 5 ) = p[ 1 ];
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::jacobian( JacMatType & J, const PointType & p ) const
+	{
+		PointType pp = _current * p;
+		jacobianAroundT( J, pp );
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::project( SPType & sp, const PointType & p ) const
+	{
+		PointType pp = _current * p;
+
+		sp[ 0 ] = pp[ 0 ] / pp[ 2 ];
+		sp[ 1 ] = pp[ 1 ] / pp[ 2 ];
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::project( SPType & sp, ScreenJacType & J, const PointType & p ) const
+	{
+		project( sp, p );
+		screenJacobian( J, sp );
+	}
+
+	template < typename T >
+	inline void Affine2D<T>::screenJacobian( ScreenJacType & J, const SPType & sp ) const
+	{
+		J( 0, 0 ) = 1;
+		J( 1, 0 ) = 0;
+
+		J( 0, 1 ) = 0;
+		J( 1, 1 ) = 1;
+
+		J( 0, 2 ) = sp[ 0 ];
+		J( 1, 2 ) = 0;
+
+		J( 0, 3 ) = sp[ 1 ];
+		J( 1, 3 ) = 0;
+
+		J( 0, 4 ) = 0;
+		J( 1, 4 ) = sp[ 0 ];
+
+		J( 0, 5 ) = 0;
+		J( 1, 5 ) = sp[ 1 ];
+	}
+
+	template <typename T>
+	inline void Affine2D<T>::hessian( HessMatType & H, const PointType & p ) const
+	{
+		H.setZero();
+
+		// 0.5 * ( G_i * G_j + G_j * G_i ), row 3 * i + k holds component k
+		H( 0, 2 ) = 0.5 * p.z();
+		H( 1, 4 ) = 0.5 * p.z();
+		H( 3, 3 ) = 0.5 * p.z();
+		H( 4, 5 ) = 0.5 * p.z();
+		H( 6, 0 ) = 0.5 * p.z();
+		H( 6, 2 ) =		  p.x();
+		H( 6, 3 ) = 0.5 * p.y();
+		H( 7, 4 ) = 0.5 * p.x();
+		H( 9, 1 ) = 0.5 * p.z();
+		H( 9, 2 ) = 0.5 * p.y();
+		H( 9, 4 ) = 0.5 * p.x();
+		H( 9, 5 ) = 0.5 * p.y();
+		H(10, 4 ) = 0.5 * p.y();
+		H(12, 3 ) = 0.5 * p.x();
+		H(13, 0 ) = 0.5 * p.z();
+		H(13, 2 ) = 0.5 * p.x();
+		H(13, 3 ) = 0.5 * p.y();
+		H(13, 5 ) = 0.5 * p.x();
+		H(15, 3 ) = 0.5 * p.y();
+		H(16, 1 ) = 0.5 * p.z();
+		H(16, 4 ) = 0.5 * p.x();
+		H(16, 5 ) =		  p.y();
+	}
+
+	template <typename T>
+	inline void Affine2D<T>::screenHessian( ScreenHessType & wx,
+											ScreenHessType & wy,
+											const SPType & sp ) const
+	{
+		T x = sp[ 0 ];
+		T y = sp[ 1 ];
+
+		wx <<   0,   0, 0.5,     0,     0,     0,
+			    0,   0,   0,   0.5,     0,     0,
+			  0.5,   0,   x, 0.5*y,     0,     0,
+			    0, 0.5, 0.5*y,   0, 0.5*x, 0.5*y,
+			    0,   0,   0, 0.5*x,     0,     0,
+			    0,   0,   0, 0.5*y,     0,     0;
+
+		wy <<   0,   0,     0,     0,   0.5,     0,
+			    0,   0,     0,     0,     0,   0.5,
+			    0,   0,     0,     0, 0.5*x,     0,
+			    0,   0,     0,     0, 0.5*y,     0,
+			  0.5,   0, 0.5*x, 0.5*y,     0, 0.5*x,
+			    0, 0.5,     0,     0, 0.5*x,     y;
+	}
+
+	template <typename T>
+	inline void Affine2D<T>::scale( T s )
+	{
+		_current.template block<2, 3>( 0, 0 ) *= s;
+	}
+}
+
+#endif
@@ -81,6 +81,8 @@ namespace cvt
 		const PointSet<3, T> &    _points3d;
 		const PointSet<2, T> &    _points2d;
 		const Matrix3<T>	 &    _intrinsics;
+		/* control points of all points, shared by the samples */
+		EPnP<T>					  _epnp;
     };
 
         
@@ -88,25 +90,16 @@ namespace cvt
 	inline EPnPSAC<T>::EPnPSAC( const PointSet<3, T> & p3d, const PointSet<2, T> & p2d, const Matrix3<T> & K ) :
 		_points3d( p3d ),
 		_points2d( p2d ),
-		_intrinsics( K )
+		_intrinsics( K ),
+		_epnp( p3d )
     {
     }
 
 	template <typename T>
 	inline typename EPnPSAC<T>::ResultType EPnPSAC<T>::estimate( const std::vector<size_t> & sampleIndices ) const
     {
-		PointSet<3, T> p3d;
-		PointSet<2, T> p2d;
-
-        for( size_t i = 0; i < sampleIndices.size(); i++ ){
-            p3d.add( _points3d[ sampleIndices[ i ] ] );
-            p2d.add( _points2d[ sampleIndices[ i ] ] );
-        }
-		
-		EPnP<T> epnp( p3d );
-
 		Matrix4<T> trans;
-		epnp.solve( trans, p2d, _intrinsics );
+		_epnp.solve( trans, _points2d, _intrinsics, &sampleIndices[ 0 ], sampleIndices.size() );
 
         return trans; 
     }
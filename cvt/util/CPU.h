@@ -40,40 +40,66 @@ namespace cvt {
 		CPU_SSE4_1 = ( 1 << 6 ),
 		CPU_SSE4_2 = ( 1 << 7 ),
 		CPU_AVX    = ( 1 << 8 ),
+		CPU_F16C   = ( 1 << 9 ),
+		CPU_AVX2   = ( 1 << 10 ),
 	};
 
 	CVT_ENUM_TO_FLAGS( CPUFeatureFlags, CPUFeatures )
 
-	static inline CPUFeatures cpuFeatures( void )
+	static inline void _cpuid( uint32_t leaf, uint32_t subleaf, uint32_t& eax, uint32_t& ebx, uint32_t& ecx, uint32_t& edx )
 	{
-		CPUFeatures ret = CPU_BASE;
-		uint32_t eax, ebx, ecx, edx;
-
 #ifdef ARCH_x86_64
-		/* FIXME: what a clusterfuck - this works only for x86_64, we need to save ebx on x86
-				  BUT cpuid on x86_64 destroys rbx and not only ebx
-		 */
 		asm volatile(
-			"movl $1, %%eax;\n\t"
 			"cpuid;\n\t"
 				: "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
-				:
+				: "a"(leaf), "c"(subleaf)
 				:
 			);
 #elif ARCH_x86
+		/* ebx is the PIC register on x86 and has to be preserved */
 		asm volatile(
 			"movl %%ebx, %%esi;\n\t"
-			"movl $1, %%eax;\n\t"
 			"cpuid;\n\t"
 			"xchgl %%ebx, %%esi;\n\t"
 				: "=a"(eax), "=S"(ebx), "=c"(ecx), "=d"(edx)
-				:
+				: "a"(leaf), "c"(subleaf)
 				:
 			);
-
 #else
+		( void ) leaf;
+		( void ) subleaf;
 		eax = ebx = ecx = edx = 0;
 #endif
+	}
+
+	/* low word of the extended control register XCR0, only valid if OSXSAVE is set */
+	static inline uint32_t _xgetbv0()
+	{
+#if defined( ARCH_x86_64 ) || defined( ARCH_x86 )
+		uint32_t eax, edx;
+		/* xgetbv opcode, older assemblers do not know the mnemonic */
+		asm volatile(
+			".byte 0x0f, 0x01, 0xd0;\n\t"
+				: "=a"(eax), "=d"(edx)
+				: "c"(0)
+				:
+			);
+		return eax;
+#else
+		return 0;
+#endif
+	}
+
+	static inline CPUFeatures cpuFeatures( void )
+	{
+		CPUFeatures ret = CPU_BASE;
+		uint32_t maxleaf, eax, ebx, ecx, edx;
+
+		_cpuid( 0, 0, maxleaf, ebx, ecx, edx );
+		if( maxleaf < 1 )
+			return ret;
+
+		_cpuid( 1, 0, eax, ebx, ecx, edx );
 
 		if( edx & ( 1 << 23 ) )
 			ret |= CPU_MMX;
@@ -83,16 +109,28 @@ namespace cvt {
 			ret |= CPU_SSE2;
 		if( ecx & ( 1 <<  0 ) )
 			ret |= CPU_SSE3;
-		if( ecx & ( 1 <<  0 ) )
-			ret |= CPU_SSE3;
 		if( ecx & ( 1 <<  9 ) )
 			ret |= CPU_SSSE3;
 		if( ecx & ( 1 << 19 ) )
 			ret |= CPU_SSE4_1;
 		if( ecx & ( 1 << 20 ) )
 			ret |= CPU_SSE4_2;
+
+		/* the AVX extensions are only usable if the OS saves the SSE and AVX state ( OSXSAVE + XCR0 bits 1 and 2 ) */
+		if( !( ecx & ( 1 << 27 ) ) || ( _xgetbv0() & 0x6 ) != 0x6 )
+			return ret;
+
 		if( ecx & ( 1 << 28 ) )
 			ret |= CPU_AVX;
+		if( ecx & ( 1 << 29 ) )
+			ret |= CPU_F16C;
+
+		/* structured extended features */
+		if( ( ret & CPU_AVX ) && maxleaf >= 7 ) {
+			_cpuid( 7, 0, eax, ebx, ecx, edx );
+			if( ebx & ( 1 << 5 ) )
+				ret |= CPU_AVX2;
+		}
 		return ret;
 	}
 
@@ -117,6 +155,10 @@ namespace cvt {
 			std::cout << "SSE4.2 ";
 		if( f & CPU_AVX )
 			std::cout << "AVX ";
+		if( f & CPU_F16C )
+			std::cout << "F16C ";
+		if( f & CPU_AVX2 )
+			std::cout << "AVX2 ";
 		std::cout << std::endl;
 	}
 
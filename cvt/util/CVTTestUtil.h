@@ -0,0 +1,89 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_CVTTESTUTIL_H
+#define CVT_CVTTESTUTIL_H
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+
+#include <string.h>
+
+namespace cvt {
+
+	/* same size, format and bitwise identical pixels */
+	static inline bool testImagesEqual( const Image& a, const Image& b )
+	{
+		if( a.width() != b.width() || a.height() != b.height() || a.format() != b.format() )
+			return false;
+
+		IMapScoped<const uint8_t> ma( a );
+		IMapScoped<const uint8_t> mb( b );
+		for( size_t y = 0; y < a.height(); y++ ) {
+			if( memcmp( ma.ptr(), mb.ptr(), a.width() * a.format().bpp ) )
+				return false;
+			ma++;
+			mb++;
+		}
+		return true;
+	}
+
+	/* for results providing operator== */
+	template<typename T>
+	static inline bool testEqual( const T& a, const T& b )
+	{
+		return a == b;
+	}
+
+	/**
+	  Calls op( result ) single threaded and with 3 and 4 threads and compares the multi-threaded
+	  results against the single threaded one with equal( a, b ). Every result starts as a copy of
+	  init. The previous thread count is restored.
+	 */
+	template<typename Result, typename Op, typename Equal>
+	static inline bool testThreadInvariance( const Op& op, Equal equal, const Result& init = Result() )
+	{
+		static const size_t threads[ 3 ] = { 1, 3, 4 };
+		size_t old = ParallelFor::numThreads();
+		bool ret = true;
+
+		Result ref( init );
+		ParallelFor::setNumThreads( threads[ 0 ] );
+		op( ref );
+		for( size_t i = 1; i < 3; i++ ) {
+			Result res( init );
+			ParallelFor::setNumThreads( threads[ i ] );
+			op( res );
+			ret &= equal( ref, res );
+		}
+
+		ParallelFor::setNumThreads( old );
+		return ret;
+	}
+
+}
+
+#endif
@@ -0,0 +1,173 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/Mutex.h>
+#include <cvt/util/Condition.h>
+
+#include <vector>
+
+namespace cvt {
+
+	/* persistent workers executing the chunks of ParallelFor::run, grown on demand */
+	class ParallelForPool
+	{
+		public:
+			static ParallelForPool& instance();
+
+			/* false if the pool is already executing a loop */
+			bool run( const ParallelFor::Job& job );
+
+		private:
+			class Worker : public Thread<ParallelForPool> {
+				public:
+					void execute( ParallelForPool* pool ) { pool->work(); }
+			};
+
+			ParallelForPool();
+			~ParallelForPool();
+			ParallelForPool( const ParallelForPool& );
+
+			void work();
+			void process( const ParallelFor::Job& job );
+
+			Mutex					_mutex;
+			Condition				_start;
+			Condition				_done;
+			std::vector<Worker*>	_workers;
+			const ParallelFor::Job* _job;
+			size_t					_generation;
+			size_t					_next;
+			size_t					_finished;
+			bool					_busy;
+			bool					_quit;
+	};
+
+	ParallelForPool& ParallelForPool::instance()
+	{
+		static ParallelForPool pool;
+		return pool;
+	}
+
+	ParallelForPool::ParallelForPool() :
+		_job( 0 ),
+		_generation( 0 ),
+		_next( 0 ),
+		_finished( 0 ),
+		_busy( false ),
+		_quit( false )
+	{
+	}
+
+	ParallelForPool::~ParallelForPool()
+	{
+		_mutex.lock();
+		_quit = true;
+		_start.notifyAll();
+		_mutex.unlock();
+
+		for( size_t i = 0; i < _workers.size(); i++ ) {
+			_workers[ i ]->join();
+			delete _workers[ i ];
+		}
+	}
+
+	bool ParallelForPool::run( const ParallelFor::Job& job )
+	{
+		ScopeLock lock( &_mutex );
+		if( _busy )
+			return false;
+
+		/* the caller takes part, so nchunks - 1 workers keep all chunks busy */
+		while( _workers.size() < job.nchunks - 1 ) {
+			Worker* worker = new Worker();
+			worker->run( this );
+			_workers.push_back( worker );
+		}
+
+		_busy = true;
+		_job = &job;
+		_next = 0;
+		_finished = 0;
+		_generation++;
+		_start.notifyAll();
+
+		process( job );
+		while( _finished < job.nchunks )
+			_done.wait( _mutex );
+
+		_job = 0;
+		_busy = false;
+		return true;
+	}
+
+	/* executes chunks of job until none is left, called with the mutex locked */
+	void ParallelForPool::process( const ParallelFor::Job& job )
+	{
+		while( _next < job.nchunks ) {
+			size_t chunk = _next++;
+			_mutex.unlock();
+			job.execute( chunk );
+			_mutex.lock();
+			if( ++_finished == job.nchunks )
+				_done.notify();
+		}
+	}
+
+	void ParallelForPool::work()
+	{
+		size_t generation = 0;
+
+		ScopeLock lock( &_mutex );
+		for( ;; ) {
+			while( !_quit && generation == _generation )
+				_start.wait( _mutex );
+			if( _quit )
+				return;
+			generation = _generation;
+			if( _job )
+				process( *_job );
+		}
+	}
+
+	void ParallelFor::_run( const Job& job )
+	{
+		if( ParallelForPool::instance().run( job ) )
+			return;
+
+		/* nested or concurrent call, use temporary threads */
+		Worker* workers = new Worker[ job.nchunks - 1 ];
+		for( size_t i = 0; i < job.nchunks - 1; i++ ) {
+			workers[ i ].set( &job, i );
+			workers[ i ].run( NULL );
+		}
+
+		job.execute( job.nchunks - 1 );
+
+		for( size_t i = 0; i < job.nchunks - 1; i++ )
+			workers[ i ].join();
+		delete[] workers;
+	}
+}
@@ -0,0 +1,226 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_PARALLELFOR_H
+#define CVT_PARALLELFOR_H
+
+#include <cvt/util/Thread.h>
+#include <unistd.h>
+
+namespace cvt {
+
+	/**
+	  @brief Run a range based loop body on multiple threads.
+
+	  The range [begin, end) is split into at most numThreads() contiguous chunks,
+	  each chunk is a multiple of grain (except the last one). The calling thread
+	  processes chunks itself and returns after all chunks are done.
+	  The body has to provide
+		void operator()( size_t begin, size_t end ) const;
+	  and must not throw.
+
+	  The chunks are executed by a pool of worker threads, which is created on first use
+	  and kept until exit, so a call only costs waking the workers. Calls made while the
+	  pool is busy (from inside a loop body or concurrently from another thread) start
+	  their own threads instead.
+
+	  bind() and each() adapt member functions and per index functors to loop bodies:
+		ParallelFor::run( ParallelFor::bind( *this, &Solver::rows ), 0, height, grain );
+	 */
+	class ParallelFor {
+		friend class ParallelForPool;
+		public:
+			template<typename Body>
+			static void run( const Body& body, size_t begin, size_t end, size_t grain = 1 );
+
+			/**
+			  Number of threads used by run(), defaults to the number of online cpus
+			 */
+			static size_t numThreads();
+
+			/**
+			  Set the number of threads used by run(), 0 restores the default
+			 */
+			static void	  setNumThreads( size_t n );
+
+			/* calls ( obj.*func )( start, end ) */
+			template<typename T>
+			class Member {
+				public:
+					typedef void ( T::*Func )( size_t start, size_t end ) const;
+
+					Member( const T& obj, Func func ) : _obj( obj ), _func( func ) {}
+					void operator()( size_t start, size_t end ) const { ( _obj.*_func )( start, end ); }
+
+				private:
+					const T&	_obj;
+					Func		_func;
+			};
+
+			/* calls ( obj.*func )( arg, start, end ) */
+			template<typename T, typename A>
+			class MemberArg {
+				public:
+					typedef void ( T::*Func )( const A& arg, size_t start, size_t end ) const;
+
+					MemberArg( const T& obj, Func func, const A& arg ) : _obj( obj ), _func( func ), _arg( arg ) {}
+					void operator()( size_t start, size_t end ) const { ( _obj.*_func )( _arg, start, end ); }
+
+				private:
+					const T&	_obj;
+					Func		_func;
+					const A&	_arg;
+			};
+
+			/* calls ( obj.*func )( i ) for every index of the range */
+			template<typename T>
+			class MemberIndex {
+				public:
+					typedef void ( T::*Func )( size_t i ) const;
+
+					MemberIndex( const T& obj, Func func ) : _obj( obj ), _func( func ) {}
+					void operator()( size_t start, size_t end ) const
+					{
+						for( size_t i = start; i < end; i++ )
+							( _obj.*_func )( i );
+					}
+
+				private:
+					const T&	_obj;
+					Func		_func;
+			};
+
+			/* calls func( i ) for every index of the range */
+			template<typename F>
+			class Each {
+				public:
+					Each( const F& func ) : _func( func ) {}
+					void operator()( size_t start, size_t end ) const
+					{
+						for( size_t i = start; i < end; i++ )
+							_func( i );
+					}
+
+				private:
+					const F&	_func;
+			};
+
+			/* the adapters only keep references, they have to be used within the expression creating them */
+			template<typename T>
+			static Member<T>		bind( const T& obj, void ( T::*func )( size_t start, size_t end ) const ) { return Member<T>( obj, func ); }
+			template<typename T, typename A>
+			static MemberArg<T, A>	bind( const T& obj, void ( T::*func )( const A& arg, size_t start, size_t end ) const, const A& arg ) { return MemberArg<T, A>( obj, func, arg ); }
+			template<typename T>
+			static MemberIndex<T>	bind( const T& obj, void ( T::*func )( size_t i ) const ) { return MemberIndex<T>( obj, func ); }
+			template<typename F>
+			static Each<F>			each( const F& func ) { return Each<F>( func ); }
+
+		private:
+			ParallelFor();
+			ParallelFor( const ParallelFor& );
+
+			static size_t& _threads();
+
+			/* type erased loop, chunk i covers the blocks [i * nblocks / nchunks, ( i + 1 ) * nblocks / nchunks ) */
+			struct Job {
+				void	( *call )( const void* body, size_t begin, size_t end );
+				const void* body;
+				size_t	begin, end, grain;
+				size_t	nblocks, nchunks;
+
+				size_t	chunkBegin( size_t i ) const { return begin + ( i * nblocks / nchunks ) * grain; }
+				size_t	chunkEnd( size_t i ) const { return i + 1 == nchunks ? end : chunkBegin( i + 1 ); }
+				void	execute( size_t i ) const { call( body, chunkBegin( i ), chunkEnd( i ) ); }
+			};
+
+			template<typename Body>
+			static void _call( const void* body, size_t begin, size_t end ) { ( *( const Body* ) body )( begin, end ); }
+
+			static void _run( const Job& job );
+
+			class Worker : public Thread<void> {
+				public:
+					Worker() : _job( 0 ), _chunk( 0 ) {}
+					void set( const Job* job, size_t chunk ) { _job = job; _chunk = chunk; }
+					void execute( void* ) { _job->execute( _chunk ); }
+
+				private:
+					const Job*	_job;
+					size_t		_chunk;
+			};
+	};
+
+	inline size_t& ParallelFor::_threads()
+	{
+		static size_t threads = 0;
+		return threads;
+	}
+
+	inline size_t ParallelFor::numThreads()
+	{
+		size_t& n = _threads();
+		if( !n ) {
+			long ncpu = sysconf( _SC_NPROCESSORS_ONLN );
+			n = ncpu > 0 ? ( size_t ) ncpu : 1;
+		}
+		return n;
+	}
+
+	inline void ParallelFor::setNumThreads( size_t n )
+	{
+		_threads() = n;
+	}
+
+	template<typename Body>
+	inline void ParallelFor::run( const Body& body, size_t begin, size_t end, size_t grain )
+	{
+		if( end <= begin )
+			return;
+		if( !grain )
+			grain = 1;
+
+		size_t nblocks = ( end - begin + grain - 1 ) / grain;
+		size_t nchunks = numThreads();
+		if( nchunks > nblocks )
+			nchunks = nblocks;
+
+		if( nchunks <= 1 ) {
+			body( begin, end );
+			return;
+		}
+
+		Job job;
+		job.call	= &ParallelFor::_call<Body>;
+		job.body	= &body;
+		job.begin	= begin;
+		job.end		= end;
+		job.grain	= grain;
+		job.nblocks = nblocks;
+		job.nchunks = nchunks;
+		_run( job );
+	}
+}
+
+#endif
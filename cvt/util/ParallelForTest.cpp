@@ -0,0 +1,133 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/CVTTest.h>
+
+#include <vector>
+
+using namespace cvt;
+
+class ParallelForCount {
+	public:
+		ParallelForCount( std::vector<int>& count ) : _count( count ) {}
+
+		void operator()( size_t start, size_t end ) const
+		{
+			for( size_t i = start; i < end; i++ )
+				_count[ i ]++;
+		}
+
+		void rows( size_t start, size_t end ) const { ( *this )( start, end ); }
+		void row( size_t i ) const { _count[ i ]++; }
+		void offset( const size_t& off, size_t start, size_t end ) const { ( *this )( start + off, end + off ); }
+
+	private:
+		std::vector<int>& _count;
+};
+
+/* every index of the inner range counted once per outer index */
+class ParallelForNested {
+	public:
+		ParallelForNested( std::vector<int>& count, size_t n ) : _count( count ), _n( n ) {}
+
+		void operator()( size_t i ) const
+		{
+			ParallelFor::run( ParallelForCount( _count ), i * _n, ( i + 1 ) * _n, 7 );
+		}
+
+	private:
+		std::vector<int>&	_count;
+		size_t				_n;
+};
+
+static bool _countEqual( const std::vector<int>& count, size_t begin, size_t end, int value )
+{
+	for( size_t i = 0; i < count.size(); i++ ) {
+		int expected = ( i >= begin && i < end ) ? value : 0;
+		if( count[ i ] != expected )
+			return false;
+	}
+	return true;
+}
+
+static bool _coverageTest( size_t threads )
+{
+	bool ret = true;
+	ParallelFor::setNumThreads( threads );
+	for( size_t n = 0; n < 200; n += 13 ) {
+		for( size_t grain = 0; grain < 20; grain += 3 ) {
+			std::vector<int> count( n + 10, 0 );
+			for( int k = 0; k < 10; k++ )
+				ParallelFor::run( ParallelForCount( count ), 5, n + 5, grain );
+			ret &= _countEqual( count, 5, n + 5, 10 );
+		}
+	}
+	ParallelFor::setNumThreads( 0 );
+	return ret;
+}
+
+BEGIN_CVTTEST( ParallelFor )
+	bool ret = true;
+	bool b;
+
+	b = _coverageTest( 1 ) && _coverageTest( 3 ) && _coverageTest( 8 );
+	CVTTEST_PRINT( "coverage", b );
+	ret &= b;
+
+	/* the pool grows with the thread count and keeps working if it shrinks again */
+	b = _coverageTest( 16 ) && _coverageTest( 2 );
+	CVTTEST_PRINT( "thread count changes", b );
+	ret &= b;
+
+	ParallelFor::setNumThreads( 4 );
+	std::vector<int> count( 1000, 0 );
+	for( int k = 0; k < 1000; k++ )
+		ParallelFor::run( ParallelForCount( count ), 0, 1000, 16 );
+	b = _countEqual( count, 0, 1000, 1000 );
+	CVTTEST_PRINT( "repeated calls", b );
+	ret &= b;
+
+	count.assign( 40 * 50, 0 );
+	ParallelFor::run( ParallelFor::each( ParallelForNested( count, 50 ) ), 0, 40 );
+	b = _countEqual( count, 0, 40 * 50, 1 );
+	CVTTEST_PRINT( "nested calls", b );
+	ret &= b;
+
+	count.assign( 300, 0 );
+	ParallelForCount counter( count );
+	size_t off = 100;
+	ParallelFor::run( ParallelFor::bind( counter, &ParallelForCount::rows ), 0, 100, 8 );
+	ParallelFor::run( ParallelFor::bind( counter, &ParallelForCount::row ), 0, 100, 8 );
+	ParallelFor::run( ParallelFor::bind( counter, &ParallelForCount::offset, off ), 100, 200, 8 );
+	b = true;
+	for( size_t i = 0; i < 300; i++ )
+		b &= count[ i ] == ( i < 100 ? 2 : ( i >= 200 ? 1 : 0 ) );
+	CVTTEST_PRINT( "member adapters", b );
+	ret &= b;
+	ParallelFor::setNumThreads( 0 );
+
+	return ret;
+END_CVTTEST
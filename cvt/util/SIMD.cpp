@@ -33,8 +33,11 @@
 #include <cvt/util/SIMDSSE41.h>
 #include <cvt/util/SIMDSSE42.h>
 #include <cvt/util/SIMDAVX.h>
+#include <cvt/util/SIMDAVX2.h>
 #include <cvt/util/CPU.h>
 
+#include <float.h>
+
 
 namespace cvt {
     const float _table_alpha_u8_f[256] = {
@@ -745,7 +748,9 @@ namespace cvt {
         if( type == SIMD_BEST ) {
             CPUFeatures cpuf;
             cpuf = cpuFeatures();
-            if( cpuf & CPU_AVX ){
+            if( cpuf & CPU_AVX2 ){
+                return new SIMDAVX2();
+            } else if( cpuf & CPU_AVX ){
                 return new SIMDAVX();
             } else if( cpuf & CPU_SSE4_2 ){
                 return new SIMDSSE42();
@@ -773,6 +778,7 @@ namespace cvt {
                 case SIMD_SSE41: return new SIMDSSE41();
                 case SIMD_SSE42: return new SIMDSSE42();
                 case SIMD_AVX: return new SIMDAVX();
+                case SIMD_AVX2: return new SIMDAVX2();
             }
         }
     }
@@ -781,7 +787,9 @@ namespace cvt {
     {
         CPUFeatures cpuf;
         cpuf = cpuFeatures();
-        if( cpuf & CPU_AVX ){
+        if( cpuf & CPU_AVX2 ){
+            return SIMD_AVX2;
+        } else if( cpuf & CPU_AVX ){
             return SIMD_AVX;
         } else if( cpuf & CPU_SSE4_2 ){
             return SIMD_SSE42;
@@ -2231,6 +2239,138 @@ namespace cvt {
         }
     }
 
+    void SIMD::Conv_XYZu8_to_ZYXAu8( uint8_t* dst, const uint8_t* src, const size_t n ) const
+    {
+        size_t i = n;
+        while( i-- ) {
+            *dst++ = src[ 2 ];
+            *dst++ = src[ 1 ];
+            *dst++ = src[ 0 ];
+            *dst++ = 255;
+            src += 3;
+        }
+    }
+
+    void SIMD::Conv_XYZAu8_to_ZYXu8( uint8_t* dst, const uint8_t* src, const size_t n ) const
+    {
+        size_t i = n;
+        while( i-- ) {
+            *dst++ = src[ 2 ];
+            *dst++ = src[ 1 ];
+            *dst++ = src[ 0 ];
+            src += 4;
+        }
+    }
+
+    void SIMD::Conv_RGBu8_to_GRAYu8( uint8_t* dst, const uint8_t* src, const size_t n ) const
+    {
+        size_t i = n;
+        int v;
+
+        while( i-- ) {
+            v = 306 * src[ 0 ];
+            v += 601 * src[ 1 ];
+            v += 117 * src[ 2 ];
+            *dst++ = ( uint8_t ) ( v >> 10 );
+            src += 3;
+        }
+    }
+
+    void SIMD::Conv_BGRu8_to_GRAYu8( uint8_t* dst, const uint8_t* src, const size_t n ) const
+    {
+        size_t i = n;
+        int v;
+
+        while( i-- ) {
+            v = 117 * src[ 0 ];
+            v += 601 * src[ 1 ];
+            v += 306 * src[ 2 ];
+            *dst++ = ( uint8_t ) ( v >> 10 );
+            src += 3;
+        }
+    }
+
+    void SIMD::Conv_RGBu8_to_GRAYf( float* dst, const uint8_t* src, const size_t n ) const
+    {
+        size_t i = n;
+        float v;
+
+        while( i-- ) {
+            v = 0.2126f * SRGB_U8_TO_F( src[ 0 ] );
+            v += 0.7152f * SRGB_U8_TO_F( src[ 1 ] );
+            v += 0.0722f * SRGB_U8_TO_F( src[ 2 ] );
+            *dst++ = v;
+            src += 3;
+        }
+    }
+
+    void SIMD::Conv_BGRu8_to_GRAYf( float* dst, const uint8_t* src, const size_t n ) const
+    {
+        size_t i = n;
+        float v;
+
+        while( i-- ) {
+            v = 0.0722f * SRGB_U8_TO_F( src[ 0 ] );
+            v += 0.7152f * SRGB_U8_TO_F( src[ 1 ] );
+            v += 0.2126f * SRGB_U8_TO_F( src[ 2 ] );
+            *dst++ = v;
+            src += 3;
+        }
+    }
+
+    void SIMD::Conv_f_to_f16( uint16_t* dst, const float* src, const size_t n ) const
+    {
+        Math::_flint32 in, tmp;
+        uint32_t sign, mantodd;
+        size_t i = n;
+
+        while( i-- ) {
+            in.f = *src++;
+            sign = in.i & 0x80000000;
+            in.i ^= sign;
+
+            if( in.i >= 0x47800000 ) {
+                // overflow to inf, keep NaN a (quiet) NaN
+                *dst++ = ( uint16_t ) ( ( ( in.i > 0x7f800000 ) ? 0x7e00 : 0x7c00 ) | ( sign >> 16 ) );
+            } else if( in.i < 0x38800000 ) {
+                // denormal or zero - let the FPU do the rounding
+                tmp.i = 0x3f000000;
+                in.f += tmp.f;
+                *dst++ = ( uint16_t ) ( ( in.i - 0x3f000000 ) | ( sign >> 16 ) );
+            } else {
+                // normal, rebias exponent and round to nearest even
+                mantodd = ( in.i >> 13 ) & 1;
+                in.i += 0xc8000fff + mantodd;
+                *dst++ = ( uint16_t ) ( ( in.i >> 13 ) | ( sign >> 16 ) );
+            }
+        }
+    }
+
+    void SIMD::Conv_f16_to_f( float* dst, const uint16_t* src, const size_t n ) const
+    {
+        Math::_flint32 out, magic;
+        uint32_t exp;
+        size_t i = n;
+
+        magic.i = 113 << 23;
+        while( i-- ) {
+            out.i = ( ( uint32_t ) ( *src & 0x7fff ) ) << 13;
+            exp = out.i & 0x0f800000;
+            out.i += ( 127 - 15 ) << 23;
+
+            if( exp == 0x0f800000 ) {
+                // inf or NaN
+                out.i += ( 128 - 16 ) << 23;
+            } else if( !exp ) {
+                // zero or denormal
+                out.i += 1 << 23;
+                out.f -= magic.f;
+            }
+            out.i |= ( ( uint32_t ) ( *src++ & 0x8000 ) ) << 16;
+            *dst++ = out.f;
+        }
+    }
+
     void SIMD::Conv_XXXf_to_XXXAf( float* dst, const float* src, size_t n ) const {
         while ( n-- ) {
             *dst++ = *src++;
@@ -2763,6 +2903,79 @@ namespace cvt {
         }
     }
 
+
+    void SIMD::Conv_NV12u8_to_RGBAu8( uint8_t* dst, const uint8_t* srcy, const uint8_t* srcuv, const size_t n ) const
+    {
+        size_t i = n >> 1;
+        int r, g, b, y, u, v;
+
+        while( i-- ) {
+            u = *srcuv++ - 128;
+            v = *srcuv++ - 128;
+            r = ((v*1634) >> 10);
+            g = ((u*401 + v*832) >> 10);
+            b = ((u*2066) >> 10);
+
+            y = ( ( ( int ) *srcy++ - 16 ) * 1192 ) >> 10;
+            *dst++ = Math::clamp( y + r, 0, 255 );
+            *dst++ = Math::clamp( y - g, 0, 255 );
+            *dst++ = Math::clamp( y + b, 0, 255 );
+            *dst++ = 0xff;
+
+            y = ( ( ( int ) *srcy++ - 16 ) * 1192 ) >> 10;
+            *dst++ = Math::clamp( y + r, 0, 255 );
+            *dst++ = Math::clamp( y - g, 0, 255 );
+            *dst++ = Math::clamp( y + b, 0, 255 );
+            *dst++ = 0xff;
+        }
+
+        if( n & 0x1 ) {
+            u = srcuv[ 0 ] - 128;
+            v = srcuv[ 1 ] - 128;
+            y = ( ( ( int ) *srcy - 16 ) * 1192 ) >> 10;
+            *dst++ = Math::clamp( y + ((v*1634) >> 10), 0, 255 );
+            *dst++ = Math::clamp( y - ((u*401 + v*832) >> 10), 0, 255 );
+            *dst++ = Math::clamp( y + ((u*2066) >> 10), 0, 255 );
+            *dst++ = 0xff;
+        }
+    }
+
+    void SIMD::Conv_NV12u8_to_BGRAu8( uint8_t* dst, const uint8_t* srcy, const uint8_t* srcuv, const size_t n ) const
+    {
+        size_t i = n >> 1;
+        int r, g, b, y, u, v;
+
+        while( i-- ) {
+            u = *srcuv++ - 128;
+            v = *srcuv++ - 128;
+            r = ((v*1634) >> 10);
+            g = ((u*401 + v*832) >> 10);
+            b = ((u*2066) >> 10);
+
+            y = ( ( ( int ) *srcy++ - 16 ) * 1192 ) >> 10;
+            *dst++ = Math::clamp( y + b, 0, 255 );
+            *dst++ = Math::clamp( y - g, 0, 255 );
+            *dst++ = Math::clamp( y + r, 0, 255 );
+            *dst++ = 0xff;
+
+            y = ( ( ( int ) *srcy++ - 16 ) * 1192 ) >> 10;
+            *dst++ = Math::clamp( y + b, 0, 255 );
+            *dst++ = Math::clamp( y - g, 0, 255 );
+            *dst++ = Math::clamp( y + r, 0, 255 );
+            *dst++ = 0xff;
+        }
+
+        if( n & 0x1 ) {
+            u = srcuv[ 0 ] - 128;
+            v = srcuv[ 1 ] - 128;
+            y = ( ( ( int ) *srcy - 16 ) * 1192 ) >> 10;
+            *dst++ = Math::clamp( y + ((u*2066) >> 10), 0, 255 );
+            *dst++ = Math::clamp( y - ((u*401 + v*832) >> 10), 0, 255 );
+            *dst++ = Math::clamp( y + ((v*1634) >> 10), 0, 255 );
+            *dst++ = 0xff;
+        }
+    }
+
     void SIMD::Decompose_4f( float* dst1, float* dst2, float* dst3, float* dst4, const float* src, size_t n ) const
     {
         while( n-- ) {
@@ -2926,6 +3139,62 @@ namespace cvt {
         }
     }
 
+    void SIMD::IIR4Horizontal4f( float* dst, const float* src, size_t width, const float* n, const float* m,
+                                 const float* d, float b1, float b2 ) const
+    {
+        float x[ 4 ][ 4 ], y[ 4 ][ 4 ], v;
+        const float* px;
+        float* py;
+
+        /* causal pass, the history before the first pixel is the steady state of the edge value */
+        for( size_t l = 0; l < 4; l++ ) {
+            x[ 0 ][ l ] = x[ 1 ][ l ] = x[ 2 ][ l ] = src[ l ];
+            y[ 0 ][ l ] = y[ 1 ][ l ] = y[ 2 ][ l ] = y[ 3 ][ l ] = b1 * src[ l ];
+        }
+
+        px = src;
+        py = dst;
+        for( size_t i = 0; i < width; i++ ) {
+            for( size_t l = 0; l < 4; l++ ) {
+                v = n[ 0 ] * px[ l ] + n[ 1 ] * x[ 0 ][ l ] + n[ 2 ] * x[ 1 ][ l ] + n[ 3 ] * x[ 2 ][ l ]
+                    - d[ 0 ] * y[ 0 ][ l ] - d[ 1 ] * y[ 1 ][ l ] - d[ 2 ] * y[ 2 ][ l ] - d[ 3 ] * y[ 3 ][ l ];
+                x[ 2 ][ l ] = x[ 1 ][ l ]; x[ 1 ][ l ] = x[ 0 ][ l ]; x[ 0 ][ l ] = px[ l ];
+                y[ 3 ][ l ] = y[ 2 ][ l ]; y[ 2 ][ l ] = y[ 1 ][ l ]; y[ 1 ][ l ] = y[ 0 ][ l ]; y[ 0 ][ l ] = v;
+                py[ l ] = v;
+            }
+            px += 4;
+            py += 4;
+        }
+
+        /* anti-causal pass, the result at i depends on the inputs after i */
+        px = src + 4 * ( width - 1 );
+        py = dst + 4 * ( width - 1 );
+        for( size_t l = 0; l < 4; l++ ) {
+            x[ 0 ][ l ] = x[ 1 ][ l ] = x[ 2 ][ l ] = x[ 3 ][ l ] = px[ l ];
+            y[ 0 ][ l ] = y[ 1 ][ l ] = y[ 2 ][ l ] = y[ 3 ][ l ] = b2 * px[ l ];
+        }
+
+        for( size_t i = 0; i < width; i++ ) {
+            for( size_t l = 0; l < 4; l++ ) {
+                v = m[ 0 ] * x[ 0 ][ l ] + m[ 1 ] * x[ 1 ][ l ] + m[ 2 ] * x[ 2 ][ l ] + m[ 3 ] * x[ 3 ][ l ]
+                    - d[ 0 ] * y[ 0 ][ l ] - d[ 1 ] * y[ 1 ][ l ] - d[ 2 ] * y[ 2 ][ l ] - d[ 3 ] * y[ 3 ][ l ];
+                x[ 3 ][ l ] = x[ 2 ][ l ]; x[ 2 ][ l ] = x[ 1 ][ l ]; x[ 1 ][ l ] = x[ 0 ][ l ]; x[ 0 ][ l ] = px[ l ];
+                y[ 3 ][ l ] = y[ 2 ][ l ]; y[ 2 ][ l ] = y[ 1 ][ l ]; y[ 1 ][ l ] = y[ 0 ][ l ]; y[ 0 ][ l ] = v;
+                py[ l ] += v;
+            }
+            px -= 4;
+            py -= 4;
+        }
+    }
+
+    void SIMD::IIR4Vertical_f( float* dst, const float** x, const float** y, const float* n, const float* d, size_t width ) const
+    {
+        for( size_t i = 0; i < width; i++ ) {
+            dst[ i ] = n[ 0 ] * x[ 0 ][ i ] + n[ 1 ] * x[ 1 ][ i ] + n[ 2 ] * x[ 2 ][ i ] + n[ 3 ] * x[ 3 ][ i ]
+                       - d[ 0 ] * y[ 0 ][ i ] - d[ 1 ] * y[ 1 ][ i ] - d[ 2 ] * y[ 2 ][ i ] - d[ 3 ] * y[ 3 ][ i ];
+        }
+    }
+
     void SIMD::AddVert_f_to_u8( uint8_t* dst, const float** bufs, size_t numw, size_t width ) const
     {
         size_t x;
@@ -4340,6 +4609,24 @@ namespace cvt {
         }
     }
 
+    void SIMD::pyrdownBox2x2_1f( float* dst, const float* src1, const float* src2, size_t n ) const
+    {
+        while( n-- ) {
+            *dst++ = ( src1[ 0 ] + src1[ 1 ] + src2[ 0 ] + src2[ 1 ] ) * 0.25f;
+            src1 += 2;
+            src2 += 2;
+        }
+    }
+
+    void SIMD::pyrdownBox2x2_1u8( uint8_t* dst, const uint8_t* src1, const uint8_t* src2, size_t n ) const
+    {
+        while( n-- ) {
+            *dst++ = ( uint8_t ) ( ( ( uint16_t ) src1[ 0 ] + ( uint16_t ) src1[ 1 ] + ( uint16_t ) src2[ 0 ] + ( uint16_t ) src2[ 1 ] + 2 ) >> 2 );
+            src1 += 2;
+            src2 += 2;
+        }
+    }
+
     void SIMD::warpLinePerspectiveBilinear1f( float* dst, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* point, const float* direction, const size_t n ) const
     {
         const uint8_t* src = ( const uint8_t* ) _src;
@@ -4706,6 +4993,329 @@ namespace cvt {
 
     }
 
+    void SIMD::remapBilinear1f( float* dst, const int16_t* xy, const uint16_t* frac, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fill, size_t n ) const
+    {
+        const uint8_t* src = ( const uint8_t* ) _src;
+        int endx = ( ( int ) srcWidth ) - 1;
+        int endy = ( ( int ) srcHeight ) - 1;
+
+        while( n-- ) {
+            int lx = *xy++;
+            int ly = *xy++;
+            float alpha1 = ( float ) ( *frac & 0x1f ) * ( 1.0f / 32.0f );
+            float alpha2 = ( float ) ( ( *frac++ >> 5 ) & 0x1f ) * ( 1.0f / 32.0f );
+            float a, b, c, d;
+
+            if( lx >= 0 && lx < endx && ly >= 0 && ly < endy ) {
+                const float* ptr = ( const float* ) ( src + srcStride * ly + sizeof( float ) * lx );
+                a = *ptr;
+                b = *( ptr + 1 );
+                ptr = ( const float* ) ( ( ( const uint8_t* ) ptr ) + srcStride );
+                c = *ptr;
+                d = *( ptr + 1 );
+            } else if( lx >= -1 && lx < ( int ) srcWidth && ly >= -1 && ly < ( int ) srcHeight ) {
+#define VAL( fx, fy ) ( ( fx ) >= 0 && ( fx ) < ( int ) srcWidth && ( fy ) >= 0 && ( fy ) < ( int ) srcHeight ) ? *( ( const float* ) ( src + srcStride * ( fy ) + sizeof( float ) * ( fx ) ) ) : fill
+                a = VAL( lx, ly );
+                b = VAL( lx + 1, ly );
+                c = VAL( lx, ly + 1 );
+                d = VAL( lx + 1, ly + 1 );
+#undef VAL
+            } else {
+                *dst++ = fill;
+                continue;
+            }
+            float v1 = a + ( b - a ) * alpha1;
+            float v2 = c + ( d - c ) * alpha1;
+            *dst++ = v1 + ( v2 - v1 ) * alpha2;
+        }
+    }
+
+    void SIMD::remapBilinear4f( float* dst, const int16_t* xy, const uint16_t* frac, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* fill, size_t n ) const
+    {
+        const uint8_t* src = ( const uint8_t* ) _src;
+
+        while( n-- ) {
+            int lx = *xy++;
+            int ly = *xy++;
+            float alpha1 = ( float ) ( *frac & 0x1f ) * ( 1.0f / 32.0f );
+            float alpha2 = ( float ) ( ( *frac++ >> 5 ) & 0x1f ) * ( 1.0f / 32.0f );
+
+            if( lx >= -1 && lx < ( int ) srcWidth && ly >= -1 && ly < ( int ) srcHeight ) {
+#define VAL( fx, fy ) ( ( fx ) >= 0 && ( fx ) < ( int ) srcWidth && ( fy ) >= 0 && ( fy ) < ( int ) srcHeight ) ? ( ( const float* ) ( src + srcStride * ( fy ) + sizeof( float ) * 4 * ( fx ) ) ) : fill
+                const float* a = VAL( lx, ly );
+                const float* b = VAL( lx + 1, ly );
+                const float* c = VAL( lx, ly + 1 );
+                const float* d = VAL( lx + 1, ly + 1 );
+#undef VAL
+                for( size_t i = 0; i < 4; i++ ) {
+                    float v1 = a[ i ] + ( b[ i ] - a[ i ] ) * alpha1;
+                    float v2 = c[ i ] + ( d[ i ] - c[ i ] ) * alpha1;
+                    *dst++ = v1 + ( v2 - v1 ) * alpha2;
+                }
+            } else {
+                for( size_t i = 0; i < 4; i++ )
+                    *dst++ = fill[ i ];
+            }
+        }
+    }
+
+    void SIMD::remapBilinear1u8( uint8_t* dst, const int16_t* xy, const uint16_t* frac, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint8_t fill, size_t n ) const
+    {
+        int endx = ( ( int ) srcWidth ) - 1;
+        int endy = ( ( int ) srcHeight ) - 1;
+
+        while( n-- ) {
+            int lx = *xy++;
+            int ly = *xy++;
+            int32_t ax = *frac & 0x1f;
+            int32_t ay = ( *frac++ >> 5 ) & 0x1f;
+            int32_t a, b, c, d;
+
+            if( lx >= 0 && lx < endx && ly >= 0 && ly < endy ) {
+                const uint8_t* ptr = src + srcStride * ly + lx;
+                a = *ptr;
+                b = *( ptr + 1 );
+                ptr += srcStride;
+                c = *ptr;
+                d = *( ptr + 1 );
+            } else if( lx >= -1 && lx < ( int ) srcWidth && ly >= -1 && ly < ( int ) srcHeight ) {
+#define VAL( fx, fy ) ( ( fx ) >= 0 && ( fx ) < ( int ) srcWidth && ( fy ) >= 0 && ( fy ) < ( int ) srcHeight ) ? *( src + srcStride * ( fy ) + ( fx ) ) : fill
+                a = VAL( lx, ly );
+                b = VAL( lx + 1, ly );
+                c = VAL( lx, ly + 1 );
+                d = VAL( lx + 1, ly + 1 );
+#undef VAL
+            } else {
+                *dst++ = fill;
+                continue;
+            }
+            int32_t v1 = ( a << 5 ) + ( b - a ) * ax;
+            int32_t v2 = ( c << 5 ) + ( d - c ) * ax;
+            *dst++ = ( uint8_t ) ( ( ( v1 << 5 ) + ( v2 - v1 ) * ay + 512 ) >> 10 );
+        }
+    }
+
+    void SIMD::remapBilinear4u8( uint8_t* _dst, const int16_t* xy, const uint16_t* frac, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const
+    {
+        uint32_t* dst = ( uint32_t* ) _dst;
+
+        while( n-- ) {
+            int lx = *xy++;
+            int ly = *xy++;
+            int32_t ax = *frac & 0x1f;
+            int32_t ay = ( *frac++ >> 5 ) & 0x1f;
+
+            if( lx >= -1 && lx < ( int ) srcWidth && ly >= -1 && ly < ( int ) srcHeight ) {
+#define VAL( fx, fy ) ( ( fx ) >= 0 && ( fx ) < ( int ) srcWidth && ( fy ) >= 0 && ( fy ) < ( int ) srcHeight ) ? *( ( const uint32_t* ) ( src + srcStride * ( fy ) + sizeof( uint32_t ) * ( fx ) ) ) : fill
+                uint32_t a = VAL( lx, ly );
+                uint32_t b = VAL( lx + 1, ly );
+                uint32_t c = VAL( lx, ly + 1 );
+                uint32_t d = VAL( lx + 1, ly + 1 );
+#undef VAL
+                uint32_t out = 0;
+                for( size_t shift = 0; shift < 32; shift += 8 ) {
+                    int32_t ca = ( a >> shift ) & 0xff;
+                    int32_t cb = ( b >> shift ) & 0xff;
+                    int32_t cc = ( c >> shift ) & 0xff;
+                    int32_t cd = ( d >> shift ) & 0xff;
+                    int32_t v1 = ( ca << 5 ) + ( cb - ca ) * ax;
+                    int32_t v2 = ( cc << 5 ) + ( cd - cc ) * ax;
+                    out |= ( uint32_t ) ( ( ( v1 << 5 ) + ( v2 - v1 ) * ay + 512 ) >> 10 ) << shift;
+                }
+                *dst++ = out;
+            } else
+                *dst++ = fill;
+        }
+    }
+
+    void SIMD::warpProjectiveCoords_f( float* coords, const float* point, const float* delta, size_t n ) const
+    {
+        for( size_t i = 0; i < n; i++ ) {
+            float fi = ( float ) i;
+            float px = point[ 0 ] + fi * delta[ 0 ];
+            float py = point[ 1 ] + fi * delta[ 1 ];
+            float inv = 1.0f / ( point[ 2 ] + fi * delta[ 2 ] );
+            *coords++ = px * inv;
+            *coords++ = py * inv;
+        }
+    }
+
+    /* Catmull-Rom weights of the taps -1, 0, 1, 2 for the fraction t */
+    static inline void _cubicWeights( float* w, float t )
+    {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        w[ 0 ] = ( -0.5f * t3 + t2 ) - 0.5f * t;
+        w[ 1 ] = ( 1.5f * t3 - 2.5f * t2 ) + 1.0f;
+        w[ 2 ] = ( -1.5f * t3 + 2.0f * t2 ) + 0.5f * t;
+        w[ 3 ] = 0.5f * t3 - 0.5f * t2;
+    }
+
+    /* bicubic sample of the 4x4 taps t ( row-major ), the columns are filtered first as in the SIMD versions */
+    static inline float _bicubic( const float* t, const float* wx, const float* wy )
+    {
+        float l[ 4 ];
+        for( size_t k = 0; k < 4; k++ )
+            l[ k ] = ( ( t[ k ] * wy[ 0 ] + t[ 4 + k ] * wy[ 1 ] ) + t[ 8 + k ] * wy[ 2 ] ) + t[ 12 + k ] * wy[ 3 ];
+        return ( l[ 0 ] * wx[ 0 ] + l[ 2 ] * wx[ 2 ] ) + ( l[ 1 ] * wx[ 1 ] + l[ 3 ] * wx[ 3 ] );
+    }
+
+    static inline uint8_t _bicubicToU8( float v )
+    {
+        v = v > 0.0f ? v : 0.0f;
+        v = v < 255.0f ? v : 255.0f;
+        return ( uint8_t ) ( v + 0.5f );
+    }
+
+    void SIMD::warpBicubic1f( float* dst, const float* coords, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fill, size_t n ) const
+    {
+        const uint8_t* src = ( const uint8_t* ) _src;
+        float t[ 16 ], wx[ 4 ], wy[ 4 ];
+
+        while( n-- ) {
+            float fx = *coords++;
+            float fy = *coords++;
+            if( !( fx >= -1.0f && fx < ( float ) srcWidth && fy >= -1.0f && fy < ( float ) srcHeight ) ) {
+                *dst++ = fill;
+                continue;
+            }
+
+            int lx = _floor( fx );
+            int ly = _floor( fy );
+            _cubicWeights( wx, fx - ( float ) lx );
+            _cubicWeights( wy, fy - ( float ) ly );
+            for( int r = 0; r < 4; r++ ) {
+                int y = ly - 1 + r;
+                for( int c = 0; c < 4; c++ ) {
+                    int x = lx - 1 + c;
+                    t[ 4 * r + c ] = ( x >= 0 && x < ( int ) srcWidth && y >= 0 && y < ( int ) srcHeight ) ?
+                                     *( ( const float* ) ( src + srcStride * y ) + x ) : fill;
+                }
+            }
+            *dst++ = _bicubic( t, wx, wy );
+        }
+    }
+
+    void SIMD::warpBicubic4f( float* dst, const float* coords, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* fill, size_t n ) const
+    {
+        const uint8_t* src = ( const uint8_t* ) _src;
+        float wx[ 4 ], wy[ 4 ];
+
+        while( n-- ) {
+            float fx = *coords++;
+            float fy = *coords++;
+            if( !( fx >= -1.0f && fx < ( float ) srcWidth && fy >= -1.0f && fy < ( float ) srcHeight ) ) {
+                for( size_t ch = 0; ch < 4; ch++ )
+                    *dst++ = fill[ ch ];
+                continue;
+            }
+
+            int lx = _floor( fx );
+            int ly = _floor( fy );
+            _cubicWeights( wx, fx - ( float ) lx );
+            _cubicWeights( wy, fy - ( float ) ly );
+            for( size_t ch = 0; ch < 4; ch++ ) {
+                float v[ 4 ];
+                for( int r = 0; r < 4; r++ ) {
+                    int y = ly - 1 + r;
+                    float p[ 4 ];
+                    for( int c = 0; c < 4; c++ ) {
+                        int x = lx - 1 + c;
+                        p[ c ] = ( x >= 0 && x < ( int ) srcWidth && y >= 0 && y < ( int ) srcHeight ) ?
+                                 *( ( const float* ) ( src + srcStride * y ) + 4 * x + ch ) : fill[ ch ];
+                    }
+                    v[ r ] = ( ( p[ 0 ] * wx[ 0 ] + p[ 1 ] * wx[ 1 ] ) + p[ 2 ] * wx[ 2 ] ) + p[ 3 ] * wx[ 3 ];
+                }
+                *dst++ = ( ( v[ 0 ] * wy[ 0 ] + v[ 1 ] * wy[ 1 ] ) + v[ 2 ] * wy[ 2 ] ) + v[ 3 ] * wy[ 3 ];
+            }
+        }
+    }
+
+    void SIMD::warpBicubic1u8( uint8_t* dst, const float* coords, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint8_t fill, size_t n ) const
+    {
+        float t[ 16 ], wx[ 4 ], wy[ 4 ];
+
+        while( n-- ) {
+            float fx = *coords++;
+            float fy = *coords++;
+            if( !( fx >= -1.0f && fx < ( float ) srcWidth && fy >= -1.0f && fy < ( float ) srcHeight ) ) {
+                *dst++ = fill;
+                continue;
+            }
+
+            int lx = _floor( fx );
+            int ly = _floor( fy );
+            _cubicWeights( wx, fx - ( float ) lx );
+            _cubicWeights( wy, fy - ( float ) ly );
+            for( int r = 0; r < 4; r++ ) {
+                int y = ly - 1 + r;
+                for( int c = 0; c < 4; c++ ) {
+                    int x = lx - 1 + c;
+                    t[ 4 * r + c ] = ( x >= 0 && x < ( int ) srcWidth && y >= 0 && y < ( int ) srcHeight ) ?
+                                     ( float ) src[ srcStride * y + x ] : ( float ) fill;
+                }
+            }
+            *dst++ = _bicubicToU8( _bicubic( t, wx, wy ) );
+        }
+    }
+
+    void SIMD::warpBicubic4u8( uint8_t* dst, const float* coords, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const
+    {
+        float wx[ 4 ], wy[ 4 ];
+
+        while( n-- ) {
+            float fx = *coords++;
+            float fy = *coords++;
+            if( !( fx >= -1.0f && fx < ( float ) srcWidth && fy >= -1.0f && fy < ( float ) srcHeight ) ) {
+                *( ( uint32_t* ) dst ) = fill;
+                dst += 4;
+                continue;
+            }
+
+            int lx = _floor( fx );
+            int ly = _floor( fy );
+            _cubicWeights( wx, fx - ( float ) lx );
+            _cubicWeights( wy, fy - ( float ) ly );
+            for( size_t ch = 0; ch < 4; ch++ ) {
+                float v[ 4 ];
+                for( int r = 0; r < 4; r++ ) {
+                    int y = ly - 1 + r;
+                    float p[ 4 ];
+                    for( int c = 0; c < 4; c++ ) {
+                        int x = lx - 1 + c;
+                        p[ c ] = ( x >= 0 && x < ( int ) srcWidth && y >= 0 && y < ( int ) srcHeight ) ?
+                                 ( float ) src[ srcStride * y + 4 * x + ch ] : ( float ) ( ( fill >> ( 8 * ch ) ) & 0xff );
+                    }
+                    v[ r ] = ( ( p[ 0 ] * wx[ 0 ] + p[ 1 ] * wx[ 1 ] ) + p[ 2 ] * wx[ 2 ] ) + p[ 3 ] * wx[ 3 ];
+                }
+                *dst++ = _bicubicToU8( ( ( v[ 0 ] * wy[ 0 ] + v[ 1 ] * wy[ 1 ] ) + v[ 2 ] * wy[ 2 ] ) + v[ 3 ] * wy[ 3 ] );
+            }
+        }
+    }
+
+    float SIMD::costTruncatedL1Line8f( float& wsum, const float* ref, const float* weights, const float* src, size_t srcWidth,
+                                       float x, float dx, const float* truncation, const float* scale, size_t n ) const
+    {
+        float cost = 0.0f;
+
+        for( size_t i = 0; i < n; i++, x += dx, ref += 8 ) {
+            if( x < 0.0f || x >= ( float ) srcWidth )
+                continue;
+            size_t x0 = ( size_t ) x;
+            size_t x1 = Math::min( x0 + 1, srcWidth - 1 );
+            float a = x - ( float ) x0;
+            const float* p0 = src + 8 * x0;
+            const float* p1 = src + 8 * x1;
+
+            float c = 0.0f;
+            for( size_t k = 0; k < 8; k++ )
+                c += scale[ k ] * Math::min( Math::abs( ref[ k ] - Math::mix( p0[ k ], p1[ k ], a ) ), truncation[ k ] );
+            cost += weights[ i ] * c;
+            wsum += weights[ i ];
+        }
+        return cost;
+    }
+
 	void SIMD::harrisScore1f( float* dst, const float* boxdx2, const float* boxdy2, const float* boxdxdy, float k, size_t width ) const
 	{
 		size_t x;
@@ -4720,6 +5330,29 @@ namespace cvt {
 	}
 
 
+	void SIMD::shiTomasiScore1f( float* dst, const float* boxdx2, const float* boxdy2, const float* boxdxdy, size_t width ) const
+	{
+		while( width-- ) {
+			float a, b, c;
+			a = *boxdx2++;
+			b = *boxdy2++;
+			c = *boxdxdy++;
+			float h = 0.5f * ( a - b );
+			*dst++ = 0.5f * ( a + b ) - Math::sqrt( h * h + c * c );
+		}
+	}
+
+	void SIMD::cornerTensor1f( float* dx2, float* dy2, float* dxdy, const float* prev, const float* cur, const float* next, size_t width ) const
+	{
+		for( size_t x = 0; x < width; x++ ) {
+			float dx = cur[ x + 1 ] - cur[ x - 1 ];
+			float dy = next[ x ] - prev[ x ];
+			dx2[ x ] = dx * dx;
+			dy2[ x ] = dy * dy;
+			dxdy[ x ] = dx * dy;
+		}
+	}
+
     float SIMD::harrisResponse1u8( const uint8_t* _src, size_t srcStride, size_t w, size_t h, const float k ) const
     {
         const uint8_t* src = _src - ( h - 1 ) * srcStride - ( w - 1 );
@@ -5234,6 +5867,71 @@ namespace cvt {
         *dst++ = v;
     }
 
+    void SIMD::debayer_LINEARu8_RGBAu8( uint32_t* dst, const uint8_t** src, size_t n, size_t phase, bool redrow ) const
+    {
+        const uint8_t* s0 = src[ 0 ];
+        const uint8_t* s1 = src[ 1 ];
+        const uint8_t* s2 = src[ 2 ];
+        const size_t ashift = redrow ? 0 : 16;
+        const size_t oshift = redrow ? 16 : 0;
+        uint32_t a, g, o, vert, horz;
+
+        for( size_t x = 0; x < n; x++ ) {
+            vert = ( s0[ 0 ] + s2[ 0 ] + 1 ) >> 1;
+            horz = ( s1[ -1 ] + s1[ 1 ] + 1 ) >> 1;
+            if( ( x & 1 ) == phase ) {
+                a = s1[ 0 ];
+                g = ( vert + horz + 1 ) >> 1;
+                o = ( ( ( s0[ -1 ] + s2[ 1 ] + 1 ) >> 1 ) + ( ( s0[ 1 ] + s2[ -1 ] + 1 ) >> 1 ) + 1 ) >> 1;
+            } else {
+                a = horz;
+                g = s1[ 0 ];
+                o = vert;
+            }
+            *dst++ = 0xff000000 | ( a << ashift ) | ( g << 8 ) | ( o << oshift );
+            s0++;
+            s1++;
+            s2++;
+        }
+    }
+
+    void SIMD::debayer_MHCu8_RGBAu8( uint32_t* dst, const uint8_t** src, size_t n, size_t phase, bool redrow ) const
+    {
+        const uint8_t* r0 = src[ 0 ];
+        const uint8_t* r1 = src[ 1 ];
+        const uint8_t* r2 = src[ 2 ];
+        const uint8_t* r3 = src[ 3 ];
+        const uint8_t* r4 = src[ 4 ];
+        const size_t ashift = redrow ? 0 : 16;
+        const size_t oshift = redrow ? 16 : 0;
+        int c, cross, ns2, we2, diag;
+        uint32_t a, g, o;
+
+        /* Malvar-He-Cutler gradient corrected interpolation, weights scaled by 16 */
+        for( size_t x = 0; x < n; x++ ) {
+            c    = r2[ 0 ];
+            ns2  = r0[ 0 ] + r4[ 0 ];
+            we2  = r2[ -2 ] + r2[ 2 ];
+            diag = r1[ -1 ] + r1[ 1 ] + r3[ -1 ] + r3[ 1 ];
+            if( ( x & 1 ) == phase ) {
+                cross = r1[ 0 ] + r3[ 0 ] + r2[ -1 ] + r2[ 1 ];
+                a = c;
+                g = Math::clamp( ( 8 * c + 4 * cross - 2 * ( ns2 + we2 ) + 8 ) >> 4, 0, 255 );
+                o = Math::clamp( ( 12 * c + 4 * diag - 3 * ( ns2 + we2 ) + 8 ) >> 4, 0, 255 );
+            } else {
+                a = Math::clamp( ( 10 * c + 8 * ( r2[ -1 ] + r2[ 1 ] ) - 2 * we2 - 2 * diag + ns2 + 8 ) >> 4, 0, 255 );
+                g = c;
+                o = Math::clamp( ( 10 * c + 8 * ( r1[ 0 ] + r3[ 0 ] ) - 2 * ns2 - 2 * diag + we2 + 8 ) >> 4, 0, 255 );
+            }
+            *dst++ = 0xff000000 | ( a << ashift ) | ( g << 8 ) | ( o << oshift );
+            r0++;
+            r1++;
+            r2++;
+            r3++;
+            r4++;
+        }
+    }
+
     void SIMD::debayer_EVEN_RGGBu8_GRAYu8( uint32_t* dst, const uint32_t* src1, const uint32_t* src2, const uint32_t* src3, const size_t n ) const
     {
         uint32_t v, t;
@@ -5795,6 +6493,14 @@ namespace cvt {
         return d;
     }
 
+    void SIMD::hammingDistance1N( uint32_t* dst, const uint8_t* query, const uint8_t* base, size_t len, size_t n ) const
+    {
+        while( n-- ){
+            *dst++ = hammingDistance( query, base, len );
+            base += len;
+        }
+    }
+
     /*
     {
         size_t d = 0;
@@ -6028,6 +6734,17 @@ namespace cvt {
 
 	}
 
+	void SIMD::prefixSumRow_f_to_f( float* dst, const float* src, const float* prev, size_t width, size_t channels ) const
+	{
+		for( size_t c = 0; c < channels; c++ ) {
+			float sum = 0.0f;
+			for( size_t i = c, end = width * channels; i < end; i += channels ) {
+				sum += src[ i ];
+				dst[ i ] = prev ? sum + prev[ i ] : sum;
+			}
+		}
+	}
+
 	void SIMD::boxFilterPrefixSum1_f_to_u8( uint8_t* dst, size_t dststride, const float* src, size_t srcstride, size_t width, size_t height, size_t boxwidth, size_t boxheight ) const
 	{
 		// FIXME
@@ -6144,6 +6861,234 @@ namespace cvt {
 		}
 	}
 
+	static inline uint8_t _cannyDirection( float dx, float dy )
+	{
+		float ax = Math::abs( dx );
+		float ay = Math::abs( dy );
+		if( ay >= 2.4142f * ax )
+			return 1;
+		if( ay >= 0.41421f * ax )
+			return ( ( dx > 0 ) ^ ( dy > 0 ) ) ? 3 : 2;
+		return 0;
+	}
+
+	void SIMD::cannyGradient1_f( float* mag, uint8_t* dir, const float* prev, const float* cur, const float* next, size_t width ) const
+	{
+		for( size_t x = 0; x < width; x++ ) {
+			size_t xl = x > 0 ? x - 1 : 0;
+			size_t xr = x + 1 < width ? x + 1 : width - 1;
+			float dx = ( ( prev[ xl ] + next[ xl ] ) + ( cur[ xl ] + cur[ xl ] ) ) - ( ( prev[ xr ] + next[ xr ] ) + ( cur[ xr ] + cur[ xr ] ) );
+			float dy = ( ( prev[ xl ] + prev[ xr ] ) + ( prev[ x ] + prev[ x ] ) ) - ( ( next[ xl ] + next[ xr ] ) + ( next[ x ] + next[ x ] ) );
+			dx *= 0.25f;
+			dy *= 0.25f;
+			mag[ x ] = Math::sqrt( dx * dx + dy * dy );
+			dir[ x ] = _cannyDirection( dx, dy );
+		}
+	}
+
+	void SIMD::cannyGradient1_f( float* mag, uint8_t* dir, const float* dx, const float* dy, size_t width ) const
+	{
+		while( width-- ) {
+			*mag++ = Math::sqrt( *dx * *dx + *dy * *dy );
+			*dir++ = _cannyDirection( *dx++, *dy++ );
+		}
+	}
+
+	void SIMD::cannyNonMaxima1_f( uint8_t* dst, const float* mprev, const float* mcur, const float* mnext, const uint8_t* dir, size_t width, float low, float high ) const
+	{
+		if( !width )
+			return;
+		dst[ 0 ] = 0;
+		for( size_t x = 1; x + 1 < width; x++ ) {
+			float m = mcur[ x ];
+			float n1, n2;
+			switch( dir[ x ] ) {
+				case 0:  n1 = mcur[ x - 1 ];  n2 = mcur[ x + 1 ];  break;
+				case 1:  n1 = mprev[ x ];     n2 = mnext[ x ];     break;
+				case 2:  n1 = mprev[ x - 1 ]; n2 = mnext[ x + 1 ]; break;
+				default: n1 = mprev[ x + 1 ]; n2 = mnext[ x - 1 ]; break;
+			}
+			if( m >= low && n1 <= m && n2 <= m )
+				dst[ x ] = m >= high ? 2 : 1;
+			else
+				dst[ x ] = 0;
+		}
+		dst[ width - 1 ] = 0;
+	}
+
+	void SIMD::pdtvDual1_f( float* px, float* py, const float* u, const float* unext, const float* weight, size_t width, float sigma, float epsilon ) const
+	{
+		for( size_t x = 0; x < width; x++ ) {
+			float g = weight ? weight[ x ] : 1.0f;
+			float dx = x + 1 < width ? u[ x + 1 ] - u[ x ] : 0.0f;
+			float dy = unext ? unext[ x ] - u[ x ] : 0.0f;
+			float s = g / Math::max( g + sigma * epsilon, 1e-20f );
+			float qx = ( px[ x ] + sigma * dx ) * s;
+			float qy = ( py[ x ] + sigma * dy ) * s;
+			float r = g / Math::max( Math::max( g, Math::sqrt( qx * qx + qy * qy ) ), 1e-20f );
+			px[ x ] = qx * r;
+			py[ x ] = qy * r;
+		}
+	}
+
+	void SIMD::pdtvPrimal1_f( float* u, float* ubar, const float* px, const float* py, const float* pyprev, const float* f, const float* lambda, float lambdac, size_t width, float tau, float theta, bool l1 ) const
+	{
+		for( size_t x = 0; x < width; x++ ) {
+			float div = ( px[ x ] - ( x > 0 ? px[ x - 1 ] : 0.0f ) ) + ( py[ x ] - ( pyprev ? pyprev[ x ] : 0.0f ) );
+			float v = u[ x ] + tau * div;
+			float t = tau * ( lambda ? lambda[ x ] : lambdac );
+			float un;
+			if( l1 ) {
+				float d = v - f[ x ];
+				un = f[ x ] + ( d - Math::min( Math::max( d, -t ), t ) );
+			} else {
+				un = ( v + t * f[ x ] ) / ( 1.0f + t );
+			}
+			ubar[ x ] = un + theta * ( un - u[ x ] );
+			u[ x ] = un;
+		}
+	}
+
+	void SIMD::histogramBSplineWeights_f( int32_t* idx, float* weights, float* dweights, const float* src, size_t n, size_t bins ) const
+	{
+		const float scale = ( float ) ( bins - 3 );
+		const float sixth = 1.0f / 6.0f;
+
+		while( n-- ) {
+			float v = *src++;
+			v = v > 0.0f ? v : 0.0f;
+			v = v < 1.0f ? v : 1.0f;
+			float t = v * scale + 1.0f;
+			float fi = ( float ) ( int32_t ) t;
+			fi = fi < scale ? fi : scale;
+			float f = t - fi;
+			float f2 = f * f;
+			float f3 = f2 * f;
+			float g = 1.0f - f;
+			float g2 = g * g;
+
+			*idx++ = ( int32_t ) fi - 1;
+			weights[ 0 ] = ( g2 * g ) * sixth;
+			weights[ 1 ] = ( ( 4.0f - 6.0f * f2 ) + 3.0f * f3 ) * sixth;
+			weights[ 2 ] = ( ( ( 1.0f + 3.0f * f ) + 3.0f * f2 ) - 3.0f * f3 ) * sixth;
+			weights[ 3 ] = f3 * sixth;
+			weights += 4;
+			if( dweights ) {
+				dweights[ 0 ] = -0.5f * g2;
+				dweights[ 1 ] = 1.5f * f2 - 2.0f * f;
+				dweights[ 2 ] = ( 0.5f + f ) - 1.5f * f2;
+				dweights[ 3 ] = 0.5f * f2;
+				dweights += 4;
+			}
+		}
+	}
+
+	void SIMD::jointHistogramBSpline_f( float* hist, size_t bins, const int32_t* ia, const float* wa, const int32_t* ib, const float* wb, size_t n ) const
+	{
+		while( n-- ) {
+			float* h = hist + *ia++ * bins + *ib++;
+			for( int k = 0; k < 4; k++ ) {
+				for( int l = 0; l < 4; l++ )
+					h[ l ] += wa[ k ] * wb[ l ];
+				h += bins;
+			}
+			wa += 4;
+			wb += 4;
+		}
+	}
+
+	float SIMD::kltSystem_f( float* jsum, float* residual, const float* warped, const float* patch, const float* jac, size_t nparams, size_t n ) const
+	{
+		/* four partial sums, combined pairwise, the same order as the vectorized versions */
+		const size_t n4 = n & ~( ( size_t ) 0x3 );
+		float s[ 4 ];
+		size_t i;
+
+		s[ 0 ] = s[ 1 ] = s[ 2 ] = s[ 3 ] = 0.0f;
+		for( i = 0; i < n4; i++ ) {
+			float r = warped[ i ] - patch[ i ];
+			residual[ i ] = r;
+			s[ i & 0x3 ] += r * r;
+		}
+		float error = ( s[ 0 ] + s[ 1 ] ) + ( s[ 2 ] + s[ 3 ] );
+		for( ; i < n; i++ ) {
+			float r = warped[ i ] - patch[ i ];
+			residual[ i ] = r;
+			error += r * r;
+		}
+
+		for( size_t k = 0; k < nparams; k++ ) {
+			s[ 0 ] = s[ 1 ] = s[ 2 ] = s[ 3 ] = 0.0f;
+			for( i = 0; i < n4; i++ )
+				s[ i & 0x3 ] += jac[ i ] * residual[ i ];
+			float sum = ( s[ 0 ] + s[ 1 ] ) + ( s[ 2 ] + s[ 3 ] );
+			for( ; i < n; i++ )
+				sum += jac[ i ] * residual[ i ];
+			jsum[ k ] = sum;
+			jac += n;
+		}
+		return error;
+	}
+
+	void SIMD::astStrength_u8( uint8_t* dst, const uint8_t* src, const int* offsets, size_t circle, size_t arc, uint8_t threshold, size_t n ) const
+	{
+		int bright[ 32 ], dark[ 32 ];
+
+		while( n-- ) {
+			int c = *src;
+			for( size_t j = 0; j < circle; j++ ) {
+				int v = src[ offsets[ j ] ];
+				bright[ j ] = bright[ j + circle ] = Math::max( v - c, 0 );
+				dark[ j ] = dark[ j + circle ] = Math::max( c - v, 0 );
+			}
+
+			int strength = 0;
+			for( size_t k = 0; k < circle; k++ ) {
+				int b = 255, d = 255;
+				for( size_t j = k; j < k + arc; j++ ) {
+					b = Math::min( b, bright[ j ] );
+					d = Math::min( d, dark[ j ] );
+				}
+				strength = Math::max( strength, Math::max( b, d ) );
+			}
+			*dst++ = strength > threshold ? strength : 0;
+			src++;
+		}
+	}
+
+	void SIMD::boxSum_f( float* dst, const float* src, const int* offsets, size_t n ) const
+	{
+		while( n-- ) {
+			*dst++ = src[ offsets[ 0 ] ] - src[ offsets[ 1 ] ] - src[ offsets[ 2 ] ] + src[ offsets[ 3 ] ];
+			offsets += 4;
+		}
+	}
+
+	void SIMD::boxTest_f( uint8_t* dst, const float* src, const int* offsets, size_t n ) const
+	{
+		for( size_t i = n >> 3; i--; ) {
+			uint8_t bits = 0;
+			for( size_t t = 0; t < 8; t++ ) {
+				float a = src[ offsets[ 0 ] ] - src[ offsets[ 1 ] ] - src[ offsets[ 2 ] ] + src[ offsets[ 3 ] ];
+				float b = src[ offsets[ 4 ] ] - src[ offsets[ 5 ] ] - src[ offsets[ 6 ] ] + src[ offsets[ 7 ] ];
+				bits |= ( a < b ) << t;
+				offsets += 8;
+			}
+			*dst++ = bits;
+		}
+	}
+
+	void SIMD::fernIndex_u8( uint32_t* dst, const uint8_t* src, const int* points, size_t n, const int* tests, size_t numTests ) const
+	{
+		while( n-- ) {
+			const uint8_t* p = src + *points++;
+			uint32_t idx = 0;
+			for( size_t t = 0; t < numTests; t++ )
+				idx = ( idx << 1 ) | ( p[ tests[ 2 * t ] ] < p[ tests[ 2 * t + 1 ] ] );
+			*dst++ = idx;
+		}
+	}
+
     void SIMD::sumPoints( Vector2f& dst, const Vector2f* src, size_t n ) const
     {
         dst.setZero();
@@ -6271,6 +7216,266 @@ namespace cvt {
         }
     }
 
+    void SIMD::reprojectionErrorSqr( float* dst, const float* P, const float* x, const float* y, const float* z,
+                                     const float* u, const float* v, size_t n ) const
+    {
+        for( size_t i = 0; i < n; i++ ){
+            float pz = P[ 8 ] * x[ i ] + P[ 9 ] * y[ i ] + P[ 10 ] * z[ i ] + P[ 11 ];
+            if( pz <= 0.0f ){
+                dst[ i ] = FLT_MAX;
+                continue;
+            }
+            float iz = 1.0f / pz;
+            float dx = ( P[ 0 ] * x[ i ] + P[ 1 ] * y[ i ] + P[ 2 ] * z[ i ] + P[ 3 ] ) * iz - u[ i ];
+            float dy = ( P[ 4 ] * x[ i ] + P[ 5 ] * y[ i ] + P[ 6 ] * z[ i ] + P[ 7 ] ) * iz - v[ i ];
+            dst[ i ] = dx * dx + dy * dy;
+        }
+    }
+
+    /* cube root of a >= 0: the exponent divided by three as start, then Newton steps */
+    static inline double _p3pCbrt( double a )
+    {
+        uint64_t bits;
+        memcpy( &bits, &a, sizeof( bits ) );
+        bits = ( uint64_t ) ( ( uint32_t ) ( bits >> 32 ) / 3 + 715094163 ) << 32;
+        double y;
+        memcpy( &y, &bits, sizeof( y ) );
+        for( int i = 0; i < 4; i++ )
+            y = ( 2.0 * y + a / ( y * y ) ) / 3.0;
+        return y;
+    }
+
+    /* real root of t^3 + a2 t^2 + a1 t + a0 = 0, the largest one if there are three */
+    static inline double _p3pCubicRoot( double a2, double a1, double a0 )
+    {
+        double p = a1 - a2 * a2 / 3.0;
+        double q = 2.0 * a2 * a2 * a2 / 27.0 - a2 * a1 / 3.0 + a0;
+        double disc = 0.25 * q * q + p * p * p / 27.0;
+        double t;
+        if( disc > 0.0 ) {
+            double s = Math::sqrt( disc );
+            double u = -0.5 * q + s;
+            double v = -0.5 * q - s;
+            double cu = _p3pCbrt( Math::abs( u ) );
+            double cv = _p3pCbrt( Math::abs( v ) );
+            t = ( u < 0.0 ? -cu : cu ) + ( v < 0.0 ? -cv : cv );
+        } else {
+            /* 2 r cos( acos( c ) / 3 ) is 2 r x with x the largest root of 4 x^3 - 3 x = c */
+            double r = Math::sqrt( -p / 3.0 );
+            double c = r > 0.0 ? -0.5 * q / ( r * r * r ) : 0.0;
+            c = c > -1.0 ? c : -1.0;
+            c = c < 1.0 ? c : 1.0;
+            double x = 0.5 + 0.5 * Math::sqrt( ( c + 1.0 ) / 1.5 );
+            for( int i = 0; i < 4; i++ ) {
+                double f  = ( 4.0 * x * x - 3.0 ) * x - c;
+                double df = 12.0 * x * x - 3.0;
+                if( df != 0.0 )
+                    x -= f / df;
+            }
+            t = 2.0 * r * x;
+        }
+        t -= a2 / 3.0;
+
+        /* polish */
+        for( int i = 0; i < 2; i++ ) {
+            double f  = ( ( t + a2 ) * t + a1 ) * t + a0;
+            double df = ( 3.0 * t + 2.0 * a2 ) * t + a1;
+            if( df != 0.0 )
+                t -= f / df;
+        }
+        return t;
+    }
+
+    /* real roots of the quadratic t^2 + b t + c, complex pairs yield their real part */
+    static inline void _p3pQuadraticRoots( double* roots, double b, double c )
+    {
+        double disc = 0.25 * b * b - c;
+        double s = disc > 0.0 ? Math::sqrt( disc ) : 0.0;
+        roots[ 0 ] = -0.5 * b + s;
+        roots[ 1 ] = -0.5 * b - s;
+    }
+
+    /**
+     *  roots of a x^4 + b x^3 + c x^2 + d x + e using Ferrari's method, polished with Newton steps,
+     *  valid[ k ] marks the roots with a small residual
+     */
+    static inline void _p3pQuarticRoots( double* roots, bool* valid, double a, double b, double c, double d, double e )
+    {
+        double B = b / a, C = c / a, D = d / a, E = e / a;
+        double B2 = B * B;
+        double p = C - 0.375 * B2;
+        double q = D - 0.5 * B * C + 0.125 * B2 * B;
+        double r = E - 0.25 * B * D + 0.0625 * B2 * C - 3.0 / 256.0 * B2 * B2;
+
+        double y[ 4 ];
+        double m = _p3pCubicRoot( p, 0.25 * p * p - r, -0.125 * q * q );
+        if( m > 1e-14 ) {
+            double s = Math::sqrt( 2.0 * m );
+            _p3pQuadraticRoots( y, s, 0.5 * p + m - 0.5 * q / s );
+            _p3pQuadraticRoots( y + 2, -s, 0.5 * p + m + 0.5 * q / s );
+        } else {
+            /* biquadratic */
+            double z[ 2 ];
+            _p3pQuadraticRoots( z, p, r );
+            y[ 0 ] = Math::sqrt( z[ 0 ] > 0.0 ? z[ 0 ] : 0.0 );
+            y[ 1 ] = -y[ 0 ];
+            y[ 2 ] = Math::sqrt( z[ 1 ] > 0.0 ? z[ 1 ] : 0.0 );
+            y[ 3 ] = -y[ 2 ];
+        }
+
+        double scale = 1.0 + Math::abs( B ) + Math::abs( C ) + Math::abs( D ) + Math::abs( E );
+        for( int i = 0; i < 4; i++ ) {
+            double x = y[ i ] - 0.25 * B;
+            for( int k = 0; k < 3; k++ ) {
+                double f = ( ( ( x + B ) * x + C ) * x + D ) * x + E;
+                double df = ( ( 4.0 * x + 3.0 * B ) * x + 2.0 * C ) * x + D;
+                if( df != 0.0 )
+                    x -= f / df;
+            }
+            double f = ( ( ( x + B ) * x + C ) * x + D ) * x + E;
+            roots[ i ] = x;
+            valid[ i ] = a != 0.0 && Math::abs( f ) < 1e-8 * scale;
+        }
+    }
+
+    void SIMD::p3p_d( double* poses, uint8_t* valid, const double* in, size_t n ) const
+    {
+        for( size_t i = 0; i < n; i++ ){
+            double f1x = in[ i ],          f1y = in[ n + i ],      f1z = in[ 2 * n + i ];
+            double f2x = in[ 3 * n + i ],  f2y = in[ 4 * n + i ],  f2z = in[ 5 * n + i ];
+            double f3x = in[ 6 * n + i ],  f3y = in[ 7 * n + i ],  f3z = in[ 8 * n + i ];
+            double P1x = in[ 9 * n + i ],  P1y = in[ 10 * n + i ], P1z = in[ 11 * n + i ];
+            double P2x = in[ 12 * n + i ], P2y = in[ 13 * n + i ], P2z = in[ 14 * n + i ];
+            double P3x = in[ 15 * n + i ], P3y = in[ 16 * n + i ], P3z = in[ 17 * n + i ];
+
+            /* theta in [ 0, pi ] requires the third bearing in the lower half space of the intermediate
+               frame, otherwise the first two correspondences are swapped */
+            double cx = f1y * f2z - f1z * f2y;
+            double cy = f1z * f2x - f1x * f2z;
+            double cz = f1x * f2y - f1y * f2x;
+            bool swap = cx * f3x + cy * f3y + cz * f3z > 0.0;
+
+            double ax = swap ? f2x : f1x, ay = swap ? f2y : f1y, az = swap ? f2z : f1z;
+            double bx = swap ? f1x : f2x, by = swap ? f1y : f2y, bz = swap ? f1z : f2z;
+            double Q1x = swap ? P2x : P1x, Q1y = swap ? P2y : P1y, Q1z = swap ? P2z : P1z;
+            double Q2x = swap ? P1x : P2x, Q2y = swap ? P1y : P2y, Q2z = swap ? P1z : P2z;
+
+            /* intermediate camera frame ( rows of tr ) */
+            double e3x = ay * bz - az * by;
+            double e3y = az * bx - ax * bz;
+            double e3z = ax * by - ay * bx;
+            double e3n = Math::sqrt( e3x * e3x + e3y * e3y + e3z * e3z );
+            double ie3 = e3n > 0.0 ? 1.0 / e3n : 0.0;
+            e3x *= ie3; e3y *= ie3; e3z *= ie3;
+            double e2x = e3y * az - e3z * ay;
+            double e2y = e3z * ax - e3x * az;
+            double e2z = e3x * ay - e3y * ax;
+            double tr[ 9 ] = { ax, ay, az, e2x, e2y, e2z, e3x, e3y, e3z };
+            double t3x = ax * f3x + ay * f3y + az * f3z;
+            double t3y = e2x * f3x + e2y * f3y + e2z * f3z;
+            double t3z = e3x * f3x + e3y * f3y + e3z * f3z;
+
+            /* intermediate world frame ( rows of nw ) */
+            double dx = Q2x - Q1x, dy = Q2y - Q1y, dz = Q2z - Q1z;
+            double d = Math::sqrt( dx * dx + dy * dy + dz * dz );
+            double id = d > 0.0 ? 1.0 / d : 0.0;
+            double n1x = dx * id, n1y = dy * id, n1z = dz * id;
+            double wx = P3x - Q1x, wy = P3y - Q1y, wz = P3z - Q1z;
+            double n3x = n1y * wz - n1z * wy;
+            double n3y = n1z * wx - n1x * wz;
+            double n3z = n1x * wy - n1y * wx;
+            double n3n = Math::sqrt( n3x * n3x + n3y * n3y + n3z * n3z );
+            double in3 = n3n > 0.0 ? 1.0 / n3n : 0.0;
+            n3x *= in3; n3y *= in3; n3z *= in3;
+            double n2x = n3y * n1z - n3z * n1y;
+            double n2y = n3z * n1x - n3x * n1z;
+            double n2z = n3x * n1y - n3y * n1x;
+            double nw[ 9 ] = { n1x, n1y, n1z, n2x, n2y, n2z, n3x, n3y, n3z };
+
+            bool ok = e3n > 1e-12 && n3n > 1e-9 * d * Math::sqrt( wx * wx + wy * wy + wz * wz ) && t3z != 0.0;
+
+            double it3z = t3z != 0.0 ? 1.0 / t3z : 0.0;
+            double f1 = t3x * it3z;
+            double f2 = t3y * it3z;
+            double p1 = n1x * wx + n1y * wy + n1z * wz;
+            double p2 = n2x * wx + n2y * wy + n2z * wz;
+
+            double cosBeta = ax * bx + ay * by + az * bz;
+            double b = 1.0 - cosBeta * cosBeta;
+            b = 1.0 / ( b > 1e-15 ? b : 1e-15 ) - 1.0;
+            b = Math::sqrt( b > 0.0 ? b : 0.0 );
+            b = cosBeta < 0.0 ? -b : b;
+
+            /* quartic in cos( theta ) */
+            double f1s = f1 * f1, f2s = f2 * f2;
+            double p1s = p1 * p1, p1c = p1s * p1, p1q = p1c * p1;
+            double p2s = p2 * p2, p2c = p2s * p2, p2q = p2c * p2;
+            double ds = d * d, bs = b * b;
+
+            double c4 = -f2s * p2q - p2q * f1s - p2q;
+            double c3 = 2 * p2c * d * b + 2 * f2s * p2c * d * b - 2 * f2 * p2c * f1 * d;
+            double c2 = -f2s * p2s * p1s - f2s * p2s * ds * bs - f2s * p2s * ds + f2s * p2q + p2q * f1s
+                        + 2 * p1 * p2s * d + 2 * f1 * f2 * p1 * p2s * d * b - p2s * p1s * f1s
+                        + 2 * p1 * p2s * f2s * d - p2s * ds * bs - 2 * p1s * p2s;
+            double c1 = 2 * p1s * p2 * d * b + 2 * f2 * p2c * f1 * d - 2 * f2s * p2c * d * b - 2 * p1 * p2 * ds * b;
+            double c0 = -2 * f2 * p2s * f1 * p1 * d * b + f2s * p2s * ds + 2 * p1c * d - p1s * ds
+                        + f2s * p2s * p1s - p1q - 2 * f2s * p2s * p1 * d + p2s * f1s * p1s
+                        + f2s * p2s * ds * bs;
+
+            double roots[ 4 ];
+            bool rvalid[ 4 ];
+            _p3pQuarticRoots( roots, rvalid, c4, c3, c2, c1, c0 );
+
+            /* back substitution of all roots */
+            for( int k = 0; k < 4; k++ ) {
+                double ct = roots[ k ];
+                bool v = ok && rvalid[ k ] && Math::abs( ct ) <= 1.0 + 1e-9;
+                ct = ct > -1.0 ? ct : -1.0;
+                ct = ct < 1.0 ? ct : 1.0;
+
+                double cotAlpha = ( -f1 * p1 / f2 - ct * p2 + d * b ) / ( -f1 * ct * p2 / f2 + p1 - d );
+                double st = Math::sqrt( 1.0 - ct * ct );
+                double sa = Math::sqrt( 1.0 / ( cotAlpha * cotAlpha + 1.0 ) );
+                double ca = 1.0 - sa * sa;
+                ca = Math::sqrt( ca > 0.0 ? ca : 0.0 );
+                ca = cotAlpha < 0.0 ? -ca : ca;
+
+                /* camera center in the intermediate world frame */
+                double h = d * ( sa * b + ca );
+                double C[ 3 ] = { ca * h, ct * sa * h, st * sa * h };
+
+                /* camera center in the world frame: Q1 + N^T C */
+                double Q1[ 3 ] = { Q1x, Q1y, Q1z };
+                double Cw[ 3 ];
+                for( int j = 0; j < 3; j++ )
+                    Cw[ j ] = Q1[ j ] + nw[ j ] * C[ 0 ] + nw[ 3 + j ] * C[ 1 ] + nw[ 6 + j ] * C[ 2 ];
+
+                /* world to camera rotation R = Tr^T Q N */
+                double Q[ 9 ] = { -ca, -sa * ct, -sa * st,
+                                   sa, -ca * ct, -ca * st,
+                                  0.0, -st,       ct };
+                double QN[ 9 ];
+                for( int r = 0; r < 3; r++ )
+                    for( int j = 0; j < 3; j++ )
+                        QN[ 3 * r + j ] = Q[ 3 * r ] * nw[ j ] + Q[ 3 * r + 1 ] * nw[ 3 + j ] + Q[ 3 * r + 2 ] * nw[ 6 + j ];
+
+                double* pose = poses + 12 * k * n + i;
+                for( int r = 0; r < 3; r++ ) {
+                    double t = 0.0;
+                    for( int j = 0; j < 3; j++ ) {
+                        double rij = tr[ r ] * QN[ j ] + tr[ 3 + r ] * QN[ 3 + j ] + tr[ 6 + r ] * QN[ 6 + j ];
+                        pose[ ( 3 * r + j ) * n ] = rij;
+                        t -= rij * Cw[ j ];
+                    }
+                    pose[ ( 9 + r ) * n ] = t;
+                    /* false for inf and nan */
+                    v = v && t - t == 0.0;
+                }
+                valid[ k * n + i ] = v;
+            }
+        }
+    }
+
     void SIMD::cleanup()
     {
         if( _simd )
@@ -44,6 +44,7 @@ namespace cvt {
         SIMD_SSE41,
         SIMD_SSE42,
         SIMD_AVX,
+        SIMD_AVX2,
         SIMD_BEST
     };
 
@@ -169,6 +170,14 @@ namespace cvt {
             virtual void IIR4BwdVertical4Fx( uint8_t * dst, size_t dstride, Fixed* fwdRes,
                                              size_t h, const Fixed * n, const Fixed * d, const Fixed & b ) const;
 
+            /* causal ( n, inputs i ... i - 3 ) and anti-causal ( m, inputs i + 1 ... i + 4 ) pass over width pixels
+               with 4 interleaved float lanes, the borders are extended with the edge values, dst != src */
+            virtual void IIR4Horizontal4f( float* dst, const float* src, size_t width, const float* n, const float* m,
+                                           const float* d, float b1, float b2 ) const;
+            /* one row of the recursion: dst = sum n[ k ] * x[ k ] - sum d[ k ] * y[ k ], x[ 0 ] is the current input row,
+               y[ 0 ] the last output row */
+            virtual void IIR4Vertical_f( float* dst, const float** x, const float** y, const float* n, const float* d, size_t width ) const;
+
 			/* add vertical */
 			virtual void AddVert_f( float* dst, const float**bufs, size_t numbufs, size_t width ) const;
 			virtual void AddVert_f_to_u8( uint8_t* dst, const float**bufs, size_t numbufs, size_t width ) const;
@@ -255,6 +264,16 @@ namespace cvt {
 
             virtual void Conv_XXXu8_to_XXXAu8(uint8_t * dst, const uint8_t* src, size_t n) const;
             virtual void Conv_XXXAu8_to_XXXu8(uint8_t * dst, const uint8_t* src, size_t n) const;
+            virtual void Conv_XYZu8_to_ZYXAu8( uint8_t* dst, const uint8_t* src, const size_t n ) const;
+            virtual void Conv_XYZAu8_to_ZYXu8( uint8_t* dst, const uint8_t* src, const size_t n ) const;
+            virtual void Conv_RGBu8_to_GRAYu8( uint8_t* dst, const uint8_t* src, const size_t n ) const;
+            virtual void Conv_BGRu8_to_GRAYu8( uint8_t* dst, const uint8_t* src, const size_t n ) const;
+            virtual void Conv_RGBu8_to_GRAYf( float* dst, const uint8_t* src, const size_t n ) const;
+            virtual void Conv_BGRu8_to_GRAYf( float* dst, const uint8_t* src, const size_t n ) const;
+
+            /* IEEE 754 half-float conversions, float to half rounds to nearest even */
+            virtual void Conv_f_to_f16( uint16_t* dst, const float* src, const size_t n ) const;
+            virtual void Conv_f16_to_f( float* dst, const uint16_t* src, const size_t n ) const;
 
             virtual void Conv_YUYVu8_to_RGBAu8( uint8_t* dst, const uint8_t* src, const size_t n ) const;
             virtual void Conv_YUYVu8_to_BGRAu8( uint8_t* dst, const uint8_t* src, const size_t n ) const;
@@ -271,6 +290,8 @@ namespace cvt {
 
             virtual void Conv_YUV420u8_to_RGBAu8( uint8_t* dst, const uint8_t* srcy, const uint8_t* srcu, const uint8_t* srcv, const size_t n ) const;
             virtual void Conv_YUV420u8_to_BGRAu8( uint8_t* dst, const uint8_t* srcy, const uint8_t* srcu, const uint8_t* srcv, const size_t n ) const;
+            virtual void Conv_NV12u8_to_RGBAu8( uint8_t* dst, const uint8_t* srcy, const uint8_t* srcuv, const size_t n ) const;
+            virtual void Conv_NV12u8_to_BGRAu8( uint8_t* dst, const uint8_t* srcy, const uint8_t* srcuv, const size_t n ) const;
 
 
             virtual void Decompose_4f( float* dst1, float* dst2, float* dst3, float* dst4, const float* src, size_t n ) const;
@@ -299,6 +320,9 @@ namespace cvt {
             virtual void pyrdownHalfHorizontal_1u8_to_1u16( uint16_t* dst, const uint8_t* src, size_t n ) const;
             /* convolve with vertical gaussian [ 1 4 6 4 1 ] and store the odd rows in u8 dst by >> 8 */
             virtual void pyrdownHalfVertical_1u16_to_1u8( uint8_t* dst, uint16_t* rows[ 5 ], size_t n ) const;
+            /* average 2x2 blocks of the rows src1 and src2 into n dst pixels, src rows have at least 2 * n pixels */
+            virtual void pyrdownBox2x2_1f( float* dst, const float* src1, const float* src2, size_t n ) const;
+            virtual void pyrdownBox2x2_1u8( uint8_t* dst, const uint8_t* src1, const uint8_t* src2, size_t n ) const;
 
             virtual void warpLinePerspectiveBilinear1f( float* dst, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight,
                                                         const float* point, const float* normal, const size_t n ) const;
@@ -315,7 +339,32 @@ namespace cvt {
             virtual void warpBilinear1u8( uint8_t* dst, const float* coords, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint8_t fill, size_t n ) const;
             virtual void warpBilinear4u8( uint8_t* dst, const float* coords, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const;
 
+            /* bilinear remap with fixed-point maps: xy holds the int16 ( x, y ) source position,
+               frac the 5-bit fractions ( fx | fy << 5 ) - samples outside of the source use fill */
+            virtual void remapBilinear1f( float* dst, const int16_t* xy, const uint16_t* frac, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fill, size_t n ) const;
+            virtual void remapBilinear4f( float* dst, const int16_t* xy, const uint16_t* frac, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* fill, size_t n ) const;
+            virtual void remapBilinear1u8( uint8_t* dst, const int16_t* xy, const uint16_t* frac, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint8_t fill, size_t n ) const;
+            virtual void remapBilinear4u8( uint8_t* dst, const int16_t* xy, const uint16_t* frac, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const;
+
+            /* source positions of n destination pixels along a row of a projective warp: ( point + i * delta ) dehomogenized */
+            virtual void warpProjectiveCoords_f( float* coords, const float* point, const float* delta, size_t n ) const;
+            /* bicubic ( Catmull-Rom ) warp with the interleaved source positions coords, taps outside of src are fill */
+            virtual void warpBicubic1f( float* dst, const float* coords, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fill, size_t n ) const;
+            virtual void warpBicubic4f( float* dst, const float* coords, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* fill, size_t n ) const;
+            virtual void warpBicubic1u8( uint8_t* dst, const float* coords, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint8_t fill, size_t n ) const;
+            virtual void warpBicubic4u8( uint8_t* dst, const float* coords, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const;
+
+            /* weighted truncated L1 cost of n samples with 8 channels against a row of 8 channel pixels, sample i
+               is compared to the row linearly interpolated at x + i * dx, samples outside of [ 0, srcWidth ) are skipped.
+               Returns sum_i w_i * sum_c scale_c * min( | ref_ic - src_c |, truncation_c ) and adds the used weights to wsum */
+            virtual float costTruncatedL1Line8f( float& wsum, const float* ref, const float* weights, const float* src, size_t srcWidth,
+                                                 float x, float dx, const float* truncation, const float* scale, size_t n ) const;
+
 			virtual void harrisScore1f( float* dst, const float* boxdx2, const float* boxdy2, const float* boxdxdy, float kappa, size_t width ) const;
+			/* smaller eigenvalue of the structure tensors [ a c; c b ] */
+			virtual void shiTomasiScore1f( float* dst, const float* boxdx2, const float* boxdy2, const float* boxdxdy, size_t width ) const;
+			/* central difference gradient products of the row cur, cur[ -1 ] and cur[ width ] must be valid */
+			virtual void cornerTensor1f( float* dx2, float* dy2, float* dxdy, const float* prev, const float* cur, const float* next, size_t width ) const;
 
             virtual float harrisResponse1u8( const uint8_t* _src, size_t srcStride, size_t w, size_t h, const float k ) const;
             virtual float harrisResponse1u8( float & xx, float & xy, float& yy, const uint8_t* _src, size_t srcStride, size_t w, size_t h, const float k ) const;
@@ -335,7 +384,19 @@ namespace cvt {
             virtual void debayer_EVEN_RGGBu8_GRAYu8( uint32_t* dst, const uint32_t* src1, const uint32_t* src2, const uint32_t* src3, size_t n ) const;
             virtual void debayer_ODD_RGGBu8_GRAYu8( uint32_t* dst, const uint32_t* src1, const uint32_t* src2, const uint32_t* src3, size_t n ) const;
 
+			/*
+			   Generic Bayer row kernels for all CFA patterns, src holds the rows y-1 .. y+1 (linear)
+			   or y-2 .. y+2 (MHC), every row has to be readable two pixels beyond both ends.
+			   If phase is 0 the first pixel of the row is red/blue, otherwise green.
+			   redrow selects whether red (true) or blue is the non-green color of the row,
+			   the output is RGBA - for BGRA pass the inverted redrow value.
+			 */
+			virtual void debayer_LINEARu8_RGBAu8( uint32_t* dst, const uint8_t** src, size_t n, size_t phase, bool redrow ) const;
+			virtual void debayer_MHCu8_RGBAu8( uint32_t* dst, const uint8_t** src, size_t n, size_t phase, bool redrow ) const;
+
             virtual size_t hammingDistance( const uint8_t* src1, const uint8_t* src2, size_t n ) const;
+			/* distances of query to n descriptors of len bytes stored contiguously in base */
+			virtual void hammingDistance1N( uint32_t* dst, const uint8_t* query, const uint8_t* base, size_t len, size_t n ) const;
 
 			// prefix sum for 1 channel images
 			virtual void prefixSum1_u8_to_f( float * dst, size_t dstStride, const uint8_t* src, size_t srcStride, size_t width, size_t height ) const;
@@ -346,6 +407,12 @@ namespace cvt {
 			virtual void prefixSumSqr1_u8_to_f( float * dst, size_t dStride, const uint8_t * src, size_t srcStride, size_t width, size_t height ) const;
 			virtual void prefixSumSqr1_f_to_f( float * dst, size_t dStride, const float* src, size_t srcStride, size_t width, size_t height ) const;
 
+			/**
+			  Horizontal prefix sum of one row with interleaved channels, dst = scan( src ) + prev.
+			  @param prev	previous row of the table or NULL
+			 */
+			virtual void prefixSumRow_f_to_f( float* dst, const float* src, const float* prev, size_t width, size_t channels ) const;
+
 			virtual void boxFilterPrefixSum1_f_to_f( float* dst, size_t dstride, const float* src, size_t srcstride, size_t width, size_t height, size_t boxwidth, size_t boxheight ) const;
 			virtual void boxFilterPrefixSum1_f_to_u8( uint8_t* dst, size_t dstride, const float* src, size_t srcstride, size_t width, size_t height, size_t boxwidth, size_t boxheight ) const;
 
@@ -357,6 +424,78 @@ namespace cvt {
 			virtual void threshold1_u8_to_u8( uint8_t* dst, const uint8_t* src, size_t n, uint8_t t ) const;
 			virtual void threshold1_u8_to_f( float* dst, const uint8_t* src, size_t n, uint8_t t ) const;
 
+			/**
+			  Canny gradient of one row, the 3x3 sobel operator scaled by 1/4 with clamped columns.
+			  Stores the magnitude and the quantized direction ( 0 horizontal, 1 vertical, 2 diagonal up, 3 diagonal down ).
+			  @param prev	row above, clamped by the caller
+			  @param next	row below, clamped by the caller
+			 */
+			virtual void cannyGradient1_f( float* mag, uint8_t* dir, const float* prev, const float* cur, const float* next, size_t width ) const;
+			/* magnitude and quantized direction from precomputed gradients */
+			virtual void cannyGradient1_f( float* mag, uint8_t* dir, const float* dx, const float* dy, size_t width ) const;
+			/**
+			  Canny non-maximum suppression of one row, dst is 0 for suppressed pixels, 1 for local maxima
+			  with magnitude >= low and 2 for local maxima with magnitude >= high. The first and the last pixel are 0.
+			 */
+			virtual void cannyNonMaxima1_f( uint8_t* dst, const float* mprev, const float* mcur, const float* mnext, const uint8_t* dir, size_t width, float low, float high ) const;
+
+			/**
+			  Dual step of the primal-dual TV solver for one row, p = ( p + sigma * grad u ) * g / ( g + sigma * epsilon )
+			  projected onto the disc with radius g. Forward differences, zero in the last column and for unext = NULL.
+			  @param weight	TV weights g or NULL for g = 1
+			 */
+			virtual void pdtvDual1_f( float* px, float* py, const float* u, const float* unext, const float* weight, size_t width, float sigma, float epsilon ) const;
+			/**
+			  Primal step of the primal-dual TV solver for one row, the proximal step of the quadratic ( l1 = false )
+			  or absolute data term at u + tau * div p, followed by the extrapolation ubar = unew + theta * ( unew - u ).
+			  @param pyprev	py of the previous row or NULL
+			  @param lambda	per pixel data term weights or NULL for lambdac
+			 */
+			virtual void pdtvPrimal1_f( float* u, float* ubar, const float* px, const float* py, const float* pyprev, const float* f, const float* lambda, float lambdac, size_t width, float tau, float theta, bool l1 ) const;
+
+			/**
+			  Cubic B-spline histogram binning of values in [0, 1] ( clamped ) to bins >= 4 bins, value v contributes to
+			  the bins idx .. idx + 3 with the four weights. dweights are the derivatives of the weights with respect to
+			  the bin coordinate v * ( bins - 3 ) + 1 and may be NULL.
+			 */
+			virtual void histogramBSplineWeights_f( int32_t* idx, float* weights, float* dweights, const float* src, size_t n, size_t bins ) const;
+			/* adds the outer products of the B-spline weights of n value pairs to the bins x bins joint histogram */
+			virtual void jointHistogramBSpline_f( float* hist, size_t bins, const int32_t* ia, const float* wa, const int32_t* ib, const float* wb, size_t n ) const;
+
+			/**
+			  Residual and steepest descent system of a KLT patch: residual = warped - patch,
+			  jsum[ k ] = sum of jac[ k * n + i ] * residual[ i ] for the nparams steepest descent planes in jac.
+			  @return the sum of squared residuals
+			 */
+			virtual float kltSystem_f( float* jsum, float* residual, const float* warped, const float* patch, const float* jac, size_t nparams, size_t n ) const;
+
+			/**
+			  Accelerated segment test strength for n pixels, offsets holds the circle of circle <= 16 pixels,
+			  arc < 16 is the required number of contiguous brighter or darker pixels. The strength M is the largest
+			  difference such that the segment test succeeds for all thresholds below M, dst is M for corners
+			  ( M > threshold ) and 0 otherwise. The FAST / AGAST corner score equals M - 1.
+			 */
+			virtual void astStrength_u8( uint8_t* dst, const uint8_t* src, const int* offsets, size_t circle, size_t arc, uint8_t threshold, size_t n ) const;
+
+			/**
+			  Sums of n boxes in an integral image, offsets holds the four corners ( br, tr, bl, tl ) of every box
+			  relative to src: dst[ i ] = src[ br ] - src[ tr ] - src[ bl ] + src[ tl ].
+			 */
+			virtual void boxSum_f( float* dst, const float* src, const int* offsets, size_t n ) const;
+			/**
+			  n ( multiple of 8 ) binary box comparisons in an integral image, offsets holds the corners of the
+			  two boxes a and b of every test in the order of boxSum_f. Bit t of dst[ i ] is set if sum( a ) < sum( b )
+			  for test 8 * i + t.
+			 */
+			virtual void boxTest_f( uint8_t* dst, const float* src, const int* offsets, size_t n ) const;
+			/**
+			  Fern evaluation for n points, given as offsets relative to src. tests holds numTests ( <= 32 ) pairs
+			  of pixel offsets relative to the point, the result of the first test is the most significant bit:
+			  dst[ i ] = ( dst[ i ] << 1 ) | ( src[ p + a ] < src[ p + b ] ).
+			  Implementations may read up to 3 bytes after every sampled pixel.
+			 */
+			virtual void fernIndex_u8( uint32_t* dst, const uint8_t* src, const int* points, size_t n, const int* tests, size_t numTests ) const;
+
             virtual void sumPoints( Vector2f& dst, const Vector2f* src, size_t n ) const;
             virtual void sumPoints( Vector3f& dst, const Vector3f* src, size_t n ) const;
 
@@ -388,6 +527,27 @@ namespace cvt {
             virtual void projectPoints( Vector2f* dst, const Matrix4f& mat, const Vector3f* src, size_t n ) const;
             virtual void projectPoints( Vector2d* dst, const Matrix4d& mat, const Vector3d* src, size_t n ) const;
 
+            /**
+             *  \brief squared reprojection errors of 3D points with SoA layout
+             *  \param dst      the squared distances of the projections to ( u, v ), FLT_MAX for points with depth <= 0
+             *  \param P        the 3x4 projection matrix, row major
+             *  \param x, y, z  the 3D points
+             *  \param u, v     the 2D measurements
+             *  \param n        the number of points
+             */
+            virtual void reprojectionErrorSqr( float* dst, const float* P, const float* x, const float* y, const float* z,
+                                               const float* u, const float* v, size_t n ) const;
+
+            /**
+             *  \brief P3P for n samples, one sample per lane
+             *  \param poses    4 * 12 planes of n values, solution k stores the world to camera rotation ( row major )
+             *                  in the planes 12 * k + 0 ... 12 * k + 8 and the translation in 12 * k + 9 ... 12 * k + 11
+             *  \param valid    4 planes of n flags marking the solutions, values of invalid solutions are unspecified
+             *  \param in       18 planes of n values: the three unit bearings followed by the three 3D points
+             *  \param n        the number of samples
+             */
+            virtual void p3p_d( double* poses, uint8_t* valid, const double* in, size_t n ) const;
+
             virtual std::string name() const;
             virtual SIMDType type() const;
 
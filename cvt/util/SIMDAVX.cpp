@@ -204,4 +204,38 @@ namespace cvt
 		return Math::invSqrt( var1var2 ) * cov;
 	}
 
+
+	void SIMDAVX::Conv_f_to_f16( uint16_t* dst, const float* src, const size_t n ) const
+	{
+		if( !_f16c ) {
+			SIMDSSE42::Conv_f_to_f16( dst, src, n );
+			return;
+		}
+
+		size_t i = n >> 3;
+		while( i-- ) {
+			_mm_storeu_si128( ( __m128i* ) dst, _mm256_cvtps_ph( _mm256_loadu_ps( src ), 0 ) );
+			src += 8;
+			dst += 8;
+		}
+
+		SIMD::Conv_f_to_f16( dst, src, n & 0x07 );
+	}
+
+	void SIMDAVX::Conv_f16_to_f( float* dst, const uint16_t* src, const size_t n ) const
+	{
+		if( !_f16c ) {
+			SIMDSSE42::Conv_f16_to_f( dst, src, n );
+			return;
+		}
+
+		size_t i = n >> 3;
+		while( i-- ) {
+			_mm256_storeu_ps( dst, _mm256_cvtph_ps( _mm_loadu_si128( ( const __m128i* ) src ) ) );
+			src += 8;
+			dst += 8;
+		}
+
+		SIMD::Conv_f16_to_f( dst, src, n & 0x07 );
+	}
 }
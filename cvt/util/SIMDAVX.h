@@ -26,6 +26,7 @@
 #define SIMDAVX_H
 
 #include <cvt/util/SIMDSSE42.h>
+#include <cvt/util/CPU.h>
 
 namespace cvt {
 
@@ -33,15 +34,22 @@ namespace cvt {
 		friend class SIMD;
 
 		protected:
-			SIMDAVX() {}
+			SIMDAVX() : _f16c( cpuFeatures() & CPU_F16C ) {}
 
 		public:
             virtual float SAD( const float* src1, const float* src2, const size_t n ) const;
             virtual float SSD( const float* src1, const float* src2, const size_t n ) const;
             virtual float NCC( const float* src1, const float* src2, const size_t n ) const;
 
+			virtual void Conv_f_to_f16( uint16_t* dst, const float* src, const size_t n ) const;
+			virtual void Conv_f16_to_f( float* dst, const uint16_t* src, const size_t n ) const;
+
 			virtual std::string name() const;
 			virtual SIMDType type() const;
+
+		private:
+			/* F16C is a separate cpuid bit, fall back to SSE2 without it */
+			bool _f16c;
 	};
 
 	inline std::string SIMDAVX::name() const
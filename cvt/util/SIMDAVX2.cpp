@@ -0,0 +1,190 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/util/SIMDAVX2.h>
+#include <immintrin.h>
+
+namespace cvt
+{
+	void SIMDAVX2::astStrength_u8( uint8_t* dst, const uint8_t* src, const int* offsets, size_t circle, size_t arc, uint8_t threshold, size_t n ) const
+	{
+		/* minima over 1, 2, 4 and 8 contiguous circle pixels, replicated once for the wrap around */
+		__m256i bright[ 4 ][ 32 ], dark[ 4 ][ 32 ];
+		const __m256i thres = _mm256_set1_epi8( threshold );
+		const __m256i zero = _mm256_setzero_si256();
+		size_t levels = 1;
+		while( ( ( size_t ) 1 << levels ) <= arc && levels < 4 )
+			levels++;
+
+		for( size_t i = n >> 5; i--; ) {
+			const __m256i c = _mm256_loadu_si256( ( const __m256i* ) src );
+			__m256i mx = zero;
+			for( size_t j = 0; j < circle; j++ ) {
+				__m256i v = _mm256_loadu_si256( ( const __m256i* ) ( src + offsets[ j ] ) );
+				bright[ 0 ][ j ] = bright[ 0 ][ j + circle ] = _mm256_subs_epu8( v, c );
+				dark[ 0 ][ j ] = dark[ 0 ][ j + circle ] = _mm256_subs_epu8( c, v );
+				mx = _mm256_max_epu8( mx, _mm256_max_epu8( bright[ 0 ][ j ], dark[ 0 ][ j ] ) );
+			}
+
+			/* no difference above the threshold: no corner in this block */
+			if( ( uint32_t ) _mm256_movemask_epi8( _mm256_cmpeq_epi8( _mm256_subs_epu8( mx, thres ), zero ) ) == 0xffffffff ) {
+				_mm256_storeu_si256( ( __m256i* ) dst, zero );
+				src += 32;
+				dst += 32;
+				continue;
+			}
+
+			for( size_t l = 1; l < levels; l++ ) {
+				size_t len = ( size_t ) 1 << ( l - 1 );
+				for( size_t j = 0; j < circle; j++ ) {
+					bright[ l ][ j ] = bright[ l ][ j + circle ] = _mm256_min_epu8( bright[ l - 1 ][ j ], bright[ l - 1 ][ j + len ] );
+					dark[ l ][ j ] = dark[ l ][ j + circle ] = _mm256_min_epu8( dark[ l - 1 ][ j ], dark[ l - 1 ][ j + len ] );
+				}
+			}
+
+			__m256i strength = zero;
+			for( size_t k = 0; k < circle; k++ ) {
+				__m256i b = _mm256_set1_epi8( ( char ) 0xff );
+				__m256i d = b;
+				size_t pos = k;
+				for( int l = levels - 1; l >= 0; l-- ) {
+					if( arc & ( ( size_t ) 1 << l ) ) {
+						b = _mm256_min_epu8( b, bright[ l ][ pos ] );
+						d = _mm256_min_epu8( d, dark[ l ][ pos ] );
+						pos += ( size_t ) 1 << l;
+						if( pos >= circle )
+							pos -= circle;
+					}
+				}
+				strength = _mm256_max_epu8( strength, _mm256_max_epu8( b, d ) );
+			}
+
+			__m256i notcorner = _mm256_cmpeq_epi8( _mm256_subs_epu8( strength, thres ), zero );
+			_mm256_storeu_si256( ( __m256i* ) dst, _mm256_andnot_si256( notcorner, strength ) );
+			src += 32;
+			dst += 32;
+		}
+
+		// Zero upper half of AVX registers to avoid AVX-SSE transition penalties
+		_mm256_zeroupper( );
+
+		SIMDSSE2::astStrength_u8( dst, src, offsets, circle, arc, threshold, n & 0x1f );
+	}
+
+	/* gathers corner k of 8 boxes whose corners are stride ints apart */
+	static inline __m256 _boxCorner8( const float* src, const int* offsets, const __m256i& index )
+	{
+		return _mm256_i32gather_ps( src, _mm256_i32gather_epi32( offsets, index, 4 ), 4 );
+	}
+
+	static inline __m256 _boxSum8( const float* src, const int* o, const __m256i& index )
+	{
+		__m256 br = _boxCorner8( src, o, index );
+		__m256 tr = _boxCorner8( src, o + 1, index );
+		__m256 bl = _boxCorner8( src, o + 2, index );
+		__m256 tl = _boxCorner8( src, o + 3, index );
+		return _mm256_add_ps( _mm256_sub_ps( _mm256_sub_ps( br, tr ), bl ), tl );
+	}
+
+	void SIMDAVX2::boxSum_f( float* dst, const float* src, const int* offsets, size_t n ) const
+	{
+		const __m256i index = _mm256_setr_epi32( 0, 4, 8, 12, 16, 20, 24, 28 );
+		for( size_t i = n >> 3; i--; ) {
+			_mm256_storeu_ps( dst, _boxSum8( src, offsets, index ) );
+			offsets += 32;
+			dst += 8;
+		}
+
+		_mm256_zeroupper( );
+
+		SIMDSSE2::boxSum_f( dst, src, offsets, n & 0x7 );
+	}
+
+	void SIMDAVX2::boxTest_f( uint8_t* dst, const float* src, const int* offsets, size_t n ) const
+	{
+		const __m256i index = _mm256_setr_epi32( 0, 8, 16, 24, 32, 40, 48, 56 );
+		for( size_t i = n >> 3; i--; ) {
+			__m256 a = _boxSum8( src, offsets, index );
+			__m256 b = _boxSum8( src, offsets + 4, index );
+			*dst++ = _mm256_movemask_ps( _mm256_cmp_ps( a, b, _CMP_LT_OQ ) );
+			offsets += 64;
+		}
+
+		_mm256_zeroupper( );
+	}
+
+	void SIMDAVX2::hammingDistance1N( uint32_t* dst, const uint8_t* query, const uint8_t* base, size_t len, size_t n ) const
+	{
+		/* the per byte counts of up to 31 blocks fit into 8 bit */
+		if( ( len & 0x1f ) || len > 32 * 31 ) {
+			SIMDAVX::hammingDistance1N( dst, query, base, len, n );
+			return;
+		}
+
+		const __m256i lut  = _mm256_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+											   0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+		const __m256i mask = _mm256_set1_epi8( 0x0f );
+		const __m256i zero = _mm256_setzero_si256();
+		const size_t blocks = len >> 5;
+
+		while( n-- ) {
+			__m256i sum = zero;
+			for( size_t b = 0; b < blocks; b++ ) {
+				__m256i xored = _mm256_xor_si256( _mm256_loadu_si256( ( const __m256i* )( query + ( b << 5 ) ) ),
+												  _mm256_loadu_si256( ( const __m256i* )( base + ( b << 5 ) ) ) );
+				sum = _mm256_add_epi8( sum, _mm256_shuffle_epi8( lut, _mm256_and_si256( xored, mask ) ) );
+				sum = _mm256_add_epi8( sum, _mm256_shuffle_epi8( lut, _mm256_and_si256( _mm256_srli_epi64( xored, 4 ), mask ) ) );
+			}
+			sum = _mm256_sad_epu8( sum, zero );
+			__m128i s = _mm_add_epi64( _mm256_castsi256_si128( sum ), _mm256_extracti128_si256( sum, 1 ) );
+			*dst++ = _mm_cvtsi128_si32( s ) + _mm_cvtsi128_si32( _mm_srli_si128( s, 8 ) );
+			base += len;
+		}
+		_mm256_zeroupper( );
+	}
+
+	void SIMDAVX2::fernIndex_u8( uint32_t* dst, const uint8_t* src, const int* points, size_t n, const int* tests, size_t numTests ) const
+	{
+		const __m256i mask = _mm256_set1_epi32( 0xff );
+		const __m256i one  = _mm256_set1_epi32( 1 );
+
+		/* eight points at once, the pixels are fetched with 32 bit gathers */
+		for( size_t i = n >> 3; i--; ) {
+			__m256i p = _mm256_loadu_si256( ( const __m256i* ) points );
+			__m256i idx = _mm256_setzero_si256();
+			for( size_t t = 0; t < numTests; t++ ) {
+				__m256i a = _mm256_and_si256( _mm256_i32gather_epi32( ( const int* ) src, _mm256_add_epi32( p, _mm256_set1_epi32( tests[ 2 * t ] ) ), 1 ), mask );
+				__m256i b = _mm256_and_si256( _mm256_i32gather_epi32( ( const int* ) src, _mm256_add_epi32( p, _mm256_set1_epi32( tests[ 2 * t + 1 ] ) ), 1 ), mask );
+				idx = _mm256_or_si256( _mm256_slli_epi32( idx, 1 ), _mm256_and_si256( _mm256_cmpgt_epi32( b, a ), one ) );
+			}
+			_mm256_storeu_si256( ( __m256i* ) dst, idx );
+			points += 8;
+			dst += 8;
+		}
+
+		SIMDAVX::fernIndex_u8( dst, src, points, n & 0x7, tests, numTests );
+	}
+
+}
@@ -0,0 +1,61 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef SIMDAVX2_H
+#define SIMDAVX2_H
+
+#include <cvt/util/SIMDAVX.h>
+
+namespace cvt {
+
+	class SIMDAVX2 : public SIMDAVX {
+		friend class SIMD;
+
+		protected:
+			SIMDAVX2() {}
+
+		public:
+			virtual void astStrength_u8( uint8_t* dst, const uint8_t* src, const int* offsets, size_t circle, size_t arc, uint8_t threshold, size_t n ) const;
+			virtual void boxSum_f( float* dst, const float* src, const int* offsets, size_t n ) const;
+			virtual void boxTest_f( uint8_t* dst, const float* src, const int* offsets, size_t n ) const;
+			virtual void fernIndex_u8( uint32_t* dst, const uint8_t* src, const int* points, size_t n, const int* tests, size_t numTests ) const;
+			virtual void hammingDistance1N( uint32_t* dst, const uint8_t* query, const uint8_t* base, size_t len, size_t n ) const;
+
+			virtual std::string name() const;
+			virtual SIMDType type() const;
+	};
+
+	inline std::string SIMDAVX2::name() const
+	{
+		return "SIMD-AVX2";
+	}
+
+	inline SIMDType SIMDAVX2::type() const
+	{
+		return SIMD_AVX2;
+	}
+}
+
+#endif
@@ -29,6 +29,7 @@
 
 #include <xmmintrin.h>
 #include <emmintrin.h>
+#include <float.h>
 
 #include <cvt/util/SIMDDebug.h>
 
@@ -2680,6 +2681,52 @@ namespace cvt
 		}
 	}
 
+	void SIMDSSE2::Conv_f_to_u8( uint8_t* dst, const float* src, const size_t n ) const
+	{
+		const __m128 scale = _mm_set1_ps( 255.0f );
+		const __m128 half = _mm_set1_ps( 0.5f );
+		__m128i a, b, c, d;
+		size_t i = n >> 4;
+
+		/* clamp the upper bound before the conversion, packus clamps the lower one */
+#define F_TO_U8_4( s ) _mm_cvttps_epi32( _mm_min_ps( _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( s ), scale ), half ), scale ) )
+		while( i-- ) {
+			a = F_TO_U8_4( src );
+			b = F_TO_U8_4( src + 4 );
+			c = F_TO_U8_4( src + 8 );
+			d = F_TO_U8_4( src + 12 );
+			_mm_storeu_si128( ( __m128i* ) dst, _mm_packus_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) ) );
+			src += 16;
+			dst += 16;
+		}
+#undef F_TO_U8_4
+
+		SIMD::Conv_f_to_u8( dst, src, n & 0xf );
+	}
+
+	void SIMDSSE2::Conv_u8_to_f( float* dst, const uint8_t* src, const size_t n ) const
+	{
+		const __m128 scale = _mm_set1_ps( 255.0f );
+		const __m128i zero = _mm_setzero_si128();
+		__m128i in, lo, hi;
+		size_t i = n >> 4;
+
+		/* division instead of the reciprocal to match the lookup table */
+		while( i-- ) {
+			in = _mm_loadu_si128( ( const __m128i* ) src );
+			lo = _mm_unpacklo_epi8( in, zero );
+			hi = _mm_unpackhi_epi8( in, zero );
+			_mm_storeu_ps( dst, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ), scale ) );
+			_mm_storeu_ps( dst + 4, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ), scale ) );
+			_mm_storeu_ps( dst + 8, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ), scale ) );
+			_mm_storeu_ps( dst + 12, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ), scale ) );
+			src += 16;
+			dst += 16;
+		}
+
+		SIMD::Conv_u8_to_f( dst, src, n & 0xf );
+	}
+
 	void SIMDSSE2::Conv_fx_to_u8( uint8_t* dst, const Fixed* src, const size_t n ) const
 	{
 		size_t i = n >> 4;
@@ -2773,6 +2820,94 @@ namespace cvt
 			*dst++ = scale * ( float ) ( *src++ );
 	}
 
+	static inline __m128i _mm_cvtps_f16_sse2( __m128 in )
+	{
+		const __m128i signmask  = _mm_set1_epi32( 0x80000000 );
+		const __m128i f16max    = _mm_set1_epi32( 0x47800000 );
+		const __m128i f32inf    = _mm_set1_epi32( 0x7f800000 );
+		const __m128i minnormal = _mm_set1_epi32( 0x38800000 );
+		const __m128i submagic  = _mm_set1_epi32( 0x3f000000 );
+		const __m128i normbias  = _mm_set1_epi32( 0xc8000fff );
+		const __m128i f16inf    = _mm_set1_epi32( 0x7c00 );
+		const __m128i f16nanbit = _mm_set1_epi32( 0x200 );
+		__m128i f, sign, isnan, isregular, issub, infnan, sub, mantodd, normal, ret;
+
+		f = _mm_castps_si128( in );
+		sign = _mm_and_si128( f, signmask );
+		f = _mm_xor_si128( f, sign );
+
+		isnan     = _mm_cmpgt_epi32( f, f32inf );
+		isregular = _mm_cmpgt_epi32( f16max, f );
+		issub     = _mm_cmpgt_epi32( minnormal, f );
+		infnan    = _mm_or_si128( _mm_and_si128( isnan, f16nanbit ), f16inf );
+
+		/* denormals: let the FPU do the rounding */
+		sub = _mm_castps_si128( _mm_add_ps( _mm_castsi128_ps( f ), _mm_castsi128_ps( submagic ) ) );
+		sub = _mm_sub_epi32( sub, submagic );
+
+		/* normals: rebias exponent and round to nearest even */
+		mantodd = _mm_srai_epi32( _mm_slli_epi32( f, 18 ), 31 );
+		normal = _mm_sub_epi32( _mm_add_epi32( f, normbias ), mantodd );
+		normal = _mm_srli_epi32( normal, 13 );
+
+		ret = _mm_or_si128( _mm_and_si128( issub, sub ), _mm_andnot_si128( issub, normal ) );
+		ret = _mm_or_si128( _mm_and_si128( isregular, ret ), _mm_andnot_si128( isregular, infnan ) );
+		return _mm_or_si128( ret, _mm_srli_epi32( sign, 16 ) );
+	}
+
+	static inline __m128 _mm_cvtf16_ps_sse2( __m128i in )
+	{
+		const __m128i nosign   = _mm_set1_epi32( 0x7fff );
+		const __m128  magic    = _mm_castsi128_ps( _mm_set1_epi32( ( 254 - 15 ) << 23 ) );
+		const __m128i wasinfnan = _mm_set1_epi32( 0x7bff );
+		const __m128i expinfnan = _mm_set1_epi32( 255 << 23 );
+		__m128i expmant, sign, infnan;
+		__m128 scaled;
+
+		expmant = _mm_and_si128( in, nosign );
+		sign    = _mm_slli_epi32( _mm_xor_si128( in, expmant ), 16 );
+		/* rebias the exponent by multiplication, this also handles denormals */
+		scaled  = _mm_mul_ps( _mm_castsi128_ps( _mm_slli_epi32( expmant, 13 ) ), magic );
+		infnan  = _mm_and_si128( _mm_cmpgt_epi32( expmant, wasinfnan ), expinfnan );
+		return _mm_or_ps( scaled, _mm_castsi128_ps( _mm_or_si128( sign, infnan ) ) );
+	}
+
+	void SIMDSSE2::Conv_f_to_f16( uint16_t* dst, const float* src, const size_t n ) const
+	{
+		const __m128i bias = _mm_set1_epi32( 0x8000 );
+		const __m128i bias16 = _mm_set1_epi16( ( short ) 0x8000 );
+		__m128i lo, hi;
+		size_t i = n >> 3;
+
+		while( i-- ) {
+			lo = _mm_sub_epi32( _mm_cvtps_f16_sse2( _mm_loadu_ps( src ) ), bias );
+			hi = _mm_sub_epi32( _mm_cvtps_f16_sse2( _mm_loadu_ps( src + 4 ) ), bias );
+			/* unsigned pack via signed saturation of the biased values */
+			_mm_storeu_si128( ( __m128i* ) dst, _mm_xor_si128( _mm_packs_epi32( lo, hi ), bias16 ) );
+			src += 8;
+			dst += 8;
+		}
+
+		SIMD::Conv_f_to_f16( dst, src, n & 0x07 );
+	}
+
+	void SIMDSSE2::Conv_f16_to_f( float* dst, const uint16_t* src, const size_t n ) const
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i in;
+		size_t i = n >> 3;
+
+		while( i-- ) {
+			in = _mm_loadu_si128( ( __m128i* ) src );
+			_mm_storeu_ps( dst, _mm_cvtf16_ps_sse2( _mm_unpacklo_epi16( in, zero ) ) );
+			_mm_storeu_ps( dst + 4, _mm_cvtf16_ps_sse2( _mm_unpackhi_epi16( in, zero ) ) );
+			src += 8;
+			dst += 8;
+		}
+
+		SIMD::Conv_f16_to_f( dst, src, n & 0x07 );
+	}
+
 	void SIMDSSE2::Conv_YUYVu8_to_RGBAu8( uint8_t* dst, const uint8_t* src, const size_t n ) const
 	{
 		const __m128i Y2RGB = _mm_set_epi16( 1192, 0, 1192, 0, 1192, 0, 1192, 0 );
@@ -3909,6 +4044,598 @@ namespace cvt
 		}
 	}
 
+	void SIMDSSE2::pyrdownBox2x2_1f( float* dst, const float* src1, const float* src2, size_t n ) const
+	{
+		const __m128 quarter = _mm_set1_ps( 0.25f );
+		__m128 a, b;
+
+		size_t n4 = n >> 2;
+		while( n4-- ) {
+			a = _mm_add_ps( _mm_loadu_ps( src1 ), _mm_loadu_ps( src2 ) );
+			b = _mm_add_ps( _mm_loadu_ps( src1 + 4 ), _mm_loadu_ps( src2 + 4 ) );
+			a = _mm_add_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0 ) ), _mm_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+			_mm_storeu_ps( dst, _mm_mul_ps( a, quarter ) );
+			src1 += 8;
+			src2 += 8;
+			dst  += 4;
+		}
+
+		SIMD::pyrdownBox2x2_1f( dst, src1, src2, n & 0x3 );
+	}
+
+	void SIMDSSE2::pyrdownBox2x2_1u8( uint8_t* dst, const uint8_t* src1, const uint8_t* src2, size_t n ) const
+	{
+		const __m128i mask = _mm_set1_epi16( 0xff );
+		const __m128i two = _mm_set1_epi16( 2 );
+		__m128i a, b, lo, hi;
+
+		size_t n16 = n >> 4;
+		while( n16-- ) {
+			/* sum of horizontal pairs as 16 bit values */
+			a  = _mm_loadu_si128( ( __m128i* ) src1 );
+			b  = _mm_loadu_si128( ( __m128i* ) src2 );
+			lo = _mm_add_epi16( _mm_add_epi16( _mm_and_si128( a, mask ), _mm_srli_epi16( a, 8 ) ),
+								_mm_add_epi16( _mm_and_si128( b, mask ), _mm_srli_epi16( b, 8 ) ) );
+			a  = _mm_loadu_si128( ( __m128i* ) ( src1 + 16 ) );
+			b  = _mm_loadu_si128( ( __m128i* ) ( src2 + 16 ) );
+			hi = _mm_add_epi16( _mm_add_epi16( _mm_and_si128( a, mask ), _mm_srli_epi16( a, 8 ) ),
+								_mm_add_epi16( _mm_and_si128( b, mask ), _mm_srli_epi16( b, 8 ) ) );
+			lo = _mm_srli_epi16( _mm_add_epi16( lo, two ), 2 );
+			hi = _mm_srli_epi16( _mm_add_epi16( hi, two ), 2 );
+			_mm_storeu_si128( ( __m128i* ) dst, _mm_packus_epi16( lo, hi ) );
+			src1 += 32;
+			src2 += 32;
+			dst  += 16;
+		}
+
+		SIMD::pyrdownBox2x2_1u8( dst, src1, src2, n & 0xf );
+	}
+
+	void SIMDSSE2::warpBilinear1f( float* dst, const float* coords, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fillcolor, size_t n ) const
+	{
+		const uint8_t* src = ( const uint8_t* ) _src;
+		const __m128i endx = _mm_set1_epi32( ( int ) srcWidth - 1 );
+		const __m128i endy = _mm_set1_epi32( ( int ) srcHeight - 1 );
+		const __m128i minus1 = _mm_set1_epi32( -1 );
+		const __m128 zerof = _mm_setzero_ps();
+		int lx[ 4 ] __attribute__ ( ( aligned ( 16 ) ) );
+		int ly[ 4 ] __attribute__ ( ( aligned ( 16 ) ) );
+
+		size_t n4 = n >> 2;
+		while( n4-- ) {
+			__m128 c0 = _mm_loadu_ps( coords );
+			__m128 c1 = _mm_loadu_ps( coords + 4 );
+			__m128 fx = _mm_shuffle_ps( c0, c1, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+			__m128 fy = _mm_shuffle_ps( c0, c1, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+			/* same floor as the scalar version: truncate and subtract one for negative values */
+			__m128i ix = _mm_add_epi32( _mm_cvttps_epi32( fx ), _mm_srai_epi32( _mm_castps_si128( fx ), 31 ) );
+			__m128i iy = _mm_add_epi32( _mm_cvttps_epi32( fy ), _mm_srai_epi32( _mm_castps_si128( fy ), 31 ) );
+			__m128i inside = _mm_and_si128( _mm_and_si128( _mm_cmpgt_epi32( ix, minus1 ), _mm_cmplt_epi32( ix, endx ) ),
+											_mm_and_si128( _mm_cmpgt_epi32( iy, minus1 ), _mm_cmplt_epi32( iy, endy ) ) );
+
+			if( _mm_movemask_epi8( inside ) != 0xffff ) {
+				SIMD::warpBilinear1f( dst, coords, _src, srcStride, srcWidth, srcHeight, fillcolor, 4 );
+			} else {
+				_mm_store_si128( ( __m128i* ) lx, ix );
+				_mm_store_si128( ( __m128i* ) ly, iy );
+				const float* p[ 4 ];
+				for( size_t i = 0; i < 4; i++ )
+					p[ i ] = ( const float* ) ( src + srcStride * ly[ i ] + sizeof( float ) * lx[ i ] );
+
+				__m128 ab0 = _mm_loadh_pi( _mm_loadl_pi( zerof, ( const __m64* ) p[ 0 ] ), ( const __m64* ) p[ 1 ] );
+				__m128 ab1 = _mm_loadh_pi( _mm_loadl_pi( zerof, ( const __m64* ) p[ 2 ] ), ( const __m64* ) p[ 3 ] );
+				__m128 cd0 = _mm_loadh_pi( _mm_loadl_pi( zerof, ( const __m64* ) ( ( const uint8_t* ) p[ 0 ] + srcStride ) ), ( const __m64* ) ( ( const uint8_t* ) p[ 1 ] + srcStride ) );
+				__m128 cd1 = _mm_loadh_pi( _mm_loadl_pi( zerof, ( const __m64* ) ( ( const uint8_t* ) p[ 2 ] + srcStride ) ), ( const __m64* ) ( ( const uint8_t* ) p[ 3 ] + srcStride ) );
+				__m128 va = _mm_shuffle_ps( ab0, ab1, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+				__m128 vb = _mm_shuffle_ps( ab0, ab1, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+				__m128 vc = _mm_shuffle_ps( cd0, cd1, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+				__m128 vd = _mm_shuffle_ps( cd0, cd1, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+
+				__m128 alpha1 = _mm_sub_ps( fx, _mm_cvtepi32_ps( ix ) );
+				__m128 alpha2 = _mm_sub_ps( fy, _mm_cvtepi32_ps( iy ) );
+				__m128 v1 = _mm_add_ps( va, _mm_mul_ps( _mm_sub_ps( vb, va ), alpha1 ) );
+				__m128 v2 = _mm_add_ps( vc, _mm_mul_ps( _mm_sub_ps( vd, vc ), alpha1 ) );
+				_mm_storeu_ps( dst, _mm_add_ps( v1, _mm_mul_ps( _mm_sub_ps( v2, v1 ), alpha2 ) ) );
+			}
+			coords += 8;
+			dst	   += 4;
+		}
+
+		SIMD::warpBilinear1f( dst, coords, _src, srcStride, srcWidth, srcHeight, fillcolor, n & 0x3 );
+	}
+
+	/* mask of the 8 positions in xy with the complete 2x2 neighbourhood inside the source */
+	static inline int _remapInside8( const int16_t* xy, __m128i endx, __m128i endy )
+	{
+		const __m128i minus1 = _mm_set1_epi16( -1 );
+		__m128i p0 = _mm_loadu_si128( ( const __m128i* ) xy );
+		__m128i p1 = _mm_loadu_si128( ( const __m128i* ) ( xy + 8 ) );
+		__m128i x = _mm_packs_epi32( _mm_srai_epi32( _mm_slli_epi32( p0, 16 ), 16 ), _mm_srai_epi32( _mm_slli_epi32( p1, 16 ), 16 ) );
+		__m128i y = _mm_packs_epi32( _mm_srai_epi32( p0, 16 ), _mm_srai_epi32( p1, 16 ) );
+		__m128i inside = _mm_and_si128( _mm_and_si128( _mm_cmpgt_epi16( x, minus1 ), _mm_cmplt_epi16( x, endx ) ),
+										_mm_and_si128( _mm_cmpgt_epi16( y, minus1 ), _mm_cmplt_epi16( y, endy ) ) );
+		return _mm_movemask_epi8( inside );
+	}
+
+	void SIMDSSE2::remapBilinear1f( float* dst, const int16_t* xy, const uint16_t* frac, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fill, size_t n ) const
+	{
+		const uint8_t* src = ( const uint8_t* ) _src;
+		const __m128i endx = _mm_set1_epi16( ( int16_t ) ( srcWidth - 1 ) );
+		const __m128i endy = _mm_set1_epi16( ( int16_t ) ( srcHeight - 1 ) );
+		const __m128i mask5 = _mm_set1_epi16( 0x1f );
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps( 1.0f / 32.0f );
+		const __m128 zerof = _mm_setzero_ps();
+
+		size_t n8 = n >> 3;
+		while( n8-- ) {
+			if( _remapInside8( xy, endx, endy ) != 0xffff ) {
+				SIMD::remapBilinear1f( dst, xy, frac, _src, srcStride, srcWidth, srcHeight, fill, 8 );
+			} else {
+				__m128i f  = _mm_loadu_si128( ( const __m128i* ) frac );
+				__m128i ax = _mm_and_si128( f, mask5 );
+				__m128i ay = _mm_and_si128( _mm_srli_epi16( f, 5 ), mask5 );
+				for( size_t k = 0; k < 2; k++ ) {
+					/* gather the horizontal neighbours as pairs and deinterleave */
+					__m128 ab0, ab1, cd0, cd1;
+					const float* p[ 4 ];
+					for( size_t i = 0; i < 4; i++ )
+						p[ i ] = ( const float* ) ( src + srcStride * xy[ 8 * k + 2 * i + 1 ] + sizeof( float ) * xy[ 8 * k + 2 * i ] );
+					ab0 = _mm_loadh_pi( _mm_loadl_pi( zerof, ( const __m64* ) p[ 0 ] ), ( const __m64* ) p[ 1 ] );
+					ab1 = _mm_loadh_pi( _mm_loadl_pi( zerof, ( const __m64* ) p[ 2 ] ), ( const __m64* ) p[ 3 ] );
+					cd0 = _mm_loadh_pi( _mm_loadl_pi( zerof, ( const __m64* ) ( ( const uint8_t* ) p[ 0 ] + srcStride ) ), ( const __m64* ) ( ( const uint8_t* ) p[ 1 ] + srcStride ) );
+					cd1 = _mm_loadh_pi( _mm_loadl_pi( zerof, ( const __m64* ) ( ( const uint8_t* ) p[ 2 ] + srcStride ) ), ( const __m64* ) ( ( const uint8_t* ) p[ 3 ] + srcStride ) );
+					__m128 va = _mm_shuffle_ps( ab0, ab1, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+					__m128 vb = _mm_shuffle_ps( ab0, ab1, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+					__m128 vc = _mm_shuffle_ps( cd0, cd1, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+					__m128 vd = _mm_shuffle_ps( cd0, cd1, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+
+					__m128 alpha1 = _mm_mul_ps( _mm_cvtepi32_ps( k ? _mm_unpackhi_epi16( ax, zero ) : _mm_unpacklo_epi16( ax, zero ) ), scale );
+					__m128 alpha2 = _mm_mul_ps( _mm_cvtepi32_ps( k ? _mm_unpackhi_epi16( ay, zero ) : _mm_unpacklo_epi16( ay, zero ) ), scale );
+					__m128 v1 = _mm_add_ps( va, _mm_mul_ps( _mm_sub_ps( vb, va ), alpha1 ) );
+					__m128 v2 = _mm_add_ps( vc, _mm_mul_ps( _mm_sub_ps( vd, vc ), alpha1 ) );
+					_mm_storeu_ps( dst + 4 * k, _mm_add_ps( v1, _mm_mul_ps( _mm_sub_ps( v2, v1 ), alpha2 ) ) );
+				}
+			}
+			xy	 += 16;
+			frac += 8;
+			dst	 += 8;
+		}
+
+		SIMD::remapBilinear1f( dst, xy, frac, _src, srcStride, srcWidth, srcHeight, fill, n & 0x7 );
+	}
+
+	void SIMDSSE2::remapBilinear1u8( uint8_t* dst, const int16_t* xy, const uint16_t* frac, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint8_t fill, size_t n ) const
+	{
+		const __m128i endx = _mm_set1_epi16( ( int16_t ) ( srcWidth - 1 ) );
+		const __m128i endy = _mm_set1_epi16( ( int16_t ) ( srcHeight - 1 ) );
+		const __m128i mask5 = _mm_set1_epi16( 0x1f );
+		const __m128i c32 = _mm_set1_epi16( 32 );
+		const __m128i round = _mm_set1_epi32( 512 );
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i mask8 = _mm_set1_epi16( 0xff );
+		__m128i f, ax, ay, wy, ab, cd, va, vb, vc, vd, v1, v2, lo, hi;
+
+		size_t n8 = n >> 3;
+		while( n8-- ) {
+			if( _remapInside8( xy, endx, endy ) != 0xffff ) {
+				SIMD::remapBilinear1u8( dst, xy, frac, src, srcStride, srcWidth, srcHeight, fill, 8 );
+			} else {
+				/* gather the horizontal neighbours as one 16 bit load each */
+#define REMAP_PTR( i ) ( src + srcStride * xy[ 2 * i + 1 ] + xy[ 2 * i ] )
+#define REMAP_PAIR( i, off ) *( ( const uint16_t* ) ( REMAP_PTR( i ) + off ) )
+				ab = _mm_set_epi16( REMAP_PAIR( 7, 0 ), REMAP_PAIR( 6, 0 ), REMAP_PAIR( 5, 0 ), REMAP_PAIR( 4, 0 ),
+									REMAP_PAIR( 3, 0 ), REMAP_PAIR( 2, 0 ), REMAP_PAIR( 1, 0 ), REMAP_PAIR( 0, 0 ) );
+				cd = _mm_set_epi16( REMAP_PAIR( 7, srcStride ), REMAP_PAIR( 6, srcStride ), REMAP_PAIR( 5, srcStride ), REMAP_PAIR( 4, srcStride ),
+									REMAP_PAIR( 3, srcStride ), REMAP_PAIR( 2, srcStride ), REMAP_PAIR( 1, srcStride ), REMAP_PAIR( 0, srcStride ) );
+#undef REMAP_PAIR
+#undef REMAP_PTR
+				va = _mm_and_si128( ab, mask8 );
+				vb = _mm_srli_epi16( ab, 8 );
+				vc = _mm_and_si128( cd, mask8 );
+				vd = _mm_srli_epi16( cd, 8 );
+
+				f  = _mm_loadu_si128( ( const __m128i* ) frac );
+				ax = _mm_and_si128( f, mask5 );
+				ay = _mm_and_si128( _mm_srli_epi16( f, 5 ), mask5 );
+
+				/* horizontal interpolation in 16 bit, a * 32 + ( b - a ) * ax <= 8160 */
+				v1 = _mm_add_epi16( _mm_slli_epi16( va, 5 ), _mm_mullo_epi16( _mm_sub_epi16( vb, va ), ax ) );
+				v2 = _mm_add_epi16( _mm_slli_epi16( vc, 5 ), _mm_mullo_epi16( _mm_sub_epi16( vd, vc ), ax ) );
+
+				/* vertical interpolation v1 * ( 32 - ay ) + v2 * ay in 32 bit */
+				wy = _mm_sub_epi16( c32, ay );
+				lo = _mm_madd_epi16( _mm_unpacklo_epi16( v1, v2 ), _mm_unpacklo_epi16( wy, ay ) );
+				hi = _mm_madd_epi16( _mm_unpackhi_epi16( v1, v2 ), _mm_unpackhi_epi16( wy, ay ) );
+				lo = _mm_srai_epi32( _mm_add_epi32( lo, round ), 10 );
+				hi = _mm_srai_epi32( _mm_add_epi32( hi, round ), 10 );
+				_mm_storel_epi64( ( __m128i* ) dst, _mm_packus_epi16( _mm_packs_epi32( lo, hi ), zero ) );
+			}
+			xy	 += 16;
+			frac += 8;
+			dst	 += 8;
+		}
+
+		SIMD::remapBilinear1u8( dst, xy, frac, src, srcStride, srcWidth, srcHeight, fill, n & 0x7 );
+	}
+
+	void SIMDSSE2::remapBilinear4u8( uint8_t* dst, const int16_t* xy, const uint16_t* frac, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const
+	{
+		const int endx = ( int ) srcWidth - 1;
+		const int endy = ( int ) srcHeight - 1;
+		const __m128i c32 = _mm_set1_epi16( 32 );
+		const __m128i round = _mm_set1_epi32( 512 );
+		const __m128i zero = _mm_setzero_si128();
+		__m128i ax, ay, wy, va, vb, vc, vd, v1, v2, lo, hi;
+
+		/* two pixels per iteration, each 16 bit vector holds the four channels of both */
+		size_t n2 = n >> 1;
+		while( n2-- ) {
+			if( xy[ 0 ] < 0 || xy[ 0 ] >= endx || xy[ 1 ] < 0 || xy[ 1 ] >= endy ||
+			    xy[ 2 ] < 0 || xy[ 2 ] >= endx || xy[ 3 ] < 0 || xy[ 3 ] >= endy ) {
+				SIMD::remapBilinear4u8( dst, xy, frac, src, srcStride, srcWidth, srcHeight, fill, 2 );
+			} else {
+				const uint32_t* p0 = ( const uint32_t* ) ( src + srcStride * xy[ 1 ] + sizeof( uint32_t ) * xy[ 0 ] );
+				const uint32_t* p1 = ( const uint32_t* ) ( src + srcStride * xy[ 3 ] + sizeof( uint32_t ) * xy[ 2 ] );
+				const uint32_t* q0 = ( const uint32_t* ) ( ( const uint8_t* ) p0 + srcStride );
+				const uint32_t* q1 = ( const uint32_t* ) ( ( const uint8_t* ) p1 + srcStride );
+
+				va = _mm_unpacklo_epi8( _mm_unpacklo_epi32( _mm_cvtsi32_si128( p0[ 0 ] ), _mm_cvtsi32_si128( p1[ 0 ] ) ), zero );
+				vb = _mm_unpacklo_epi8( _mm_unpacklo_epi32( _mm_cvtsi32_si128( p0[ 1 ] ), _mm_cvtsi32_si128( p1[ 1 ] ) ), zero );
+				vc = _mm_unpacklo_epi8( _mm_unpacklo_epi32( _mm_cvtsi32_si128( q0[ 0 ] ), _mm_cvtsi32_si128( q1[ 0 ] ) ), zero );
+				vd = _mm_unpacklo_epi8( _mm_unpacklo_epi32( _mm_cvtsi32_si128( q0[ 1 ] ), _mm_cvtsi32_si128( q1[ 1 ] ) ), zero );
+
+				ax = _mm_unpacklo_epi64( _mm_set1_epi16( frac[ 0 ] & 0x1f ), _mm_set1_epi16( frac[ 1 ] & 0x1f ) );
+				ay = _mm_unpacklo_epi64( _mm_set1_epi16( ( frac[ 0 ] >> 5 ) & 0x1f ), _mm_set1_epi16( ( frac[ 1 ] >> 5 ) & 0x1f ) );
+
+				v1 = _mm_add_epi16( _mm_slli_epi16( va, 5 ), _mm_mullo_epi16( _mm_sub_epi16( vb, va ), ax ) );
+				v2 = _mm_add_epi16( _mm_slli_epi16( vc, 5 ), _mm_mullo_epi16( _mm_sub_epi16( vd, vc ), ax ) );
+
+				wy = _mm_sub_epi16( c32, ay );
+				lo = _mm_madd_epi16( _mm_unpacklo_epi16( v1, v2 ), _mm_unpacklo_epi16( wy, ay ) );
+				hi = _mm_madd_epi16( _mm_unpackhi_epi16( v1, v2 ), _mm_unpackhi_epi16( wy, ay ) );
+				lo = _mm_srai_epi32( _mm_add_epi32( lo, round ), 10 );
+				hi = _mm_srai_epi32( _mm_add_epi32( hi, round ), 10 );
+				_mm_storel_epi64( ( __m128i* ) dst, _mm_packus_epi16( _mm_packs_epi32( lo, hi ), zero ) );
+			}
+			xy	 += 4;
+			frac += 2;
+			dst	 += 8;
+		}
+
+		SIMD::remapBilinear4u8( dst, xy, frac, src, srcStride, srcWidth, srcHeight, fill, n & 0x1 );
+	}
+
+	void SIMDSSE2::warpBilinear4f( float* dst, const float* coords, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* fillcolor, size_t n ) const
+	{
+		const uint8_t* src = ( const uint8_t* ) _src;
+		const float endx = ( float ) srcWidth - 1.0f;
+		const float endy = ( float ) srcHeight - 1.0f;
+
+		while( n-- ) {
+			float fx = coords[ 0 ];
+			float fy = coords[ 1 ];
+			if( fx >= 0.0f && fx < endx && fy >= 0.0f && fy < endy ) {
+				int lx = ( int ) fx;
+				int ly = ( int ) fy;
+				__m128 alpha1 = _mm_set1_ps( fx - ( float ) lx );
+				__m128 alpha2 = _mm_set1_ps( fy - ( float ) ly );
+				const float* p1 = ( const float* ) ( src + srcStride * ly ) + 4 * lx;
+				const float* p2 = ( const float* ) ( ( const uint8_t* ) p1 + srcStride );
+				__m128 va = _mm_loadu_ps( p1 );
+				__m128 vb = _mm_loadu_ps( p1 + 4 );
+				__m128 vc = _mm_loadu_ps( p2 );
+				__m128 vd = _mm_loadu_ps( p2 + 4 );
+				__m128 v1 = _mm_add_ps( va, _mm_mul_ps( _mm_sub_ps( vb, va ), alpha1 ) );
+				__m128 v2 = _mm_add_ps( vc, _mm_mul_ps( _mm_sub_ps( vd, vc ), alpha1 ) );
+				_mm_storeu_ps( dst, _mm_add_ps( v1, _mm_mul_ps( _mm_sub_ps( v2, v1 ), alpha2 ) ) );
+			} else {
+				SIMD::warpBilinear4f( dst, coords, _src, srcStride, srcWidth, srcHeight, fillcolor, 1 );
+			}
+			coords += 2;
+			dst += 4;
+		}
+	}
+
+	void SIMDSSE2::warpProjectiveCoords_f( float* coords, const float* point, const float* delta, size_t n ) const
+	{
+		const __m128 px = _mm_set1_ps( point[ 0 ] );
+		const __m128 py = _mm_set1_ps( point[ 1 ] );
+		const __m128 pz = _mm_set1_ps( point[ 2 ] );
+		const __m128 dx = _mm_set1_ps( delta[ 0 ] );
+		const __m128 dy = _mm_set1_ps( delta[ 1 ] );
+		const __m128 dz = _mm_set1_ps( delta[ 2 ] );
+		const __m128 one = _mm_set1_ps( 1.0f );
+		const __m128 four = _mm_set1_ps( 4.0f );
+		__m128 fi = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+		__m128 x, y, inv;
+
+		size_t n4 = n >> 2;
+		for( size_t i = 0; i < n4; i++ ) {
+			x = _mm_add_ps( px, _mm_mul_ps( fi, dx ) );
+			y = _mm_add_ps( py, _mm_mul_ps( fi, dy ) );
+			inv = _mm_div_ps( one, _mm_add_ps( pz, _mm_mul_ps( fi, dz ) ) );
+			x = _mm_mul_ps( x, inv );
+			y = _mm_mul_ps( y, inv );
+			_mm_storeu_ps( coords, _mm_unpacklo_ps( x, y ) );
+			_mm_storeu_ps( coords + 4, _mm_unpackhi_ps( x, y ) );
+			fi = _mm_add_ps( fi, four );
+			coords += 8;
+		}
+
+		for( size_t i = n4 << 2; i < n; i++ ) {
+			float f = ( float ) i;
+			float sx = point[ 0 ] + f * delta[ 0 ];
+			float sy = point[ 1 ] + f * delta[ 1 ];
+			float sinv = 1.0f / ( point[ 2 ] + f * delta[ 2 ] );
+			*coords++ = sx * sinv;
+			*coords++ = sy * sinv;
+		}
+	}
+
+	/* Catmull-Rom weights, same operations as in SIMD */
+	static inline void _cubicWeights( float* w, float t )
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+		w[ 0 ] = ( -0.5f * t3 + t2 ) - 0.5f * t;
+		w[ 1 ] = ( 1.5f * t3 - 2.5f * t2 ) + 1.0f;
+		w[ 2 ] = ( -1.5f * t3 + 2.0f * t2 ) + 0.5f * t;
+		w[ 3 ] = 0.5f * t3 - 0.5f * t2;
+	}
+
+	static inline void _mm_cubic_weights( __m128& w0, __m128& w1, __m128& w2, __m128& w3, __m128 t )
+	{
+		const __m128 c0_5 = _mm_set1_ps( 0.5f );
+		const __m128 c1_5 = _mm_set1_ps( 1.5f );
+		__m128 t2 = _mm_mul_ps( t, t );
+		__m128 t3 = _mm_mul_ps( t2, t );
+		w0 = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( -0.5f ), t3 ), t2 ), _mm_mul_ps( c0_5, t ) );
+		w1 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( c1_5, t3 ), _mm_mul_ps( _mm_set1_ps( 2.5f ), t2 ) ), _mm_set1_ps( 1.0f ) );
+		w2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( -1.5f ), t3 ), _mm_mul_ps( _mm_set1_ps( 2.0f ), t2 ) ), _mm_mul_ps( c0_5, t ) );
+		w3 = _mm_sub_ps( _mm_mul_ps( c0_5, t3 ), _mm_mul_ps( c0_5, t2 ) );
+	}
+
+	void SIMDSSE2::warpBicubic1f( float* dst, const float* coords, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fill, size_t n ) const
+	{
+		const uint8_t* src = ( const uint8_t* ) _src;
+		const __m128 one = _mm_set1_ps( 1.0f );
+		const __m128 endx = _mm_set1_ps( ( float ) srcWidth - 2.0f );
+		const __m128 endy = _mm_set1_ps( ( float ) srcHeight - 2.0f );
+		int lx[ 4 ] __attribute__ ( ( aligned ( 16 ) ) );
+		int ly[ 4 ] __attribute__ ( ( aligned ( 16 ) ) );
+		__m128 wx[ 4 ], wy[ 4 ];
+
+		size_t n4 = n >> 2;
+		while( n4-- ) {
+			__m128 c0 = _mm_loadu_ps( coords );
+			__m128 c1 = _mm_loadu_ps( coords + 4 );
+			__m128 fx = _mm_shuffle_ps( c0, c1, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+			__m128 fy = _mm_shuffle_ps( c0, c1, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+			/* all taps inside, the positions are positive and truncation is the floor */
+			__m128 inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( fx, one ), _mm_cmplt_ps( fx, endx ) ),
+										_mm_and_ps( _mm_cmpge_ps( fy, one ), _mm_cmplt_ps( fy, endy ) ) );
+
+			if( _mm_movemask_ps( inside ) != 0xf ) {
+				SIMD::warpBicubic1f( dst, coords, _src, srcStride, srcWidth, srcHeight, fill, 4 );
+			} else {
+				__m128i ix = _mm_cvttps_epi32( fx );
+				__m128i iy = _mm_cvttps_epi32( fy );
+				_mm_store_si128( ( __m128i* ) lx, ix );
+				_mm_store_si128( ( __m128i* ) ly, iy );
+				_mm_cubic_weights( wx[ 0 ], wx[ 1 ], wx[ 2 ], wx[ 3 ], _mm_sub_ps( fx, _mm_cvtepi32_ps( ix ) ) );
+				_mm_cubic_weights( wy[ 0 ], wy[ 1 ], wy[ 2 ], wy[ 3 ], _mm_sub_ps( fy, _mm_cvtepi32_ps( iy ) ) );
+				/* one vector of tap weights per pixel */
+				_MM_TRANSPOSE4_PS( wx[ 0 ], wx[ 1 ], wx[ 2 ], wx[ 3 ] );
+				_MM_TRANSPOSE4_PS( wy[ 0 ], wy[ 1 ], wy[ 2 ], wy[ 3 ] );
+
+				for( size_t i = 0; i < 4; i++ ) {
+					const uint8_t* p = src + srcStride * ( ly[ i ] - 1 ) + sizeof( float ) * ( lx[ i ] - 1 );
+					__m128 w = wy[ i ];
+					__m128 acc = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( ( const float* ) p ), _mm_shuffle_ps( w, w, 0x00 ) ),
+											 _mm_mul_ps( _mm_loadu_ps( ( const float* ) ( p + srcStride ) ), _mm_shuffle_ps( w, w, 0x55 ) ) );
+					acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( ( const float* ) ( p + 2 * srcStride ) ), _mm_shuffle_ps( w, w, 0xaa ) ) );
+					acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( ( const float* ) ( p + 3 * srcStride ) ), _mm_shuffle_ps( w, w, 0xff ) ) );
+					acc = _mm_mul_ps( acc, wx[ i ] );
+					acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+					_mm_store_ss( dst + i, _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 0x01 ) ) );
+				}
+			}
+			coords += 8;
+			dst += 4;
+		}
+
+		SIMD::warpBicubic1f( dst, coords, _src, srcStride, srcWidth, srcHeight, fill, n & 0x3 );
+	}
+
+	void SIMDSSE2::warpBicubic4f( float* dst, const float* coords, const float* _src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* fill, size_t n ) const
+	{
+		const uint8_t* src = ( const uint8_t* ) _src;
+		const float endx = ( float ) srcWidth - 2.0f;
+		const float endy = ( float ) srcHeight - 2.0f;
+		float wx[ 4 ], wy[ 4 ];
+
+		while( n-- ) {
+			float fx = coords[ 0 ];
+			float fy = coords[ 1 ];
+			if( fx >= 1.0f && fx < endx && fy >= 1.0f && fy < endy ) {
+				int lx = ( int ) fx;
+				int ly = ( int ) fy;
+				_cubicWeights( wx, fx - ( float ) lx );
+				_cubicWeights( wy, fy - ( float ) ly );
+				const __m128 wx0 = _mm_set1_ps( wx[ 0 ] ), wx1 = _mm_set1_ps( wx[ 1 ] ), wx2 = _mm_set1_ps( wx[ 2 ] ), wx3 = _mm_set1_ps( wx[ 3 ] );
+				const uint8_t* p = src + srcStride * ( ly - 1 ) + sizeof( float ) * 4 * ( lx - 1 );
+				__m128 v[ 4 ];
+				for( size_t r = 0; r < 4; r++ ) {
+					const float* row = ( const float* ) p;
+					v[ r ] = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( row ), wx0 ), _mm_mul_ps( _mm_loadu_ps( row + 4 ), wx1 ) );
+					v[ r ] = _mm_add_ps( v[ r ], _mm_mul_ps( _mm_loadu_ps( row + 8 ), wx2 ) );
+					v[ r ] = _mm_add_ps( v[ r ], _mm_mul_ps( _mm_loadu_ps( row + 12 ), wx3 ) );
+					p += srcStride;
+				}
+				__m128 res = _mm_add_ps( _mm_mul_ps( v[ 0 ], _mm_set1_ps( wy[ 0 ] ) ), _mm_mul_ps( v[ 1 ], _mm_set1_ps( wy[ 1 ] ) ) );
+				res = _mm_add_ps( res, _mm_mul_ps( v[ 2 ], _mm_set1_ps( wy[ 2 ] ) ) );
+				res = _mm_add_ps( res, _mm_mul_ps( v[ 3 ], _mm_set1_ps( wy[ 3 ] ) ) );
+				_mm_storeu_ps( dst, res );
+			} else {
+				SIMD::warpBicubic4f( dst, coords, _src, srcStride, srcWidth, srcHeight, fill, 1 );
+			}
+			coords += 2;
+			dst += 4;
+		}
+	}
+
+	void SIMDSSE2::warpBicubic4u8( uint8_t* dst, const float* coords, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const
+	{
+		const float endx = ( float ) srcWidth - 2.0f;
+		const float endy = ( float ) srcHeight - 2.0f;
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 zerof = _mm_setzero_ps();
+		const __m128 c255 = _mm_set1_ps( 255.0f );
+		const __m128 c0_5 = _mm_set1_ps( 0.5f );
+		float wx[ 4 ], wy[ 4 ];
+
+		while( n-- ) {
+			float fx = coords[ 0 ];
+			float fy = coords[ 1 ];
+			if( fx >= 1.0f && fx < endx && fy >= 1.0f && fy < endy ) {
+				int lx = ( int ) fx;
+				int ly = ( int ) fy;
+				_cubicWeights( wx, fx - ( float ) lx );
+				_cubicWeights( wy, fy - ( float ) ly );
+				const __m128 wx0 = _mm_set1_ps( wx[ 0 ] ), wx1 = _mm_set1_ps( wx[ 1 ] ), wx2 = _mm_set1_ps( wx[ 2 ] ), wx3 = _mm_set1_ps( wx[ 3 ] );
+				const uint8_t* p = src + srcStride * ( ly - 1 ) + 4 * ( lx - 1 );
+				__m128 v[ 4 ];
+				for( size_t r = 0; r < 4; r++ ) {
+					__m128i px = _mm_loadu_si128( ( const __m128i* ) p );
+					__m128i lo = _mm_unpacklo_epi8( px, zero );
+					__m128i hi = _mm_unpackhi_epi8( px, zero );
+					v[ r ] = _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ), wx0 ),
+										 _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ), wx1 ) );
+					v[ r ] = _mm_add_ps( v[ r ], _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ), wx2 ) );
+					v[ r ] = _mm_add_ps( v[ r ], _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ), wx3 ) );
+					p += srcStride;
+				}
+				__m128 res = _mm_add_ps( _mm_mul_ps( v[ 0 ], _mm_set1_ps( wy[ 0 ] ) ), _mm_mul_ps( v[ 1 ], _mm_set1_ps( wy[ 1 ] ) ) );
+				res = _mm_add_ps( res, _mm_mul_ps( v[ 2 ], _mm_set1_ps( wy[ 2 ] ) ) );
+				res = _mm_add_ps( res, _mm_mul_ps( v[ 3 ], _mm_set1_ps( wy[ 3 ] ) ) );
+				res = _mm_add_ps( _mm_min_ps( _mm_max_ps( res, zerof ), c255 ), c0_5 );
+				__m128i out = _mm_packs_epi32( _mm_cvttps_epi32( res ), zero );
+				*( ( uint32_t* ) dst ) = ( uint32_t ) _mm_cvtsi128_si32( _mm_packus_epi16( out, zero ) );
+			} else {
+				SIMD::warpBicubic4u8( dst, coords, src, srcStride, srcWidth, srcHeight, fill, 1 );
+			}
+			coords += 2;
+			dst += 4;
+		}
+	}
+
+	float SIMDSSE2::costTruncatedL1Line8f( float& wsum, const float* ref, const float* weights, const float* src, size_t srcWidth,
+										   float x, float dx, const float* truncation, const float* scale, size_t n ) const
+	{
+		const __m128 signmask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+		const __m128 t0 = _mm_loadu_ps( truncation ), t1 = _mm_loadu_ps( truncation + 4 );
+		const __m128 s0 = _mm_loadu_ps( scale ), s1 = _mm_loadu_ps( scale + 4 );
+		const float width = ( float ) srcWidth;
+		__m128 acc = _mm_setzero_ps();
+		float ws = 0.0f;
+
+		/* the eight channels of one sample fill two registers */
+		for( size_t i = 0; i < n; i++, x += dx, ref += 8 ) {
+			if( x < 0.0f || x >= width )
+				continue;
+			size_t x0 = ( size_t ) x;
+			size_t x1 = x0 + 1 < srcWidth ? x0 + 1 : x0;
+			const __m128 a = _mm_set1_ps( x - ( float ) x0 );
+			const float* p0 = src + 8 * x0;
+			const float* p1 = src + 8 * x1;
+
+			__m128 lo = _mm_loadu_ps( p0 );
+			__m128 hi = _mm_loadu_ps( p0 + 4 );
+			lo = _mm_add_ps( lo, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( p1 ), lo ), a ) );
+			hi = _mm_add_ps( hi, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( p1 + 4 ), hi ), a ) );
+			lo = _mm_min_ps( _mm_and_ps( _mm_sub_ps( _mm_loadu_ps( ref ), lo ), signmask ), t0 );
+			hi = _mm_min_ps( _mm_and_ps( _mm_sub_ps( _mm_loadu_ps( ref + 4 ), hi ), signmask ), t1 );
+
+			const __m128 w = _mm_set1_ps( weights[ i ] );
+			acc = _mm_add_ps( acc, _mm_mul_ps( w, _mm_add_ps( _mm_mul_ps( lo, s0 ), _mm_mul_ps( hi, s1 ) ) ) );
+			ws += weights[ i ];
+		}
+
+		acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+		acc = _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 1 ) );
+		wsum += ws;
+		return _mm_cvtss_f32( acc );
+	}
+
+	void SIMDSSE2::IIR4Horizontal4f( float* dst, const float* src, size_t width, const float* n, const float* m,
+									 const float* d, float b1, float b2 ) const
+	{
+		const __m128 n0 = _mm_set1_ps( n[ 0 ] ), n1 = _mm_set1_ps( n[ 1 ] ), n2 = _mm_set1_ps( n[ 2 ] ), n3 = _mm_set1_ps( n[ 3 ] );
+		const __m128 m0 = _mm_set1_ps( m[ 0 ] ), m1 = _mm_set1_ps( m[ 1 ] ), m2 = _mm_set1_ps( m[ 2 ] ), m3 = _mm_set1_ps( m[ 3 ] );
+		const __m128 d0 = _mm_set1_ps( d[ 0 ] ), d1 = _mm_set1_ps( d[ 1 ] ), d2 = _mm_set1_ps( d[ 2 ] ), d3 = _mm_set1_ps( d[ 3 ] );
+		__m128 x0, x1, x2, x3, xc, y0, y1, y2, y3, v;
+		const float* px;
+		float* py;
+
+		/* causal pass */
+		px = src;
+		py = dst;
+		x0 = x1 = x2 = _mm_loadu_ps( px );
+		y0 = y1 = y2 = y3 = _mm_mul_ps( x0, _mm_set1_ps( b1 ) );
+		for( size_t i = 0; i < width; i++ ) {
+			xc = _mm_loadu_ps( px );
+			v = _mm_add_ps( _mm_add_ps( _mm_mul_ps( n0, xc ), _mm_mul_ps( n1, x0 ) ), _mm_add_ps( _mm_mul_ps( n2, x1 ), _mm_mul_ps( n3, x2 ) ) );
+			v = _mm_sub_ps( v, _mm_add_ps( _mm_add_ps( _mm_mul_ps( d0, y0 ), _mm_mul_ps( d1, y1 ) ), _mm_add_ps( _mm_mul_ps( d2, y2 ), _mm_mul_ps( d3, y3 ) ) ) );
+			x2 = x1; x1 = x0; x0 = xc;
+			y3 = y2; y2 = y1; y1 = y0; y0 = v;
+			_mm_storeu_ps( py, v );
+			px += 4;
+			py += 4;
+		}
+
+		/* anti-causal pass, the result at i depends on the inputs after i */
+		px = src + 4 * ( width - 1 );
+		py = dst + 4 * ( width - 1 );
+		x0 = x1 = x2 = x3 = _mm_loadu_ps( px );
+		y0 = y1 = y2 = y3 = _mm_mul_ps( x0, _mm_set1_ps( b2 ) );
+		for( size_t i = 0; i < width; i++ ) {
+			v = _mm_add_ps( _mm_add_ps( _mm_mul_ps( m0, x0 ), _mm_mul_ps( m1, x1 ) ), _mm_add_ps( _mm_mul_ps( m2, x2 ), _mm_mul_ps( m3, x3 ) ) );
+			v = _mm_sub_ps( v, _mm_add_ps( _mm_add_ps( _mm_mul_ps( d0, y0 ), _mm_mul_ps( d1, y1 ) ), _mm_add_ps( _mm_mul_ps( d2, y2 ), _mm_mul_ps( d3, y3 ) ) ) );
+			x3 = x2; x2 = x1; x1 = x0; x0 = _mm_loadu_ps( px );
+			y3 = y2; y2 = y1; y1 = y0; y0 = v;
+			_mm_storeu_ps( py, _mm_add_ps( _mm_loadu_ps( py ), v ) );
+			px -= 4;
+			py -= 4;
+		}
+	}
+
+	void SIMDSSE2::IIR4Vertical_f( float* dst, const float** x, const float** y, const float* n, const float* d, size_t width ) const
+	{
+		const __m128 n0 = _mm_set1_ps( n[ 0 ] ), n1 = _mm_set1_ps( n[ 1 ] ), n2 = _mm_set1_ps( n[ 2 ] ), n3 = _mm_set1_ps( n[ 3 ] );
+		const __m128 d0 = _mm_set1_ps( d[ 0 ] ), d1 = _mm_set1_ps( d[ 1 ] ), d2 = _mm_set1_ps( d[ 2 ] ), d3 = _mm_set1_ps( d[ 3 ] );
+		const float* x0 = x[ 0 ], *x1 = x[ 1 ], *x2 = x[ 2 ], *x3 = x[ 3 ];
+		const float* y0 = y[ 0 ], *y1 = y[ 1 ], *y2 = y[ 2 ], *y3 = y[ 3 ];
+		__m128 v;
+
+		/* four columns per register */
+		size_t n4 = width >> 2;
+		while( n4-- ) {
+			v = _mm_add_ps( _mm_add_ps( _mm_mul_ps( n0, _mm_loadu_ps( x0 ) ), _mm_mul_ps( n1, _mm_loadu_ps( x1 ) ) ),
+							_mm_add_ps( _mm_mul_ps( n2, _mm_loadu_ps( x2 ) ), _mm_mul_ps( n3, _mm_loadu_ps( x3 ) ) ) );
+			v = _mm_sub_ps( v, _mm_add_ps( _mm_add_ps( _mm_mul_ps( d0, _mm_loadu_ps( y0 ) ), _mm_mul_ps( d1, _mm_loadu_ps( y1 ) ) ),
+										   _mm_add_ps( _mm_mul_ps( d2, _mm_loadu_ps( y2 ) ), _mm_mul_ps( d3, _mm_loadu_ps( y3 ) ) ) ) );
+			_mm_storeu_ps( dst, v );
+			x0 += 4; x1 += 4; x2 += 4; x3 += 4;
+			y0 += 4; y1 += 4; y2 += 4; y3 += 4;
+			dst += 4;
+		}
+
+		const float* xt[ 4 ] = { x0, x1, x2, x3 };
+		const float* yt[ 4 ] = { y0, y1, y2, y3 };
+		SIMD::IIR4Vertical_f( dst, xt, yt, n, d, width & 0x3 );
+	}
+
 	void SIMDSSE2::harrisScore1f( float* dst, const float* boxdx2, const float* boxdy2, const float* boxdxy, float k, size_t width ) const
 	{
 		size_t x;
@@ -3917,7 +4644,7 @@ namespace cvt
 
 		if( ( ( size_t ) dst ) & 0xf || ( ( size_t ) boxdx2 ) & 0xf || ( ( size_t ) boxdy2 ) & 0xf || ( ( size_t ) boxdxy ) & 0xf   ) {
 			__m128 a, b, c, tmp1, tmp2;
-			for( x = 0 ; x < width; x += 4 ) {
+			for( x = 0; x + 4 <= width; x += 4 ) {
 				a = _mm_loadu_ps( boxdx2 );
 				b = _mm_loadu_ps( boxdy2 );
 				c = _mm_loadu_ps( boxdxy );
@@ -3932,7 +4659,7 @@ namespace cvt
 			}
 		} else {
 			__m128 a, b, c, tmp1, tmp2;
-			for( x = 0; x < width; x += 4 ) {
+			for( x = 0; x + 4 <= width; x += 4 ) {
 				a = _mm_load_ps( boxdx2 );
 				b = _mm_load_ps( boxdy2 );
 				c = _mm_load_ps( boxdxy );
@@ -3956,6 +4683,48 @@ namespace cvt
 		}
 	}
 
+	void SIMDSSE2::shiTomasiScore1f( float* dst, const float* boxdx2, const float* boxdy2, const float* boxdxdy, size_t width ) const
+	{
+		const __m128 half = _mm_set1_ps( 0.5f );
+		__m128 a, b, c, h;
+
+		for( size_t i = width >> 2; i--; ) {
+			a = _mm_loadu_ps( boxdx2 );
+			b = _mm_loadu_ps( boxdy2 );
+			c = _mm_loadu_ps( boxdxdy );
+			h = _mm_mul_ps( half, _mm_sub_ps( a, b ) );
+			h = _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( h, h ), _mm_mul_ps( c, c ) ) );
+			_mm_storeu_ps( dst, _mm_sub_ps( _mm_mul_ps( half, _mm_add_ps( a, b ) ), h ) );
+			dst += 4;
+			boxdx2 += 4;
+			boxdy2 += 4;
+			boxdxdy += 4;
+		}
+
+		SIMD::shiTomasiScore1f( dst, boxdx2, boxdy2, boxdxdy, width & 0x3 );
+	}
+
+	void SIMDSSE2::cornerTensor1f( float* dx2, float* dy2, float* dxdy, const float* prev, const float* cur, const float* next, size_t width ) const
+	{
+		__m128 dx, dy;
+
+		for( size_t i = width >> 2; i--; ) {
+			dx = _mm_sub_ps( _mm_loadu_ps( cur + 1 ), _mm_loadu_ps( cur - 1 ) );
+			dy = _mm_sub_ps( _mm_loadu_ps( next ), _mm_loadu_ps( prev ) );
+			_mm_storeu_ps( dx2, _mm_mul_ps( dx, dx ) );
+			_mm_storeu_ps( dy2, _mm_mul_ps( dy, dy ) );
+			_mm_storeu_ps( dxdy, _mm_mul_ps( dx, dy ) );
+			dx2 += 4;
+			dy2 += 4;
+			dxdy += 4;
+			prev += 4;
+			cur += 4;
+			next += 4;
+		}
+
+		SIMD::cornerTensor1f( dx2, dy2, dxdy, prev, cur, next, width & 0x3 );
+	}
+
 
 
 	float SIMDSSE2::harrisResponse1u8( const uint8_t* ptr, size_t stride, size_t , size_t , const float k ) const
@@ -4653,6 +5422,54 @@ static inline void boxFilterLineInternal1_f_to_u8( uint8_t *dst, const float *A,
 	}
 }
 
+void SIMDSSE2::prefixSumRow_f_to_f( float* dst, const float* src, const float* prev, size_t width, size_t channels ) const
+{
+	if( channels != 1 && channels != 4 ) {
+		SIMD::prefixSumRow_f_to_f( dst, src, prev, width, channels );
+		return;
+	}
+
+	__m128 x, sum;
+	sum = _mm_setzero_ps();
+
+	if( channels == 4 ) {
+		while( width-- ) {
+			sum = _mm_add_ps( sum, _mm_loadu_ps( src ) );
+			x = prev ? _mm_add_ps( sum, _mm_loadu_ps( prev ) ) : sum;
+			_mm_storeu_ps( dst, x );
+			src += 4;
+			dst += 4;
+			if( prev )
+				prev += 4;
+		}
+		return;
+	}
+
+	size_t n = width >> 2;
+	while( n-- ) {
+		/* scan inside the vector, then add the carry of the previous elements */
+		x = _mm_loadu_ps( src );
+		x = _mm_add_ps( x, _mm_castsi128_ps( _mm_slli_si128( _mm_castps_si128( x ), 4 ) ) );
+		x = _mm_add_ps( x, _mm_castsi128_ps( _mm_slli_si128( _mm_castps_si128( x ), 8 ) ) );
+		x = _mm_add_ps( x, sum );
+		sum = _mm_shuffle_ps( x, x, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+		if( prev ) {
+			x = _mm_add_ps( x, _mm_loadu_ps( prev ) );
+			prev += 4;
+		}
+		_mm_storeu_ps( dst, x );
+		src += 4;
+		dst += 4;
+	}
+
+	float s = _mm_cvtss_f32( sum );
+	n = width & 0x03;
+	while( n-- ) {
+		s += *src++;
+		*dst++ = prev ? s + *prev++ : s;
+	}
+}
+
 void SIMDSSE2::boxFilterPrefixSum1_f_to_u8( uint8_t* dst, size_t dststride, const float* src, size_t srcstride, size_t width, size_t height, size_t boxwidth, size_t boxheight ) const
 {
 	// FIXME
@@ -5697,6 +6514,138 @@ void SIMDSSE2::debayer_EVEN_RGGBu8_GRAYu8( uint32_t* _dst, const uint32_t* src1,
 
 }
 
+static inline void _debayer_store_RGBA16( uint8_t* dst, __m128i r, __m128i g, __m128i b )
+{
+	const __m128i alpha = _mm_set1_epi8( ( char ) 0xff );
+	__m128i rg, ba;
+
+	rg = _mm_unpacklo_epi8( r, g );
+	ba = _mm_unpacklo_epi8( b, alpha );
+	_mm_storeu_si128( ( __m128i* ) ( dst +  0 ), _mm_unpacklo_epi16( rg, ba ) );
+	_mm_storeu_si128( ( __m128i* ) ( dst + 16 ), _mm_unpackhi_epi16( rg, ba ) );
+	rg = _mm_unpackhi_epi8( r, g );
+	ba = _mm_unpackhi_epi8( b, alpha );
+	_mm_storeu_si128( ( __m128i* ) ( dst + 32 ), _mm_unpacklo_epi16( rg, ba ) );
+	_mm_storeu_si128( ( __m128i* ) ( dst + 48 ), _mm_unpackhi_epi16( rg, ba ) );
+}
+
+void SIMDSSE2::debayer_LINEARu8_RGBAu8( uint32_t* dst, const uint8_t** src, size_t n, size_t phase, bool redrow ) const
+{
+	const uint8_t* s0 = src[ 0 ];
+	const uint8_t* s1 = src[ 1 ];
+	const uint8_t* s2 = src[ 2 ];
+	/* mask selects the red/blue positions of the row */
+	const __m128i mask = _mm_set1_epi16( phase ? ( short ) 0xff00 : 0x00ff );
+	__m128i c, vert, horz, cross, diag, a, g, o;
+	size_t i = n >> 4;
+
+	while( i-- ) {
+		c     = _mm_loadu_si128( ( const __m128i* ) s1 );
+		vert  = _mm_avg_epu8( _mm_loadu_si128( ( const __m128i* ) s0 ), _mm_loadu_si128( ( const __m128i* ) s2 ) );
+		horz  = _mm_avg_epu8( _mm_loadu_si128( ( const __m128i* ) ( s1 - 1 ) ), _mm_loadu_si128( ( const __m128i* ) ( s1 + 1 ) ) );
+		cross = _mm_avg_epu8( vert, horz );
+		diag  = _mm_avg_epu8( _mm_avg_epu8( _mm_loadu_si128( ( const __m128i* ) ( s0 - 1 ) ), _mm_loadu_si128( ( const __m128i* ) ( s2 + 1 ) ) ),
+							  _mm_avg_epu8( _mm_loadu_si128( ( const __m128i* ) ( s0 + 1 ) ), _mm_loadu_si128( ( const __m128i* ) ( s2 - 1 ) ) ) );
+
+		a = _mm_or_si128( _mm_and_si128( mask, c ), _mm_andnot_si128( mask, horz ) );
+		g = _mm_or_si128( _mm_and_si128( mask, cross ), _mm_andnot_si128( mask, c ) );
+		o = _mm_or_si128( _mm_and_si128( mask, diag ), _mm_andnot_si128( mask, vert ) );
+
+		if( redrow )
+			_debayer_store_RGBA16( ( uint8_t* ) dst, a, g, o );
+		else
+			_debayer_store_RGBA16( ( uint8_t* ) dst, o, g, a );
+
+		s0 += 16;
+		s1 += 16;
+		s2 += 16;
+		dst += 16;
+	}
+
+	if( n & 0xf ) {
+		const uint8_t* tail[ 3 ] = { s0, s1, s2 };
+		SIMD::debayer_LINEARu8_RGBAu8( dst, tail, n & 0xf, phase, redrow );
+	}
+}
+
+static inline __m128i _debayer_load8( const uint8_t* src )
+{
+	return _mm_unpacklo_epi8( _mm_loadl_epi64( ( const __m128i* ) src ), _mm_setzero_si128() );
+}
+
+void SIMDSSE2::debayer_MHCu8_RGBAu8( uint32_t* dst, const uint8_t** src, size_t n, size_t phase, bool redrow ) const
+{
+	const uint8_t* r0 = src[ 0 ];
+	const uint8_t* r1 = src[ 1 ];
+	const uint8_t* r2 = src[ 2 ];
+	const uint8_t* r3 = src[ 3 ];
+	const uint8_t* r4 = src[ 4 ];
+	/* mask selects the red/blue positions of the row */
+	const __m128i mask = _mm_set1_epi32( phase ? ( int ) 0xffff0000 : 0x0000ffff );
+	const __m128i round = _mm_set1_epi16( 8 );
+	const __m128i alpha = _mm_set1_epi8( ( char ) 0xff );
+	__m128i c, ns, we, ns2, we2, ring2, diag, gA, dA, hG, vG, base, a, g, o, rg, ba;
+	size_t i = n >> 3;
+
+	/* Malvar-He-Cutler gradient corrected interpolation, weights scaled by 16 */
+	while( i-- ) {
+		c    = _debayer_load8( r2 );
+		ns   = _mm_add_epi16( _debayer_load8( r1 ), _debayer_load8( r3 ) );
+		we   = _mm_add_epi16( _debayer_load8( r2 - 1 ), _debayer_load8( r2 + 1 ) );
+		ns2  = _mm_add_epi16( _debayer_load8( r0 ), _debayer_load8( r4 ) );
+		we2  = _mm_add_epi16( _debayer_load8( r2 - 2 ), _debayer_load8( r2 + 2 ) );
+		diag = _mm_add_epi16( _mm_add_epi16( _debayer_load8( r1 - 1 ), _debayer_load8( r1 + 1 ) ),
+							  _mm_add_epi16( _debayer_load8( r3 - 1 ), _debayer_load8( r3 + 1 ) ) );
+		ring2 = _mm_add_epi16( ns2, we2 );
+
+		/* 8c + 4 cross - 2 ring2 */
+		gA = _mm_add_epi16( _mm_slli_epi16( c, 3 ), _mm_slli_epi16( _mm_add_epi16( ns, we ), 2 ) );
+		gA = _mm_sub_epi16( gA, _mm_slli_epi16( ring2, 1 ) );
+		/* 12c + 4 diag - 3 ring2 */
+		dA = _mm_add_epi16( _mm_add_epi16( _mm_slli_epi16( c, 3 ), _mm_slli_epi16( c, 2 ) ), _mm_slli_epi16( diag, 2 ) );
+		dA = _mm_sub_epi16( dA, _mm_add_epi16( ring2, _mm_slli_epi16( ring2, 1 ) ) );
+		/* 10c - 2 diag + 8 neighbours - 2 same axis + other axis */
+		base = _mm_sub_epi16( _mm_add_epi16( _mm_slli_epi16( c, 3 ), _mm_slli_epi16( c, 1 ) ), _mm_slli_epi16( diag, 1 ) );
+		hG = _mm_add_epi16( _mm_add_epi16( base, _mm_slli_epi16( we, 3 ) ), _mm_sub_epi16( ns2, _mm_slli_epi16( we2, 1 ) ) );
+		vG = _mm_add_epi16( _mm_add_epi16( base, _mm_slli_epi16( ns, 3 ) ), _mm_sub_epi16( we2, _mm_slli_epi16( ns2, 1 ) ) );
+
+		gA = _mm_srai_epi16( _mm_add_epi16( gA, round ), 4 );
+		dA = _mm_srai_epi16( _mm_add_epi16( dA, round ), 4 );
+		hG = _mm_srai_epi16( _mm_add_epi16( hG, round ), 4 );
+		vG = _mm_srai_epi16( _mm_add_epi16( vG, round ), 4 );
+
+		a = _mm_or_si128( _mm_and_si128( mask, c ), _mm_andnot_si128( mask, hG ) );
+		g = _mm_or_si128( _mm_and_si128( mask, gA ), _mm_andnot_si128( mask, c ) );
+		o = _mm_or_si128( _mm_and_si128( mask, dA ), _mm_andnot_si128( mask, vG ) );
+
+		a = _mm_packus_epi16( a, a );
+		g = _mm_packus_epi16( g, g );
+		o = _mm_packus_epi16( o, o );
+
+		if( redrow ) {
+			rg = _mm_unpacklo_epi8( a, g );
+			ba = _mm_unpacklo_epi8( o, alpha );
+		} else {
+			rg = _mm_unpacklo_epi8( o, g );
+			ba = _mm_unpacklo_epi8( a, alpha );
+		}
+		_mm_storeu_si128( ( __m128i* ) dst, _mm_unpacklo_epi16( rg, ba ) );
+		_mm_storeu_si128( ( __m128i* ) ( dst + 4 ), _mm_unpackhi_epi16( rg, ba ) );
+
+		r0 += 8;
+		r1 += 8;
+		r2 += 8;
+		r3 += 8;
+		r4 += 8;
+		dst += 8;
+	}
+
+	if( n & 0x7 ) {
+		const uint8_t* tail[ 5 ] = { r0, r1, r2, r3, r4 };
+		SIMD::debayer_MHCu8_RGBAu8( dst, tail, n & 0x7, phase, redrow );
+	}
+}
+
 void SIMDSSE2::debayer_ODD_RGGBu8_GRAYu8( uint32_t* _dst, const uint32_t* src1, const uint32_t* src2, const uint32_t* src3, const size_t width ) const
 {
 	size_t n = width >> 2;
@@ -6020,6 +6969,464 @@ void SIMDSSE2::adaptiveThreshold1_f_to_f( float* dst, const float* src, const fl
 	}
 }
 
+/* quantized canny directions of four gradients packed into the low 4 bytes */
+static inline int32_t _mm_canny_direction( __m128 dx, __m128 dy )
+{
+	const __m128 absmask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+	const __m128 zero = _mm_setzero_ps();
+	__m128 ax = _mm_and_ps( dx, absmask );
+	__m128 ay = _mm_and_ps( dy, absmask );
+	__m128i vert = _mm_castps_si128( _mm_cmpge_ps( ay, _mm_mul_ps( ax, _mm_set1_ps( 2.4142f ) ) ) );
+	__m128i diag = _mm_castps_si128( _mm_cmpge_ps( ay, _mm_mul_ps( ax, _mm_set1_ps( 0.41421f ) ) ) );
+	__m128i down = _mm_castps_si128( _mm_xor_ps( _mm_cmpgt_ps( dx, zero ), _mm_cmpgt_ps( dy, zero ) ) );
+
+	/* vertical 1, diagonal 2 + down, horizontal 0 */
+	__m128i d = _mm_and_si128( diag, _mm_or_si128( _mm_set1_epi32( 2 ), _mm_and_si128( down, _mm_set1_epi32( 1 ) ) ) );
+	d = _mm_or_si128( _mm_andnot_si128( vert, d ), _mm_and_si128( vert, _mm_set1_epi32( 1 ) ) );
+	d = _mm_packs_epi32( d, d );
+	d = _mm_packus_epi16( d, d );
+	return _mm_cvtsi128_si32( d );
+}
+
+static inline uint8_t _canny_direction( float dx, float dy )
+{
+	float ax = Math::abs( dx );
+	float ay = Math::abs( dy );
+	if( ay >= 2.4142f * ax )
+		return 1;
+	if( ay >= 0.41421f * ax )
+		return ( ( dx > 0 ) ^ ( dy > 0 ) ) ? 3 : 2;
+	return 0;
+}
+
+static inline void _canny_gradient( float* mag, uint8_t* dir, const float* prev, const float* cur, const float* next, size_t x, size_t width )
+{
+	size_t xl = x > 0 ? x - 1 : 0;
+	size_t xr = x + 1 < width ? x + 1 : width - 1;
+	float dx = ( ( prev[ xl ] + next[ xl ] ) + ( cur[ xl ] + cur[ xl ] ) ) - ( ( prev[ xr ] + next[ xr ] ) + ( cur[ xr ] + cur[ xr ] ) );
+	float dy = ( ( prev[ xl ] + prev[ xr ] ) + ( prev[ x ] + prev[ x ] ) ) - ( ( next[ xl ] + next[ xr ] ) + ( next[ x ] + next[ x ] ) );
+	dx *= 0.25f;
+	dy *= 0.25f;
+	mag[ x ] = Math::sqrt( dx * dx + dy * dy );
+	dir[ x ] = _canny_direction( dx, dy );
+}
+
+void SIMDSSE2::cannyGradient1_f( float* mag, uint8_t* dir, const float* prev, const float* cur, const float* next, size_t width ) const
+{
+	if( width < 6 ) {
+		SIMD::cannyGradient1_f( mag, dir, prev, cur, next, width );
+		return;
+	}
+
+	const __m128 quarter = _mm_set1_ps( 0.25f );
+	__m128 pl, pc, pr, cl, cr, nl, nc, nr, dx, dy;
+	int32_t d;
+
+	_canny_gradient( mag, dir, prev, cur, next, 0, width );
+
+	size_t x = 1;
+	for( ; x + 5 <= width; x += 4 ) {
+		pl = _mm_loadu_ps( prev + x - 1 );
+		pc = _mm_loadu_ps( prev + x );
+		pr = _mm_loadu_ps( prev + x + 1 );
+		cl = _mm_loadu_ps( cur + x - 1 );
+		cr = _mm_loadu_ps( cur + x + 1 );
+		nl = _mm_loadu_ps( next + x - 1 );
+		nc = _mm_loadu_ps( next + x );
+		nr = _mm_loadu_ps( next + x + 1 );
+
+		dx = _mm_sub_ps( _mm_add_ps( _mm_add_ps( pl, nl ), _mm_add_ps( cl, cl ) ), _mm_add_ps( _mm_add_ps( pr, nr ), _mm_add_ps( cr, cr ) ) );
+		dy = _mm_sub_ps( _mm_add_ps( _mm_add_ps( pl, pr ), _mm_add_ps( pc, pc ) ), _mm_add_ps( _mm_add_ps( nl, nr ), _mm_add_ps( nc, nc ) ) );
+		dx = _mm_mul_ps( dx, quarter );
+		dy = _mm_mul_ps( dy, quarter );
+
+		_mm_storeu_ps( mag + x, _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ) ) );
+		d = _mm_canny_direction( dx, dy );
+		memcpy( dir + x, &d, sizeof( int32_t ) );
+	}
+
+	for( ; x < width; x++ )
+		_canny_gradient( mag, dir, prev, cur, next, x, width );
+}
+
+void SIMDSSE2::cannyGradient1_f( float* mag, uint8_t* dir, const float* dx, const float* dy, size_t width ) const
+{
+	__m128 gx, gy;
+	int32_t d;
+	size_t i = width >> 2;
+
+	while( i-- ) {
+		gx = _mm_loadu_ps( dx );
+		gy = _mm_loadu_ps( dy );
+		_mm_storeu_ps( mag, _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( gx, gx ), _mm_mul_ps( gy, gy ) ) ) );
+		d = _mm_canny_direction( gx, gy );
+		memcpy( dir, &d, sizeof( int32_t ) );
+		dx += 4;
+		dy += 4;
+		mag += 4;
+		dir += 4;
+	}
+
+	i = width & 0x3;
+	while( i-- ) {
+		*mag++ = Math::sqrt( *dx * *dx + *dy * *dy );
+		*dir++ = _canny_direction( *dx++, *dy++ );
+	}
+}
+
+void SIMDSSE2::cannyNonMaxima1_f( uint8_t* dst, const float* mprev, const float* mcur, const float* mnext, const uint8_t* dir, size_t width, float low, float high ) const
+{
+	if( width < 6 ) {
+		SIMD::cannyNonMaxima1_f( dst, mprev, mcur, mnext, dir, width, low, high );
+		return;
+	}
+
+	const __m128 vlow = _mm_set1_ps( low );
+	const __m128 vhigh = _mm_set1_ps( high );
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi32( 1 );
+	const __m128i two = _mm_set1_epi32( 2 );
+	const __m128i three = _mm_set1_epi32( 3 );
+	__m128 m, n1, n2, vert, up, down, keep, strong;
+	__m128i d;
+	int32_t tmp;
+
+	dst[ 0 ] = 0;
+	size_t x = 1;
+	for( ; x + 5 <= width; x += 4 ) {
+		memcpy( &tmp, dir + x, sizeof( int32_t ) );
+		d = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( tmp ), zero ), zero );
+		vert = _mm_castsi128_ps( _mm_cmpeq_epi32( d, one ) );
+		up = _mm_castsi128_ps( _mm_cmpeq_epi32( d, two ) );
+		down = _mm_castsi128_ps( _mm_cmpeq_epi32( d, three ) );
+
+		/* select the two neighbours along the gradient, horizontal is the default */
+		m = _mm_loadu_ps( mcur + x );
+		n1 = _mm_loadu_ps( mcur + x - 1 );
+		n2 = _mm_loadu_ps( mcur + x + 1 );
+		n1 = _mm_or_ps( _mm_andnot_ps( vert, n1 ), _mm_and_ps( vert, _mm_loadu_ps( mprev + x ) ) );
+		n2 = _mm_or_ps( _mm_andnot_ps( vert, n2 ), _mm_and_ps( vert, _mm_loadu_ps( mnext + x ) ) );
+		n1 = _mm_or_ps( _mm_andnot_ps( up, n1 ), _mm_and_ps( up, _mm_loadu_ps( mprev + x - 1 ) ) );
+		n2 = _mm_or_ps( _mm_andnot_ps( up, n2 ), _mm_and_ps( up, _mm_loadu_ps( mnext + x + 1 ) ) );
+		n1 = _mm_or_ps( _mm_andnot_ps( down, n1 ), _mm_and_ps( down, _mm_loadu_ps( mprev + x + 1 ) ) );
+		n2 = _mm_or_ps( _mm_andnot_ps( down, n2 ), _mm_and_ps( down, _mm_loadu_ps( mnext + x - 1 ) ) );
+
+		keep = _mm_and_ps( _mm_cmpge_ps( m, vlow ), _mm_and_ps( _mm_cmple_ps( n1, m ), _mm_cmple_ps( n2, m ) ) );
+		strong = _mm_and_ps( keep, _mm_cmpge_ps( m, vhigh ) );
+
+		/* the masks are -1, so the negated sum is 0, 1 or 2 */
+		d = _mm_sub_epi32( _mm_setzero_si128(), _mm_add_epi32( _mm_castps_si128( keep ), _mm_castps_si128( strong ) ) );
+		d = _mm_packs_epi32( d, d );
+		d = _mm_packus_epi16( d, d );
+		tmp = _mm_cvtsi128_si32( d );
+		memcpy( dst + x, &tmp, sizeof( int32_t ) );
+	}
+
+	for( ; x + 1 < width; x++ ) {
+		float mc = mcur[ x ];
+		float a, b;
+		switch( dir[ x ] ) {
+			case 0:  a = mcur[ x - 1 ];  b = mcur[ x + 1 ];  break;
+			case 1:  a = mprev[ x ];     b = mnext[ x ];     break;
+			case 2:  a = mprev[ x - 1 ]; b = mnext[ x + 1 ]; break;
+			default: a = mprev[ x + 1 ]; b = mnext[ x - 1 ]; break;
+		}
+		if( mc >= low && a <= mc && b <= mc )
+			dst[ x ] = mc >= high ? 2 : 1;
+		else
+			dst[ x ] = 0;
+	}
+	dst[ width - 1 ] = 0;
+}
+
+void SIMDSSE2::pdtvDual1_f( float* px, float* py, const float* u, const float* unext, const float* weight, size_t width, float sigma, float epsilon ) const
+{
+	const __m128 vsigma = _mm_set1_ps( sigma );
+	const __m128 vse = _mm_set1_ps( sigma * epsilon );
+	const __m128 tiny = _mm_set1_ps( 1e-20f );
+	const __m128 one = _mm_set1_ps( 1.0f );
+	__m128 g, c, dx, dy, s, qx, qy, r;
+	size_t x = 0;
+
+	for( ; x + 4 < width; x += 4 ) {
+		g = weight ? _mm_loadu_ps( weight + x ) : one;
+		c = _mm_loadu_ps( u + x );
+		dx = _mm_sub_ps( _mm_loadu_ps( u + x + 1 ), c );
+		dy = unext ? _mm_sub_ps( _mm_loadu_ps( unext + x ), c ) : _mm_setzero_ps();
+		s = _mm_div_ps( g, _mm_max_ps( _mm_add_ps( g, vse ), tiny ) );
+		qx = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( px + x ), _mm_mul_ps( vsigma, dx ) ), s );
+		qy = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( py + x ), _mm_mul_ps( vsigma, dy ) ), s );
+		r = _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( qx, qx ), _mm_mul_ps( qy, qy ) ) );
+		r = _mm_div_ps( g, _mm_max_ps( _mm_max_ps( g, r ), tiny ) );
+		_mm_storeu_ps( px + x, _mm_mul_ps( qx, r ) );
+		_mm_storeu_ps( py + x, _mm_mul_ps( qy, r ) );
+	}
+
+	/* the tail contains the last column */
+	SIMD::pdtvDual1_f( px + x, py + x, u + x, unext ? unext + x : NULL, weight ? weight + x : NULL, width - x, sigma, epsilon );
+}
+
+void SIMDSSE2::pdtvPrimal1_f( float* u, float* ubar, const float* px, const float* py, const float* pyprev, const float* f, const float* lambda, float lambdac, size_t width, float tau, float theta, bool l1 ) const
+{
+	if( width < 2 ) {
+		SIMD::pdtvPrimal1_f( u, ubar, px, py, pyprev, f, lambda, lambdac, width, tau, theta, l1 );
+		return;
+	}
+
+	const __m128 vtau = _mm_set1_ps( tau );
+	const __m128 vtheta = _mm_set1_ps( theta );
+	const __m128 vt = _mm_set1_ps( tau * lambdac );
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 sign = _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) );
+	__m128 div, uold, v, t, vf, d, un;
+
+	/* the first column has no left neighbour */
+	SIMD::pdtvPrimal1_f( u, ubar, px, py, pyprev, f, lambda, lambdac, 1, tau, theta, l1 );
+
+	size_t x = 1;
+	for( ; x + 4 <= width; x += 4 ) {
+		div = _mm_sub_ps( _mm_loadu_ps( px + x ), _mm_loadu_ps( px + x - 1 ) );
+		div = _mm_add_ps( div, pyprev ? _mm_sub_ps( _mm_loadu_ps( py + x ), _mm_loadu_ps( pyprev + x ) ) : _mm_loadu_ps( py + x ) );
+		uold = _mm_loadu_ps( u + x );
+		v = _mm_add_ps( uold, _mm_mul_ps( vtau, div ) );
+		t = lambda ? _mm_mul_ps( vtau, _mm_loadu_ps( lambda + x ) ) : vt;
+		vf = _mm_loadu_ps( f + x );
+		if( l1 ) {
+			d = _mm_sub_ps( v, vf );
+			un = _mm_add_ps( vf, _mm_sub_ps( d, _mm_min_ps( _mm_max_ps( d, _mm_xor_ps( t, sign ) ), t ) ) );
+		} else {
+			un = _mm_div_ps( _mm_add_ps( v, _mm_mul_ps( t, vf ) ), _mm_add_ps( one, t ) );
+		}
+		_mm_storeu_ps( ubar + x, _mm_add_ps( un, _mm_mul_ps( vtheta, _mm_sub_ps( un, uold ) ) ) );
+		_mm_storeu_ps( u + x, un );
+	}
+
+	for( ; x < width; x++ ) {
+		float dv = ( px[ x ] - px[ x - 1 ] ) + ( py[ x ] - ( pyprev ? pyprev[ x ] : 0.0f ) );
+		float vs = u[ x ] + tau * dv;
+		float ts = tau * ( lambda ? lambda[ x ] : lambdac );
+		float uns;
+		if( l1 ) {
+			float ds = vs - f[ x ];
+			uns = f[ x ] + ( ds - Math::min( Math::max( ds, -ts ), ts ) );
+		} else {
+			uns = ( vs + ts * f[ x ] ) / ( 1.0f + ts );
+		}
+		ubar[ x ] = uns + theta * ( uns - u[ x ] );
+		u[ x ] = uns;
+	}
+}
+
+void SIMDSSE2::histogramBSplineWeights_f( int32_t* idx, float* weights, float* dweights, const float* src, size_t n, size_t bins ) const
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 scale = _mm_set1_ps( ( float ) ( bins - 3 ) );
+	const __m128 sixth = _mm_set1_ps( 1.0f / 6.0f );
+	const __m128 c0_5 = _mm_set1_ps( 0.5f );
+	const __m128 c1_5 = _mm_set1_ps( 1.5f );
+	const __m128 c2 = _mm_set1_ps( 2.0f );
+	const __m128 c3 = _mm_set1_ps( 3.0f );
+	const __m128 c4 = _mm_set1_ps( 4.0f );
+	const __m128 c6 = _mm_set1_ps( 6.0f );
+	const __m128i ione = _mm_set1_epi32( 1 );
+	__m128 v, t, fi, f, f2, f3, g, g2, w0, w1, w2, w3;
+	size_t i = n >> 2;
+
+	while( i-- ) {
+		v = _mm_min_ps( _mm_max_ps( _mm_loadu_ps( src ), zero ), one );
+		t = _mm_add_ps( _mm_mul_ps( v, scale ), one );
+		fi = _mm_cvtepi32_ps( _mm_cvttps_epi32( t ) );
+		fi = _mm_min_ps( fi, scale );
+		f = _mm_sub_ps( t, fi );
+		f2 = _mm_mul_ps( f, f );
+		f3 = _mm_mul_ps( f2, f );
+		g = _mm_sub_ps( one, f );
+		g2 = _mm_mul_ps( g, g );
+
+		_mm_storeu_si128( ( __m128i* ) idx, _mm_sub_epi32( _mm_cvttps_epi32( fi ), ione ) );
+
+		w0 = _mm_mul_ps( _mm_mul_ps( g2, g ), sixth );
+		w1 = _mm_mul_ps( _mm_add_ps( _mm_sub_ps( c4, _mm_mul_ps( c6, f2 ) ), _mm_mul_ps( c3, f3 ) ), sixth );
+		w2 = _mm_mul_ps( _mm_sub_ps( _mm_add_ps( _mm_add_ps( one, _mm_mul_ps( c3, f ) ), _mm_mul_ps( c3, f2 ) ), _mm_mul_ps( c3, f3 ) ), sixth );
+		w3 = _mm_mul_ps( f3, sixth );
+		_MM_TRANSPOSE4_PS( w0, w1, w2, w3 );
+		_mm_storeu_ps( weights, w0 );
+		_mm_storeu_ps( weights + 4, w1 );
+		_mm_storeu_ps( weights + 8, w2 );
+		_mm_storeu_ps( weights + 12, w3 );
+
+		if( dweights ) {
+			w0 = _mm_mul_ps( _mm_set1_ps( -0.5f ), g2 );
+			w1 = _mm_sub_ps( _mm_mul_ps( c1_5, f2 ), _mm_mul_ps( c2, f ) );
+			w2 = _mm_sub_ps( _mm_add_ps( c0_5, f ), _mm_mul_ps( c1_5, f2 ) );
+			w3 = _mm_mul_ps( c0_5, f2 );
+			_MM_TRANSPOSE4_PS( w0, w1, w2, w3 );
+			_mm_storeu_ps( dweights, w0 );
+			_mm_storeu_ps( dweights + 4, w1 );
+			_mm_storeu_ps( dweights + 8, w2 );
+			_mm_storeu_ps( dweights + 12, w3 );
+			dweights += 16;
+		}
+
+		src += 4;
+		idx += 4;
+		weights += 16;
+	}
+
+	SIMD::histogramBSplineWeights_f( idx, weights, dweights, src, n & 0x3, bins );
+}
+
+void SIMDSSE2::jointHistogramBSpline_f( float* hist, size_t bins, const int32_t* ia, const float* wa, const int32_t* ib, const float* wb, size_t n ) const
+{
+	__m128 b;
+	while( n-- ) {
+		float* h = hist + *ia++ * bins + *ib++;
+		b = _mm_loadu_ps( wb );
+		_mm_storeu_ps( h, _mm_add_ps( _mm_loadu_ps( h ), _mm_mul_ps( _mm_set1_ps( wa[ 0 ] ), b ) ) );
+		h += bins;
+		_mm_storeu_ps( h, _mm_add_ps( _mm_loadu_ps( h ), _mm_mul_ps( _mm_set1_ps( wa[ 1 ] ), b ) ) );
+		h += bins;
+		_mm_storeu_ps( h, _mm_add_ps( _mm_loadu_ps( h ), _mm_mul_ps( _mm_set1_ps( wa[ 2 ] ), b ) ) );
+		h += bins;
+		_mm_storeu_ps( h, _mm_add_ps( _mm_loadu_ps( h ), _mm_mul_ps( _mm_set1_ps( wa[ 3 ] ), b ) ) );
+		wa += 4;
+		wb += 4;
+	}
+}
+
+float SIMDSSE2::kltSystem_f( float* jsum, float* residual, const float* warped, const float* patch, const float* jac, size_t nparams, size_t n ) const
+{
+	const size_t n4 = n & ~( ( size_t ) 0x3 );
+	float s[ 4 ] __attribute__ ( ( aligned ( 16 ) ) );
+	__m128 acc, r;
+	size_t i;
+
+	acc = _mm_setzero_ps();
+	for( i = 0; i < n4; i += 4 ) {
+		r = _mm_sub_ps( _mm_loadu_ps( warped + i ), _mm_loadu_ps( patch + i ) );
+		_mm_storeu_ps( residual + i, r );
+		acc = _mm_add_ps( acc, _mm_mul_ps( r, r ) );
+	}
+	_mm_store_ps( s, acc );
+	float error = ( s[ 0 ] + s[ 1 ] ) + ( s[ 2 ] + s[ 3 ] );
+	for( ; i < n; i++ ) {
+		float rs = warped[ i ] - patch[ i ];
+		residual[ i ] = rs;
+		error += rs * rs;
+	}
+
+	for( size_t k = 0; k < nparams; k++ ) {
+		acc = _mm_setzero_ps();
+		for( i = 0; i < n4; i += 4 )
+			acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( jac + i ), _mm_loadu_ps( residual + i ) ) );
+		_mm_store_ps( s, acc );
+		float sum = ( s[ 0 ] + s[ 1 ] ) + ( s[ 2 ] + s[ 3 ] );
+		for( ; i < n; i++ )
+			sum += jac[ i ] * residual[ i ];
+		jsum[ k ] = sum;
+		jac += n;
+	}
+	return error;
+}
+
+void SIMDSSE2::astStrength_u8( uint8_t* dst, const uint8_t* src, const int* offsets, size_t circle, size_t arc, uint8_t threshold, size_t n ) const
+{
+	/* minima over 1, 2, 4 and 8 contiguous circle pixels, replicated once for the wrap around */
+	__m128i bright[ 4 ][ 32 ], dark[ 4 ][ 32 ];
+	const __m128i thres = _mm_set1_epi8( threshold );
+	const __m128i zero = _mm_setzero_si128();
+	size_t levels = 1;
+	while( ( ( size_t ) 1 << levels ) <= arc && levels < 4 )
+		levels++;
+
+	for( size_t i = n >> 4; i--; ) {
+		const __m128i c = _mm_loadu_si128( ( const __m128i* ) src );
+		__m128i mx = zero;
+		for( size_t j = 0; j < circle; j++ ) {
+			__m128i v = _mm_loadu_si128( ( const __m128i* ) ( src + offsets[ j ] ) );
+			bright[ 0 ][ j ] = bright[ 0 ][ j + circle ] = _mm_subs_epu8( v, c );
+			dark[ 0 ][ j ] = dark[ 0 ][ j + circle ] = _mm_subs_epu8( c, v );
+			mx = _mm_max_epu8( mx, _mm_max_epu8( bright[ 0 ][ j ], dark[ 0 ][ j ] ) );
+		}
+
+		/* no difference above the threshold: no corner in this block */
+		if( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_subs_epu8( mx, thres ), zero ) ) == 0xffff ) {
+			_mm_storeu_si128( ( __m128i* ) dst, zero );
+			src += 16;
+			dst += 16;
+			continue;
+		}
+
+		for( size_t l = 1; l < levels; l++ ) {
+			size_t len = ( size_t ) 1 << ( l - 1 );
+			for( size_t j = 0; j < circle; j++ ) {
+				bright[ l ][ j ] = bright[ l ][ j + circle ] = _mm_min_epu8( bright[ l - 1 ][ j ], bright[ l - 1 ][ j + len ] );
+				dark[ l ][ j ] = dark[ l ][ j + circle ] = _mm_min_epu8( dark[ l - 1 ][ j ], dark[ l - 1 ][ j + len ] );
+			}
+		}
+
+		__m128i strength = zero;
+		for( size_t k = 0; k < circle; k++ ) {
+			__m128i b = _mm_set1_epi8( ( char ) 0xff );
+			__m128i d = b;
+			size_t pos = k;
+			for( int l = levels - 1; l >= 0; l-- ) {
+				if( arc & ( ( size_t ) 1 << l ) ) {
+					b = _mm_min_epu8( b, bright[ l ][ pos ] );
+					d = _mm_min_epu8( d, dark[ l ][ pos ] );
+					pos += ( size_t ) 1 << l;
+					if( pos >= circle )
+						pos -= circle;
+				}
+			}
+			strength = _mm_max_epu8( strength, _mm_max_epu8( b, d ) );
+		}
+
+		__m128i notcorner = _mm_cmpeq_epi8( _mm_subs_epu8( strength, thres ), zero );
+		_mm_storeu_si128( ( __m128i* ) dst, _mm_andnot_si128( notcorner, strength ) );
+		src += 16;
+		dst += 16;
+	}
+
+	SIMD::astStrength_u8( dst, src, offsets, circle, arc, threshold, n & 0xf );
+}
+
+void SIMDSSE2::boxSum_f( float* dst, const float* src, const int* offsets, size_t n ) const
+{
+	for( size_t i = n >> 2; i--; ) {
+		const int* o = offsets;
+		__m128 br = _mm_set_ps( src[ o[ 12 ] ], src[ o[ 8 ] ], src[ o[ 4 ] ], src[ o[ 0 ] ] );
+		__m128 tr = _mm_set_ps( src[ o[ 13 ] ], src[ o[ 9 ] ], src[ o[ 5 ] ], src[ o[ 1 ] ] );
+		__m128 bl = _mm_set_ps( src[ o[ 14 ] ], src[ o[ 10 ] ], src[ o[ 6 ] ], src[ o[ 2 ] ] );
+		__m128 tl = _mm_set_ps( src[ o[ 15 ] ], src[ o[ 11 ] ], src[ o[ 7 ] ], src[ o[ 3 ] ] );
+		_mm_storeu_ps( dst, _mm_add_ps( _mm_sub_ps( _mm_sub_ps( br, tr ), bl ), tl ) );
+		offsets += 16;
+		dst += 4;
+	}
+
+	SIMD::boxSum_f( dst, src, offsets, n & 0x3 );
+}
+
+static inline __m128 _boxSum4( const float* src, const int* o )
+{
+	__m128 br = _mm_set_ps( src[ o[ 24 ] ], src[ o[ 16 ] ], src[ o[ 8 ] ], src[ o[ 0 ] ] );
+	__m128 tr = _mm_set_ps( src[ o[ 25 ] ], src[ o[ 17 ] ], src[ o[ 9 ] ], src[ o[ 1 ] ] );
+	__m128 bl = _mm_set_ps( src[ o[ 26 ] ], src[ o[ 18 ] ], src[ o[ 10 ] ], src[ o[ 2 ] ] );
+	__m128 tl = _mm_set_ps( src[ o[ 27 ] ], src[ o[ 19 ] ], src[ o[ 11 ] ], src[ o[ 3 ] ] );
+	return _mm_add_ps( _mm_sub_ps( _mm_sub_ps( br, tr ), bl ), tl );
+}
+
+void SIMDSSE2::boxTest_f( uint8_t* dst, const float* src, const int* offsets, size_t n ) const
+{
+	for( size_t i = n >> 3; i--; ) {
+		int lo = _mm_movemask_ps( _mm_cmplt_ps( _boxSum4( src, offsets ), _boxSum4( src, offsets + 4 ) ) );
+		int hi = _mm_movemask_ps( _mm_cmplt_ps( _boxSum4( src, offsets + 32 ), _boxSum4( src, offsets + 36 ) ) );
+		*dst++ = lo | ( hi << 4 );
+		offsets += 64;
+	}
+}
+
 void SIMDSSE2::sumPoints( Vector2f& dst, const Vector2f* src, size_t n ) const
 {
 	__m128 result = _mm_setzero_ps();
@@ -6381,4 +7788,396 @@ void SIMDSSE2::projectPoints( Vector2f* dst, const Matrix4f& _mat, const Vector3
         }
 }
 
+void SIMDSSE2::reprojectionErrorSqr( float* dst, const float* P, const float* x, const float* y, const float* z,
+                                     const float* u, const float* v, size_t n ) const
+{
+	__m128 p[ 12 ];
+	for( size_t k = 0; k < 12; k++ )
+		p[ k ] = _mm_set1_ps( P[ k ] );
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one  = _mm_set1_ps( 1.0f );
+	const __m128 fmax = _mm_set1_ps( FLT_MAX );
+
+	size_t i = n >> 2;
+	while( i-- ){
+		__m128 px = _mm_loadu_ps( x );
+		__m128 py = _mm_loadu_ps( y );
+		__m128 pz = _mm_loadu_ps( z );
+
+		/* same summation order as the base version */
+		__m128 rx = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( p[ 0 ], px ), _mm_mul_ps( p[ 1 ], py ) ), _mm_mul_ps( p[ 2 ], pz ) ), p[ 3 ] );
+		__m128 ry = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( p[ 4 ], px ), _mm_mul_ps( p[ 5 ], py ) ), _mm_mul_ps( p[ 6 ], pz ) ), p[ 7 ] );
+		__m128 rz = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( p[ 8 ], px ), _mm_mul_ps( p[ 9 ], py ) ), _mm_mul_ps( p[ 10 ], pz ) ), p[ 11 ] );
+
+		/* points behind the camera get FLT_MAX */
+		__m128 valid = _mm_cmpgt_ps( rz, zero );
+		__m128 iz = _mm_div_ps( one, rz );
+		__m128 dx = _mm_sub_ps( _mm_mul_ps( rx, iz ), _mm_loadu_ps( u ) );
+		__m128 dy = _mm_sub_ps( _mm_mul_ps( ry, iz ), _mm_loadu_ps( v ) );
+		__m128 d = _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) );
+		_mm_storeu_ps( dst, _mm_or_ps( _mm_and_ps( valid, d ), _mm_andnot_ps( valid, fmax ) ) );
+
+		x += 4; y += 4; z += 4;
+		u += 4; v += 4;
+		dst += 4;
+	}
+
+	SIMD::reprojectionErrorSqr( dst, P, x, y, z, u, v, n & 0x3 );
+}
+
+/* the P3P helpers follow the scalar versions in SIMD.cpp operation by operation, so both give the same bits */
+static inline __m128d _p3pSel( __m128d mask, __m128d a, __m128d b )
+{
+	return _mm_or_pd( _mm_and_pd( mask, a ), _mm_andnot_pd( mask, b ) );
+}
+
+static inline __m128d _p3pNeg( __m128d a )
+{
+	return _mm_xor_pd( a, _mm_set1_pd( -0.0 ) );
+}
+
+static inline __m128d _p3pAbs( __m128d a )
+{
+	return _mm_andnot_pd( _mm_set1_pd( -0.0 ), a );
+}
+
+/* negates the lanes of a where x < 0 */
+static inline __m128d _p3pSign( __m128d a, __m128d x )
+{
+	return _mm_xor_pd( a, _mm_and_pd( _mm_cmplt_pd( x, _mm_setzero_pd() ), _mm_set1_pd( -0.0 ) ) );
+}
+
+static inline __m128d _p3pCbrt( __m128d a )
+{
+	/* high word / 3 by multiplication with 0xAAAAAAAB */
+	__m128i hi = _mm_srli_epi64( _mm_castpd_si128( a ), 32 );
+	hi = _mm_srli_epi64( _mm_mul_epu32( hi, _mm_set1_epi32( 0xAAAAAAAB ) ), 33 );
+	hi = _mm_add_epi64( hi, _mm_set_epi32( 0, 715094163, 0, 715094163 ) );
+	__m128d y = _mm_castsi128_pd( _mm_slli_epi64( hi, 32 ) );
+
+	const __m128d two = _mm_set1_pd( 2.0 );
+	const __m128d three = _mm_set1_pd( 3.0 );
+	for( int i = 0; i < 4; i++ )
+		y = _mm_div_pd( _mm_add_pd( _mm_mul_pd( two, y ), _mm_div_pd( a, _mm_mul_pd( y, y ) ) ), three );
+	return y;
+}
+
+static inline __m128d _p3pCubicRoot( __m128d a2, __m128d a1, __m128d a0 )
+{
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d one = _mm_set1_pd( 1.0 );
+	const __m128d three = _mm_set1_pd( 3.0 );
+	const __m128d m05q = _mm_set1_pd( -0.5 );
+
+	__m128d p = _mm_sub_pd( a1, _mm_div_pd( _mm_mul_pd( a2, a2 ), three ) );
+	__m128d q = _mm_add_pd( _mm_sub_pd( _mm_div_pd( _mm_mul_pd( _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 2.0 ), a2 ), a2 ), a2 ), _mm_set1_pd( 27.0 ) ),
+										_mm_div_pd( _mm_mul_pd( a2, a1 ), three ) ), a0 );
+	__m128d disc = _mm_add_pd( _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 0.25 ), q ), q ),
+							   _mm_div_pd( _mm_mul_pd( _mm_mul_pd( p, p ), p ), _mm_set1_pd( 27.0 ) ) );
+	__m128d hq = _mm_mul_pd( m05q, q );
+
+	/* one real root */
+	__m128d s = _mm_sqrt_pd( disc );
+	__m128d u = _mm_add_pd( hq, s );
+	__m128d v = _mm_sub_pd( hq, s );
+	__m128d t1 = _mm_add_pd( _p3pSign( _p3pCbrt( _p3pAbs( u ) ), u ), _p3pSign( _p3pCbrt( _p3pAbs( v ) ), v ) );
+
+	/* three real roots */
+	__m128d r = _mm_sqrt_pd( _mm_div_pd( _p3pNeg( p ), three ) );
+	__m128d c = _p3pSel( _mm_cmpgt_pd( r, zero ), _mm_div_pd( hq, _mm_mul_pd( _mm_mul_pd( r, r ), r ) ), zero );
+	c = _mm_max_pd( c, _mm_set1_pd( -1.0 ) );
+	c = _mm_min_pd( c, one );
+	__m128d x = _mm_add_pd( _mm_set1_pd( 0.5 ), _mm_mul_pd( _mm_set1_pd( 0.5 ), _mm_sqrt_pd( _mm_div_pd( _mm_add_pd( c, one ), _mm_set1_pd( 1.5 ) ) ) ) );
+	for( int i = 0; i < 4; i++ ) {
+		__m128d f  = _mm_sub_pd( _mm_mul_pd( _mm_sub_pd( _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 4.0 ), x ), x ), three ), x ), c );
+		__m128d df = _mm_sub_pd( _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 12.0 ), x ), x ), three );
+		x = _p3pSel( _mm_cmpneq_pd( df, zero ), _mm_sub_pd( x, _mm_div_pd( f, df ) ), x );
+	}
+	__m128d t3 = _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 2.0 ), r ), x );
+
+	__m128d t = _p3pSel( _mm_cmpgt_pd( disc, zero ), t1, t3 );
+	t = _mm_sub_pd( t, _mm_div_pd( a2, three ) );
+
+	/* polish */
+	for( int i = 0; i < 2; i++ ) {
+		__m128d f  = _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_add_pd( t, a2 ), t ), a1 ), t ), a0 );
+		__m128d df = _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( three, t ), _mm_mul_pd( _mm_set1_pd( 2.0 ), a2 ) ), t ), a1 );
+		t = _p3pSel( _mm_cmpneq_pd( df, zero ), _mm_sub_pd( t, _mm_div_pd( f, df ) ), t );
+	}
+	return t;
+}
+
+static inline void _p3pQuadraticRoots( __m128d* roots, __m128d b, __m128d c )
+{
+	__m128d disc = _mm_sub_pd( _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 0.25 ), b ), b ), c );
+	__m128d s = _mm_and_pd( _mm_cmpgt_pd( disc, _mm_setzero_pd() ), _mm_sqrt_pd( disc ) );
+	__m128d hb = _mm_mul_pd( _mm_set1_pd( -0.5 ), b );
+	roots[ 0 ] = _mm_add_pd( hb, s );
+	roots[ 1 ] = _mm_sub_pd( hb, s );
+}
+
+static inline void _p3pQuarticRoots( __m128d* roots, __m128d* valid, __m128d a, __m128d b, __m128d c, __m128d d, __m128d e )
+{
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d half = _mm_set1_pd( 0.5 );
+
+	__m128d B = _mm_div_pd( b, a ), C = _mm_div_pd( c, a ), D = _mm_div_pd( d, a ), E = _mm_div_pd( e, a );
+	__m128d B2 = _mm_mul_pd( B, B );
+	__m128d p = _mm_sub_pd( C, _mm_mul_pd( _mm_set1_pd( 0.375 ), B2 ) );
+	__m128d q = _mm_add_pd( _mm_sub_pd( D, _mm_mul_pd( _mm_mul_pd( half, B ), C ) ), _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 0.125 ), B2 ), B ) );
+	__m128d r = _mm_sub_pd( _mm_add_pd( _mm_sub_pd( E, _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 0.25 ), B ), D ) ),
+										_mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 0.0625 ), B2 ), C ) ),
+							_mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 3.0 / 256.0 ), B2 ), B2 ) );
+
+	__m128d m = _p3pCubicRoot( p, _mm_sub_pd( _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 0.25 ), p ), p ), r ),
+							   _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( -0.125 ), q ), q ) );
+
+	/* both branches, selected per lane */
+	__m128d y[ 4 ], z[ 4 ];
+	__m128d s = _mm_sqrt_pd( _mm_mul_pd( _mm_set1_pd( 2.0 ), m ) );
+	__m128d pm = _mm_add_pd( _mm_mul_pd( half, p ), m );
+	__m128d qs = _mm_div_pd( _mm_mul_pd( half, q ), s );
+	_p3pQuadraticRoots( y, s, _mm_sub_pd( pm, qs ) );
+	_p3pQuadraticRoots( y + 2, _p3pNeg( s ), _mm_add_pd( pm, qs ) );
+
+	/* biquadratic */
+	_p3pQuadraticRoots( z, p, r );
+	z[ 0 ] = _mm_sqrt_pd( _mm_max_pd( z[ 0 ], zero ) );
+	z[ 2 ] = _mm_sqrt_pd( _mm_max_pd( z[ 1 ], zero ) );
+	z[ 1 ] = _p3pNeg( z[ 0 ] );
+	z[ 3 ] = _p3pNeg( z[ 2 ] );
+
+	__m128d ferrari = _mm_cmpgt_pd( m, _mm_set1_pd( 1e-14 ) );
+	__m128d scale = _mm_add_pd( _mm_add_pd( _mm_add_pd( _mm_add_pd( _mm_set1_pd( 1.0 ), _p3pAbs( B ) ), _p3pAbs( C ) ), _p3pAbs( D ) ), _p3pAbs( E ) );
+	__m128d thresh = _mm_mul_pd( _mm_set1_pd( 1e-8 ), scale );
+	__m128d anz = _mm_cmpneq_pd( a, zero );
+	const __m128d three = _mm_set1_pd( 3.0 );
+	const __m128d two = _mm_set1_pd( 2.0 );
+	const __m128d four = _mm_set1_pd( 4.0 );
+	for( int i = 0; i < 4; i++ ) {
+		__m128d x = _mm_sub_pd( _p3pSel( ferrari, y[ i ], z[ i ] ), _mm_mul_pd( _mm_set1_pd( 0.25 ), B ) );
+		for( int k = 0; k < 3; k++ ) {
+			__m128d f = _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_add_pd( x, B ), x ), C ), x ), D ), x ), E );
+			__m128d df = _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( four, x ), _mm_mul_pd( three, B ) ), x ),
+															 _mm_mul_pd( two, C ) ), x ), D );
+			x = _p3pSel( _mm_cmpneq_pd( df, zero ), _mm_sub_pd( x, _mm_div_pd( f, df ) ), x );
+		}
+		__m128d f = _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_add_pd( x, B ), x ), C ), x ), D ), x ), E );
+		roots[ i ] = x;
+		valid[ i ] = _mm_and_pd( anz, _mm_cmplt_pd( _p3pAbs( f ), thresh ) );
+	}
+}
+
+/* cross product a x b */
+static inline void _p3pCross( __m128d* c, const __m128d* a, const __m128d* b )
+{
+	c[ 0 ] = _mm_sub_pd( _mm_mul_pd( a[ 1 ], b[ 2 ] ), _mm_mul_pd( a[ 2 ], b[ 1 ] ) );
+	c[ 1 ] = _mm_sub_pd( _mm_mul_pd( a[ 2 ], b[ 0 ] ), _mm_mul_pd( a[ 0 ], b[ 2 ] ) );
+	c[ 2 ] = _mm_sub_pd( _mm_mul_pd( a[ 0 ], b[ 1 ] ), _mm_mul_pd( a[ 1 ], b[ 0 ] ) );
+}
+
+static inline __m128d _p3pDot( const __m128d* a, const __m128d* b )
+{
+	return _mm_add_pd( _mm_add_pd( _mm_mul_pd( a[ 0 ], b[ 0 ] ), _mm_mul_pd( a[ 1 ], b[ 1 ] ) ), _mm_mul_pd( a[ 2 ], b[ 2 ] ) );
+}
+
+/* product of the four factors, evaluated from the left */
+static inline __m128d _p3pMul( __m128d a, __m128d b, __m128d c, __m128d d )
+{
+	return _mm_mul_pd( _mm_mul_pd( _mm_mul_pd( a, b ), c ), d );
+}
+
+/* solves the lanes i and i + 1, or only lane i if pair is false */
+static inline void _p3pLanes( double* poses, uint8_t* valid, const double* in, size_t n, size_t i, bool pair )
+{
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d one = _mm_set1_pd( 1.0 );
+	const __m128d two = _mm_set1_pd( 2.0 );
+
+	__m128d v[ 18 ];
+	for( size_t j = 0; j < 18; j++ )
+		v[ j ] = pair ? _mm_loadu_pd( in + j * n + i ) : _mm_load1_pd( in + j * n + i );
+	const __m128d* f1 = v;
+	const __m128d* f2 = v + 3;
+	const __m128d* f3 = v + 6;
+	const __m128d* P1 = v + 9;
+	const __m128d* P2 = v + 12;
+	const __m128d* P3 = v + 15;
+
+	/* swap the first two correspondences if the third bearing lies in the upper half space */
+	__m128d c[ 3 ];
+	_p3pCross( c, f1, f2 );
+	__m128d swap = _mm_cmpgt_pd( _p3pDot( c, f3 ), zero );
+
+	__m128d a[ 3 ], b[ 3 ], Q1[ 3 ], Q2[ 3 ];
+	for( int j = 0; j < 3; j++ ) {
+		a[ j ] = _p3pSel( swap, f2[ j ], f1[ j ] );
+		b[ j ] = _p3pSel( swap, f1[ j ], f2[ j ] );
+		Q1[ j ] = _p3pSel( swap, P2[ j ], P1[ j ] );
+		Q2[ j ] = _p3pSel( swap, P1[ j ], P2[ j ] );
+	}
+
+	/* intermediate camera frame ( rows of tr ) */
+	__m128d tr[ 9 ];
+	tr[ 0 ] = a[ 0 ]; tr[ 1 ] = a[ 1 ]; tr[ 2 ] = a[ 2 ];
+	_p3pCross( tr + 6, a, b );
+	__m128d e3n = _mm_sqrt_pd( _p3pDot( tr + 6, tr + 6 ) );
+	__m128d ie3 = _mm_and_pd( _mm_cmpgt_pd( e3n, zero ), _mm_div_pd( one, e3n ) );
+	for( int j = 6; j < 9; j++ )
+		tr[ j ] = _mm_mul_pd( tr[ j ], ie3 );
+	_p3pCross( tr + 3, tr + 6, a );
+	__m128d t3x = _p3pDot( tr, f3 );
+	__m128d t3y = _p3pDot( tr + 3, f3 );
+	__m128d t3z = _p3pDot( tr + 6, f3 );
+
+	/* intermediate world frame ( rows of nw ) */
+	__m128d nw[ 9 ], w[ 3 ];
+	for( int j = 0; j < 3; j++ )
+		nw[ j ] = _mm_sub_pd( Q2[ j ], Q1[ j ] );
+	__m128d d = _mm_sqrt_pd( _p3pDot( nw, nw ) );
+	__m128d id = _mm_and_pd( _mm_cmpgt_pd( d, zero ), _mm_div_pd( one, d ) );
+	for( int j = 0; j < 3; j++ ) {
+		nw[ j ] = _mm_mul_pd( nw[ j ], id );
+		w[ j ] = _mm_sub_pd( P3[ j ], Q1[ j ] );
+	}
+	_p3pCross( nw + 6, nw, w );
+	__m128d n3n = _mm_sqrt_pd( _p3pDot( nw + 6, nw + 6 ) );
+	__m128d in3 = _mm_and_pd( _mm_cmpgt_pd( n3n, zero ), _mm_div_pd( one, n3n ) );
+	for( int j = 6; j < 9; j++ )
+		nw[ j ] = _mm_mul_pd( nw[ j ], in3 );
+	_p3pCross( nw + 3, nw + 6, nw );
+
+	__m128d t3znz = _mm_cmpneq_pd( t3z, zero );
+	__m128d ok = _mm_and_pd( _mm_and_pd( _mm_cmpgt_pd( e3n, _mm_set1_pd( 1e-12 ) ),
+										 _mm_cmpgt_pd( n3n, _mm_mul_pd( _mm_mul_pd( _mm_set1_pd( 1e-9 ), d ), _mm_sqrt_pd( _p3pDot( w, w ) ) ) ) ),
+							 t3znz );
+
+	__m128d it3z = _mm_and_pd( t3znz, _mm_div_pd( one, t3z ) );
+	__m128d pf1 = _mm_mul_pd( t3x, it3z );
+	__m128d pf2 = _mm_mul_pd( t3y, it3z );
+	__m128d p1 = _p3pDot( nw, w );
+	__m128d p2 = _p3pDot( nw + 3, w );
+
+	__m128d cosBeta = _p3pDot( a, b );
+	__m128d bb = _mm_sub_pd( one, _mm_mul_pd( cosBeta, cosBeta ) );
+	bb = _mm_sub_pd( _mm_div_pd( one, _mm_max_pd( bb, _mm_set1_pd( 1e-15 ) ) ), one );
+	bb = _p3pSign( _mm_sqrt_pd( _mm_max_pd( bb, zero ) ), cosBeta );
+
+	/* quartic in cos( theta ) */
+	__m128d f1s = _mm_mul_pd( pf1, pf1 ), f2s = _mm_mul_pd( pf2, pf2 );
+	__m128d p1s = _mm_mul_pd( p1, p1 ), p1c = _mm_mul_pd( p1s, p1 ), p1q = _mm_mul_pd( p1c, p1 );
+	__m128d p2s = _mm_mul_pd( p2, p2 ), p2c = _mm_mul_pd( p2s, p2 ), p2q = _mm_mul_pd( p2c, p2 );
+	__m128d ds = _mm_mul_pd( d, d ), bs = _mm_mul_pd( bb, bb );
+	__m128d f2sp2s = _mm_mul_pd( f2s, p2s );
+
+	__m128d coeffs[ 5 ];
+	coeffs[ 0 ] = _mm_sub_pd( _mm_sub_pd( _mm_mul_pd( _p3pNeg( f2s ), p2q ), _mm_mul_pd( p2q, f1s ) ), p2q );
+	coeffs[ 1 ] = _mm_sub_pd( _mm_add_pd( _p3pMul( two, p2c, d, bb ), _mm_mul_pd( _p3pMul( two, f2s, p2c, d ), bb ) ),
+							  _mm_mul_pd( _p3pMul( two, pf2, p2c, pf1 ), d ) );
+
+	__m128d c2 = _mm_mul_pd( _mm_mul_pd( _p3pNeg( f2s ), p2s ), p1s );
+	c2 = _mm_sub_pd( c2, _p3pMul( f2s, p2s, ds, bs ) );
+	c2 = _mm_sub_pd( c2, _mm_mul_pd( f2sp2s, ds ) );
+	c2 = _mm_add_pd( c2, _mm_mul_pd( f2s, p2q ) );
+	c2 = _mm_add_pd( c2, _mm_mul_pd( p2q, f1s ) );
+	c2 = _mm_add_pd( c2, _p3pMul( two, p1, p2s, d ) );
+	c2 = _mm_add_pd( c2, _mm_mul_pd( _mm_mul_pd( _mm_mul_pd( _p3pMul( two, pf1, pf2, p1 ), p2s ), d ), bb ) );
+	c2 = _mm_sub_pd( c2, _mm_mul_pd( _mm_mul_pd( p2s, p1s ), f1s ) );
+	c2 = _mm_add_pd( c2, _mm_mul_pd( _p3pMul( two, p1, p2s, f2s ), d ) );
+	c2 = _mm_sub_pd( c2, _mm_mul_pd( _mm_mul_pd( p2s, ds ), bs ) );
+	c2 = _mm_sub_pd( c2, _mm_mul_pd( _mm_mul_pd( two, p1s ), p2s ) );
+	coeffs[ 2 ] = c2;
+
+	__m128d c1 = _mm_mul_pd( _p3pMul( two, p1s, p2, d ), bb );
+	c1 = _mm_add_pd( c1, _mm_mul_pd( _p3pMul( two, pf2, p2c, pf1 ), d ) );
+	c1 = _mm_sub_pd( c1, _mm_mul_pd( _p3pMul( two, f2s, p2c, d ), bb ) );
+	c1 = _mm_sub_pd( c1, _mm_mul_pd( _p3pMul( two, p1, p2, ds ), bb ) );
+	coeffs[ 3 ] = c1;
+
+	__m128d c0 = _mm_mul_pd( _mm_mul_pd( _mm_mul_pd( _p3pMul( _mm_set1_pd( -2.0 ), pf2, p2s, pf1 ), p1 ), d ), bb );
+	c0 = _mm_add_pd( c0, _mm_mul_pd( f2sp2s, ds ) );
+	c0 = _mm_add_pd( c0, _mm_mul_pd( _mm_mul_pd( two, p1c ), d ) );
+	c0 = _mm_sub_pd( c0, _mm_mul_pd( p1s, ds ) );
+	c0 = _mm_add_pd( c0, _mm_mul_pd( f2sp2s, p1s ) );
+	c0 = _mm_sub_pd( c0, p1q );
+	c0 = _mm_sub_pd( c0, _mm_mul_pd( _p3pMul( two, f2s, p2s, p1 ), d ) );
+	c0 = _mm_add_pd( c0, _mm_mul_pd( _mm_mul_pd( p2s, f1s ), p1s ) );
+	c0 = _mm_add_pd( c0, _mm_mul_pd( _mm_mul_pd( f2sp2s, ds ), bs ) );
+	coeffs[ 4 ] = c0;
+
+	__m128d roots[ 4 ], rvalid[ 4 ];
+	_p3pQuarticRoots( roots, rvalid, coeffs[ 0 ], coeffs[ 1 ], coeffs[ 2 ], coeffs[ 3 ], coeffs[ 4 ] );
+
+	/* back substitution of all roots */
+	__m128d db = _mm_mul_pd( d, bb );
+	__m128d mf1 = _p3pNeg( pf1 );
+	for( int k = 0; k < 4; k++ ) {
+		__m128d ct = roots[ k ];
+		__m128d vk = _mm_and_pd( _mm_and_pd( ok, rvalid[ k ] ), _mm_cmple_pd( _p3pAbs( ct ), _mm_set1_pd( 1.0 + 1e-9 ) ) );
+		ct = _mm_max_pd( ct, _mm_set1_pd( -1.0 ) );
+		ct = _mm_min_pd( ct, one );
+
+		__m128d cotAlpha = _mm_div_pd( _mm_add_pd( _mm_sub_pd( _mm_div_pd( _mm_mul_pd( mf1, p1 ), pf2 ), _mm_mul_pd( ct, p2 ) ), db ),
+									   _mm_sub_pd( _mm_add_pd( _mm_div_pd( _mm_mul_pd( _mm_mul_pd( mf1, ct ), p2 ), pf2 ), p1 ), d ) );
+		__m128d st = _mm_sqrt_pd( _mm_sub_pd( one, _mm_mul_pd( ct, ct ) ) );
+		__m128d sa = _mm_sqrt_pd( _mm_div_pd( one, _mm_add_pd( _mm_mul_pd( cotAlpha, cotAlpha ), one ) ) );
+		__m128d ca = _mm_sqrt_pd( _mm_max_pd( _mm_sub_pd( one, _mm_mul_pd( sa, sa ) ), zero ) );
+		ca = _p3pSign( ca, cotAlpha );
+
+		/* camera center in the intermediate world frame */
+		__m128d h = _mm_mul_pd( d, _mm_add_pd( _mm_mul_pd( sa, bb ), ca ) );
+		__m128d C[ 3 ] = { _mm_mul_pd( ca, h ), _mm_mul_pd( _mm_mul_pd( ct, sa ), h ), _mm_mul_pd( _mm_mul_pd( st, sa ), h ) };
+
+		/* camera center in the world frame: Q1 + N^T C */
+		__m128d Cw[ 3 ];
+		for( int j = 0; j < 3; j++ )
+			Cw[ j ] = _mm_add_pd( _mm_add_pd( _mm_add_pd( Q1[ j ], _mm_mul_pd( nw[ j ], C[ 0 ] ) ), _mm_mul_pd( nw[ 3 + j ], C[ 1 ] ) ),
+								  _mm_mul_pd( nw[ 6 + j ], C[ 2 ] ) );
+
+		/* world to camera rotation R = Tr^T Q N */
+		__m128d Q[ 9 ] = { _p3pNeg( ca ), _mm_mul_pd( _p3pNeg( sa ), ct ), _mm_mul_pd( _p3pNeg( sa ), st ),
+						   sa, _mm_mul_pd( _p3pNeg( ca ), ct ), _mm_mul_pd( _p3pNeg( ca ), st ),
+						   zero, _p3pNeg( st ), ct };
+		__m128d QN[ 9 ];
+		for( int r = 0; r < 3; r++ )
+			for( int j = 0; j < 3; j++ )
+				QN[ 3 * r + j ] = _mm_add_pd( _mm_add_pd( _mm_mul_pd( Q[ 3 * r ], nw[ j ] ), _mm_mul_pd( Q[ 3 * r + 1 ], nw[ 3 + j ] ) ),
+											  _mm_mul_pd( Q[ 3 * r + 2 ], nw[ 6 + j ] ) );
+
+		double* pose = poses + 12 * k * n + i;
+		for( int r = 0; r < 3; r++ ) {
+			__m128d t = zero;
+			for( int j = 0; j < 3; j++ ) {
+				__m128d rij = _mm_add_pd( _mm_add_pd( _mm_mul_pd( tr[ r ], QN[ j ] ), _mm_mul_pd( tr[ 3 + r ], QN[ 3 + j ] ) ),
+										  _mm_mul_pd( tr[ 6 + r ], QN[ 6 + j ] ) );
+				if( pair )
+					_mm_storeu_pd( pose + ( 3 * r + j ) * n, rij );
+				else
+					_mm_store_sd( pose + ( 3 * r + j ) * n, rij );
+				t = _mm_sub_pd( t, _mm_mul_pd( rij, Cw[ j ] ) );
+			}
+			if( pair )
+				_mm_storeu_pd( pose + ( 9 + r ) * n, t );
+			else
+				_mm_store_sd( pose + ( 9 + r ) * n, t );
+			/* false for inf and nan */
+			vk = _mm_and_pd( vk, _mm_cmpeq_pd( _mm_sub_pd( t, t ), zero ) );
+		}
+
+		int mask = _mm_movemask_pd( vk );
+		valid[ k * n + i ] = mask & 1;
+		if( pair )
+			valid[ k * n + i + 1 ] = ( mask >> 1 ) & 1;
+	}
+}
+
+void SIMDSSE2::p3p_d( double* poses, uint8_t* valid, const double* in, size_t n ) const
+{
+	size_t i = 0;
+	for( ; i + 1 < n; i += 2 )
+		_p3pLanes( poses, valid, in, n, i, true );
+	if( i < n )
+		_p3pLanes( poses, valid, in, n, i, false );
+}
+
 }
@@ -89,8 +89,12 @@ namespace cvt {
 			virtual void ConvolveClampVertSym_f( float* dst, const float** bufs, const float* weights, size_t numw, size_t width ) const;
 			virtual void ConvolveClampVertSym_f_to_u8( uint8_t* dst, const float** bufs, const float* weights, size_t numw, size_t width ) const;
 
+			virtual void Conv_f_to_u8( uint8_t* dst, const float* src, const size_t n ) const;
 			virtual void Conv_fx_to_u8( uint8_t* dst, const Fixed* src, const size_t n ) const;
+			virtual void Conv_u8_to_f( float* dst, const uint8_t* src, const size_t n ) const;
 			virtual void Conv_u16_to_f( float* dst, const uint16_t* src, const size_t n ) const;
+			virtual void Conv_f_to_f16( uint16_t* dst, const float* src, const size_t n ) const;
+			virtual void Conv_f16_to_f( float* dst, const uint16_t* src, const size_t n ) const;
 
 			virtual void Conv_YUYVu8_to_RGBAu8( uint8_t* dst, const uint8_t* src, const size_t n ) const;
 			virtual void Conv_YUYVu8_to_BGRAu8( uint8_t* dst, const uint8_t* src, const size_t n ) const;
@@ -109,8 +113,28 @@ namespace cvt {
 
 			virtual void pyrdownHalfHorizontal_1u8_to_1u16( uint16_t* dst, const uint8_t* src, size_t n ) const;
 			virtual void pyrdownHalfVertical_1u16_to_1u8( uint8_t* dst, uint16_t* rows[ 5 ], size_t n ) const;
+			virtual void pyrdownBox2x2_1f( float* dst, const float* src1, const float* src2, size_t n ) const;
+			virtual void pyrdownBox2x2_1u8( uint8_t* dst, const uint8_t* src1, const uint8_t* src2, size_t n ) const;
+
+			virtual void warpBilinear1f( float* dst, const float* coords, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fillcolor, size_t n ) const;
+			virtual void remapBilinear1f( float* dst, const int16_t* xy, const uint16_t* frac, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fill, size_t n ) const;
+			virtual void remapBilinear1u8( uint8_t* dst, const int16_t* xy, const uint16_t* frac, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint8_t fill, size_t n ) const;
+			virtual void remapBilinear4u8( uint8_t* dst, const int16_t* xy, const uint16_t* frac, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const;
+			virtual void warpBilinear4f( float* dst, const float* coords, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* fillcolor, size_t n ) const;
+			virtual void warpProjectiveCoords_f( float* coords, const float* point, const float* delta, size_t n ) const;
+			virtual void warpBicubic1f( float* dst, const float* coords, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, float fill, size_t n ) const;
+			virtual void warpBicubic4f( float* dst, const float* coords, const float* src, size_t srcStride, size_t srcWidth, size_t srcHeight, const float* fill, size_t n ) const;
+			virtual void warpBicubic4u8( uint8_t* dst, const float* coords, const uint8_t* src, size_t srcStride, size_t srcWidth, size_t srcHeight, uint32_t fill, size_t n ) const;
+			virtual float costTruncatedL1Line8f( float& wsum, const float* ref, const float* weights, const float* src, size_t srcWidth,
+												 float x, float dx, const float* truncation, const float* scale, size_t n ) const;
+
+			virtual void IIR4Horizontal4f( float* dst, const float* src, size_t width, const float* n, const float* m,
+										   const float* d, float b1, float b2 ) const;
+			virtual void IIR4Vertical_f( float* dst, const float** x, const float** y, const float* n, const float* d, size_t width ) const;
 
 			virtual void harrisScore1f( float* dst, const float* boxdx2, const float* boxdy2, const float* boxdxdy, float kappa, size_t width ) const;
+			virtual void shiTomasiScore1f( float* dst, const float* boxdx2, const float* boxdy2, const float* boxdxdy, size_t width ) const;
+			virtual void cornerTensor1f( float* dx2, float* dy2, float* dxdy, const float* prev, const float* cur, const float* next, size_t width ) const;
 
 			virtual float harrisResponse1u8( const uint8_t* _src, size_t srcStride, size_t w, size_t h, const float k ) const;
 			virtual float harrisResponse1u8( float & xx, float & xy, float & yy, const uint8_t* _src, size_t srcStride, size_t w, size_t h, const float k ) const;
@@ -118,6 +142,7 @@ namespace cvt {
 
             virtual void prefixSum1_u8_to_f( float * dst, size_t dstStride, const uint8_t * src, size_t srcStride, size_t width, size_t height ) const;
             virtual void prefixSumSqr1_u8_to_f( float * dst, size_t dStride, const uint8_t * src, size_t srcStride, size_t width, size_t height ) const;
+			virtual void prefixSumRow_f_to_f( float* dst, const float* src, const float* prev, size_t width, size_t channels ) const;
 
 			virtual void boxFilterPrefixSum1_f_to_u8( uint8_t* dst, size_t dstride, const float* src, size_t srcstride, size_t width, size_t height, size_t boxwidth, size_t boxheight ) const;
 
@@ -127,10 +152,26 @@ namespace cvt {
 			virtual void debayer_ODD_RGGBu8_RGBAu8( uint32_t* dst, const uint32_t* src1, const uint32_t* src2, const uint32_t* src3, size_t n ) const;
 			virtual void debayer_EVEN_RGGBu8_GRAYu8( uint32_t* dst, const uint32_t* src1, const uint32_t* src2, const uint32_t* src3, size_t n ) const;
 			virtual void debayer_ODD_RGGBu8_GRAYu8( uint32_t* dst, const uint32_t* src1, const uint32_t* src2, const uint32_t* src3, size_t n ) const;
+			virtual void debayer_LINEARu8_RGBAu8( uint32_t* dst, const uint8_t** src, size_t n, size_t phase, bool redrow ) const;
+			virtual void debayer_MHCu8_RGBAu8( uint32_t* dst, const uint8_t** src, size_t n, size_t phase, bool redrow ) const;
 
 			virtual void adaptiveThreshold1_f_to_u8( uint8_t* dst, const float* src, const float* srcmean, size_t n, float t ) const;
 			virtual void adaptiveThreshold1_f_to_f( float* dst, const float* src, const float* srcmean, size_t n, float t ) const;
 
+			virtual void cannyGradient1_f( float* mag, uint8_t* dir, const float* prev, const float* cur, const float* next, size_t width ) const;
+			virtual void cannyGradient1_f( float* mag, uint8_t* dir, const float* dx, const float* dy, size_t width ) const;
+			virtual void cannyNonMaxima1_f( uint8_t* dst, const float* mprev, const float* mcur, const float* mnext, const uint8_t* dir, size_t width, float low, float high ) const;
+
+			virtual void pdtvDual1_f( float* px, float* py, const float* u, const float* unext, const float* weight, size_t width, float sigma, float epsilon ) const;
+			virtual void pdtvPrimal1_f( float* u, float* ubar, const float* px, const float* py, const float* pyprev, const float* f, const float* lambda, float lambdac, size_t width, float tau, float theta, bool l1 ) const;
+
+			virtual void histogramBSplineWeights_f( int32_t* idx, float* weights, float* dweights, const float* src, size_t n, size_t bins ) const;
+			virtual void jointHistogramBSpline_f( float* hist, size_t bins, const int32_t* ia, const float* wa, const int32_t* ib, const float* wb, size_t n ) const;
+			virtual float kltSystem_f( float* jsum, float* residual, const float* warped, const float* patch, const float* jac, size_t nparams, size_t n ) const;
+			virtual void astStrength_u8( uint8_t* dst, const uint8_t* src, const int* offsets, size_t circle, size_t arc, uint8_t threshold, size_t n ) const;
+			virtual void boxSum_f( float* dst, const float* src, const int* offsets, size_t n ) const;
+			virtual void boxTest_f( uint8_t* dst, const float* src, const int* offsets, size_t n ) const;
+
 			virtual void sumPoints( Vector2f& dst, const Vector2f* src, size_t n ) const;
 			virtual void sumPoints( Vector3f& dst, const Vector3f* src, size_t n ) const;
 
@@ -144,6 +185,9 @@ namespace cvt {
 
             using SIMDSSE::projectPoints;
             virtual void projectPoints( Vector2f* dst, const Matrix4f& mat, const Vector3f* src, size_t n ) const;
+            virtual void reprojectionErrorSqr( float* dst, const float* P, const float* x, const float* y, const float* z,
+                                               const float* u, const float* v, size_t n ) const;
+            virtual void p3p_d( double* poses, uint8_t* valid, const double* in, size_t n ) const;
 
 		public:
 			virtual std::string name() const;
@@ -170,5 +170,37 @@ namespace cvt {
 		return bitcount;
 	}
 
+	void SIMDSSSE3::hammingDistance1N( uint32_t* dst, const uint8_t* query, const uint8_t* base, size_t len, size_t n ) const
+	{
+		/* the per byte counts of up to 31 blocks fit into 8 bit */
+		if( ( len & 0xf ) || len > 16 * 31 ) {
+			SIMD::hammingDistance1N( dst, query, base, len, n );
+			return;
+		}
+
+		static const uint8_t __attribute__((aligned( 16 ))) LUT[ 16 ] = { 0, 1, 1, 2,
+																		  1, 2, 2, 3,
+																		  1, 2, 2, 3,
+																		  2, 3, 3, 4 };
+
+		const __m128i mask = _mm_set1_epi8( 0x0f );
+		const __m128i lut  = _mm_load_si128( ( __m128i* )LUT );
+		const __m128i zero = _mm_setzero_si128();
+		const size_t blocks = len >> 4;
+
+		while( n-- ) {
+			__m128i sum = zero;
+			for( size_t b = 0; b < blocks; b++ ) {
+				__m128i xored = _mm_xor_si128( _mm_loadu_si128( ( __m128i* )( query + ( b << 4 ) ) ),
+											   _mm_loadu_si128( ( __m128i* )( base + ( b << 4 ) ) ) );
+				sum = _mm_add_epi8( sum, _mm_shuffle_epi8( lut, _mm_and_si128( xored, mask ) ) );
+				sum = _mm_add_epi8( sum, _mm_shuffle_epi8( lut, _mm_and_si128( _mm_srli_epi64( xored, 4 ), mask ) ) );
+			}
+			sum = _mm_sad_epu8( sum, zero );
+			*dst++ = _mm_cvtsi128_si32( sum ) + _mm_cvtsi128_si32( _mm_srli_si128( sum, 8 ) );
+			base += len;
+		}
+	}
+
 }
 
@@ -27,6 +27,8 @@
 #include <cvt/util/CVTTest.h>
 #include <cvt/math/Math.h>
 #include <sstream>
+#include <vector>
+#include <cstring>
 
 using namespace cvt;
 
@@ -130,6 +132,19 @@ static bool _hammingTest()
             }
         }
         
+        /* one to many, descriptor lengths handled by the different paths */
+        for( size_t i = 0; i < num; i++ ){
+            vecB[ i ] = ( uint8_t )rand();
+        }
+        const size_t lens[] = { 7, 32, 48, 64, 512 };
+        for( size_t l = 0; l < 5; l++ ){
+            const size_t len = lens[ l ], n = num / len - 1;
+            std::vector<uint32_t> dist( n );
+            simd->hammingDistance1N( &dist[ 0 ], vecA, vecB + len, len, n );
+            for( size_t i = 0; i < n; i++ )
+                tRes &= dist[ i ] == simd->hammingDistance( vecA, vecB + len * ( i + 1 ), len );
+        }
+
         result &= tRes;
         CVTTEST_PRINT( "HammingDistance " + simd->name() + ": ", tRes );
         
@@ -141,6 +156,99 @@ static bool _hammingTest()
     return result;
 }
 
+static bool _halfFloatTest()
+{
+    bool result = true;
+
+    const size_t num = 0x10000;
+    uint16_t* half = new uint16_t[ num ];
+    uint16_t* half2 = new uint16_t[ num ];
+    float* fl = new float[ num ];
+    float* fref = new float[ num ];
+    uint16_t* href = new uint16_t[ num ];
+
+    for( size_t i = 0; i < num; i++ )
+        half[ i ] = ( uint16_t ) i;
+
+    /* random floats covering the normal, denormal and overflow range of half */
+    srand( time( NULL ) );
+    for( size_t i = 0; i < num; i++ )
+        fref[ i ] = Math::rand( -1.0f, 1.0f ) * Math::pow( 2.0f, Math::rand( -26.0f, 17.0f ) );
+
+    SIMD* base = SIMD::get( SIMD_BASE );
+    base->Conv_f_to_f16( href, fref, num );
+
+    SIMDType bestType = SIMD::bestSupportedType();
+    for( int st = SIMD_BASE; st <= bestType; st++ ) {
+        SIMD* simd = SIMD::get( ( SIMDType ) st );
+        bool tRes = true;
+
+        /* every half value except NaNs has to survive the round trip, NaNs stay NaNs */
+        simd->Conv_f16_to_f( fl, half, num );
+        simd->Conv_f_to_f16( half2, fl, num );
+        for( size_t i = 0; i < num; i++ ) {
+            if( ( half[ i ] & 0x7c00 ) == 0x7c00 && ( half[ i ] & 0x3ff ) )
+                tRes &= ( half2[ i ] & 0x7c00 ) == 0x7c00 && ( half2[ i ] & 0x3ff );
+            else
+                tRes &= half2[ i ] == half[ i ];
+        }
+
+        simd->Conv_f_to_f16( half2, fref, num );
+        for( size_t i = 0; i < num; i++ )
+            tRes &= half2[ i ] == href[ i ];
+
+        result &= tRes;
+        CVTTEST_PRINT( "HalfFloat " + simd->name() + ": ", tRes );
+        delete simd;
+    }
+
+    delete base;
+    delete[] half;
+    delete[] half2;
+    delete[] fl;
+    delete[] fref;
+    delete[] href;
+    return result;
+}
+
+static bool _u8FloatTest()
+{
+    bool result = true;
+
+    const size_t num = 256 + 13;
+    uint8_t u8[ num ], u8out[ num ], u8ref[ num ];
+    float fl[ num ], fref[ num ], fsrc[ num ];
+
+    for( size_t i = 0; i < num; i++ ) {
+        u8[ i ] = ( uint8_t ) i;
+        fsrc[ i ] = Math::rand( -0.5f, 1.5f );
+    }
+    fsrc[ 0 ] = 1e10f;
+    fsrc[ 1 ] = -1e10f;
+
+    SIMD* base = SIMD::get( SIMD_BASE );
+    base->Conv_u8_to_f( fref, u8, num );
+    base->Conv_f_to_u8( u8ref, fsrc, num );
+
+    SIMDType bestType = SIMD::bestSupportedType();
+    for( int st = SIMD_BASE; st <= bestType; st++ ) {
+        SIMD* simd = SIMD::get( ( SIMDType ) st );
+        bool tRes = true;
+
+        simd->Conv_u8_to_f( fl, u8, num );
+        simd->Conv_f_to_u8( u8out, fsrc, num );
+        tRes &= memcmp( fl, fref, sizeof( float ) * num ) == 0;
+        tRes &= memcmp( u8out, u8ref, num ) == 0;
+
+        result &= tRes;
+        CVTTEST_PRINT( "u8 <-> float " + simd->name() + ": ", tRes );
+        delete simd;
+    }
+
+    delete base;
+    return result;
+}
+
 static bool _projectTest()
 {
 	std::vector<Vector2f> gtProjected;
@@ -196,6 +304,102 @@ static bool _projectTest()
 	return testResult;
 }
 
+static bool _reprojectionErrorTest()
+{
+	const size_t n = 203;
+	std::vector<float> x( n ), y( n ), z( n ), u( n ), v( n ), ref( n ), res( n );
+	float P[ 12 ];
+	for( size_t k = 0; k < 12; k++ )
+		P[ k ] = Math::rand( -1.0f, 1.0f );
+	P[ 11 ] = 5.0f;
+
+	for( size_t i = 0; i < n; i++ ){
+		x[ i ] = Math::rand( -3.0f, 3.0f );
+		y[ i ] = Math::rand( -3.0f, 3.0f );
+		z[ i ] = Math::rand( -3.0f, 3.0f );
+		u[ i ] = Math::rand( -10.0f, 10.0f );
+		v[ i ] = Math::rand( -10.0f, 10.0f );
+	}
+
+	SIMD* base = SIMD::get( SIMD_BASE );
+	base->reprojectionErrorSqr( &ref[ 0 ], P, &x[ 0 ], &y[ 0 ], &z[ 0 ], &u[ 0 ], &v[ 0 ], n );
+	delete base;
+
+	bool result = true;
+	SIMDType bestType = SIMD::bestSupportedType();
+	for( int st = SIMD_BASE; st <= bestType; st++ ) {
+		SIMD* simd = SIMD::get( ( SIMDType ) st );
+		simd->reprojectionErrorSqr( &res[ 0 ], P, &x[ 0 ], &y[ 0 ], &z[ 0 ], &u[ 0 ], &v[ 0 ], n );
+		bool fail = false;
+		for( size_t i = 0; i < n; i++ ){
+			if( Math::abs( ref[ i ] - res[ i ] ) > 1e-4f * Math::max( ref[ i ], 1.0f ) )
+				fail = true;
+		}
+		CVTTEST_PRINT( "ReprojectionError " + simd->name() + ": ", !fail );
+		result &= !fail;
+		delete simd;
+	}
+	return result;
+}
+
+static bool _p3pTest()
+{
+	/* odd to cover the tail of the SIMD versions */
+	const size_t n = 37;
+	std::vector<double> in( 18 * n ), ref( 48 * n ), res( 48 * n );
+	std::vector<uint8_t> refValid( 4 * n ), resValid( 4 * n );
+
+	/* points in front of a translated camera, bearings of the points */
+	for( size_t i = 0; i < n; i++ ){
+		double t[ 3 ] = { Math::rand( -0.5, 0.5 ), Math::rand( -0.5, 0.5 ), Math::rand( -0.5, 0.5 ) };
+		for( size_t k = 0; k < 3; k++ ){
+			double P[ 3 ] = { Math::rand( -1.0, 1.0 ), Math::rand( -1.0, 1.0 ), Math::rand( 4.0, 6.0 ) };
+			double b[ 3 ] = { P[ 0 ] + t[ 0 ], P[ 1 ] + t[ 1 ], P[ 2 ] + t[ 2 ] };
+			double len = Math::sqrt( b[ 0 ] * b[ 0 ] + b[ 1 ] * b[ 1 ] + b[ 2 ] * b[ 2 ] );
+			for( size_t j = 0; j < 3; j++ ){
+				in[ ( 3 * k + j ) * n + i ] = b[ j ] / len;
+				in[ ( 9 + 3 * k + j ) * n + i ] = P[ j ];
+			}
+		}
+	}
+
+	SIMD* base = SIMD::get( SIMD_BASE );
+	base->p3p_d( &ref[ 0 ], &refValid[ 0 ], &in[ 0 ], n );
+	delete base;
+
+	size_t numValid = 0;
+	for( size_t i = 0; i < refValid.size(); i++ )
+		numValid += refValid[ i ];
+	bool result = numValid >= n;
+
+	SIMDType bestType = SIMD::bestSupportedType();
+	for( int st = SIMD_BASE; st <= bestType; st++ ) {
+		SIMD* simd = SIMD::get( ( SIMDType ) st );
+		simd->p3p_d( &res[ 0 ], &resValid[ 0 ], &in[ 0 ], n );
+		bool fail = false;
+		for( size_t k = 0; k < 4; k++ ){
+			for( size_t i = 0; i < n; i++ ){
+				if( refValid[ k * n + i ] != resValid[ k * n + i ] ){
+					fail = true;
+					continue;
+				}
+				if( !refValid[ k * n + i ] )
+					continue;
+				/* same bits */
+				for( size_t m = 0; m < 12; m++ ){
+					size_t idx = ( 12 * k + m ) * n + i;
+					if( memcmp( &ref[ idx ], &res[ idx ], sizeof( double ) ) )
+						fail = true;
+				}
+			}
+		}
+		CVTTEST_PRINT( "P3P " + simd->name() + ": ", !fail );
+		result &= !fail;
+		delete simd;
+	}
+	return result;
+}
+
 static void _SADTest( float* src1, float* src2, size_t n )
 {
 	float reference = 0.0f;
@@ -339,6 +543,18 @@ BEGIN_CVTTEST( simd )
 		testResult = _projectTest();
         CVTTEST_PRINT( "Project Points 3d->2d", testResult );
 
+		testResult = _reprojectionErrorTest();
+        CVTTEST_PRINT( "Reprojection error", testResult );
+
+		testResult = _p3pTest();
+        CVTTEST_PRINT( "P3P", testResult );
+
+		testResult = _halfFloatTest();
+        CVTTEST_PRINT( "Half-float conversion", testResult );
+
+		testResult = _u8FloatTest();
+        CVTTEST_PRINT( "u8 <-> float conversion", testResult );
+
 #define TESTSIZE ( 2048 * 2048 )
 		fdst = new float[ TESTSIZE ];
 		fsrc1 = new float[ TESTSIZE ];
@@ -0,0 +1,363 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/BatchPnP.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/Exception.h>
+#include <cvt/math/Math.h>
+
+#include <float.h>
+#include <time.h>
+
+/* number of hypotheses solved together by the P3P stages */
+#define BATCHPNP_LANES 8
+/* number of points scored against a group of hypotheses */
+#define BATCHPNP_POINT_BLOCK 512
+#define BATCHPNP_HYPOTHESIS_GROUP 16
+
+namespace cvt
+{
+	/**
+	  P3P after Kneip et al., "A Novel Parametrization of the Perspective-Three-Point Problem for a Direct
+	  Computation of Absolute Camera Position and Orientation", for blocks of BATCHPNP_LANES samples.
+	  SIMD::p3p_d solves one sample per lane. The output holds four poses per sample, valid marks the solutions.
+	 */
+	class BatchPnP::P3PBody
+	{
+		public:
+			P3PBody( const BatchPnP& pnp, const size_t* samples, size_t n, Matrix4f* poses, uint8_t* valid ) :
+				_pnp( pnp ), _samples( samples ), _n( n ), _poses( poses ), _valid( valid )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				for( size_t block = begin; block < end; block++ ) {
+					size_t first = block * BATCHPNP_LANES;
+					solve( simd, first, Math::min<size_t>( BATCHPNP_LANES, _n - first ) );
+				}
+			}
+
+		private:
+			void solve( SIMD* simd, size_t first, size_t count ) const
+			{
+				const size_t L = BATCHPNP_LANES;
+				double in[ 18 * L ];
+				double poses[ 48 * L ];
+				uint8_t valid[ 4 * L ];
+
+				/* bearings and points in planes, surplus lanes repeat the first sample */
+				for( size_t l = 0; l < L; l++ ) {
+					size_t s = first + ( l < count ? l : 0 );
+					for( size_t k = 0; k < 3; k++ ) {
+						size_t idx = _samples[ 3 * s + k ];
+						in[ ( 3 * k + 0 ) * L + l ] = _pnp._bx[ idx ];
+						in[ ( 3 * k + 1 ) * L + l ] = _pnp._by[ idx ];
+						in[ ( 3 * k + 2 ) * L + l ] = _pnp._bz[ idx ];
+						in[ ( 9 + 3 * k + 0 ) * L + l ] = _pnp._x[ idx ];
+						in[ ( 9 + 3 * k + 1 ) * L + l ] = _pnp._y[ idx ];
+						in[ ( 9 + 3 * k + 2 ) * L + l ] = _pnp._z[ idx ];
+					}
+				}
+
+				simd->p3p_d( poses, valid, in, L );
+
+				for( size_t l = 0; l < count; l++ ) {
+					for( size_t k = 0; k < 4; k++ ) {
+						size_t out = 4 * ( first + l ) + k;
+						_valid[ out ] = valid[ k * L + l ];
+						if( !_valid[ out ] )
+							continue;
+
+						const double* p = poses + 12 * k * L + l;
+						Matrix4f& pose = _poses[ out ];
+						for( size_t i = 0; i < 3; i++ ) {
+							for( size_t j = 0; j < 3; j++ )
+								pose[ i ][ j ] = p[ ( 3 * i + j ) * L ];
+							pose[ i ][ 3 ] = p[ ( 9 + i ) * L ];
+						}
+						pose[ 3 ][ 0 ] = pose[ 3 ][ 1 ] = pose[ 3 ][ 2 ] = 0.0f;
+						pose[ 3 ][ 3 ] = 1.0f;
+					}
+				}
+			}
+
+			const BatchPnP&	_pnp;
+			const size_t*	_samples;
+			size_t			_n;
+			Matrix4f*		_poses;
+			uint8_t*		_valid;
+	};
+
+	class BatchPnP::EPnPBody
+	{
+		public:
+			EPnPBody( const BatchPnP& pnp, const size_t* samples, size_t sampleSize, Matrix4f* poses ) :
+				_pnp( pnp ), _samples( samples ), _sampleSize( sampleSize ), _poses( poses )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				for( size_t i = begin; i < end; i++ )
+					_pnp._epnp.solve( _poses[ i ], _pnp._p2d, _pnp._K, _samples + i * _sampleSize, _sampleSize );
+			}
+
+		private:
+			const BatchPnP&	_pnp;
+			const size_t*	_samples;
+			size_t			_sampleSize;
+			Matrix4f*		_poses;
+	};
+
+	/* scores groups of hypotheses against blocks of points */
+	class BatchPnP::ScoreBody
+	{
+		public:
+			ScoreBody( const BatchPnP& pnp, const float* projections, size_t* inliers, float* costs, float maxDistance ) :
+				_pnp( pnp ), _projections( projections ), _inliers( inliers ), _costs( costs ),
+				_thresh( maxDistance * maxDistance )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t n = _pnp.size();
+				float err[ BATCHPNP_POINT_BLOCK ];
+
+				for( size_t group = begin; group < end; group += BATCHPNP_HYPOTHESIS_GROUP ) {
+					size_t groupEnd = Math::min<size_t>( group + BATCHPNP_HYPOTHESIS_GROUP, end );
+					for( size_t h = group; h < groupEnd; h++ ) {
+						_inliers[ h ] = 0;
+						_costs[ h ] = 0.0f;
+					}
+
+					for( size_t p = 0; p < n; p += BATCHPNP_POINT_BLOCK ) {
+						size_t m = Math::min<size_t>( BATCHPNP_POINT_BLOCK, n - p );
+						for( size_t h = group; h < groupEnd; h++ ) {
+							simd->reprojectionErrorSqr( err, _projections + 12 * h, &_pnp._x[ p ], &_pnp._y[ p ], &_pnp._z[ p ],
+														&_pnp._u[ p ], &_pnp._v[ p ], m );
+							size_t count = 0;
+							float cost = 0.0f;
+							for( size_t i = 0; i < m; i++ ) {
+								count += err[ i ] < _thresh;
+								cost += Math::min( err[ i ], _thresh );
+							}
+							_inliers[ h ] += count;
+							_costs[ h ] += cost;
+						}
+					}
+				}
+			}
+
+		private:
+			const BatchPnP&	_pnp;
+			const float*	_projections;
+			size_t*			_inliers;
+			float*			_costs;
+			float			_thresh;
+	};
+
+	BatchPnP::BatchPnP( const PointSet3f& p3d, const PointSet2f& p2d, const Matrix3f& K ) :
+		_K( K ),
+		_p3d( p3d ),
+		_p2d( p2d ),
+		_epnp( _p3d ),
+		_rng( time( NULL ) )
+	{
+		if( p3d.size() != p2d.size() )
+			throw CVTException( "BatchPnP: number of 2D and 3D points differ" );
+
+		const size_t n = p3d.size();
+		_x.resize( n ); _y.resize( n ); _z.resize( n );
+		_u.resize( n ); _v.resize( n );
+		_bx.resize( n ); _by.resize( n ); _bz.resize( n );
+
+		Matrix3d Kinv;
+		for( size_t i = 0; i < 3; i++ )
+			for( size_t k = 0; k < 3; k++ )
+				Kinv[ i ][ k ] = K[ i ][ k ];
+		Kinv.inverseSelf();
+
+		for( size_t i = 0; i < n; i++ ) {
+			_x[ i ] = p3d[ i ].x;
+			_y[ i ] = p3d[ i ].y;
+			_z[ i ] = p3d[ i ].z;
+			_u[ i ] = p2d[ i ].x;
+			_v[ i ] = p2d[ i ].y;
+
+			Vector3d b = Kinv * Vector3d( p2d[ i ].x, p2d[ i ].y, 1.0 );
+			b.normalize();
+			_bx[ i ] = b.x;
+			_by[ i ] = b.y;
+			_bz[ i ] = b.z;
+		}
+	}
+
+	void BatchPnP::p3p( std::vector<Matrix4f>& poses, std::vector<size_t>& sampleIds, const size_t* samples, size_t n ) const
+	{
+		poses.clear();
+		sampleIds.clear();
+		if( !n )
+			return;
+
+		std::vector<Matrix4f> all( 4 * n );
+		std::vector<uint8_t> valid( 4 * n );
+		P3PBody body( *this, samples, n, &all[ 0 ], &valid[ 0 ] );
+		ParallelFor::run( body, 0, ( n + BATCHPNP_LANES - 1 ) / BATCHPNP_LANES );
+
+		poses.reserve( 4 * n );
+		sampleIds.reserve( 4 * n );
+		for( size_t i = 0; i < all.size(); i++ ) {
+			if( valid[ i ] ) {
+				poses.push_back( all[ i ] );
+				sampleIds.push_back( i >> 2 );
+			}
+		}
+	}
+
+	void BatchPnP::epnp( std::vector<Matrix4f>& poses, const size_t* samples, size_t sampleSize, size_t n ) const
+	{
+		if( sampleSize < 4 )
+			throw CVTException( "BatchPnP: EPnP needs at least 4 points per sample" );
+
+		poses.resize( n );
+		if( !n )
+			return;
+		EPnPBody body( *this, samples, sampleSize, &poses[ 0 ] );
+		ParallelFor::run( body, 0, n, 16 );
+	}
+
+	void BatchPnP::score( std::vector<size_t>& inliers, std::vector<float>& costs, const std::vector<Matrix4f>& poses, float maxDistance ) const
+	{
+		inliers.assign( poses.size(), 0 );
+		costs.assign( poses.size(), 0.0f );
+		if( poses.empty() || !size() )
+			return;
+
+		/* projection matrices K [ R | t ], row major */
+		std::vector<float> proj( 12 * poses.size() );
+		for( size_t h = 0; h < poses.size(); h++ ) {
+			float* P = &proj[ 12 * h ];
+			for( size_t r = 0; r < 3; r++ )
+				for( size_t c = 0; c < 4; c++ )
+					P[ 4 * r + c ] = _K[ r ][ 0 ] * poses[ h ][ 0 ][ c ] + _K[ r ][ 1 ] * poses[ h ][ 1 ][ c ] + _K[ r ][ 2 ] * poses[ h ][ 2 ][ c ];
+		}
+
+		ScoreBody body( *this, &proj[ 0 ], &inliers[ 0 ], &costs[ 0 ], maxDistance );
+		ParallelFor::run( body, 0, poses.size(), BATCHPNP_HYPOTHESIS_GROUP );
+	}
+
+	void BatchPnP::inliers( std::vector<size_t>& indices, const Matrix4f& pose, float maxDistance ) const
+	{
+		indices.clear();
+		const size_t n = size();
+		if( !n )
+			return;
+
+		float P[ 12 ];
+		for( size_t r = 0; r < 3; r++ )
+			for( size_t c = 0; c < 4; c++ )
+				P[ 4 * r + c ] = _K[ r ][ 0 ] * pose[ 0 ][ c ] + _K[ r ][ 1 ] * pose[ 1 ][ c ] + _K[ r ][ 2 ] * pose[ 2 ][ c ];
+
+		std::vector<float> err( n );
+		SIMD::instance()->reprojectionErrorSqr( &err[ 0 ], P, &_x[ 0 ], &_y[ 0 ], &_z[ 0 ], &_u[ 0 ], &_v[ 0 ], n );
+
+		float thresh = maxDistance * maxDistance;
+		for( size_t i = 0; i < n; i++ ) {
+			if( err[ i ] < thresh )
+				indices.push_back( i );
+		}
+	}
+
+	void BatchPnP::randomSamples( std::vector<size_t>& samples, size_t sampleSize, size_t n )
+	{
+		const int npts = size();
+		samples.resize( sampleSize * n );
+		for( size_t s = 0; s < n; s++ ) {
+			size_t* sample = &samples[ s * sampleSize ];
+			for( size_t k = 0; k < sampleSize; k++ ) {
+				bool unique;
+				do {
+					sample[ k ] = Math::min( _rng.uniform( 0, npts ), npts - 1 );
+					unique = true;
+					for( size_t j = 0; j < k; j++ )
+						unique &= sample[ j ] != sample[ k ];
+				} while( !unique );
+			}
+		}
+	}
+
+	Matrix4f BatchPnP::estimate( std::vector<size_t>& inlierIndices, size_t numHypotheses, float maxDistance, Solver solver )
+	{
+		const size_t sampleSize = solver == SOLVER_P3P ? 3 : 5;
+		if( size() < Math::max<size_t>( sampleSize, 4 ) )
+			throw CVTException( "BatchPnP: not enough correspondences" );
+
+		std::vector<size_t> samples;
+		randomSamples( samples, sampleSize, numHypotheses );
+
+		std::vector<Matrix4f> poses;
+		std::vector<size_t> sampleIds;
+		if( solver == SOLVER_P3P )
+			p3p( poses, sampleIds, &samples[ 0 ], numHypotheses );
+		else
+			epnp( poses, &samples[ 0 ], sampleSize, numHypotheses );
+
+		Matrix4f best;
+		best.setIdentity();
+		inlierIndices.clear();
+		if( poses.empty() )
+			return best;
+
+		std::vector<size_t> counts;
+		std::vector<float> costs;
+		score( counts, costs, poses, maxDistance );
+
+		size_t bestIdx = 0;
+		for( size_t h = 1; h < poses.size(); h++ ) {
+			if( counts[ h ] > counts[ bestIdx ] || ( counts[ h ] == counts[ bestIdx ] && costs[ h ] < costs[ bestIdx ] ) )
+				bestIdx = h;
+		}
+		best = poses[ bestIdx ];
+		inliers( inlierIndices, best, maxDistance );
+
+		/* refine with EPnP on the inliers, keep it if it is not worse */
+		if( inlierIndices.size() >= 6 ) {
+			std::vector<Matrix4f> refined;
+			epnp( refined, &inlierIndices[ 0 ], inlierIndices.size(), 1 );
+			refined.push_back( best );
+			score( counts, costs, refined, maxDistance );
+			if( counts[ 0 ] > counts[ 1 ] || ( counts[ 0 ] == counts[ 1 ] && costs[ 0 ] <= costs[ 1 ] ) ) {
+				best = refined[ 0 ];
+				inliers( inlierIndices, best, maxDistance );
+			}
+		}
+		return best;
+	}
+}
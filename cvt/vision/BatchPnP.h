@@ -0,0 +1,116 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_BATCHPNP_H
+#define CVT_BATCHPNP_H
+
+#include <cvt/geom/PointSet.h>
+#include <cvt/math/Matrix.h>
+#include <cvt/vision/EPnP.h>
+#include <cvt/util/RNG.h>
+
+#include <vector>
+
+namespace cvt
+{
+	/**
+	  @brief Pose estimation from many 2D-3D sample sets at once.
+
+	  The correspondences are stored once as structure of arrays together with their bearing vectors and the
+	  EPnP control points of the whole point set. Minimal P3P problems are solved for blocks of hypotheses
+	  with the p3p_d SIMD kernel, one hypothesis per lane, EPnP problems reuse the shared control points and
+	  barycentric coordinates. The reprojection errors of all points for all hypotheses are computed in blocks
+	  of points with reprojectionErrorSqr, so a block stays in the cache while it is scored against a group of
+	  hypotheses. Solving and scoring run in parallel over the hypotheses.
+	 */
+	class BatchPnP
+	{
+		public:
+			enum Solver {
+				SOLVER_P3P,
+				SOLVER_EPNP
+			};
+
+			BatchPnP( const PointSet3f& p3d, const PointSet2f& p2d, const Matrix3f& K );
+			~BatchPnP();
+
+			size_t size() const		{ return _x.size(); }
+
+			/**
+			  Solves the P3P problems of n samples, sample i consists of the point indices samples[ 3 * i ] to
+			  samples[ 3 * i + 2 ]. Every sample yields up to four poses ( world to camera ), sampleIds holds the
+			  sample of every pose.
+			 */
+			void p3p( std::vector<Matrix4f>& poses, std::vector<size_t>& sampleIds, const size_t* samples, size_t n ) const;
+
+			/* solves the EPnP problems of n samples with sampleSize ( >= 4 ) point indices each, one pose per sample */
+			void epnp( std::vector<Matrix4f>& poses, const size_t* samples, size_t sampleSize, size_t n ) const;
+
+			/**
+			  Scores all poses against all points: inliers holds the number of points with a reprojection error
+			  below maxDistance, costs the sum of the squared errors truncated at maxDistance^2.
+			 */
+			void score( std::vector<size_t>& inliers, std::vector<float>& costs, const std::vector<Matrix4f>& poses, float maxDistance ) const;
+
+			/* indices of the points with a reprojection error below maxDistance */
+			void inliers( std::vector<size_t>& indices, const Matrix4f& pose, float maxDistance ) const;
+
+			/**
+			  Solves numHypotheses random minimal samples ( 3 points for P3P, 5 for EPnP ) in one batch and keeps
+			  the pose with the most inliers ( lowest cost on ties ). The pose is refined with EPnP on its inliers.
+			 */
+			Matrix4f estimate( std::vector<size_t>& inliers, size_t numHypotheses, float maxDistance, Solver solver = SOLVER_P3P );
+
+			void setSeed( uint64_t seed )	{ _rng = RNG( seed ); }
+
+		private:
+			class P3PBody;
+			class EPnPBody;
+			class ScoreBody;
+
+			BatchPnP( const BatchPnP& );
+			BatchPnP& operator=( const BatchPnP& );
+
+			void randomSamples( std::vector<size_t>& samples, size_t sampleSize, size_t n );
+
+			/* points and measurements, structure of arrays */
+			std::vector<float>	_x, _y, _z;
+			std::vector<float>	_u, _v;
+			/* unit bearing vectors */
+			std::vector<double>	_bx, _by, _bz;
+
+			Matrix3f			_K;
+			PointSet3f			_p3d;
+			PointSet2f			_p2d;
+			EPnP<float>			_epnp;
+			RNG					_rng;
+	};
+
+	inline BatchPnP::~BatchPnP()
+	{
+	}
+}
+
+#endif
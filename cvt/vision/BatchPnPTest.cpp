@@ -0,0 +1,186 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/BatchPnP.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+
+#include <utility>
+
+namespace cvt {
+
+	/* points in front of the camera, the first numInliers project with noise, the others are random */
+	static void _batchPnPScene( PointSet3f& p3d, PointSet2f& p2d, Matrix4f& pose, Matrix3f& K, size_t n, size_t numInliers, float noise )
+	{
+		K = Matrix3f( 500.0f, 0.0f, 320.0f,
+					  0.0f, 500.0f, 240.0f,
+					  0.0f, 0.0f, 1.0f );
+
+		Matrix3f R;
+		R.setRotationXYZ( 0.2f, -0.4f, 0.3f );
+		Vector3f t( 0.3f, -0.2f, 1.5f );
+		pose.setIdentity();
+		for( size_t r = 0; r < 3; r++ ) {
+			for( size_t c = 0; c < 3; c++ )
+				pose[ r ][ c ] = R[ r ][ c ];
+			pose[ r ][ 3 ] = t[ r ];
+		}
+		Matrix3f Rt = R.transpose();
+
+		p3d.clear();
+		p2d.clear();
+		for( size_t i = 0; i < n; i++ ) {
+			Vector3f pc( Math::rand( -2.0f, 2.0f ), Math::rand( -1.5f, 1.5f ), Math::rand( 3.0f, 8.0f ) );
+			p3d.add( Rt * ( pc - t ) );
+
+			Vector3f pp = K * pc;
+			Vector2f p( pp.x / pp.z, pp.y / pp.z );
+			if( i < numInliers ) {
+				p.x += Math::rand( -noise, noise );
+				p.y += Math::rand( -noise, noise );
+			} else {
+				p.x = Math::rand( 0.0f, 640.0f );
+				p.y = Math::rand( 0.0f, 480.0f );
+			}
+			p2d.add( p );
+		}
+	}
+
+	static bool _batchPnPPoseEqual( const Matrix4f& a, const Matrix4f& b, float eps )
+	{
+		for( size_t r = 0; r < 3; r++ )
+			for( size_t c = 0; c < 4; c++ )
+				if( Math::abs( a[ r ][ c ] - b[ r ][ c ] ) > eps )
+					return false;
+		return true;
+	}
+
+	typedef std::pair<Matrix4f, std::vector<size_t> > BatchPnPResult;
+
+	/* pose and inliers of a seeded RANSAC run */
+	struct BatchPnPEstimate {
+		BatchPnPEstimate( BatchPnP& p ) : pnp( p ) {}
+		void operator()( BatchPnPResult& res ) const
+		{
+			pnp.setSeed( 7 );
+			res.first = pnp.estimate( res.second, 200, 3.0f );
+		}
+		BatchPnP& pnp;
+	};
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( BatchPnP )
+
+bool result = true;
+bool b;
+
+PointSet3f p3d;
+PointSet2f p2d;
+Matrix4f gt;
+Matrix3f K;
+
+/* exact correspondences: every sample has to contain the true pose */
+_batchPnPScene( p3d, p2d, gt, K, 100, 100, 0.0f );
+BatchPnP exact( p3d, p2d, K );
+
+std::vector<size_t> samples;
+for( size_t i = 0; i < 100; i++ ) {
+	size_t a = Math::rand( 0, 99 ), c = a;
+	while( c == a )
+		c = Math::rand( 0, 99 );
+	size_t d = a;
+	while( d == a || d == c )
+		d = Math::rand( 0, 99 );
+	samples.push_back( a );
+	samples.push_back( c );
+	samples.push_back( d );
+}
+
+std::vector<Matrix4f> poses;
+std::vector<size_t> sampleIds;
+exact.p3p( poses, sampleIds, &samples[ 0 ], 100 );
+std::vector<bool> found( 100, false );
+for( size_t i = 0; i < poses.size(); i++ )
+	found[ sampleIds[ i ] ] = found[ sampleIds[ i ] ] || _batchPnPPoseEqual( poses[ i ], gt, 1e-2f );
+size_t numFound = 0;
+for( size_t i = 0; i < found.size(); i++ )
+	numFound += found[ i ];
+b = numFound >= 98 && poses.size() <= 400;
+CVTTEST_PRINT( "P3P", b );
+result &= b;
+
+/* EPnP on samples of 6 points */
+samples.clear();
+for( size_t i = 0; i < 20; i++ )
+	for( size_t k = 0; k < 6; k++ )
+		samples.push_back( ( i * 7 + k * 13 ) % 100 );
+exact.epnp( poses, &samples[ 0 ], 6, 20 );
+b = poses.size() == 20;
+for( size_t i = 0; i < poses.size(); i++ )
+	b &= _batchPnPPoseEqual( poses[ i ], gt, 1e-2f );
+CVTTEST_PRINT( "EPnP", b );
+result &= b;
+
+/* batched scoring equals the inliers of the single poses */
+_batchPnPScene( p3d, p2d, gt, K, 1000, 600, 1.0f );
+BatchPnP pnp( p3d, p2d, K );
+pnp.setSeed( 42 );
+samples.clear();
+for( size_t i = 0; i < 3 * 300; i++ )
+	samples.push_back( ( i * 31 + i / 3 ) % 1000 );
+pnp.p3p( poses, sampleIds, &samples[ 0 ], 300 );
+std::vector<size_t> counts, inl;
+std::vector<float> costs;
+pnp.score( counts, costs, poses, 3.0f );
+b = counts.size() == poses.size() && poses.size() > 0;
+for( size_t i = 0; i < poses.size() && b; i++ ) {
+	pnp.inliers( inl, poses[ i ], 3.0f );
+	b &= inl.size() == counts[ i ];
+}
+CVTTEST_PRINT( "Score", b );
+result &= b;
+
+/* RANSAC with 40% outliers */
+Matrix4f est = pnp.estimate( inl, 500, 3.0f );
+b = _batchPnPPoseEqual( est, gt, 5e-2f ) && inl.size() >= 590 && inl.size() <= 620;
+CVTTEST_PRINT( "Estimate P3P", b );
+result &= b;
+
+est = pnp.estimate( inl, 500, 3.0f, BatchPnP::SOLVER_EPNP );
+b = _batchPnPPoseEqual( est, gt, 5e-2f ) && inl.size() >= 590 && inl.size() <= 620;
+CVTTEST_PRINT( "Estimate EPnP", b );
+result &= b;
+
+/* the result does not depend on the number of threads */
+b = testThreadInvariance<BatchPnPResult>( BatchPnPEstimate( pnp ), testEqual<BatchPnPResult> );
+CVTTEST_PRINT( "Threads", b );
+result &= b;
+
+return result;
+
+END_CVTTEST
@@ -0,0 +1,409 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/CapturePreprocessor.h>
+#include <cvt/gfx/IDebayer.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/Exception.h>
+
+#include <vector>
+
+namespace cvt {
+
+	/* converts rows of the raw frame to GRAY_FLOAT or GRAY_UINT8 */
+	class CaptureRowConverter {
+		public:
+			CaptureRowConverter( const uint8_t* src, size_t sstride, const IFormat& sformat, size_t width, size_t height,
+								 const IFormat& dformat, IConvertFlags flags ) :
+				_src( src ),
+				_sstride( sstride ),
+				_sformat( sformat ),
+				_width( width ),
+				_height( height ),
+				_dformat( dformat ),
+				_flags( flags )
+			{
+			}
+
+			/* convert the rows [ ystart, yend ) to dst + y * dstride, tmp provides space for one float row */
+			void convert( uint8_t* dst, size_t dstride, size_t ystart, size_t yend, float* tmp ) const;
+
+		private:
+			const uint8_t*	_src;
+			size_t			_sstride;
+			const IFormat&	_sformat;
+			size_t			_width;
+			size_t			_height;
+			const IFormat&	_dformat;
+			IConvertFlags	_flags;
+	};
+
+	void CaptureRowConverter::convert( uint8_t* dst, size_t dstride, size_t ystart, size_t yend, float* tmp ) const
+	{
+		SIMD* simd = SIMD::instance();
+		const bool gf = _dformat.formatID == IFORMAT_GRAY_FLOAT;
+
+		switch( _sformat.formatID ) {
+			case IFORMAT_BAYER_RGGB_UINT8:
+			case IFORMAT_BAYER_GRBG_UINT8:
+			case IFORMAT_BAYER_GBRG_UINT8:
+			case IFORMAT_BAYER_BGGR_UINT8:
+				IDebayer::debayerRows( dst, dstride, _dformat, _src, _sstride, _sformat, _width, _height, ystart, yend, _flags );
+				return;
+			default:
+				break;
+		}
+
+		for( size_t y = ystart; y < yend; y++ ) {
+			const uint8_t* s = _src + y * _sstride;
+			uint8_t* d = dst + y * dstride;
+			float* df = gf ? ( float* ) d : tmp;
+
+			switch( _sformat.formatID ) {
+				case IFORMAT_GRAY_UINT8:
+				case IFORMAT_NV12_UINT8:
+				case IFORMAT_I420_UINT8:
+					/* the luma plane is the gray image */
+					if( gf )
+						simd->Conv_u8_to_f( df, s, _width );
+					else
+						simd->Memcpy( d, s, _width );
+					continue;
+				case IFORMAT_GRAY_FLOAT:
+					if( gf )
+						simd->Memcpy( d, s, _width * sizeof( float ) );
+					else
+						simd->Conv_f_to_u8( d, ( const float* ) s, _width );
+					continue;
+				case IFORMAT_RGBA_UINT8:
+					if( gf )
+						simd->Conv_RGBAu8_to_GRAYf( df, s, _width );
+					else
+						simd->Conv_RGBAu8_to_GRAYu8( d, s, _width );
+					continue;
+				case IFORMAT_BGRA_UINT8:
+					if( gf )
+						simd->Conv_BGRAu8_to_GRAYf( df, s, _width );
+					else
+						simd->Conv_BGRAu8_to_GRAYu8( d, s, _width );
+					continue;
+				case IFORMAT_RGB_UINT8:
+					if( gf )
+						simd->Conv_RGBu8_to_GRAYf( df, s, _width );
+					else
+						simd->Conv_RGBu8_to_GRAYu8( d, s, _width );
+					continue;
+				case IFORMAT_BGR_UINT8:
+					if( gf )
+						simd->Conv_BGRu8_to_GRAYf( df, s, _width );
+					else
+						simd->Conv_BGRu8_to_GRAYu8( d, s, _width );
+					continue;
+				case IFORMAT_YUYV_UINT8:
+					if( gf )
+						simd->Conv_YUYVu8_to_GRAYf( df, s, _width );
+					else
+						simd->Conv_YUYVu8_to_GRAYu8( d, s, _width );
+					continue;
+				case IFORMAT_UYVY_UINT8:
+					if( gf )
+						simd->Conv_UYVYu8_to_GRAYf( df, s, _width );
+					else
+						simd->Conv_UYVYu8_to_GRAYu8( d, s, _width );
+					continue;
+				case IFORMAT_RGBA_FLOAT:
+					simd->Conv_RGBAf_to_GRAYf( df, ( const float* ) s, _width );
+					break;
+				case IFORMAT_BGRA_FLOAT:
+					simd->Conv_BGRAf_to_GRAYf( df, ( const float* ) s, _width );
+					break;
+				default:
+					continue;
+			}
+
+			/* float sources with GRAY_UINT8 destination went through tmp */
+			if( !gf )
+				simd->Conv_f_to_u8( d, tmp, _width );
+		}
+	}
+
+	/* converts bands of rows into one image, used as input for the rectification */
+	class CaptureConvertBand {
+		public:
+			CaptureConvertBand( const CaptureRowConverter& conv, uint8_t* dst, size_t dstride, size_t width ) :
+				_conv( conv ), _dst( dst ), _dstride( dstride ), _width( width )
+			{
+			}
+
+			void operator()( size_t ystart, size_t yend ) const
+			{
+				ScopedBuffer<float, true> tmp( _width );
+				_conv.convert( _dst, _dstride, ystart, yend, tmp.ptr() );
+			}
+
+		private:
+			const CaptureRowConverter&	_conv;
+			uint8_t*					_dst;
+			size_t						_dstride;
+			size_t						_width;
+	};
+
+	struct CaptureLevel {
+		uint8_t*	base;
+		size_t		stride;
+		size_t		width;
+		size_t		height;
+	};
+
+	/*
+	   computes bands of _bandsize rows of the first level ( by conversion or rectification ) and
+	   immediately the corresponding rows of all 2x2 downscaled levels while they are still in the cache.
+	   _bandsize is a multiple of 2^( levels - 1 ), thus every band is independent of the others.
+	 */
+	class CapturePyramidBand {
+		public:
+			CapturePyramidBand( const std::vector<CaptureLevel>& levels, size_t bandsize, const IFormat& format,
+								const CaptureRowConverter* conv, const IRemap* remap,
+								const uint8_t* buf, size_t bstride, size_t bwidth, size_t bheight ) :
+				_levels( levels ), _bandsize( bandsize ), _format( format ), _conv( conv ), _remap( remap ),
+				_buf( buf ), _bstride( bstride ), _bwidth( bwidth ), _bheight( bheight )
+			{
+			}
+
+			void operator()( size_t bstart, size_t bend ) const;
+
+		private:
+			const std::vector<CaptureLevel>&	_levels;
+			size_t								_bandsize;
+			const IFormat&						_format;
+			const CaptureRowConverter*			_conv;
+			const IRemap*						_remap;
+			const uint8_t*						_buf;
+			size_t								_bstride;
+			size_t								_bwidth;
+			size_t								_bheight;
+	};
+
+	void CapturePyramidBand::operator()( size_t bstart, size_t bend ) const
+	{
+		SIMD* simd = SIMD::instance();
+		const CaptureLevel& l0 = _levels[ 0 ];
+		ScopedBuffer<float, true> tmp( _conv ? l0.width : 1 );
+
+		for( size_t b = bstart; b < bend; b++ ) {
+			size_t y0 = b * _bandsize;
+			size_t y1 = Math::min( y0 + _bandsize, l0.height );
+
+			if( _conv )
+				_conv->convert( l0.base, l0.stride, y0, y1, tmp.ptr() );
+			else
+				_remap->applyRows( l0.base, l0.stride, _buf, _bstride, _bwidth, _bheight, _format, y0, y1 );
+
+			for( size_t l = 1; l < _levels.size(); l++ ) {
+				const CaptureLevel& prev = _levels[ l - 1 ];
+				const CaptureLevel& cur = _levels[ l ];
+				size_t ye = Math::min( ( y0 + _bandsize ) >> l, cur.height );
+
+				for( size_t y = y0 >> l; y < ye; y++ ) {
+					const uint8_t* s1 = prev.base + 2 * y * prev.stride;
+					const uint8_t* s2 = s1 + prev.stride;
+					uint8_t* d = cur.base + y * cur.stride;
+					if( _format == IFormat::GRAY_FLOAT )
+						simd->pyrdownBox2x2_1f( ( float* ) d, ( const float* ) s1, ( const float* ) s2, cur.width );
+					else
+						simd->pyrdownBox2x2_1u8( d, s1, s2, cur.width );
+				}
+			}
+		}
+	}
+
+	CapturePreprocessor::CapturePreprocessor( const IFormat& format, IConvertFlags flags ) :
+		_format( format ),
+		_flags( flags ),
+		_rectify( false )
+	{
+		if( format != IFormat::GRAY_FLOAT && format != IFormat::GRAY_UINT8 )
+			throw CVTException( "CapturePreprocessor: destination format has to be GRAY_FLOAT or GRAY_UINT8" );
+	}
+
+	CapturePreprocessor::~CapturePreprocessor()
+	{
+	}
+
+	void CapturePreprocessor::setRectification( const Image& warp )
+	{
+		_remap.update( warp );
+		_rectify = true;
+	}
+
+	void CapturePreprocessor::setRectification( const IRemap& remap )
+	{
+		_remap = remap;
+		_rectify = true;
+	}
+
+	void CapturePreprocessor::clearRectification()
+	{
+		_rectify = false;
+	}
+
+	void CapturePreprocessor::checkSource( const Image& raw ) const
+	{
+		switch( raw.format().formatID ) {
+			case IFORMAT_GRAY_UINT8:
+			case IFORMAT_GRAY_FLOAT:
+			case IFORMAT_RGBA_UINT8:
+			case IFORMAT_BGRA_UINT8:
+			case IFORMAT_RGBA_FLOAT:
+			case IFORMAT_BGRA_FLOAT:
+			case IFORMAT_RGB_UINT8:
+			case IFORMAT_BGR_UINT8:
+			case IFORMAT_YUYV_UINT8:
+			case IFORMAT_UYVY_UINT8:
+			case IFORMAT_NV12_UINT8:
+			case IFORMAT_I420_UINT8:
+			case IFORMAT_BAYER_RGGB_UINT8:
+			case IFORMAT_BAYER_GRBG_UINT8:
+			case IFORMAT_BAYER_GBRG_UINT8:
+			case IFORMAT_BAYER_BGGR_UINT8:
+				break;
+			default:
+				throw CVTException( "CapturePreprocessor: unsupported source format" );
+		}
+
+		if( raw.width() < 2 || raw.height() < 2 )
+			throw CVTException( "CapturePreprocessor: source image too small" );
+		if( _rectify && ( raw.width() >= 0x8000 || raw.height() >= 0x8000 ) )
+			throw CVTException( "CapturePreprocessor: source image too large for rectification" );
+	}
+
+	void CapturePreprocessor::convertSource( const Image& raw )
+	{
+		size_t sstride, dstride;
+
+		_buffer.reallocate( raw.width(), raw.height(), _format );
+
+		const uint8_t* src = raw.map( &sstride );
+		uint8_t* dst = _buffer.map( &dstride );
+
+		CaptureRowConverter conv( src, sstride, raw.format(), raw.width(), raw.height(), _format, _flags );
+		CaptureConvertBand band( conv, dst, dstride, raw.width() );
+		ParallelFor::run( band, 0, raw.height(), 32 );
+
+		_buffer.unmap( dst );
+		raw.unmap( src );
+	}
+
+	void CapturePreprocessor::sweep( Image** images, size_t n, const Image& raw )
+	{
+		std::vector<CaptureLevel> levels( n );
+		size_t bstride = 0, sstride = 0;
+		const uint8_t* buf = NULL;
+		const uint8_t* src = NULL;
+
+		for( size_t i = 0; i < n; i++ ) {
+			levels[ i ].base = images[ i ]->map( &levels[ i ].stride );
+			levels[ i ].width = images[ i ]->width();
+			levels[ i ].height = images[ i ]->height();
+		}
+
+		if( _rectify ) {
+			buf = _buffer.map( &bstride );
+		} else {
+			src = raw.map( &sstride );
+		}
+
+		CaptureRowConverter conv( src, sstride, raw.format(), raw.width(), raw.height(), _format, _flags );
+		size_t bandsize = Math::max<size_t>( 32, ( size_t ) 1 << ( n - 1 ) );
+		CapturePyramidBand band( levels, bandsize, _format, _rectify ? NULL : &conv, &_remap,
+								 buf, bstride, _buffer.width(), _buffer.height() );
+		ParallelFor::run( band, 0, ( levels[ 0 ].height + bandsize - 1 ) / bandsize );
+
+		if( _rectify )
+			_buffer.unmap( buf );
+		else
+			raw.unmap( src );
+
+		for( size_t i = 0; i < n; i++ )
+			images[ i ]->unmap( levels[ i ].base );
+	}
+
+	void CapturePreprocessor::process( ImagePyramid& pyr, const Image& raw )
+	{
+		build( pyr, raw, IScaleFilterGauss(), pyr.scaleFactor() == 0.5f );
+	}
+
+	void CapturePreprocessor::process( ImagePyramid& pyr, const Image& raw, const IScaleFilter& sfilter )
+	{
+		bool box = dynamic_cast<const IScaleFilterBox*>( &sfilter ) != NULL;
+		build( pyr, raw, sfilter, box && pyr.scaleFactor() == 0.5f );
+	}
+
+	/* fused: all octaves are 2x2 box averages computed within the sweep, otherwise they are scaled with sfilter */
+	void CapturePreprocessor::build( ImagePyramid& pyr, const Image& raw, const IScaleFilter& sfilter, bool fused )
+	{
+		checkSource( raw );
+
+		size_t w = _rectify ? _remap.width() : raw.width();
+		size_t h = _rectify ? _remap.height() : raw.height();
+		size_t n = fused ? pyr.octaves() : 1;
+		std::vector<Image*> images( n );
+
+		float fw = w;
+		float fh = h;
+		pyr[ 0 ].reallocate( w, h, _format );
+		images[ 0 ] = &pyr[ 0 ];
+		for( size_t i = 1; i < n; i++ ) {
+			fw *= 0.5f;
+			fh *= 0.5f;
+			pyr[ i ].reallocate( ( size_t ) fw, ( size_t ) fh, _format );
+			images[ i ] = &pyr[ i ];
+		}
+
+		if( _rectify )
+			convertSource( raw );
+		sweep( &images[ 0 ], n, raw );
+
+		if( !fused )
+			pyr.recompute( sfilter );
+	}
+
+	void CapturePreprocessor::process( Image& dst, const Image& raw )
+	{
+		checkSource( raw );
+
+		Image* img = &dst;
+		if( _rectify ) {
+			dst.reallocate( _remap.width(), _remap.height(), _format );
+			convertSource( raw );
+		} else {
+			dst.reallocate( raw.width(), raw.height(), _format );
+		}
+		sweep( &img, 1, raw );
+	}
+
+}
@@ -0,0 +1,101 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#ifndef CVT_CAPTUREPREPROCESSOR_H
+#define CVT_CAPTUREPREPROCESSOR_H
+
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IConvert.h>
+#include <cvt/gfx/IRemap.h>
+#include <cvt/vision/ImagePyramid.h>
+
+namespace cvt {
+
+	/**
+	  @brief Fused preprocessing of raw camera frames.
+
+	  Converts a raw camera frame ( GRAY, RGB(A), BGR(A), YUYV, UYVY, NV12, I420 or Bayer )
+	  directly into a GRAY_FLOAT or GRAY_UINT8 image pyramid, optionally undistorted/rectified
+	  by a warp image or remap as provided by StereoRectification.
+	  For pyramids with scale factor 0.5 and a box filter the conversion and all downscaled octaves
+	  are computed in one sweep over parallel bands of rows, each octave is the 2x2 box average of
+	  the previous one. Otherwise the first octave is computed in one sweep and the remaining octaves
+	  are scaled with the given IScaleFilter, like ImagePyramid::update does.
+	  With rectification the frame is first converted into an internal buffer, which is reused
+	  between calls, since the warp accesses arbitrary source rows.
+	 */
+	class CapturePreprocessor {
+		public:
+			CapturePreprocessor( const IFormat& format = IFormat::GRAY_FLOAT, IConvertFlags flags = ICONVERT_DEBAYER_LINEAR );
+			~CapturePreprocessor();
+
+			const IFormat&	format() const { return _format; }
+
+			/**
+			  @brief Undistort/rectify with the GRAYALPHA_FLOAT warp image, the first octave gets the size of the warp.
+			 */
+			void			setRectification( const Image& warp );
+			void			setRectification( const IRemap& remap );
+			void			clearRectification();
+			bool			hasRectification() const { return _rectify; }
+
+			/**
+			  @brief Convert the raw frame into the first octave of pyr and compute the remaining octaves.
+
+			  Octaves of scale factor 0.5 are the 2x2 box average computed within the sweep, other
+			  scale factors use IScaleFilterGauss.
+			 */
+			void			process( ImagePyramid& pyr, const Image& raw );
+
+			/**
+			  @brief Convert the raw frame into the first octave of pyr and scale the remaining octaves with sfilter.
+
+			  Only an IScaleFilterBox with scale factor 0.5 takes the fused path.
+			 */
+			void			process( ImagePyramid& pyr, const Image& raw, const IScaleFilter& sfilter );
+
+			/**
+			  @brief Convert ( and rectify ) the raw frame into dst without building a pyramid.
+			 */
+			void			process( Image& dst, const Image& raw );
+
+		private:
+			CapturePreprocessor( const CapturePreprocessor& );
+			CapturePreprocessor& operator=( const CapturePreprocessor& );
+
+			void			checkSource( const Image& raw ) const;
+			void			convertSource( const Image& raw );
+			void			sweep( Image** images, size_t n, const Image& raw );
+			void			build( ImagePyramid& pyr, const Image& raw, const IScaleFilter& sfilter, bool fused );
+
+			const IFormat&	_format;
+			IConvertFlags	_flags;
+			bool			_rectify;
+			IRemap			_remap;
+			Image			_buffer;
+	};
+
+}
+
+#endif
@@ -0,0 +1,246 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/CapturePreprocessor.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/gfx/IDebayer.h>
+#include <cvt/gfx/ifilter/IWarp.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/math/Math.h>
+
+using namespace cvt;
+
+static void _randomImage( Image& img )
+{
+	IMapScoped<uint8_t> map( img );
+	size_t n = img.width() * img.format().bpp;
+	for( size_t y = 0; y < img.height(); y++ ) {
+		for( size_t x = 0; x < n; x++ )
+			map.ptr()[ x ] = ( uint8_t ) Math::rand( 0.0f, 255.0f );
+		map++;
+	}
+}
+
+static bool _compareFloat( const Image& a, const Image& b, float eps )
+{
+	if( a.width() != b.width() || a.height() != b.height() )
+		return false;
+
+	IMapScoped<const float> ma( a );
+	IMapScoped<const float> mb( b );
+	for( size_t y = 0; y < a.height(); y++ ) {
+		for( size_t x = 0; x < a.width(); x++ ) {
+			if( Math::abs( ma.ptr()[ x ] - mb.ptr()[ x ] ) > eps )
+				return false;
+		}
+		ma++;
+		mb++;
+	}
+	return true;
+}
+
+/* every octave has to be the 2x2 average of the previous one */
+static bool _checkOctaves( const ImagePyramid& pyr )
+{
+	bool ret = true;
+	for( size_t l = 1; l < pyr.octaves(); l++ ) {
+		const Image& prev = pyr[ l - 1 ];
+		const Image& cur = pyr[ l ];
+		ret &= cur.width() == prev.width() / 2 && cur.height() == prev.height() / 2;
+
+		IMapScoped<const float> mp( prev );
+		IMapScoped<const float> mc( cur );
+		for( size_t y = 0; y < cur.height(); y++ ) {
+			const float* p1 = mp.line( 2 * y );
+			const float* p2 = mp.line( 2 * y + 1 );
+			for( size_t x = 0; x < cur.width(); x++ ) {
+				float v = ( p1[ 2 * x ] + p1[ 2 * x + 1 ] + p2[ 2 * x ] + p2[ 2 * x + 1 ] ) * 0.25f;
+				ret &= Math::abs( mc.ptr()[ x ] - v ) < 1e-6f;
+			}
+			mc++;
+		}
+	}
+	return ret;
+}
+
+static bool _rgbaPyramidTest()
+{
+	Image raw( 203, 157, IFormat::RGBA_UINT8 );
+	Image ref;
+	ImagePyramid pyr( 4, 0.5f );
+	CapturePreprocessor pre( IFormat::GRAY_FLOAT );
+
+	_randomImage( raw );
+	raw.convert( ref, IFormat::GRAY_FLOAT );
+	pre.process( pyr, raw );
+
+	return _compareFloat( pyr[ 0 ], ref, 1e-6f ) && _checkOctaves( pyr );
+}
+
+static bool _bayerTest()
+{
+	Image raw( 128, 96, IFormat::BAYER_GBRG_UINT8 );
+	Image ref( 128, 96, IFormat::GRAY_UINT8 );
+	ImagePyramid pyr( 3, 0.5f );
+	CapturePreprocessor pre( IFormat::GRAY_UINT8, ICONVERT_DEBAYER_HQLINEAR );
+
+	_randomImage( raw );
+	IDebayer::debayer( ref, raw, ICONVERT_DEBAYER_HQLINEAR );
+	pre.process( pyr, raw );
+
+	return testImagesEqual( pyr[ 0 ], ref ) && pyr[ 2 ].width() == 32 && pyr[ 2 ].height() == 24;
+}
+
+static Vector2f _identity( const Vector2f& pt )
+{
+	return pt;
+}
+
+static bool _rectificationTest()
+{
+	Image raw( 160, 120, IFormat::YUYV_UINT8 );
+	Image warp( 160, 120, IFormat::GRAYALPHA_FLOAT );
+	ImagePyramid pyr( 3, 0.5f );
+	ImagePyramid pyrrect( 3, 0.5f );
+	CapturePreprocessor pre;
+	bool ret = true;
+
+	_randomImage( raw );
+	IWarp::warpGeneric( warp, _identity );
+
+	pre.process( pyr, raw );
+	pre.setRectification( warp );
+	pre.process( pyrrect, raw );
+
+	for( size_t l = 0; l < pyr.octaves(); l++ )
+		ret &= _compareFloat( pyr[ l ], pyrrect[ l ], 1e-5f );
+	return ret;
+}
+
+static bool _scaleFactorTest()
+{
+	Image raw( 160, 120, IFormat::BGRA_UINT8 );
+	Image ref;
+	ImagePyramid pyr( 3, 0.7f );
+	ImagePyramid pyrref( 3, 0.7f );
+	CapturePreprocessor pre;
+	bool ret = true;
+
+	_randomImage( raw );
+	raw.convert( ref, IFormat::GRAY_FLOAT );
+	pyrref.update( ref );
+	pre.process( pyr, raw );
+
+	for( size_t l = 0; l < pyr.octaves(); l++ )
+		ret &= _compareFloat( pyr[ l ], pyrref[ l ], 1e-5f );
+	return ret;
+}
+
+/* a non box filter has to give the same octaves as ImagePyramid::update, also with scale factor 0.5 */
+static bool _filterTest()
+{
+	Image raw( 160, 120, IFormat::RGBA_UINT8 );
+	Image ref;
+	ImagePyramid pyr( 3, 0.5f );
+	ImagePyramid pyrref( 3, 0.5f );
+	CapturePreprocessor pre;
+	bool ret = true;
+
+	_randomImage( raw );
+	raw.convert( ref, IFormat::GRAY_FLOAT );
+	pyrref.update( ref, IScaleFilterBilinear() );
+	pre.process( pyr, raw, IScaleFilterBilinear() );
+	for( size_t l = 0; l < pyr.octaves(); l++ )
+		ret &= _compareFloat( pyr[ l ], pyrref[ l ], 1e-5f );
+
+	pre.process( pyr, raw, IScaleFilterBox() );
+	ret &= _checkOctaves( pyr );
+	return ret;
+}
+
+static bool _simdTest()
+{
+	const size_t n = 37;
+	float fsrc[ 2 ][ 2 * n ], fout[ n ], fref[ n ];
+	uint8_t src[ 2 ][ 2 * n ], out[ n ], ref[ n ];
+	bool ret = true;
+
+	for( size_t k = 0; k < 2; k++ ) {
+		for( size_t x = 0; x < 2 * n; x++ ) {
+			src[ k ][ x ] = ( uint8_t ) Math::rand( 0.0f, 255.0f );
+			fsrc[ k ][ x ] = Math::rand( -1.0f, 1.0f );
+		}
+	}
+
+	SIMD* base = SIMD::get( SIMD_BASE );
+	base->pyrdownBox2x2_1u8( ref, src[ 0 ], src[ 1 ], n );
+	base->pyrdownBox2x2_1f( fref, fsrc[ 0 ], fsrc[ 1 ], n );
+	SIMDType bestType = SIMD::bestSupportedType();
+	for( int st = SIMD_BASE; st <= bestType; st++ ) {
+		SIMD* simd = SIMD::get( ( SIMDType ) st );
+		simd->pyrdownBox2x2_1u8( out, src[ 0 ], src[ 1 ], n );
+		simd->pyrdownBox2x2_1f( fout, fsrc[ 0 ], fsrc[ 1 ], n );
+		for( size_t x = 0; x < n; x++ ) {
+			ret &= out[ x ] == ref[ x ];
+			ret &= Math::abs( fout[ x ] - fref[ x ] ) < 1e-6f;
+		}
+		delete simd;
+	}
+	delete base;
+	return ret;
+}
+
+BEGIN_CVTTEST( CapturePreprocessor )
+	bool result = true;
+	bool b;
+
+	b = _rgbaPyramidTest();
+	CVTTEST_PRINT( "RGBA_UINT8 to GRAY_FLOAT pyramid", b );
+	result &= b;
+
+	b = _bayerTest();
+	CVTTEST_PRINT( "Bayer to GRAY_UINT8 pyramid", b );
+	result &= b;
+
+	b = _rectificationTest();
+	CVTTEST_PRINT( "Identity rectification", b );
+	result &= b;
+
+	b = _scaleFactorTest();
+	CVTTEST_PRINT( "Scale factor 0.7", b );
+	result &= b;
+
+	b = _filterTest();
+	CVTTEST_PRINT( "Scale filter with scale factor 0.5", b );
+	result &= b;
+
+	b = _simdTest();
+	CVTTEST_PRINT( "pyrdownBox2x2 SIMD", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
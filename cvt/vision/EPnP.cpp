@@ -24,6 +24,8 @@
 
 #include <cvt/vision/EPnP.h>
 
+#include <Eigen/Eigenvalues>
+
 namespace cvt
 {
 	template <typename T>
@@ -36,19 +38,28 @@ namespace cvt
 
 	template <typename T>
 	void EPnP<T>::solve( Matrix4<T> & transform, const PointSet<2, T> & pointSet, const Matrix3<T> & K ) const
+	{
+		std::vector<size_t> indices( pointSet.size() );
+		for( size_t i = 0; i < indices.size(); i++ )
+			indices[ i ] = i;
+		solve( transform, pointSet, K, &indices[ 0 ], indices.size() );
+	}
+
+	template <typename T>
+	void EPnP<T>::solve( Matrix4<T> & transform, const PointSet<2, T> & pointSet, const Matrix3<T> & K, const size_t* indices, size_t n ) const
 	{
 		Eigen::Matrix<T, 12, 12> A;
 
 		// build the matrix (M^T*M in the paper)
-		buildSystem( A, pointSet, K );
+		buildSystem( A, pointSet, K, indices, n );
 
-		// compute the svd: we know that it's symmetric and square, so no preconditioning!
-		Eigen::JacobiSVD<Eigen::Matrix<T, 12, 12>, Eigen::NoQRPreconditioner> svd( A, Eigen::ComputeFullU | Eigen::ComputeFullV );
-		const Eigen::Matrix<T, 12, 12> & V = svd.matrixV();
-		const Eigen::Matrix<T, 12, 1> & v0 = V.col( 11 );
-		const Eigen::Matrix<T, 12, 1> & v1 = V.col( 10 );
-		const Eigen::Matrix<T, 12, 1> & v2 = V.col(  9 );
-		const Eigen::Matrix<T, 12, 1> & v3 = V.col(  8 );
+		// A is symmetric: the eigenvectors of the smallest eigenvalues span the null space
+		Eigen::SelfAdjointEigenSolver<Eigen::Matrix<T, 12, 12> > eig( A );
+		const Eigen::Matrix<T, 12, 12> & V = eig.eigenvectors();
+		const Eigen::Matrix<T, 12, 1> & v0 = V.col( 0 );
+		const Eigen::Matrix<T, 12, 1> & v1 = V.col( 1 );
+		const Eigen::Matrix<T, 12, 1> & v2 = V.col( 2 );
+		const Eigen::Matrix<T, 12, 1> & v3 = V.col( 3 );
 
 		// distances of the control points
 		Eigen::Matrix<T, 6, 1> controlPointDistances, cpDistSqr;
@@ -74,20 +85,23 @@ namespace cvt
 		// N=2;
 		solveBetaN2( betas, constraintMat, cpDistSqr );
 		combinedV = betas[ 0 ] * v0 + betas[ 1 ] * v1;
+		correctSign( combinedV, indices[ 0 ] );
 		computePose( Tout[ 0 ], combinedV, _controlPoints );
-		err[ 0 ] = reprojectionError( Tout[ 0 ], K44, _points3D, pointSet );
+		err[ 0 ] = reprojectionError( Tout[ 0 ], K44, _points3D, pointSet, indices, n );
 
 		// N=3;
 		solveBetaN3( betas, constraintMat, cpDistSqr );
 		combinedV = betas[ 0 ] * v0 + betas[ 1 ] * v1 + betas[ 2 ] * v2;
+		correctSign( combinedV, indices[ 0 ] );
 		computePose( Tout[ 1 ], combinedV, _controlPoints );
-		err[ 1 ] = reprojectionError( Tout[ 1 ], K44, _points3D, pointSet );
+		err[ 1 ] = reprojectionError( Tout[ 1 ], K44, _points3D, pointSet, indices, n );
 
 		// N=4;
 		solveBetaN4( betas, constraintMat, cpDistSqr );
 		combinedV = betas[ 0 ] * v0 + betas[ 1 ] * v1 + betas[ 2 ] * v2 + betas[ 3 ] * v3;
+		correctSign( combinedV, indices[ 0 ] );
 		computePose( Tout[ 2 ], combinedV, _controlPoints );
-		err[ 2 ] = reprojectionError( Tout[ 2 ], K44, _points3D, pointSet );
+		err[ 2 ] = reprojectionError( Tout[ 2 ], K44, _points3D, pointSet, indices, n );
 
 		size_t i = 0;
 		if( err[ 1 ] < err[ 0 ] ){
@@ -166,13 +180,15 @@ namespace cvt
 	}
 
 	template<typename T>
-	void EPnP<T>::buildSystem( Eigen::Matrix<T, 12, 12> & A, const PointSet<2, T> & points2D, const Matrix3<T> & K ) const
+	void EPnP<T>::buildSystem( Eigen::Matrix<T, 12, 12> & A, const PointSet<2, T> & points2D, const Matrix3<T> & K,
+							   const size_t* indices, size_t n ) const
 	{
 		// build the matrix:
 		A.setZero();
 
 		Eigen::Matrix<T, 12, 1> l0, l1;
-		for( size_t i = 0; i < points2D.size(); i++ ){
+		for( size_t j = 0; j < n; j++ ){
+			size_t i = indices[ j ];
 			for( size_t k = 0; k < 4; k++ ){
 				l0[ k * 3 ]		= _barycentricCoords[ i ][ k ] * K[ 0 ][ 0 ];
 				l0[ k * 3 + 1 ] = _barycentricCoords[ i ][ k ] * K[ 0 ][ 1 ];
@@ -388,6 +404,16 @@ namespace cvt
 		cpDelta[ 5 ] = ( _controlPoints[ 2 ] - _controlPoints[ 3 ] ).length();
 	}
 
+	template <typename T>
+	void EPnP<T>::correctSign( Eigen::Matrix<T, 12, 1> & estimatedCoords, size_t index ) const
+	{
+		T z = ( T )0;
+		for( size_t k = 0; k < 4; k++ )
+			z += _barycentricCoords[ index ][ k ] * estimatedCoords[ 3 * k + 2 ];
+		if( z < 0 )
+			estimatedCoords = -estimatedCoords;
+	}
+
 	template <typename T>
 	void EPnP<T>::computePose( Matrix4<T> & transform,
 							   const Eigen::Matrix<T, 12, 1> & estimatedCoords,
@@ -406,14 +432,16 @@ namespace cvt
 	T EPnP<T>::reprojectionError( const Matrix4<T> & transform,
 								  const Matrix4<T> & K44,
 								  const PointSet<3, T> & p3d,
-								  const PointSet<2, T> & p2d ) const
+								  const PointSet<2, T> & p2d,
+								  const size_t* indices, size_t n ) const
 	{
 		T error = ( T )0;
 		Matrix4<T> P = K44 * transform;
 		Vector3<T> tmp;
 		Vector2<T> proj;
 
-		for( size_t i = 0, n = p3d.size(); i < n; i++ ){
+		for( size_t j = 0; j < n; j++ ){
+			size_t i = indices[ j ];
 			tmp = P * p3d[ i ];
 			proj[ 0 ] = tmp[ 0 ] / tmp[ 2 ];
 			proj[ 1 ] = tmp[ 1 ] / tmp[ 2 ];
@@ -45,6 +45,17 @@ namespace cvt {
              */
             void solve( Matrix4<T> & transform, const PointSet<2, T> & pointSet, const Matrix3<T> & K ) const;
 
+            /**
+             * Compute pose from a subset of the 2D-3D matches, the control points
+             * of the whole 3D pointset are reused
+             * @param transform	Output transformation (Rotation and Translation)
+             * @param pointSet	The 2D correspondences of all 3D points
+             * @param K			Intrinsic Matrix
+             * @param indices	The indices of the matches to use (at least 4)
+             * @param n			The number of indices
+             */
+            void solve( Matrix4<T> & transform, const PointSet<2, T> & pointSet, const Matrix3<T> & K, const size_t* indices, size_t n ) const;
+
         private:
             const PointSet<3, T>&	_points3D;
             // the control points
@@ -56,7 +67,8 @@ namespace cvt {
 
             void computeControlPoints( const PointSet<3, T> & ptSet );
             void computeBarycentricCoords( const PointSet<3, T> & ptSet );
-            void buildSystem( Eigen::Matrix<T, 12, 12> & A, const PointSet<2, T> & points2D, const Matrix3<T> & K ) const;
+            void buildSystem( Eigen::Matrix<T, 12, 12> & A, const PointSet<2, T> & points2D, const Matrix3<T> & K,
+                              const size_t* indices, size_t n ) const;
 
             void computeControlPointsDelta( Eigen::Matrix<T, 6, 1> & cpDelta ) const;
 
@@ -72,6 +84,9 @@ namespace cvt {
                               const Eigen::Matrix<T, 6, 10> & C,
                               const Eigen::Matrix<T, 6,  1> & dSqr ) const;
 
+            /* flip the camera coordinates of the control points if the point index lies behind the camera */
+            void correctSign( Eigen::Matrix<T, 12, 1> & estimatedCoords, size_t index ) const;
+
             void computePose( Matrix4<T> & transform,
                               const Eigen::Matrix<T, 12, 1> & estimatedCoords,
                               const PointSet<3, T> & controlPoints ) const;
@@ -79,7 +94,8 @@ namespace cvt {
 			T	reprojectionError( const Matrix4<T> & transform,
 								   const Matrix4<T> & K44,
 								   const PointSet<3, T> & p3d,
-								   const PointSet<2, T> & p2d ) const;
+								   const PointSet<2, T> & p2d,
+								   const size_t* indices, size_t n ) const;
 
             void fillConstraintMatrix( Eigen::Matrix<T, 6, 10> & C,
                                        const Eigen::Matrix<T, 12, 1> & v0,
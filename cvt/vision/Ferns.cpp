@@ -24,30 +24,202 @@
 
 #include <cvt/vision/Ferns.h>
 
-#include <cvt/vision/FAST.h>
+#include <cvt/vision/PatchGenerator.h>
+#include <cvt/vision/features/FAST.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/RNG.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/Exception.h>
+
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
 
 namespace cvt
 {
+	static const char FERNS_MAGIC[ 8 ] = { 'C', 'V', 'T', 'F', 'E', 'R', 'N', 'S' };
+	static const uint32_t FERNS_VERSION = 1;
+
+	/* trains a range of classes, the counts are accumulated per class and worker */
+	class Ferns::TrainBody
+	{
+		public:
+			TrainBody( const Ferns& ferns, const Image& img, float* posteriors ) :
+				_ferns( ferns ), _img( img ), _posteriors( posteriors )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				const size_t nf = _ferns._numFerns;
+				const size_t nr = _ferns.numResults();
+				const size_t nc = _ferns.numClasses();
+				const size_t S = _ferns._testsPerFern;
+				const int half = _ferns._patchSize >> 1;
+				const double norm = 1.0 / ( ( double ) _ferns._trainingSamples + nr * _ferns._regPrior );
+				SIMD* simd = SIMD::instance();
+
+				PatchGenerator gen( Rangef( 0.0f, Math::TWO_PI ), Rangef( 0.6f, 1.5f ), _ferns._patchSize, 3.0 /* noise */ );
+				Image patch;
+				std::vector<uint32_t> counts( nf * nr );
+				std::vector<int> offsets;
+				size_t offsetStride = 0;
+
+				for( size_t c = begin; c < end; c++ ) {
+					gen.setSeed( _ferns._seed + c + 1 );
+					std::fill( counts.begin(), counts.end(), 0 );
+
+					for( size_t s = 0; s < _ferns._trainingSamples; s++ ) {
+						gen.next( patch, _img, _ferns._modelFeatures[ c ] );
+
+						size_t stride;
+						const uint8_t* p = patch.map( &stride );
+						if( stride != offsetStride ) {
+							_ferns.testOffsets( offsets, stride );
+							offsetStride = stride;
+						}
+						int center = half * stride + half;
+						for( size_t f = 0; f < nf; f++ ) {
+							uint32_t idx;
+							simd->fernIndex_u8( &idx, p, &center, 1, &offsets[ 2 * S * f ], S );
+							counts[ f * nr + idx ]++;
+						}
+						patch.unmap( p );
+					}
+
+					for( size_t i = 0; i < nf * nr; i++ )
+						_posteriors[ i * nc + c ] = Math::log( ( counts[ i ] + _ferns._regPrior ) * norm );
+				}
+			}
+
+		private:
+			const Ferns&	_ferns;
+			const Image&	_img;
+			float*			_posteriors;
+	};
+
+	class Ferns::ClassifyBody
+	{
+		public:
+			ClassifyBody( const Ferns& ferns, const uint8_t* base, const int* points, const size_t* pointIdx,
+						  const int* offsets, int* classes, float* probs ) :
+				_ferns( ferns ), _base( base ), _points( points ), _pointIdx( pointIdx ),
+				_offsets( offsets ), _classes( classes ), _probs( probs )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				const size_t nf = _ferns._numFerns;
+				const size_t nr = _ferns.numResults();
+				const size_t nc = _ferns.numClasses();
+				const size_t S = _ferns._testsPerFern;
+				const size_t m = end - begin;
+				const float* post = _ferns._posteriors;
+				SIMD* simd = SIMD::instance();
+
+				std::vector<uint32_t> idx( nf * m );
+				std::vector<float> scores( nc );
+
+				for( size_t f = 0; f < nf; f++ )
+					simd->fernIndex_u8( &idx[ f * m ], _base, _points + begin, m, _offsets + 2 * S * f, S );
+
+				for( size_t k = 0; k < m; k++ ) {
+					simd->Memcpy( ( uint8_t* ) &scores[ 0 ], ( const uint8_t* ) ( post + idx[ k ] * nc ), nc * sizeof( float ) );
+					for( size_t f = 1; f < nf; f++ )
+						simd->Add( &scores[ 0 ], &scores[ 0 ], post + ( f * nr + idx[ f * m + k ] ) * nc, nc );
+
+					size_t best = 0;
+					for( size_t c = 1; c < nc; c++ ) {
+						if( scores[ c ] > scores[ best ] )
+							best = c;
+					}
+
+					double sum = 0.0;
+					for( size_t c = 0; c < nc; c++ )
+						sum += Math::exp( scores[ c ] - scores[ best ] );
+
+					size_t i = _pointIdx[ begin + k ];
+					_classes[ i ] = best;
+					_probs[ i ] = 1.0 / sum;
+				}
+			}
+
+		private:
+			const Ferns&	_ferns;
+			const uint8_t*	_base;
+			const int*		_points;
+			const size_t*	_pointIdx;
+			const int*		_offsets;
+			int*			_classes;
+			float*			_probs;
+	};
 
 	Ferns::Ferns( uint32_t patchSize, uint32_t numOverallTests, uint32_t numFerns ) :
 		_patchSize( patchSize ),
 		_numFerns( numFerns ),
 		_nTests( numOverallTests ),
 		_trainingSamples( 15000 ),
-		_featureDetector( 0 )
+		_regPrior( 1.0f ),
+		_seed( time( NULL ) ),
+		_posteriors( 0 ),
+		_map( 0 ),
+		_mappedSize( 0 )
 	{
-		_ferns.reserve( numFerns );
+		if( patchSize == 0 || patchSize > 255 )
+			throw CVTException( "Ferns: patch size has to be in [ 1, 255 ]" );
 
 		while( ( _nTests % _numFerns ) != 0 ){
 			_nTests++;
 		}
 		_testsPerFern = _nTests / _numFerns;
 
-		_featureDetector = new FAST( SEGMENT_9 );
-		_featureDetector->setThreshold( 40 );
+		if( _testsPerFern > 24 )
+			throw CVTException( "Ferns: too many tests per fern" );
 	}
 
-	Ferns::Ferns( const std::string & fileName ) : _featureDetector( 0 )
+	Ferns::Ferns( const std::string & fileName ) :
+		_trainingSamples( 15000 ),
+		_regPrior( 1.0f ),
+		_seed( time( NULL ) ),
+		_posteriors( 0 ),
+		_map( 0 ),
+		_mappedSize( 0 )
+	{
+		char magic[ sizeof( FERNS_MAGIC ) ] = { 0 };
+		std::ifstream file( fileName.c_str(), std::ifstream::in | std::ifstream::binary );
+		if( !file.is_open() )
+			throw CVTException( "Ferns: could not open file" );
+		file.read( magic, sizeof( magic ) );
+		file.close();
+
+		if( memcmp( magic, FERNS_MAGIC, sizeof( magic ) ) == 0 )
+			loadBinary( fileName );
+		else
+			loadText( fileName );
+	}
+
+	Ferns::~Ferns()
+	{
+		unmap();
+	}
+
+	void Ferns::unmap()
+	{
+		if( _map ){
+			munmap( _map, _mappedSize );
+			_map = 0;
+			_mappedSize = 0;
+		}
+	}
+
+	void Ferns::loadText( const std::string & fileName )
 	{
 		std::ifstream file;
 		std::string line;
@@ -80,8 +252,7 @@ namespace cvt
 		strTok.str( line );
 		strTok >> numFeatures;
 
-        int x, y;
-		std::string lineVal;
+		float x, y;
 		for( size_t i = 0; i < numFeatures; i++ ){
 			getline( file, line );
 
@@ -90,11 +261,13 @@ namespace cvt
 			strTok >> x;
 			strTok >> y;
 
-			_modelFeatures.push_back( Feature2Df( x, y ) );
+			_modelFeatures.push_back( Vector2f( x, y ) );
 		}
 
+		_tests.resize( 4 * _numFerns * _testsPerFern );
+		_posteriorData.resize( _numFerns * numResults() * numFeatures );
+
 		uint32_t numProbs;
-		float	 regPrior;
 		for( size_t i = 0; i < _numFerns; i++ ){
 			getline( file, line );
 			strTok.clear();
@@ -104,201 +277,240 @@ namespace cvt
 			getline( file, line );
 			strTok.clear();
 			strTok.str( line );
-			strTok >> regPrior;
+			strTok >> _regPrior;
 
-			_ferns.push_back( Fern( _testsPerFern, _patchSize ) );
-			Eigen::Vector2i p0, p1;
+			if( numProbs != numResults() )
+				throw CVTException( "Ferns: invalid model file" );
+
+			int v;
 			for( uint32_t t = 0; t < _testsPerFern; t++ ){
 				getline( file, line );
 
 				strTok.clear();
 				strTok.str( line );
-
-				strTok >> p0[ 0 ];
-				strTok >> p0[ 1 ];
-				strTok >> p1[ 0 ];
-				strTok >> p1[ 1 ];
-				_ferns.back().addTest( p0, p1 );
+				for( size_t k = 0; k < 4; k++ ){
+					strTok >> v;
+					_tests[ 4 * ( i * _testsPerFern + t ) + k ] = v;
+				}
 			}
 
+			float* post = &_posteriorData[ i * numProbs * numFeatures ];
 			for( size_t p = 0; p < numProbs; p++ ){
-				double prob;
 				getline( file, line );
 				strTok.clear();
 				strTok.str( line );
-				for( size_t c = 0; c < _modelFeatures.size(); c++ ){
-					strTok >> prob;
-					_ferns.back().setProbabilityForTest( p, c, prob );
+				for( size_t c = 0; c < numFeatures; c++ ){
+					strTok >> *post++;
 				}
-
 			}
 		}
-	}
 
-	Ferns::~Ferns()
-	{
-		if( _featureDetector )
-			delete _featureDetector;
+		if( !file.good() )
+			throw CVTException( "Ferns: invalid model file" );
+
+		_posteriors = _posteriorData.size() ? &_posteriorData[ 0 ] : 0;
 	}
 
-	void Ferns::train( const Image & img )
+	void Ferns::loadBinary( const std::string & fileName )
 	{
-		RNG rng( time( NULL ) );
-
-		Eigen::Vector2i x0, x1;
-		for( uint32_t i = 0; i < _numFerns; i++ ){
-			_ferns.push_back( Fern( _testsPerFern, _patchSize ) );
-
-			for( uint32_t t = 0; t < _testsPerFern; t++ ){
-				x0[ 0 ] = rng.uniform( 0, _patchSize );
-				x0[ 1 ] = rng.uniform( 0, _patchSize );
-				x1[ 0 ] = rng.uniform( 0, _patchSize );
-				x1[ 1 ] = rng.uniform( 0, _patchSize );
+		int fd = open( fileName.c_str(), O_RDONLY, 0 );
+		if( fd < 0 ){
+			String msg( "Could not open file: " );
+			msg += strerror( errno );
+			throw CVTException( msg.c_str() );
+		}
 
-				_ferns.back().addTest( x0, x1 );
-			}
+		struct stat fileInfo;
+		if( fstat( fd, &fileInfo ) == -1 ){
+			String msg( "fstat error: " );
+			msg += strerror( errno );
+			close( fd );
+			throw CVTException( msg.c_str() );
 		}
 
-		// detect features in the "model"-image
-		std::vector<Feature2Df> features;
-        VectorFeature2DInserter<float> inserter( features );
-		_featureDetector->extract( img, inserter );
+		_mappedSize = fileInfo.st_size;
+		_map = mmap( 0, _mappedSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+		/* the mapping stays valid after closing the descriptor */
+		close( fd );
+		if( _map == MAP_FAILED ){
+			String msg( "Could not map file: " );
+			msg += strerror( errno );
+			_map = 0;
+			throw CVTException( msg.c_str() );
+		}
 
-		int32_t patchHalfSize = _patchSize >> 1;
+		const uint8_t* ptr = ( const uint8_t* ) _map + sizeof( FERNS_MAGIC );
+		const uint8_t* end = ( const uint8_t* ) _map + _mappedSize;
+		if( ptr + 6 * sizeof( uint32_t ) > end ){
+			unmap();
+			throw CVTException( "Ferns: invalid model file" );
+		}
 
-		/* train the class */
-		PatchGenerator patchGen( Rangef( 0.0f, Math::TWO_PI ), Rangef( 0.6f, 1.5f ), _patchSize, 3.0 /* noise */ );
+		const uint32_t* header = ( const uint32_t* ) ptr;
+		if( header[ 0 ] != FERNS_VERSION ){
+			unmap();
+			throw CVTException( "Ferns: unsupported model version" );
+		}
+		_patchSize	  = header[ 1 ];
+		_numFerns	  = header[ 2 ];
+		_testsPerFern = header[ 3 ];
+		_nTests		  = _numFerns * _testsPerFern;
+		uint32_t numClasses = header[ 4 ];
+		memcpy( &_regPrior, &header[ 5 ], sizeof( float ) );
+		ptr += 6 * sizeof( uint32_t );
+
+		size_t testBytes = 4 * _numFerns * _testsPerFern;
+		size_t posteriorSize = _numFerns * numResults() * numClasses;
+		if( _testsPerFern > 24 || ptr + numClasses * sizeof( Vector2f ) + testBytes + posteriorSize * sizeof( float ) != end ){
+			unmap();
+			throw CVTException( "Ferns: invalid model file" );
+		}
 
-		int x, y;
-		for( size_t i = 0; i < features.size(); i++ ){
-			std::cout << "FEATURE " << i+1 << " / " << features.size() << std::endl;
-			x = features[ i ].pt.x;
-			y = features[ i ].pt.y;
+		const float* pos = ( const float* ) ptr;
+		_modelFeatures.resize( numClasses );
+		for( size_t c = 0; c < numClasses; c++ )
+			_modelFeatures[ c ] = Vector2f( pos[ 2 * c ], pos[ 2 * c + 1 ] );
+		ptr += numClasses * sizeof( Vector2f );
 
-			if( ( x - patchHalfSize ) < 0 ||
-			 	( x + patchHalfSize ) >= ( int32_t )img.width() ||
-				( y - patchHalfSize ) < 0 ||
-				( y + patchHalfSize ) >= ( int32_t )img.height() )
-				continue;
+		_tests.assign( ptr, ptr + testBytes );
+		ptr += testBytes;
 
-			_modelFeatures.push_back( features[ i ] );
+		_posteriors = ( const float* ) ptr;
+	}
 
-			this->trainClass( _modelFeatures.size() - 1, patchGen, img );
-		}
+	bool Ferns::insidePatch( int x, int y, size_t width, size_t height ) const
+	{
+		int half = _patchSize >> 1;
+		return x - half >= 0 && x - half + ( int ) _patchSize <= ( int ) width &&
+			   y - half >= 0 && y - half + ( int ) _patchSize < ( int ) height;
+	}
 
-		for( size_t i = 0; i < _ferns.size(); i++ ){
-			_ferns[ i ].normalizeStatistics( _trainingSamples );
-		}
+	/* offsets of the test pixels relative to the patch center */
+	void Ferns::testOffsets( std::vector<int>& offsets, size_t stride ) const
+	{
+		int half = _patchSize >> 1;
+		int center = half * stride + half;
+		offsets.resize( _tests.size() / 2 );
+		for( size_t i = 0; i < offsets.size(); i++ )
+			offsets[ i ] = _tests[ 2 * i + 1 ] * ( int ) stride + _tests[ 2 * i ] - center;
 	}
 
-	void Ferns::match( const::std::vector<Eigen::Vector2i> & features,
-					   const Image & img,
-					   std::vector<Eigen::Vector2d> & matchedModel,
-					   std::vector<Eigen::Vector2d> & matchedFeatures )
+	void Ferns::train( const Image & img )
 	{
-		std::vector<double> bestProbsForPoint( _modelFeatures.size(), 0.0 );
-		std::vector<size_t> featureIndicesForPoint( _modelFeatures.size(), 0 );
+		if( img.format() != IFormat::GRAY_UINT8 )
+			throw CVTException( "Ferns: training image has to be GRAY_UINT8" );
 
-		int32_t patchHalfSize = _patchSize >> 1;
+		unmap();
 
-		size_t stride;
-		const uint8_t * p = img.map( &stride );
+		RNG rng( _seed );
+		_tests.resize( 4 * _nTests );
+		for( size_t i = 0; i < _tests.size(); i++ )
+			_tests[ i ] = rng.uniform( 0, ( int ) _patchSize );
 
-		uint32_t testResult;
-		for( size_t i = 0; i < features.size(); i++ ){
-			if( features[ i ][ 0 ] - patchHalfSize < 0 ||
-			    features[ i ][ 0 ] + patchHalfSize > ( int32_t )img.width() ||
-			    features[ i ][ 1 ] - patchHalfSize < 0 ||
-			    features[ i ][ 1 ] + patchHalfSize > ( int32_t )img.height() ){
-				continue;
-			}
+		// detect features in the "model"-image
+		FAST fast( SEGMENT_9, 40 );
+		FeatureSet features;
+		fast.detect( features, img );
+		features.filterNMS( 2, true );
 
-			const uint8_t * uL = p + stride * ( features[ i ][ 1 ] - patchHalfSize ) + features[ i ][ 0 ] - patchHalfSize;
-			std::vector<double> classProbs( _modelFeatures.size(), 0.0 );
+		_modelFeatures.clear();
+		for( size_t i = 0; i < features.size(); i++ ){
+			if( insidePatch( features[ i ].pt.x, features[ i ].pt.y, img.width(), img.height() ) )
+				_modelFeatures.push_back( features[ i ].pt );
+		}
 
+		_posteriorData.resize( _numFerns * numResults() * _modelFeatures.size() );
+		_posteriors = _posteriorData.size() ? &_posteriorData[ 0 ] : 0;
 
-			for( size_t f = 0; f < _ferns.size(); f++) {
-				testResult = _ferns[ f ].test( uL, stride );
-				const std::vector<double> & trainedProbabilities = _ferns[ f ].probsForResult( testResult );
-				for( size_t k = 0; k < trainedProbabilities.size(); k++ ){
-					classProbs[ k ] += trainedProbabilities[ k ];
-				}
-			}
+		/* train the classes */
+		TrainBody body( *this, img, &_posteriorData[ 0 ] );
+		ParallelFor::run( body, 0, _modelFeatures.size() );
+	}
 
-			size_t bestIdx = 0;
-			double probSum = exp( classProbs[ 0 ] );
-			for( size_t k = 1; k < classProbs.size(); k++ ){
-				probSum += exp( classProbs[ k ] );
-				if( classProbs[ k ] > classProbs[ bestIdx ] )
-					bestIdx = k;
-			}
+	void Ferns::classify( std::vector<int> & classes, std::vector<float> & probabilities, const Image & img, const std::vector<Vector2f> & pts ) const
+	{
+		if( img.format() != IFormat::GRAY_UINT8 )
+			throw CVTException( "Ferns: image has to be GRAY_UINT8" );
 
-			double probability = exp( classProbs[ bestIdx ] ) / probSum;
+		classes.assign( pts.size(), -1 );
+		probabilities.assign( pts.size(), 0.0f );
+		if( !numClasses() )
+			return;
 
-			if( probability > bestProbsForPoint[ bestIdx ] ){
-				bestProbsForPoint[ bestIdx ] = probability;
-				featureIndicesForPoint[ bestIdx ] = i;
+		size_t stride;
+		const uint8_t* base = img.map( &stride );
+
+		std::vector<int> points;
+		std::vector<size_t> pointIdx;
+		points.reserve( pts.size() );
+		pointIdx.reserve( pts.size() );
+		for( size_t i = 0; i < pts.size(); i++ ){
+			int x = pts[ i ].x;
+			int y = pts[ i ].y;
+			if( insidePatch( x, y, img.width(), img.height() ) ){
+				points.push_back( y * stride + x );
+				pointIdx.push_back( i );
 			}
 		}
-		img.unmap( p );
 
-		// no check the result:
-		for( size_t i = 0; i < bestProbsForPoint.size(); i++ ){
-			std::cout << "Prob: " << bestProbsForPoint[ i ] << std::endl;
-			if( bestProbsForPoint[ i ] > 0.96 ){
-				matchedModel.push_back( Eigen::Vector2d( _modelFeatures[ i ].pt.x, _modelFeatures[ i ].pt.y ) );
-				matchedFeatures.push_back( features[ featureIndicesForPoint[ i ] ].cast<double>() );
-			}
+		if( points.size() ){
+			std::vector<int> offsets;
+			testOffsets( offsets, stride );
+
+			ClassifyBody body( *this, base, &points[ 0 ], &pointIdx[ 0 ], &offsets[ 0 ], &classes[ 0 ], &probabilities[ 0 ] );
+			ParallelFor::run( body, 0, points.size(), 64 );
 		}
 
+		img.unmap( base );
 	}
 
 	double Ferns::classify( Eigen::Vector2i & bestClass, const Image & img, const Eigen::Vector2i & p )
 	{
-		size_t imStride;
+		std::vector<Vector2f> pts( 1, Vector2f( p[ 0 ], p[ 1 ] ) );
+		std::vector<int> classes;
+		std::vector<float> probs;
+		classify( classes, probs, img, pts );
 
-        const uint8_t * imP = img.map( &imStride );
-		int32_t patchHalfSize = _patchSize >> 1;
+		if( classes[ 0 ] < 0 )
+			return 0.0;
 
-        if( p[ 0 ] - patchHalfSize < 0 ||
-            p[ 0 ] + patchHalfSize > ( int32_t )img.width() ||
-            p[ 1 ] - patchHalfSize < 0 ||
-            p[ 1 ] + patchHalfSize > ( int32_t )img.height() )
-            return 0.0f;
-
-		const uint8_t * uL = imP + imStride * ( p[ 1 ] - patchHalfSize ) + p[ 0 ] - patchHalfSize;
-
-		std::vector<double> classProbs( _modelFeatures.size(), 0.0 );
+		bestClass[ 0 ] = _modelFeatures[ classes[ 0 ] ].x;
+		bestClass[ 1 ] = _modelFeatures[ classes[ 0 ] ].y;
+		return probs[ 0 ];
+	}
 
-		uint32_t testResult;
+	void Ferns::match( const::std::vector<Eigen::Vector2i> & features,
+					   const Image & img,
+					   std::vector<Eigen::Vector2d> & matchedModel,
+					   std::vector<Eigen::Vector2d> & matchedFeatures )
+	{
+		std::vector<Vector2f> pts( features.size() );
+		for( size_t i = 0; i < features.size(); i++ )
+			pts[ i ] = Vector2f( features[ i ][ 0 ], features[ i ][ 1 ] );
 
-		// for each fern
-		for( size_t i = 0; i < _ferns.size(); i++ ){
-			testResult = _ferns[ i ].test( uL, imStride );
-			const std::vector<double> & trainedProbs = _ferns[ i ].probsForResult( testResult );
+		std::vector<int> classes;
+		std::vector<float> probs;
+		classify( classes, probs, img, pts );
 
-			for( size_t f = 0; f < trainedProbs.size(); f++ ){
-				classProbs[ f ] += trainedProbs[ f ];
+		std::vector<float> bestProbsForPoint( _modelFeatures.size(), 0.0f );
+		std::vector<size_t> featureIndicesForPoint( _modelFeatures.size(), 0 );
+		for( size_t i = 0; i < features.size(); i++ ){
+			if( classes[ i ] >= 0 && probs[ i ] > bestProbsForPoint[ classes[ i ] ] ){
+				bestProbsForPoint[ classes[ i ] ] = probs[ i ];
+				featureIndicesForPoint[ classes[ i ] ] = i;
 			}
 		}
 
-		img.unmap( imP );
-
-		uint32_t bestIdx = 0;
-		double probSum = 0.0;
-		for( size_t i = 0; i < classProbs.size(); i++ ){
-			probSum += exp( classProbs[ i ] );
-			if( classProbs[ i ] > classProbs[ bestIdx ] )
-				bestIdx = i;
+		// now check the result:
+		for( size_t i = 0; i < bestProbsForPoint.size(); i++ ){
+			if( bestProbsForPoint[ i ] > 0.96 ){
+				matchedModel.push_back( Eigen::Vector2d( _modelFeatures[ i ].x, _modelFeatures[ i ].y ) );
+				matchedFeatures.push_back( features[ featureIndicesForPoint[ i ] ].cast<double>() );
+			}
 		}
-
-		bestClass[ 0 ] = _modelFeatures[ bestIdx ].pt.x;
-		bestClass[ 1 ] = _modelFeatures[ bestIdx ].pt.y;
-
-		return exp( classProbs[ bestIdx ] ) / probSum;
 	}
 
-	void Ferns::save( const std::string & fileName )
+	void Ferns::save( const std::string & fileName ) const
 	{
 		std::ofstream out;
 
@@ -311,34 +523,51 @@ namespace cvt
 
 		out << _modelFeatures.size() << std::endl;
 		for( size_t i = 0; i < _modelFeatures.size(); i++ ){
-			out << _modelFeatures[ i ].pt.x << " " << _modelFeatures[ i ].pt.y << std::endl;
+			out << _modelFeatures[ i ].x << " " << _modelFeatures[ i ].y << std::endl;
 		}
 
-		for( size_t i = 0; i < _ferns.size(); i++ ){
-			_ferns[ i ].serialize( out );
+		const float* post = _posteriors;
+		for( size_t f = 0; f < _numFerns; f++ ){
+			out << numResults() << std::endl;
+			out << _regPrior << std::endl;
+
+			for( size_t t = 0; t < _testsPerFern; t++ ){
+				const uint8_t* test = &_tests[ 4 * ( f * _testsPerFern + t ) ];
+				out << ( int ) test[ 0 ] << " " << ( int ) test[ 1 ] << " " << ( int ) test[ 2 ] << " " << ( int ) test[ 3 ] << std::endl;
+			}
+
+			for( size_t r = 0; r < numResults(); r++ ){
+				for( size_t c = 0; c < _modelFeatures.size(); c++ ){
+					out << *post++ << " ";
+				}
+				out << std::endl;
+			}
 		}
 
 		out.close();
 	}
 
-	void Ferns::trainClass( size_t idx, PatchGenerator & patchGen, const Image & img )
+	void Ferns::saveBinary( const std::string & fileName ) const
 	{
-		Image patch( _patchSize, _patchSize, img.format() );
-		size_t pStride;
-		uint8_t * p;
-
-		for( size_t i = 0; i < _trainingSamples; i++ ) {
-			// generate a new patch
-			patchGen.next( patch, img, _modelFeatures[ idx ].pt );
-
-			p = patch.map( &pStride );
-
-			// train each fern
-			for( size_t f = 0; f < _ferns.size(); f++ ){
-				_ferns[ f ].trainClass( idx , p,  pStride );
-			}
-
-			patch.unmap( p );
+		std::ofstream out( fileName.c_str(), std::ios_base::out | std::ios_base::binary );
+		if( !out.is_open() )
+			throw CVTException( "Ferns: could not open file" );
+
+		uint32_t header[ 6 ] = { FERNS_VERSION, _patchSize, _numFerns, _testsPerFern, ( uint32_t ) _modelFeatures.size(), 0 };
+		memcpy( &header[ 5 ], &_regPrior, sizeof( float ) );
+
+		out.write( FERNS_MAGIC, sizeof( FERNS_MAGIC ) );
+		out.write( ( const char* ) header, sizeof( header ) );
+		for( size_t c = 0; c < _modelFeatures.size(); c++ ){
+			float pos[ 2 ] = { _modelFeatures[ c ].x, _modelFeatures[ c ].y };
+			out.write( ( const char* ) pos, sizeof( pos ) );
 		}
+		if( _tests.size() )
+			out.write( ( const char* ) &_tests[ 0 ], _tests.size() );
+		if( _posteriors )
+			out.write( ( const char* ) _posteriors, _numFerns * numResults() * _modelFeatures.size() * sizeof( float ) );
+
+		if( !out.good() )
+			throw CVTException( "Ferns: could not write model" );
 	}
-}
\ No newline at end of file
+}
@@ -26,50 +26,88 @@
 #define CVT_FERNS_H
 
 #include <cvt/gfx/Image.h>
-#include <cvt/vision/PatchGenerator.h>
-#include <cvt/vision/internal/Fern.h>
-#include <cvt/vision/FAST.h>
+#include <cvt/math/Vector.h>
+#include <cvt/util/String.h>
 
 #include <Eigen/Core>
 #include <vector>
 #include <string>
-#include <utility>
 
 namespace cvt 
 {
-	
+	/**
+	  @brief Random ferns keypoint classifier.
+
+	  Every fern is a set of binary pixel comparisons within a patch around the keypoint, the comparison results
+	  form the index into the trained log posteriors of all classes ( the keypoints of the model image ).
+	  The posteriors are stored as one contiguous array ( fern, result, class ), keypoints are classified in
+	  parallel batches with the SIMD fern kernel.
+
+	  Models can be saved as text or in a binary format, binary models are memory mapped on loading.
+	  Patches have to lie completely within the image, excluding the last image row. The training patches are
+	  smoothed with a 3x3 Gaussian, classified images should be smoothed the same way.
+	 */
 	class Ferns 
 	{
-		
 		public:
 			Ferns( uint32_t patchSize = 21, uint32_t numOverallTests = 300, uint32_t numFerns = 30 );
 			Ferns( const std::string & fileName );
 			~Ferns();
-			
+
+			/* train the classes with random affine warps of the FAST features of the model image ( GRAY_UINT8 ) */
 			void train( const Image & img );
-			
+
+			void setTrainingSamples( uint32_t n )	{ _trainingSamples = n; }
+			void setSeed( uint64_t seed )			{ _seed = seed; }
+
+			size_t numClasses() const				{ return _modelFeatures.size(); }
+			const Vector2f& classPosition( size_t c ) const { return _modelFeatures[ c ]; }
+
 			double classify( Eigen::Vector2i & bestClass, const Image & img, const Eigen::Vector2i & p );
-		
+
+			/* batch classification, class -1 for points too close to the border */
+			void classify( std::vector<int> & classes, std::vector<float> & probabilities, const Image & img, const std::vector<Vector2f> & pts ) const;
+
 			void match( const::std::vector<Eigen::Vector2i> & features,
 						const Image & img,
 						std::vector<Eigen::Vector2d> & matchedModel,
 					    std::vector<Eigen::Vector2d> & matchedFeatures );
-			
-			void save( const std::string & fileName );
-			
-		private:						
+
+			void save( const std::string & fileName ) const;
+			void saveBinary( const std::string & fileName ) const;
+
+		private:
+			class TrainBody;
+			class ClassifyBody;
+
+			Ferns( const Ferns& );
+			Ferns& operator=( const Ferns& );
+
+			void		loadText( const std::string & fileName );
+			void		loadBinary( const std::string & fileName );
+			void		unmap();
+			bool		insidePatch( int x, int y, size_t width, size_t height ) const;
+			void		testOffsets( std::vector<int>& offsets, size_t stride ) const;
+			size_t		numResults() const { return ( size_t ) 1 << _testsPerFern; }
+
 			uint32_t	_patchSize;
 			uint32_t	_numFerns;
 			uint32_t 	_nTests;
 			uint32_t	_testsPerFern;
 			uint32_t	_trainingSamples;
-			
-			std::vector<Fern>				_ferns;						
-			FAST*                           _featureDetector;			
-			std::vector<Feature2Df>	_modelFeatures;	
+			float		_regPrior;
+			uint64_t	_seed;
+
+			/* x0, y0, x1, y1 of every test w.r.t. the upper left corner of the patch */
+			std::vector<uint8_t>	_tests;
+			std::vector<Vector2f>	_modelFeatures;
 
-			void trainClass( size_t idx, PatchGenerator & patchGen, const Image & img );
+			/* log posteriors, either _posteriorData or memory mapped */
+			std::vector<float>		_posteriorData;
+			const float*			_posteriors;
+			void*					_map;
+			size_t					_mappedSize;
 	};
 	
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,180 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/Ferns.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+
+#include <stdio.h>
+
+namespace cvt {
+
+	/* overlapping textured rectangles, smoothed like the training patches */
+	static void _fernsImage( Image& img, size_t w, size_t h )
+	{
+		std::vector<uint8_t> v( w * h, 0 );
+		for( size_t r = 0; r < 25; r++ ) {
+			size_t x0 = Math::rand( 0.0f, w - 1.0f ), y0 = Math::rand( 0.0f, h - 1.0f );
+			size_t x1 = Math::min<size_t>( w, x0 + Math::rand( 10.0f, 40.0f ) );
+			size_t y1 = Math::min<size_t>( h, y0 + Math::rand( 10.0f, 40.0f ) );
+			uint8_t c = Math::rand( 0.0f, 255.0f );
+			for( size_t y = y0; y < y1; y++ )
+				for( size_t x = x0; x < x1; x++ )
+					v[ y * w + x ] = ( v[ y * w + x ] + c ) / 2 + ( ( x * 7 + y * 13 ) % 11 );
+		}
+
+		Image tmp( w, h, IFormat::GRAY_UINT8 );
+		{
+			IMapScoped<uint8_t> map( tmp );
+			for( size_t y = 0; y < h; y++ ) {
+				memcpy( map.ptr(), &v[ y * w ], w );
+				map++;
+			}
+		}
+		img.reallocate( w, h, IFormat::GRAY_UINT8 );
+		tmp.convolve( img, IKernel::GAUSS_HORIZONTAL_3 );
+		img.convolve( tmp, IKernel::GAUSS_VERTICAL_3 );
+		img = tmp;
+	}
+
+	static bool _fernsKernel( const Image& img )
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+
+		IMapScoped<const uint8_t> map( img );
+		int stride = map.stride();
+		std::vector<int> points, tests;
+		for( size_t i = 0; i < 37; i++ )
+			points.push_back( ( int ) Math::rand( 10.0f, img.height() - 11.0f ) * stride + ( int ) Math::rand( 10.0f, img.width() - 11.0f ) );
+		for( size_t i = 0; i < 2 * 13; i++ )
+			tests.push_back( ( int ) Math::rand( -10.0f, 10.0f ) * stride + ( int ) Math::rand( -10.0f, 10.0f ) );
+
+		std::vector<uint32_t> r0( points.size() ), r1( points.size() );
+		base->fernIndex_u8( &r0[ 0 ], map.ptr(), &points[ 0 ], points.size(), &tests[ 0 ], 13 );
+		best->fernIndex_u8( &r1[ 0 ], map.ptr(), &points[ 0 ], points.size(), &tests[ 0 ], 13 );
+
+		delete base;
+		delete best;
+		return r0 == r1;
+	}
+
+	static void _fernsClassify( std::vector<int>& classes, std::vector<float>& probs, const Ferns& ferns, const Image& img )
+	{
+		std::vector<Vector2f> pts;
+		for( size_t c = 0; c < ferns.numClasses(); c++ )
+			pts.push_back( ferns.classPosition( c ) );
+		/* outside of the image */
+		pts.push_back( Vector2f( 1.0f, 1.0f ) );
+		ferns.classify( classes, probs, img, pts );
+	}
+
+	/* classes and probabilities of a freshly trained model */
+	struct FernsTrain {
+		FernsTrain( const Image& i ) : img( i ) {}
+		void operator()( std::vector<float>& out ) const
+		{
+			Ferns ferns( 21, 300, 30 );
+			ferns.setTrainingSamples( 500 );
+			ferns.setSeed( 1234 );
+			ferns.train( img );
+			std::vector<int> classes;
+			_fernsClassify( classes, out, ferns, img );
+			out.insert( out.end(), classes.begin(), classes.end() );
+		}
+		const Image& img;
+	};
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( Ferns )
+
+bool result = true;
+bool b;
+
+Image img;
+_fernsImage( img, 200, 150 );
+
+b = _fernsKernel( img );
+CVTTEST_PRINT( "Kernel", b );
+result &= b;
+
+Ferns ferns( 21, 300, 30 );
+ferns.setTrainingSamples( 500 );
+ferns.setSeed( 1234 );
+ferns.train( img );
+
+std::vector<int> classes;
+std::vector<float> probs;
+_fernsClassify( classes, probs, ferns, img );
+
+size_t correct = 0;
+for( size_t c = 0; c < ferns.numClasses(); c++ )
+	correct += classes[ c ] == ( int ) c;
+b = ferns.numClasses() > 10 && correct > ferns.numClasses() / 2 && classes.back() == -1;
+CVTTEST_PRINT( "Train and classify", b );
+result &= b;
+
+/* training does not depend on the number of threads */
+b = testThreadInvariance<std::vector<float> >( FernsTrain( img ), testEqual<std::vector<float> > );
+CVTTEST_PRINT( "Threads", b );
+
+std::vector<int> classes1;
+std::vector<float> probs1;
+result &= b;
+
+/* binary model, memory mapped */
+std::string binFile = "/tmp/cvt_ferns_test.bin";
+std::string txtFile = "/tmp/cvt_ferns_test.txt";
+ferns.saveBinary( binFile );
+ferns.save( txtFile );
+{
+	Ferns loaded( binFile );
+	_fernsClassify( classes1, probs1, loaded, img );
+	b = classes1 == classes && probs1 == probs && loaded.numClasses() == ferns.numClasses();
+	CVTTEST_PRINT( "Binary model", b );
+	result &= b;
+}
+{
+	Ferns loaded( txtFile );
+	_fernsClassify( classes1, probs1, loaded, img );
+	b = classes1.size() == classes.size();
+	size_t same = 0;
+	for( size_t i = 0; i < classes1.size() && b; i++ )
+		same += classes1[ i ] == classes[ i ];
+	b &= same + 2 >= classes.size();
+	CVTTEST_PRINT( "Text model", b );
+	result &= b;
+}
+remove( binFile.c_str() );
+remove( txtFile.c_str() );
+
+return result;
+
+END_CVTTEST
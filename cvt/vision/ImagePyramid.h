@@ -67,6 +67,11 @@ namespace cvt
             void combinedImage( Image& comb, const Color& c = Color::BLACK ) const;
             void saveCombined( const String& filename, const Color& c = Color::BLACK ) const;
 
+            /**
+             * \brief recompute the scale space from the first octave, e.g. after pyr[ 0 ] was written in place
+             */
+            void recompute( const IScaleFilter &sfilter = IScaleFilterGauss() );
+
             template <class Func>
             void apply( ImagePyramid& out, const Func& f ) const;
 
@@ -79,9 +84,6 @@ namespace cvt
         private:
             std::vector<Image>       _image;
             float                    _scaleFactor;
-
-            /* recompute the scale space from the first octave */
-            void recompute( const IScaleFilter &sfilter );
     };
 
     inline ImagePyramid::ImagePyramid( size_t octaves, float scaleFactor ) :
@@ -0,0 +1,579 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_KLT_BATCH_H
+#define CVT_KLT_BATCH_H
+
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+#include <cvt/vision/ImagePyramid.h>
+#include <cvt/vision/KLTPatch.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/EigenBridge.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/Exception.h>
+
+namespace cvt
+{
+    /**
+     *  \class KLTBatch
+     *  \brief Inverse compositional KLT for many patches at once
+     *
+     *  The templates, steepest descent images and inverse Hessians of all patches
+     *  are stored per octave in contiguous aligned buffers ( patch after patch, the
+     *  steepest descent images plane by plane ), the poses and tracking results in
+     *  plain arrays indexed by the patch index. align() distributes the patches
+     *  over the threads of ParallelFor. PoseType can be Translation2D, Affine2D or GA2.
+     */
+    template <size_t pSize, class PoseType>
+    class KLTBatch
+    {
+        public:
+            typedef Eigen::Matrix<float, PoseType::NPARAMS, PoseType::NPARAMS> HessType;
+            typedef Eigen::Matrix<float, PoseType::NPARAMS, 1>                 JacType;
+            typedef Eigen::Matrix<float, 2, PoseType::NPARAMS>                 ScreenJacType;
+            static const size_t PatchSize = pSize;
+            static const size_t NumPixels = pSize * pSize;
+            static const size_t NumParams = PoseType::NPARAMS;
+
+            KLTBatch();
+
+            /**
+             *  \brief extract a new patch at pos from all octaves of the pyramid
+             *  \return false if the patch is too close to the border or not textured enough,
+             *          the patch is added nonetheless but marked as invalid
+             */
+            bool            add( const ImagePyramid& pyrImg,
+                                 const ImagePyramid& pyrGx,
+                                 const ImagePyramid& pyrGy,
+                                 const Vector2f& pos );
+
+            /**
+             *  \brief copy the templates of an existing patch, the pose is taken from the patch
+             *          the patch has to be extracted successfully
+             */
+            void            add( const KLTPatch<pSize, PoseType>& patch );
+
+            size_t          size()      const { return _valid.size(); }
+            size_t          numScales() const { return _patch.size(); }
+            bool            isValid( size_t idx ) const { return _valid[ idx ] != 0; }
+            void            reserve( size_t n );
+            void            clear();
+
+            void            initPose( size_t idx, const Vector2f& pos );
+            void            initPose( size_t idx, const Matrix3f& mat );
+            Matrix3f        poseMat( size_t idx ) const;
+            void            currentCenter( size_t idx, Vector2f& center ) const;
+
+            /**
+             *  \brief align the patches idx[ 0 ] ... idx[ n - 1 ] starting from their current poses
+             *  \param idx      indices of valid patches, each index may only appear once
+             */
+            void            align( const size_t* idx, size_t n, const ImagePyramid& pyramid, size_t maxIters = 2 );
+
+            /* align all valid patches */
+            void            align( const ImagePyramid& pyramid, size_t maxIters = 2 );
+
+            /* results of the last alignment of patch idx, ssd and sad are computed on the finest octave */
+            bool            tracked( size_t idx ) const { return _tracked[ idx ] != 0; }
+            float           ssd( size_t idx )     const { return _ssd[ idx ]; }
+            float           sad( size_t idx )     const { return _sad[ idx ]; }
+
+            const float*    pixels( size_t idx, size_t octave = 0 ) const { return &_patch[ octave ][ idx * NumPixels ]; }
+            const float*    transformed( size_t idx )               const { return &_transformed[ idx * NumPixels ]; }
+            const float*    jacobians( size_t idx, size_t octave = 0 )  const { return &_jac[ octave ][ idx * NumParams * NumPixels ]; }
+            const float*    inverseHessian( size_t idx, size_t octave = 0 ) const { return &_invHess[ octave ][ idx * NumParams * NumParams ]; }
+
+            const Vector2f* patchPoints()    const { return &_points[ 0 ]; }
+            static size_t   numPatchPoints() { return NumPixels; }
+
+        private:
+            typedef std::vector<float, Eigen::aligned_allocator<float> >                 FloatBuffer;
+            typedef std::vector<ScreenJacType, Eigen::aligned_allocator<ScreenJacType> > ScreenJacVec;
+
+            struct Level
+            {
+                const float*    ptr;
+                size_t          stride;
+                size_t          width;
+                size_t          height;
+            };
+
+            class AlignBody
+            {
+                public:
+                    AlignBody( KLTBatch& batch, const size_t* idx, const Level* levels, size_t octaves, float scaleFactor, size_t maxIters ) :
+                        _batch( batch ), _idx( idx ), _levels( levels ), _octaves( octaves ), _scaleFactor( scaleFactor ), _maxIters( maxIters )
+                    {
+                    }
+
+                    void operator()( size_t begin, size_t end ) const
+                    {
+                        ScopedBuffer<Vector2f, true> pts( NumPixels );
+                        ScopedBuffer<float, true>    buf( 4 * NumPixels );
+                        for( size_t i = begin; i < end; i++ )
+                            _batch.alignPatch( _idx[ i ], _levels, _octaves, _scaleFactor, _maxIters, pts.ptr(), buf.ptr() );
+                    }
+
+                private:
+                    KLTBatch&       _batch;
+                    const size_t*   _idx;
+                    const Level*    _levels;
+                    size_t          _octaves;
+                    float           _scaleFactor;
+                    size_t          _maxIters;
+            };
+
+            KLTBatch( const KLTBatch& );
+            KLTBatch& operator=( const KLTBatch& );
+
+            void            resizeOctaves( size_t octaves );
+            size_t          append();
+            bool            extract( size_t idx, const float* iptr, const float* gxptr, const float* gyptr,
+                                     size_t stride, const Vector2f& pos, size_t octave );
+            void            alignPatch( size_t idx, const Level* levels, size_t octaves, float scaleFactor,
+                                        size_t maxIters, Vector2f* pts, float* buf );
+            bool            alignOctave( size_t idx, PoseType& pose, const Level& level, size_t octave,
+                                         size_t maxIters, Vector2f* pts, float*& cur, float*& curRes,
+                                         float*& cand, float*& candRes, float& error );
+            bool            patchIsInImage( const Matrix3f& pose, size_t w, size_t h ) const;
+
+            /* per octave buffers */
+            std::vector<FloatBuffer>    _patch;
+            std::vector<FloatBuffer>    _jac;
+            std::vector<FloatBuffer>    _invHess;
+
+            /* per patch data */
+            FloatBuffer                 _transformed;
+            std::vector<PoseType>       _poses;
+            std::vector<uint8_t>        _valid;
+            std::vector<uint8_t>        _tracked;
+            std::vector<float>          _ssd;
+            std::vector<float>          _sad;
+
+            std::vector<Vector2f>       _points;
+            ScreenJacVec                _screenJac;
+    };
+
+    template <size_t pSize, class PoseType>
+    inline KLTBatch<pSize, PoseType>::KLTBatch()
+    {
+        _points.reserve( NumPixels );
+        _screenJac.resize( NumPixels );
+
+        int half = pSize >> 1;
+        PoseType pose;
+        Eigen::Vector2f p;
+        for( size_t y = 0; y < pSize; y++ ){
+            for( size_t x = 0; x < pSize; x++ ){
+                _points.push_back( Vector2f( ( int ) x - half, ( int ) y - half ) );
+                EigenBridge::toEigen( p, _points.back() );
+                pose.screenJacobian( _screenJac[ _points.size() - 1 ], p );
+            }
+        }
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::resizeOctaves( size_t octaves )
+    {
+        size_t n = size();
+        _patch.resize( octaves );
+        _jac.resize( octaves );
+        _invHess.resize( octaves );
+        for( size_t o = 0; o < octaves; o++ ){
+            _patch[ o ].resize( n * NumPixels );
+            _jac[ o ].resize( n * NumParams * NumPixels );
+            _invHess[ o ].resize( n * NumParams * NumParams );
+        }
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::reserve( size_t n )
+    {
+        for( size_t o = 0; o < numScales(); o++ ){
+            _patch[ o ].reserve( n * NumPixels );
+            _jac[ o ].reserve( n * NumParams * NumPixels );
+            _invHess[ o ].reserve( n * NumParams * NumParams );
+        }
+        _transformed.reserve( n * NumPixels );
+        _poses.reserve( n );
+        _valid.reserve( n );
+        _tracked.reserve( n );
+        _ssd.reserve( n );
+        _sad.reserve( n );
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::clear()
+    {
+        _patch.clear();
+        _jac.clear();
+        _invHess.clear();
+        _transformed.clear();
+        _poses.clear();
+        _valid.clear();
+        _tracked.clear();
+        _ssd.clear();
+        _sad.clear();
+    }
+
+    template <size_t pSize, class PoseType>
+    inline bool KLTBatch<pSize, PoseType>::add( const ImagePyramid& pyrImg,
+                                                const ImagePyramid& pyrGx,
+                                                const ImagePyramid& pyrGy,
+                                                const Vector2f& pos )
+    {
+        if( size() == 0 )
+            resizeOctaves( pyrImg.octaves() );
+        else if( pyrImg.octaves() != numScales() )
+            throw CVTException( "Pyramid octaves do not match the patch octaves" );
+
+        size_t idx = append();
+        initPose( idx, pos );
+
+        const size_t phalf = pSize >> 1;
+        float scale = 1.0f;
+        for( size_t o = 0; o < numScales(); o++ ){
+            Vector2f octavePos = pos * scale;
+            int x = octavePos.x;
+            int y = octavePos.y;
+            size_t w = pyrImg[ o ].width();
+            size_t h = pyrImg[ o ].height();
+
+            if( x < ( int )phalf + 1 || ( x + phalf + 1 ) >= w ||
+                y < ( int )phalf + 1 || ( y + phalf + 1 ) >= h )
+                return false;
+
+            IMapScoped<const float> iMap( pyrImg[ o ] );
+            IMapScoped<const float> gxMap( pyrGx[ o ] );
+            IMapScoped<const float> gyMap( pyrGy[ o ] );
+            if( !extract( idx, iMap.ptr(), gxMap.ptr(), gyMap.ptr(), iMap.stride() / sizeof( float ), octavePos, o ) )
+                return false;
+
+            scale *= pyrImg.scaleFactor();
+        }
+
+        _valid[ idx ] = 1;
+        return true;
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::add( const KLTPatch<pSize, PoseType>& patch )
+    {
+        if( size() == 0 )
+            resizeOctaves( patch.numScales() );
+        else if( patch.numScales() != numScales() )
+            throw CVTException( "Patch octaves do not match the batch octaves" );
+
+        size_t idx = append();
+        initPose( idx, patch.poseMat() );
+
+        for( size_t o = 0; o < numScales(); o++ ){
+            const float* p = patch.pixels( o );
+            std::copy( p, p + NumPixels, &_patch[ o ][ idx * NumPixels ] );
+
+            /* the patch stores one jacobian per pixel, the batch plane by plane */
+            const JacType* j = patch.jacobians( o );
+            float* J = &_jac[ o ][ idx * NumParams * NumPixels ];
+            for( size_t i = 0; i < NumPixels; i++ ){
+                for( size_t k = 0; k < NumParams; k++ )
+                    J[ k * NumPixels + i ] = j[ i ][ k ];
+            }
+
+            Eigen::Map<HessType> invH( &_invHess[ o ][ idx * NumParams * NumParams ] );
+            invH = patch.inverseHessian( o );
+        }
+        _valid[ idx ] = 1;
+    }
+
+    /* appends an invalid patch and returns its index */
+    template <size_t pSize, class PoseType>
+    inline size_t KLTBatch<pSize, PoseType>::append()
+    {
+        size_t idx = size();
+        for( size_t o = 0; o < numScales(); o++ ){
+            _patch[ o ].resize( ( idx + 1 ) * NumPixels );
+            _jac[ o ].resize( ( idx + 1 ) * NumParams * NumPixels );
+            _invHess[ o ].resize( ( idx + 1 ) * NumParams * NumParams );
+        }
+        _transformed.resize( ( idx + 1 ) * NumPixels );
+        _poses.push_back( PoseType() );
+        _valid.push_back( 0 );
+        _tracked.push_back( 0 );
+        _ssd.push_back( 0.0f );
+        _sad.push_back( 0.0f );
+        return idx;
+    }
+
+    template <size_t pSize, class PoseType>
+    inline bool KLTBatch<pSize, PoseType>::extract( size_t idx, const float* iptr, const float* gxptr, const float* gyptr,
+                                                    size_t stride, const Vector2f& pos, size_t octave )
+    {
+        const float pHalf = ( pSize >> 1 );
+        size_t offset = ( int )( pos.y - pHalf ) * stride + ( int )( pos.x - pHalf );
+        iptr  += offset;
+        gxptr += offset;
+        gyptr += offset;
+
+        float* p = &_patch[ octave ][ idx * NumPixels ];
+        float* J = &_jac[ octave ][ idx * NumParams * NumPixels ];
+
+        Eigen::Matrix<float, 2, 1> g;
+        JacType j;
+        HessType hess( HessType::Zero() );
+
+        const ScreenJacType* sj = &_screenJac[ 0 ];
+        for( size_t y = 0; y < pSize; y++ ){
+            for( size_t x = 0; x < pSize; x++ ){
+                *p++ = iptr[ x ];
+                g[ 0 ] = gxptr[ x ];
+                g[ 1 ] = gyptr[ x ];
+
+                j = sj->transpose() * g;
+                hess.noalias() += j * j.transpose();
+
+                /* steepest descent images are stored plane by plane */
+                for( size_t k = 0; k < NumParams; k++ )
+                    J[ k * NumPixels ] = j[ k ];
+                J++;
+                sj++;
+            }
+            iptr  += stride;
+            gxptr += stride;
+            gyptr += stride;
+        }
+
+        float det = hess.determinant();
+        if( Math::abs( det ) > 1e-5 ){
+            Eigen::Map<HessType> invH( &_invHess[ octave ][ idx * NumParams * NumParams ] );
+            invH = hess.inverse();
+            return true;
+        }
+        return false;
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::initPose( size_t idx, const Vector2f& pos )
+    {
+        Matrix3f m;
+        m.setIdentity();
+        m[ 0 ][ 2 ] = pos.x;
+        m[ 1 ][ 2 ] = pos.y;
+        _poses[ idx ].set( m );
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::initPose( size_t idx, const Matrix3f& mat )
+    {
+        _poses[ idx ].set( mat );
+    }
+
+    template <size_t pSize, class PoseType>
+    inline Matrix3f KLTBatch<pSize, PoseType>::poseMat( size_t idx ) const
+    {
+        Matrix3f m;
+        EigenBridge::toCVT( m, _poses[ idx ].transformation() );
+        return m;
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::currentCenter( size_t idx, Vector2f& center ) const
+    {
+        const Eigen::Matrix3f& tmp = _poses[ idx ].transformation();
+        center.x = tmp( 0, 2 );
+        center.y = tmp( 1, 2 );
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::align( const ImagePyramid& pyramid, size_t maxIters )
+    {
+        std::vector<size_t> idx;
+        idx.reserve( size() );
+        for( size_t i = 0; i < size(); i++ ){
+            if( _valid[ i ] )
+                idx.push_back( i );
+        }
+        if( idx.size() )
+            align( &idx[ 0 ], idx.size(), pyramid, maxIters );
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::align( const size_t* idx, size_t n, const ImagePyramid& pyramid, size_t maxIters )
+    {
+        if( n == 0 )
+            return;
+
+        if( pyramid.octaves() != numScales() )
+            throw CVTException( "Pyramid octaves do not match the patch octaves" );
+        if( pyramid[ 0 ].format() != IFormat::GRAY_FLOAT )
+            throw CVTException( "Format must be GRAY_FLOAT!" );
+
+        /* map all octaves once, the workers only read */
+        std::vector<IMapScoped<const float>*> maps( pyramid.octaves() );
+        std::vector<Level> levels( pyramid.octaves() );
+        for( size_t o = 0; o < pyramid.octaves(); o++ ){
+            maps[ o ] = new IMapScoped<const float>( pyramid[ o ] );
+            levels[ o ].ptr    = maps[ o ]->ptr();
+            levels[ o ].stride = maps[ o ]->stride();
+            levels[ o ].width  = pyramid[ o ].width();
+            levels[ o ].height = pyramid[ o ].height();
+        }
+
+        AlignBody body( *this, idx, &levels[ 0 ], pyramid.octaves(), pyramid.scaleFactor(), maxIters );
+        ParallelFor::run( body, 0, n, 16 );
+
+        for( size_t o = 0; o < maps.size(); o++ )
+            delete maps[ o ];
+    }
+
+    template <size_t pSize, class PoseType>
+    inline void KLTBatch<pSize, PoseType>::alignPatch( size_t idx, const Level* levels, size_t octaves, float scaleFactor,
+                                                       size_t maxIters, Vector2f* pts, float* buf )
+    {
+        float* cur     = buf;
+        float* curRes  = buf + NumPixels;
+        float* cand    = buf + 2 * NumPixels;
+        float* candRes = buf + 3 * NumPixels;
+        float  error   = 0.0f;
+
+        _tracked[ idx ] = 0;
+        if( maxIters == 0 ){
+            _tracked[ idx ] = 1;
+            return;
+        }
+
+        PoseType& pose = _poses[ idx ];
+
+        /* move the pose to the coarsest octave */
+        Matrix3f m;
+        EigenBridge::toCVT( m, pose.transformation() );
+        float scale = Math::pow( scaleFactor, ( float )( octaves - 1 ) );
+        m[ 0 ][ 2 ] *= scale;
+        m[ 1 ][ 2 ] *= scale;
+        pose.set( m );
+
+        PoseType backup( pose );
+        bool ret = false;
+        for( int oc = octaves - 1; oc >= 0; --oc ){
+            ret = alignOctave( idx, pose, levels[ oc ], oc, maxIters, pts, cur, curRes, cand, candRes, error );
+            if( !ret )
+                pose.transformation() = backup.transformation();
+
+            if( oc != 0 ){
+                EigenBridge::toCVT( m, pose.transformation() );
+                m[ 0 ][ 2 ] /= scaleFactor;
+                m[ 1 ][ 2 ] /= scaleFactor;
+                pose.set( m );
+                backup.transformation() = pose.transformation();
+            }
+        }
+
+        if( ret ){
+            SIMD* simd = SIMD::instance();
+            const float* tmpl = &_patch[ 0 ][ idx * NumPixels ];
+            _tracked[ idx ] = 1;
+            _ssd[ idx ] = error;
+            _sad[ idx ] = simd->SAD( tmpl, cur, NumPixels );
+            simd->Memcpy( ( uint8_t* ) &_transformed[ idx * NumPixels ], ( const uint8_t* ) cur, NumPixels * sizeof( float ) );
+        }
+    }
+
+    template <size_t pSize, class PoseType>
+    inline bool KLTBatch<pSize, PoseType>::alignOctave( size_t idx, PoseType& pose, const Level& level, size_t octave,
+                                                        size_t maxIters, Vector2f* pts, float*& cur, float*& curRes,
+                                                        float*& cand, float*& candRes, float& error )
+    {
+        SIMD* simd = SIMD::instance();
+        const float* tmpl = &_patch[ octave ][ idx * NumPixels ];
+        const float* J    = &_jac[ octave ][ idx * NumParams * NumPixels ];
+        Eigen::Map<const HessType> invH( &_invHess[ octave ][ idx * NumParams * NumParams ] );
+
+        JacType jSum, jCand;
+        JacType delta;
+
+        Matrix3f m;
+        EigenBridge::toCVT( m, pose.transformation() );
+        if( !patchIsInImage( m, level.width, level.height ) )
+            return false;
+
+        typename PoseType::MatrixType save = pose.transformation();
+
+        simd->transformPoints( pts, m, &_points[ 0 ], NumPixels );
+        simd->warpBilinear1f( cur, &pts[ 0 ].x, level.ptr, level.stride, level.width, level.height, 2.0f, NumPixels );
+        error = simd->kltSystem_f( jSum.data(), curRes, cur, tmpl, J, NumParams, NumPixels );
+
+        for( size_t iter = 0; iter < maxIters; iter++ ){
+            delta = invH * jSum;
+
+            float newError = error + 1.0f;
+            while( newError > error ){
+                if( delta.cwiseAbs().maxCoeff() < 1e-6f ){
+                    /* no improving step left, stay at the last accepted pose */
+                    pose.transformation() = save;
+                    return true;
+                }
+
+                pose.transformation() = save;
+                pose.applyInverse( -delta );
+                EigenBridge::toCVT( m, pose.transformation() );
+
+                if( patchIsInImage( m, level.width, level.height ) ){
+                    simd->transformPoints( pts, m, &_points[ 0 ], NumPixels );
+                    simd->warpBilinear1f( cand, &pts[ 0 ].x, level.ptr, level.stride, level.width, level.height, 2.0f, NumPixels );
+                    newError = simd->kltSystem_f( jCand.data(), candRes, cand, tmpl, J, NumParams, NumPixels );
+                }
+
+                delta *= 0.5f;
+            }
+
+            /* accept the step, the system at the new pose has already been evaluated */
+            save  = pose.transformation();
+            error = newError;
+            jSum  = jCand;
+            std::swap( cur, cand );
+            std::swap( curRes, candRes );
+        }
+        return true;
+    }
+
+    template <size_t pSize, class PoseType>
+    inline bool KLTBatch<pSize, PoseType>::patchIsInImage( const Matrix3f& pose, size_t w, size_t h ) const
+    {
+        const float half = pSize >> 1;
+        const Vector2f corners[ 4 ] = { Vector2f( -half, -half ), Vector2f( half, -half ),
+                                        Vector2f( half, half ), Vector2f( -half, half ) };
+        for( size_t i = 0; i < 4; i++ ){
+            Vector2f pWarped = pose * corners[ i ];
+            if( pWarped.x < 0.0f || pWarped.x >= w ||
+                pWarped.y < 0.0f || pWarped.y >= h )
+                return false;
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,262 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/KLTBatch.h>
+#include <cvt/vision/KLTPatch.h>
+#include <cvt/gfx/IWarpEngine.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/gfx/IMapScoped.h>
+
+#include <cvt/math/Affine2D.h>
+#include <cvt/math/GA2.h>
+#include <cvt/math/Translation2D.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace cvt {
+
+	static bool _kltSystemKernel()
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+		bool ret = true;
+
+		for( size_t n = 1; n < 41; n++ ) {
+			std::vector<float> warped( n ), patch( n ), jac( 6 * n );
+			for( size_t i = 0; i < n; i++ ) {
+				warped[ i ] = Math::rand( 0.0f, 1.0f );
+				patch[ i ] = Math::rand( 0.0f, 1.0f );
+			}
+			for( size_t i = 0; i < 6 * n; i++ )
+				jac[ i ] = Math::rand( -1.0f, 1.0f );
+
+			std::vector<float> r1( n ), r2( n ), j1( 6 ), j2( 6 );
+			float e1 = base->kltSystem_f( &j1[ 0 ], &r1[ 0 ], &warped[ 0 ], &patch[ 0 ], &jac[ 0 ], 6, n );
+			float e2 = best->kltSystem_f( &j2[ 0 ], &r2[ 0 ], &warped[ 0 ], &patch[ 0 ], &jac[ 0 ], 6, n );
+			ret &= e1 == e2 && r1 == r2 && j1 == j2;
+
+			/* against the straightforward sums */
+			double e = 0, j0 = 0;
+			for( size_t i = 0; i < n; i++ ) {
+				e += Math::sqr( warped[ i ] - patch[ i ] );
+				j0 += jac[ i ] * ( warped[ i ] - patch[ i ] );
+			}
+			ret &= Math::abs( e - e1 ) < 1e-4 && Math::abs( j0 - j1[ 0 ] ) < 1e-4;
+		}
+
+		delete base;
+		delete best;
+		return ret;
+	}
+
+	/* smooth, non periodic texture */
+	static void _kltPattern( Image& img, size_t w, size_t h )
+	{
+		img.reallocate( w, h, IFormat::GRAY_FLOAT );
+		IMapScoped<float> map( img );
+		for( size_t y = 0; y < h; y++ ) {
+			float* p = map.ptr();
+			for( size_t x = 0; x < w; x++ ) {
+				float fx = x, fy = y;
+				p[ x ] = 0.5f + 0.12f * Math::sin( 0.21f * fx + 0.13f * fy )
+							  + 0.12f * Math::sin( 0.07f * fx - 0.19f * fy ) * Math::cos( 0.05f * fx + 0.11f * fy )
+							  + 0.1f * Math::sin( 0.0003f * fx * fy + 2.0f * Math::sin( 0.02f * fy ) );
+			}
+			map++;
+		}
+	}
+
+	static void _kltPyramids( ImagePyramid& pyr, ImagePyramid& gx, ImagePyramid& gy, const Image& img )
+	{
+		IKernel kx( IKernel::HAAR_HORIZONTAL_3 );
+		IKernel ky( IKernel::HAAR_VERTICAL_3 );
+		kx.scale( -0.5f );
+		ky.scale( -0.5f );
+
+		pyr.update( img );
+		pyr.convolve( gx, kx );
+		pyr.convolve( gy, ky );
+	}
+
+	/* align the valid patches from M * pos + ( 4, -3 ), the poses of all patches afterwards */
+	template <class Batch>
+	struct KLTAlign {
+		KLTAlign( Batch& b, const ImagePyramid& p, const Matrix3f& m, const std::vector<Vector2f>& ps ) : batch( b ), pyr( p ), M( m ), pos( ps ) {}
+		void operator()( std::vector<Matrix3f>& poses ) const
+		{
+			for( size_t i = 0; i < batch.size(); i++ ) {
+				if( batch.isValid( i ) )
+					batch.initPose( i, M * pos[ i ] + Vector2f( 4.0f, -3.0f ) );
+			}
+			batch.align( pyr, 10 );
+			poses.resize( batch.size() );
+			for( size_t i = 0; i < batch.size(); i++ )
+				poses[ i ] = batch.poseMat( i );
+		}
+		Batch&							batch;
+		const ImagePyramid&				pyr;
+		Matrix3f						M;
+		const std::vector<Vector2f>&	pos;
+	};
+
+	/*
+	   extract patches on a grid of img, move the image by the affine motion M and align the
+	   patches from a displaced start, the recovered poses have to be M * [ I | p ]
+	 */
+	template <class PoseType>
+	static bool _kltTrack( const Image& img, const Matrix3f& M, size_t& tracked, size_t& total )
+	{
+		typedef KLTBatch<16, PoseType> Batch;
+
+		ImagePyramid pyr( 3, 0.5f ), gx( 3, 0.5f ), gy( 3, 0.5f );
+		_kltPyramids( pyr, gx, gy, img );
+
+		Batch batch;
+		std::vector<Vector2f> pos;
+		for( float y = 96; y < img.height() - 96; y += 40 ) {
+			for( float x = 96; x < img.width() - 96; x += 40 ) {
+				if( batch.add( pyr, gx, gy, Vector2f( x, y ) ) )
+					pos.push_back( Vector2f( x, y ) );
+				else
+					pos.push_back( Vector2f( -1.0f, -1.0f ) );
+			}
+		}
+
+		Image moved( img.width(), img.height(), IFormat::GRAY_FLOAT );
+		IWarpEngine warp( IWARP_BILINEAR );
+		warp.warp( moved, img, M.inverse() );
+		_kltPyramids( pyr, gx, gy, moved );
+
+		/* the same result independent of the number of threads */
+		bool ret = testThreadInvariance<std::vector<Matrix3f> >( KLTAlign<Batch>( batch, pyr, M, pos ), testEqual<std::vector<Matrix3f> > );
+
+		tracked = total = 0;
+		for( size_t i = 0; i < batch.size(); i++ ) {
+			if( !batch.isValid( i ) )
+				continue;
+			total++;
+			if( !batch.tracked( i ) )
+				continue;
+
+			Vector2f center, truth = M * pos[ i ];
+			batch.currentCenter( i, center );
+			Matrix3f P = batch.poseMat( i );
+			/* the linear part is only weakly determined by a 16x16 patch */
+			if( ( center - truth ).length() < 0.1f &&
+				Math::abs( P[ 0 ][ 0 ] - M[ 0 ][ 0 ] ) < 0.03f && Math::abs( P[ 0 ][ 1 ] - M[ 0 ][ 1 ] ) < 0.03f &&
+				Math::abs( P[ 1 ][ 0 ] - M[ 1 ][ 0 ] ) < 0.03f && Math::abs( P[ 1 ][ 1 ] - M[ 1 ][ 1 ] ) < 0.03f )
+				tracked++;
+		}
+		return ret && total > 0;
+	}
+
+	/* a batch filled from extracted KLTPatches has to equal the batch extracted from the pyramid */
+	static bool _kltFromPatch( const Image& img )
+	{
+		typedef KLTPatch<16, GA2<float> > Patch;
+		typedef KLTBatch<16, GA2<float> > Batch;
+
+		ImagePyramid pyr( 3, 0.5f ), gx( 3, 0.5f ), gy( 3, 0.5f );
+		_kltPyramids( pyr, gx, gy, img );
+
+		Batch extracted, copied;
+		bool ret = true;
+		for( float y = 64; y < img.height() - 64; y += 56 ) {
+			for( float x = 64; x < img.width() - 64; x += 56 ) {
+				Patch patch( pyr.octaves() );
+				if( !patch.update( pyr, gx, gy, Vector2f( x, y ) ) )
+					continue;
+				ret &= extracted.add( pyr, gx, gy, Vector2f( x, y ) );
+				copied.add( patch );
+			}
+		}
+		ret &= copied.size() > 0 && copied.size() == extracted.size();
+		if( !ret )
+			return false;
+
+		const size_t np = Batch::NumParams;
+		for( size_t i = 0; i < copied.size(); i++ ) {
+			ret &= copied.isValid( i ) && copied.poseMat( i ) == extracted.poseMat( i );
+			for( size_t o = 0; o < copied.numScales(); o++ ) {
+				ret &= std::equal( copied.pixels( i, o ), copied.pixels( i, o ) + Batch::NumPixels, extracted.pixels( i, o ) );
+				ret &= std::equal( copied.jacobians( i, o ), copied.jacobians( i, o ) + np * Batch::NumPixels, extracted.jacobians( i, o ) );
+				const float* h0 = copied.inverseHessian( i, o );
+				const float* h1 = extracted.inverseHessian( i, o );
+				for( size_t k = 0; k < np * np; k++ )
+					ret &= Math::abs( h0[ k ] - h1[ k ] ) <= 1e-4f * ( 1.0f + Math::abs( h1[ k ] ) );
+			}
+		}
+		return ret;
+	}
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( KLTBatch )
+
+Image img;
+_kltPattern( img, 512, 512 );
+
+bool result = true;
+bool b;
+
+b = _kltSystemKernel();
+CVTTEST_PRINT( "kltSystem_f", b );
+result &= b;
+
+size_t tracked, total;
+Matrix3f M;
+
+M.setIdentity();
+M[ 0 ][ 2 ] = 3.5f;
+M[ 1 ][ 2 ] = -2.25f;
+b = _kltTrack<Translation2D<float> >( img, M, tracked, total );
+b &= tracked >= 0.9f * total;
+CVTTEST_PRINT( "Translation2D", b );
+result &= b;
+
+M[ 0 ][ 0 ] = 1.1f; M[ 0 ][ 1 ] = 0.06f;
+M[ 1 ][ 0 ] = -0.07f; M[ 1 ][ 1 ] = 0.94f;
+b = _kltTrack<Affine2D<float> >( img, M, tracked, total );
+b &= tracked >= 0.9f * total;
+CVTTEST_PRINT( "Affine2D", b );
+result &= b;
+
+b = _kltTrack<GA2<float> >( img, M, tracked, total );
+b &= tracked >= 0.9f * total;
+CVTTEST_PRINT( "GA2", b );
+result &= b;
+
+b = _kltFromPatch( img );
+CVTTEST_PRINT( "KLTPatch import", b );
+result &= b;
+
+return result;
+
+END_CVTTEST
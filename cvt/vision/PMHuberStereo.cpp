@@ -26,6 +26,14 @@
 #include <cvt/util/Exception.h>
 #include <cvt/cl/CLBuffer.h>
 #include <cvt/cl/kernel/pmhstereo.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/math/Vector.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/ParallelFor.h>
+
+#include <vector>
+#include <limits>
 
 
 namespace cvt {
@@ -39,34 +47,71 @@ namespace cvt {
 	};
 
 
-	PMHuberStereo::PMHuberStereo() :
-		_clpmh_init( _pmhstereo_source, "pmhstereo_init" ),
-		_clpmh_propagate( _pmhstereo_source, "pmhstereo_propagate_view" ),
-		_clpmh_depthmap( _pmhstereo_source, "pmhstereo_depthmap" ),
-		_clpmh_viewbufclear( _pmhstereo_source, "pmhstereo_viewbuf_clear" ),
-		_clpmh_fill( _pmhstereo_source, "pmhstereo_fill_state" ),
-		_clpmh_consistency( _pmhstereo_source, "pmhstereo_consistency" ),
-		_clpmh_filldepthmap( _pmhstereo_source, "pmhstereo_fill_depthmap" ),
-		_clpmh_fillnormalmap( _pmhstereo_source, "pmhstereo_fill_normalmap" ),
-		_clpmh_normaldepth( _pmhstereo_source, "pmhstereo_normal_depth" ),
-		_clpmh_clear( _pmhstereo_source, "pmhstereo_clear" ),
-		_clpmh_occmap( _pmhstereo_source, "pmhstereo_occmap" ),
-		_clpmh_gradxy( _pmhstereo_source, "pmhstereo_gradxy" ),
-		_clpmh_weight( _pmhstereo_source, "pmhstereo_weight" )
+	PMHuberStereo::PMHuberStereo()
 	{
-
 	}
 
 	PMHuberStereo::~PMHuberStereo()
 	{
 	}
 
-	void PMHuberStereo::depthMap( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples, float dscale, Image* normalmap )
+	/* the kernels are only built on first use, the CPU path works without an OpenCL device */
+	void PMHuberStereo::initCL()
+	{
+		if( ( cl_kernel ) _clpmh_propagate != NULL )
+			return;
+
+		_clpmh_init = CLKernel( _pmhstereo_source, "pmhstereo_init" );
+		_clpmh_propagate = CLKernel( _pmhstereo_source, "pmhstereo_propagate_view" );
+		_clpmh_depthmap = CLKernel( _pmhstereo_source, "pmhstereo_depthmap" );
+		_clpmh_viewbufclear = CLKernel( _pmhstereo_source, "pmhstereo_viewbuf_clear" );
+		_clpmh_fill = CLKernel( _pmhstereo_source, "pmhstereo_fill_state" );
+		_clpmh_consistency = CLKernel( _pmhstereo_source, "pmhstereo_consistency" );
+		_clpmh_filldepthmap = CLKernel( _pmhstereo_source, "pmhstereo_fill_depthmap" );
+		_clpmh_fillnormalmap = CLKernel( _pmhstereo_source, "pmhstereo_fill_normalmap" );
+		_clpmh_normaldepth = CLKernel( _pmhstereo_source, "pmhstereo_normal_depth" );
+		_clpmh_clear = CLKernel( _pmhstereo_source, "pmhstereo_clear" );
+		_clpmh_occmap = CLKernel( _pmhstereo_source, "pmhstereo_occmap" );
+		_clpmh_gradxy = CLKernel( _pmhstereo_source, "pmhstereo_gradxy" );
+		_clpmh_weight = CLKernel( _pmhstereo_source, "pmhstereo_weight" );
+	}
+
+	void PMHuberStereo::depthMap( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples, float dscale, Image* normalmap, IFilterType type )
+	{
+		switch( type ) {
+			case IFILTER_OPENCL:
+				depthMapCL( dmap, left, right, patchsize, depthmax, iterations, dscale, normalmap );
+				break;
+			case IFILTER_CPU:
+				depthMapCPU( dmap, left, right, patchsize, depthmax, iterations, viewsamples, dscale, normalmap );
+				break;
+			default:
+				throw CVTException( "Not implemented" );
+		}
+	}
+
+	void PMHuberStereo::depthMapInpaint( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples, IFilterType type )
+	{
+		switch( type ) {
+			case IFILTER_OPENCL:
+				depthMapInpaintCL( dmap, left, right, patchsize, depthmax, iterations );
+				break;
+			case IFILTER_CPU:
+				depthMapInpaintCPU( dmap, left, right, patchsize, depthmax, iterations, viewsamples );
+				break;
+			default:
+				throw CVTException( "Not implemented" );
+		}
+	}
+
+	void PMHuberStereo::depthMapCL( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, float dscale, Image* normalmap )
 	{
 		if( left.width() != right.width() || left.height() != right.height() ||
 		    left.memType() != IALLOCATOR_CL || right.memType() != IALLOCATOR_CL )
 			throw CVTException( "Left/Right stereo images inconsistent or incompatible memory type" );
 
+		initCL();
+
 		const float maxdispdiff = 0.5f;
 		const float maxanglediff = 10.0f;
 		const float thetascale = 50.0f;
@@ -290,12 +335,14 @@ namespace cvt {
 		}
 	}
 
-	void PMHuberStereo::depthMapInpaint( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples )
+	void PMHuberStereo::depthMapInpaintCL( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations )
 	{
 		if( left.width() != right.width() || left.height() != right.height() ||
 		    left.memType() != IALLOCATOR_CL || right.memType() != IALLOCATOR_CL )
 			throw CVTException( "Left/Right stereo images inconsistent or incompatible memory type" );
 
+		initCL();
+
 		float theta = 0.0f;
 		CLBuffer viewbuf1( sizeof( PMHVIEWPROP ) * left.width() * left.height() );
 		CLBuffer viewbuf2( sizeof( PMHVIEWPROP ) * right.width() * right.height() );
@@ -505,4 +552,813 @@ namespace cvt {
 //		_clpmh_outputfinal.save( "stereofinal.png" );
 
 	}
+
+	/* CPU implementation of the kernels in pmhstereo.cl: the pixel states are the planes x' = a * x + b * y + c
+	   mapping into the other view and the patch cost in w. The propagation runs red-black: first all pixels
+	   with even x + y are updated from the neighbours of the last state, then the odd pixels from the updated
+	   ones. Every pixel has its own random sequence, the result does not depend on the number of threads */
+	static const float PMH_DEPTHREFINEMUL  = 2.0f;
+	static const float PMH_NORMALREFINEMUL = 0.1f;
+	static const float PMH_NORMALCOMPMAX   = 0.95f;
+	static const int   PMH_NUMRNDTRIES	   = 3;
+	static const int   PMH_NUMRNDSAMPLE	   = 6;
+	static const float PMH_COLORWEIGHT	   = 26.0f;
+	static const float PMH_COLORGRADALPHA  = 0.05f;
+	static const float PMH_COLORMAXDIFF	   = 0.04f;
+	static const float PMH_GRADMAXDIFF	   = 0.01f;
+
+	class PMHRandom
+	{
+		public:
+			PMHRandom( uint32_t seed ) : _state( hash( seed ) )
+			{
+				if( !_state )
+					_state = 1;
+			}
+
+			/* xorshift32, uniform in [ 0, 1 ) */
+			float next()
+			{
+				_state ^= _state << 13;
+				_state ^= _state >> 17;
+				_state ^= _state << 5;
+				return 2.3283064365386962890625e-10f * ( float ) _state;
+			}
+
+			static uint32_t hash( uint32_t v )
+			{
+				v = ( v ^ 61 ) ^ ( v >> 16 );
+				v *= 9;
+				v ^= v >> 4;
+				v *= 0x27d4eb2d;
+				v ^= v >> 15;
+				return v;
+			}
+
+		private:
+			uint32_t _state;
+	};
+
+	static inline bool _pmhFinite( const Vector4f& s )
+	{
+		const float fmax = std::numeric_limits<float>::max();
+		return Math::abs( s.x ) <= fmax && Math::abs( s.y ) <= fmax && Math::abs( s.z ) <= fmax;
+	}
+
+	static inline Vector4f _pmhViewprop( const Vector4f& s )
+	{
+		return Vector4f( 1.0f / s.x, -s.y / s.x, -s.z / s.x, 0.0f );
+	}
+
+	static inline float _pmhTransform( const Vector4f& s, float x, float y )
+	{
+		return s.x * x + s.y * y + s.z;
+	}
+
+	/* state from the normal ( nx, ny ) and the depth z at ( x, y ) of the reference view */
+	static inline Vector4f _pmhFromNormalDepth( float nx, float ny, float z, float x, float y, int lr )
+	{
+		float nfactor = Math::max( Math::sqrt( nx * nx + ny * ny ) + 0.001f, 1.0f );
+		nx /= nfactor;
+		ny /= nfactor;
+		float nz = Math::sqrt( 1.0f - nx * nx - ny * ny );
+
+		Vector4f ret( 1.0f + nx / nz, ny / nz, -( ( nx * x + ny * y ) / nz + z ), 0.0f );
+		if( !lr )
+			return _pmhViewprop( ret );
+		return ret;
+	}
+
+	static inline Vector4f _pmhInit( PMHRandom& rng, float x, float y, int lr, float normmul, float depthmax )
+	{
+		float z = rng.next() * depthmax;
+		float nx = ( rng.next() - 0.5f ) * normmul * PMH_NORMALCOMPMAX;
+		float ny = ( rng.next() - 0.5f ) * normmul * PMH_NORMALCOMPMAX;
+		nx = Math::clamp( nx, -PMH_NORMALCOMPMAX, PMH_NORMALCOMPMAX );
+		ny = Math::clamp( ny, -PMH_NORMALCOMPMAX, PMH_NORMALCOMPMAX );
+		return _pmhFromNormalDepth( nx, ny, z, x, y, lr );
+	}
+
+	/* normal and depth of the state in the reference view */
+	static inline Vector4f _pmhToRefNormalDepth( const Vector4f& state, float x, float y, int lr )
+	{
+		Vector4f s = lr ? state : _pmhViewprop( state );
+		s.x = 1.0f - s.x;
+		s.y = -s.y;
+		s.z = -s.z;
+
+		Vector4f ret;
+		ret.w = s.x * x + s.y * y + s.z;
+		ret.z = 1.0f / Math::sqrt( s.x * s.x + s.y * s.y + 1.0f );
+		ret.x = -s.x * ret.z;
+		ret.y = -s.y * ret.z;
+		if( !_pmhFinite( ret ) )
+			return Vector4f( 0.0f, 0.0f, 1.0f, 0.0f );
+		return ret;
+	}
+
+	static inline Vector3f _pmhToNormal( const Vector4f& s )
+	{
+		float sx = 1.0f - s.x;
+		float sy = -s.y;
+		float nz = 1.0f / Math::sqrt( sx * sx + sy * sy + 1.0f );
+		return Vector3f( -sx * nz, -sy * nz, nz );
+	}
+
+	static inline Vector4f _pmhRefine( PMHRandom& rng, const Vector4f& state, float x, float y, float depthmax, int lr )
+	{
+		Vector4f nd = _pmhToRefNormalDepth( state, x, y, lr );
+		float z = nd.w + ( rng.next() - 0.5f ) * PMH_DEPTHREFINEMUL;
+		z = Math::clamp( z, 0.0f, depthmax );
+		float nx = nd.x + ( rng.next() - 0.5f ) * PMH_NORMALREFINEMUL;
+		float ny = nd.y + ( rng.next() - 0.5f ) * PMH_NORMALREFINEMUL;
+		nx = Math::clamp( nx, -PMH_NORMALCOMPMAX, PMH_NORMALCOMPMAX );
+		ny = Math::clamp( ny, -PMH_NORMALCOMPMAX, PMH_NORMALCOMPMAX );
+		return _pmhFromNormalDepth( nx, ny, z, x, y, lr );
+	}
+
+	class PMHuberStereoCPU
+	{
+		public:
+			struct View {
+				std::vector<float>		feature;	/* r, g, b, dx, dy, dxy, dyx, 0 */
+				std::vector<float>		weight;
+				std::vector<Vector4f>	state;
+				std::vector<Vector4f>	tmp;
+				std::vector<Vector4f>	smooth;
+				std::vector<Vector4f>	viewbuf;
+				std::vector<int>		viewcount;
+			};
+
+			PMHuberStereoCPU( const Image& left, const Image& right, size_t patchsize, float depthmax, size_t viewsamples );
+
+			void init( int lr );
+			void propagate( int lr, size_t iter, float theta );
+			void consistency( std::vector<Vector4f>& output, int lr, float maxdispdiff, float maxanglediff );
+			void occlusionMap( std::vector<float>& output, int lr, float maxdispdiff );
+			void fillState( std::vector<Vector4f>& output, const std::vector<Vector4f>& input, int lr );
+			void normalDepth( std::vector<Vector4f>& output, int lr );
+			void smooth( int lr, const std::vector<Vector4f>& input, const std::vector<float>* mask, float lambda, size_t iter );
+			void depthMap( Image& dmap, const std::vector<Vector4f>& input, float scale ) const;
+			void normalMap( Image& normalmap, const std::vector<Vector4f>& input ) const;
+
+			/* parallel parts, all of them work on rows [ start, end ) */
+			void initRows( size_t start, size_t end ) const;
+			void propagateRows( size_t start, size_t end ) const;
+			void consistencyRows( size_t start, size_t end ) const;
+			void fillStateRows( size_t start, size_t end ) const;
+			void normalDepthRows( size_t start, size_t end ) const;
+			void rofDualRows( size_t start, size_t end ) const;
+			void rofPrimalRows( size_t start, size_t end ) const;
+
+		private:
+			void prepare( View& view, const Image& img );
+			void setupPatch( float* ref, float* weights, const View& view, size_t x, size_t y ) const;
+			float patchCost( const float* ref, const float* weights, const View& other, size_t x, size_t y, const Vector4f& state ) const;
+			Vector2f smoothDistance( const Vector4f& a, const Vector4f& b, const Vector4f& smooth, float x, float y ) const;
+			bool check( Vector4f& statel, float& dispdiff, float& angle, size_t x, size_t y ) const;
+
+			SIMD*		_simd;
+			size_t		_width, _height;
+			int			_patchsize;
+			float		_depthmax;
+			size_t		_viewsamples;
+			View		_view[ 2 ];
+
+			/* arguments of the parallel parts, _lr = 1 is the left view */
+			int			_lr;
+			size_t		_iter;
+			float		_theta;
+			int			_phase;
+			float		_maxdispdiff;
+			float		_maxanglediff;
+			float		_lambda;
+			const std::vector<Vector4f>*	_input;
+			std::vector<Vector4f>*			_output;
+			std::vector<float>*				_maskout;
+			const std::vector<float>*		_mask;
+			std::vector<Vector4f>			_px, _py;
+	};
+
+	PMHuberStereoCPU::PMHuberStereoCPU( const Image& left, const Image& right, size_t patchsize, float depthmax, size_t viewsamples ) :
+		_simd( SIMD::instance() ),
+		_width( left.width() ),
+		_height( left.height() ),
+		_patchsize( ( int ) patchsize ),
+		_depthmax( depthmax ),
+		_viewsamples( viewsamples )
+	{
+		const size_t n = _width * _height;
+		/* index 1 is the left view like the lr flag of the kernels */
+		prepare( _view[ 1 ], left );
+		prepare( _view[ 0 ], right );
+		for( size_t i = 0; i < 2; i++ ) {
+			_view[ i ].state.resize( n, Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ) );
+			_view[ i ].tmp.resize( n, Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ) );
+			_view[ i ].smooth.resize( n, Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ) );
+			_view[ i ].viewbuf.resize( n * Math::max<size_t>( viewsamples, 1 ) );
+			_view[ i ].viewcount.resize( n, 0 );
+		}
+	}
+
+	/* colour, gradients as in pmhstereo_gradxy and the huber weights as in pmhstereo_weight */
+	void PMHuberStereoCPU::prepare( View& view, const Image& img )
+	{
+		const size_t w = _width, h = _height;
+		Image rgba;
+		img.convert( rgba, IFormat::RGBA_FLOAT );
+
+		std::vector<float> gray( w * h );
+		view.feature.resize( 8 * w * h );
+		view.weight.resize( w * h );
+
+		IMapScoped<const float> map( rgba );
+		for( size_t y = 0; y < h; y++ ) {
+			const float* src = map.ptr();
+			float* f = &view.feature[ 8 * y * w ];
+			for( size_t x = 0; x < w; x++ ) {
+				f[ 0 ] = src[ 0 ];
+				f[ 1 ] = src[ 1 ];
+				f[ 2 ] = src[ 2 ];
+				gray[ y * w + x ] = 0.2126f * src[ 0 ] + 0.7152f * src[ 1 ] + 0.0722f * src[ 2 ];
+				src += 4;
+				f += 8;
+			}
+			map++;
+		}
+
+#define GRAY( x, y ) ( ( ( x ) >= 0 && ( x ) < ( int ) w && ( y ) >= 0 && ( y ) < ( int ) h ) ? gray[ ( y ) * w + ( x ) ] : 0.0f )
+		for( int y = 0; y < ( int ) h; y++ ) {
+			for( int x = 0; x < ( int ) w; x++ ) {
+				float* f = &view.feature[ 8 * ( y * w + x ) ];
+				float dx = GRAY( x + 1, y ) - GRAY( x - 1, y );
+				f[ 3 ] = dx * 0.5f + ( GRAY( x + 1, y - 1 ) - GRAY( x - 1, y - 1 ) ) * 0.25f + ( GRAY( x + 1, y + 1 ) - GRAY( x - 1, y + 1 ) ) * 0.25f;
+				f[ 4 ] = ( GRAY( x, y + 1 ) - GRAY( x, y - 1 ) ) * 0.5f + ( GRAY( x - 1, y + 1 ) - GRAY( x - 1, y - 1 ) ) * 0.25f + ( GRAY( x + 1, y + 1 ) - GRAY( x + 1, y - 1 ) ) * 0.25f;
+				f[ 5 ] = GRAY( x + 1, y + 1 ) - GRAY( x - 1, y - 1 );
+				f[ 6 ] = GRAY( x - 1, y + 1 ) - GRAY( x + 1, y - 1 );
+				f[ 7 ] = 0.0f;
+				/* the weight only depends on the horizontal gradient like in the kernel */
+				view.weight[ y * w + x ] = Math::exp( -3.0f * Math::pow( Math::abs( dx ), 0.8f ) ) + 0.0001f;
+			}
+		}
+#undef GRAY
+	}
+
+	/* reference samples and support weights of the patch around ( x, y ), samples outside of the image get weight 0 */
+	void PMHuberStereoCPU::setupPatch( float* ref, float* weights, const View& view, size_t x, size_t y ) const
+	{
+		const int ps = _patchsize;
+		const float* center = &view.feature[ 8 * ( y * _width + x ) ];
+
+		for( int dy = -ps; dy <= ps; dy++ ) {
+			int py = ( int ) y + dy;
+			for( int dx = -ps; dx <= ps; dx++, ref += 8, weights++ ) {
+				int px = ( int ) x + dx;
+				if( px < 0 || px >= ( int ) _width || py < 0 || py >= ( int ) _height ) {
+					*weights = 0.0f;
+					for( size_t k = 0; k < 8; k++ )
+						ref[ k ] = 0.0f;
+					continue;
+				}
+				const float* val = &view.feature[ 8 * ( py * _width + px ) ];
+				float len = Math::sqrt( ( float ) ( dx * dx + dy * dy ) );
+				float cdiff = Math::abs( center[ 0 ] - val[ 0 ] ) + Math::abs( center[ 1 ] - val[ 1 ] ) + Math::abs( center[ 2 ] - val[ 2 ] );
+				*weights = Math::exp( -cdiff * ( Math::smoothstep( 0.0f, 26.0f, len ) * 1.5f * PMH_COLORWEIGHT + 5.0f ) );
+				for( size_t k = 0; k < 8; k++ )
+					ref[ k ] = val[ k ];
+			}
+		}
+	}
+
+	/* patch_eval_color_grad_weighted, one SIMD call per patch row */
+	float PMHuberStereoCPU::patchCost( const float* ref, const float* weights, const View& other, size_t x, size_t y, const Vector4f& state ) const
+	{
+		static const float truncation[ 8 ] = { PMH_COLORMAXDIFF, PMH_COLORMAXDIFF, PMH_COLORMAXDIFF,
+											   PMH_GRADMAXDIFF, PMH_GRADMAXDIFF, PMH_GRADMAXDIFF, PMH_GRADMAXDIFF, 0.0f };
+		static const float scale[ 8 ] = { PMH_COLORGRADALPHA, PMH_COLORGRADALPHA, PMH_COLORGRADALPHA,
+										  1.0f - PMH_COLORGRADALPHA, 1.0f - PMH_COLORGRADALPHA, 1.0f - PMH_COLORGRADALPHA, 1.0f - PMH_COLORGRADALPHA, 0.0f };
+
+		if( !_pmhFinite( state ) )
+			return 1e5f;
+
+		const int ps = _patchsize;
+		const size_t n = 2 * ps + 1;
+		float cost = 0.0f;
+		float wsum = 0.0f;
+
+		for( int dy = -ps; dy <= ps; dy++, ref += 8 * n, weights += n ) {
+			int py = ( int ) y + dy;
+			if( py < 0 || py >= ( int ) _height )
+				continue;
+			float x0 = _pmhTransform( state, ( float ) ( ( int ) x - ps ), ( float ) py );
+			cost += _simd->costTruncatedL1Line8f( wsum, ref, weights, &other.feature[ 8 * py * _width ], _width, x0, state.x, truncation, scale, n );
+		}
+
+		if( wsum <= 1.1f )
+			return 1e5f;
+		return cost / wsum;
+	}
+
+	Vector2f PMHuberStereoCPU::smoothDistance( const Vector4f& a, const Vector4f& b, const Vector4f& smooth, float x, float y ) const
+	{
+		if( !_pmhFinite( a ) || !_pmhFinite( b ) )
+			return Vector2f( 0.0f, 0.0f );
+
+		const float dscale = 1.0f / ( _depthmax * _depthmax );
+		Vector4f da = _pmhToRefNormalDepth( a, x, y, _lr ) - smooth;
+		Vector4f db = _pmhToRefNormalDepth( b, x, y, _lr ) - smooth;
+		return Vector2f( da.x * da.x + da.y * da.y + dscale * da.w * da.w,
+						 db.x * db.x + db.y * db.y + dscale * db.w * db.w );
+	}
+
+	void PMHuberStereoCPU::init( int lr )
+	{
+		_lr = lr;
+		ParallelFor::run( ParallelFor::bind( *this, &PMHuberStereoCPU::initRows ), 0, _height );
+	}
+
+	void PMHuberStereoCPU::initRows( size_t start, size_t end ) const
+	{
+		const View& view = _view[ _lr ];
+		const View& other = _view[ 1 - _lr ];
+		const size_t n = Math::sqr( 2 * _patchsize + 1 );
+		ScopedBuffer<float, true> ref( 8 * n );
+		ScopedBuffer<float, true> weights( n );
+		std::vector<Vector4f>& state = const_cast<std::vector<Vector4f>&>( view.state );
+
+		for( size_t y = start; y < end; y++ ) {
+			for( size_t x = 0; x < _width; x++ ) {
+				PMHRandom rng( ( uint32_t ) ( y * _width + x ) * 2 + _lr );
+				Vector4f s = _pmhInit( rng, ( float ) x, ( float ) y, _lr, 1.0f, _depthmax );
+				setupPatch( ref.ptr(), weights.ptr(), view, x, y );
+				s.w = patchCost( ref.ptr(), weights.ptr(), other, x, y, s );
+				state[ y * _width + x ] = s;
+			}
+		}
+	}
+
+	/* red-black propagation of one view, reads the view propagation buffer of this view and fills the one of the other view */
+	void PMHuberStereoCPU::propagate( int lr, size_t iter, float theta )
+	{
+		View& other = _view[ 1 - lr ];
+		std::fill( other.viewcount.begin(), other.viewcount.end(), 0 );
+
+		_lr = lr;
+		_iter = iter;
+		_theta = theta;
+		for( _phase = 0; _phase < 2; _phase++ )
+			ParallelFor::run( ParallelFor::bind( *this, &PMHuberStereoCPU::propagateRows ), 0, _height );
+	}
+
+	void PMHuberStereoCPU::propagateRows( size_t start, size_t end ) const
+	{
+		const View& view = _view[ _lr ];
+		View& other = const_cast<View&>( _view[ 1 - _lr ] );
+		/* phase 0 reads state and writes tmp, phase 1 the other way around */
+		const std::vector<Vector4f>& src = _phase ? view.tmp : view.state;
+		std::vector<Vector4f>& dst = const_cast<std::vector<Vector4f>&>( _phase ? view.state : view.tmp );
+		const int w = ( int ) _width, h = ( int ) _height;
+		const size_t n = Math::sqr( 2 * _patchsize + 1 );
+		const float theta = _theta;
+		ScopedBuffer<float, true> ref( 8 * n );
+		ScopedBuffer<float, true> weights( n );
+
+		for( int y = ( int ) start; y < ( int ) end; y++ ) {
+			for( int x = 0; x < w; x++ ) {
+				const size_t idx = y * w + x;
+				if( ( ( x + y ) & 1 ) != _phase ) {
+					dst[ idx ] = src[ idx ];
+					continue;
+				}
+
+				const float fx = ( float ) x, fy = ( float ) y;
+				PMHRandom rng( ( uint32_t ) ( idx * 2 + _lr ) + ( uint32_t ) _iter * 0x9e3779b9 );
+				setupPatch( ref.ptr(), weights.ptr(), view, x, y );
+
+				Vector4f smooth = view.smooth[ idx ];
+				float nfactor = Math::max( Math::sqrt( smooth.x * smooth.x + smooth.y * smooth.y ) + 0.001f, 1.0f );
+				smooth.x /= nfactor;
+				smooth.y /= nfactor;
+				smooth = Vector4f( smooth.x, smooth.y, Math::sqrt( 1.0f - smooth.x * smooth.x - smooth.y * smooth.y ), smooth.z * _depthmax );
+
+				Vector4f self = src[ idx ];
+				Vector4f neighbour;
+				Vector2f sdist;
+
+#define PMH_TRY( candidate ) do { \
+					neighbour = ( candidate ); \
+					neighbour.w = patchCost( ref.ptr(), weights.ptr(), other, x, y, neighbour ); \
+					sdist = smoothDistance( neighbour, self, smooth, fx, fy ); \
+					if( neighbour.w + theta * sdist.x <= self.w + theta * sdist.y ) \
+						self = neighbour; \
+				} while( 0 )
+
+				/* the neighbours */
+				for( int py = -1; py <= 1; py++ ) {
+					int ny = Math::clamp( y + py, 0, h - 1 );
+					for( int px = -1; px <= 1; px++ ) {
+						if( px == 0 && py == 0 )
+							continue;
+						int nx = Math::clamp( x + px, 0, w - 1 );
+						PMH_TRY( src[ ny * w + nx ] );
+					}
+				}
+
+				/* the smoothed state */
+				Vector4f ssmooth( 1.0f + smooth.x / smooth.z, smooth.y / smooth.z, -( ( smooth.x * fx + smooth.y * fy ) / smooth.z + smooth.w ), 0.0f );
+				PMH_TRY( _lr ? ssmooth : _pmhViewprop( ssmooth ) );
+
+				/* random samples of the neighbourhood */
+				for( int i = 0; i < PMH_NUMRNDSAMPLE; i++ ) {
+					int nx = Math::min( x + ( int ) ( rng.next() * 7.0f + 0.5f ), w - 1 );
+					int ny = Math::min( y + ( int ) ( rng.next() * 7.0f + 0.5f ), h - 1 );
+					PMH_TRY( src[ ny * w + nx ] );
+				}
+
+				/* random state */
+				PMH_TRY( _pmhInit( rng, fx, fy, _lr, 2.0f, _depthmax ) );
+
+				/* states propagated from the other view */
+				const int nview = Math::min( view.viewcount[ idx ], ( int ) _viewsamples );
+				for( int i = 0; i < nview; i++ )
+					PMH_TRY( view.viewbuf[ idx * _viewsamples + i ] );
+
+				/* randomized refinement */
+				for( int i = 0; i < PMH_NUMRNDTRIES - 1; i++ )
+					PMH_TRY( _pmhRefine( rng, self, fx, fy, _depthmax, _lr ) );
+#undef PMH_TRY
+
+				/* the target pixel is in the same row, rows are never shared between threads */
+				if( _viewsamples ) {
+					float pos = _pmhTransform( self, fx, fy );
+					if( pos >= -0.5f && pos < ( float ) w - 0.5f ) {
+						size_t tidx = y * w + ( size_t ) ( pos + 0.5f );
+						int& count = other.viewcount[ tidx ];
+						if( count < ( int ) _viewsamples )
+							other.viewbuf[ tidx * _viewsamples + count ] = _pmhViewprop( self );
+						count++;
+					}
+				}
+
+				dst[ idx ] = self;
+			}
+		}
+	}
+
+	/* compares the state of the view lr with the state it points to in the other view */
+	bool PMHuberStereoCPU::check( Vector4f& statel, float& dispdiff, float& angle, size_t x, size_t y ) const
+	{
+		const View& view = _view[ _lr ];
+		const View& other = _view[ 1 - _lr ];
+		statel = view.state[ y * _width + x ];
+
+		float x2 = _pmhTransform( statel, ( float ) x, ( float ) y );
+		Vector4f stater;
+		if( x2 < 0 || x2 >= ( float ) _width )
+			stater = Vector4f( 1e5f, 1e5f, 1e5f, 1e5f );
+		else
+			stater = other.state[ y * _width + Math::min( ( size_t ) ( x2 + 0.5f ), _width - 1 ) ];
+
+		float ndiff;
+		if( _lr )
+			ndiff = _pmhToNormal( statel ) * _pmhToNormal( _pmhViewprop( stater ) );
+		else
+			ndiff = _pmhToNormal( stater ) * _pmhToNormal( _pmhViewprop( statel ) );
+
+		dispdiff = Math::abs( ( float ) x - _pmhTransform( stater, x2, ( float ) y ) );
+		angle = Math::rad2Deg( Math::acos( ndiff ) );
+		return true;
+	}
+
+	void PMHuberStereoCPU::consistency( std::vector<Vector4f>& output, int lr, float maxdispdiff, float maxanglediff )
+	{
+		output.resize( _width * _height );
+		_lr = lr;
+		_output = &output;
+		_maskout = NULL;
+		_maxdispdiff = maxdispdiff;
+		_maxanglediff = maxanglediff;
+		ParallelFor::run( ParallelFor::bind( *this, &PMHuberStereoCPU::consistencyRows ), 0, _height, 16 );
+	}
+
+	/* occluded or inconsistent pixels get mask 0, the angle limit is 5 degrees as in pmhstereo_occmap */
+	void PMHuberStereoCPU::occlusionMap( std::vector<float>& output, int lr, float maxdispdiff )
+	{
+		output.resize( _width * _height );
+		_lr = lr;
+		_output = NULL;
+		_maskout = &output;
+		_maxdispdiff = maxdispdiff;
+		_maxanglediff = 5.0f;
+		ParallelFor::run( ParallelFor::bind( *this, &PMHuberStereoCPU::consistencyRows ), 0, _height, 16 );
+	}
+
+	void PMHuberStereoCPU::consistencyRows( size_t start, size_t end ) const
+	{
+		for( size_t y = start; y < end; y++ ) {
+			for( size_t x = 0; x < _width; x++ ) {
+				Vector4f state;
+				float dispdiff, angle;
+				check( state, dispdiff, angle, x, y );
+				/* comparisons with NaN angles are false like in the kernels */
+				bool invalid = dispdiff >= _maxdispdiff || angle >= _maxanglediff;
+				if( _output )
+					( *_output )[ y * _width + x ] = invalid ? Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ) : state;
+				else
+					( *_maskout )[ y * _width + x ] = invalid ? 0.0f : 1.0f;
+			}
+		}
+	}
+
+	void PMHuberStereoCPU::fillState( std::vector<Vector4f>& output, const std::vector<Vector4f>& input, int lr )
+	{
+		output.resize( _width * _height );
+		_lr = lr;
+		_input = &input;
+		_output = &output;
+		ParallelFor::run( ParallelFor::bind( *this, &PMHuberStereoCPU::fillStateRows ), 0, _height, 16 );
+	}
+
+	/* invalid states are replaced by the valid neighbour in the row with the larger depth, the output is ( nx, ny, depth / depthmax, 1 ) */
+	void PMHuberStereoCPU::fillStateRows( size_t start, size_t end ) const
+	{
+		const std::vector<Vector4f>& input = *_input;
+		const int w = ( int ) _width;
+
+		for( size_t y = start; y < end; y++ ) {
+			const Vector4f* row = &input[ y * w ];
+			for( int x = 0; x < w; x++ ) {
+				const float fx = ( float ) x, fy = ( float ) y;
+				Vector4f val = row[ x ];
+				if( val.length() < 1e-1f ) {
+					Vector4f left( 0.0f, 0.0f, 0.0f, 0.0f );
+					for( int i = x - 1; left.length() < 1e-1f && i >= 0; i-- )
+						left = row[ i ];
+					Vector4f right( 0.0f, 0.0f, 0.0f, 0.0f );
+					for( int i = x + 1; right.length() < 1e-1f && i < w; i++ )
+						right = row[ i ];
+					if( left.length() < 1e-1f ) left = Vector4f( 1e5f, 1e5f, 1e5f, 1e5f );
+					if( right.length() < 1e-1f ) right = Vector4f( 1e5f, 1e5f, 1e5f, 1e5f );
+
+					left.w = Math::abs( _pmhTransform( left, fx, fy ) - fx );
+					right.w = Math::abs( _pmhTransform( right, fx, fy ) - fx );
+					val = left.w < right.w ? left : right;
+				}
+				val = _pmhToRefNormalDepth( val, fx, fy, _lr );
+				( *_output )[ y * w + x ] = Vector4f( val.x, val.y, val.w / _depthmax, 1.0f );
+			}
+		}
+	}
+
+	void PMHuberStereoCPU::normalDepth( std::vector<Vector4f>& output, int lr )
+	{
+		output.resize( _width * _height );
+		_lr = lr;
+		_output = &output;
+		ParallelFor::run( ParallelFor::bind( *this, &PMHuberStereoCPU::normalDepthRows ), 0, _height, 16 );
+	}
+
+	void PMHuberStereoCPU::normalDepthRows( size_t start, size_t end ) const
+	{
+		const std::vector<Vector4f>& state = _view[ _lr ].state;
+		for( size_t y = start; y < end; y++ ) {
+			for( size_t x = 0; x < _width; x++ ) {
+				Vector4f val = _pmhToRefNormalDepth( state[ y * _width + x ], ( float ) x, ( float ) y, _lr );
+				( *_output )[ y * _width + x ] = Vector4f( val.x, val.y, val.w / _depthmax, 1.0f );
+			}
+		}
+	}
+
+	/* weighted Huber-ROF as in PDHuberWeighted and PDHuberWeightedInpaint ( with mask ), warm started
+	   with the current smooth image of the view. Dual and primal steps are separate passes over the rows */
+	static const float PMH_ROF_SIGMA = 0.35355339f;
+	static const float PMH_ROF_TAU   = 0.35355339f;
+	static const float PMH_ROF_THETA = 0.5f;
+	static const float PMH_ROF_ALPHA = 0.001f;
+
+	void PMHuberStereoCPU::smooth( int lr, const std::vector<Vector4f>& input, const std::vector<float>* mask, float lambda, size_t iter )
+	{
+		const Vector4f zero( 0.0f, 0.0f, 0.0f, 0.0f );
+		_px.assign( _width * _height, zero );
+		_py.assign( _width * _height, zero );
+		_lr = lr;
+		_input = &input;
+		_mask = mask;
+		_lambda = lambda;
+		for( size_t i = 0; i < iter; i++ ) {
+			ParallelFor::run( ParallelFor::bind( *this, &PMHuberStereoCPU::rofDualRows ), 0, _height, 16 );
+			ParallelFor::run( ParallelFor::bind( *this, &PMHuberStereoCPU::rofPrimalRows ), 0, _height, 16 );
+		}
+	}
+
+	void PMHuberStereoCPU::rofDualRows( size_t start, size_t end ) const
+	{
+		const View& view = _view[ _lr ];
+		const std::vector<Vector4f>& u = view.smooth;
+		Vector4f* px = const_cast<Vector4f*>( &_px[ 0 ] );
+		Vector4f* py = const_cast<Vector4f*>( &_py[ 0 ] );
+		const size_t w = _width;
+
+		for( size_t y = start; y < end; y++ ) {
+			for( size_t x = 0; x < w; x++ ) {
+				const size_t idx = y * w + x;
+				const float weight = view.weight[ idx ];
+				const Vector4f& c = u[ idx ];
+				Vector4f dx = x + 1 < w ? ( c - u[ idx + 1 ] ) * weight : Vector4f( 0.0f, 0.0f, 0.0f, 0.0f );
+				Vector4f dy = y + 1 < _height ? ( c - u[ idx + w ] ) * weight : Vector4f( 0.0f, 0.0f, 0.0f, 0.0f );
+				const float denom = 1.0f / ( 1.0f + PMH_ROF_SIGMA * PMH_ROF_ALPHA / weight );
+				Vector4f a = ( px[ idx ] + dx * PMH_ROF_SIGMA ) * denom;
+				Vector4f b = ( py[ idx ] + dy * PMH_ROF_SIGMA ) * denom;
+
+				if( _mask ) {
+					/* every channel on its own */
+					for( int k = 0; k < 4; k++ ) {
+						float n = Math::max( 1.0f, Math::sqrt( a[ k ] * a[ k ] + b[ k ] * b[ k ] ) );
+						a[ k ] /= n;
+						b[ k ] /= n;
+					}
+				} else {
+					/* the normal components together, the depth on its own, the last channel is not projected */
+					float n = Math::max( 1.0f, Math::sqrt( a.x * a.x + b.x * b.x + a.y * a.y + b.y * b.y ) );
+					a.x /= n; a.y /= n;
+					b.x /= n; b.y /= n;
+					n = Math::max( 1.0f, Math::sqrt( a.z * a.z + b.z * b.z ) );
+					a.z /= n;
+					b.z /= n;
+				}
+				px[ idx ] = a;
+				py[ idx ] = b;
+			}
+		}
+	}
+
+	void PMHuberStereoCPU::rofPrimalRows( size_t start, size_t end ) const
+	{
+		View& view = const_cast<View&>( _view[ _lr ] );
+		const std::vector<Vector4f>& f = *_input;
+		const size_t w = _width;
+
+		for( size_t y = start; y < end; y++ ) {
+			for( size_t x = 0; x < w; x++ ) {
+				const size_t idx = y * w + x;
+				Vector4f div = _px[ idx ] + _py[ idx ];
+				if( x > 0 )
+					div -= _px[ idx - 1 ];
+				if( y > 0 )
+					div -= _py[ idx - w ];
+				div *= view.weight[ idx ];
+
+				float lambda = _lambda;
+				if( _mask )
+					lambda *= ( *_mask )[ idx ];
+
+				Vector4f& u = view.smooth[ idx ];
+				Vector4f unew = ( u + ( f[ idx ] * lambda - div ) * PMH_ROF_TAU ) / ( 1.0f + PMH_ROF_TAU * lambda );
+				u = unew + ( unew - u ) * PMH_ROF_THETA;
+				u.w = 1.0f;
+			}
+		}
+	}
+
+	/* pmhstereo_fill_depthmap: the disparity of consistent pixels, the smaller one of the neighbours in the row otherwise */
+	void PMHuberStereoCPU::depthMap( Image& dmap, const std::vector<Vector4f>& input, float scale ) const
+	{
+		Image tmp( _width, _height, IFormat::GRAY_FLOAT );
+		IMapScoped<float> map( tmp );
+		const int w = ( int ) _width;
+		const float invalid = -1e5f;
+
+		for( size_t y = 0; y < _height; y++ ) {
+			const Vector4f* row = &input[ y * w ];
+			float* dst = map.ptr();
+			const float fy = ( float ) y;
+			for( int x = 0; x < w; x++ ) {
+				const float fx = ( float ) x;
+				Vector4f state = row[ x ];
+				Vector3f xyz( state.x, state.y, state.z );
+				if( xyz.length() < 1e-1f ) {
+					Vector4f left( 0.0f, 0.0f, 0.0f, 0.0f ), right( 0.0f, 0.0f, 0.0f, 0.0f );
+					for( int i = x - 1; Vector3f( left.x, left.y, left.z ).length() < 1e-1f && i >= 0; i-- )
+						left = row[ i ];
+					for( int i = x + 1; Vector3f( right.x, right.y, right.z ).length() < 1e-1f && i < w; i++ )
+						right = row[ i ];
+					if( Vector3f( left.x, left.y, left.z ).length() < 1e-1f ) left = Vector4f( invalid, invalid, invalid, 0.0f );
+					if( Vector3f( right.x, right.y, right.z ).length() < 1e-1f ) right = Vector4f( invalid, invalid, invalid, 0.0f );
+					dst[ x ] = scale * Math::min( fx - _pmhTransform( left, fx, fy ), fx - _pmhTransform( right, fx, fy ) );
+				} else
+					dst[ x ] = scale * Math::abs( _pmhTransform( state, fx, fy ) - fx );
+			}
+			map++;
+		}
+
+		if( dmap.channels() == 1 && dmap.format() != IFormat::GRAY_FLOAT )
+			tmp.convert( dmap, dmap.format() );
+		else
+			dmap = tmp;
+	}
+
+	void PMHuberStereoCPU::normalMap( Image& normalmap, const std::vector<Vector4f>& input ) const
+	{
+		normalmap.reallocate( _width, _height, IFormat::RGBA_FLOAT );
+		IMapScoped<float> map( normalmap );
+		const int w = ( int ) _width;
+		const float invalid = -1e5f;
+
+		for( size_t y = 0; y < _height; y++ ) {
+			const Vector4f* row = &input[ y * w ];
+			float* dst = map.ptr();
+			const float fy = ( float ) y;
+			for( int x = 0; x < w; x++ ) {
+				const float fx = ( float ) x;
+				Vector4f state = row[ x ];
+				if( Vector3f( state.x, state.y, state.z ).length() < 1e-1f ) {
+					Vector4f left( 0.0f, 0.0f, 0.0f, 0.0f ), right( 0.0f, 0.0f, 0.0f, 0.0f );
+					for( int i = x - 1; Vector3f( left.x, left.y, left.z ).length() < 1e-1f && i >= 0; i-- )
+						left = row[ i ];
+					for( int i = x + 1; Vector3f( right.x, right.y, right.z ).length() < 1e-1f && i < w; i++ )
+						right = row[ i ];
+					if( Vector3f( left.x, left.y, left.z ).length() < 1e-1f ) left = Vector4f( invalid, invalid, invalid, 0.0f );
+					if( Vector3f( right.x, right.y, right.z ).length() < 1e-1f ) right = Vector4f( invalid, invalid, invalid, 0.0f );
+					state = fx - _pmhTransform( left, fx, fy ) < fx - _pmhTransform( right, fx, fy ) ? left : right;
+				}
+				Vector3f n = _pmhToNormal( state );
+				*dst++ = n.x;
+				*dst++ = n.y;
+				*dst++ = n.z;
+				*dst++ = 0.0f;
+			}
+			map++;
+		}
+	}
+
+	void PMHuberStereo::depthMapCPU( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples, float dscale, Image* normalmap )
+	{
+		if( left.width() != right.width() || left.height() != right.height() )
+			throw CVTException( "Left/Right stereo images inconsistent" );
+
+		const float maxdispdiff = 0.5f;
+		const float maxanglediff = 10.0f;
+		const float thetascale = 50.0f;
+		float theta = 0.0f;
+
+		if( dscale <= 0.0f )
+			dscale = 1.0f / depthmax;
+
+		PMHuberStereoCPU pmh( left, right, patchsize, depthmax, viewsamples );
+		std::vector<Vector4f> consistent, filled;
+
+		pmh.init( 1 );
+		pmh.init( 0 );
+
+		for( size_t iter = 0; iter < iterations; iter++ ) {
+			pmh.propagate( 1, iter, theta );
+			pmh.propagate( 0, iter, theta );
+
+			for( int lr = 1; lr >= 0; lr-- ) {
+				pmh.consistency( consistent, lr, maxdispdiff, maxanglediff );
+				pmh.fillState( filled, consistent, lr );
+				pmh.smooth( lr, filled, NULL, theta * thetascale + 5.0f, 250 );
+			}
+
+			if( iter >= 5 )
+				theta = Math::smoothstep<float>( ( ( iter - 5.0f ) / ( ( float ) iterations - 5.0f ) ) ) * 1.0f;
+		}
+
+		pmh.consistency( consistent, 1, maxdispdiff, maxanglediff );
+		pmh.depthMap( dmap, consistent, dscale );
+		if( normalmap != NULL )
+			pmh.normalMap( *normalmap, consistent );
+	}
+
+	void PMHuberStereo::depthMapInpaintCPU( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples )
+	{
+		if( left.width() != right.width() || left.height() != right.height() )
+			throw CVTException( "Left/Right stereo images inconsistent" );
+
+		float theta = 0.0f;
+		PMHuberStereoCPU pmh( left, right, patchsize, depthmax, viewsamples );
+		std::vector<Vector4f> normaldepth;
+		std::vector<float> mask;
+
+		pmh.init( 1 );
+		pmh.init( 0 );
+
+		for( size_t iter = 0; iter < iterations; iter++ ) {
+			pmh.propagate( 1, iter, theta );
+			pmh.propagate( 0, iter, theta );
+
+			for( int lr = 1; lr >= 0; lr-- ) {
+				pmh.occlusionMap( mask, lr, 0.5f );
+				pmh.normalDepth( normaldepth, lr );
+				pmh.smooth( lr, normaldepth, &mask, theta * 20.0f + 5.0f, 100 );
+			}
+
+			if( iter >= 4 )
+				theta = Math::smoothstep<float>( ( ( iter - 4.0f ) / ( ( float ) iterations - 4.0f ) ) ) * 1.0f;
+		}
+
+		pmh.consistency( normaldepth, 1, 1.0f, 5.0f );
+		dmap.reallocate( left.width(), left.height(), IFormat::GRAY_FLOAT );
+		pmh.depthMap( dmap, normaldepth, 1.0f );
+	}
 }
@@ -26,21 +26,31 @@
 #define CVT_PMHUBERSTEREO_H
 
 #include <cvt/gfx/Image.h>
+#include <cvt/gfx/IFilter.h>
 #include <cvt/cl/CLKernel.h>
 
 #include <cvt/gfx/PDROF.h>
 #include <cvt/gfx/PDROFInpaint.h>
 
 namespace cvt {
+	/* PatchMatch stereo with slanted support windows coupled to a Huber-ROF smoothed normal/depth field.
+	   The OpenCL version expects CL images, the CPU version accepts images of any memory type and keeps
+	   up to viewsamples propagated states of the other view per pixel */
 	class PMHuberStereo {
 		public:
 			PMHuberStereo();
 			~PMHuberStereo();
 
-			void depthMap( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples, float dscale = -1.0f, Image* normalmap = NULL );
-			void depthMapInpaint( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples );
+			void depthMap( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples, float dscale = -1.0f, Image* normalmap = NULL, IFilterType type = IFILTER_OPENCL );
+			void depthMapInpaint( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples, IFilterType type = IFILTER_OPENCL );
 
 		private:
+			void initCL();
+			void depthMapCL( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, float dscale, Image* normalmap );
+			void depthMapInpaintCL( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations );
+			void depthMapCPU( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples, float dscale, Image* normalmap );
+			void depthMapInpaintCPU( Image& dmap, const Image& left, const Image& right, size_t patchsize, float depthmax, size_t iterations, size_t viewsamples );
+
 			CLKernel _clpmh_init;
 			CLKernel _clpmh_propagate;
 			CLKernel _clpmh_depthmap;
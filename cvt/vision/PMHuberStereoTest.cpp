@@ -0,0 +1,147 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/PMHuberStereo.h>
+#include <cvt/gfx/Image.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/math/Math.h>
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+namespace cvt {
+
+	/* coloured texture, shifted horizontally by dx */
+	static void _pmhTexture( Image& img, float dx )
+	{
+		img.reallocate( 64, 48, IFormat::RGBA_FLOAT );
+		IMapScoped<float> map( img );
+		for( size_t y = 0; y < img.height(); y++ ) {
+			float* ptr = map.ptr();
+			for( size_t x = 0; x < img.width(); x++ ) {
+				float fx = ( float ) x - dx;
+				float fy = ( float ) y;
+				*ptr++ = 0.5f + 0.25f * Math::sin( 0.61f * fx + 0.23f * fy ) + 0.2f * Math::sin( 0.17f * fx - 0.47f * fy + 1.0f );
+				*ptr++ = 0.5f + 0.3f * Math::sin( -0.39f * fx + 0.53f * fy + 0.5f ) + 0.15f * Math::cos( 0.83f * fx );
+				*ptr++ = 0.5f + 0.35f * Math::cos( 0.29f * fx + 0.71f * fy + 2.0f );
+				*ptr++ = 1.0f;
+			}
+			map++;
+		}
+	}
+
+	static bool _testCostLine()
+	{
+		const size_t width = 37;
+		const size_t n = 9;
+		float src[ 8 * width ], ref[ 8 * n ], weights[ n ];
+		const float trunc[ 8 ] = { 0.04f, 0.04f, 0.04f, 0.01f, 0.01f, 0.01f, 0.01f, 0.0f };
+		const float scale[ 8 ] = { 0.05f, 0.05f, 0.05f, 0.95f, 0.95f, 0.95f, 0.95f, 0.0f };
+
+		srand( 17 );
+		for( size_t i = 0; i < 8 * width; i++ )
+			src[ i ] = Math::rand( 0.0f, 1.0f );
+		for( size_t i = 0; i < 8 * n; i++ )
+			ref[ i ] = Math::rand( 0.0f, 1.0f );
+		for( size_t i = 0; i < n; i++ )
+			weights[ i ] = Math::rand( 0.0f, 1.0f );
+
+		/* start positions inside, partially outside left and right of the row */
+		const float xs[ 4 ][ 2 ] = { { 3.3f, 1.02f }, { -4.6f, 0.97f }, { 30.2f, 1.1f }, { 12.0f, -0.8f } };
+		SIMD* base = SIMD::get( SIMD_BASE );
+		bool ret = true;
+		for( int t = SIMD_BASE; t <= SIMD::bestSupportedType(); t++ ) {
+			SIMD* simd = SIMD::get( ( SIMDType ) t );
+			for( size_t k = 0; k < 4; k++ ) {
+				float w1 = 0.5f, w2 = 0.5f;
+				float c1 = base->costTruncatedL1Line8f( w1, ref, weights, src, width, xs[ k ][ 0 ], xs[ k ][ 1 ], trunc, scale, n );
+				float c2 = simd->costTruncatedL1Line8f( w2, ref, weights, src, width, xs[ k ][ 0 ], xs[ k ][ 1 ], trunc, scale, n );
+				ret &= Math::abs( c1 - c2 ) < 1e-5f && Math::abs( w1 - w2 ) < 1e-5f;
+			}
+			if( simd != base )
+				delete simd;
+		}
+		delete base;
+		return ret;
+	}
+
+	/* median of the absolute disparity error, a border of 8 pixels is ignored */
+	static float _pmhDisparityError( const Image& disp, float d )
+	{
+		IMapScoped<const float> map( disp );
+		std::vector<float> err;
+		for( size_t y = 0; y < disp.height(); y++ ) {
+			const float* ptr = map.ptr();
+			if( y >= 8 && y + 8 < disp.height() ) {
+				for( size_t x = 8; x + 8 < disp.width(); x++ )
+					err.push_back( Math::abs( ptr[ x ] - d ) );
+			}
+			map++;
+		}
+		std::nth_element( err.begin(), err.begin() + err.size() / 2, err.end() );
+		return err[ err.size() / 2 ];
+	}
+
+	struct PMHuberDepthMap {
+		PMHuberDepthMap( PMHuberStereo& p, const Image& l, const Image& r ) : pmh( p ), left( l ), right( r ) {}
+		void operator()( Image& disp ) const { pmh.depthMap( disp, left, right, 4, 12.0f, 6, 4, 1.0f, NULL, IFILTER_CPU ); }
+		PMHuberStereo&	pmh;
+		const Image&	left;
+		const Image&	right;
+	};
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( PMHuberStereo )
+	bool result = true;
+	bool b;
+	Image left, right, disp;
+
+	b = _testCostLine();
+	CVTTEST_PRINT( "costTruncatedL1Line8f", b );
+	result &= b;
+
+	/* the right image sees the texture 4 pixels further left */
+	_pmhTexture( left, 0.0f );
+	_pmhTexture( right, -4.0f );
+
+	PMHuberStereo pmh;
+	pmh.depthMap( disp, left, right, 4, 12.0f, 6, 4, 1.0f, NULL, IFILTER_CPU );
+	b = disp.width() == left.width() && disp.height() == left.height() && disp.format() == IFormat::GRAY_FLOAT;
+	b &= _pmhDisparityError( disp, 4.0f ) < 0.5f;
+	CVTTEST_PRINT( "CPU depth map of a shifted image", b );
+	result &= b;
+
+	b = testThreadInvariance<Image>( PMHuberDepthMap( pmh, left, right ), testImagesEqual );
+	CVTTEST_PRINT( "CPU depth map independent of the number of threads", b );
+	result &= b;
+
+	return result;
+END_CVTTEST
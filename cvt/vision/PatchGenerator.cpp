@@ -84,22 +84,22 @@ namespace cvt
 		int32_t x0, y0, x1, y1;	
 		uint32_t numChannels = outputPatch.channels();
 		
-		currentP[ 1 ] = -(float)_patchSize / 2.0f;	
+		currentP[ 1 ] = -( float )( _patchSize >> 1 );	
 		float fracX, fracY;
 		double pixelNoise;
 		int32_t tmp0, tmp1, tmp;
 		for( uint32_t i = 0; i < _patchSize; i++ ){
-			currentP[ 0 ] = -(float)_patchSize / 2.0f;
+			currentP[ 0 ] = -( float )( _patchSize >> 1 );
 			for( uint32_t j = 0; j < _patchSize; j++ ){	
 				pPrime = _affine * currentP;
 												
-				x0 = int32_t( pPrime[ 0 ] + float( patchCenter[ 0 ] ) );
-				y0 = int32_t( pPrime[ 1 ] + float( patchCenter[ 1 ] ) );
-				x1 = x0++;
-				y1 = y0++;
-				fracX = pPrime[ 0 ] - Math::floor( pPrime[ 0 ] );
-				fracY = pPrime[ 1 ] - Math::floor( pPrime[ 1 ] );
-				
+				float px = pPrime[ 0 ] + patchCenter[ 0 ];
+				float py = pPrime[ 1 ] + patchCenter[ 1 ];
+				x0 = ( int32_t ) Math::floor( px );
+				y0 = ( int32_t ) Math::floor( py );
+				fracX = px - x0;
+				fracY = py - y0;
+
 				if( x0 < 0 ||
 				    y0 < 0 ||
 				    ( uint32_t )x0 >= inputImage.width() ||
@@ -107,17 +107,14 @@ namespace cvt
 					for( size_t c = 0; c < numChannels; c++ )
 						out[ numChannels * j  + c ] = 0;
 				} else {
+					/* clamp the bilinear neighbours to the image */
+					x1 = Math::min<int32_t>( x0 + 1, inputImage.width() - 1 );
+					y1 = Math::min<int32_t>( y0 + 1, inputImage.height() - 1 );
 					pixelNoise = Math::clamp( _rng.gaussian( _whiteNoiseSigma ), -20.0, 20.0 );
 					
 					for( size_t c = 0; c < numChannels; c++ ){						
-						if( ( uint32_t )x1 < inputImage.width() )
-							tmp0 = Math::mix( in[ y0 * inStride + x0 * numChannels + c ], in[ y0 * inStride + x1 * numChannels + c ], fracX );
-						else
-							tmp0 = in[ y0 * inStride + x0 * numChannels + c ];
-						if( ( uint32_t )y1 < inputImage.height() )
-							tmp1 = Math::mix( in[ y1 * inStride + x0 * numChannels + c ], in[ y1 * inStride + x1 * numChannels + c ], fracX );
-						else
-							tmp1 = in[ y1 * inStride + x0 * numChannels + c ];
+						tmp0 = Math::mix( in[ y0 * inStride + x0 * numChannels + c ], in[ y0 * inStride + x1 * numChannels + c ], fracX );
+						tmp1 = Math::mix( in[ y1 * inStride + x0 * numChannels + c ], in[ y1 * inStride + x1 * numChannels + c ], fracX );
 						tmp = Math::mix( tmp0, tmp1, fracY ) + pixelNoise;
 						
 						out[ numChannels * j + c ] = ( uint8_t )Math::clamp( tmp, 0, 255 );
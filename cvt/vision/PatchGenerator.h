@@ -42,6 +42,9 @@ namespace cvt
 			
 			/* generate the next patch */
 			void next( Image & outputPatch, const cvt::Image & inputImage, const Vector2f & patchCenter );			
+
+			/* restart the random sequence, e.g. for reproducible patches on parallel workers */
+			void setSeed( uint64_t seed ) { _rng = RNG( seed ); }
 			
 		private:
 			uint32_t			_patchSize;
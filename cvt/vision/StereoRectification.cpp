@@ -31,26 +31,36 @@ namespace cvt {
 											  const CameraCalibration& right )
 	{
 		StereoCameraCalibration scalib( left, right );
-		size_t w = 0;
-		size_t h = 0;
-		//_leftWarp.re
+		size_t w = left.width();
+		size_t h = left.height();
+		_leftWarp.reallocate( w, h, IFormat::GRAYALPHA_FLOAT );
+		_rightWarp.reallocate( right.width(), right.height(), IFormat::GRAYALPHA_FLOAT );
 		scalib.undistortRectify( _rectifiedCalibration, _leftWarp, _rightWarp, w, h );
+		_leftRemap.update( _leftWarp );
+		_rightRemap.update( _rightWarp );
 	}
 
 	StereoRectification::StereoRectification( const StereoRectification& other ):
 		_rectifiedCalibration( other._rectifiedCalibration ),
 		_leftWarp( other._leftWarp ),
-		_rightWarp( other._rightWarp )
+		_rightWarp( other._rightWarp ),
+		_leftRemap( other._leftRemap ),
+		_rightRemap( other._rightRemap )
 	{}
 
 	void StereoRectification::undistortLeft( Image& out, const Image& in ) const
 	{
-		IWarp::apply( out, in, _leftWarp );
+		_leftRemap.apply( out, in );
 	}
 
 	void StereoRectification::undistortRight( Image& out, const Image& in ) const
 	{
-		IWarp::apply( out, in, _rightWarp );
+		_rightRemap.apply( out, in );
+	}
+
+	void StereoRectification::undistort( Image& outLeft, Image& outRight, const Image& inLeft, const Image& inRight ) const
+	{
+		IRemap::apply( outLeft, inLeft, _leftRemap, outRight, inRight, _rightRemap );
 	}
 
 }
@@ -26,6 +26,7 @@
 #define CVT_STEREO_RECTIFICATION_H
 
 #include <cvt/vision/StereoCameraCalibration.h>
+#include <cvt/gfx/IRemap.h>
 
 namespace cvt {
 
@@ -36,11 +37,21 @@ namespace cvt {
 
 			void undistortLeft( Image& out, const Image& in ) const;
 			void undistortRight( Image& out, const Image& in ) const;
+			/* rectify both images of the stereo pair in one parallel pass */
+			void undistort( Image& outLeft, Image& outRight, const Image& inLeft, const Image& inRight ) const;
+
+			const Image& leftWarp() const { return _leftWarp; }
+			const Image& rightWarp() const { return _rightWarp; }
+			const IRemap& leftRemap() const { return _leftRemap; }
+			const IRemap& rightRemap() const { return _rightRemap; }
+			const StereoCameraCalibration& rectifiedCalibration() const { return _rectifiedCalibration; }
 
 		private:
 			StereoCameraCalibration _rectifiedCalibration;
 			Image	_leftWarp;
 			Image	_rightWarp;
+			IRemap	_leftRemap;
+			IRemap	_rightRemap;
 	};
 
 }
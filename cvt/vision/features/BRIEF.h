@@ -32,6 +32,7 @@
 #include <cvt/vision/features/FeatureDescriptor.h>
 #include <cvt/vision/features/FeatureDescriptorExtractor.h>
 #include <cvt/vision/features/MatchBruteForce.h>
+#include <cvt/util/ParallelFor.h>
 
 namespace cvt {
 
@@ -104,11 +105,42 @@ namespace cvt {
             void extractInternal( const Image& img, const FeatureSet& features );
 
             template <class ImgT>
-            void descriptor( Descriptor& feature, const Vector2f& pt, const IMapScoped<ImgT>& map );
+            void descriptor( Descriptor& feature, const Vector2f& pt, const IMapScoped<ImgT>& map ) const;
+
+            /* computes the descriptors of the features [ begin, end ) after start in parallel chunks */
+            template <class ImgT>
+            class ExtractBody {
+                public:
+                    ExtractBody( const BRIEF<N>& brief, Descriptor* desc, const std::vector<const IMapScoped<ImgT>*>& maps, const std::vector<float>& scales ) :
+                        _brief( brief ), _desc( desc ), _maps( maps ), _scales( scales )
+                    {
+                    }
+
+                    void operator()( size_t begin, size_t end ) const
+                    {
+                        for( size_t i = begin; i < end; i++ ) {
+                            size_t o = _maps.size() > 1 ? _desc[ i ].octave : 0;
+                            _brief.descriptor( _desc[ i ], _desc[ i ].pt * _scales[ o ], *_maps[ o ] );
+                        }
+                    }
+
+                private:
+                    const BRIEF<N>&								_brief;
+                    Descriptor*									_desc;
+                    const std::vector<const IMapScoped<ImgT>*>&	_maps;
+                    const std::vector<float>&					_scales;
+            };
+
+            template <class ImgT>
+            void extractParallel( const std::vector<const IMapScoped<ImgT>*>& maps, const std::vector<float>& scales, const FeatureSet& features );
 
 			const size_t			_boxradius;
 			std::vector<Descriptor> _features;
 
+			/* box filtered images reused between the extract calls */
+			Image					_boxImage;
+			ImagePyramid			_boxPyr;
+
 	};
 
 #include <cvt/vision/features/BRIEFPattern.h>
@@ -119,14 +151,16 @@ namespace cvt {
 
 	template<size_t N>
 	inline BRIEF<N>::BRIEF( size_t boxradius ) :
-		_boxradius( boxradius )
+		_boxradius( boxradius ),
+		_boxPyr( 0, 0.5f )
 	{
 	}
 
 	template<size_t N>
 	inline BRIEF<N>::BRIEF( const BRIEF<N>& other ) :
 		_boxradius( other._boxradius ),
-		_features( other._features )
+		_features( other._features ),
+		_boxPyr( 0, 0.5f )
 	{
 	}
 
@@ -195,26 +229,19 @@ namespace cvt {
     template<class ImgT>
     inline void BRIEF<N>::extractInternal( const ImagePyramid& pyr, const FeatureSet& features )
     {
-        ImagePyramid boxPyr( pyr.octaves(), pyr.scaleFactor() );
-        pyr.boxfilter( boxPyr, _boxradius );
+        if( _boxPyr.octaves() != pyr.octaves() || _boxPyr.scaleFactor() != pyr.scaleFactor() )
+            _boxPyr = ImagePyramid( pyr.octaves(), pyr.scaleFactor() );
+        pyr.boxfilter( _boxPyr, _boxradius );
 
         size_t octaves = pyr.octaves();
-        std::vector<IMapScoped<ImgT>*> maps;
+        std::vector<const IMapScoped<ImgT>*> maps;
         std::vector<float> scales;
         for( size_t i = 0; i < octaves; ++i ){
-            maps.push_back( new IMapScoped<ImgT>( boxPyr[ i ] ) );
-            scales.push_back( Math::pow( boxPyr.scaleFactor(), ( float )i ) );
+            maps.push_back( new IMapScoped<ImgT>( _boxPyr[ i ] ) );
+            scales.push_back( Math::pow( _boxPyr.scaleFactor(), ( float )i ) );
         }
 
-        size_t iend = features.size();
-        Vector2f vs;
-        for( size_t i = 0; i < iend; ++i ) {
-            _features.push_back( Descriptor( features[ i ] ) );
-            Descriptor& desc = _features.back();
-            size_t o = desc.octave;
-            vs = desc.pt * scales[ o ];
-            descriptor( desc, vs, *maps[ o ] );
-        }
+        extractParallel<ImgT>( maps, scales, features );
 
         for( size_t i = 0; i < octaves; ++i ){
             delete maps[ i ];
@@ -225,20 +252,34 @@ namespace cvt {
     template<class ImgT>
     inline void BRIEF<N>::extractInternal( const Image& img, const FeatureSet& features )
 	{
-		Image boximg;
-		img.boxfilter( boximg, _boxradius );
-
-        IMapScoped<ImgT> map( boximg );
-		size_t iend = features.size();
-		for( size_t i = 0; i < iend; ++i ) {
-			_features.push_back( Descriptor( features[ i ] ) );
-            descriptor( _features.back(), features[ i ].pt, map );
-		}
+		img.boxfilter( _boxImage, _boxradius );
+
+        IMapScoped<ImgT> map( _boxImage );
+        std::vector<const IMapScoped<ImgT>*> maps( 1, &map );
+        std::vector<float> scales( 1, 1.0f );
+        extractParallel<ImgT>( maps, scales, features );
 	}
 
     template<size_t N>
     template<class ImgT>
-    inline void BRIEF<N>::descriptor( Descriptor& feature, const Vector2f& pt, const IMapScoped<ImgT>& map )
+    inline void BRIEF<N>::extractParallel( const std::vector<const IMapScoped<ImgT>*>& maps, const std::vector<float>& scales, const FeatureSet& features )
+    {
+        size_t start = _features.size();
+        size_t iend = features.size();
+        if( !iend )
+            return;
+
+        _features.reserve( start + iend );
+        for( size_t i = 0; i < iend; ++i )
+            _features.push_back( Descriptor( features[ i ] ) );
+
+        ExtractBody<ImgT> body( *this, &_features[ start ], maps, scales );
+        ParallelFor::run( body, 0, iend, 64 );
+    }
+
+    template<size_t N>
+    template<class ImgT>
+    inline void BRIEF<N>::descriptor( Descriptor& feature, const Vector2f& pt, const IMapScoped<ImgT>& map ) const
     {
         int px = ( int ) pt.x;
         int py = ( int ) pt.y;
@@ -24,6 +24,9 @@
 
 #include <cvt/vision/features/FAST.h>
 #include <cvt/gfx/IScaleFilter.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/SIMD.h>
 
 namespace cvt
 {
@@ -399,73 +402,44 @@ namespace cvt
 	#undef CHECK_BARRIER
 	}
 
-	inline void FAST::detect10( const Image& img, uint8_t threshold, FeatureSetWrapper& features, size_t border )
+	void FAST::detectSegment( const Image& img, size_t arc, uint8_t threshold, FeatureSetWrapper& features, size_t border )
 	{
-		size_t stride;
-		const uint8_t * im = img.map( &stride );
+		if( img.width() <= 2 * border || img.height() <= 2 * border )
+			return;
 
-		size_t x, y;
-		size_t xsize = img.width() - border;
-		size_t ysize = img.height() - border;
+		IMapScoped<const uint8_t> map( img );
+		const size_t stride = map.stride();
+		const size_t n = img.width() - 2 * border;
 
 		int offsets[ 16 ];
 		make_offsets( offsets, stride );
 
-		for( y=border; y < ysize; y++ ){
-			for( x=border; x < xsize; x++ ){
-				const uint8_t* p = im + y*stride + x;
-
-				if( isCorner10( p, offsets, threshold ) )
-					features( x, y, score10Pixel( p, offsets, threshold ) );
+		/* the kernel returns score + 1 for corners and 0 otherwise */
+		SIMD* simd = SIMD::instance();
+		ScopedBuffer<uint8_t, true> buffer( n );
+		uint8_t* strength = buffer.ptr();
+		for( size_t y = border; y < img.height() - border; y++ ) {
+			simd->astStrength_u8( strength, map.ptr() + y * stride + border, offsets, 16, arc, threshold, n );
+			for( size_t i = 0; i < n; i++ ) {
+				if( strength[ i ] )
+					features( i + border, y, strength[ i ] - 1 );
 			}
 		}
-		img.unmap( im );
 	}
 
-	inline void FAST::detect11( const Image& img, uint8_t threshold, FeatureSetWrapper& features, size_t border )
+	inline void FAST::detect10( const Image& img, uint8_t threshold, FeatureSetWrapper& features, size_t border )
 	{
-		size_t stride;
-		const uint8_t * im = img.map( &stride );
-
-		size_t x, y;
-		size_t xsize = img.width() - border;
-		size_t ysize = img.height() - border;
-
-		int offsets[ 16 ];
-		make_offsets( offsets, stride );
-
-		for( y=border; y < ysize; y++ ){
-			for( x=border; x < xsize; x++ ){
-				const uint8_t* p = im + y*stride + x;
+		detectSegment( img, 10, threshold, features, border );
+	}
 
-				if( isCorner11( p, offsets, threshold ) )
-					features( x, y, score11Pixel( p, offsets, threshold ) );
-			}
-		}
-		img.unmap( im );
+	inline void FAST::detect11( const Image& img, uint8_t threshold, FeatureSetWrapper& features, size_t border )
+	{
+		detectSegment( img, 11, threshold, features, border );
 	}
 
 	inline void FAST::detect12( const Image& img, uint8_t threshold, FeatureSetWrapper& features, size_t border )
 	{
-		size_t stride;
-		const uint8_t * im = img.map( &stride );
-
-		size_t x, y;
-		size_t xsize = img.width() - border;
-		size_t ysize = img.height() - border;
-
-		int offsets[ 16 ];
-		make_offsets( offsets, stride );
-
-		for( y=border; y < ysize; y++ ){
-			for( x=border; x < xsize; x++ ){
-				const uint8_t* p = im + y*stride + x;
-
-				if( isCorner12( p, offsets, threshold ) )
-					features( x, y, score12Pixel( p, offsets, threshold ) );
-			}
-		}
-		img.unmap( im );
+		detectSegment( img, 12, threshold, features, border );
 	}
 
 }
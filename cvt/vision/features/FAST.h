@@ -70,6 +70,8 @@ namespace cvt
 			static void detect10( const Image& img, uint8_t threshold, FeatureSetWrapper& features, size_t border = 3 );
 			static void detect11( const Image& img, uint8_t threshold, FeatureSetWrapper& features, size_t border = 3 );
 			static void detect12( const Image& img, uint8_t threshold, FeatureSetWrapper& features, size_t border = 3 );
+			/* vectorised segment test and score of any arc length on the 16 pixel circle */
+			static void detectSegment( const Image& img, size_t arc, uint8_t threshold, FeatureSetWrapper& features, size_t border = 3 );
 
             static int score9Pixel( const uint8_t* p, const int * offsets, uint8_t threshold );
             static int score10Pixel( const uint8_t* p, const int * offsets, uint8_t threshold );
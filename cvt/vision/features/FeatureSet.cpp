@@ -51,7 +51,7 @@ namespace cvt {
 	void FeatureSet::filterBest( size_t n, bool sort )
 	{
 		if( sort ) {
-			CmpScore cmp;
+			CmpBest cmp;
 			std::sort( _features.begin(), _features.end(), cmp );
 		}
 		if( _features.size() > n )
@@ -90,6 +90,22 @@ namespace cvt {
 					}
 			};
 
+			/* strict weak ordering with the best ( highest score ) feature first, ties broken by position and octave */
+			class CmpBest
+			{
+				public:
+					bool operator()( const Feature& f1, const Feature& f2 ) const
+					{
+						if( f1.score != f2.score )
+							return f1.score > f2.score;
+						if( f1.pt.y != f2.pt.y )
+							return f1.pt.y < f2.pt.y;
+						if( f1.pt.x != f2.pt.x )
+							return f1.pt.x < f2.pt.x;
+						return f1.octave < f2.octave;
+					}
+			};
+
 			class CmpPos
 			{
 				public:
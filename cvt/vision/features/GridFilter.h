@@ -96,9 +96,10 @@ namespace cvt {
                 inline void operator() ( const Feature* f ) { featureSet.add( *f ); }
             };
 
+            /* best features first */
             struct CmpScore {
                 bool operator()( const Feature* f1, const Feature* f2 ) {
-                    return f1->score < f2->score;
+                    return FeatureSet::CmpBest()( *f1, *f2 );
                 }
             };
 
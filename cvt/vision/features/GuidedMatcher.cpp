@@ -0,0 +1,371 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/features/GuidedMatcher.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/SIMD.h>
+#include <cvt/util/Exception.h>
+#include <cvt/math/Math.h>
+
+namespace cvt
+{
+	class GuidedMatcher::MatchBody
+	{
+		public:
+			MatchBody( const GuidedMatcher& matcher, const Search& search, MatchingIndices* result ) :
+				_matcher( matcher ), _search( search ), _result( result )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				std::vector<uint32_t> dist( _matcher._maxRow + 1 );
+				for( size_t i = begin; i < end; i++ )
+					_matcher.matchQuery( _result[ i ], _search, i, &dist[ 0 ] );
+			}
+
+		private:
+			const GuidedMatcher&	_matcher;
+			const Search&			_search;
+			MatchingIndices*		_result;
+	};
+
+	GuidedMatcher::GuidedMatcher( float cellSize, const Params& params ) :
+		_cellSize( Math::max( cellSize, 1.0f ) ),
+		_params( params ),
+		_cols( 0 ),
+		_rows( 0 ),
+		_octaves( 0 ),
+		_minX( 0.0f ),
+		_minY( 0.0f ),
+		_len( 0 ),
+		_maxRow( 0 )
+	{
+	}
+
+	GuidedMatcher::~GuidedMatcher()
+	{
+	}
+
+	void GuidedMatcher::build( const FeatureDescriptorExtractor& targets )
+	{
+		std::vector<const FeatureDescriptor*> ptrs( targets.size() );
+		for( size_t i = 0; i < ptrs.size(); i++ )
+			ptrs[ i ] = &targets[ i ];
+		build( ptrs );
+	}
+
+	void GuidedMatcher::build( const std::vector<const FeatureDescriptor*>& targets )
+	{
+		const size_t n = targets.size();
+		_targets = targets;
+		_cols = _rows = _octaves = 0;
+		_maxRow = 0;
+		_len = 0;
+		_cellStart.clear();
+		if( !n )
+			return;
+
+		_len = targets[ 0 ]->length();
+		float maxX, maxY;
+		int maxOctave = 0;
+		_minX = maxX = targets[ 0 ]->pt.x;
+		_minY = maxY = targets[ 0 ]->pt.y;
+		for( size_t i = 0; i < n; i++ ) {
+			const FeatureDescriptor& d = *targets[ i ];
+			if( d.compareType() != FEATUREDESC_CMP_HAMMING || d.length() != _len )
+				throw CVTException( "GuidedMatcher: targets need binary descriptors of equal length" );
+			_minX = Math::min( _minX, d.pt.x );
+			_minY = Math::min( _minY, d.pt.y );
+			maxX = Math::max( maxX, d.pt.x );
+			maxY = Math::max( maxY, d.pt.y );
+			maxOctave = Math::max( maxOctave, d.octave );
+		}
+
+		_cols = ( int ) ( ( maxX - _minX ) / _cellSize ) + 1;
+		_rows = ( int ) ( ( maxY - _minY ) / _cellSize ) + 1;
+		_octaves = maxOctave + 1;
+
+		/* counting sort by octave and cell */
+		std::vector<uint32_t> cell( n );
+		_cellStart.assign( _cols * _rows * _octaves + 1, 0 );
+		for( size_t i = 0; i < n; i++ ) {
+			const FeatureDescriptor& d = *targets[ i ];
+			int cx = ( int ) ( ( d.pt.x - _minX ) / _cellSize );
+			int cy = ( int ) ( ( d.pt.y - _minY ) / _cellSize );
+			cell[ i ] = ( Math::max( d.octave, 0 ) * _rows + cy ) * _cols + cx;
+			_cellStart[ cell[ i ] + 1 ]++;
+		}
+
+		for( size_t c = 1; c < _cellStart.size(); c++ )
+			_cellStart[ c ] += _cellStart[ c - 1 ];
+
+		/* visitCells scores a run of cells within one row at once */
+		for( size_t r = 0; r < ( size_t ) ( _rows * _octaves ); r++ )
+			_maxRow = Math::max<size_t>( _maxRow, _cellStart[ ( r + 1 ) * _cols ] - _cellStart[ r * _cols ] );
+
+		_index.resize( n );
+		_desc.resize( n * _len );
+		_pos.resize( n );
+		_angle.resize( n );
+		std::vector<uint32_t> fill( _cellStart.begin(), _cellStart.end() - 1 );
+		for( size_t i = 0; i < n; i++ ) {
+			const FeatureDescriptor& d = *targets[ i ];
+			size_t t = fill[ cell[ i ] ]++;
+			_index[ t ] = i;
+			_pos[ t ] = d.pt;
+			_angle[ t ] = d.angle;
+			SIMD::instance()->Memcpy( &_desc[ t * _len ], d.ptr(), _len );
+		}
+	}
+
+	void GuidedMatcher::matchInWindow( std::vector<MatchingIndices>& matches,
+									   const std::vector<FeatureDescriptor*>& queries,
+									   float radius ) const
+	{
+		Search search;
+		search.type = SEARCH_WINDOW;
+		search.queries = queries.size() ? ( const FeatureDescriptor* const* ) &queries[ 0 ] : 0;
+		search.radii = 0;
+		search.radius = radius;
+		match( matches, search, queries.size() );
+	}
+
+	void GuidedMatcher::matchInWindow( std::vector<MatchingIndices>& matches,
+									   const std::vector<FeatureDescriptor*>& queries,
+									   const std::vector<float>& radii ) const
+	{
+		if( radii.size() != queries.size() )
+			throw CVTException( "GuidedMatcher: number of radii and queries differ" );
+
+		Search search;
+		search.type = SEARCH_WINDOW;
+		search.queries = queries.size() ? ( const FeatureDescriptor* const* ) &queries[ 0 ] : 0;
+		search.radii = radii.size() ? &radii[ 0 ] : 0;
+		search.radius = 0.0f;
+		match( matches, search, queries.size() );
+	}
+
+	void GuidedMatcher::scanLineMatch( std::vector<FeatureMatch>& matches,
+									   const std::vector<const FeatureDescriptor*>& queries,
+									   float minDisp,
+									   float maxDisp,
+									   float maxLineDist ) const
+	{
+		Search search;
+		search.type = SEARCH_SCANLINE;
+		search.queries = queries.size() ? &queries[ 0 ] : 0;
+		search.minDisp = minDisp;
+		search.maxDisp = maxDisp;
+		search.lineDist = maxLineDist;
+
+		std::vector<MatchingIndices> indices;
+		match( indices, search, queries.size() );
+
+		matches.reserve( matches.size() + indices.size() );
+		FeatureMatch m;
+		for( size_t i = 0; i < indices.size(); i++ ) {
+			m.feature0 = queries[ indices[ i ].srcIdx ];
+			m.feature1 = _targets[ indices[ i ].dstIdx ];
+			m.distance = indices[ i ].distance;
+			matches.push_back( m );
+		}
+	}
+
+	void GuidedMatcher::matchEpipolar( std::vector<MatchingIndices>& matches,
+									   const std::vector<const FeatureDescriptor*>& queries,
+									   const std::vector<Vector3f>& lines,
+									   float maxLineDist ) const
+	{
+		if( lines.size() != queries.size() )
+			throw CVTException( "GuidedMatcher: number of lines and queries differ" );
+
+		Search search;
+		search.type = SEARCH_EPIPOLAR;
+		search.queries = queries.size() ? &queries[ 0 ] : 0;
+		search.lines = lines.size() ? &lines[ 0 ] : 0;
+		search.lineDist = maxLineDist;
+		match( matches, search, queries.size() );
+	}
+
+	void GuidedMatcher::match( std::vector<MatchingIndices>& matches, const Search& search, size_t n ) const
+	{
+		for( size_t i = 0; i < n; i++ ) {
+			if( search.queries[ i ]->compareType() != FEATUREDESC_CMP_HAMMING || search.queries[ i ]->length() != _len )
+				throw CVTException( "GuidedMatcher: query descriptors do not match the targets" );
+		}
+
+		if( !n || _targets.empty() )
+			return;
+
+		std::vector<MatchingIndices> result( n );
+		MatchBody body( *this, search, &result[ 0 ] );
+		ParallelFor::run( body, 0, n, 32 );
+
+		matches.reserve( matches.size() + n );
+		for( size_t i = 0; i < n; i++ ) {
+			if( result[ i ].srcIdx == i )
+				matches.push_back( result[ i ] );
+		}
+	}
+
+	void GuidedMatcher::matchQuery( MatchingIndices& m, const Search& search, size_t idx, uint32_t* dist ) const
+	{
+		const FeatureDescriptor& q = *search.queries[ idx ];
+		float second = Math::MAXF;
+
+		/* srcIdx is only set for accepted matches */
+		m.srcIdx = ( size_t ) -1;
+		m.dstIdx = 0;
+		m.distance = _params.maxDistance;
+
+		switch( search.type ) {
+			case SEARCH_WINDOW:
+				{
+					float r = search.radii ? search.radii[ idx ] : search.radius;
+					visitCells( m, second, q, search, idx, q.pt.x - r, q.pt.x + r, q.pt.y - r, q.pt.y + r, dist );
+				}
+				break;
+			case SEARCH_SCANLINE:
+				visitCells( m, second, q, search, idx, q.pt.x - search.maxDisp, q.pt.x - search.minDisp,
+						    q.pt.y - search.lineDist, q.pt.y + search.lineDist, dist );
+				break;
+			case SEARCH_EPIPOLAR:
+				{
+					/* walk along the line in cell steps of the dominant direction */
+					const Vector3f& l = search.lines[ idx ];
+					float norm = Math::sqrt( Math::sqr( l.x ) + Math::sqr( l.y ) );
+					if( norm == 0.0f )
+						break;
+					if( Math::abs( l.y ) >= Math::abs( l.x ) ) {
+						float ext = search.lineDist * norm / Math::abs( l.y );
+						for( int cx = 0; cx < _cols; cx++ ) {
+							float x0 = _minX + cx * _cellSize;
+							float x1 = x0 + _cellSize;
+							float y0 = -( l.x * x0 + l.z ) / l.y;
+							float y1 = -( l.x * x1 + l.z ) / l.y;
+							visitCells( m, second, q, search, idx, x0 + 0.5f * _cellSize, x0 + 0.5f * _cellSize,
+										Math::min( y0, y1 ) - ext, Math::max( y0, y1 ) + ext, dist );
+						}
+					} else {
+						float ext = search.lineDist * norm / Math::abs( l.x );
+						for( int cy = 0; cy < _rows; cy++ ) {
+							float y0 = _minY + cy * _cellSize;
+							float y1 = y0 + _cellSize;
+							float x0 = -( l.y * y0 + l.z ) / l.x;
+							float x1 = -( l.y * y1 + l.z ) / l.x;
+							visitCells( m, second, q, search, idx, Math::min( x0, x1 ) - ext, Math::max( x0, x1 ) + ext,
+										y0 + 0.5f * _cellSize, y0 + 0.5f * _cellSize, dist );
+						}
+					}
+				}
+				break;
+		}
+
+		if( m.srcIdx != ( size_t ) -1 && _params.ratio < 1.0f && m.distance >= _params.ratio * second )
+			m.srcIdx = ( size_t ) -1;
+	}
+
+	void GuidedMatcher::visitCells( MatchingIndices& m, float& second, const FeatureDescriptor& q, const Search& search,
+									size_t idx, float x0, float x1, float y0, float y1, uint32_t* dist ) const
+	{
+		int cx0 = Math::max( ( int ) Math::floor( ( x0 - _minX ) / _cellSize ), 0 );
+		int cx1 = Math::min( ( int ) Math::floor( ( x1 - _minX ) / _cellSize ), _cols - 1 );
+		int cy0 = Math::max( ( int ) Math::floor( ( y0 - _minY ) / _cellSize ), 0 );
+		int cy1 = Math::min( ( int ) Math::floor( ( y1 - _minY ) / _cellSize ), _rows - 1 );
+		if( cx0 > cx1 || cy0 > cy1 )
+			return;
+
+		int o0 = Math::max( q.octave - ( int ) _params.maxOctaveDiff, 0 );
+		int o1 = Math::min( q.octave + ( int ) _params.maxOctaveDiff, _octaves - 1 );
+
+		SIMD* simd = SIMD::instance();
+		for( int o = o0; o <= o1; o++ ) {
+			for( int cy = cy0; cy <= cy1; cy++ ) {
+				const uint32_t* cells = &_cellStart[ ( o * _rows + cy ) * _cols ];
+				size_t start = cells[ cx0 ];
+				size_t end = cells[ cx1 + 1 ];
+				if( start == end )
+					continue;
+
+				/* the cells of a row are contiguous */
+				simd->hammingDistance1N( dist, q.ptr(), &_desc[ start * _len ], _len, end - start );
+				for( size_t t = start; t < end; t++ ) {
+					float d = dist[ t - start ];
+					if( d >= second || !accept( q, search, idx, t ) )
+						continue;
+					if( d < m.distance ) {
+						/* only accepted matches replace the second best */
+						if( m.srcIdx != ( size_t ) -1 )
+							second = m.distance;
+						m.srcIdx = idx;
+						m.dstIdx = _index[ t ];
+						m.distance = d;
+					} else {
+						second = d;
+					}
+				}
+			}
+		}
+	}
+
+	bool GuidedMatcher::accept( const FeatureDescriptor& q, const Search& search, size_t idx, size_t t ) const
+	{
+		const Vector2f& p = _pos[ t ];
+		switch( search.type ) {
+			case SEARCH_WINDOW:
+				{
+					/* square window including its border like the RowLookupTable matching */
+					float r = search.radii ? search.radii[ idx ] : search.radius;
+					if( Math::abs( p.x - q.pt.x ) > r || Math::abs( p.y - q.pt.y ) > r )
+						return false;
+				}
+				break;
+			case SEARCH_SCANLINE:
+				{
+					/* all bounds inclusive */
+					float disp = q.pt.x - p.x;
+					if( Math::abs( q.pt.y - p.y ) > search.lineDist || disp < search.minDisp || disp > search.maxDisp )
+						return false;
+				}
+				break;
+			case SEARCH_EPIPOLAR:
+				{
+					const Vector3f& l = search.lines[ idx ];
+					if( Math::abs( l.x * p.x + l.y * p.y + l.z ) > search.lineDist * Math::sqrt( Math::sqr( l.x ) + Math::sqr( l.y ) ) )
+						return false;
+				}
+				break;
+		}
+
+		if( _params.maxAngleDiff >= 0.0f ) {
+			float diff = Math::abs( q.angle - _angle[ t ] );
+			diff = fmodf( diff, Math::TWO_PI );
+			if( Math::min( diff, Math::TWO_PI - diff ) > _params.maxAngleDiff )
+				return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,158 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_GUIDEDMATCHER_H
+#define CVT_GUIDEDMATCHER_H
+
+#include <cvt/vision/features/FeatureSet.h>
+#include <cvt/vision/features/FeatureDescriptorExtractor.h>
+#include <cvt/vision/features/FeatureMatch.h>
+#include <cvt/math/Vector.h>
+
+#include <vector>
+
+namespace cvt
+{
+	/**
+	  @brief Guided matching of binary descriptors against a uniform grid hash of the target features.
+
+	  The target features are sorted into the cells of a uniform grid, separately for every octave, and their
+	  descriptors are stored contiguously in cell order. A query only visits the cells overlapping its search
+	  region ( window around a predicted position, rectified stereo band or general epipolar band ) and computes
+	  the Hamming distances to all descriptors of a cell in one batch. The costs therefore depend on the local
+	  density of the targets and not on their total number. Queries are processed in parallel, the matches are
+	  returned in query order.
+
+	  A match is accepted if the distance is below maxDistance and, if enabled, passes the ratio test against
+	  the second best candidate.
+	 */
+	class GuidedMatcher
+	{
+		public:
+			struct Params {
+				Params() :
+					maxDistance( 50.0f ),
+					ratio( 1.0f ),
+					maxOctaveDiff( 0 ),
+					maxAngleDiff( -1.0f )
+				{
+				}
+
+				/* maximum descriptor distance */
+				float	maxDistance;
+				/* the best distance has to be smaller than ratio * second best, values >= 1 disable the test */
+				float	ratio;
+				/* maximum octave difference between query and target */
+				size_t	maxOctaveDiff;
+				/* maximum orientation difference in radians, negative values disable the check */
+				float	maxAngleDiff;
+			};
+
+			GuidedMatcher( float cellSize = 16.0f, const Params& params = Params() );
+			~GuidedMatcher();
+
+			void			setParams( const Params& params )	{ _params = params; }
+			const Params&	params() const						{ return _params; }
+
+			/* the targets have to outlive the matcher or the next build */
+			void			build( const FeatureDescriptorExtractor& targets );
+			void			build( const std::vector<const FeatureDescriptor*>& targets );
+
+			size_t			size() const { return _targets.size(); }
+
+			/* targets in the square window [ x - radius, x + radius ] x [ y - radius, y + radius ] around the query
+			   position, the indices refer to the query and target sets */
+			void			matchInWindow( std::vector<MatchingIndices>& matches,
+										   const std::vector<FeatureDescriptor*>& queries,
+										   float radius ) const;
+
+			/* per query search radius */
+			void			matchInWindow( std::vector<MatchingIndices>& matches,
+										   const std::vector<FeatureDescriptor*>& queries,
+										   const std::vector<float>& radii ) const;
+
+			/* rectified stereo, targets at disparity [ minDisp, maxDisp ] within maxLineDist ( inclusive ) of the query row */
+			void			scanLineMatch( std::vector<FeatureMatch>& matches,
+										   const std::vector<const FeatureDescriptor*>& queries,
+										   float minDisp,
+										   float maxDisp,
+										   float maxLineDist ) const;
+
+			/* targets within maxLineDist of the epipolar line ( a, b, c ) of each query */
+			void			matchEpipolar( std::vector<MatchingIndices>& matches,
+										   const std::vector<const FeatureDescriptor*>& queries,
+										   const std::vector<Vector3f>& lines,
+										   float maxLineDist ) const;
+
+		private:
+			enum SearchType {
+				SEARCH_WINDOW,
+				SEARCH_SCANLINE,
+				SEARCH_EPIPOLAR
+			};
+
+			struct Search {
+				SearchType			type;
+				const FeatureDescriptor* const* queries;
+				const float*		radii;
+				float				radius;
+				float				minDisp;
+				float				maxDisp;
+				const Vector3f*		lines;
+				float				lineDist;
+			};
+
+			class MatchBody;
+
+			GuidedMatcher( const GuidedMatcher& );
+			GuidedMatcher& operator=( const GuidedMatcher& );
+
+			void			match( std::vector<MatchingIndices>& matches, const Search& search, size_t n ) const;
+			void			matchQuery( MatchingIndices& m, const Search& search, size_t idx, uint32_t* dist ) const;
+			void			visitCells( MatchingIndices& m, float& second, const FeatureDescriptor& q, const Search& search,
+										size_t idx, float x0, float x1, float y0, float y1, uint32_t* dist ) const;
+			bool			accept( const FeatureDescriptor& q, const Search& search, size_t idx, size_t t ) const;
+
+			float			_cellSize;
+			Params			_params;
+
+			int				_cols, _rows, _octaves;
+			float			_minX, _minY;
+			size_t			_len;
+			size_t			_maxRow;
+
+			std::vector<const FeatureDescriptor*>	_targets;
+
+			/* target index, descriptor, position and orientation in cell order */
+			std::vector<size_t>						_index;
+			std::vector<uint8_t>					_desc;
+			std::vector<Vector2f>					_pos;
+			std::vector<float>						_angle;
+			/* start of each cell in the cell ordered arrays, octave major */
+			std::vector<uint32_t>					_cellStart;
+	};
+}
+
+#endif
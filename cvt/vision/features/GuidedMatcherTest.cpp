@@ -0,0 +1,308 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/features/GuidedMatcher.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/math/Math.h>
+
+namespace cvt {
+
+	typedef FeatureDescriptorInternal<32, uint8_t, FEATUREDESC_CMP_HAMMING> GMDescriptor;
+
+	static void _gmRandomDescriptors( std::vector<GMDescriptor>& descs, size_t n )
+	{
+		descs.clear();
+		for( size_t i = 0; i < n; i++ ) {
+			GMDescriptor d( Math::rand( 0.0f, 640.0f ), Math::rand( 0.0f, 480.0f ), Math::rand( 0.0f, Math::TWO_PI ), i % 3, 0.0f );
+			for( size_t k = 0; k < 32; k++ )
+				d.desc[ k ] = Math::rand( 0.0f, 256.0f );
+			descs.push_back( d );
+		}
+	}
+
+	/* noisy copies of the targets moved by up to shift */
+	static void _gmQueries( std::vector<GMDescriptor>& queries, const std::vector<GMDescriptor>& targets, float shift )
+	{
+		queries = targets;
+		for( size_t i = 0; i < queries.size(); i++ ) {
+			GMDescriptor& q = queries[ i ];
+			q.pt.x += Math::rand( -shift, shift );
+			q.pt.y += Math::rand( -shift, shift );
+			q.angle += Math::rand( -0.2f, 0.2f );
+			for( size_t k = 0; k < 12; k++ ) {
+				size_t bit = Math::rand( 0.0f, 255.0f );
+				q.desc[ bit >> 3 ] ^= 1 << ( bit & 7 );
+			}
+		}
+	}
+
+	struct GMReference {
+		GuidedMatcher::Params params;
+
+		bool angleOk( const Feature& a, const Feature& b ) const
+		{
+			if( params.maxAngleDiff < 0.0f )
+				return true;
+			float diff = fmodf( Math::abs( a.angle - b.angle ), Math::TWO_PI );
+			return Math::min( diff, Math::TWO_PI - diff ) <= params.maxAngleDiff;
+		}
+
+		bool octaveOk( const Feature& a, const Feature& b ) const
+		{
+			return ( size_t ) Math::abs( a.octave - b.octave ) <= params.maxOctaveDiff;
+		}
+
+		/* returns the best distance or -1 if there is no match */
+		template<typename GEOM>
+		float match( const GMDescriptor& q, const std::vector<GMDescriptor>& targets, GEOM geom ) const
+		{
+			float best = Math::MAXF, second = Math::MAXF;
+			for( size_t t = 0; t < targets.size(); t++ ) {
+				if( !geom( q, targets[ t ] ) || !octaveOk( q, targets[ t ] ) || !angleOk( q, targets[ t ] ) )
+					continue;
+				float d = q.distance( targets[ t ] );
+				if( d < best ) {
+					second = best;
+					best = d;
+				} else if( d < second ) {
+					second = d;
+				}
+			}
+			if( best >= params.maxDistance || ( params.ratio < 1.0f && best >= params.ratio * second ) )
+				return -1.0f;
+			return best;
+		}
+	};
+
+	struct GMWindow {
+		GMWindow( float r ) : radius( r ) {}
+		bool operator()( const Feature& q, const Feature& t ) const { return Math::abs( q.pt.x - t.pt.x ) <= radius && Math::abs( q.pt.y - t.pt.y ) <= radius; }
+		float radius;
+	};
+
+	struct GMScanLine {
+		bool operator()( const Feature& q, const Feature& t ) const
+		{
+			float disp = q.pt.x - t.pt.x;
+			return Math::abs( q.pt.y - t.pt.y ) <= 2.0f && disp >= 0.0f && disp <= 60.0f;
+		}
+	};
+
+	struct GMEpipolar {
+		GMEpipolar( const Vector3f& l ) : line( l ) {}
+		bool operator()( const Feature&, const Feature& t ) const
+		{
+			return Math::abs( line.x * t.pt.x + line.y * t.pt.y + line.z ) <= 2.0f * Math::sqrt( Math::sqr( line.x ) + Math::sqr( line.y ) );
+		}
+		Vector3f line;
+	};
+
+	static void _gmSameDescriptor( GMDescriptor& q, GMDescriptor& t )
+	{
+		for( size_t k = 0; k < 32; k++ )
+			q.desc[ k ] = t.desc[ k ] = k;
+	}
+
+	/* a single identical target at pt is found by a window query at ( 100, 100 ) */
+	static bool _gmWindowHit( const Vector2f& pt, float radius )
+	{
+		GMDescriptor q( 100.0f, 100.0f, 0.0f, 0, 0.0f ), t( pt.x, pt.y, 0.0f, 0, 0.0f );
+		_gmSameDescriptor( q, t );
+		GuidedMatcher matcher;
+		matcher.build( std::vector<const FeatureDescriptor*>( 1, &t ) );
+		std::vector<MatchingIndices> matches;
+		matcher.matchInWindow( matches, std::vector<FeatureDescriptor*>( 1, &q ), radius );
+		return matches.size() == 1;
+	}
+
+	/* a single identical target at pt is found by a scanline query at ( 100, 100 ) */
+	static bool _gmScanLineHit( const Vector2f& pt, float minDisp, float maxDisp, float lineDist )
+	{
+		GMDescriptor q( 100.0f, 100.0f, 0.0f, 0, 0.0f ), t( pt.x, pt.y, 0.0f, 0, 0.0f );
+		_gmSameDescriptor( q, t );
+		GuidedMatcher matcher;
+		matcher.build( std::vector<const FeatureDescriptor*>( 1, &t ) );
+		std::vector<FeatureMatch> matches;
+		matcher.scanLineMatch( matches, std::vector<const FeatureDescriptor*>( 1, &q ), minDisp, maxDisp, lineDist );
+		return matches.size() == 1;
+	}
+
+	/* the matches have to contain exactly the queries with a reference match and the same distances */
+	template<typename GEOM>
+	static bool _gmCompare( const std::vector<MatchingIndices>& matches, const std::vector<GMDescriptor>& queries,
+							const std::vector<GMDescriptor>& targets, const GMReference& ref, const std::vector<GEOM>& geom )
+	{
+		size_t m = 0;
+		for( size_t i = 0; i < queries.size(); i++ ) {
+			float d = ref.match( queries[ i ], targets, geom[ i ] );
+			if( d < 0.0f )
+				continue;
+			if( m >= matches.size() || matches[ m ].srcIdx != i || matches[ m ].distance != d )
+				return false;
+			const GMDescriptor& t = targets[ matches[ m ].dstIdx ];
+			if( !geom[ i ]( queries[ i ], t ) || queries[ i ].distance( t ) != d )
+				return false;
+			m++;
+		}
+		return m == matches.size();
+	}
+
+	static bool _gmSameMatches( const std::vector<MatchingIndices>& a, const std::vector<MatchingIndices>& b )
+	{
+		if( a.size() != b.size() )
+			return false;
+		for( size_t i = 0; i < a.size(); i++ ) {
+			if( a[ i ].srcIdx != b[ i ].srcIdx || a[ i ].dstIdx != b[ i ].dstIdx || a[ i ].distance != b[ i ].distance )
+				return false;
+		}
+		return true;
+	}
+
+	struct GMMatchEpipolar {
+		GMMatchEpipolar( const GuidedMatcher& m, const std::vector<const FeatureDescriptor*>& q, const std::vector<Vector3f>& l ) :
+			matcher( m ), queries( q ), lines( l ) {}
+		void operator()( std::vector<MatchingIndices>& matches ) const { matcher.matchEpipolar( matches, queries, lines, 2.0f ); }
+		const GuidedMatcher&							matcher;
+		const std::vector<const FeatureDescriptor*>&	queries;
+		const std::vector<Vector3f>&					lines;
+	};
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( GuidedMatcher )
+
+bool result = true;
+bool b;
+
+std::vector<GMDescriptor> targets, queries;
+_gmRandomDescriptors( targets, 3000 );
+_gmQueries( queries, targets, 4.0f );
+
+std::vector<const FeatureDescriptor*> tptr;
+std::vector<FeatureDescriptor*> qptr;
+std::vector<const FeatureDescriptor*> qcptr;
+for( size_t i = 0; i < targets.size(); i++ ) {
+	tptr.push_back( &targets[ i ] );
+	qptr.push_back( &queries[ i ] );
+	qcptr.push_back( &queries[ i ] );
+}
+
+GMReference ref;
+ref.params.maxDistance = 60.0f;
+ref.params.maxOctaveDiff = 1;
+
+GuidedMatcher matcher( 16.0f, ref.params );
+matcher.build( tptr );
+
+/* windows with fixed and per query radius */
+std::vector<MatchingIndices> matches;
+matcher.matchInWindow( matches, qptr, 10.0f );
+std::vector<GMWindow> windows( queries.size(), GMWindow( 10.0f ) );
+b = _gmCompare( matches, queries, targets, ref, windows ) && matches.size() > 2500;
+
+std::vector<float> radii( queries.size() );
+for( size_t i = 0; i < radii.size(); i++ ) {
+	radii[ i ] = Math::rand( 1.0f, 40.0f );
+	windows[ i ] = GMWindow( radii[ i ] );
+}
+matches.clear();
+matcher.matchInWindow( matches, qptr, radii );
+b &= _gmCompare( matches, queries, targets, ref, windows );
+CVTTEST_PRINT( "Window", b );
+result &= b;
+
+/* the window is a square including its border, the scanline bounds are inclusive */
+b = _gmWindowHit( Vector2f( 108.0f, 108.0f ), 8.0f ) && _gmWindowHit( Vector2f( 92.0f, 92.0f ), 8.0f );
+b &= !_gmWindowHit( Vector2f( 108.5f, 100.0f ), 8.0f ) && !_gmWindowHit( Vector2f( 100.0f, 91.5f ), 8.0f );
+b &= _gmScanLineHit( Vector2f( 95.0f, 102.0f ), 5.0f, 20.0f, 2.0f ) && _gmScanLineHit( Vector2f( 80.0f, 98.0f ), 5.0f, 20.0f, 2.0f );
+b &= !_gmScanLineHit( Vector2f( 95.5f, 100.0f ), 5.0f, 20.0f, 2.0f ) && !_gmScanLineHit( Vector2f( 79.5f, 100.0f ), 5.0f, 20.0f, 2.0f );
+b &= !_gmScanLineHit( Vector2f( 90.0f, 102.5f ), 5.0f, 20.0f, 2.0f );
+CVTTEST_PRINT( "Search region borders", b );
+result &= b;
+
+/* ratio test and rotation consistency */
+ref.params.ratio = 0.8f;
+ref.params.maxAngleDiff = 0.1f;
+matcher.setParams( ref.params );
+matches.clear();
+matcher.matchInWindow( matches, qptr, radii );
+b = _gmCompare( matches, queries, targets, ref, windows );
+CVTTEST_PRINT( "Ratio and rotation", b );
+result &= b;
+ref.params.ratio = 1.0f;
+ref.params.maxAngleDiff = -1.0f;
+ref.params.maxOctaveDiff = 0;
+matcher.setParams( ref.params );
+
+/* rectified stereo */
+std::vector<GMDescriptor> left( targets );
+for( size_t i = 0; i < left.size(); i++ ) {
+	left[ i ].pt.x += Math::rand( 0.0f, 50.0f );
+	left[ i ].pt.y += Math::rand( -1.0f, 1.0f );
+}
+std::vector<const FeatureDescriptor*> lptr;
+for( size_t i = 0; i < left.size(); i++ )
+	lptr.push_back( &left[ i ] );
+std::vector<FeatureMatch> fmatches;
+matcher.scanLineMatch( fmatches, lptr, 0.0f, 60.0f, 2.0f );
+matches.clear();
+for( size_t i = 0; i < fmatches.size(); i++ ) {
+	MatchingIndices m;
+	m.srcIdx = ( const GMDescriptor* ) fmatches[ i ].feature0 - &left[ 0 ];
+	m.dstIdx = ( const GMDescriptor* ) fmatches[ i ].feature1 - &targets[ 0 ];
+	m.distance = fmatches[ i ].distance;
+	matches.push_back( m );
+}
+std::vector<GMScanLine> scan( left.size() );
+b = _gmCompare( matches, left, targets, ref, scan ) && matches.size() > 2500;
+CVTTEST_PRINT( "Scanline", b );
+result &= b;
+
+/* epipolar lines through the query position in random directions */
+std::vector<Vector3f> lines( queries.size() );
+std::vector<GMEpipolar> epi;
+for( size_t i = 0; i < lines.size(); i++ ) {
+	float a = Math::rand( 0.0f, Math::PI );
+	Vector2f n( Math::cos( a ), Math::sin( a ) );
+	lines[ i ] = Vector3f( n.x, n.y, -n.dot( targets[ i ].pt ) );
+	epi.push_back( GMEpipolar( lines[ i ] ) );
+}
+matches.clear();
+matcher.matchEpipolar( matches, qcptr, lines, 2.0f );
+b = _gmCompare( matches, queries, targets, ref, epi ) && matches.size() > 2500;
+CVTTEST_PRINT( "Epipolar", b );
+result &= b;
+
+/* independent of the number of threads */
+b = testThreadInvariance<std::vector<MatchingIndices> >( GMMatchEpipolar( matcher, qcptr, lines ), _gmSameMatches );
+CVTTEST_PRINT( "Threads", b );
+result &= b;
+
+return result;
+
+END_CVTTEST
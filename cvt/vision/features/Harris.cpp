@@ -24,8 +24,234 @@
 
 
 #include <cvt/vision/features/Harris.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/SIMD.h>
+
+#define HARRIS_BAND_HEIGHT 32
 
 namespace cvt {
-	const float Harris::_kappa = 0.04f; // 0.04 to 0.15 - TODO: make parameter
-	const int	Harris::_radius = 3;
+
+	class HarrisBands
+	{
+		public:
+			HarrisBands( std::vector<std::vector<Feature> >& out, const Image& image, const uint8_t* ptr, size_t stride,
+						 const std::vector<float>& weights, Harris::Response response, float kappa, float threshold,
+						 size_t border, bool nms, bool subpixel, size_t octave, float scale ) :
+				_out( out ), _ptr( ptr ), _stride( stride ), _u8( image.format() == IFormat::GRAY_UINT8 ),
+				_width( image.width() ), _height( image.height() ), _weights( weights ), _response( response ),
+				_kappa( kappa ), _threshold( threshold ), _border( border ), _nms( nms ), _subpixel( subpixel ),
+				_octave( octave ), _scale( scale )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const int w = _width;
+				const int h = _height;
+				const int r = _weights.size() >> 1;
+				const int wn = _weights.size();
+				const size_t rstride = Math::pad16( sizeof( float ) * ( w + 8 ) ) / sizeof( float );
+
+				/* 3 image rows, 3 tensor rows, 3 x ( 2 r + 1 ) horizontally windowed rows, 3 vertically windowed rows
+				   and the responses of the band with one row above and below */
+				const size_t nrows = 3 + 3 + 3 * wn + 3 + HARRIS_BAND_HEIGHT + 2;
+				ScopedBuffer<float, true> mem( rstride * nrows );
+				float* rows = mem.ptr();
+				float* img[ 3 ];
+				int imgId[ 3 ];
+				for( int i = 0; i < 3; i++ ) {
+					img[ i ] = rows + 4;
+					imgId[ i ] = -1;
+					rows += rstride;
+				}
+				float* t[ 3 ];
+				for( int i = 0; i < 3; i++ ) {
+					t[ i ] = rows;
+					rows += rstride;
+				}
+				std::vector<float*> win( 3 * wn );
+				for( int i = 0; i < 3 * wn; i++ ) {
+					win[ i ] = rows;
+					rows += rstride;
+				}
+				float* sum[ 3 ];
+				for( int i = 0; i < 3; i++ ) {
+					sum[ i ] = rows;
+					rows += rstride;
+				}
+				float* scores = rows;
+				std::vector<const float*> bufs( wn );
+
+				for( size_t band = begin; band < end; band++ ) {
+					std::vector<Feature>& features = _out[ band ];
+					const int y0 = _border + band * HARRIS_BAND_HEIGHT;
+					const int y1 = Math::min<int>( y0 + HARRIS_BAND_HEIGHT, h - _border );
+					const int sy0 = Math::max( y0 - 1, 0 );
+					const int sy1 = Math::min( y1 + 1, h );
+
+					/* windowed tensor rows j in [ y - r, y + r ] live in slot ( j - sy0 + r ) % wn */
+					int jnext = sy0 - r;
+					for( int y = sy0; y < sy1; y++ ) {
+						for( ; jnext <= y + r; jnext++ ) {
+							int cj = Math::clamp( jnext, 0, h - 1 );
+							const float* prev = imageRow( img, imgId, Math::max( cj - 1, 0 ), cj, Math::min( cj + 1, h - 1 ), 0 );
+							const float* cur  = imageRow( img, imgId, Math::max( cj - 1, 0 ), cj, Math::min( cj + 1, h - 1 ), 1 );
+							const float* next = imageRow( img, imgId, Math::max( cj - 1, 0 ), cj, Math::min( cj + 1, h - 1 ), 2 );
+							simd->cornerTensor1f( t[ 0 ], t[ 1 ], t[ 2 ], prev, cur, next, w );
+
+							int slot = ( jnext - sy0 + r ) % wn;
+							for( int c = 0; c < 3; c++ )
+								simd->ConvolveHorizontalSym1f( win[ c * wn + slot ], t[ c ], w, &_weights[ 0 ], wn, IBORDER_CLAMP );
+						}
+
+						for( int c = 0; c < 3; c++ ) {
+							for( int k = 0; k < wn; k++ )
+								bufs[ k ] = win[ c * wn + ( y - r + k - sy0 + r ) % wn ];
+							simd->ConvolveClampVertSym_f( sum[ c ], &bufs[ 0 ], &_weights[ 0 ], wn, w );
+						}
+
+						float* score = scores + ( y - sy0 ) * rstride;
+						if( _response == Harris::HARRIS )
+							simd->harrisScore1f( score, sum[ 0 ], sum[ 1 ], sum[ 2 ], _kappa, w );
+						else
+							simd->shiTomasiScore1f( score, sum[ 0 ], sum[ 1 ], sum[ 2 ], w );
+					}
+
+					for( int y = y0; y < y1; y++ ) {
+						const float* score = scores + ( y - sy0 ) * rstride;
+						const float* above = y > sy0 ? score - rstride : 0;
+						const float* below = y + 1 < sy1 ? score + rstride : 0;
+						for( int x = _border; x < w - ( int ) _border; x++ ) {
+							float s = score[ x ];
+							if( !( s > _threshold ) )
+								continue;
+							if( _nms && !isMaximum( above, score, below, x, w ) )
+								continue;
+
+							Vector2f pt( x, y );
+							if( _subpixel && above && below && x > 0 && x + 1 < w )
+								pt += refine( above, score, below, x );
+							features.push_back( Feature( pt.x * _scale, pt.y * _scale, 0.0f, _octave, s ) );
+						}
+					}
+				}
+			}
+
+		private:
+			/* returns the image row ids[ idx ] as float with one replicated pixel on each side */
+			const float* imageRow( float** img, int* imgId, int y0, int y1, int y2, int idx ) const
+			{
+				const int ids[ 3 ] = { y0, y1, y2 };
+				const int y = ids[ idx ];
+				for( int i = 0; i < 3; i++ ) {
+					if( imgId[ i ] == y )
+						return img[ i ];
+				}
+
+				/* replace a row that is not needed */
+				int i = 0;
+				while( imgId[ i ] == y0 || imgId[ i ] == y1 || imgId[ i ] == y2 )
+					i++;
+
+				float* dst = img[ i ];
+				if( _u8 )
+					SIMD::instance()->Conv_u8_to_f( dst, _ptr + y * _stride, _width );
+				else
+					SIMD::instance()->Memcpy( ( uint8_t* ) dst, _ptr + y * _stride, sizeof( float ) * _width );
+				dst[ -1 ] = dst[ 0 ];
+				dst[ _width ] = dst[ _width - 1 ];
+				imgId[ i ] = y;
+				return dst;
+			}
+
+			/* no response in the 3x3 neighbourhood is larger */
+			bool isMaximum( const float* above, const float* score, const float* below, int x, int w ) const
+			{
+				const float s = score[ x ];
+				const int xs = Math::max( x - 1, 0 );
+				const int xe = Math::min( x + 1, w - 1 );
+				for( int i = xs; i <= xe; i++ ) {
+					if( score[ i ] > s || ( above && above[ i ] > s ) || ( below && below[ i ] > s ) )
+						return false;
+				}
+				return true;
+			}
+
+			/* maximum of the quadratic fitted to the 3x3 responses, zero if it is not within one pixel */
+			Vector2f refine( const float* above, const float* score, const float* below, int x ) const
+			{
+				float gx  = 0.5f * ( score[ x + 1 ] - score[ x - 1 ] );
+				float gy  = 0.5f * ( below[ x ] - above[ x ] );
+				float hxx = score[ x + 1 ] - 2.0f * score[ x ] + score[ x - 1 ];
+				float hyy = below[ x ] - 2.0f * score[ x ] + above[ x ];
+				float hxy = 0.25f * ( below[ x + 1 ] - below[ x - 1 ] - above[ x + 1 ] + above[ x - 1 ] );
+				float det = hxx * hyy - hxy * hxy;
+
+				Vector2f offset( 0.0f, 0.0f );
+				if( hxx < 0.0f && det > 0.0f ) {
+					offset.x = -( hyy * gx - hxy * gy ) / det;
+					offset.y = -( hxx * gy - hxy * gx ) / det;
+					if( Math::abs( offset.x ) > 1.0f || Math::abs( offset.y ) > 1.0f )
+						offset.setZero();
+				}
+				return offset;
+			}
+
+			std::vector<std::vector<Feature> >&	_out;
+			const uint8_t*				_ptr;
+			size_t						_stride;
+			bool						_u8;
+			size_t						_width;
+			size_t						_height;
+			const std::vector<float>&	_weights;
+			Harris::Response			_response;
+			float						_kappa;
+			float						_threshold;
+			size_t						_border;
+			bool						_nms;
+			bool						_subpixel;
+			size_t						_octave;
+			float						_scale;
+	};
+
+	void Harris::detect( FeatureSet& features, const Image& image, size_t octave, float scale )
+	{
+		if( image.format() != IFormat::GRAY_FLOAT && image.format() != IFormat::GRAY_UINT8 )
+			throw CVTException( "Input Image format must be GRAY_FLOAT or GRAY_UINT8" );
+
+		if( image.width() <= 2 * _border || image.height() <= 2 * _border )
+			return;
+
+		/* separable window weights */
+		const int r = _radius;
+		std::vector<float> weights( 2 * r + 1 );
+		float wsum = 0.0f;
+		for( int i = -r; i <= r; i++ ) {
+			if( _window == WINDOW_GAUSS ) {
+				float sigma = 0.5f * r;
+				weights[ i + r ] = Math::exp( -( float ) ( i * i ) / ( 2.0f * sigma * sigma ) );
+			} else
+				weights[ i + r ] = 1.0f;
+			wsum += weights[ i + r ];
+		}
+		for( size_t i = 0; i < weights.size(); i++ )
+			weights[ i ] /= wsum;
+
+		size_t bands = ( image.height() - 2 * _border + HARRIS_BAND_HEIGHT - 1 ) / HARRIS_BAND_HEIGHT;
+		std::vector<std::vector<Feature> > out( bands );
+		{
+			IMapScoped<const uint8_t> map( image );
+			HarrisBands body( out, image, map.ptr(), map.stride(), weights, _response, _kappa, _threshold,
+							  _border, _nms, _subpixel, octave, scale );
+			ParallelFor::run( body, 0, bands );
+		}
+
+		for( size_t b = 0; b < bands; b++ ) {
+			for( size_t i = 0; i < out[ b ].size(); i++ )
+				features.add( out[ b ][ i ] );
+		}
+	}
 }
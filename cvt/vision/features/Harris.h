@@ -27,16 +27,30 @@
 
 #include <cvt/vision/features/FeatureDetector.h>
 #include <cvt/gfx/Image.h>
-#include <cvt/gfx/ifilter/BoxFilter.h>
-#include <cvt/gfx/IMapScoped.h>
-#include <cvt/util/ScopedBuffer.h>
-
+#include <cvt/math/Math.h>
 
 namespace cvt
 {
+	/**
+	  @brief Harris / Shi-Tomasi corner detector.
+
+	  Gradients, tensor products, window sums and the corner response are computed in one pass over
+	  rolling row buffers, the rows are processed in parallel bands. GRAY_UINT8 images are evaluated
+	  with intensities in [ 0, 1 ] like GRAY_FLOAT images, so both share the threshold.
+	 */
 	class Harris : public FeatureDetector
 	{
 		public:
+			enum Response {
+				HARRIS,		/* det - kappa * trace^2 */
+				SHI_TOMASI	/* smaller eigenvalue */
+			};
+
+			enum Window {
+				WINDOW_BOX,
+				WINDOW_GAUSS
+			};
+
 			Harris( float threshold = 5e-5f, size_t border = 3 );
 			~Harris();
 
@@ -49,20 +63,47 @@ namespace cvt
 			void setBorder( size_t border )	{ _border = border; }
 			size_t border() const	{ return _border; }
 
+			void setResponse( Response response )	{ _response = response; }
+			Response response() const				{ return _response; }
+
+			void setKappa( float kappa )			{ _kappa = kappa; }
+			float kappa() const						{ return _kappa; }
+
+			/* ( 2 radius + 1 )^2 window of the structure tensor, the gaussian uses sigma = radius / 2 */
+			void setWindow( size_t radius, Window window = WINDOW_BOX );
+			size_t windowRadius() const				{ return _radius; }
+			Window window() const					{ return _window; }
+
+			/* only keep the maxima of the 3x3 neighbourhood */
+			void setNonMaxSuppress( bool nms )		{ _nms = nms; }
+			bool nonMaxSuppress() const				{ return _nms; }
+
+			/* refine the positions of the 3x3 maxima by fitting a quadratic to the response */
+			void setSubpixel( bool subpixel )		{ _subpixel = subpixel; }
+			bool subpixel() const					{ return _subpixel; }
+
 		private:
-			void detectFloat( FeatureSet& features, const Image& image );
-			void detectU8( FeatureSet& features, const Image& image );
+			void detect( FeatureSet& features, const Image& image, size_t octave, float scale );
 
 			float		_threshold;
             size_t		_border;
-
-			static const float  _kappa;
-			static const int	_radius;
+			Response	_response;
+			float		_kappa;
+			size_t		_radius;
+			Window		_window;
+			bool		_nms;
+			bool		_subpixel;
 	};
 
 	inline Harris::Harris( float threshold, size_t border ) :
 		_threshold( threshold ),
-		_border( border )
+		_border( border ),
+		_response( HARRIS ),
+		_kappa( 0.04f ),
+		_radius( 3 ),
+		_window( WINDOW_BOX ),
+		_nms( false ),
+		_subpixel( false )
 	{
 	}
 
@@ -70,73 +111,21 @@ namespace cvt
 	{
 	}
 
-	inline void Harris::detect( FeatureSet& features, const Image& image )
+	inline void Harris::setWindow( size_t radius, Window window )
 	{
-		if( image.format() == IFormat::GRAY_FLOAT )
-			detectFloat( features, image );
-		else if( image.format() == IFormat::GRAY_UINT8 )
-			detectU8( features, image );
-		else
-			throw CVTException( "Input Image format must be GRAY_FLOAT or GRAY_UINT8" );
-
+		_radius = Math::max<size_t>( radius, 1 );
+		_window = window;
 	}
 
-	inline void Harris::detectFloat( FeatureSet& features, const Image& image )
+	inline void Harris::detect( FeatureSet& features, const Image& image )
 	{
-		size_t w, h;
-
-		w = image.width();
-		h = image.height();
-
-		Image dx( w, h, IFormat::GRAY_FLOAT );
-		Image dy( w, h, IFormat::GRAY_FLOAT );
-		Image dxy( w, h, IFormat::GRAY_FLOAT );
-
-		image.convolve( dx, IKernel::HAAR_HORIZONTAL_3 );
-		image.convolve( dy, IKernel::HAAR_VERTICAL_3 );
-
-		dxy = dx;
-		dxy.mul( dy );
-		dx.mul( dx );
-		dy.mul( dy );
-
-		dx.boxfilter( dx, _radius );
-		dy.boxfilter( dy, _radius );
-		dxy.boxfilter( dxy, _radius );
-
-		IMapScoped<const float> dxmap( dx );
-		IMapScoped<const float> dymap( dy );
-		IMapScoped<const float> dxymap( dxy );
-
-		SIMD* simd = SIMD::instance();
-		size_t yend = h - _border;
-		size_t xend = w - _border;
-		ScopedBuffer<float,true> scorebuf( w );
-		dxmap.setLine( _border );
-		dymap.setLine( _border );
-		dxymap.setLine( _border );
-
-		for( size_t y = _border; y < yend; y++ ) {
-			float* ptr = scorebuf.ptr();
-			simd->harrisScore1f( ptr, dxmap.ptr(), dymap.ptr(), dxymap.ptr(), _kappa, w );
-			for( size_t x = _border;  x < xend; x++ ) {
-				if( ptr[ x ] > _threshold  )
-					features.add( Feature( x, y, 0, 0, ptr[ x ] ) );
-			}
-			dxmap++;
-			dymap++;
-			dxymap++;
-		}
+		detect( features, image, 0, 1.0f );
 	}
 
-	inline void Harris::detectU8( FeatureSet& features, const Image& image )
+	inline void Harris::detect( FeatureSet& features, const ImagePyramid& pyr )
 	{
-		throw CVTException( "uint8 detection not implemented" );
-	}
-
-	inline void Harris::detect( FeatureSet& features, const ImagePyramid& image )
-	{		
-		throw CVTException( "multiscale detection not implemented" );
+		for( size_t o = 0; o < pyr.octaves(); o++ )
+			detect( features, pyr[ o ], o, Math::pow( pyr.scaleFactor(), -( float ) o ) );
 	}
 
 }
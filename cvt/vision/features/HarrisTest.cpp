@@ -0,0 +1,291 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/features/Harris.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+
+#include <string.h>
+
+namespace cvt {
+
+	static void _harrisImage( Image& img, size_t w, size_t h )
+	{
+		img.reallocate( w, h, IFormat::GRAY_UINT8 );
+		std::vector<float> v( w * h, 90.0f );
+		for( size_t r = 0; r < 120; r++ ) {
+			size_t x0 = Math::rand( 0.0f, w - 1.0f ), y0 = Math::rand( 0.0f, h - 1.0f );
+			size_t x1 = Math::min<size_t>( w, x0 + Math::rand( 6.0f, 60.0f ) );
+			size_t y1 = Math::min<size_t>( h, y0 + Math::rand( 6.0f, 60.0f ) );
+			float c = Math::rand( 0.0f, 255.0f );
+			for( size_t y = y0; y < y1; y++ )
+				for( size_t x = x0; x < x1; x++ )
+					v[ y * w + x ] = c;
+		}
+		IMapScoped<uint8_t> map( img );
+		for( size_t y = 0; y < h; y++ ) {
+			uint8_t* p = map.ptr();
+			for( size_t x = 0; x < w; x++ )
+				p[ x ] = Math::clamp( v[ y * w + x ] + Math::rand( -4.0f, 4.0f ), 0.0f, 255.0f );
+			map++;
+		}
+	}
+
+	/* smooth bright quadrant with its corner at ( cx, cy ) */
+	static void _harrisSquare( Image& img, float cx, float cy )
+	{
+		img.reallocate( 100, 100, IFormat::GRAY_FLOAT );
+		IMapScoped<float> map( img );
+		for( size_t y = 0; y < 100; y++ ) {
+			float* p = map.ptr();
+			float ey = 0.5f + 0.5f * tanhf( ( ( float ) y - cy ) / 3.0f );
+			for( size_t x = 0; x < 100; x++ ) {
+				float ex = 0.5f + 0.5f * tanhf( ( ( float ) x - cx ) / 3.0f );
+				p[ x ] = 0.2f + 0.6f * ex * ey;
+			}
+			map++;
+		}
+	}
+
+	/* response at every pixel evaluated directly with clamped borders */
+	static void _harrisReference( std::vector<float>& score, const Image& img, size_t radius, Harris::Response response, float kappa )
+	{
+		int w = img.width(), h = img.height(), r = radius;
+		std::vector<float> v( w * h );
+		{
+			IMapScoped<const uint8_t> map( img );
+			for( int y = 0; y < h; y++ ) {
+				for( int x = 0; x < w; x++ )
+					v[ y * w + x ] = map.ptr()[ x ] / 255.0f;
+				map++;
+			}
+		}
+
+		std::vector<float> xx( w * h ), yy( w * h ), xy( w * h );
+		for( int y = 0; y < h; y++ ) {
+			for( int x = 0; x < w; x++ ) {
+				float dx = v[ y * w + Math::min( x + 1, w - 1 ) ] - v[ y * w + Math::max( x - 1, 0 ) ];
+				float dy = v[ Math::min( y + 1, h - 1 ) * w + x ] - v[ Math::max( y - 1, 0 ) * w + x ];
+				xx[ y * w + x ] = dx * dx;
+				yy[ y * w + x ] = dy * dy;
+				xy[ y * w + x ] = dx * dy;
+			}
+		}
+
+		score.resize( w * h );
+		float norm = 1.0f / Math::sqr( 2.0f * r + 1.0f );
+		for( int y = 0; y < h; y++ ) {
+			for( int x = 0; x < w; x++ ) {
+				double a = 0, b = 0, c = 0;
+				for( int dy = -r; dy <= r; dy++ ) {
+					for( int dx = -r; dx <= r; dx++ ) {
+						int i = Math::clamp( y + dy, 0, h - 1 ) * w + Math::clamp( x + dx, 0, w - 1 );
+						a += xx[ i ];
+						b += yy[ i ];
+						c += xy[ i ];
+					}
+				}
+				a *= norm; b *= norm; c *= norm;
+				if( response == Harris::HARRIS )
+					score[ y * w + x ] = ( a * b - c * c ) - kappa * Math::sqr( a + b );
+				else
+					score[ y * w + x ] = 0.5 * ( a + b ) - Math::sqrt( Math::sqr( 0.5 * ( a - b ) ) + c * c );
+			}
+		}
+	}
+
+	static bool _harrisKernels()
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+		bool ret = true;
+
+		const size_t n = 103;
+		std::vector<float> a( n + 2 ), b( n + 2 ), c( n + 2 );
+		for( size_t i = 0; i < n + 2; i++ ) {
+			a[ i ] = Math::rand( 0.0f, 1.0f );
+			b[ i ] = Math::rand( 0.0f, 1.0f );
+			c[ i ] = Math::rand( -1.0f, 1.0f );
+		}
+
+		std::vector<float> r1( 3 * n + 8, 0.0f ), r2( 3 * n + 8, 0.0f );
+		base->shiTomasiScore1f( &r1[ 0 ], &a[ 0 ], &b[ 0 ], &c[ 0 ], n );
+		best->shiTomasiScore1f( &r2[ 0 ], &a[ 0 ], &b[ 0 ], &c[ 0 ], n );
+		ret &= r1 == r2;
+
+		/* must not write beyond n */
+		base->harrisScore1f( &r1[ 0 ], &a[ 0 ], &b[ 0 ], &c[ 0 ], 0.04f, n );
+		best->harrisScore1f( &r2[ 0 ], &a[ 0 ], &b[ 0 ], &c[ 0 ], 0.04f, n );
+		ret &= r1 == r2 && r2[ n ] == r1[ n ];
+
+		base->cornerTensor1f( &r1[ 0 ], &r1[ n ], &r1[ 2 * n ], &a[ 1 ], &b[ 1 ], &c[ 1 ], n );
+		best->cornerTensor1f( &r2[ 0 ], &r2[ n ], &r2[ 2 * n ], &a[ 1 ], &b[ 1 ], &c[ 1 ], n );
+		ret &= r1 == r2;
+
+		delete base;
+		delete best;
+		return ret;
+	}
+
+	static bool _harrisResponse( const Image& img, Harris::Response response )
+	{
+		std::vector<float> ref;
+		_harrisReference( ref, img, 3, response, 0.04f );
+
+		/* every pixel inside of the border is a feature */
+		Harris harris( -1e30f, 2 );
+		harris.setResponse( response );
+		FeatureSet fs;
+		harris.detect( fs, img );
+
+		size_t w = img.width(), h = img.height();
+		if( fs.size() != ( w - 4 ) * ( h - 4 ) )
+			return false;
+
+		float maxabs = 0.0f;
+		for( size_t i = 0; i < ref.size(); i++ )
+			maxabs = Math::max( maxabs, Math::abs( ref[ i ] ) );
+
+		for( size_t i = 0; i < fs.size(); i++ ) {
+			size_t x = fs[ i ].pt.x, y = fs[ i ].pt.y;
+			if( Math::abs( fs[ i ].score - ref[ y * w + x ] ) > 1e-4f * maxabs )
+				return false;
+		}
+		return true;
+	}
+
+	static bool _harrisSame( const FeatureSet& a, const FeatureSet& b )
+	{
+		if( a.size() != b.size() )
+			return false;
+		for( size_t i = 0; i < a.size(); i++ ) {
+			if( a[ i ].pt != b[ i ].pt || a[ i ].score != b[ i ].score || a[ i ].octave != b[ i ].octave )
+				return false;
+		}
+		return true;
+	}
+
+	struct HarrisDetect {
+		HarrisDetect( Harris& h, const Image& i ) : harris( h ), img( i ) {}
+		void operator()( FeatureSet& fs ) const { harris.detect( fs, img ); }
+		Harris&			harris;
+		const Image&	img;
+	};
+
+	static Vector2f _harrisCorner( float cx, float cy )
+	{
+		Image img;
+		_harrisSquare( img, cx, cy );
+
+		Harris harris( 1e-6f, 3 );
+		harris.setResponse( Harris::SHI_TOMASI );
+		harris.setWindow( 3, Harris::WINDOW_GAUSS );
+		harris.setNonMaxSuppress( true );
+		harris.setSubpixel( true );
+		FeatureSet fs;
+		harris.detect( fs, img );
+
+		Vector2f best( -1.0f, -1.0f );
+		float score = 0.0f;
+		for( size_t i = 0; i < fs.size(); i++ ) {
+			if( fs[ i ].score > score ) {
+				score = fs[ i ].score;
+				best = fs[ i ].pt;
+			}
+		}
+		return best;
+	}
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( Harris )
+
+bool result = true;
+bool b;
+
+b = _harrisKernels();
+CVTTEST_PRINT( "Kernels", b );
+result &= b;
+
+Image img;
+_harrisImage( img, 211, 157 );
+
+b = _harrisResponse( img, Harris::HARRIS );
+CVTTEST_PRINT( "Harris response", b );
+result &= b;
+
+b = _harrisResponse( img, Harris::SHI_TOMASI );
+CVTTEST_PRINT( "Shi-Tomasi response", b );
+result &= b;
+
+/* float and uint8 input */
+Harris harris( 1e-4f, 4 );
+harris.setNonMaxSuppress( true );
+FeatureSet fs8, fsf;
+harris.detect( fs8, img );
+Image imgf;
+img.convert( imgf, IFormat::GRAY_FLOAT );
+harris.detect( fsf, imgf );
+b = fs8.size() > 50 && fs8.size() == fsf.size();
+for( size_t i = 0; i < fs8.size() && b; i++ )
+	b &= fs8[ i ].pt == fsf[ i ].pt && Math::abs( fs8[ i ].score - fsf[ i ].score ) < 1e-6f;
+CVTTEST_PRINT( "uint8 vs. float", b );
+result &= b;
+
+/* independent of the number of threads */
+b = testThreadInvariance<FeatureSet>( HarrisDetect( harris, img ), _harrisSame );
+CVTTEST_PRINT( "Threads", b );
+result &= b;
+
+/* octave 0 of a pyramid equals the image, higher octaves are scaled */
+ImagePyramid pyr( 3, 0.5f );
+pyr.update( img );
+FeatureSet fsp, fsp0;
+harris.detect( fsp, pyr );
+for( size_t i = 0; i < fsp.size(); i++ ) {
+	if( fsp[ i ].octave == 0 )
+		fsp0.add( fsp[ i ] );
+}
+b = _harrisSame( fs8, fsp0 ) && fsp.size() > fsp0.size();
+for( size_t i = 0; i < fsp.size(); i++ )
+	b &= fsp[ i ].pt.x < img.width() && fsp[ i ].pt.y < img.height();
+CVTTEST_PRINT( "Pyramid", b );
+result &= b;
+
+/* the refined corner follows a subpixel shift */
+Vector2f c0 = _harrisCorner( 40.0f, 50.0f );
+Vector2f c1 = _harrisCorner( 40.4f, 50.3f );
+Vector2f d = c1 - c0;
+b = c0.x > 0 && Math::abs( d.x - 0.4f ) < 0.2f && Math::abs( d.y - 0.3f ) < 0.2f;
+CVTTEST_PRINT( "Subpixel", b );
+result &= b;
+
+return result;
+
+END_CVTTEST
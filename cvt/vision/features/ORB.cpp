@@ -23,9 +23,167 @@
 */
 
 #include <cvt/vision/features/ORB.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/SIMD.h>
 
 namespace cvt {
 
+	struct ORBLevel {
+		const float*		ptr;
+		size_t				stride;
+		float				scale;
+		const int*			strips;
+		const int*			tests;
+	};
+
+	class ORBExtract
+	{
+		public:
+			ORBExtract( ORB::Descriptor* descriptors, const std::vector<ORBLevel>& levels ) :
+				_descriptors( descriptors ), _levels( levels )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				float sums[ 60 ];
+
+				for( size_t i = begin; i < end; i++ ) {
+					ORB::Descriptor& desc = _descriptors[ i ];
+					/* a single level is used for all features */
+					const ORBLevel& level = _levels[ _levels.size() > 1 ? desc.octave : 0 ];
+					Vector2f pt = desc.pt * level.scale;
+					const float* base = level.ptr + ( int ) pt.y * ( ssize_t ) level.stride + ( int ) pt.x;
+
+					/* intensity centroid from the row and column strips, summed in the order of the scalar version */
+					simd->boxSum_f( sums, base, level.strips, 60 );
+					float mx = 0.0f;
+					float my = 0.0f;
+					for( int k = 0; k < 15; k++ )
+						mx += ( ( float ) k - 15.0f ) * ( sums[ k ] - sums[ 15 + k ] );
+					for( int k = 0; k < 15; k++ )
+						my += ( ( float ) k - 15.0f ) * ( sums[ 30 + k ] - sums[ 45 + k ] );
+
+					float angle = Math::atan2( my, mx );
+					if( angle < 0 )
+						angle += Math::TWO_PI;
+					angle = Math::TWO_PI - angle + Math::HALF_PI;
+					while( angle > Math::TWO_PI )
+						angle -= Math::TWO_PI;
+					desc.angle = angle;
+
+					size_t index = ( size_t ) ( angle * 30.0f / Math::TWO_PI );
+					if( index >= 30 )
+						index = 0;
+					simd->boxTest_f( desc.desc, base, level.tests + index * 256 * 8, 256 );
+				}
+			}
+
+		private:
+			ORB::Descriptor*				_descriptors;
+			const std::vector<ORBLevel>&	_levels;
+	};
+
+	void ORB::extract( const ImagePyramid& pyr, const FeatureSet& features )
+	{
+		if( pyr[ 0 ].channels() != 1 ||
+			( pyr[ 0 ].format() != IFormat::GRAY_UINT8 && pyr[ 0 ].format() != IFormat::GRAY_FLOAT ) )
+			throw CVTException( "Unimplemented" );
+
+		if( _integralPyr.octaves() != pyr.octaves() || _integralPyr.scaleFactor() != pyr.scaleFactor() )
+			_integralPyr = ImagePyramid( pyr.octaves(), pyr.scaleFactor() );
+		pyr.integralImage( _integralPyr );
+
+		std::vector<const Image*> integrals( pyr.octaves() );
+		for( size_t i = 0; i < pyr.octaves(); i++ )
+			integrals[ i ] = &_integralPyr[ i ];
+		extract( integrals, pyr.scaleFactor(), features );
+	}
+
+	void ORB::extract( const Image& img, const FeatureSet& features )
+	{
+		if( img.channels() != 1 ||
+			( img.format() != IFormat::GRAY_UINT8 && img.format() != IFormat::GRAY_FLOAT ) )
+			throw CVTException( "Unimplemented" );
+
+		img.integralImage( _integral );
+
+		std::vector<const Image*> integrals( 1, &_integral );
+		extract( integrals, 1.0f, features );
+	}
+
+	void ORB::extract( const std::vector<const Image*>& integrals, float scaleFactor, const FeatureSet& features )
+	{
+		std::vector<ORBLevel> levels( integrals.size() );
+		for( size_t i = 0; i < integrals.size(); i++ ) {
+			levels[ i ].ptr = integrals[ i ]->map<float>( &levels[ i ].stride );
+			levels[ i ].scale = Math::pow( scaleFactor, ( float ) i );
+			const Tables& t = tables( levels[ i ].stride );
+			levels[ i ].strips = &t.strips[ 0 ];
+			levels[ i ].tests = &t.tests[ 0 ];
+		}
+
+		size_t start = _features.size();
+		size_t iend = features.size();
+		_features.reserve( start + iend );
+		for( size_t i = 0; i < iend; ++i )
+			_features.push_back( Descriptor( features[ i ] ) );
+
+		if( iend ) {
+			ORBExtract body( &_features[ 0 ] + start, levels );
+			ParallelFor::run( body, 0, iend, 64 );
+		}
+
+		for( size_t i = 0; i < integrals.size(); i++ )
+			integrals[ i ]->unmap( levels[ i ].ptr );
+	}
+
+	static inline void _orbBox( int* offsets, int x0, int y0, int x1, int y1, int stride )
+	{
+		/* box ( x0, x1 ] x ( y0, y1 ] as br, tr, bl, tl */
+		offsets[ 0 ] = y1 * stride + x1;
+		offsets[ 1 ] = y0 * stride + x1;
+		offsets[ 2 ] = y1 * stride + x0;
+		offsets[ 3 ] = y0 * stride + x0;
+	}
+
+	const ORB::Tables& ORB::tables( size_t stride )
+	{
+		for( size_t i = 0; i < _tables.size(); i++ ) {
+			if( _tables[ i ].stride == stride )
+				return _tables[ i ];
+		}
+
+		_tables.push_back( Tables() );
+		Tables& t = _tables.back();
+		const int s = stride;
+		t.stride = stride;
+
+		/* the rows above / below and the columns left / right of the centre */
+		t.strips.resize( 60 * 4 );
+		for( int i = 0; i < 15; i++ ) {
+			int c = _circularoffset[ i ];
+			_orbBox( &t.strips[ i * 4 ], -c - 1, i - 16, c, i - 15, s );
+			_orbBox( &t.strips[ ( 15 + i ) * 4 ], -c - 1, 14 - i, c, 15 - i, s );
+			_orbBox( &t.strips[ ( 30 + i ) * 4 ], i - 16, -c - 1, i - 15, c, s );
+			_orbBox( &t.strips[ ( 45 + i ) * 4 ], 14 - i, -c - 1, 15 - i, c, s );
+		}
+
+		/* the 5x5 boxes of the rotated point pairs */
+		t.tests.resize( 30 * 512 * 4 );
+		int* o = &t.tests[ 0 ];
+		for( int a = 0; a < 30; a++ ) {
+			for( int p = 0; p < 512; p++ ) {
+				int px = _patterns[ a ][ p ][ 0 ];
+				int py = _patterns[ a ][ p ][ 1 ];
+				_orbBox( o, px - 3, py - 3, px + 2, py + 2, s );
+				o += 4;
+			}
+		}
+		return t;
+	}
+
 	const int ORB::_circularoffset[ 31 ] = {
 		3,  6,  8,  9, 10, 11, 12, 13, 13, 14, 14, 14, 15, 15, 15, 15,
 		15, 15, 15, 14, 14, 14, 13, 13, 12, 11, 10,  9,  8,  6,  3
@@ -34,6 +34,8 @@
 #include <cvt/vision/features/FeatureDescriptorExtractor.h>
 #include <cvt/vision/features/MatchBruteForce.h>
 
+#include <deque>
+
 namespace cvt {
 
 	class ORB : public FeatureDescriptorExtractor
@@ -93,22 +95,37 @@ namespace cvt {
 				SIMD* _simd;
 			};
 
-			float centroidAngle( const Vector2f& pt, const IMapScoped<const float>& map );
-			void descriptor( Descriptor& feature, const Vector2f& pt, const IMapScoped<const float>& map );
+			/* integral image offsets of the box sums for a row stride */
+			struct Tables {
+				size_t				stride;
+				std::vector<int>	strips; /* 4 x 15 strips of the intensity centroid */
+				std::vector<int>	tests;	/* 256 box tests for each of the 30 angle bins */
+			};
+
+			void extract( const std::vector<const Image*>& integrals, float scaleFactor, const FeatureSet& features );
+			const Tables& tables( size_t stride );
 
 			static const int		_patterns[ 30 ][ 512 ][ 2 ];
 			static const int		_circularoffset[ 31 ];
 
 			std::vector<Descriptor> _features;
+
+			/* reused between the extract calls */
+			Image					_integral;
+			ImagePyramid			_integralPyr;
+			/* deque: the levels keep pointers into the tables while new strides are added */
+			std::deque<Tables>		_tables;
 	};
 
-	inline ORB::ORB()
+	inline ORB::ORB() :
+		_integralPyr( 0, 0.5f )
 	{
 	}
 
 	inline ORB::ORB( const ORB& orb ) :
 		FeatureDescriptorExtractor(),
-		_features( orb._features )
+		_features( orb._features ),
+		_integralPyr( 0, 0.5f )
 	{
 	}
 
@@ -143,117 +160,6 @@ namespace cvt {
 		_features.clear();
 	}
 
-	inline void ORB::extract( const ImagePyramid& pyr, const FeatureSet& features )
-	{
-		if( pyr[ 0 ].channels() != 1 ||
-			( pyr[ 0 ].format() != IFormat::GRAY_UINT8 && pyr[ 0 ].format() != IFormat::GRAY_FLOAT ) )
-			throw CVTException( "Unimplemented" );
-
-		ImagePyramid integralPyr( pyr.octaves(), pyr.scaleFactor() );
-		pyr.integralImage( integralPyr );
-
-		size_t octaves = pyr.octaves();
-		std::vector<IMapScoped<const float>*> maps;
-		std::vector<float> scales;
-		for( size_t i = 0; i < octaves; ++i ){
-			maps.push_back( new IMapScoped<const float>( integralPyr[ i ] ) );
-			scales.push_back( Math::pow( integralPyr.scaleFactor(), ( float )i ) );
-		}
-
-		size_t iend = features.size();
-		Vector2f vs;
-		for( size_t i = 0; i < iend; ++i ) {
-			_features.push_back( Descriptor( features[ i ] ) );
-			Descriptor& desc = _features.back();
-			size_t o = desc.octave;
-			vs = desc.pt * scales[ o ];
-
-			desc.angle = centroidAngle( vs, *maps[ o ] );
-			descriptor( desc, vs, *maps[ o ] );
-		}
-
-		for( size_t i = 0; i < octaves; ++i ){
-			delete maps[ i ];
-		}
-	}
-
-	inline void ORB::extract( const Image& img, const FeatureSet& features )
-	{
-		if( img.channels() != 1 ||
-			( img.format() != IFormat::GRAY_UINT8 && img.format() != IFormat::GRAY_FLOAT ) )
-			throw CVTException( "Unimplemented" );
-
-		IntegralImage iimage( img );
-		IMapScoped<const float> map( iimage.sumImage() );
-
-		size_t iend = features.size();
-		for( size_t i = 0; i < iend; ++i ) {
-			_features.push_back( Descriptor( features[ i ] ) );
-			Descriptor& desc = _features.back();
-			desc.angle = centroidAngle( desc.pt, map );
-			descriptor( desc, desc.pt, map );
-		}
-	}
-
-	inline float ORB::centroidAngle( const Vector2f& pt, const IMapScoped<const float>& map )
-	{
-		float mx = 0;
-		float my = 0;
-		float angle = 0.0f;
-
-		int cury = ( int ) pt.y - 15;
-		int curx = ( int ) pt.x;
-
-		for( int i = 0; i < 15; i++ ) {
-			mx +=( ( float ) i - 15.0f ) * ( IntegralImage::area( map, curx - _circularoffset[ i ], cury + i, 2 * _circularoffset[ i ] + 1, 1 )
-										   - IntegralImage::area( map, curx - _circularoffset[ i ], cury + 30 - i, 2 * _circularoffset[ i ] + 1, 1) );
-		}
-
-		cury = ( int ) pt.y;
-		curx = ( int ) pt.x - 15;
-		for( int i = 0; i < 15; i++ ) {
-			my += ( ( float ) i - 15.0f ) * ( IntegralImage::area( map, curx + i, cury - _circularoffset[ i ], 1, 2 * _circularoffset[ i ] + 1 )
-											- IntegralImage::area( map, curx + 30 - i, cury - _circularoffset[ i ], 1, 2 * _circularoffset[ i ] + 1 ) );
-		}
-
-		angle = Math::atan2( my, mx );
-
-		if( angle < 0 )
-			angle += Math::TWO_PI;
-		angle = Math::TWO_PI - angle + Math::HALF_PI;
-
-		while( angle > Math::TWO_PI )
-			angle -= Math::TWO_PI;
-		return angle;
-	}
-
-	inline void ORB::descriptor( Descriptor& feature, const Vector2f& pt, const IMapScoped<const float>& map )
-	{
-		size_t index = ( size_t ) ( feature.angle * 30.0f / Math::TWO_PI );
-		if( index >= 30 )
-			index = 0;
-		int x = ( int ) pt.x;
-		int y = ( int ) pt.y;
-
-
-#define ORBTEST( n ) ( IntegralImage::area( map, x + _patterns[ index ][ ( n ) * 2 ][ 0 ] - 2,\
-										         y + _patterns[ index ][ ( n ) * 2 ][ 1 ] - 2, 5, 5 ) < \
-					   IntegralImage::area( map, x + _patterns[ index ][ ( n ) * 2 + 1 ][ 0 ] - 2,\
-										         y + _patterns[ index ][ ( n ) * 2 + 1 ][ 1 ] - 2, 5, 5 ) )
-		int idx;
-		for( int i = 0; i < 32; i++ ) {
-			idx = i << 3;
-			feature.desc[ i ]  =   ORBTEST( idx );
-			feature.desc[ i ] |= ( ORBTEST( idx + 1 ) ) << 1;
-			feature.desc[ i ] |= ( ORBTEST( idx + 2 ) ) << 2;
-			feature.desc[ i ] |= ( ORBTEST( idx + 3 ) ) << 3;
-			feature.desc[ i ] |= ( ORBTEST( idx + 4 ) ) << 4;
-			feature.desc[ i ] |= ( ORBTEST( idx + 5 ) ) << 5;
-			feature.desc[ i ] |= ( ORBTEST( idx + 6 ) ) << 6;
-			feature.desc[ i ] |= ( ORBTEST( idx + 7 ) ) << 7;
-		}
-	}
-
 	inline void ORB::matchBruteForce( std::vector<FeatureMatch>& matches, const FeatureDescriptorExtractor& other, float distThresh ) const
 	{
 		DistFunc dfunc;
@@ -0,0 +1,273 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/features/ORB.h>
+#include <cvt/vision/features/FAST.h>
+#include <cvt/vision/IntegralImage.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+
+#include <string.h>
+
+namespace cvt {
+
+	static void _orbImage( Image& img, size_t w, size_t h )
+	{
+		img.reallocate( w, h, IFormat::GRAY_UINT8 );
+		std::vector<float> v( w * h, 100.0f );
+		for( size_t r = 0; r < 250; r++ ) {
+			size_t x0 = Math::rand( 0.0f, w - 1.0f ), y0 = Math::rand( 0.0f, h - 1.0f );
+			size_t x1 = Math::min<size_t>( w, x0 + Math::rand( 4.0f, 50.0f ) );
+			size_t y1 = Math::min<size_t>( h, y0 + Math::rand( 4.0f, 50.0f ) );
+			float c = Math::rand( 0.0f, 255.0f );
+			for( size_t y = y0; y < y1; y++ )
+				for( size_t x = x0; x < x1; x++ )
+					v[ y * w + x ] = c;
+		}
+		IMapScoped<uint8_t> map( img );
+		for( size_t y = 0; y < h; y++ ) {
+			uint8_t* p = map.ptr();
+			for( size_t x = 0; x < w; x++ )
+				p[ x ] = Math::clamp( v[ y * w + x ] + Math::rand( -8.0f, 8.0f ), 0.0f, 255.0f );
+			map++;
+		}
+	}
+
+	/* the intensity centroid angle evaluated box by box */
+	static float _orbAngle( const Vector2f& pt, const IMapScoped<const float>& map )
+	{
+		static const int circ[ 15 ] = { 3, 6, 8, 9, 10, 11, 12, 13, 13, 14, 14, 14, 15, 15, 15 };
+		float mx = 0, my = 0;
+		int cury = ( int ) pt.y - 15;
+		int curx = ( int ) pt.x;
+		for( int i = 0; i < 15; i++ )
+			mx += ( ( float ) i - 15.0f ) * ( IntegralImage::area( map, curx - circ[ i ], cury + i, 2 * circ[ i ] + 1, 1 )
+											- IntegralImage::area( map, curx - circ[ i ], cury + 30 - i, 2 * circ[ i ] + 1, 1 ) );
+		cury = ( int ) pt.y;
+		curx = ( int ) pt.x - 15;
+		for( int i = 0; i < 15; i++ )
+			my += ( ( float ) i - 15.0f ) * ( IntegralImage::area( map, curx + i, cury - circ[ i ], 1, 2 * circ[ i ] + 1 )
+											- IntegralImage::area( map, curx + 30 - i, cury - circ[ i ], 1, 2 * circ[ i ] + 1 ) );
+
+		float angle = Math::atan2( my, mx );
+		if( angle < 0 )
+			angle += Math::TWO_PI;
+		angle = Math::TWO_PI - angle + Math::HALF_PI;
+		while( angle > Math::TWO_PI )
+			angle -= Math::TWO_PI;
+		return angle;
+	}
+
+	/* the sampling pattern of the original implementation */
+	namespace orbref {
+		struct ORB {
+			static const int _patterns[ 30 ][ 512 ][ 2 ];
+		};
+		#include <cvt/vision/features/ORBPattern.h>
+	}
+
+	/* the descriptor of the original implementation, 5x5 box tests evaluated with IntegralImage::area */
+	static void _orbDescriptor( uint8_t* desc, const Vector2f& pt, float angle, const IMapScoped<const float>& map )
+	{
+		size_t index = ( size_t ) ( angle * 30.0f / Math::TWO_PI );
+		if( index >= 30 )
+			index = 0;
+		const int ( *pattern )[ 2 ] = orbref::ORB::_patterns[ index ];
+		int x = ( int ) pt.x;
+		int y = ( int ) pt.y;
+		for( int i = 0; i < 32; i++ ) {
+			desc[ i ] = 0;
+			for( int k = 0; k < 8; k++ ) {
+				int n = ( i * 8 + k ) * 2;
+				float a = IntegralImage::area( map, x + pattern[ n ][ 0 ] - 2, y + pattern[ n ][ 1 ] - 2, 5, 5 );
+				float b = IntegralImage::area( map, x + pattern[ n + 1 ][ 0 ] - 2, y + pattern[ n + 1 ][ 1 ] - 2, 5, 5 );
+				desc[ i ] |= ( a < b ) << k;
+			}
+		}
+	}
+
+	static bool _orbEqual( const ORB& a, const ORB& b, size_t offset = 0 )
+	{
+		if( a.size() + offset > b.size() )
+			return false;
+		for( size_t i = 0; i < a.size(); i++ ) {
+			const ORB::Descriptor& da = ( const ORB::Descriptor& ) a[ i ];
+			const ORB::Descriptor& db = ( const ORB::Descriptor& ) b[ i + offset ];
+			if( da.pt != db.pt || da.angle != db.angle || memcmp( da.desc, db.desc, 32 ) )
+				return false;
+		}
+		return true;
+	}
+
+	static bool _orbSame( const ORB& a, const ORB& b )
+	{
+		return a.size() == b.size() && _orbEqual( a, b );
+	}
+
+	/* two extract calls on the same features */
+	struct ORBExtractTwice {
+		ORBExtractTwice( const Image& i, const FeatureSet& f ) : img( i ), features( f ) {}
+		void operator()( ORB& orb ) const
+		{
+			orb.extract( img, features );
+			orb.extract( img, features );
+		}
+		const Image&		img;
+		const FeatureSet&	features;
+	};
+
+	static bool _orbKernels()
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* sse2 = SIMD::get( SIMD_SSE2 );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+
+		std::vector<float> data( 4096 );
+		for( size_t i = 0; i < data.size(); i++ )
+			data[ i ] = Math::rand( 0.0f, 1000.0f );
+		const float* src = &data[ 2048 ];
+
+		std::vector<int> offsets( 8 * 64 );
+		for( size_t i = 0; i < offsets.size(); i++ )
+			offsets[ i ] = Math::rand( -2048.0f, 2047.0f );
+
+		bool ret = true;
+		for( size_t n = 0; n <= 64; n++ ) {
+			float s1[ 128 ], s2[ 128 ], s3[ 128 ];
+			base->boxSum_f( s1, src, &offsets[ 0 ], n );
+			sse2->boxSum_f( s2, src, &offsets[ 0 ], n );
+			best->boxSum_f( s3, src, &offsets[ 0 ], n );
+			ret &= !memcmp( s1, s2, sizeof( float ) * n ) && !memcmp( s1, s3, sizeof( float ) * n );
+		}
+		for( size_t n = 8; n <= 64; n += 8 ) {
+			uint8_t t1[ 8 ], t2[ 8 ], t3[ 8 ];
+			base->boxTest_f( t1, src, &offsets[ 0 ], n );
+			sse2->boxTest_f( t2, src, &offsets[ 0 ], n );
+			best->boxTest_f( t3, src, &offsets[ 0 ], n );
+			ret &= !memcmp( t1, t2, n / 8 ) && !memcmp( t1, t3, n / 8 );
+		}
+
+		delete base;
+		delete sse2;
+		delete best;
+		return ret;
+	}
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( ORB )
+
+bool result = true;
+bool b;
+
+b = _orbKernels();
+CVTTEST_PRINT( "boxSum_f / boxTest_f", b );
+result &= b;
+
+Image img;
+_orbImage( img, 640, 480 );
+FeatureSet features;
+FAST fast( SEGMENT_9, 25, 24 );
+fast.detect( features, img );
+
+ORB orb;
+orb.extract( img, features );
+b = orb.size() == features.size() && orb.size() > 100;
+
+Image iimg;
+img.integralImage( iimg );
+{
+	IMapScoped<const float> map( iimg );
+	for( size_t i = 0; i < orb.size(); i++ )
+		b &= orb[ i ].angle == _orbAngle( features[ i ].pt, map );
+}
+CVTTEST_PRINT( "Orientation", b );
+result &= b;
+
+b = true;
+{
+	IMapScoped<const float> map( iimg );
+	for( size_t i = 0; i < orb.size(); i++ ) {
+		const ORB::Descriptor& d = ( const ORB::Descriptor& ) orb[ i ];
+		uint8_t ref[ 32 ];
+		_orbDescriptor( ref, features[ i ].pt, d.angle, map );
+		b &= !memcmp( ref, d.desc, 32 );
+	}
+}
+CVTTEST_PRINT( "Descriptor vs. original", b );
+result &= b;
+
+/* the base kernels yield the same descriptors */
+SIMD::force( SIMD_BASE );
+ORB orbBase;
+orbBase.extract( img, features );
+SIMD::force( SIMD_BEST );
+b = _orbEqual( orb, orbBase );
+CVTTEST_PRINT( "Base vs. SIMD", b );
+result &= b;
+
+/* independent of the number of threads, repeated calls append */
+b = testThreadInvariance<ORB>( ORBExtractTwice( img, features ), _orbSame );
+{
+	ORB orbTwice;
+	ORBExtractTwice( img, features )( orbTwice );
+	b &= _orbEqual( orb, orbTwice ) && _orbEqual( orb, orbTwice, orb.size() );
+}
+CVTTEST_PRINT( "Threads", b );
+result &= b;
+
+/* octave 0 of a pyramid equals the image */
+ImagePyramid pyr( 3, 0.5f );
+pyr.update( img );
+FeatureSet pfeatures;
+fast.detect( pfeatures, pyr );
+ORB orbPyr;
+orbPyr.extract( pyr, pfeatures );
+orbPyr.extract( pyr, pfeatures );
+FeatureSet level0;
+for( size_t i = 0; i < pfeatures.size(); i++ ) {
+	if( pfeatures[ i ].octave == 0 )
+		level0.add( pfeatures[ i ] );
+}
+ORB orb0;
+orb0.extract( img, level0 );
+b = orbPyr.size() == 2 * pfeatures.size() && level0.size() < pfeatures.size();
+for( size_t i = 0, k = 0; i < pfeatures.size() && b; i++ ) {
+	if( pfeatures[ i ].octave != 0 )
+		continue;
+	const ORB::Descriptor& d0 = ( const ORB::Descriptor& ) orb0[ k++ ];
+	const ORB::Descriptor& dp = ( const ORB::Descriptor& ) orbPyr[ pfeatures.size() + i ];
+	b &= d0.angle == dp.angle && !memcmp( d0.desc, dp.desc, 32 );
+}
+CVTTEST_PRINT( "Pyramid", b );
+result &= b;
+
+return result;
+
+END_CVTTEST
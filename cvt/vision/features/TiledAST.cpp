@@ -0,0 +1,445 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/features/TiledAST.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/ParallelFor.h>
+#include <cvt/util/ScopedBuffer.h>
+#include <cvt/util/SIMD.h>
+
+#include <algorithm>
+#include <string.h>
+
+#define TILEDAST_TILE_WIDTH  128
+#define TILEDAST_TILE_HEIGHT 32
+
+namespace cvt
+{
+	/* circles as ( dx, dy ) pairs in the order of the FAST / AGAST implementations */
+	static const int _fastCircle[ 32 ] = {
+		 0,  3,	 1,  3,	 2,  2,	 3,  1,	 3,  0,	 3, -1,	 2, -2,	 1, -3,
+		 0, -3,	-1, -3,	-2, -2,	-3, -1,	-3,  0,	-3,  1,	-2,  2,	-1,  3
+	};
+
+	static const int _agast5_8Circle[ 16 ] = {
+		-1,  0,	-1, -1,	 0, -1,	 1, -1,	 1,  0,	 1,  1,	 0,  1,	-1,  1
+	};
+
+	static const int _agast7_12dCircle[ 24 ] = {
+		-3,  0,	-2, -1,	-1, -2,	 0, -3,	 1, -2,	 2, -1,	 3,  0,	 2,  1,	 1,  2,	 0,  3,	-1,  2,	-2,  1
+	};
+
+	static const int _agast7_12sCircle[ 24 ] = {
+		-2,  0,	-2, -1,	-1, -2,	 0, -2,	 1, -2,	 2, -1,	 2,  0,	 2,  1,	 1,  2,	 0,  2,	-1,  2,	-2,  1
+	};
+
+	struct TiledASTLevel {
+		const uint8_t*	ptr;
+		size_t			stride;
+		size_t			width;
+		size_t			height;
+		float			scale;
+	};
+
+	struct TiledASTJob {
+		size_t			octave;
+		size_t			x0, y0, x1, y1;
+	};
+
+	/* per cell thresholds of the adaptive mode, threshold is 0 if disabled */
+	struct TiledASTAdaptive {
+		const uint8_t*	threshold;
+		size_t			cellWidth;
+		size_t			cellHeight;
+		size_t			cellsX;
+		size_t			cellsY;
+	};
+
+	/* bounded heap of the best features of a cell, the worst feature is on top */
+	struct TiledASTCell {
+		size_t					index;
+		std::vector<Feature>	heap;
+	};
+
+	static inline void _tiledASTInsert( std::vector<Feature>& heap, const Feature& f, size_t bound )
+	{
+		FeatureSet::CmpBest cmp;
+		if( !bound || heap.size() < bound ) {
+			heap.push_back( f );
+			if( bound )
+				std::push_heap( heap.begin(), heap.end(), cmp );
+		} else if( cmp( f, heap.front() ) ) {
+			std::pop_heap( heap.begin(), heap.end(), cmp );
+			heap.back() = f;
+			std::push_heap( heap.begin(), heap.end(), cmp );
+		}
+	}
+
+	static bool _tiledASTCmpPos( const Feature& f1, const Feature& f2 )
+	{
+		if( f1.pt.y != f2.pt.y )
+			return f1.pt.y < f2.pt.y;
+		if( f1.pt.x != f2.pt.x )
+			return f1.pt.x < f2.pt.x;
+		return f1.octave < f2.octave;
+	}
+
+	class TiledASTTiles
+	{
+		public:
+			TiledASTTiles( std::vector<std::vector<TiledASTCell> >& out, std::vector<size_t>& counts, const std::vector<TiledASTJob>& jobs,
+						   const std::vector<TiledASTLevel>& levels, const int* circle, size_t circleSize, size_t arc, uint8_t threshold,
+						   size_t border, size_t radius, size_t cellWidth, size_t cellHeight, size_t cellsX, size_t bound,
+						   const TiledASTAdaptive& adaptive ) :
+				_out( out ), _counts( counts ), _jobs( jobs ), _levels( levels ), _circle( circle ), _circleSize( circleSize ), _arc( arc ),
+				_threshold( threshold ), _border( border ), _radius( radius ), _cellWidth( cellWidth ), _cellHeight( cellHeight ),
+				_cellsX( cellsX ), _bound( bound ), _adaptive( adaptive )
+			{
+			}
+
+			void operator()( size_t begin, size_t end ) const
+			{
+				SIMD* simd = SIMD::instance();
+				const size_t bwidth = TILEDAST_TILE_WIDTH + 2 * _radius;
+				ScopedBuffer<uint8_t, true> buffer( bwidth * ( TILEDAST_TILE_HEIGHT + 2 * _radius ) );
+				int offsets[ 16 ];
+
+				for( size_t j = begin; j < end; j++ ) {
+					const TiledASTJob& job = _jobs[ j ];
+					const TiledASTLevel& level = _levels[ job.octave ];
+					std::vector<TiledASTCell>& cells = _out[ j ];
+					uint8_t* strength = buffer.ptr();
+
+					for( size_t i = 0; i < _circleSize; i++ )
+						offsets[ i ] = _circle[ 2 * i ] + _circle[ 2 * i + 1 ] * ( int ) level.stride;
+
+					/* strengths of the tile and the suppression halo, zero outside of the valid area */
+					const int r = _radius;
+					const int bx = ( int ) job.x0 - r;
+					const int by = ( int ) job.y0 - r;
+					const size_t bh = job.y1 - job.y0 + 2 * r;
+					const int xs = Math::max<int>( bx, _border );
+					const int xe = Math::min<int>( job.x1 + r, level.width - _border );
+					const int ys = Math::max<int>( by, _border );
+					const int ye = Math::min<int>( job.y1 + r, level.height - _border );
+
+					memset( strength, 0, bwidth * bh );
+					for( int y = ys; y < ye; y++ ) {
+						uint8_t* row = strength + ( y - by ) * bwidth + ( xs - bx );
+						simd->astStrength_u8( row, level.ptr + y * level.stride + xs, offsets, _circleSize, _arc, _threshold, xe - xs );
+						if( _adaptive.threshold )
+							_cellThreshold( row, xs, y, xe - xs, level.scale );
+					}
+
+					for( size_t y = job.y0; y < job.y1; y++ ) {
+						const uint8_t* s = strength + ( y - by ) * bwidth + ( job.x0 - bx );
+						for( size_t x = job.x0; x < job.x1; x++, s++ ) {
+							if( !*s || !_isMaximum( s, bwidth ) )
+								continue;
+
+							Feature f( x * level.scale, y * level.scale, 0.0f, job.octave, ( float ) ( *s - 1 ) );
+							if( _adaptive.threshold )
+								_counts[ j * _adaptive.cellsX * _adaptive.cellsY + _adaptiveCell( f.pt.x, f.pt.y ) ]++;
+
+							size_t cell = 0;
+							if( _cellsX )
+								cell = ( ( size_t ) f.pt.y / _cellHeight ) * _cellsX + ( size_t ) f.pt.x / _cellWidth;
+							_tiledASTInsert( _cell( cells, cell ), f, _bound );
+						}
+					}
+				}
+			}
+
+		private:
+			/* remove the strengths not above the threshold of their adaptive cell */
+			void _cellThreshold( uint8_t* row, size_t x0, size_t y, size_t n, float scale ) const
+			{
+				for( size_t i = 0; i < n; i++ ) {
+					if( row[ i ] && row[ i ] <= _adaptive.threshold[ _adaptiveCell( ( x0 + i ) * scale, y * scale ) ] )
+						row[ i ] = 0;
+				}
+			}
+
+			size_t _adaptiveCell( float x, float y ) const
+			{
+				size_t cx = Math::min<size_t>( ( size_t ) x / _adaptive.cellWidth, _adaptive.cellsX - 1 );
+				size_t cy = Math::min<size_t>( ( size_t ) y / _adaptive.cellHeight, _adaptive.cellsY - 1 );
+				return cy * _adaptive.cellsX + cx;
+			}
+
+			/* no strength in the ( 2 radius + 1 )^2 neighbourhood is larger */
+			bool _isMaximum( const uint8_t* s, size_t stride ) const
+			{
+				const int r = _radius;
+				const uint8_t v = *s;
+				for( int dy = -r; dy <= r; dy++ ) {
+					const uint8_t* row = s + dy * ( ssize_t ) stride;
+					for( int dx = -r; dx <= r; dx++ ) {
+						if( row[ dx ] > v )
+							return false;
+					}
+				}
+				return true;
+			}
+
+			std::vector<Feature>& _cell( std::vector<TiledASTCell>& cells, size_t index ) const
+			{
+				for( size_t i = 0; i < cells.size(); i++ ) {
+					if( cells[ i ].index == index )
+						return cells[ i ].heap;
+				}
+				cells.push_back( TiledASTCell() );
+				cells.back().index = index;
+				return cells.back().heap;
+			}
+
+			std::vector<std::vector<TiledASTCell> >& _out;
+			std::vector<size_t>&				_counts;
+			const std::vector<TiledASTJob>&		_jobs;
+			const std::vector<TiledASTLevel>&	_levels;
+			const int*	_circle;
+			size_t		_circleSize;
+			size_t		_arc;
+			uint8_t		_threshold;
+			size_t		_border;
+			size_t		_radius;
+			size_t		_cellWidth;
+			size_t		_cellHeight;
+			size_t		_cellsX;
+			size_t		_bound;
+			const TiledASTAdaptive&	_adaptive;
+	};
+
+	TiledAST::TiledAST( Pattern pattern, uint8_t threshold, size_t border ) :
+		_threshold( threshold ),
+		_nmsRadius( 1 ),
+		_cellsX( 0 ),
+		_cellsY( 0 ),
+		_featuresPerCell( 0 ),
+		_maxFeatures( 0 ),
+		_adaptiveFeatures( 0 ),
+		_adaptiveCellsX( 0 ),
+		_adaptiveCellsY( 0 ),
+		_adaptiveMin( 5 ),
+		_adaptiveMax( 200 )
+	{
+		setBorder( border );
+		setPattern( pattern );
+	}
+
+	void TiledAST::setPattern( Pattern pattern )
+	{
+		const int* circle;
+		switch( pattern ) {
+			case FAST_9:
+			case FAST_10:
+			case FAST_11:
+			case FAST_12:
+				circle = _fastCircle;
+				_circleSize = 16;
+				_arc = 9 + ( pattern - FAST_9 );
+				break;
+			case OAST_9_16:
+				circle = _fastCircle;
+				_circleSize = 16;
+				_arc = 9;
+				break;
+			case AGAST_5_8:
+				circle = _agast5_8Circle;
+				_circleSize = 8;
+				_arc = 5;
+				break;
+			case AGAST_7_12d:
+				circle = _agast7_12dCircle;
+				_circleSize = 12;
+				_arc = 7;
+				break;
+			case AGAST_7_12s:
+				circle = _agast7_12sCircle;
+				_circleSize = 12;
+				_arc = 7;
+				break;
+			default:
+				throw CVTException( "Unknown segment test pattern" );
+		}
+		_pattern = pattern;
+		memcpy( _circle, circle, sizeof( int ) * 2 * _circleSize );
+	}
+
+	void TiledAST::setAdaptiveThreshold( size_t features, size_t cellsX, size_t cellsY )
+	{
+		if( features && ( !cellsX || !cellsY ) )
+			throw CVTException( "Adaptive threshold needs at least one cell" );
+		_adaptiveFeatures = features;
+		_adaptiveCellsX = cellsX;
+		_adaptiveCellsY = cellsY;
+		resetAdaptiveThreshold();
+	}
+
+	void TiledAST::setAdaptiveRange( uint8_t minThreshold, uint8_t maxThreshold )
+	{
+		if( !minThreshold || minThreshold > maxThreshold )
+			throw CVTException( "Invalid adaptive threshold range" );
+		_adaptiveMin = minThreshold;
+		_adaptiveMax = maxThreshold;
+		for( size_t i = 0; i < _cellThresholds.size(); i++ )
+			_cellThresholds[ i ] = Math::clamp( _cellThresholds[ i ], _adaptiveMin, _adaptiveMax );
+	}
+
+	void TiledAST::resetAdaptiveThreshold()
+	{
+		if( _adaptiveFeatures )
+			_cellThresholds.assign( _adaptiveCellsX * _adaptiveCellsY, Math::clamp( _threshold, _adaptiveMin, _adaptiveMax ) );
+		else
+			_cellThresholds.clear();
+	}
+
+	void TiledAST::updateAdaptiveThreshold( const std::vector<size_t>& counts )
+	{
+		/* step proportional to the log of the count ratio, with a dead band of +-25% around the target */
+		const float target = ( float ) _adaptiveFeatures / ( float ) _cellThresholds.size();
+		for( size_t c = 0; c < _cellThresholds.size(); c++ ) {
+			float ratio = ( counts[ c ] + 1.0f ) / ( target + 1.0f );
+			if( ratio < 1.25f && ratio > 0.8f )
+				continue;
+
+			float t = _cellThresholds[ c ];
+			float step = Math::clamp( t * 0.25f * Math::log2( ratio ), -0.5f * t, 0.5f * t );
+			if( Math::abs( step ) < 1.0f )
+				step = ratio > 1.0f ? 1.0f : -1.0f;
+			_cellThresholds[ c ] = ( uint8_t ) Math::clamp( t + step, ( float ) _adaptiveMin, ( float ) _adaptiveMax );
+		}
+	}
+
+	void TiledAST::detect( FeatureSet& features, const Image& img )
+	{
+		std::vector<const Image*> images( 1, &img );
+		detect( features, images, 1.0f );
+	}
+
+	void TiledAST::detect( FeatureSet& features, const ImagePyramid& pyr )
+	{
+		std::vector<const Image*> images( pyr.octaves() );
+		for( size_t o = 0; o < pyr.octaves(); o++ )
+			images[ o ] = &pyr[ o ];
+		detect( features, images, pyr.scaleFactor() );
+	}
+
+	void TiledAST::detect( FeatureSet& features, const std::vector<const Image*>& images, float scaleFactor )
+	{
+		for( size_t o = 0; o < images.size(); o++ ) {
+			if( images[ o ]->format() != IFormat::GRAY_UINT8 )
+				throw CVTException( "Input Image format must be GRAY_UINT8" );
+		}
+
+		/* the cell layout of GridFilter */
+		const bool grid = _cellsX && _cellsY;
+		const size_t cellWidth  = grid ? ( size_t ) Math::ceil( ( float ) images[ 0 ]->width() / _cellsX ) : 1;
+		const size_t cellHeight = grid ? ( size_t ) Math::ceil( ( float ) images[ 0 ]->height() / _cellsY ) : 1;
+		const size_t bound = grid ? _featuresPerCell : _maxFeatures;
+
+		/* the kernel runs with the lowest cell threshold, the cells are applied on the strengths */
+		TiledASTAdaptive adaptive;
+		uint8_t threshold = _threshold;
+		adaptive.threshold = 0;
+		adaptive.cellsX = adaptive.cellsY = 1;
+		if( _adaptiveFeatures ) {
+			adaptive.threshold = &_cellThresholds[ 0 ];
+			adaptive.cellsX = _adaptiveCellsX;
+			adaptive.cellsY = _adaptiveCellsY;
+			threshold = *std::min_element( _cellThresholds.begin(), _cellThresholds.end() );
+		}
+		adaptive.cellWidth  = Math::max<size_t>( Math::ceil( ( float ) images[ 0 ]->width() / adaptive.cellsX ), 1 );
+		adaptive.cellHeight = Math::max<size_t>( Math::ceil( ( float ) images[ 0 ]->height() / adaptive.cellsY ), 1 );
+
+		std::vector<IMapScoped<const uint8_t>*> maps( images.size() );
+		std::vector<TiledASTLevel> levels( images.size() );
+		std::vector<TiledASTJob> jobs;
+		for( size_t o = 0; o < images.size(); o++ ) {
+			maps[ o ] = new IMapScoped<const uint8_t>( *images[ o ] );
+			levels[ o ].ptr    = maps[ o ]->ptr();
+			levels[ o ].stride = maps[ o ]->stride();
+			levels[ o ].width  = images[ o ]->width();
+			levels[ o ].height = images[ o ]->height();
+			levels[ o ].scale  = Math::pow( scaleFactor, -( float ) o );
+
+			if( levels[ o ].width <= 2 * _border || levels[ o ].height <= 2 * _border )
+				continue;
+
+			TiledASTJob job;
+			job.octave = o;
+			for( job.y0 = _border; job.y0 < levels[ o ].height - _border; job.y0 += TILEDAST_TILE_HEIGHT ) {
+				job.y1 = Math::min<size_t>( job.y0 + TILEDAST_TILE_HEIGHT, levels[ o ].height - _border );
+				for( job.x0 = _border; job.x0 < levels[ o ].width - _border; job.x0 += TILEDAST_TILE_WIDTH ) {
+					job.x1 = Math::min<size_t>( job.x0 + TILEDAST_TILE_WIDTH, levels[ o ].width - _border );
+					jobs.push_back( job );
+				}
+			}
+		}
+
+		const size_t ncells = adaptive.cellsX * adaptive.cellsY;
+		std::vector<std::vector<TiledASTCell> > tileCells( jobs.size() );
+		std::vector<size_t> tileCounts( _adaptiveFeatures ? jobs.size() * ncells : 0, 0 );
+		TiledASTTiles tiles( tileCells, tileCounts, jobs, levels, _circle, _circleSize, _arc, threshold, _border, _nmsRadius,
+							 cellWidth, cellHeight, grid ? _cellsX : 0, bound, adaptive );
+		ParallelFor::run( tiles, 0, jobs.size() );
+
+		for( size_t o = 0; o < maps.size(); o++ )
+			delete maps[ o ];
+
+		/* adapt the cell thresholds for the next frame to the detections before the quotas */
+		if( _adaptiveFeatures ) {
+			std::vector<size_t> counts( ncells, 0 );
+			for( size_t j = 0; j < jobs.size(); j++ )
+				for( size_t c = 0; c < ncells; c++ )
+					counts[ c ] += tileCounts[ j * ncells + c ];
+			updateAdaptiveThreshold( counts );
+		}
+
+		/* merge the bounded heaps of the tiles per cell */
+		FeatureSet::CmpBest cmp;
+		std::vector<std::vector<Feature> > cells( grid ? _cellsX * _cellsY : 1 );
+		for( size_t t = 0; t < tileCells.size(); t++ ) {
+			for( size_t c = 0; c < tileCells[ t ].size(); c++ ) {
+				const TiledASTCell& cell = tileCells[ t ][ c ];
+				for( size_t i = 0; i < cell.heap.size(); i++ )
+					_tiledASTInsert( cells[ cell.index ], cell.heap[ i ], bound );
+			}
+		}
+
+		std::vector<Feature> result;
+		for( size_t c = 0; c < cells.size(); c++ )
+			result.insert( result.end(), cells[ c ].begin(), cells[ c ].end() );
+
+		if( grid && _maxFeatures && result.size() > _maxFeatures ) {
+			std::nth_element( result.begin(), result.begin() + _maxFeatures, result.end(), cmp );
+			result.resize( _maxFeatures );
+		}
+
+		std::sort( result.begin(), result.end(), _tiledASTCmpPos );
+		for( size_t i = 0; i < result.size(); i++ )
+			features.add( result[ i ] );
+	}
+}
@@ -0,0 +1,148 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_TILEDAST_H
+#define CVT_TILEDAST_H
+
+#include <cvt/vision/features/FeatureDetector.h>
+#include <cvt/math/Math.h>
+#include <cvt/util/Exception.h>
+
+#include <vector>
+
+namespace cvt
+{
+	/**
+	  @brief Tile parallel accelerated segment test ( FAST / AGAST ) corner detector with built-in filtering.
+
+	  The image, or every octave of a pyramid, is split into tiles which are processed in parallel. Each tile
+	  computes the segment test strengths with the SIMD kernel, applies the non-maximum suppression on the strengths
+	  and keeps the best features of every grid cell in bounded heaps. The result for an image equals
+	  FAST / AGAST detection followed by FeatureSet::filterNMS, FeatureSet::filterGrid and FeatureSet::filterBest
+	  with the same parameters, sorted by position. For pyramids the non-maximum suppression is done within the octaves.
+	 */
+	class TiledAST : public FeatureDetector
+	{
+		public:
+			enum Pattern {
+				FAST_9,
+				FAST_10,
+				FAST_11,
+				FAST_12,
+				AGAST_5_8,
+				AGAST_7_12d,
+				AGAST_7_12s,
+				OAST_9_16
+			};
+
+			TiledAST( Pattern pattern = FAST_9, uint8_t threshold = 30, size_t border = 3 );
+			~TiledAST();
+
+			void detect( FeatureSet& features, const Image& image );
+			void detect( FeatureSet& features, const ImagePyramid& image );
+
+			void setPattern( Pattern pattern );
+			Pattern pattern() const					{ return _pattern; }
+
+			/* threshold of the segment test, also the start value of the adaptive cell thresholds */
+			void setThreshold( uint8_t threshold )	{ _threshold = threshold; }
+			uint8_t threshold() const				{ return _threshold; }
+
+			void setBorder( size_t border )			{ _border = Math::max<size_t>( border, 3 ); }
+			size_t border() const					{ return _border; }
+
+			/* radius of the non-maximum suppression, 0 disables it */
+			void setNMSRadius( size_t radius )		{ _nmsRadius = radius; }
+			size_t nmsRadius() const				{ return _nmsRadius; }
+
+			/**
+			  Keep only the best featuresPerCell features in each of the cellsX x cellsY cells spanned over
+			  the ( first octave ) image, cellsX or cellsY 0 disables the grid.
+			 */
+			void setGrid( size_t cellsX, size_t cellsY, size_t featuresPerCell );
+			size_t gridCellsX() const				{ return _cellsX; }
+			size_t gridCellsY() const				{ return _cellsY; }
+			size_t featuresPerCell() const			{ return _featuresPerCell; }
+
+			/* keep only the best n features ( after the grid ), 0 keeps all */
+			void setMaxFeatures( size_t n )			{ _maxFeatures = n; }
+			size_t maxFeatures() const				{ return _maxFeatures; }
+
+			/**
+			  Adaptive threshold mode: the ( first octave ) image is divided into cellsX x cellsY cells with
+			  their own threshold. After every detection each cell threshold is moved towards the value yielding
+			  features / ( cellsX * cellsY ) detections ( after the non-maximum suppression, before grid and best-N
+			  filtering ) in the cell, so the next frame adapts without detecting again.
+			  features 0 disables the mode, setting it resets all cells to threshold().
+			 */
+			void setAdaptiveThreshold( size_t features, size_t cellsX = 8, size_t cellsY = 6 );
+			size_t adaptiveFeatures() const			{ return _adaptiveFeatures; }
+			void resetAdaptiveThreshold();
+
+			/* range of the adaptive cell thresholds, default [ 5, 200 ] */
+			void setAdaptiveRange( uint8_t minThreshold, uint8_t maxThreshold );
+
+			/* current threshold of the adaptive cell ( x, y ) */
+			uint8_t cellThreshold( size_t x, size_t y ) const	{ return _cellThresholds[ y * _adaptiveCellsX + x ]; }
+
+		private:
+			void detect( FeatureSet& features, const std::vector<const Image*>& images, float scaleFactor );
+			void updateAdaptiveThreshold( const std::vector<size_t>& counts );
+
+			Pattern		_pattern;
+			uint8_t		_threshold;
+			size_t		_border;
+			size_t		_nmsRadius;
+			size_t		_cellsX;
+			size_t		_cellsY;
+			size_t		_featuresPerCell;
+			size_t		_maxFeatures;
+
+			size_t		_adaptiveFeatures;
+			size_t		_adaptiveCellsX;
+			size_t		_adaptiveCellsY;
+			uint8_t		_adaptiveMin;
+			uint8_t		_adaptiveMax;
+			std::vector<uint8_t> _cellThresholds;
+
+			/* circle of the pattern as ( dx, dy ) pairs */
+			int			_circle[ 32 ];
+			size_t		_circleSize;
+			size_t		_arc;
+	};
+
+	inline TiledAST::~TiledAST()
+	{
+	}
+
+	inline void TiledAST::setGrid( size_t cellsX, size_t cellsY, size_t featuresPerCell )
+	{
+		_cellsX = cellsX;
+		_cellsY = cellsY;
+		_featuresPerCell = featuresPerCell;
+	}
+}
+
+#endif
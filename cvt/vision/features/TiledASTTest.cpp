@@ -0,0 +1,352 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/features/TiledAST.h>
+#include <cvt/vision/features/FAST.h>
+#include <cvt/vision/features/AGAST.h>
+#include <cvt/gfx/IMapScoped.h>
+#include <cvt/util/CVTTest.h>
+#include <cvt/util/CVTTestUtil.h>
+#include <cvt/util/SIMD.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace cvt {
+
+	/* rectangles of random intensity with some noise */
+	static void _tastImage( Image& img, size_t w, size_t h )
+	{
+		img.reallocate( w, h, IFormat::GRAY_UINT8 );
+		std::vector<float> v( w * h, 128.0f );
+		for( size_t r = 0; r < 300; r++ ) {
+			size_t x0 = Math::rand( 0.0f, w - 1.0f ), y0 = Math::rand( 0.0f, h - 1.0f );
+			size_t x1 = Math::min<size_t>( w, x0 + Math::rand( 4.0f, 60.0f ) );
+			size_t y1 = Math::min<size_t>( h, y0 + Math::rand( 4.0f, 60.0f ) );
+			float c = Math::rand( 0.0f, 255.0f );
+			for( size_t y = y0; y < y1; y++ )
+				for( size_t x = x0; x < x1; x++ )
+					v[ y * w + x ] = c;
+		}
+		IMapScoped<uint8_t> map( img );
+		for( size_t y = 0; y < h; y++ ) {
+			uint8_t* p = map.ptr();
+			for( size_t x = 0; x < w; x++ )
+				p[ x ] = Math::clamp( v[ y * w + x ] + Math::rand( -6.0f, 6.0f ), 0.0f, 255.0f );
+			map++;
+		}
+	}
+
+	static bool _tastCmp( const Feature& f1, const Feature& f2 )
+	{
+		if( f1.pt.y != f2.pt.y )
+			return f1.pt.y < f2.pt.y;
+		if( f1.pt.x != f2.pt.x )
+			return f1.pt.x < f2.pt.x;
+		return f1.octave < f2.octave;
+	}
+
+	static bool _tastEqual( const FeatureSet& a, const FeatureSet& b )
+	{
+		std::vector<Feature> fa( a.begin(), a.end() ), fb( b.begin(), b.end() );
+		std::sort( fa.begin(), fa.end(), _tastCmp );
+		std::sort( fb.begin(), fb.end(), _tastCmp );
+		if( fa.size() != fb.size() )
+			return false;
+		for( size_t i = 0; i < fa.size(); i++ ) {
+			if( fa[ i ].pt != fb[ i ].pt || fa[ i ].score != fb[ i ].score || fa[ i ].octave != fb[ i ].octave )
+				return false;
+		}
+		return true;
+	}
+
+	struct TiledASTDetect {
+		TiledASTDetect( TiledAST& t, const Image& i ) : tast( t ), img( i ) {}
+		void operator()( FeatureSet& fs ) const { tast.detect( fs, img ); }
+		TiledAST&		tast;
+		const Image&	img;
+	};
+
+	static bool _tastKernel()
+	{
+		SIMD* base = SIMD::get( SIMD_BASE );
+		SIMD* sse2 = SIMD::get( SIMD_SSE2 );
+		SIMD* best = SIMD::get( SIMD::bestSupportedType() );
+		bool ret = true;
+
+		Image img;
+		_tastImage( img, 100, 20 );
+		IMapScoped<const uint8_t> map( img );
+		const uint8_t* row = map.ptr() + 10 * map.stride() + 3;
+
+		/* FAST circle and AGAST 5_8 circle */
+		int fast[ 16 ], agast[ 8 ];
+		const int fx[ 16 ] = { 0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2, -1 };
+		const int fy[ 16 ] = { 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2, -1, 0, 1, 2, 3 };
+		const int ax[ 8 ] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+		const int ay[ 8 ] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+		for( size_t i = 0; i < 16; i++ )
+			fast[ i ] = fx[ i ] + fy[ i ] * ( int ) map.stride();
+		for( size_t i = 0; i < 8; i++ )
+			agast[ i ] = ax[ i ] + ay[ i ] * ( int ) map.stride();
+
+		for( size_t n = 1; n < 94; n += 7 ) {
+			for( size_t arc = 9; arc <= 12; arc++ ) {
+				std::vector<uint8_t> d1( n ), d2( n ), d3( n );
+				base->astStrength_u8( &d1[ 0 ], row, fast, 16, arc, 10, n );
+				sse2->astStrength_u8( &d2[ 0 ], row, fast, 16, arc, 10, n );
+				best->astStrength_u8( &d3[ 0 ], row, fast, 16, arc, 10, n );
+				ret &= d1 == d2 && d1 == d3;
+			}
+			std::vector<uint8_t> d1( n ), d2( n ), d3( n );
+			base->astStrength_u8( &d1[ 0 ], row, agast, 8, 5, 0, n );
+			sse2->astStrength_u8( &d2[ 0 ], row, agast, 8, 5, 0, n );
+			best->astStrength_u8( &d3[ 0 ], row, agast, 8, 5, 0, n );
+			ret &= d1 == d2 && d1 == d3;
+		}
+
+		delete base;
+		delete sse2;
+		delete best;
+		return ret;
+	}
+
+	/* plain segment test on the FAST circle: arc contiguous pixels brighter than c + t or darker than c - t */
+	static bool _tastSegment( const uint8_t* p, const int* offsets, size_t arc, int t )
+	{
+		for( size_t k = 0; k < 16; k++ ) {
+			size_t nb = 0, nd = 0;
+			for( size_t j = 0; j < arc; j++ ) {
+				int v = p[ offsets[ ( k + j ) & 15 ] ];
+				nb += v > *p + t;
+				nd += v < *p - t;
+			}
+			if( nb == arc || nd == arc )
+				return true;
+		}
+		return false;
+	}
+
+	/* brute force reference detector, the score is the largest threshold the pixel still passes */
+	static void _tastReference( FeatureSet& fs, const Image& img, size_t arc, int threshold, size_t border )
+	{
+		IMapScoped<const uint8_t> map( img );
+		const int fx[ 16 ] = { 0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2, -1 };
+		const int fy[ 16 ] = { 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2, -1, 0, 1, 2, 3 };
+		int offsets[ 16 ];
+		for( size_t i = 0; i < 16; i++ )
+			offsets[ i ] = fx[ i ] + fy[ i ] * ( int ) map.stride();
+
+		for( size_t y = border; y < img.height() - border; y++ ) {
+			for( size_t x = border; x < img.width() - border; x++ ) {
+				const uint8_t* p = map.ptr() + y * map.stride() + x;
+				if( !_tastSegment( p, offsets, arc, threshold ) )
+					continue;
+				int t = threshold;
+				while( t < 255 && _tastSegment( p, offsets, arc, t + 1 ) )
+					t++;
+				fs.add( Feature( x, y, 0.0f, 0, t ) );
+			}
+		}
+	}
+
+	/* FAST and TiledAST against the brute force segment test */
+	static bool _tastSegmentTest( const Image& img, FASTSize size, TiledAST::Pattern pattern, size_t arc )
+	{
+		FeatureSet ref, fres, tres;
+		_tastReference( ref, img, arc, 20, 3 );
+
+		FAST fast( size, 20, 3 );
+		fast.detect( fres, img );
+
+		TiledAST tast( pattern, 20, 3 );
+		tast.setNMSRadius( 0 );
+		tast.detect( tres, img );
+		return ref.size() > 0 && _tastEqual( ref, fres ) && _tastEqual( ref, tres );
+	}
+
+	static bool _tastFAST( const Image& img, FASTSize size, TiledAST::Pattern pattern, size_t radius,
+						   size_t cellsX, size_t cellsY, size_t perCell, size_t best )
+	{
+		FeatureSet ref, res;
+		FAST fast( size, 20, 3 );
+		fast.detect( ref, img );
+		if( radius )
+			ref.filterNMS( radius, true );
+		if( cellsX )
+			ref.filterGrid( img.width(), img.height(), cellsX, cellsY, perCell );
+		if( best )
+			ref.filterBest( best, true );
+
+		TiledAST tast( pattern, 20, 3 );
+		tast.setNMSRadius( radius );
+		tast.setGrid( cellsX, cellsY, perCell );
+		tast.setMaxFeatures( best );
+		tast.detect( res, img );
+
+		/* independent of the number of threads */
+		return ref.size() > 0 && _tastEqual( ref, res ) &&
+			   testThreadInvariance<FeatureSet>( TiledASTDetect( tast, img ), _tastEqual );
+	}
+
+	/* the AGAST detectors also test the column width - border */
+	static bool _tastAGAST( const Image& img, AGAST::ASTType type, TiledAST::Pattern pattern )
+	{
+		FeatureSet ref, all, res;
+		AGAST agast( type, 20, 4 );
+		agast.detect( all, img );
+		for( size_t i = 0; i < all.size(); i++ ) {
+			if( all[ i ].pt.x < img.width() - 4 )
+				ref.add( all[ i ] );
+		}
+
+		TiledAST tast( pattern, 20, 4 );
+		tast.setNMSRadius( 0 );
+		tast.detect( res, img );
+		return ref.size() > 0 && _tastEqual( ref, res );
+	}
+
+	static bool _tastPyramid( const Image& img )
+	{
+		ImagePyramid pyr( 3, 0.5f );
+		pyr.update( img );
+
+		FeatureSet ref, res;
+		FAST fast( SEGMENT_9, 20, 3 );
+		fast.detect( ref, pyr );
+
+		TiledAST tast( TiledAST::FAST_9, 20, 3 );
+		tast.setNMSRadius( 0 );
+		tast.detect( res, pyr );
+		return ref.size() > 0 && _tastEqual( ref, res );
+	}
+
+	/* the cell thresholds converge to the target count and recover after a contrast change */
+	static bool _tastAdaptive( const Image& img )
+	{
+		const size_t target = 600;
+		TiledAST tast( TiledAST::FAST_9, 20, 3 );
+		tast.setAdaptiveThreshold( target, 4, 3 );
+		tast.setGrid( 4, 3, 30 );
+
+		bool ret = true;
+		FeatureSet fs;
+		for( size_t i = 0; i < 30; i++ ) {
+			fs.clear();
+			tast.detect( fs, img );
+		}
+		/* the output respects the quotas */
+		ret &= fs.size() <= 4 * 3 * 30;
+
+		/* count without the quotas with the adapted thresholds */
+		tast.setGrid( 0, 0, 0 );
+		fs.clear();
+		tast.detect( fs, img );
+		ret &= Math::abs( ( float ) fs.size() - ( float ) target ) < 0.35f * target;
+
+		/* low contrast version of the image */
+		Image dim( img );
+		{
+			IMapScoped<uint8_t> map( dim );
+			for( size_t y = 0; y < dim.height(); y++ ) {
+				uint8_t* p = map.ptr();
+				for( size_t x = 0; x < dim.width(); x++ )
+					p[ x ] = 64 + p[ x ] / 3;
+				map++;
+			}
+		}
+
+		size_t first = 0;
+		for( size_t i = 0; i < 30; i++ ) {
+			fs.clear();
+			tast.detect( fs, dim );
+			if( !i )
+				first = fs.size();
+		}
+		ret &= first < 0.5f * target;
+		ret &= Math::abs( ( float ) fs.size() - ( float ) target ) < 0.35f * target;
+
+		for( size_t y = 0; y < 3; y++ )
+			for( size_t x = 0; x < 4; x++ )
+				ret &= tast.cellThreshold( x, y ) >= 5 && tast.cellThreshold( x, y ) <= 200;
+		return ret;
+	}
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( TiledAST )
+
+bool result = true;
+bool b;
+
+b = _tastKernel();
+CVTTEST_PRINT( "astStrength_u8", b );
+result &= b;
+
+Image img;
+_tastImage( img, 643, 481 );
+
+b = _tastSegmentTest( img, SEGMENT_9, TiledAST::FAST_9, 9 );
+b &= _tastSegmentTest( img, SEGMENT_10, TiledAST::FAST_10, 10 );
+b &= _tastSegmentTest( img, SEGMENT_11, TiledAST::FAST_11, 11 );
+b &= _tastSegmentTest( img, SEGMENT_12, TiledAST::FAST_12, 12 );
+CVTTEST_PRINT( "FAST 9 - 12", b );
+result &= b;
+
+b = _tastFAST( img, SEGMENT_9, TiledAST::FAST_9, 1, 0, 0, 0, 0 );
+b &= _tastFAST( img, SEGMENT_9, TiledAST::FAST_9, 3, 0, 0, 0, 0 );
+CVTTEST_PRINT( "NMS", b );
+result &= b;
+
+b = _tastFAST( img, SEGMENT_9, TiledAST::FAST_9, 1, 10, 4, 20, 0 );
+b &= _tastFAST( img, SEGMENT_10, TiledAST::FAST_10, 3, 7, 5, 3, 0 );
+CVTTEST_PRINT( "NMS + grid", b );
+result &= b;
+
+b = _tastFAST( img, SEGMENT_9, TiledAST::FAST_9, 1, 0, 0, 0, 200 );
+b &= _tastFAST( img, SEGMENT_9, TiledAST::FAST_9, 1, 10, 4, 20, 150 );
+CVTTEST_PRINT( "NMS + best", b );
+result &= b;
+
+b = _tastAGAST( img, AGAST::AGAST_5_8, TiledAST::AGAST_5_8 );
+b &= _tastAGAST( img, AGAST::AGAST_7_12d, TiledAST::AGAST_7_12d );
+b &= _tastAGAST( img, AGAST::AGAST_7_12s, TiledAST::AGAST_7_12s );
+b &= _tastAGAST( img, AGAST::OAST_9_16, TiledAST::OAST_9_16 );
+CVTTEST_PRINT( "AGAST", b );
+result &= b;
+
+b = _tastAdaptive( img );
+CVTTEST_PRINT( "Adaptive threshold", b );
+result &= b;
+
+b = _tastPyramid( img );
+CVTTEST_PRINT( "Pyramid", b );
+result &= b;
+
+return result;
+
+END_CVTTEST
@@ -3062,6 +3062,6 @@ end_if:
 					return false;
 			else
 				return false;
-		return false;
+		return true;
 	}
 }
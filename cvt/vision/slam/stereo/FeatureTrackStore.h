@@ -0,0 +1,440 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#ifndef CVT_FEATURE_TRACK_STORE_H
+#define CVT_FEATURE_TRACK_STORE_H
+
+#include <map>
+#include <vector>
+#include <cvt/vision/features/FeatureDescriptor.h>
+#include <cvt/math/Math.h>
+#include <cvt/math/Vector.h>
+#include <cvt/util/Exception.h>
+
+namespace cvt
+{
+	/**
+	 *	\class FeatureTrackStore
+	 *	\brief Storage for feature tracks over multiple frames
+	 *
+	 *	Every track occupies a slot and all track properties are stored column wise
+	 *	(structure of arrays) indexed by the slot. Removed slots are put on a free list
+	 *	and reused by later tracks, so the memory is bounded by the maximum number of
+	 *	simultaneously alive tracks.
+	 *
+	 *	Track ids contain the slot index in the lower and a generation counter in the
+	 *	upper 32 bits. The generation of a slot is incremented on removal, so ids of
+	 *	removed tracks stay invalid even if their slot is reused.
+	 *
+	 *	Tracks can be linked to a map point, the store keeps an index from the map point
+	 *	to its track that is updated when the track is removed.
+	 *
+	 *	The store owns the descriptors (cloned on insertion) and the patches.
+	 */
+	template <class PatchT>
+	class FeatureTrackStore
+	{
+		public:
+			typedef uint64_t Id;
+			static const Id		INVALID_ID = ~( ( uint64_t ) 0 );
+			static const size_t NO_MAP_POINT = ( size_t ) -1;
+
+			FeatureTrackStore( size_t historyLength = 8 );
+			~FeatureTrackStore();
+
+			Id							add( const Vector2f& pos, const FeatureDescriptor& desc, PatchT* patch, size_t mapPoint = NO_MAP_POINT );
+			void						remove( Id id );
+			bool						isValid( Id id ) const;
+			void						clear();
+
+			/* number of alive tracks */
+			size_t						size() const { return _size; }
+			/* number of allocated slots */
+			size_t						capacity() const { return _generation.size(); }
+			size_t						historyLength() const { return _historyLength; }
+
+			/* current frame counter */
+			size_t						frame() const { return _frame; }
+			void						nextFrame() { _frame++; }
+
+			void						observe( Id id, const Vector2f& pos, float quality );
+
+			const Vector2f&				position( Id id ) const;
+			size_t						history( std::vector<Vector2f>& positions, Id id ) const;
+			size_t						age( Id id ) const;
+			size_t						lastSeen( Id id ) const;
+			float						quality( Id id ) const;
+			size_t						mapPoint( Id id ) const;
+			void						setMapPoint( Id id, size_t mapPoint );
+			Id							trackForMapPoint( size_t mapPoint ) const;
+			const FeatureDescriptor&	descriptor( Id id ) const;
+			void						setDescriptor( Id id, const FeatureDescriptor& desc );
+			PatchT*						patch( Id id ) const;
+			void						setPatch( Id id, PatchT* patch );
+
+			/* batch access */
+			void						ids( std::vector<Id>& ids ) const;
+			void						gather( std::vector<FeatureDescriptor*>& descriptors,
+												std::vector<PatchT*>& patches,
+												const std::vector<Id>& ids ) const;
+			void						gatherPositions( std::vector<Vector2f>& positions, const std::vector<Id>& ids ) const;
+			void						scatter( const std::vector<Id>& ids,
+												 const std::vector<Vector2f>& positions,
+												 const std::vector<float>& quality );
+
+			size_t						removeUnseen( size_t maxFrames );
+
+		private:
+			FeatureTrackStore( const FeatureTrackStore& );
+			FeatureTrackStore& operator=( const FeatureTrackStore& );
+
+			static uint32_t				slotOf( Id id ) { return ( uint32_t ) id; }
+			static uint32_t				generationOf( Id id ) { return ( uint32_t ) ( id >> 32 ); }
+			static Id					makeId( uint32_t slot, uint32_t generation ) { return ( ( Id ) generation << 32 ) | slot; }
+
+			size_t						checkedSlot( Id id ) const;
+			void						releaseSlot( size_t slot );
+			void						unlinkMapPoint( size_t slot );
+
+			size_t						_historyLength;
+			size_t						_size;
+			size_t						_frame;
+
+			/* columns, indexed by the slot */
+			std::vector<uint32_t>			_generation;
+			std::vector<uint8_t>			_alive;
+			std::vector<Vector2f>			_history;		/* _historyLength positions per slot */
+			std::vector<uint32_t>			_observations;
+			std::vector<uint32_t>			_firstFrame;
+			std::vector<uint32_t>			_lastFrame;
+			std::vector<float>				_quality;
+			std::vector<size_t>				_mapPoint;
+			std::vector<FeatureDescriptor*>	_descriptors;
+			std::vector<PatchT*>			_patches;
+
+			std::vector<uint32_t>			_free;
+
+			/* track of each linked map point */
+			std::map<size_t, Id>			_mapPointTracks;
+	};
+
+	template <class PatchT>
+	const typename FeatureTrackStore<PatchT>::Id FeatureTrackStore<PatchT>::INVALID_ID;
+
+	template <class PatchT>
+	const size_t FeatureTrackStore<PatchT>::NO_MAP_POINT;
+
+	template <class PatchT>
+	inline FeatureTrackStore<PatchT>::FeatureTrackStore( size_t historyLength ) :
+		_historyLength( Math::max<size_t>( historyLength, 1 ) ),
+		_size( 0 ),
+		_frame( 0 )
+	{
+	}
+
+	template <class PatchT>
+	inline FeatureTrackStore<PatchT>::~FeatureTrackStore()
+	{
+		clear();
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::clear()
+	{
+		for( size_t i = 0; i < _descriptors.size(); i++ ){
+			delete _descriptors[ i ];
+			delete _patches[ i ];
+		}
+
+		_generation.clear();
+		_alive.clear();
+		_history.clear();
+		_observations.clear();
+		_firstFrame.clear();
+		_lastFrame.clear();
+		_quality.clear();
+		_mapPoint.clear();
+		_descriptors.clear();
+		_patches.clear();
+		_free.clear();
+		_mapPointTracks.clear();
+		_size = 0;
+		_frame = 0;
+	}
+
+	template <class PatchT>
+	inline typename FeatureTrackStore<PatchT>::Id FeatureTrackStore<PatchT>::add( const Vector2f& pos, const FeatureDescriptor& desc, PatchT* patch, size_t mapPoint )
+	{
+		size_t slot;
+		if( _free.size() ){
+			slot = _free.back();
+			_free.pop_back();
+		} else {
+			slot = _generation.size();
+			if( slot > 0xffffffff )
+				throw CVTException( "too many feature tracks" );
+			_generation.push_back( 0 );
+			_alive.push_back( 0 );
+			_history.resize( _history.size() + _historyLength );
+			_observations.push_back( 0 );
+			_firstFrame.push_back( 0 );
+			_lastFrame.push_back( 0 );
+			_quality.push_back( 0.0f );
+			_mapPoint.push_back( NO_MAP_POINT );
+			_descriptors.push_back( 0 );
+			_patches.push_back( 0 );
+		}
+
+		_alive[ slot ] = 1;
+		_history[ slot * _historyLength ] = pos;
+		_observations[ slot ] = 1;
+		_firstFrame[ slot ] = _frame;
+		_lastFrame[ slot ] = _frame;
+		_quality[ slot ] = 0.0f;
+		_mapPoint[ slot ] = mapPoint;
+		_descriptors[ slot ] = desc.clone();
+		_patches[ slot ] = patch;
+		_size++;
+
+		Id id = makeId( slot, _generation[ slot ] );
+		if( mapPoint != NO_MAP_POINT )
+			_mapPointTracks[ mapPoint ] = id;
+		return id;
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::unlinkMapPoint( size_t slot )
+	{
+		if( _mapPoint[ slot ] == NO_MAP_POINT )
+			return;
+		typename std::map<size_t, Id>::iterator it = _mapPointTracks.find( _mapPoint[ slot ] );
+		if( it != _mapPointTracks.end() && it->second == makeId( slot, _generation[ slot ] ) )
+			_mapPointTracks.erase( it );
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::releaseSlot( size_t slot )
+	{
+		unlinkMapPoint( slot );
+		delete _descriptors[ slot ];
+		delete _patches[ slot ];
+		_descriptors[ slot ] = 0;
+		_patches[ slot ] = 0;
+		_alive[ slot ] = 0;
+		_generation[ slot ]++;
+		_free.push_back( slot );
+		_size--;
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::remove( Id id )
+	{
+		releaseSlot( checkedSlot( id ) );
+	}
+
+	template <class PatchT>
+	inline bool FeatureTrackStore<PatchT>::isValid( Id id ) const
+	{
+		size_t slot = slotOf( id );
+		return slot < _generation.size() && _alive[ slot ] && _generation[ slot ] == generationOf( id );
+	}
+
+	template <class PatchT>
+	inline size_t FeatureTrackStore<PatchT>::checkedSlot( Id id ) const
+	{
+		if( !isValid( id ) )
+			throw CVTException( "invalid feature track id" );
+		return slotOf( id );
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::observe( Id id, const Vector2f& pos, float quality )
+	{
+		size_t slot = checkedSlot( id );
+		_history[ slot * _historyLength + _observations[ slot ] % _historyLength ] = pos;
+		_observations[ slot ]++;
+		_lastFrame[ slot ] = _frame;
+		_quality[ slot ] = quality;
+	}
+
+	template <class PatchT>
+	inline const Vector2f& FeatureTrackStore<PatchT>::position( Id id ) const
+	{
+		size_t slot = checkedSlot( id );
+		return _history[ slot * _historyLength + ( _observations[ slot ] - 1 ) % _historyLength ];
+	}
+
+	/* stores the last positions of the track, oldest first, and returns their number */
+	template <class PatchT>
+	inline size_t FeatureTrackStore<PatchT>::history( std::vector<Vector2f>& positions, Id id ) const
+	{
+		size_t slot = checkedSlot( id );
+		size_t n = Math::min<size_t>( _observations[ slot ], _historyLength );
+		const Vector2f* hist = &_history[ slot * _historyLength ];
+
+		positions.resize( n );
+		for( size_t i = 0; i < n; i++ )
+			positions[ i ] = hist[ ( _observations[ slot ] - n + i ) % _historyLength ];
+		return n;
+	}
+
+	/* number of frames since the track was created */
+	template <class PatchT>
+	inline size_t FeatureTrackStore<PatchT>::age( Id id ) const
+	{
+		return _frame - _firstFrame[ checkedSlot( id ) ];
+	}
+
+	/* number of frames since the last observation */
+	template <class PatchT>
+	inline size_t FeatureTrackStore<PatchT>::lastSeen( Id id ) const
+	{
+		return _frame - _lastFrame[ checkedSlot( id ) ];
+	}
+
+	template <class PatchT>
+	inline float FeatureTrackStore<PatchT>::quality( Id id ) const
+	{
+		return _quality[ checkedSlot( id ) ];
+	}
+
+	template <class PatchT>
+	inline size_t FeatureTrackStore<PatchT>::mapPoint( Id id ) const
+	{
+		return _mapPoint[ checkedSlot( id ) ];
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::setMapPoint( Id id, size_t mapPoint )
+	{
+		size_t slot = checkedSlot( id );
+		unlinkMapPoint( slot );
+		_mapPoint[ slot ] = mapPoint;
+		if( mapPoint != NO_MAP_POINT )
+			_mapPointTracks[ mapPoint ] = id;
+	}
+
+	/* the track linked to the map point or INVALID_ID */
+	template <class PatchT>
+	inline typename FeatureTrackStore<PatchT>::Id FeatureTrackStore<PatchT>::trackForMapPoint( size_t mapPoint ) const
+	{
+		typename std::map<size_t, Id>::const_iterator it = _mapPointTracks.find( mapPoint );
+		return it == _mapPointTracks.end() ? INVALID_ID : it->second;
+	}
+
+	template <class PatchT>
+	inline const FeatureDescriptor& FeatureTrackStore<PatchT>::descriptor( Id id ) const
+	{
+		return *_descriptors[ checkedSlot( id ) ];
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::setDescriptor( Id id, const FeatureDescriptor& desc )
+	{
+		size_t slot = checkedSlot( id );
+		FeatureDescriptor* d = desc.clone();
+		delete _descriptors[ slot ];
+		_descriptors[ slot ] = d;
+	}
+
+	template <class PatchT>
+	inline PatchT* FeatureTrackStore<PatchT>::patch( Id id ) const
+	{
+		return _patches[ checkedSlot( id ) ];
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::setPatch( Id id, PatchT* patch )
+	{
+		size_t slot = checkedSlot( id );
+		if( _patches[ slot ] != patch )
+			delete _patches[ slot ];
+		_patches[ slot ] = patch;
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::ids( std::vector<Id>& ids ) const
+	{
+		ids.clear();
+		ids.reserve( _size );
+		for( size_t i = 0; i < _alive.size(); i++ ){
+			if( _alive[ i ] )
+				ids.push_back( makeId( i, _generation[ i ] ) );
+		}
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::gather( std::vector<FeatureDescriptor*>& descriptors,
+												   std::vector<PatchT*>& patches,
+												   const std::vector<Id>& ids ) const
+	{
+		descriptors.resize( ids.size() );
+		patches.resize( ids.size() );
+		for( size_t i = 0; i < ids.size(); i++ ){
+			size_t slot = checkedSlot( ids[ i ] );
+			descriptors[ i ] = _descriptors[ slot ];
+			patches[ i ] = _patches[ slot ];
+		}
+	}
+
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::gatherPositions( std::vector<Vector2f>& positions, const std::vector<Id>& ids ) const
+	{
+		positions.resize( ids.size() );
+		for( size_t i = 0; i < ids.size(); i++ ){
+			size_t slot = checkedSlot( ids[ i ] );
+			positions[ i ] = _history[ slot * _historyLength + ( _observations[ slot ] - 1 ) % _historyLength ];
+		}
+	}
+
+	/* adds an observation in the current frame for each of the ids */
+	template <class PatchT>
+	inline void FeatureTrackStore<PatchT>::scatter( const std::vector<Id>& ids,
+													const std::vector<Vector2f>& positions,
+													const std::vector<float>& quality )
+	{
+		if( ids.size() != positions.size() || ids.size() != quality.size() )
+			throw CVTException( "ids, positions and quality need to have the same size" );
+
+		for( size_t i = 0; i < ids.size(); i++ )
+			observe( ids[ i ], positions[ i ], quality[ i ] );
+	}
+
+	/* removes all tracks not observed within the last maxFrames frames, returns the number of removed tracks */
+	template <class PatchT>
+	inline size_t FeatureTrackStore<PatchT>::removeUnseen( size_t maxFrames )
+	{
+		size_t removed = 0;
+		for( size_t i = 0; i < _alive.size(); i++ ){
+			if( _alive[ i ] && _frame - _lastFrame[ i ] > maxFrames ){
+				releaseSlot( i );
+				removed++;
+			}
+		}
+		return removed;
+	}
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2011 - 2013, Philipp Heise and Sebastian Klose
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+
+#include <cvt/vision/slam/stereo/FeatureTrackStore.h>
+#include <cvt/util/CVTTest.h>
+
+namespace cvt {
+
+	struct TrackStorePatch {
+		TrackStorePatch( int v ) : value( v ) { alive++; }
+		~TrackStorePatch() { alive--; }
+
+		int			value;
+		static int	alive;
+	};
+
+	int TrackStorePatch::alive = 0;
+
+	typedef FeatureDescriptorInternal<4, uint8_t, FEATUREDESC_CMP_HAMMING> TrackStoreDescriptor;
+	typedef FeatureTrackStore<TrackStorePatch> TestTrackStore;
+
+	static TestTrackStore::Id _addTrack( TestTrackStore& store, float x, uint8_t d, size_t mapPoint = TestTrackStore::NO_MAP_POINT )
+	{
+		TrackStoreDescriptor desc( x, 0.0f, 0.0f, 0, 0.0f );
+		for( size_t i = 0; i < 4; i++ )
+			desc.desc[ i ] = d;
+		return store.add( Vector2f( x, 0.0f ), desc, new TrackStorePatch( d ), mapPoint );
+	}
+
+	static bool _throws( const TestTrackStore& store, TestTrackStore::Id id )
+	{
+		try {
+			store.position( id );
+		} catch( const Exception& ) {
+			return true;
+		}
+		return false;
+	}
+
+}
+
+using namespace cvt;
+
+BEGIN_CVTTEST( FeatureTrackStore )
+
+bool result = true;
+bool b;
+
+{
+	TestTrackStore store( 3 );
+
+	std::vector<TestTrackStore::Id> ids;
+	for( size_t i = 0; i < 10; i++ )
+		ids.push_back( _addTrack( store, i, i ) );
+
+	b = store.size() == 10 && store.capacity() == 10 && TrackStorePatch::alive == 10;
+	for( size_t i = 0; i < 10; i++ ) {
+		b &= store.isValid( ids[ i ] );
+		b &= store.position( ids[ i ] ).x == i;
+		b &= store.descriptor( ids[ i ] ).ptr()[ 3 ] == i;
+		b &= store.patch( ids[ i ] )->value == ( int ) i;
+		b &= store.mapPoint( ids[ i ] ) == TestTrackStore::NO_MAP_POINT;
+	}
+	CVTTEST_PRINT( "Add", b );
+	result &= b;
+
+	/* removed ids stay invalid when the slot is reused */
+	store.remove( ids[ 3 ] );
+	store.remove( ids[ 7 ] );
+	b = store.size() == 8 && TrackStorePatch::alive == 8 && !store.isValid( ids[ 3 ] ) && _throws( store, ids[ 7 ] );
+	TestTrackStore::Id n0 = _addTrack( store, 20, 20 );
+	TestTrackStore::Id n1 = _addTrack( store, 21, 21 );
+	b &= store.capacity() == 10 && store.size() == 10;
+	b &= n0 != ids[ 7 ] && n1 != ids[ 3 ] && !store.isValid( ids[ 3 ] ) && !store.isValid( ids[ 7 ] );
+	b &= store.isValid( n0 ) && store.isValid( n1 ) && store.position( n0 ).x == 20 && store.position( n1 ).x == 21;
+	b &= !store.isValid( TestTrackStore::INVALID_ID );
+	CVTTEST_PRINT( "Free list and generations", b );
+	result &= b;
+	ids[ 7 ] = n0;
+	ids[ 3 ] = n1;
+
+	/* position history, age and batch access */
+	for( size_t f = 1; f <= 4; f++ ) {
+		store.nextFrame();
+		std::vector<TestTrackStore::Id> seen;
+		std::vector<Vector2f> pos;
+		std::vector<float> quality;
+		for( size_t i = 0; i < 10; i += 2 ) {
+			seen.push_back( ids[ i ] );
+			pos.push_back( Vector2f( i, f ) );
+			quality.push_back( f );
+		}
+		store.scatter( seen, pos, quality );
+	}
+
+	std::vector<Vector2f> hist;
+	b = store.history( hist, ids[ 2 ] ) == 3 && hist[ 0 ].y == 2 && hist[ 1 ].y == 3 && hist[ 2 ].y == 4;
+	b &= store.history( hist, ids[ 1 ] ) == 1 && hist[ 0 ].x == 1;
+	b &= store.age( ids[ 2 ] ) == 4 && store.lastSeen( ids[ 2 ] ) == 0 && store.lastSeen( ids[ 1 ] ) == 4;
+	b &= store.quality( ids[ 4 ] ) == 4.0f;
+
+	std::vector<Vector2f> positions;
+	store.gatherPositions( positions, ids );
+	std::vector<FeatureDescriptor*> descs;
+	std::vector<TrackStorePatch*> patches;
+	store.gather( descs, patches, ids );
+	for( size_t i = 0; i < ids.size(); i++ ) {
+		b &= positions[ i ] == store.position( ids[ i ] );
+		b &= descs[ i ] == &store.descriptor( ids[ i ] ) && patches[ i ] == store.patch( ids[ i ] );
+	}
+	CVTTEST_PRINT( "History and batch access", b );
+	result &= b;
+
+	/* pruning of tracks not seen recently */
+	b = store.removeUnseen( 2 ) == 5 && store.size() == 5 && TrackStorePatch::alive == 5;
+	std::vector<TestTrackStore::Id> alive;
+	store.ids( alive );
+	b &= alive.size() == 5;
+	for( size_t i = 0; i < alive.size(); i++ )
+		b &= store.lastSeen( alive[ i ] ) == 0;
+	CVTTEST_PRINT( "Remove unseen", b );
+	result &= b;
+}
+
+/* the StereoSLAM bookkeeping: new map features every frame, the recent ones are observed
+   with gaps and the tracks are pruned after each nextFrame */
+{
+	const size_t maxUnseen = 5;
+	const size_t perFrame = 20;
+	const size_t observed = 10 * perFrame;
+	TestTrackStore store;
+	size_t mapPoints = 0;
+
+	b = true;
+	for( size_t f = 0; f < 500; f++ ) {
+		store.nextFrame();
+		store.removeUnseen( maxUnseen );
+
+		for( size_t m = mapPoints > observed ? mapPoints - observed : 0; m < mapPoints; m++ ) {
+			TestTrackStore::Id id = store.trackForMapPoint( m );
+			if( id != TestTrackStore::INVALID_ID && Math::rand( 0.0f, 1.0f ) < 0.7f )
+				store.observe( id, Vector2f( m, f ), 1.0f );
+		}
+
+		for( size_t i = 0; i < perFrame; i++, mapPoints++ )
+			_addTrack( store, mapPoints, i, mapPoints );
+
+		/* a track lives at most while its map point is observed plus maxUnseen frames */
+		b &= store.size() <= perFrame * ( 10 + maxUnseen + 1 );
+		b &= store.capacity() <= perFrame * ( 10 + maxUnseen + 1 );
+	}
+
+	/* only the map points of alive tracks are linked */
+	size_t linked = 0;
+	for( size_t m = 0; m < mapPoints; m++ ) {
+		TestTrackStore::Id id = store.trackForMapPoint( m );
+		if( id == TestTrackStore::INVALID_ID )
+			continue;
+		linked++;
+		b &= store.isValid( id ) && store.mapPoint( id ) == m;
+	}
+	b &= linked == store.size() && TrackStorePatch::alive == ( int ) store.size();
+
+	/* relinking a track */
+	TestTrackStore::Id id = store.trackForMapPoint( mapPoints - 1 );
+	store.setMapPoint( id, mapPoints );
+	b &= store.trackForMapPoint( mapPoints - 1 ) == TestTrackStore::INVALID_ID && store.trackForMapPoint( mapPoints ) == id;
+	store.remove( id );
+	b &= store.trackForMapPoint( mapPoints ) == TestTrackStore::INVALID_ID;
+	CVTTEST_PRINT( "Bounded over many frames", b );
+	result &= b;
+}
+
+b = TrackStorePatch::alive == 0;
+CVTTEST_PRINT( "Ownership", b );
+result &= b;
+
+return result;
+
+END_CVTTEST
@@ -43,40 +43,39 @@ namespace cvt
                                      const std::vector<size_t>&		predictedIds,
                                      const ImagePyramid&            pyr )
     {
-        SIMD* simd = SIMD::instance();
-        const size_t nPixels = Math::sqr( PatchType::size() );
+        const size_t nPixels = PatchBatch::NumPixels;
         const float  maxSSD = nPixels * _ssdThreshold;
-        const size_t maxSAD = nPixels * _sadThreshold;
-
-        Vector2f center;
+        const float  maxSAD = nPixels * _sadThreshold;
 
+        // start the valid patches from their predicted positions
+        std::vector<size_t> ids;
+        ids.reserve( predictedPositions.size() );
         for( size_t i = 0; i < predictedPositions.size(); i++ ){
-            const Vector2f& p = predictedPositions[ i ];
-
             size_t id = predictedIds[ i ];
-            //  get the patch
-            PatchType* patch = _patchForId[ id ];
-
-            if( patch == 0 ){
+            if( !_patches.isValid( id ) ){
                 // this was a bad PATCH
                 continue;
             }
+            _patches.initPose( id, predictedPositions[ i ] );
+            ids.push_back( id );
+        }
+
+        if( ids.empty() )
+            return;
 
-            // start from predicted position
-            patch->initPose( p );
-
-            //  try to track the patch
-            if( patch->align( pyr, 5 ) ){
-                // successfully tracked: check SSD, SAD values
-                float ssd = simd->SSD( patch->pixels(), patch->transformed(), nPixels );
-                if( ssd < maxSSD ){
-                    size_t sad = simd->SAD( patch->pixels(), patch->transformed(), nPixels );
-                    if( sad < maxSAD ){
-                        patch->currentCenter( center );
-                        trackedPositions.add( Vector2d( center.x, center.y ) );
-                        trackedFeatureIds.push_back( id );
-                    }
-                }
+        //  try to track all patches
+        _patches.align( &ids[ 0 ], ids.size(), pyr, 5 );
+
+        Vector2f center;
+        for( size_t i = 0; i < ids.size(); i++ ){
+            size_t id = ids[ i ];
+            // successfully tracked: check SSD, SAD values
+            if( _patches.tracked( id ) &&
+                _patches.ssd( id ) < maxSSD &&
+                _patches.sad( id ) < maxSAD ){
+                _patches.currentCenter( id, center );
+                trackedPositions.add( Vector2d( center.x, center.y ) );
+                trackedFeatureIds.push_back( id );
             }
         }
     }
@@ -86,31 +85,19 @@ namespace cvt
                                             const ImagePyramid& pyrGradY,
                                             const Vector2f & f, size_t id )
     {
-        std::vector<PatchType*> patches;
-        std::vector<Vector2f>  feature;
-        feature.push_back( f );
-
-        PatchType::extractPatches( patches, feature, pyr, pyrGradX, pyrGradY );
-
-        if( id != _patchForId.size() ){
+        if( id != _patches.size() ){
             throw CVTException( "Patch IDs out of sync" );
         }
 
         // FIXME: shall we handle this differently?
         // Problem: Map has already added feature with id at this point
-        if( patches.size() )
-            _patchForId.push_back( patches[ 0 ] );
-        else
-            _patchForId.push_back( 0 );
-
+        // -> patches that could not be extracted stay as invalid entries
+        _patches.add( pyr, pyrGradX, pyrGradY, f );
     }
 
 
     void KLTTracking::clear()
     {
-        for( size_t i = 0; i < _patchForId.size(); i++ ){
-            delete _patchForId[ i ];
-        }
-        _patchForId.clear();
+        _patches.clear();
     }
 }
@@ -33,6 +33,7 @@
 #include <cvt/gfx/GFXEngineImage.h>
 #include <cvt/vision/Vision.h>
 #include <cvt/vision/features/RowLookupTable.h>
+#include <cvt/vision/features/TiledAST.h>
 #include <cvt/vision/slam/stereo/FeatureAnalyzer.h>
 #include <cvt/util/Time.h>
 
@@ -76,6 +77,10 @@ namespace cvt
         // prepare debug image
         imgLeftGray.convert( _debugMono, IFormat::RGBA_UINT8 );
 
+        _tracks.nextFrame();
+        if( _params.maxUnseenFrames )
+            _tracks.removeUnseen( _params.maxUnseenFrames );
+
         // detect current keypoints and extract descriptors
         extractFeatures( imgLeftGray, imgRightGray );
 
@@ -171,30 +176,46 @@ namespace cvt
 
 	   // detect features in current left frame
 	   FeatureSet leftFeatures, rightFeatures;
-	   _detector->detect( leftFeatures, _pyrLeft );
-	   _detector->detect( rightFeatures, _pyrRight );
-
-       if ( _params.dbgShowFeatures ) {
-           debugImageDrawFeatures( _debugMono, leftFeatures, Color::BLUE );
-       }
-
-       const int NMS_RADIUS( _params.nonMaximumSuppressionRadius );
-	   leftFeatures.filterNMS( NMS_RADIUS, true );
-	   rightFeatures.filterNMS( NMS_RADIUS, true );
-
-       if ( _params.dbgShowNMSFilteredFeatures ) {
-           debugImageDrawFeatures( _debugMono, leftFeatures, Color::BLACK );
-       }
-
+	   const int NMS_RADIUS( _params.nonMaximumSuppressionRadius );
 	   const int X_CELLS = _params.gridFilteringCellsX;
 	   const int Y_CELLS = _params.gridFilteringCellsY;
 	   const int MAX_CELL_FEATURES = _params.maxFeaturesPerCell;
-       if ( _params.useGridFiltering ) {
-           leftFeatures.filterGrid( _pyrLeft[ 0 ].width(), _pyrLeft[ 0 ].height(), X_CELLS, Y_CELLS, MAX_CELL_FEATURES );
-           rightFeatures.filterGrid( _pyrLeft[ 0 ].width(), _pyrLeft[ 0 ].height(), X_CELLS, Y_CELLS, MAX_CELL_FEATURES );
+
+       TiledAST* tiled = dynamic_cast<TiledAST*>( _detector );
+       if ( tiled && !_params.dbgShowFeatures && !_params.dbgShowNMSFilteredFeatures ) {
+           // NMS and grid / best-N filtering are done during detection
+           tiled->setNMSRadius( NMS_RADIUS );
+           if ( _params.useGridFiltering ) {
+               tiled->setGrid( X_CELLS, Y_CELLS, MAX_CELL_FEATURES );
+               tiled->setMaxFeatures( 0 );
+           } else {
+               tiled->setGrid( 0, 0, 0 );
+               tiled->setMaxFeatures( _params.bestFeaturesCount );
+           }
+           tiled->detect( leftFeatures, _pyrLeft );
+           tiled->detect( rightFeatures, _pyrRight );
        } else {
-            leftFeatures.filterBest( _params.bestFeaturesCount, true );
-            rightFeatures.filterBest( _params.bestFeaturesCount, true );
+           _detector->detect( leftFeatures, _pyrLeft );
+           _detector->detect( rightFeatures, _pyrRight );
+
+           if ( _params.dbgShowFeatures ) {
+               debugImageDrawFeatures( _debugMono, leftFeatures, Color::BLUE );
+           }
+
+           leftFeatures.filterNMS( NMS_RADIUS, true );
+           rightFeatures.filterNMS( NMS_RADIUS, true );
+
+           if ( _params.dbgShowNMSFilteredFeatures ) {
+               debugImageDrawFeatures( _debugMono, leftFeatures, Color::BLACK );
+           }
+
+           if ( _params.useGridFiltering ) {
+               leftFeatures.filterGrid( _pyrLeft[ 0 ].width(), _pyrLeft[ 0 ].height(), X_CELLS, Y_CELLS, MAX_CELL_FEATURES );
+               rightFeatures.filterGrid( _pyrLeft[ 0 ].width(), _pyrLeft[ 0 ].height(), X_CELLS, Y_CELLS, MAX_CELL_FEATURES );
+           } else {
+               leftFeatures.filterBest( _params.bestFeaturesCount, true );
+               rightFeatures.filterBest( _params.bestFeaturesCount, true );
+           }
        }
 
 	   leftFeatures.sortPosition();
@@ -214,6 +235,11 @@ namespace cvt
 	   _descExtractorRight->extract( _pyrRight, rightFeatures );
    }
 
+   bool StereoSLAM::binaryDescriptors( const FeatureDescriptorExtractor& extractor )
+   {
+	   return extractor.size() && extractor[ 0 ].compareType() == FEATUREDESC_CMP_HAMMING;
+   }
+
    void StereoSLAM::predictVisibleFeatures( std::vector<Vector2f>& imgPositions,
 											std::vector<size_t>& ids,
 											std::vector<FeatureDescriptor*>& descriptors,
@@ -226,10 +252,26 @@ namespace cvt
 								   _calib.firstCamera(),
 								   _params.keyframeSelectionRadius );
 
+	   // only the features with a track can be matched, the tracks of long unseen features are dropped
+	   std::vector<TrackStore::Id> trackIds;
+	   trackIds.reserve( ids.size() );
+	   size_t n = 0;
+	   for( size_t i = 0; i < ids.size(); ++i ){
+		   TrackStore::Id id = _tracks.trackForMapPoint( ids[ i ] );
+		   if( id == TrackStore::INVALID_ID )
+			   continue;
+		   trackIds.push_back( id );
+		   ids[ n ] = ids[ i ];
+		   imgPositions[ n ] = imgPositions[ i ];
+		   n++;
+	   }
+	   ids.resize( n );
+	   imgPositions.resize( n );
+
 	   std::cout << "Visible points from map (Selected points): " << ids.size() << std::endl;
 
 	   // get the corresponding descriptors
-	   _descriptorDatabase.descriptorsAndPatchesForIds( descriptors, patches, ids );
+	   _tracks.gather( descriptors, patches, trackIds );
 	   for( size_t i = 0; i < descriptors.size(); ++i ){
 		   descriptors[ i ]->pt = imgPositions[ i ];
 	   }
@@ -245,47 +287,63 @@ namespace cvt
 
 
         // match with current left features
-        RowLookupTable rlt( *_descExtractorLeft );
-        _descExtractorLeft->matchInWindow( matchedIndices,
-                                           rlt,
-                                           predictedDescriptors,
-                                           _params.matchingWindow,
-                                           _params.matchingMaxDescDistance );
-
-        // refine matched positions using KLT
-        tracked.reserve( matchedIndices.size() );
-        Vector4f vec;
-        Vector2f refined;
+        if( binaryDescriptors( *_descExtractorLeft ) ){
+            GuidedMatcher::Params params;
+            params.maxDistance = _params.matchingMaxDescDistance;
+            params.maxOctaveDiff = _pyrLeft.octaves();
+            _matcher.setParams( params );
+            _matcher.build( *_descExtractorLeft );
+            _matcher.matchInWindow( matchedIndices, predictedDescriptors, _params.matchingWindow );
+        } else {
+            RowLookupTable rlt( *_descExtractorLeft );
+            _descExtractorLeft->matchInWindow( matchedIndices,
+                                               rlt,
+                                               predictedDescriptors,
+                                               _params.matchingWindow,
+                                               _params.matchingMaxDescDistance );
+        }
+
+        // refine all matched positions in one batch using KLT
+        _kltBatch.clear();
+        _kltBatch.reserve( matchedIndices.size() );
         for ( size_t i = 0; i < matchedIndices.size(); ++i ){
             const MatchingIndices& m = matchedIndices[ i ];
-            size_t curMapIdx = predictedIds[ m.srcIdx ];
-            PatchType* patch = predictedPatches[ m.srcIdx ];
-
-
             const Vector2f& pt = ( *_descExtractorLeft )[ m.dstIdx ].pt;
 
             // TODO: try to only update the position and keep the rest of the patch pose
             //       the idea would be, that the last alignment/oriantation of this patch
             //       is probably better than just using the position
-            patch->initPose( pt );
+            _kltBatch.add( *predictedPatches[ m.srcIdx ] );
+            _kltBatch.initPose( i, pt );
+        }
+        _kltBatch.align( _pyrLeftf, _params.kltTrackingIters );
+
+        tracked.reserve( matchedIndices.size() );
+        Vector4f vec;
+        Vector2f refined;
+        for ( size_t i = 0; i < matchedIndices.size(); ++i ){
+            const MatchingIndices& m = matchedIndices[ i ];
+            size_t curMapIdx = predictedIds[ m.srcIdx ];
+            PatchType* patch = predictedPatches[ m.srcIdx ];
 
-            bool kltRes = patch->align( _pyrLeftf, _params.kltTrackingIters );
-            patch->currentCenter( refined );
+            // keep the refined pose with the patch for the next frame
+            patch->initPose( _kltBatch.poseMat( i ) );
+            _kltBatch.currentCenter( i, refined );
 
-            // compute SAD between patch->pixels() (original pixels saved in the patch/KF)
-            // and patch->transformed() (pixels at refined patch location)
-            float avgSAD = SIMD::instance()->SAD( patch->pixels(),
-                                                  patch->transformed(),
-                                                  patch->numPatchPoints() ) / patch->numPatchPoints();
+            // the batch stores the SAD between the original pixels saved in the patch/KF
+            // and the pixels at the refined patch location
+            float avgSAD = _kltBatch.sad( i ) / _kltBatch.numPatchPoints();
 
             const MapFeature& mapFeature = _map.featureForId( curMapIdx );
             EigenBridge::toCVT( vec, mapFeature.estimate() );
 
             // klt was successful and SAD is reasonably small?
-            if ( kltRes && avgSAD < _params.kltAvgSAD ) {
+            if ( _kltBatch.tracked( i ) && avgSAD < _params.kltAvgSAD ) {
                 tracked.points2d.add( refined );// refinement was an improvment
                 tracked.points3d.add( Vector3f( vec ) );
                 tracked.mapFeatureIds.push_back( curMapIdx );
+                // the pixels are in [ 0, 1 ], the quality is one minus the average SAD
+                _tracks.observe( _tracks.trackForMapPoint( curMapIdx ), refined, 1.0f - avgSAD );
             }
         } // for matched indices
     }
@@ -343,14 +401,27 @@ namespace cvt
 
 	   // try to match the free features with right frame
 	   std::vector<FeatureMatch> stereoMatches;
-       RowLookupTable rltRight( *_descExtractorRight );
-	   _descExtractorRight->scanLineMatch( stereoMatches,
-                                           rltRight,
-										   freeFeaturesLeft,
-										   _params.minDisparity,
-										   _params.maxDisparity,
-										   _params.stereoMaxDescDistance,
-										   _params.maxEpilineDistance );
+	   if( binaryDescriptors( *_descExtractorRight ) ){
+		   GuidedMatcher::Params params;
+		   params.maxDistance = _params.stereoMaxDescDistance;
+		   params.maxOctaveDiff = _pyrLeft.octaves();
+		   _matcher.setParams( params );
+		   _matcher.build( *_descExtractorRight );
+		   _matcher.scanLineMatch( stereoMatches,
+								   freeFeaturesLeft,
+								   _params.minDisparity,
+								   _params.maxDisparity,
+								   _params.maxEpilineDistance );
+	   } else {
+		   RowLookupTable rltRight( *_descExtractorRight );
+		   _descExtractorRight->scanLineMatch( stereoMatches,
+											   rltRight,
+											   freeFeaturesLeft,
+											   _params.minDisparity,
+											   _params.maxDisparity,
+											   _params.stereoMaxDescDistance,
+											   _params.maxEpilineDistance );
+	   }
 
 	   if ( _params.dbgShowStereoMatches ) {
 		   Image debugImg;
@@ -378,7 +449,7 @@ namespace cvt
 	   float bd = 0.0f;
        //int counter = 0;
 	   for( size_t i = 0; i < stereoMatches.size(); ++i ){
-		   DescriptorDatabase::PatchType* patch = new DescriptorDatabase::PatchType( _pyrLeft.octaves() );
+		   PatchType* patch = new PatchType( _pyrLeft.octaves() );
 		   const FeatureMatch& m = stereoMatches[ i ];
 		   const Vector2f& posL = m.feature0->pt;
 		   const Vector2f& posR = m.feature1->pt;
@@ -442,6 +513,7 @@ namespace cvt
          _bundler.join();
 
       _map.clear();
+      _tracks.clear();
 
 	  Eigen::Matrix4f I( Eigen::Matrix4f::Identity() );
       _pose.set( I );
@@ -510,8 +582,7 @@ namespace cvt
 		   p3d[ 3 ] = 1;
 		   mf.estimate() = poseInv * p3d;
 		   size_t featureId = _map.addFeatureToKeyframe( mf, mm, kid );
-		   _descriptorDatabase.addDescriptor( *desc, featureId );
-		   _descriptorDatabase.addPatch( patch, featureId );
+		   _tracks.add( p2d, *desc, patch, featureId );
 	   }
 
        /* bundle adjust */
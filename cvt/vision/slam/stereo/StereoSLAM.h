@@ -30,7 +30,11 @@
 #include <cvt/util/Signal.h>
 #include <cvt/vision/slam/SlamMap.h>
 #include <cvt/vision/slam/Keyframe.h>
-#include <cvt/vision/slam/stereo/DescriptorDatabase.h>
+#include <cvt/vision/slam/stereo/FeatureTrackStore.h>
+#include <cvt/vision/features/GuidedMatcher.h>
+#include <cvt/vision/KLTPatch.h>
+#include <cvt/vision/KLTBatch.h>
+#include <cvt/math/GA2.h>
 #include <cvt/vision/features/FeatureMatch.h>
 #include <cvt/vision/CameraCalibration.h>
 #include <cvt/vision/StereoCameraCalibration.h>
@@ -67,6 +71,7 @@ namespace cvt
                    kltTrackingIters( 2 ),
                    kltAvgSAD( 0.25f ),
 				   kltStereoIters( 2 ),
+				   maxUnseenFrames( 0 ),
                    useSBA( false ),
                    sbaIterations( 5 ),
                    sbaDeltaKeyframes( 1 ),
@@ -109,6 +114,12 @@ namespace cvt
                 float  kltAvgSAD;
 				size_t kltStereoIters;
 
+				/*
+				   drop the track of a map feature not observed within this number of frames, 0 keeps all tracks.
+				   The map point stays in the map without descriptor, so it can not be matched again afterwards
+				 */
+				size_t maxUnseenFrames;
+
                 /* use SBA */
                 bool    useSBA;
                 size_t  sbaIterations;
@@ -175,12 +186,16 @@ namespace cvt
 			size_t size() const { return points3d.size(); }
 		 };
 
-		 typedef DescriptorDatabase::PatchType	PatchType;
+		 typedef KLTPatch<7, GA2<float> >		PatchType;
+		 typedef KLTBatch<7, GA2<float> >		PatchBatch;
+		 typedef FeatureTrackStore<PatchType>	TrackStore;
 		 Params						 _params;
 		 FeatureDetector*			 _detector;
 		 FeatureDescriptorExtractor* _descExtractorLeft;
 		 FeatureDescriptorExtractor* _descExtractorRight;
-		 DescriptorDatabase			 _descriptorDatabase;
+		 GuidedMatcher				 _matcher;
+		 /* tracks of the map features, linked by the map feature id */
+		 TrackStore					 _tracks;
 		 ImagePyramid				 _pyrLeft;
 		 ImagePyramid				 _pyrRight;
 
@@ -189,6 +204,8 @@ namespace cvt
 		 ImagePyramid				 _pyrRightf;
 		 ImagePyramid				 _gradXl;
 		 ImagePyramid				 _gradYl;
+		 /* the matched patches, aligned at once */
+		 PatchBatch					 _kltBatch;
 		 IKernel					 _kernelGx;
 		 IKernel					 _kernelGy;
 
@@ -206,6 +223,9 @@ namespace cvt
 
 		 void extractFeatures( const Image& left, const Image& right );
 
+		 /* the guided matcher is used for binary descriptors */
+		 static bool binaryDescriptors( const FeatureDescriptorExtractor& extractor );
+
 		 void predictVisibleFeatures( std::vector<Vector2f>& imgPositions,
 									  std::vector<size_t>& ids,
 									  std::vector<FeatureDescriptor*>& descriptors,